@@ -105,7 +105,29 @@
 #define GD_CFG_USE_PERF_MONITOR     GD_ENABLED
 
 
+//! Track the allocations made through GD_ALLOC/GD_NEW (bytes per tag, leak report) ?
+//! Every allocation takes a lock, only enabled in debug builds.
+#ifdef _DEBUG
+    #define GD_CFG_USE_MEMORY_TRACKING  GD_ENABLED
+#else
+    #define GD_CFG_USE_MEMORY_TRACKING  GD_DISABLED
+#endif
+
+
 #define GD_CFG_USE_PROPERTIES       GD_ENABLED
 
 
+//! Compile the SSE2 code paths ? They are only taken if the cpu supports SSE2.
+#if GD_PLATFORM == GD_PLATFORM_WIN32 || defined(__SSE2__)
+    #define GD_CFG_USE_SSE2         GD_ENABLED
+#else
+    #define GD_CFG_USE_SSE2         GD_DISABLED
+#endif
+
+
+//! Align Matrix4 on 16 bytes so the SSE code paths use aligned loads ?
+//! Visual C++ can't pass aligned types by value, std::vector<Matrix4f> won't compile.
+#define GD_CFG_USE_ALIGNED_MATRIX   GD_DISABLED
+
+
 #endif  //  _BUILD_OPTIONS_H_
@@ -28,14 +28,78 @@
 #include "Core.h"
 #include "ConfigFile.h"
 #include "FileManager/FileManager.h"
+#include "FileManager/MemoryFile.h"
 
 
 namespace Gamedesk {
 	
 	
+///////////////////////////////////////////////////////////////////////////////
+// Binary cache layout: header, sections, values, then the string table.
+// Sections and variable names are interned in the string table.
+static const UInt32 CONFIG_CACHE_MAGIC   = 0x46434447;     // "GDCF"
+static const UInt32 CONFIG_CACHE_VERSION = 1;
+
+struct ConfigCacheHeader
+{
+    UInt32              mMagic;
+    UInt32              mVersion;
+    MD5Checksum::Value  mChecksum;          //!< Checksum of the text file this cache was compiled from.
+    UInt32              mNbSections;
+    UInt32              mNbValues;
+    UInt32              mStringsSize;
+};
+
+struct ConfigCacheSection
+{
+    UInt32  mName;                          //!< Offset in the string table.
+    UInt32  mFirstValue;
+    UInt32  mNbValues;
+};
+
+struct ConfigCacheValue
+{
+    UInt32  mName;                          //!< Offset in the string table.
+    UInt32  mType;                          //!< Variant::eVariantType.
+    UInt32  mValue;                         //!< Bool, Int32 or Float bits, or offset in the string table.
+};
+
+/**
+ *  Convert a value read from the text file to a typed variant.
+ *  The value is typed only if it is written back the same way by Save(), otherwise it stays a string.
+ */
+static void ParseValue( const String& pText, Variant& pValue )
+{
+    if( pText == "True" )
+        pValue = true;
+    else if( pText == "False" )
+        pValue = false;
+    else if( ToString( StringTo<Int32>(pText.c_str()) ) == pText )
+        pValue = StringTo<Int32>(pText.c_str());
+    else if( ToString( StringTo<Float>(pText.c_str()) ) == pText )
+        pValue = StringTo<Float>(pText.c_str());
+    else
+        pValue = pText;
+}
+
+//! Add a string to the string table of the cache, once.
+static UInt32 InternString( const String& pString, Map<String,UInt32>& pOffsets, String& pStrings )
+{
+    Map<String,UInt32>::iterator itOffset = pOffsets.find( pString );
+    if( itOffset != pOffsets.end() )
+        return (*itOffset).second;
+
+    UInt32 offset = (UInt32)pStrings.size();
+    pStrings.append( pString.c_str(), pString.size() + 1 );
+    pOffsets[pString] = offset;
+
+    return offset;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // ConfigSection
-ConfigSection::ConfigSection( const String& pSectionName, const ConfigFile& pConfigFile ) :
+ConfigSection::ConfigSection( const String& pSectionName, ConfigFile& pConfigFile ) :
     mConfigFile( pConfigFile ),
     mSectionName( pSectionName )
 {
@@ -48,13 +112,13 @@ ConfigSection::~ConfigSection()
 
 void ConfigSection::Clear()
 {
-    Variant*                          variant = NULL;
-    Map<String,Variant*>::iterator    itMap;
+    Map<String,UInt32>::iterator    itMap;
 
     for( itMap = mVars.begin(); itMap != mVars.end(); itMap++ )
     {
-        variant = (*itMap).second;
+        Variant*& variant = mConfigFile.mValues[(*itMap).second];
         GD_DELETE(variant);
+        variant = NULL;
     }
 
     mVars.clear();
@@ -63,13 +127,13 @@ void ConfigSection::Clear()
 void ConfigSection::Save( std::ostream& pOut )
 {
     Variant*                          variant = NULL;
-    Map<String,Variant*>::iterator    itMap;
+    Map<String,UInt32>::iterator      itMap;
     String                            value;
     String                            name;
 
     for( itMap = mVars.begin(); itMap != mVars.end(); itMap++ )
     {
-        variant    = (*itMap).second;
+        variant    = mConfigFile.mValues[(*itMap).second];
 
         name       = (*itMap).first;
         value      = (String)(*variant);
@@ -124,48 +188,40 @@ void ConfigSection::Load( std::istream& pIn )
             throw InvalidConfigFileException( mConfigFile.GetFileName(), Here );
 
         // Create a new variable.
-        (*this)[varName] = varValue;
+        ParseValue( varValue, (*this)[varName] );
     }
 }
 
 Variant& ConfigSection::operator [] ( const String& pVarName )
 {
-    Variant*                          variant = NULL;
-    Map<String,Variant*>::iterator    itMap = mVars.find( pVarName );
-        
-    // If we've found the section in our map, return it immediately.
-    if( itMap != mVars.end() )
-    {
-        variant = (*itMap).second;
-    }
-    // Otherwise we need to create it.
-    else
-    {
-        variant = GD_NEW(Variant, this, "Core::Config::ConfigSection::Variant");
-        mVars[pVarName] = variant;
-    }
+    return *mConfigFile.mValues[GetValueID( pVarName, NULL )];
+}
 
-    return *variant;
+Variant& ConfigSection::Get( const String& pVarName, const Variant& pDefaultValue )
+{
+    return *mConfigFile.mValues[GetValueID( pVarName, &pDefaultValue )];
 }
 
-Variant& ConfigSection::Get( const String& pVarName, Variant pDefaultValue )
+UInt32 ConfigSection::GetValueID( const String& pVarName, const Variant* pDefaultValue )
 {
-    Variant*                          variant = NULL;
-    Map<String,Variant*>::iterator    itMap = mVars.find( pVarName );
+    Map<String,UInt32>::iterator    itMap = mVars.lower_bound( pVarName );
         
-    // If we've found the section in our map, return it immediately.
-    if( itMap != mVars.end() )
-    {
-        variant = (*itMap).second;
-    }
+    // If we've found the variable in our map, return it immediately.
+    if( itMap != mVars.end() && (*itMap).first == pVarName )
+        return (*itMap).second;
+
     // Otherwise we need to create it.
+    Variant* variant;
+    if( pDefaultValue )
+        variant = GD_NEW(Variant, this, "Core::Config::ConfigSection::Variant")( *pDefaultValue );
     else
-    {
-        variant = GD_NEW(Variant, this, "Core::Config::ConfigSection::Variant")( pDefaultValue );
-        mVars[pVarName] = variant;
-    }
+        variant = GD_NEW(Variant, this, "Core::Config::ConfigSection::Variant");
 
-    return *variant;
+    UInt32 id = (UInt32)mConfigFile.mValues.size();
+    mConfigFile.mValues.push_back( variant );
+    mVars.insert( itMap, std::make_pair( pVarName, id ) );
+
+    return id;
 }
 
 const String& ConfigSection::GetName() const
@@ -177,6 +233,7 @@ const String& ConfigSection::GetName() const
 // ConfigFile
 ///////////////////////////////////////////////////////////////////////////////
 ConfigFile::ConfigFile( const String& pFileName, const String& pFolder )
+    : mLoadedFromCache(false)
 {
     mFileName = pFolder + pFileName;
 }
@@ -198,25 +255,48 @@ void ConfigFile::Clear()
     }
 
     mSections.clear();
+    mValues.clear();
 }
 
 void ConfigFile::Load()
 {
-    std::ifstream   inFile( mFileName.c_str() );
+    if( !FileManager::FileExist(mFileName) )
+        throw FileNotFoundException( mFileName, Here );
+
+    mLoadedFromCache = false;
 
-    if( inFile.fail() )
+    UInt32 fileSize = FileManager::GetFileSize( mFileName );
+    if( fileSize == 0 )
+        return;
+
+    MemoryFile textFile( mFileName, true );
+
+    MD5Checksum checksum;
+    checksum.Update( textFile.GetMemory(), textFile.GetSize() );
+    checksum.Finalize();
+
+    if( LoadCache(checksum.Digest()) )
     {
-        inFile.close();
-        throw FileNotFoundException( mFileName, Here );
+        mLoadedFromCache = true;
+        return;
     }
 
+    std::istringstream inText( String( (const Char*)textFile.GetMemory(), textFile.GetSize() ) );
+    textFile.Close();
+
+    LoadText( inText );
+    SaveCache( checksum.Digest() );
+}
+
+void ConfigFile::LoadText( std::istream& pIn )
+{
     String              sectionName;
     String              nextWord;
     char                buffer[512];
     std::stringstream   lineStream;
     
-    inFile.getline(buffer, 512);
-    while( inFile.good() )
+    pIn.getline(buffer, 512);
+    while( pIn.good() )
     {        
         lineStream.clear();
         lineStream.str(buffer);
@@ -235,19 +315,16 @@ void ConfigFile::Load()
         
         // Find opening and closing bracket (must be at start and end of section name).
         if( sectionName.at(0) != '[' || sectionName.at( sectionName.size() -1 ) != ']' )
-        {
-            inFile.close();
             throw InvalidConfigFileException( mFileName, Here );
-        }
 
         // Extract the section name from the string (remove "[]")
         sectionName = sectionName.substr( 1, sectionName.length() - 2 );
 
         // Load this section.
-        (*this)[sectionName].Load(inFile);
+        (*this)[sectionName].Load(pIn);
 
         // Read another section...
-        inFile.getline(buffer, 512);
+        pIn.getline(buffer, 512);
     }
 }
 
@@ -296,16 +373,203 @@ ConfigSection& ConfigFile::operator [] ( const String& pSectionName )
     return *section;
 }
 
-Variant& ConfigFile::Get( const String& pSectionName, const String& pVarName, Variant pDefaultValue )
+Variant& ConfigFile::Get( const String& pSectionName, const String& pVarName, const Variant& pDefaultValue )
 {
     return operator[]( pSectionName ).Get( pVarName, pDefaultValue );
 }
 
+ConfigFile::Key ConfigFile::GetKey( const String& pSectionName, const String& pVarName, const Variant& pDefaultValue )
+{
+    return Key( operator[]( pSectionName ).GetValueID( pVarName, &pDefaultValue ) );
+}
+
+Variant& ConfigFile::Get( Key pKey )
+{
+    GD_ASSERT_M( pKey.mID < mValues.size() && mValues[pKey.mID] != NULL, "[ConfigFile::Get] Invalid key." );
+    return *mValues[pKey.mID];
+}
+
 const String& ConfigFile::GetFileName() const
 {
     return mFileName;
 }
 
+String ConfigFile::GetCacheFileName() const
+{
+    return mFileName + ".cache";
+}
+
+Bool ConfigFile::IsLoadedFromCache() const
+{
+    return mLoadedFromCache;
+}
+
+Bool ConfigFile::LoadCache( const MD5Checksum::Value& pChecksum )
+{
+    String cacheFileName = GetCacheFileName();
+    if( !FileManager::FileExist(cacheFileName) || FileManager::GetFileSize(cacheFileName) < sizeof(ConfigCacheHeader) )
+        return false;
+
+    MemoryFile cacheFile( cacheFileName, true );
+
+    const ConfigCacheHeader* header = (const ConfigCacheHeader*)cacheFile.GetMemory();
+    if( header->mMagic != CONFIG_CACHE_MAGIC || header->mVersion != CONFIG_CACHE_VERSION || header->mChecksum != pChecksum )
+        return false;
+
+    // Computed on 64 bits, the counts of a corrupted header must not wrap around.
+    UInt64 expectedSize = UInt64(sizeof(ConfigCacheHeader)) +
+                          UInt64(header->mNbSections) * sizeof(ConfigCacheSection) +
+                          UInt64(header->mNbValues) * sizeof(ConfigCacheValue) +
+                          header->mStringsSize;
+    if( cacheFile.GetSize() != expectedSize )
+        return false;
+
+    const ConfigCacheSection*   sections = (const ConfigCacheSection*)(header + 1);
+    const ConfigCacheValue*     values   = (const ConfigCacheValue*)(sections + header->mNbSections);
+    const Char*                 strings  = (const Char*)(values + header->mNbValues);
+
+    // Check every range and offset before adding anything, a corrupted cache is ignored as a whole.
+    if( header->mStringsSize > 0 && strings[header->mStringsSize - 1] != '\0' )
+        return false;
+
+    for( UInt32 iSection = 0; iSection < header->mNbSections; iSection++ )
+    {
+        const ConfigCacheSection& section = sections[iSection];
+        if( section.mName >= header->mStringsSize || section.mFirstValue > header->mNbValues ||
+            section.mNbValues > header->mNbValues - section.mFirstValue )
+        {
+            return false;
+        }
+    }
+
+    for( UInt32 iValue = 0; iValue < header->mNbValues; iValue++ )
+    {
+        const ConfigCacheValue& value = values[iValue];
+        if( value.mName >= header->mStringsSize ||
+            (value.mType == Variant::Variant_String && value.mValue >= header->mStringsSize) )
+        {
+            return false;
+        }
+    }
+
+    for( UInt32 iSection = 0; iSection < header->mNbSections; iSection++ )
+    {
+        ConfigSection& section = (*this)[strings + sections[iSection].mName];
+
+        const ConfigCacheValue* value    = values + sections[iSection].mFirstValue;
+        const ConfigCacheValue* valueEnd = value + sections[iSection].mNbValues;
+        for( ; value != valueEnd; ++value )
+        {
+            Variant& variant = section[strings + value->mName];
+
+            switch( value->mType )
+            {
+            case Variant::Variant_Bool:
+                variant = value->mValue != 0;
+                break;
+
+            case Variant::Variant_Int:
+                variant = (Int32)value->mValue;
+                break;
+
+            case Variant::Variant_Float:
+                {
+                    Float floatValue;
+                    memcpy( &floatValue, &value->mValue, sizeof(floatValue) );
+                    variant = floatValue;
+                }
+                break;
+
+            case Variant::Variant_String:
+                variant = String( strings + value->mValue );
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ConfigFile::SaveCache( const MD5Checksum::Value& pChecksum )
+{
+    Vector<ConfigCacheSection>  sections;
+    Vector<ConfigCacheValue>    values;
+    Map<String,UInt32>          stringOffsets;
+    String                      strings;
+
+    for( Map<String,ConfigSection*>::iterator itSection = mSections.begin(); itSection != mSections.end(); ++itSection )
+    {
+        ConfigSection* section = (*itSection).second;
+
+        ConfigCacheSection cacheSection;
+        cacheSection.mName       = InternString( (*itSection).first, stringOffsets, strings );
+        cacheSection.mFirstValue = (UInt32)values.size();
+        cacheSection.mNbValues   = (UInt32)section->mVars.size();
+        sections.push_back( cacheSection );
+
+        for( Map<String,UInt32>::iterator itVar = section->mVars.begin(); itVar != section->mVars.end(); ++itVar )
+        {
+            const Variant& variant = *mValues[(*itVar).second];
+
+            ConfigCacheValue cacheValue;
+            cacheValue.mName  = InternString( (*itVar).first, stringOffsets, strings );
+            cacheValue.mType  = variant.GetType();
+            cacheValue.mValue = 0;
+
+            switch( variant.GetType() )
+            {
+            case Variant::Variant_Bool:
+                cacheValue.mValue = (Bool)variant ? 1 : 0;
+                break;
+
+            case Variant::Variant_Int:
+                cacheValue.mValue = (UInt32)(Int32)variant;
+                break;
+
+            case Variant::Variant_Float:
+                {
+                    Float floatValue = variant;
+                    memcpy( &cacheValue.mValue, &floatValue, sizeof(floatValue) );
+                }
+                break;
+
+            case Variant::Variant_String:
+                cacheValue.mValue = InternString( (String)variant, stringOffsets, strings );
+                break;
+
+            default:
+                break;
+            }
+
+            values.push_back( cacheValue );
+        }
+    }
+
+    ConfigCacheHeader header;
+    header.mMagic       = CONFIG_CACHE_MAGIC;
+    header.mVersion     = CONFIG_CACHE_VERSION;
+    header.mChecksum    = pChecksum;
+    header.mNbSections  = (UInt32)sections.size();
+    header.mNbValues    = (UInt32)values.size();
+    header.mStringsSize = (UInt32)strings.size();
+
+    // The cache is only an optimization, the text file stays the reference.
+    std::ofstream outFile( GetCacheFileName().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+    if( outFile.fail() )
+        return;
+
+    outFile.write( (const char*)&header, sizeof(header) );
+    if( !sections.empty() )
+        outFile.write( (const char*)&sections[0], sections.size() * sizeof(ConfigCacheSection) );
+    if( !values.empty() )
+        outFile.write( (const char*)&values[0], values.size() * sizeof(ConfigCacheValue) );
+    outFile.write( strings.c_str(), strings.size() );
+    outFile.close();
+}
+
 ConfigFile::Iterator::Iterator( ConfigFile& pConfigFile ) :
     mConfigFile( pConfigFile ),
     mIterator( pConfigFile.mSections.begin() )
@@ -30,6 +30,7 @@
 
 
 #include "Variant.h"
+#include "FileManager/Checksum.h"
 
 
 namespace Gamedesk {
@@ -55,7 +56,7 @@ class CORE_API ConfigSection
     
 public:
     //! Constructor.
-    ConfigSection( const String& pSectionName, const class ConfigFile& pConfigFile );
+    ConfigSection( const String& pSectionName, class ConfigFile& pConfigFile );
 
     //! Destructor.
     virtual ~ConfigSection();
@@ -74,10 +75,11 @@ public:
      *  @param  pDefaultValue   Default value that will be returned if the variable is not found.
      *  @return A variant containing the variable's value.
      */
-    Variant& Get( const String& pVarName, Variant pDefaultValue );
+    Variant& Get( const String& pVarName, const Variant& pDefaultValue );
 
     /**
      *  Remove all variables in this section.
+     *  Key handles on these variables become invalid.
      */
     void Clear();
 
@@ -100,9 +102,17 @@ private:
      */
     void Load( std::istream& pIn );
 
+    /**
+     *  Get the id of a variable in the config file value table, creating the variable if needed.
+     *  @param  pVarName        Name of the variable.
+     *  @param  pDefaultValue   Value of the variable if it is created, NULL for an empty variant.
+     *  @return Index of the variable in the value table of the config file.
+     */
+    UInt32 GetValueID( const String& pVarName, const Variant* pDefaultValue );
+
 private:
-    Map<String,Variant*>        mVars;          //!< Map of variants in this section.
-    const class ConfigFile&     mConfigFile;    //!< Config file associated to this section.
+    Map<String,UInt32>          mVars;          //!< Id of each variable in the config file value table.
+    class ConfigFile&           mConfigFile;    //!< Config file associated to this section.
     const String                mSectionName;   //!< Name of this section. 
 };
 
@@ -110,6 +120,11 @@ private:
 /**
  *  Define a config file.  A config file usually contains one or more config section, that 
  *  in turn contains variables.
+ *  Variables are stored in a flat value table. A Key resolved once by name gives direct
+ *  access to a variable in this table.
+ *  Load() compiles the text file to a binary cache next to it (see GetCacheFileName()).
+ *  Later loads map the cache instead of parsing the text, as long as the checksum of the
+ *  text file matches the one stored in the cache.
  *  @author Sbastien Lussier.
  */
 class CORE_API ConfigFile
@@ -137,6 +152,25 @@ public:
     };
     friend class Iterator;
 
+    /**
+     *  Handle on a variable, resolved by name once with GetKey().
+     *  A handle stays valid until its variable is removed by Clear().
+     */
+    class CORE_API Key
+    {
+        friend class ConfigFile;
+
+    public:
+        Key() : mID(INVALID_ID) {}
+        Bool IsValid() const { return mID != INVALID_ID; }
+
+    private:
+        explicit Key( UInt32 pID ) : mID(pID) {}
+
+        static const UInt32 INVALID_ID = 0xFFFFFFFF;
+        UInt32  mID;
+    };
+
 public:
     /**
      *  Constructor.
@@ -151,7 +185,11 @@ public:
     //! Save the content of the config file on disk.
     void Save();   
     
-    //! Load the content of the config file from disk.
+    /**
+     *  Load the content of the config file from disk.
+     *  The binary cache is used when it is up to date, otherwise the text file is
+     *  parsed and the cache is written again.
+     */
     void Load();
 
     //! Empty the config file of all it's sections and variables.
@@ -172,19 +210,52 @@ public:
      *  @param  pDefaultValue   Default value that will be returned if the variable is not found.
      *  @return A variant containing the variable's value.
      */
-    Variant& Get( const String& pSectionName, const String& pVarName, Variant pDefaultValue );
+    Variant& Get( const String& pSectionName, const String& pVarName, const Variant& pDefaultValue );
+
+    /**
+     *  Resolve a variable to a handle, for direct access with Get( Key ).
+     *  @param  pSectionName    Name of the section of the variable.
+     *  @param  pVarName        Name of the variable.
+     *  @param  pDefaultValue   Value of the variable if it doesn't exist yet.
+     *  @return A handle on the variable.
+     */
+    Key GetKey( const String& pSectionName, const String& pVarName, const Variant& pDefaultValue );
+
+    //! Access a variable using a handle obtained with GetKey().
+    Variant& Get( Key pKey );
 
     //!< Get the filename.
     const String& GetFileName() const;
 
+    //! Get the name of the binary cache compiled from this config file.
+    String GetCacheFileName() const;
+
+    //! Return true if the last Load() used the binary cache.
+    Bool IsLoadedFromCache() const;
+
 #ifdef GD_DEBUG
     //!< Print the content of the config file.
     std::ostream& DebugPrint( std::ostream& pOut );
 #endif
 
+private:
+    //! ConfigSection registers its variables in the value table.
+    friend class ConfigSection;
+
+    //! Parse the text format.
+    void LoadText( std::istream& pIn );
+
+    //! Load the binary cache, return false if it is missing or doesn't match pChecksum.
+    Bool LoadCache( const MD5Checksum::Value& pChecksum );
+
+    //! Write the binary cache of the current content, tagged with the checksum of the text file.
+    void SaveCache( const MD5Checksum::Value& pChecksum );
+
 private:
     String                      mFileName;      //!< Config filename.
     Map<String,ConfigSection*>  mSections;      //!< Map of sections associated with their names.
+    Vector<Variant*>            mValues;        //!< Every variable, indexed by id. NULL once removed.
+    Bool                        mLoadedFromCache;
 };
 
 
@@ -45,7 +45,7 @@ Variant::~Variant()
     Clear();   
 }
 
-Variant::Variant( const Variant& pOther )   
+Variant::Variant( const Variant& pOther )   : mType( Variant_None )
 {  
     switch( pOther.mType )
     {
@@ -125,6 +125,9 @@ Variant::operator Bool () const
     case Variant_Int:         
         return mIntValue != 0;
         break;
+
+    case Variant_Float:
+        return mFloatValue != 0.0f;
         
     case Variant_String:      
         if( ToUpper( *mStringValue ) == "TRUE" ) 
@@ -147,6 +150,9 @@ Variant::operator Int32 () const
         
     case Variant_Bool:
         return mBoolValue == true ? 1 : 0;
+
+    case Variant_Float:
+        return Int32(mFloatValue);
             
     case Variant_String:
         return StringTo<Int32>( mStringValue->c_str() );
@@ -0,0 +1,199 @@
+/**
+ *  @file       HashMap.h
+ *  @brief      Open addressing hash map.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _HASH_MAP_H_
+#define     _HASH_MAP_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Hash functions used by HashMap. Specialize it to use a new key type.
+ */
+template <class K>
+class HashFunction
+{
+public:
+    UInt32 operator () ( const K& pKey ) const
+    {
+        return (UInt32)pKey * 2654435761U;
+    }
+};
+
+template <class T>
+class HashFunction<T*>
+{
+public:
+    UInt32 operator () ( T* pKey ) const
+    {
+        // Objects are at least 8 bytes aligned, drop the low bits before mixing.
+        size_t val = (size_t)pKey >> 3;
+        return (UInt32)(val ^ (val >> 29)) * 2654435761U;
+    }
+};
+
+template <>
+class HashFunction<String>
+{
+public:
+    UInt32 operator () ( const String& pKey ) const
+    {
+        // FNV-1a
+        UInt32 hash = 2166136261U;
+        for( String::const_iterator it = pKey.begin(); it != pKey.end(); ++it )
+        {
+            hash ^= (Byte)(*it);
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+};
+
+
+/**
+ *  Hash map storing its entries in a single array (open addressing, linear probing).
+ *  Lookups touch one or two cache lines instead of walking the nodes of a tree,
+ *  which makes it a good fit for large pointer to index tables.
+ *  The array is kept at most half full. Entries can't be removed individually, 
+ *  use Clear() to empty the map.
+ *  @brief  Open addressing hash map.
+ */
+template < class K, class V, class H = HashFunction<K> >
+class HashMap
+{
+public:
+    HashMap()
+        : mCount(0)
+    {
+    }
+
+    //! Number of entries in the map.
+    UInt32 Size() const
+    {
+        return mCount;
+    }
+
+    //! Remove all entries, the memory is kept for the next use.
+    void Clear()
+    {
+        for( typename Vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it )
+            *it = Slot();
+
+        mCount = 0;
+    }
+
+    //! Allocate enough slots to insert pCount entries without rehashing.
+    void Reserve( UInt32 pCount )
+    {
+        UInt32 capacity = 16;
+        while( capacity < pCount * 2 )
+            capacity <<= 1;
+
+        if( capacity > mSlots.size() )
+            Rehash( capacity );
+    }
+
+    //! Find the value associated with pKey, NULL if not in the map.
+    V* Find( const K& pKey )
+    {
+        if( mCount == 0 )
+            return NULL;
+
+        Slot& slot = mSlots[FindSlot(pKey)];
+        return slot.mUsed ? &slot.mValue : NULL;
+    }
+
+    const V* Find( const K& pKey ) const
+    {
+        return const_cast<HashMap*>(this)->Find( pKey );
+    }
+
+    //! Access the value associated with pKey, inserting a default value if it's not in the map.
+    V& operator [] ( const K& pKey )
+    {
+        if( (mCount + 1) * 2 > mSlots.size() )
+            Rehash( mSlots.empty() ? 16 : (UInt32)mSlots.size() * 2 );
+
+        Slot& slot = mSlots[FindSlot(pKey)];
+        if( !slot.mUsed )
+        {
+            slot.mKey   = pKey;
+            slot.mValue = V();
+            slot.mUsed  = true;
+            mCount++;
+        }
+
+        return slot.mValue;
+    }
+
+private:
+    class Slot
+    {
+    public:
+        Slot() : mKey(), mValue(), mUsed(false) {}
+
+        K       mKey;
+        V       mValue;
+        Bool    mUsed;
+    };
+
+    //! Index of the slot holding pKey, or of the empty slot where it would go.
+    UInt32 FindSlot( const K& pKey ) const
+    {
+        UInt32 mask  = (UInt32)mSlots.size() - 1;
+        UInt32 index = mHash(pKey) & mask;
+
+        while( mSlots[index].mUsed && !(mSlots[index].mKey == pKey) )
+            index = (index + 1) & mask;
+
+        return index;
+    }
+
+    void Rehash( UInt32 pCapacity )
+    {
+        Vector<Slot> oldSlots;
+        oldSlots.swap( mSlots );
+        mSlots.resize( pCapacity );
+
+        for( typename Vector<Slot>::iterator it = oldSlots.begin(); it != oldSlots.end(); ++it )
+        {
+            if( (*it).mUsed )
+                mSlots[FindSlot((*it).mKey)] = *it;
+        }
+    }
+
+private:
+    Vector<Slot>    mSlots;     //!< Power of two number of slots.
+    UInt32          mCount;     //!< Number of used slots.
+    H               mHash;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _HASH_MAP_H_
@@ -1,12 +1,10 @@
 /**
  *  @file       PerformanceMonitor.cpp
- *  @brief      Small profiler that lets you collect info at runtime.
- *  @desc       Posted on Flipcode COTD by Chris Brodie
- *              - Is reasonably lightweight. 
- *              - Easy to use. 
- *              - Real-time data access, you don't need to wait until application exits to get your data. 
- *              - Frame aware, i.e. it can be used to collect data on a frame by frame basis or perhaps per second for averaged display. 
- *              - Collects hierarchical data to aid in pinpointing bottlenecks 
+ *  @brief      Thread aware hierarchical profiler.
+ *  @desc       Originally based on the profiler posted on Flipcode COTD by Chris Brodie.
+ *              - Scopes are recorded in per thread event rings, without locks or allocations.
+ *              - Frame aware, events are folded into hierarchical stats at each frame boundary.
+ *              - Captures can be exported as Chrome trace JSON (chrome://tracing).
  *  @author     Sbastien Lussier.
  *  @date       10/02/04.
  */
@@ -34,6 +32,12 @@
 #include "Core.h"
 #include "PerformanceMonitor.h"
 
+#include "Thread/Thread.h"
+#include "Thread/Mutex.h"
+#include "Thread/Atomic.h"
+#include "Containers/HashMap.h"
+#include "FileManager/FileManager.h"
+
 
 namespace Gamedesk {
 	
@@ -41,7 +45,495 @@ namespace Gamedesk {
 #if GD_CFG_USE_PERF_MONITOR == GD_ENABLED
 
 tree<PerformanceStats>						PerformanceMonitor::mStats;
-tree<PerformanceStats>::sibling_iterator	PerformanceMonitor::mParent = mStats.begin();
+
+
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+    #define GD_THREAD_LOCAL __declspec(thread)
+#else
+    #define GD_THREAD_LOCAL __thread
+#endif
+
+
+static const UInt32 EVENTS_MASK = Profiler::EVENTS_PER_THREAD - 1;
+
+//! Name of the frame markers, compared by pointer.
+static const Char   FRAME_EVENT_NAME[] = "Frame";
+
+
+/**
+ *  Begin, end or frame event. End events have no name.
+ */
+class ProfilerEvent
+{
+public:
+    const Char*     mName;
+    UInt64          mTime;      //!< CPU cycles.
+};
+
+
+/**
+ *  Event kept for the Chrome trace export.
+ */
+class CapturedEvent
+{
+public:
+    CapturedEvent( const ProfilerEvent& pEvent, UInt32 pThreadId )
+        : mName(pEvent.mName)
+        , mTime(pEvent.mTime)
+        , mThreadId(pEvent.mName == FRAME_EVENT_NAME ? 0 : pThreadId)
+    {
+    }
+
+    const Char*     mName;
+    UInt64          mTime;
+    UInt32          mThreadId;
+};
+
+
+/**
+ *  Name given to a thread, kept after its ring is freed for the traces.
+ */
+class ThreadName
+{
+public:
+    UInt32          mThreadId;
+    const Char*     mName;
+};
+
+
+/**
+ *  Scope opened on a thread, as seen by the collector.
+ */
+class OpenScope
+{
+public:
+    const Char*                         mName;
+    UInt64                              mStart;
+    tree<PerformanceStats>::iterator    mNode;
+};
+
+
+/**
+ *  Event ring of one thread. The owner thread is the only writer of mEvents and
+ *  mWritten, the collector is the only writer of mRead.
+ */
+class ProfilerThread
+{
+public:
+    ProfilerThread()
+        : mReleased(0)
+        , mOpenRecorded(0)
+        , mOpenDropped(0)
+        , mThreadId(Thread::GetCurrentId())
+    {
+    }
+
+    //! Return true if pCount events can be pushed.
+    Bool HasRoom( UInt32 pCount ) const
+    {
+        UInt32 used = (UInt32)mWritten.Get() - (UInt32)mRead.Get();
+        return used + pCount <= Profiler::EVENTS_PER_THREAD;
+    }
+
+    void Push( const Char* pName, UInt64 pTime )
+    {
+        UInt32 written = (UInt32)mWritten.Get();
+        ProfilerEvent& event = mEvents[written & EVENTS_MASK];
+        event.mName = pName;
+        event.mTime = pTime;
+
+        // Publish the event to the collector.
+        mWritten.Set( written + 1 );
+    }
+
+public:
+    ProfilerEvent       mEvents[Profiler::EVENTS_PER_THREAD];
+    AtomicInt32         mWritten;
+    AtomicInt32         mRead;
+    AtomicInt32         mReleased;          //!< Set by the owner thread after its last event.
+
+    // Owner thread state.
+    UInt32              mOpenRecorded;      //!< Scopes whose begin was recorded but not their end.
+    UInt32              mOpenDropped;       //!< Scopes dropped, always nested in the recorded ones.
+    HashMap<String, const Char*>    mPersistentNames;   //!< Names returned by Profiler::GetPersistentName().
+
+    UInt32              mThreadId;
+
+    // Collector state.
+    Vector<OpenScope>   mOpenScopes;
+};
+
+
+static GD_THREAD_LOCAL ProfilerThread*  gCurrentThread = NULL;
+
+static Mutex                    gThreadsMutex;      //!< Protects the thread list and the collector state.
+static Vector<ProfilerThread*>  gThreads;
+static Vector<ThreadName>       gThreadNames;
+static AtomicInt32              gDroppedEvents;
+
+static Bool                     gCapturing = false;
+static UInt64                   gCaptureStart = 0;
+static Vector<CapturedEvent>    gCapturedEvents;
+
+static Mutex                    gNamesMutex;        //!< Protects gPersistentNames.
+static List<String>             gPersistentNames;   //!< Never shrinks, the scopes keep pointers to these names.
+
+
+//! Return the ring of the calling thread, registering it on first use.
+static ProfilerThread* GetProfilerThread()
+{
+    if( gCurrentThread == NULL )
+    {
+        // Rings live until ReleaseThread() is called, threads that don't call it may be profiled up to the end.
+        ProfilerThread* thread = GD_NEW(ProfilerThread, NULL, "Core::Debug::Profiler");
+
+        gThreadsMutex.Lock();
+        gThreads.push_back( thread );
+        gThreadsMutex.Unlock();
+
+        gCurrentThread = thread;
+    }
+
+    return gCurrentThread;
+}
+
+//! Return the child of pParent named pName, creating it if needed.
+static tree<PerformanceStats>::iterator FindChild( tree<PerformanceStats>::iterator pParent, const Char* pName )
+{
+    tree<PerformanceStats>& stats = PerformanceMonitor::mStats;
+
+    for( tree<PerformanceStats>::sibling_iterator itr = stats.begin(pParent); itr != stats.end(pParent); ++itr )
+    {
+        if( itr->mName == pName )
+            return itr;
+    }
+
+    return stats.append_child( pParent, PerformanceStats(pName) );
+}
+
+//! Return the root of the stats, creating it if needed.
+static tree<PerformanceStats>::iterator GetRoot()
+{
+    tree<PerformanceStats>& stats = PerformanceMonitor::mStats;
+
+    if( stats.size() == 0 )
+        return stats.insert( stats.begin(), PerformanceStats("Gamedesk") );
+
+    return stats.begin();
+}
+
+static void AddSample( PerformanceStats& pStats, UInt64 pElapsed )
+{
+    pStats.mSamples++;
+    pStats.mTotalTime += pElapsed;
+
+    if( pStats.mSamples == 1 )
+    {
+        pStats.mMax = pElapsed;
+        pStats.mMin = pElapsed;
+    }
+    else
+    {
+        pStats.mMax = Maths::Max<UInt64>(pElapsed, pStats.mMax);
+        pStats.mMin = Maths::Min<UInt64>(pElapsed, pStats.mMin);
+    }
+}
+
+//! Write pText as a JSON string.
+static void WriteJsonString( Stream& pStream, const Char* pText )
+{
+    String text("\"");
+    for( ; *pText; pText++ )
+    {
+        if( *pText == '"' || *pText == '\\' )
+            text += '\\';
+        if( (Byte)*pText >= ' ' )
+            text += *pText;
+    }
+    text += "\"";
+
+    pStream.Serialize( (void*)text.c_str(), text.size() );
+}
+
+static void WriteText( Stream& pStream, const Char* pText )
+{
+    pStream.Serialize( (void*)pText, strlen(pText) );
+}
+
+
+void Profiler::Begin( const Char* pName )
+{
+    ProfilerThread* thread = GetProfilerThread();
+
+    // Keep room for the end of this scope and of every scope it is nested in.
+    if( thread->mOpenDropped == 0 && thread->HasRoom(thread->mOpenRecorded + 2) )
+    {
+        thread->mOpenRecorded++;
+        thread->Push( pName, SystemInfo::Instance()->GetCpuCycles() );
+    }
+    else
+    {
+        thread->mOpenDropped++;
+        gDroppedEvents.Increment();
+    }
+}
+
+void Profiler::End()
+{
+    UInt64 time = SystemInfo::Instance()->GetCpuCycles();
+    ProfilerThread* thread = GetProfilerThread();
+
+    if( thread->mOpenDropped > 0 )
+    {
+        thread->mOpenDropped--;
+        return;
+    }
+
+    GD_ASSERT_M( thread->mOpenRecorded > 0, "[Profiler::End] No scope to close!" );
+    thread->mOpenRecorded--;
+    thread->Push( NULL, time );
+}
+
+void Profiler::EndFrame()
+{
+    ProfilerThread* thread = GetProfilerThread();
+
+    if( thread->HasRoom(thread->mOpenRecorded + 1) )
+        thread->Push( FRAME_EVENT_NAME, SystemInfo::Instance()->GetCpuCycles() );
+    else
+        gDroppedEvents.Increment();
+
+    Collect();
+}
+
+void Profiler::SetThreadName( const Char* pName )
+{
+    UInt32 threadId = Thread::GetCurrentId();
+
+    gThreadsMutex.Lock();
+
+    UInt32 i = 0;
+    while( i < gThreadNames.size() && gThreadNames[i].mThreadId != threadId )
+        i++;
+
+    if( i == gThreadNames.size() )
+    {
+        gThreadNames.push_back( ThreadName() );
+        gThreadNames[i].mThreadId = threadId;
+    }
+
+    gThreadNames[i].mName = pName;
+
+    gThreadsMutex.Unlock();
+}
+
+void Profiler::ReleaseThread()
+{
+    if( gCurrentThread == NULL )
+        return;
+
+    // The collector frees the ring once it has read its last events.
+    gCurrentThread->mReleased.Set( 1 );
+    gCurrentThread = NULL;
+}
+
+const Char* Profiler::GetPersistentName( const String& pName )
+{
+    ProfilerThread* thread = GetProfilerThread();
+
+    const Char** cachedName = thread->mPersistentNames.Find( pName );
+    if( cachedName )
+        return *cachedName;
+
+    gNamesMutex.Lock();
+
+    List<String>::iterator itName = std::find( gPersistentNames.begin(), gPersistentNames.end(), pName );
+    if( itName == gPersistentNames.end() )
+        itName = gPersistentNames.insert( gPersistentNames.end(), pName );
+
+    const Char* name = itName->c_str();
+
+    gNamesMutex.Unlock();
+
+    thread->mPersistentNames[pName] = name;
+    return name;
+}
+
+void Profiler::Collect()
+{
+    gThreadsMutex.Lock();
+
+    UInt64 frequency = SystemInfo::Instance()->GetCpuFrequency();
+    tree<PerformanceStats>::iterator root = GetRoot();
+
+    for( UInt32 i = 0; i < gThreads.size(); i++ )
+    {
+        ProfilerThread* thread = gThreads[i];
+
+        // Checked first, the events published before the flag are all read below.
+        Bool released = thread->mReleased.Get() != 0;
+
+        UInt32 read = (UInt32)thread->mRead.Get();
+        UInt32 written = (UInt32)thread->mWritten.Get();
+
+        for( ; read != written; read++ )
+        {
+            const ProfilerEvent& event = thread->mEvents[read & EVENTS_MASK];
+
+            if( gCapturing )
+                gCapturedEvents.push_back( CapturedEvent(event, thread->mThreadId) );
+
+            if( event.mName == FRAME_EVENT_NAME )
+                continue;
+
+            if( event.mName )
+            {
+                OpenScope scope;
+                scope.mName = event.mName;
+                scope.mStart = event.mTime;
+                scope.mNode = FindChild( thread->mOpenScopes.empty() ? root : thread->mOpenScopes.back().mNode, event.mName );
+                thread->mOpenScopes.push_back( scope );
+            }
+            else
+            {
+                const OpenScope& scope = thread->mOpenScopes.back();
+                AddSample( *scope.mNode, (event.mTime - scope.mStart) * 1000000 / frequency );
+                thread->mOpenScopes.pop_back();
+            }
+        }
+
+        // Give the slots back to the owner thread.
+        thread->mRead.Set( written );
+
+        if( released )
+        {
+            GD_DELETE(thread);
+            gThreads.erase( gThreads.begin() + i );
+            i--;
+        }
+    }
+
+    gThreadsMutex.Unlock();
+}
+
+void Profiler::StartCapture()
+{
+    // Events recorded before the capture starts are not part of it.
+    Collect();
+
+    gThreadsMutex.Lock();
+    gCapturing = true;
+    gCaptureStart = SystemInfo::Instance()->GetCpuCycles();
+    gCapturedEvents.clear();
+    gThreadsMutex.Unlock();
+}
+
+Bool Profiler::StopCapture( const String& pFileName )
+{
+    if( !IsCapturing() )
+        return false;
+
+    Collect();
+
+    gThreadsMutex.Lock();
+    gCapturing = false;
+
+    Vector<CapturedEvent> events;
+    events.swap( gCapturedEvents );
+
+    Vector<ThreadName> threadNames = gThreadNames;
+    gThreadsMutex.Unlock();
+
+    Stream* stream = FileManager::CreateOutputStream( pFileName );
+    if( !stream )
+        return false;
+
+    Double ticksPerMicroSec = SystemInfo::Instance()->GetCpuFrequency() / 1000000.0;
+    Char buffer[128];
+
+    WriteText( *stream, "{\"traceEvents\":[\n" );
+
+    // Thread names.
+    for( UInt32 i = 0; i < threadNames.size(); i++ )
+    {
+        sprintf( buffer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", threadNames[i].mThreadId );
+        WriteText( *stream, buffer );
+        WriteJsonString( *stream, threadNames[i].mName );
+        WriteText( *stream, "}},\n" );
+    }
+
+    for( UInt32 i = 0; i < events.size(); i++ )
+    {
+        const CapturedEvent& event = events[i];
+        Double timeStamp = (Int64)(event.mTime - gCaptureStart) / ticksPerMicroSec;
+
+        if( event.mName == FRAME_EVENT_NAME )
+        {
+            sprintf( buffer, "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f},\n", timeStamp );
+            WriteText( *stream, buffer );
+        }
+        else if( event.mName )
+        {
+            sprintf( buffer, "{\"ph\":\"B\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"name\":", event.mThreadId, timeStamp );
+            WriteText( *stream, buffer );
+            WriteJsonString( *stream, event.mName );
+            WriteText( *stream, "},\n" );
+        }
+        else
+        {
+            sprintf( buffer, "{\"ph\":\"E\",\"pid\":0,\"tid\":%u,\"ts\":%.3f},\n", event.mThreadId, timeStamp );
+            WriteText( *stream, buffer );
+        }
+    }
+
+    // The last entry can't be followed by a comma.
+    WriteText( *stream, "{}\n],\"displayTimeUnit\":\"ms\"}\n" );
+
+    GD_DELETE(stream);
+    return true;
+}
+
+Bool Profiler::IsCapturing()
+{
+    gThreadsMutex.Lock();
+    Bool capturing = gCapturing;
+    gThreadsMutex.Unlock();
+
+    return capturing;
+}
+
+UInt32 Profiler::GetNbDroppedEvents()
+{
+    return gDroppedEvents.Get();
+}
+
+UInt32 Profiler::GetNbThreads()
+{
+    gThreadsMutex.Lock();
+    UInt32 nbThreads = gThreads.size();
+    gThreadsMutex.Unlock();
+
+    return nbThreads;
+}
+
+
+void PerformanceMonitor::Reset()
+{
+    gThreadsMutex.Lock();
+
+    mStats.clear();
+
+    // Scopes still open must be rebuilt in the new tree.
+    tree<PerformanceStats>::iterator root = GetRoot();
+    for( UInt32 i = 0; i < gThreads.size(); i++ )
+    {
+        Vector<OpenScope>& scopes = gThreads[i]->mOpenScopes;
+        for( UInt32 j = 0; j < scopes.size(); j++ )
+            scopes[j].mNode = FindChild( j == 0 ? root : scopes[j-1].mNode, scopes[j].mName );
+    }
+
+    gThreadsMutex.Unlock();
+}
 
 #endif
 
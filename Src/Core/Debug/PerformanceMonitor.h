@@ -1,12 +1,10 @@
 /**
  *  @file       PerformanceMonitor.h
- *  @brief      Small profiler that lets you collect info at runtime.
- *  @desc       Posted on Flipcode COTD by Chris Brodie
- *              - Is reasonably lightweight. 
- *              - Easy to use. 
- *              - Real-time data access, you don't need to wait until application exits to get your data. 
- *              - Frame aware, i.e. it can be used to collect data on a frame by frame basis or perhaps per second for averaged display. 
- *              - Collects hierarchical data to aid in pinpointing bottlenecks 
+ *  @brief      Thread aware hierarchical profiler.
+ *  @desc       Originally based on the profiler posted on Flipcode COTD by Chris Brodie.
+ *              - Scopes are recorded in per thread event rings, without locks or allocations.
+ *              - Frame aware, events are folded into hierarchical stats at each frame boundary.
+ *              - Captures can be exported as Chrome trace JSON (chrome://tracing).
  *  @author     Sbastien Lussier.
  *  @date       10/02/04.
  */
@@ -82,69 +80,93 @@ public:
 };
 
 
+/**
+ *  Records profiling events from any thread.
+ *  Each thread owns a ring of events it is the only one to write to, so opening
+ *  and closing a scope takes no lock and allocates nothing. Names are kept by
+ *  pointer and must stay valid for the lifetime of the process (string literals,
+ *  or GetPersistentName()). When a ring is full, new scopes are dropped until it
+ *  is drained.
+ *  Collect() drains the rings into PerformanceMonitor::mStats and, while a
+ *  capture is running, keeps the events for the Chrome trace export.
+ */
+class CORE_API Profiler
+{
+public:
+    static const UInt32 EVENTS_PER_THREAD = 16384;  //!< Ring size, must be a power of two.
+
+    //! Open a scope on the calling thread.
+    static void Begin( const Char* pName );
+
+    //! Close the innermost scope of the calling thread.
+    static void End();
+
+    //! Mark the end of a frame and collect the events of every thread.
+    static void EndFrame();
+
+    //! Name the calling thread in exported traces.
+    static void SetThreadName( const Char* pName );
+
+    //! Called by a thread that won't record anything anymore, its ring is freed by the next Collect().
+    static void ReleaseThread();
+
+    /**
+     *  Return a copy of pName that stays valid for the lifetime of the process, the same one for equal names.
+     *  Each thread caches the names it asked for, only the first request of a name takes a lock.
+     */
+    static const Char* GetPersistentName( const String& pName );
+
+    //! Fold the events recorded since the last call into PerformanceMonitor::mStats.
+    static void Collect();
+
+    //! Keep the collected events until StopCapture() is called.
+    static void StartCapture();
+
+    /**
+     *  Collect the pending events, stop the capture and write it as Chrome trace JSON.
+     *  @param  pFileName   File to create, open it in chrome://tracing.
+     *  @return \c false if no capture was running or the file could not be created.
+     */
+    static Bool StopCapture( const String& pFileName );
+
+    //! Return \c true between StartCapture() and StopCapture().
+    static Bool IsCapturing();
+
+    //! Number of events dropped because a thread ring was full.
+    static UInt32 GetNbDroppedEvents();
+
+    //! Number of threads that have a ring.
+    static UInt32 GetNbThreads();
+};
+
+
+/**
+ *  Profile the scope in which it is declared, use the Profile() macro.
+ */
 class CORE_API PerformanceMonitor
 {
 public:
-	PerformanceMonitor( const String& pName )
+	PerformanceMonitor( const Char* pName )
 	{
-        // The tree is empty, create a root node
-		if( mStats.size() == 0 )
-			mParent = mStats.insert( mStats.begin(), PerformanceStats("Gamedesk") );
-
-		// Check to see if we are resampling an existing profile subject.
-		PerformanceStats NewStats( pName );
-		tree<PerformanceStats>::sibling_iterator itr = std::find( mStats.begin(mParent), mStats.end(mParent), NewStats );
-			
-		if( itr != mStats.end(mParent) )
-        {
-            mParent = itr;
-            mThisNode = itr;
-        }
-	    else
-		{ 	
-			// Profile subject did not exist, create a new one.
-			mParent = mStats.append_child( mParent, NewStats );
-			mThisNode = mParent;
-		}
-		
-		mStart = SystemInfo::Instance()->GetMicroSec64();
+		Profiler::Begin( pName );
 	}
 
-	~PerformanceMonitor()
+	//! pName is copied, it may be freed before the scope is collected (ex. class names of plugins).
+	PerformanceMonitor( const String& pName )
 	{
-		UInt64 Elapsed = SystemInfo::Instance()->GetMicroSec64() - mStart;
-
-		// Record statistics for this sampling
-		mThisNode->mSamples++;
-		mThisNode->mTotalTime += Elapsed;
-		
-		if( mThisNode->mSamples == 1 )
-		{
-			mThisNode->mMax = Elapsed;
-			mThisNode->mMin = Elapsed;
-	    }
-		else
-		{
-			mThisNode->mMax = Maths::Max<Double>(Elapsed, mThisNode->mMax);
-			mThisNode->mMin = Maths::Min<Double>(Elapsed, mThisNode->mMin);
-		}
-		
-		// Reset parent pointer
-	    mParent = mStats.parent(mThisNode);
+		Profiler::Begin( Profiler::GetPersistentName( pName ) );
 	}
 
-	static void Reset(void)
+	~PerformanceMonitor()
 	{
-		mStats.clear();
+		Profiler::End();
 	}
 
-public:
-	static tree<PerformanceStats>					mStats;
+	//! Discard the collected stats.
+	static void Reset();
 
-private:
-	UInt64											mStart;
-	tree<PerformanceStats>::iterator				mThisNode;
-	static tree<PerformanceStats>::sibling_iterator	mParent;
+public:
+	static tree<PerformanceStats>					mStats;     //!< Updated by Profiler::Collect(), times in microseconds.
 };
 
 
@@ -156,8 +178,10 @@ private:
 
 #if GD_CFG_USE_PERF_MONITOR == GD_ENABLED
     #define Profile(Name) Gamedesk::PerformanceMonitor 	monitor(Name)
+    #define ProfileFrame() Gamedesk::Profiler::EndFrame()
 #else
     #define Profile(Name)
+    #define ProfileFrame()
 #endif
 
 
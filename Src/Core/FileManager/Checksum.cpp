@@ -434,4 +434,109 @@ inline void MD5Checksum::II(UInt32& a, UInt32 b, UInt32 c, UInt32 d, UInt32 x, U
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// XXHashChecksum
+static const UInt64 XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const UInt64 XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const UInt64 XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+static const UInt64 XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const UInt64 XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline UInt64 XXHRotateLeft( UInt64 pValue, UInt32 pBits )
+{
+    return (pValue << pBits) | (pValue >> (64 - pBits));
+}
+
+static inline UInt64 XXHRead64( const Byte* pData )
+{
+    UInt64 value;
+    memcpy( &value, pData, sizeof(value) );
+    return value;
+}
+
+static inline UInt32 XXHRead32( const Byte* pData )
+{
+    UInt32 value;
+    memcpy( &value, pData, sizeof(value) );
+    return value;
+}
+
+static inline UInt64 XXHRound( UInt64 pAcc, UInt64 pInput )
+{
+    pAcc += pInput * XXH_PRIME64_2;
+    pAcc  = XXHRotateLeft( pAcc, 31 );
+    return pAcc * XXH_PRIME64_1;
+}
+
+static inline UInt64 XXHMergeRound( UInt64 pAcc, UInt64 pValue )
+{
+    pAcc ^= XXHRound( 0, pValue );
+    return pAcc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+XXHashChecksum::Value XXHashChecksum::Compute( const Byte* pData, UInt32 pSize, UInt64 pSeed )
+{
+    const Byte* data = pData;
+    const Byte* end  = pData + pSize;
+    UInt64      hash;
+
+    if( pSize >= 32 )
+    {
+        const Byte* stripeEnd = end - 32;
+        UInt64 v1 = pSeed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        UInt64 v2 = pSeed + XXH_PRIME64_2;
+        UInt64 v3 = pSeed;
+        UInt64 v4 = pSeed - XXH_PRIME64_1;
+
+        do
+        {
+            v1 = XXHRound( v1, XXHRead64(data) );
+            v2 = XXHRound( v2, XXHRead64(data + 8) );
+            v3 = XXHRound( v3, XXHRead64(data + 16) );
+            v4 = XXHRound( v4, XXHRead64(data + 24) );
+            data += 32;
+        } while( data <= stripeEnd );
+
+        hash = XXHRotateLeft( v1, 1 ) + XXHRotateLeft( v2, 7 ) + XXHRotateLeft( v3, 12 ) + XXHRotateLeft( v4, 18 );
+        hash = XXHMergeRound( hash, v1 );
+        hash = XXHMergeRound( hash, v2 );
+        hash = XXHMergeRound( hash, v3 );
+        hash = XXHMergeRound( hash, v4 );
+    }
+    else
+    {
+        hash = pSeed + XXH_PRIME64_5;
+    }
+
+    hash += pSize;
+
+    for( ; data + 8 <= end; data += 8 )
+    {
+        hash ^= XXHRound( 0, XXHRead64(data) );
+        hash  = XXHRotateLeft( hash, 27 ) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+
+    if( data + 4 <= end )
+    {
+        hash ^= UInt64( XXHRead32(data) ) * XXH_PRIME64_1;
+        hash  = XXHRotateLeft( hash, 23 ) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        data += 4;
+    }
+
+    for( ; data < end; data++ )
+    {
+        hash ^= (*data) * XXH_PRIME64_5;
+        hash  = XXHRotateLeft( hash, 11 ) * XXH_PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+
 } // namespace Gamedesk
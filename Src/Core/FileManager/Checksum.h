@@ -115,6 +115,20 @@ private:
 };
 
 
+/**
+ *  64 bit xxHash, see http://cyan4973.github.io/xxHash/
+ *  Much faster than MD5 to detect changes in data, but not cryptographic.
+ */
+class CORE_API XXHashChecksum
+{
+public:
+    typedef UInt64 Value;
+
+    //! Hash a memory block.
+    static Value Compute( const Byte* pData, UInt32 pSize, UInt64 pSeed = 0 );
+};
+
+
 } // namespace Gamedesk
 
 
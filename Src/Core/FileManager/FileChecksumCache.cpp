@@ -0,0 +1,271 @@
+/**
+ *  @file       FileChecksumCache.cpp
+ *  @brief      Checksums of files on disk, cached by size and modification time.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "FileChecksumCache.h"
+#include "FileManager/FileManager.h"
+#include "FileManager/MemoryFile.h"
+#include "Thread/JobManager.h"
+
+
+namespace Gamedesk {
+
+
+static const UInt32 CHECKSUM_CACHE_MAGIC   = 0x43434447;   // "GDCC"
+static const UInt32 CHECKSUM_CACHE_VERSION = 2;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Hash the stale files of a GetChecksums() call.
+class FileChecksumBody : public ParallelForBody
+{
+public:
+    FileChecksumBody( const Vector<String>& pFileNames, Vector<FileChecksum>& pChecksums, FileChecksum::Algorithm pAlgorithm )
+        : mFileNames(pFileNames)
+        , mChecksums(pChecksums)
+        , mAlgorithm(pAlgorithm)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+            mChecksums[i] = FileChecksumCache::ComputeChecksum( mFileNames[i], mAlgorithm );
+    }
+
+private:
+    const Vector<String>&           mFileNames;
+    Vector<FileChecksum>&           mChecksums;
+    FileChecksum::Algorithm         mAlgorithm;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FileChecksumCache
+FileChecksumCache::FileChecksumCache( FileChecksum::Algorithm pAlgorithm )
+    : mAlgorithm(pAlgorithm)
+    , mNbHashedFiles(0)
+{
+}
+
+FileChecksum::Algorithm FileChecksumCache::GetAlgorithm() const
+{
+    return mAlgorithm;
+}
+
+void FileChecksumCache::Load( const String& pCacheFileName )
+{
+    Clear();
+
+    if( !FileManager::FileExist(pCacheFileName) || FileManager::GetFileSize(pCacheFileName) < 4 * sizeof(UInt32) )
+        return;
+
+    Stream* stream = FileManager::CreateInputStream( pCacheFileName );
+    if( !stream )
+        return;
+
+    UInt32 magic   = 0;
+    UInt32 version = 0;
+    UInt32 algorithm = 0;
+    UInt32 nbEntries = 0;
+    (*stream) << magic << version << algorithm << nbEntries;
+
+    if( magic == CHECKSUM_CACHE_MAGIC && version == CHECKSUM_CACHE_VERSION && algorithm == (UInt32)mAlgorithm )
+    {
+        for( UInt32 i = 0; i < nbEntries; i++ )
+        {
+            String fileName;
+            Entry  entry;
+
+            (*stream) << fileName << entry.mSize << entry.mWriteTime << entry.mChecksum;
+
+            mEntries[fileName] = entry;
+        }
+    }
+
+    GD_DELETE(stream);
+}
+
+void FileChecksumCache::Save( const String& pCacheFileName )
+{
+    Stream* stream = FileManager::CreateOutputStream( pCacheFileName );
+    if( !stream )
+        return;
+
+    UInt32 magic     = CHECKSUM_CACHE_MAGIC;
+    UInt32 version   = CHECKSUM_CACHE_VERSION;
+    UInt32 algorithm = mAlgorithm;
+    UInt32 nbEntries = (UInt32)mEntries.size();
+    (*stream) << magic << version << algorithm << nbEntries;
+
+    for( Map<String,Entry>::iterator itEntry = mEntries.begin(); itEntry != mEntries.end(); ++itEntry )
+    {
+        String fileName = (*itEntry).first;
+        Entry& entry    = (*itEntry).second;
+
+        (*stream) << fileName << entry.mSize << entry.mWriteTime << entry.mChecksum;
+    }
+
+    GD_DELETE(stream);
+}
+
+void FileChecksumCache::Clear()
+{
+    mEntries.clear();
+}
+
+FileChecksum FileChecksumCache::GetChecksum( const String& pFileName )
+{
+    Map<String,Entry>::iterator itEntry = mEntries.find( pFileName );
+
+    Entry entry;
+    if( IsUpToDate( pFileName, itEntry != mEntries.end() ? &(*itEntry).second : NULL, entry ) )
+        return (*itEntry).second.mChecksum;
+
+    // The file doesn't exist.
+    if( entry.mWriteTime == 0 )
+    {
+        if( itEntry != mEntries.end() )
+            mEntries.erase( itEntry );
+        return FileChecksum();
+    }
+
+    entry.mChecksum = ComputeChecksum( pFileName, mAlgorithm );
+    mEntries[pFileName] = entry;
+    mNbHashedFiles++;
+
+    return entry.mChecksum;
+}
+
+void FileChecksumCache::GetChecksums( const Vector<String>& pFileNames, Vector<FileChecksum>& pChecksums )
+{
+    Vector<String>              staleFiles;
+    Vector<Entry>               staleEntries;
+    Map<String,UInt32>          staleIndices;
+    Vector<Int32>               fileToStale;
+
+    fileToStale.assign( pFileNames.size(), -1 );
+    pChecksums.assign( pFileNames.size(), FileChecksum() );
+
+    // Take what we can from the cache, and list the files to hash (only once each).
+    for( UInt32 i = 0; i < pFileNames.size(); i++ )
+    {
+        const String& fileName = pFileNames[i];
+
+        Map<String,UInt32>::iterator itStale = staleIndices.find( fileName );
+        if( itStale != staleIndices.end() )
+        {
+            fileToStale[i] = (*itStale).second;
+            continue;
+        }
+
+        Map<String,Entry>::iterator itEntry = mEntries.find( fileName );
+
+        Entry entry;
+        if( IsUpToDate( fileName, itEntry != mEntries.end() ? &(*itEntry).second : NULL, entry ) )
+        {
+            pChecksums[i] = (*itEntry).second.mChecksum;
+        }
+        else if( entry.mWriteTime == 0 )
+        {
+            if( itEntry != mEntries.end() )
+                mEntries.erase( itEntry );
+        }
+        else
+        {
+            fileToStale[i] = (Int32)staleFiles.size();
+            staleIndices[fileName] = (UInt32)staleFiles.size();
+            staleFiles.push_back( fileName );
+            staleEntries.push_back( entry );
+        }
+    }
+
+    if( staleFiles.empty() )
+        return;
+
+    Vector<FileChecksum> staleChecksums;
+    staleChecksums.resize( staleFiles.size() );
+    FileChecksumBody body( staleFiles, staleChecksums, mAlgorithm );
+    JobManager::Instance()->ParallelFor( (UInt32)staleFiles.size(), 1, body );
+
+    for( UInt32 i = 0; i < staleFiles.size(); i++ )
+    {
+        staleEntries[i].mChecksum = staleChecksums[i];
+        mEntries[staleFiles[i]] = staleEntries[i];
+    }
+
+    for( UInt32 i = 0; i < pFileNames.size(); i++ )
+    {
+        if( fileToStale[i] != -1 )
+            pChecksums[i] = staleChecksums[fileToStale[i]];
+    }
+
+    mNbHashedFiles += (UInt32)staleFiles.size();
+}
+
+UInt32 FileChecksumCache::GetNbHashedFiles() const
+{
+    return mNbHashedFiles;
+}
+
+Bool FileChecksumCache::IsUpToDate( const String& pFileName, const Entry* pCached, Entry& pEntry )
+{
+    pEntry.mWriteTime = FileManager::GetLastWriteTime( pFileName );
+    pEntry.mSize      = pEntry.mWriteTime != 0 ? FileManager::GetFileSize( pFileName ) : 0;
+
+    return pCached != NULL && pEntry.mWriteTime != 0 &&
+           pCached->mWriteTime == pEntry.mWriteTime && pCached->mSize == pEntry.mSize;
+}
+
+FileChecksum FileChecksumCache::ComputeChecksum( const String& pFileName, FileChecksum::Algorithm pAlgorithm )
+{
+    if( !FileManager::FileExist(pFileName) )
+        return FileChecksum();
+
+    // Empty files can't be mapped.
+    if( FileManager::GetFileSize(pFileName) == 0 )
+        return ComputeChecksum( NULL, 0, pAlgorithm );
+
+    MemoryFile file( pFileName, true );
+    return ComputeChecksum( file.GetMemory(), file.GetSize(), pAlgorithm );
+}
+
+FileChecksum FileChecksumCache::ComputeChecksum( const Byte* pData, UInt32 pSize, FileChecksum::Algorithm pAlgorithm )
+{
+    GD_ASSERT( pAlgorithm != FileChecksum::Algorithm_None );
+
+    if( pAlgorithm == FileChecksum::Algorithm_XXHash )
+        return FileChecksum( XXHashChecksum::Compute( pData, pSize ) );
+
+    MD5Checksum checksum;
+    if( pSize != 0 )
+        checksum.Update( (Byte*)pData, pSize );
+    checksum.Finalize();
+
+    return FileChecksum( checksum.Digest() );
+}
+
+
+} // namespace Gamedesk
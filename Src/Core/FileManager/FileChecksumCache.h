@@ -0,0 +1,200 @@
+/**
+ *  @file       FileChecksumCache.h
+ *  @brief      Checksums of files on disk, cached by size and modification time.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _FILE_CHECKSUM_CACHE_H_
+#define     _FILE_CHECKSUM_CACHE_H_
+
+
+#include "FileManager/Checksum.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Checksum of a file, an MD5 digest or a 64 bit xxHash depending on the
+ *  algorithm of the FileChecksumCache that computed it. Checksums computed
+ *  with different algorithms are never equal.
+ */
+class CORE_API FileChecksum
+{
+public:
+    enum Algorithm
+    {
+        Algorithm_None,     //!< No checksum, the file doesn't exist.
+        Algorithm_MD5,      //!< MD5 digest, see MD5Checksum.
+        Algorithm_XXHash    //!< 64 bit xxHash, much faster but not cryptographic, see XXHashChecksum.
+    };
+
+public:
+    FileChecksum()
+        : mAlgorithm(Algorithm_None)
+        , mMD5(0, 0, 0, 0)
+        , mXXHash(0)
+    {
+    }
+
+    explicit FileChecksum( const MD5Checksum::Value& pMD5 )
+        : mAlgorithm(Algorithm_MD5)
+        , mMD5(pMD5)
+        , mXXHash(0)
+    {
+    }
+
+    explicit FileChecksum( XXHashChecksum::Value pXXHash )
+        : mAlgorithm(Algorithm_XXHash)
+        , mMD5(0, 0, 0, 0)
+        , mXXHash(pXXHash)
+    {
+    }
+
+    Algorithm GetAlgorithm() const
+    {
+        return mAlgorithm;
+    }
+
+    const MD5Checksum::Value& GetMD5() const
+    {
+        GD_ASSERT( mAlgorithm == Algorithm_MD5 );
+        return mMD5;
+    }
+
+    XXHashChecksum::Value GetXXHash() const
+    {
+        GD_ASSERT( mAlgorithm == Algorithm_XXHash );
+        return mXXHash;
+    }
+
+    Bool operator == ( const FileChecksum& pOther ) const
+    {
+        return mAlgorithm == pOther.mAlgorithm && mMD5 == pOther.mMD5 && mXXHash == pOther.mXXHash;
+    }
+
+    Bool operator != ( const FileChecksum& pOther ) const
+    {
+        return !(*this == pOther);
+    }
+
+    friend Stream& operator << ( Stream& pStream, FileChecksum& pChecksum )
+    {
+        UInt32 algorithm = pChecksum.mAlgorithm;
+        pStream << algorithm;
+        pChecksum.mAlgorithm = Algorithm(algorithm);
+
+        if( pChecksum.mAlgorithm == Algorithm_MD5 )
+            pStream << pChecksum.mMD5.A << pChecksum.mMD5.B << pChecksum.mMD5.C << pChecksum.mMD5.D;
+        else if( pChecksum.mAlgorithm == Algorithm_XXHash )
+            pStream << pChecksum.mXXHash;
+
+        return pStream;
+    }
+
+private:
+    Algorithm               mAlgorithm;
+    MD5Checksum::Value      mMD5;
+    XXHashChecksum::Value   mXXHash;
+};
+
+
+/**
+ *  Compute the checksum of files to detect when they change, for example to
+ *  decide if an asset must be imported again.
+ *  A file is hashed again only if its size or its last write time changed since
+ *  its checksum was cached; the cache can be saved and loaded between runs.
+ *  Files are read through memory mapping, and GetChecksums() hashes them in
+ *  parallel over the JobManager.
+ */
+class CORE_API FileChecksumCache
+{
+public:
+    //! Constructor.
+    FileChecksumCache( FileChecksum::Algorithm pAlgorithm = FileChecksum::Algorithm_MD5 );
+
+    //! Get the algorithm used to compute the checksums.
+    FileChecksum::Algorithm GetAlgorithm() const;
+
+    /**
+     *  Load the checksums saved by Save(). Does nothing if the file doesn't exist or
+     *  was saved with another algorithm.
+     *  @param  pCacheFileName  File to load.
+     */
+    void Load( const String& pCacheFileName );
+
+    /**
+     *  Save the checksums.
+     *  @param  pCacheFileName  File to save.
+     */
+    void Save( const String& pCacheFileName );
+
+    //! Forget every checksum.
+    void Clear();
+
+    /**
+     *  Get the checksum of a file, from the cache if the file didn't change.
+     *  @param  pFileName   Name of the file.
+     *  @return The checksum of the file, FileChecksum::Algorithm_None if the file doesn't exist.
+     */
+    FileChecksum GetChecksum( const String& pFileName );
+
+    /**
+     *  Get the checksum of several files, the ones that are not up to date in the cache
+     *  are hashed in parallel.
+     *  @param  pFileNames  Name of the files.
+     *  @param  pChecksums  Receives the checksum of each file, FileChecksum::Algorithm_None for the files that don't exist.
+     */
+    void GetChecksums( const Vector<String>& pFileNames, Vector<FileChecksum>& pChecksums );
+
+    //! Number of files read since the cache was created. The other checksums came from the cache.
+    UInt32 GetNbHashedFiles() const;
+
+    //! Compute the checksum of a file, without using a cache.
+    static FileChecksum ComputeChecksum( const String& pFileName, FileChecksum::Algorithm pAlgorithm );
+
+    //! Compute the checksum of a memory block.
+    static FileChecksum ComputeChecksum( const Byte* pData, UInt32 pSize, FileChecksum::Algorithm pAlgorithm );
+
+private:
+    class Entry
+    {
+    public:
+        UInt32              mSize;
+        UInt64              mWriteTime;
+        FileChecksum        mChecksum;
+    };
+
+    //! Return true if the cached entry still describes the file, and update pEntry to the current size/time.
+    static Bool IsUpToDate( const String& pFileName, const Entry* pCached, Entry& pEntry );
+
+private:
+    Map<String,Entry>   mEntries;
+    FileChecksum::Algorithm mAlgorithm;
+    UInt32              mNbHashedFiles;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _FILE_CHECKSUM_CACHE_H_
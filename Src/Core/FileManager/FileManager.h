@@ -101,6 +101,20 @@ public:
      */
     static Bool FileExist( const String& pFilename );
 
+    /**
+     *  Get the size of a file on disk.
+     *  @param  pFilename   The file name.
+     *  @return The size in bytes, 0 if the file doesn't exist.
+     */
+    static UInt32 GetFileSize( const String& pFilename );
+
+    /**
+     *  Get the last time a file was written to.
+     *  @param  pFilename   The file name.
+     *  @return A time stamp that increases each time the file is modified, 0 if the file doesn't exist.
+     */
+    static UInt64 GetLastWriteTime( const String& pFilename );
+
     static Stream* CreateInputStream( const String& pFile );
     static Stream* CreateOutputStream( const String& pFile );
 };
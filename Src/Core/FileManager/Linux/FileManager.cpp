@@ -28,6 +28,8 @@
 #include "Core.h"
 #include "FileManager.h"
 
+#include <sys/stat.h>
+
 
 namespace Gamedesk {
 	
@@ -75,5 +77,14 @@ void FileManager::DeleteFile( const String& pFilename )
 {
 }
 
+UInt64 FileManager::GetLastWriteTime( const String& pFilename )
+{
+    struct stat fileInfo;
+    if( stat( pFilename.c_str(), &fileInfo ) != 0 )
+        return 0;
+
+    return UInt64(fileInfo.st_mtim.tv_sec) * 1000000000 + fileInfo.st_mtim.tv_nsec;
+}
+
 
 } // namespace Gamedesk
@@ -100,6 +100,19 @@ Bool FileManager::FileExist( const String& pFilename )
     return sceIoGetstat(pFilename.c_str(), &fileStats) >= 0;
 }
 
+UInt64 FileManager::GetLastWriteTime( const String& pFilename )
+{
+    SceIoStat fileStats;
+    if( sceIoGetstat(pFilename.c_str(), &fileStats) < 0 )
+        return 0;
+
+    // Microseconds since year 0, months and years rounded up, it only has to increase.
+    const ScePspDateTime& time = fileStats.st_mtime;
+    UInt64 days    = (UInt64(time.year) * 12 + time.month) * 31 + time.day;
+    UInt64 seconds = ((days * 24 + time.hour) * 60 + time.minute) * 60 + time.second;
+    return seconds * 1000000 + time.microsecond;
+}
+
 class StdFileInputStream : public InputStream
 {
     friend class FileManager;
@@ -0,0 +1,452 @@
+/**
+ *  @file       TextLexer.cpp
+ *  @brief      Tokenizer for text files, working in place over the file data.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "TextLexer.h"
+
+#include "SystemInfo/SystemInfo.h"
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    #include <emmintrin.h>
+#endif
+
+#include <math.h>
+
+
+namespace Gamedesk {
+
+
+//! Powers of ten that are exactly representable as a double.
+static const Double POWERS_OF_TEN[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const Int32 MAX_EXACT_POWER_OF_TEN = 22;
+
+//! Significant digits kept in the mantissa, more would overflow an UInt64.
+static const UInt32 MAX_MANTISSA_DIGITS = 19;
+
+
+static inline Bool IsWhite( Char pChar )
+{
+    return pChar == ' ' || pChar == '\n' || pChar == '\t' || pChar == '\r';
+}
+
+static inline Bool IsDigitChar( Char pChar )
+{
+    return pChar >= '0' && pChar <= '9';
+}
+
+static inline Bool IsIdentifierChar( Char pChar )
+{
+    return (pChar >= 'a' && pChar <= 'z') ||
+           (pChar >= 'A' && pChar <= 'Z') ||
+           (pChar >= '0' && pChar <= '9') ||
+           pChar == '_';
+}
+
+
+Bool TextToken::EqualsLowerCase( const Char* pString ) const
+{
+    for( UInt32 i = 0; i < mLength; i++ )
+    {
+        Char c = mData[i];
+        if( c >= 'A' && c <= 'Z' )
+            c += 'a' - 'A';
+
+        if( c != pString[i] )
+            return false;
+    }
+
+    return pString[mLength] == '\0';
+}
+
+
+TextLexer::TextLexer()
+    : mBegin(NULL)
+    , mEnd(NULL)
+    , mCurrent(NULL)
+    , mCommentStyles(Comment_None)
+    , mUseSSE2(false)
+{
+}
+
+TextLexer::TextLexer( const Char* pText, UInt32 pLength, UInt32 pCommentStyles )
+{
+    Init( pText, pLength, pCommentStyles );
+}
+
+void TextLexer::Init( const Char* pText, UInt32 pLength, UInt32 pCommentStyles )
+{
+    mBegin          = pText;
+    mEnd            = pText + pLength;
+    mCurrent        = pText;
+    mCommentStyles  = pCommentStyles;
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    mUseSSE2        = SystemInfo::Instance()->CpuSupportSSE2();
+#else
+    mUseSSE2        = false;
+#endif
+}
+
+void TextLexer::SkipWhite()
+{
+    do
+    {
+        // Most runs are a single separator, only go wide for indentation and blank lines.
+        if( mCurrent >= mEnd || !IsWhite(*mCurrent) )
+            continue;
+
+        mCurrent++;
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+        if( mUseSSE2 )
+        {
+            const __m128i space     = _mm_set1_epi8( ' ' );
+            const __m128i tab       = _mm_set1_epi8( '\t' );
+            const __m128i newLine   = _mm_set1_epi8( '\n' );
+            const __m128i carriage  = _mm_set1_epi8( '\r' );
+
+            while( mCurrent + 16 <= mEnd )
+            {
+                __m128i chars = _mm_loadu_si128( (const __m128i*)mCurrent );
+                __m128i white = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( chars, space ), _mm_cmpeq_epi8( chars, tab ) ),
+                                              _mm_or_si128( _mm_cmpeq_epi8( chars, newLine ), _mm_cmpeq_epi8( chars, carriage ) ) );
+
+                UInt32 mask = (UInt32)_mm_movemask_epi8( white );
+                if( mask != 0xFFFF )
+                {
+                    // Advance to the first non white character.
+                    while( mask & 1 )
+                    {
+                        mask >>= 1;
+                        mCurrent++;
+                    }
+                    break;
+                }
+
+                mCurrent += 16;
+            }
+        }
+#endif
+
+        while( mCurrent < mEnd && IsWhite(*mCurrent) )
+            mCurrent++;
+    }
+    while( SkipComment() );
+}
+
+Bool TextLexer::IsCommentStart() const
+{
+    if( (mCommentStyles & Comment_Hash) && *mCurrent == '#' )
+        return true;
+
+    return (mCommentStyles & Comment_Cpp) && *mCurrent == '/' && mCurrent + 1 < mEnd && (mCurrent[1] == '/' || mCurrent[1] == '*');
+}
+
+Bool TextLexer::SkipComment()
+{
+    if( mCurrent >= mEnd )
+        return false;
+
+    if( (mCommentStyles & Comment_Hash) && *mCurrent == '#' )
+    {
+        SkipLine();
+        return true;
+    }
+
+    if( (mCommentStyles & Comment_Cpp) && *mCurrent == '/' && mCurrent + 1 < mEnd )
+    {
+        if( mCurrent[1] == '/' )
+        {
+            SkipLine();
+            return true;
+        }
+
+        if( mCurrent[1] == '*' )
+        {
+            mCurrent += 2;
+            while( mCurrent + 1 < mEnd && !(mCurrent[0] == '*' && mCurrent[1] == '/') )
+                mCurrent++;
+
+            mCurrent = mCurrent + 1 < mEnd ? mCurrent + 2 : mEnd;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TextLexer::SkipBlanks()
+{
+    while( mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\t' || *mCurrent == '\r') )
+        mCurrent++;
+}
+
+void TextLexer::SkipLine()
+{
+    const Char* newLine = (const Char*)memchr( mCurrent, '\n', mEnd - mCurrent );
+    mCurrent = newLine ? newLine + 1 : mEnd;
+}
+
+Bool TextLexer::SkipBlock()
+{
+    UInt32 depth = 1;
+
+    while( mCurrent < mEnd )
+    {
+        if( SkipComment() )
+            continue;
+
+        switch( *mCurrent++ )
+        {
+        case '{':
+            depth++;
+            break;
+
+        case '}':
+            if( --depth == 0 )
+                return true;
+            break;
+
+        case '"':
+            {
+                const Char* quote = (const Char*)memchr( mCurrent, '"', mEnd - mCurrent );
+                mCurrent = quote ? quote + 1 : mEnd;
+            }
+            break;
+        }
+    }
+
+    return false;
+}
+
+TextToken TextLexer::ReadToken()
+{
+    SkipWhite();
+
+    const Char* start = mCurrent;
+    while( mCurrent < mEnd && !IsWhite(*mCurrent) && !IsCommentStart() )
+        mCurrent++;
+
+    return TextToken( start, (UInt32)(mCurrent - start) );
+}
+
+TextToken TextLexer::ReadToken( const Char* pStopChars )
+{
+    SkipWhite();
+
+    const Char* start = mCurrent;
+    while( mCurrent < mEnd && !IsWhite(*mCurrent) && strchr( pStopChars, *mCurrent ) == NULL && !IsCommentStart() )
+        mCurrent++;
+
+    return TextToken( start, (UInt32)(mCurrent - start) );
+}
+
+TextToken TextLexer::ReadIdentifier( const Char* pExtraChars )
+{
+    SkipWhite();
+
+    const Char* start = mCurrent;
+    while( mCurrent < mEnd && (IsIdentifierChar(*mCurrent) || (pExtraChars && strchr( pExtraChars, *mCurrent ) != NULL)) )
+        mCurrent++;
+
+    return TextToken( start, (UInt32)(mCurrent - start) );
+}
+
+TextToken TextLexer::ReadQuoted()
+{
+    SkipWhite();
+
+    if( mCurrent >= mEnd || *mCurrent != '"' )
+        return TextToken( mCurrent, 0 );
+
+    const Char* start = ++mCurrent;
+    const Char* quote = (const Char*)memchr( start, '"', mEnd - start );
+    
+    mCurrent = quote ? quote + 1 : mEnd;
+    return TextToken( start, (UInt32)((quote ? quote : mEnd) - start) );
+}
+
+Bool TextLexer::Expect( const Char* pExpected )
+{
+    return ReadToken() == pExpected;
+}
+
+Float TextLexer::ReadFloat()
+{
+    TextToken token = ReadToken();
+    return (Float)ParseDouble( token.GetData(), token.GetData() + token.GetLength() );
+}
+
+Int32 TextLexer::ReadInt()
+{
+    TextToken token = ReadToken();
+    return ParseInt( token.GetData(), token.GetData() + token.GetLength() );
+}
+
+UInt32 TextLexer::ReadUInt()
+{
+    return (UInt32)ReadInt();
+}
+
+UInt32 TextLexer::GetLineNumber() const
+{
+    UInt32 line = 1;
+    for( const Char* c = mBegin; c < mCurrent; c++ )
+    {
+        if( *c == '\n' )
+            line++;
+    }
+
+    return line;
+}
+
+Double TextLexer::ParseDouble( const Char* pText, const Char* pEnd, const Char** pStop )
+{
+    const Char* c = pText;
+
+    Bool negative = false;
+    if( c < pEnd && (*c == '-' || *c == '+') )
+    {
+        negative = *c == '-';
+        c++;
+    }
+
+    UInt64 mantissa     = 0;
+    UInt32 numDigits    = 0;
+    Int32  exponent     = 0;
+    Bool   hasDigits    = false;
+
+    for( ; c < pEnd && IsDigitChar(*c); c++ )
+    {
+        hasDigits = true;
+        if( numDigits < MAX_MANTISSA_DIGITS )
+        {
+            mantissa = mantissa * 10 + (*c - '0');
+            if( mantissa != 0 )
+                numDigits++;
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+
+    if( c < pEnd && *c == '.' )
+    {
+        for( c++; c < pEnd && IsDigitChar(*c); c++ )
+        {
+            hasDigits = true;
+            if( numDigits < MAX_MANTISSA_DIGITS )
+            {
+                mantissa = mantissa * 10 + (*c - '0');
+                if( mantissa != 0 )
+                    numDigits++;
+                exponent--;
+            }
+        }
+    }
+
+    if( !hasDigits )
+    {
+        if( pStop )
+            *pStop = pText;
+        return 0.0;
+    }
+
+    if( c < pEnd && (*c == 'e' || *c == 'E') )
+    {
+        const Char* exponentStart = c++;
+
+        Bool negativeExponent = false;
+        if( c < pEnd && (*c == '-' || *c == '+') )
+        {
+            negativeExponent = *c == '-';
+            c++;
+        }
+
+        if( c < pEnd && IsDigitChar(*c) )
+        {
+            Int32 value = 0;
+            for( ; c < pEnd && IsDigitChar(*c); c++ )
+            {
+                if( value < 10000 )
+                    value = value * 10 + (*c - '0');
+            }
+
+            exponent += negativeExponent ? -value : value;
+        }
+        else
+        {
+            // Not an exponent, "e" belongs to whatever follows the number.
+            c = exponentStart;
+        }
+    }
+
+    if( pStop )
+        *pStop = c;
+
+    Double value = (Double)mantissa;
+    if( mantissa != 0 && exponent != 0 )
+    {
+        // Multiplying or dividing by an exact power of ten rounds only once.
+        if( exponent < 0 )
+            value = exponent >= -MAX_EXACT_POWER_OF_TEN ? value / POWERS_OF_TEN[-exponent] : value / pow( 10.0, -exponent );
+        else
+            value = exponent <= MAX_EXACT_POWER_OF_TEN ? value * POWERS_OF_TEN[exponent] : value * pow( 10.0, exponent );
+    }
+
+    return negative ? -value : value;
+}
+
+Int32 TextLexer::ParseInt( const Char* pText, const Char* pEnd, const Char** pStop )
+{
+    const Char* c = pText;
+
+    Bool negative = false;
+    if( c < pEnd && (*c == '-' || *c == '+') )
+    {
+        negative = *c == '-';
+        c++;
+    }
+
+    const Char* digits = c;
+
+    UInt32 value = 0;
+    for( ; c < pEnd && IsDigitChar(*c); c++ )
+        value = value * 10 + (*c - '0');
+
+    if( pStop )
+        *pStop = c != digits ? c : pText;
+
+    return (Int32)(negative ? 0 - value : value);
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,202 @@
+/**
+ *  @file       TextLexer.h
+ *  @brief      Tokenizer for text files, working in place over the file data.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _TEXT_LEXER_H_
+#define     _TEXT_LEXER_H_
+
+
+#include "Containers/StringUtils.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  A range of characters of the buffer given to a TextLexer. It is not null
+ *  terminated and is only valid as long as the buffer is.
+ */
+class CORE_API TextToken
+{
+public:
+    TextToken()
+        : mData(NULL)
+        , mLength(0)
+    {
+    }
+
+    TextToken( const Char* pData, UInt32 pLength )
+        : mData(pData)
+        , mLength(pLength)
+    {
+    }
+
+    const Char* GetData() const     { return mData;         }
+    UInt32      GetLength() const   { return mLength;       }
+    Bool        IsEmpty() const     { return mLength == 0;  }
+
+    //! Same value as Hash() on the equivalent string.
+    UInt32      GetHash() const     { return Hash( mData, mLength ); }
+
+    String      ToString() const                { return String( mData, mLength );  }
+    void        CopyTo( String& pString ) const { pString.assign( mData, mLength ); }
+
+    Bool operator == ( const Char* pString ) const
+    {
+        return strncmp( mData, pString, mLength ) == 0 && pString[mLength] == '\0';
+    }
+
+    Bool operator != ( const Char* pString ) const
+    {
+        return !(*this == pString);
+    }
+
+    //! Case insensitive comparison, pString must be lower case.
+    Bool EqualsLowerCase( const Char* pString ) const;
+
+private:
+    const Char* mData;
+    UInt32      mLength;
+};
+
+
+/**
+ *  Split a text buffer, usually a MemoryFile, in whitespace separated tokens.
+ *  Tokens are returned as TextToken pointing in the buffer, nothing is allocated
+ *  or copied. Numbers are parsed directly from the buffer, independently of the
+ *  current locale. Whitespace runs are skipped 16 characters at a time with SSE2.
+ *  Every Read method skips the whitespace and comments in front of its token.
+ */
+class CORE_API TextLexer
+{
+public:
+    enum CommentStyle
+    {
+        Comment_None    = 0,
+        Comment_Cpp     = 1 << 0,   //!< "//" up to the end of the line and "/* */".
+        Comment_Hash    = 1 << 1    //!< "#" up to the end of the line.
+    };
+
+public:
+    TextLexer();
+    TextLexer( const Char* pText, UInt32 pLength, UInt32 pCommentStyles = Comment_None );
+
+    void Init( const Char* pText, UInt32 pLength, UInt32 pCommentStyles = Comment_None );
+
+    Bool AtEnd() const
+    {
+        return mCurrent >= mEnd;
+    }
+
+    //! Next character, without skipping anything. '\0' at the end of the buffer.
+    Char PeekChar() const
+    {
+        return mCurrent < mEnd ? *mCurrent : '\0';
+    }
+
+    Char GetChar()
+    {
+        return mCurrent < mEnd ? *mCurrent++ : '\0';
+    }
+
+    void UngetChar()
+    {
+        if( mCurrent > mBegin )
+            mCurrent--;
+    }
+
+    //! Skip whitespaces, new lines and comments.
+    void SkipWhite();
+
+    //! Skip spaces and tabs, up to the end of the line.
+    void SkipBlanks();
+
+    //! Skip everything up to and including the next new line.
+    void SkipLine();
+
+    /**
+     *  Skip up to and including the '}' closing a block whose '{' was just read.
+     *  Braces inside quoted strings and comments are ignored.
+     *  @return false if the buffer ended before the block.
+     */
+    Bool SkipBlock();
+
+    //! Read up to the next whitespace or comment.
+    TextToken ReadToken();
+
+    //! Read up to the next whitespace, comment or one of pStopChars. The token is empty if it starts with a stop char.
+    TextToken ReadToken( const Char* pStopChars );
+
+    //! Read letters, digits, underscores and pExtraChars.
+    TextToken ReadIdentifier( const Char* pExtraChars = NULL );
+
+    //! Read a string between double quotes. The quotes are not part of the token.
+    TextToken ReadQuoted();
+
+    //! Read a token, return true if it's pExpected.
+    Bool      Expect( const Char* pExpected );
+
+    Float     ReadFloat();
+    Int32     ReadInt();
+    UInt32    ReadUInt();
+
+    //! Position in the buffer, the next character to read.
+    const Char* GetPosition() const
+    {
+        return mCurrent;
+    }
+
+    //! Line of the current position, starting at 1. Not cached, meant for error messages.
+    UInt32    GetLineNumber() const;
+
+    /**
+     *  Parse a decimal number ([+-]digits[.digits][(e|E)[+-]digits]) starting at pText.
+     *  @param  pEnd    Parsing stops there at the latest.
+     *  @param  pStop   If not NULL, receives the position of the first character not parsed.
+     */
+    static Double ParseDouble( const Char* pText, const Char* pEnd, const Char** pStop = NULL );
+
+    //! Parse a decimal integer ([+-]digits) starting at pText. Negative values wrap around when stored in an UInt32.
+    static Int32  ParseInt( const Char* pText, const Char* pEnd, const Char** pStop = NULL );
+
+private:
+    //! The current character is the start of a comment. Must not be at the end.
+    Bool      IsCommentStart() const;
+
+    //! Skip the comment at the current position, if any.
+    Bool      SkipComment();
+
+private:
+    const Char*     mBegin;
+    const Char*     mEnd;
+    const Char*     mCurrent;
+    UInt32          mCommentStyles;
+    Bool            mUseSSE2;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _TEXT_LEXER_H_
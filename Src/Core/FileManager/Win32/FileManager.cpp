@@ -112,6 +112,24 @@ Bool FileManager::FileExist( const String& pFilename )
     return _access( pFilename.c_str(), _A_NORMAL ) == 0;
 }
 
+UInt32 FileManager::GetFileSize( const String& pFilename )
+{
+    struct _stat fileInfo;
+    if( _stat( pFilename.c_str(), &fileInfo ) != 0 )
+        return 0;
+
+    return fileInfo.st_size;
+}
+
+UInt64 FileManager::GetLastWriteTime( const String& pFilename )
+{
+    WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+    if( !GetFileAttributesEx( pFilename.c_str(), GetFileExInfoStandard, &fileInfo ) )
+        return 0;
+
+    return (UInt64(fileInfo.ftLastWriteTime.dwHighDateTime) << 32) | fileInfo.ftLastWriteTime.dwLowDateTime;
+}
+
 
 
 class StdFileInputStream : public InputStream
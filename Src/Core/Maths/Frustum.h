@@ -124,6 +124,12 @@ public:
                PointInFrustum( Vector3f(pBox.Max().x, pBox.Max().y, pBox.Min().z) );      
     }
 
+    //! Get one of the frustum planes, the inside of the frustum is on its negative side.
+    const Plane3f& GetPlane( FrustumSide pSide ) const
+    {
+        return mPlanes[pSide];
+    }
+
     /**
      *  Serialize this frustum to/from a stream.
      *  @param  pStream Stream used for serialization.
@@ -0,0 +1,52 @@
+/**
+ *  @file       MathsSIMD.cpp
+ *  @brief      Selection of the SSE code paths of the maths classes.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "MathsSIMD.h"
+#include "SystemInfo/SystemInfo.h"
+
+
+namespace Gamedesk {
+
+
+Int32 MathsSIMD::mUseSSE = -1;
+
+
+void MathsSIMD::SetUseSSE( Bool pUseSSE )
+{
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    mUseSSE = pUseSSE && SystemInfo::Instance()->CpuSupportSSE() ? 1 : 0;
+#else
+    mUseSSE = 0;
+#endif
+}
+
+void MathsSIMD::Detect()
+{
+    SetUseSSE( true );
+}
+
+
+} // namespace Gamedesk
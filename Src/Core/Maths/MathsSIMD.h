@@ -0,0 +1,87 @@
+/**
+ *  @file       MathsSIMD.h
+ *  @brief      Selection of the SSE code paths of the maths classes.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _MATHS_SIMD_H_
+#define     _MATHS_SIMD_H_
+
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    #include <xmmintrin.h>
+#endif
+
+
+#if GD_COMPILER == GD_COMPILER_GCC
+    #define GD_ALIGN(Bytes)     __attribute__((aligned(Bytes)))
+#else
+    #define GD_ALIGN(Bytes)     __declspec(align(Bytes))
+#endif
+
+
+// Aligned matrices can be loaded with aligned SSE instructions, but they can't
+// be passed by value to functions such as std::vector<>::resize with Visual C++.
+#if GD_CFG_USE_ALIGNED_MATRIX == GD_ENABLED
+    #define GD_MATRIX_ALIGN             GD_ALIGN(16)
+    #define GD_MATRIX_LOAD(pAddress)    _mm_load_ps(pAddress)
+    #define GD_MATRIX_STORE(pAddress,v) _mm_store_ps(pAddress, v)
+#else
+    #define GD_MATRIX_ALIGN
+    #define GD_MATRIX_LOAD(pAddress)    _mm_loadu_ps(pAddress)
+    #define GD_MATRIX_STORE(pAddress,v) _mm_storeu_ps(pAddress, v)
+#endif
+
+
+namespace Gamedesk {
+
+
+/**
+ *  The Float specializations of Matrix4, Quaternion and the array transforms
+ *  take an SSE code path when the cpu supports it and GD_CFG_USE_SSE2 is enabled.
+ */
+class CORE_API MathsSIMD
+{
+public:
+    //! Return \c true if the SSE code paths are taken.
+    static Bool UseSSE()
+    {
+        if( mUseSSE < 0 )
+            Detect();
+
+        return mUseSSE > 0;
+    }
+
+    //! Force the scalar code paths (when \c false), used to compare both.
+    static void SetUseSSE( Bool pUseSSE );
+
+private:
+    static void Detect();
+
+    static Int32 mUseSSE;   //!< -1 until detected.
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _MATHS_SIMD_H_
@@ -33,6 +33,7 @@
 
 
 #include "Maths.h"
+#include "MathsSIMD.h"
 #include "Vector3.h"
 
 
@@ -192,9 +193,7 @@ public:
 
     friend Vector3<T> operator * ( const Vector3<T>& v, const Matrix4<T>& m  )
 	{
-		return( Vector3<T>( m._11*v.x + m._12*v.y + m._13*v.z + m._14,
-							m._21*v.x + m._22*v.y + m._23*v.z + m._24,
-							m._31*v.x + m._32*v.y + m._33*v.z + m._34 ) );
+		return m.TransformPoint( v );
 	}
 
     /**
@@ -250,22 +249,9 @@ public:
      */
     Matrix4 operator * ( const Matrix4& pMatrix ) const
     {
-        return Matrix4( M[0][0] * pMatrix(0,0) + M[0][1] * pMatrix(1,0) + M[0][2] * pMatrix(2,0) + M[0][3] * pMatrix(3,0),
-                        M[0][0] * pMatrix(0,1) + M[0][1] * pMatrix(1,1) + M[0][2] * pMatrix(2,1) + M[0][3] * pMatrix(3,1),
-                        M[0][0] * pMatrix(0,2) + M[0][1] * pMatrix(1,2) + M[0][2] * pMatrix(2,2) + M[0][3] * pMatrix(3,2),
-                        M[0][0] * pMatrix(0,3) + M[0][1] * pMatrix(1,3) + M[0][2] * pMatrix(2,3) + M[0][3] * pMatrix(3,3),
-                        M[1][0] * pMatrix(0,0) + M[1][1] * pMatrix(1,0) + M[1][2] * pMatrix(2,0) + M[1][3] * pMatrix(3,0),
-                        M[1][0] * pMatrix(0,1) + M[1][1] * pMatrix(1,1) + M[1][2] * pMatrix(2,1) + M[1][3] * pMatrix(3,1),
-                        M[1][0] * pMatrix(0,2) + M[1][1] * pMatrix(1,2) + M[1][2] * pMatrix(2,2) + M[1][3] * pMatrix(3,2),
-                        M[1][0] * pMatrix(0,3) + M[1][1] * pMatrix(1,3) + M[1][2] * pMatrix(2,3) + M[1][3] * pMatrix(3,3),
-                        M[2][0] * pMatrix(0,0) + M[2][1] * pMatrix(1,0) + M[2][2] * pMatrix(2,0) + M[2][3] * pMatrix(3,0),
-                        M[2][0] * pMatrix(0,1) + M[2][1] * pMatrix(1,1) + M[2][2] * pMatrix(2,1) + M[2][3] * pMatrix(3,1),
-                        M[2][0] * pMatrix(0,2) + M[2][1] * pMatrix(1,2) + M[2][2] * pMatrix(2,2) + M[2][3] * pMatrix(3,2),
-                        M[2][0] * pMatrix(0,3) + M[2][1] * pMatrix(1,3) + M[2][2] * pMatrix(2,3) + M[2][3] * pMatrix(3,3),
-                        M[3][0] * pMatrix(0,0) + M[3][1] * pMatrix(1,0) + M[3][2] * pMatrix(2,0) + M[3][3] * pMatrix(3,0),
-                        M[3][0] * pMatrix(0,1) + M[3][1] * pMatrix(1,1) + M[3][2] * pMatrix(2,1) + M[3][3] * pMatrix(3,1),
-                        M[3][0] * pMatrix(0,2) + M[3][1] * pMatrix(1,2) + M[3][2] * pMatrix(2,2) + M[3][3] * pMatrix(3,2),
-                        M[3][0] * pMatrix(0,3) + M[3][1] * pMatrix(1,3) + M[3][2] * pMatrix(2,3) + M[3][3] * pMatrix(3,3) );
+        Matrix4 result;
+        Multiply( *this, pMatrix, result );
+        return result;
     }
 
     /**
@@ -276,17 +262,71 @@ public:
      */
     const Matrix4& operator *= ( const Matrix4& pMatrix )
     {
-        Matrix4 matTemp( *this );
+        Multiply( *this, pMatrix, *this );
+        return *this;
+    }
+
+    /**
+     *  Multiply two matrices, pResult can be one of them.
+     *  Specialized for Float to use SSE.
+     */
+    static void Multiply( const Matrix4& pFirst, const Matrix4& pSecond, Matrix4& pResult )
+    {
+        MultiplyScalar( pFirst, pSecond, pResult );
+    }
+
+    //! Multiply two matrices without SSE, pResult can be one of them.
+    static void MultiplyScalar( const Matrix4& pFirst, const Matrix4& pSecond, Matrix4& pResult )
+    {
+        Matrix4 matTemp( pFirst );
         Int32   row, col;
 
         for( row = 0; row < 4; row++ )
             for( col = 0; col < 4; col++ )
-                M[row][col] = matTemp(row,0) * pMatrix(0,col) +
-                              matTemp(row,1) * pMatrix(1,col) +
-                              matTemp(row,2) * pMatrix(2,col) +
-                              matTemp(row,3) * pMatrix(3,col);
+                pResult.M[row][col] = matTemp(row,0) * pSecond(0,col) +
+                                      matTemp(row,1) * pSecond(1,col) +
+                                      matTemp(row,2) * pSecond(2,col) +
+                                      matTemp(row,3) * pSecond(3,col);
+    }
 
-        return *this;
+    /**
+     *  Transform a point (w = 1), same as pPoint * matrix.
+     *  Specialized for Float to use SSE.
+     */
+    Vector3<T> TransformPoint( const Vector3<T>& pPoint ) const
+    {
+        return Vector3<T>( _11*pPoint.x + _12*pPoint.y + _13*pPoint.z + _14,
+                           _21*pPoint.x + _22*pPoint.y + _23*pPoint.z + _24,
+                           _31*pPoint.x + _32*pPoint.y + _33*pPoint.z + _34 );
+    }
+
+    /**
+     *  Transform an array of points (w = 1).
+     *  @param  pPoints     Points to transform.
+     *  @param  pResult     Receives the transformed points, can be pPoints.
+     *  @param  pCount      Number of points.
+     */
+    void TransformPoints( const Vector3<T>* pPoints, Vector3<T>* pResult, UInt32 pCount ) const
+    {
+        for( UInt32 i = 0; i < pCount; i++ )
+            pResult[i] = TransformPoint( pPoints[i] );
+    }
+
+    /**
+     *  Transform an array of directions (w = 0), the translation is ignored.
+     *  @param  pVectors    Vectors to transform.
+     *  @param  pResult     Receives the transformed vectors, can be pVectors.
+     *  @param  pCount      Number of vectors.
+     */
+    void TransformVectors( const Vector3<T>* pVectors, Vector3<T>* pResult, UInt32 pCount ) const
+    {
+        for( UInt32 i = 0; i < pCount; i++ )
+        {
+            const Vector3<T> v = pVectors[i];
+            pResult[i] = Vector3<T>( _11*v.x + _12*v.y + _13*v.z,
+                                     _21*v.x + _22*v.y + _23*v.z,
+                                     _31*v.x + _32*v.y + _33*v.z );
+        }
     }
 
     /**
@@ -915,7 +955,7 @@ public:
 private:
     union
     {
-        T M[4][4];
+        GD_MATRIX_ALIGN T M[4][4];
         T elem16[16];
         struct
         {
@@ -933,6 +973,129 @@ typedef Matrix4<Float>   Matrix4f;
 typedef Matrix4<Double>  Matrix4d;
 
 
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+
+// The rows of M are the transformed axes: a point is x*M[0] + y*M[1] + z*M[2] + M[3].
+
+template <>
+INLINE void Matrix4<Float>::Multiply( const Matrix4<Float>& pFirst, const Matrix4<Float>& pSecond, Matrix4<Float>& pResult )
+{
+    if( !MathsSIMD::UseSSE() )
+    {
+        MultiplyScalar( pFirst, pSecond, pResult );
+        return;
+    }
+
+    // Load pSecond first, pResult can be pSecond.
+    const __m128 row0 = GD_MATRIX_LOAD( pSecond.M[0] );
+    const __m128 row1 = GD_MATRIX_LOAD( pSecond.M[1] );
+    const __m128 row2 = GD_MATRIX_LOAD( pSecond.M[2] );
+    const __m128 row3 = GD_MATRIX_LOAD( pSecond.M[3] );
+
+    for( Int32 i = 0; i < 4; i++ )
+    {
+        const Float* first = pFirst.M[i];
+        __m128 row = _mm_mul_ps( _mm_set1_ps( first[0] ), row0 );
+        row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( first[1] ), row1 ) );
+        row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( first[2] ), row2 ) );
+        row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( first[3] ), row3 ) );
+        GD_MATRIX_STORE( pResult.M[i], row );
+    }
+}
+
+template <>
+INLINE Vector3<Float> Matrix4<Float>::TransformPoint( const Vector3<Float>& pPoint ) const
+{
+    if( !MathsSIMD::UseSSE() )
+    {
+        return Vector3<Float>( _11*pPoint.x + _12*pPoint.y + _13*pPoint.z + _14,
+                               _21*pPoint.x + _22*pPoint.y + _23*pPoint.z + _24,
+                               _31*pPoint.x + _32*pPoint.y + _33*pPoint.z + _34 );
+    }
+
+    __m128 result = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( pPoint.x ), GD_MATRIX_LOAD( M[0] ) ), GD_MATRIX_LOAD( M[3] ) );
+    result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( pPoint.y ), GD_MATRIX_LOAD( M[1] ) ) );
+    result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( pPoint.z ), GD_MATRIX_LOAD( M[2] ) ) );
+
+    Vector3<Float> point;
+    _mm_storel_pi( (__m64*)&point.x, result );
+    _mm_store_ss( &point.z, _mm_movehl_ps( result, result ) );
+    return point;
+}
+
+template <>
+INLINE void Matrix4<Float>::TransformPoints( const Vector3<Float>* pPoints, Vector3<Float>* pResult, UInt32 pCount ) const
+{
+    if( !MathsSIMD::UseSSE() )
+    {
+        for( UInt32 i = 0; i < pCount; i++ )
+        {
+            const Vector3<Float> v = pPoints[i];
+            pResult[i] = Vector3<Float>( _11*v.x + _12*v.y + _13*v.z + _14,
+                                         _21*v.x + _22*v.y + _23*v.z + _24,
+                                         _31*v.x + _32*v.y + _33*v.z + _34 );
+        }
+        return;
+    }
+
+    const __m128 row0 = GD_MATRIX_LOAD( M[0] );
+    const __m128 row1 = GD_MATRIX_LOAD( M[1] );
+    const __m128 row2 = GD_MATRIX_LOAD( M[2] );
+    const __m128 row3 = GD_MATRIX_LOAD( M[3] );
+
+    for( UInt32 i = 0; i < pCount; i++ )
+    {
+        // Read the whole point before writing, pResult can be pPoints.
+        const __m128 x = _mm_set1_ps( pPoints[i].x );
+        const __m128 y = _mm_set1_ps( pPoints[i].y );
+        const __m128 z = _mm_set1_ps( pPoints[i].z );
+
+        __m128 result = _mm_add_ps( _mm_mul_ps( x, row0 ), row3 );
+        result = _mm_add_ps( result, _mm_mul_ps( y, row1 ) );
+        result = _mm_add_ps( result, _mm_mul_ps( z, row2 ) );
+
+        _mm_storel_pi( (__m64*)&pResult[i].x, result );
+        _mm_store_ss( &pResult[i].z, _mm_movehl_ps( result, result ) );
+    }
+}
+
+template <>
+INLINE void Matrix4<Float>::TransformVectors( const Vector3<Float>* pVectors, Vector3<Float>* pResult, UInt32 pCount ) const
+{
+    if( !MathsSIMD::UseSSE() )
+    {
+        for( UInt32 i = 0; i < pCount; i++ )
+        {
+            const Vector3<Float> v = pVectors[i];
+            pResult[i] = Vector3<Float>( _11*v.x + _12*v.y + _13*v.z,
+                                         _21*v.x + _22*v.y + _23*v.z,
+                                         _31*v.x + _32*v.y + _33*v.z );
+        }
+        return;
+    }
+
+    const __m128 row0 = GD_MATRIX_LOAD( M[0] );
+    const __m128 row1 = GD_MATRIX_LOAD( M[1] );
+    const __m128 row2 = GD_MATRIX_LOAD( M[2] );
+
+    for( UInt32 i = 0; i < pCount; i++ )
+    {
+        const __m128 x = _mm_set1_ps( pVectors[i].x );
+        const __m128 y = _mm_set1_ps( pVectors[i].y );
+        const __m128 z = _mm_set1_ps( pVectors[i].z );
+
+        __m128 result = _mm_mul_ps( x, row0 );
+        result = _mm_add_ps( result, _mm_mul_ps( y, row1 ) );
+        result = _mm_add_ps( result, _mm_mul_ps( z, row2 ) );
+
+        _mm_storel_pi( (__m64*)&pResult[i].x, result );
+        _mm_store_ss( &pResult[i].z, _mm_movehl_ps( result, result ) );
+    }
+}
+
+#endif  //  #if GD_CFG_USE_SSE2
+
+
 // Constants
 template<class T> const Matrix4<T> Matrix4<T>::ZERO( T(0), T(0), T(0), T(0),
 													 T(0), T(0), T(0), T(0),
@@ -264,8 +264,15 @@ public:
      *  Convert the quaternion to a 4x4 rotation matrix.
      *  Note : Code snippet from game programming gems.
      *  @brief  Convert the quaternion to a 4x4 rotation matrix
+     *  Specialized for Float to use SSE.
      */
     const Matrix4<T>& ToMatrix( Matrix4<T>& pResultMatrix ) const
+    {
+        return ToMatrixScalar( pResultMatrix );
+    }
+
+    //! Convert the quaternion to a 4x4 rotation matrix without SSE.
+    const Matrix4<T>& ToMatrixScalar( Matrix4<T>& pResultMatrix ) const
     {
         // if q is guaranteed to be a unit quaternion, s will always
         // be 1.  In that case, this calculation can be optimized out.
@@ -908,6 +915,50 @@ typedef Quaternion<Float>   Quaternionf;
 typedef Quaternion<Double>  Quaterniond;
 
 
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+
+template <>
+INLINE const Matrix4<Float>& Quaternion<Float>::ToMatrix( Matrix4<Float>& pResultMatrix ) const
+{
+    if( !MathsSIMD::UseSSE() )
+        return ToMatrixScalar( pResultMatrix );
+
+    Float norm = GetNormSquare();
+    Float scalar = norm > 0 ? 2.0f / norm : 0;
+
+    // (w,x,y,z) -> (x,y,z,w)
+    __m128 q = _mm_loadu_ps( &w );
+    q = _mm_shuffle_ps( q, q, _MM_SHUFFLE(0,3,2,1) );
+
+    const __m128 qs = _mm_mul_ps( q, _mm_set1_ps( scalar ) );   // (x,y,z,w) * scalar
+    const __m128 sq = _mm_mul_ps( q, qs );                      // (xx,yy,zz,ww)
+
+    // (1-(yy+zz), 1-(xx+zz), 1-(xx+yy))
+    __m128 diag = _mm_sub_ps( _mm_set_ps( 0, 1, 1, 1 ), _mm_shuffle_ps( sq, sq, _MM_SHUFFLE(3,0,0,1) ) );
+    diag = _mm_sub_ps( diag, _mm_shuffle_ps( sq, sq, _MM_SHUFFLE(3,1,2,2) ) );
+
+    // (xz,xy,yz) and (wy,wz,wx)
+    const __m128 v0 = _mm_mul_ps( _mm_shuffle_ps( q, q, _MM_SHUFFLE(3,1,0,0) ), _mm_shuffle_ps( qs, qs, _MM_SHUFFLE(3,2,1,2) ) );
+    const __m128 v1 = _mm_mul_ps( _mm_shuffle_ps( qs, qs, _MM_SHUFFLE(3,3,3,3) ), _mm_shuffle_ps( q, q, _MM_SHUFFLE(3,0,2,1) ) );
+
+    GD_ALIGN(16) Float d[4];
+    GD_ALIGN(16) Float a[4];
+    GD_ALIGN(16) Float b[4];
+    _mm_store_ps( d, diag );
+    _mm_store_ps( a, _mm_add_ps( v0, v1 ) );    // (xz+wy, xy+wz, yz+wx)
+    _mm_store_ps( b, _mm_sub_ps( v0, v1 ) );    // (xz-wy, xy-wz, yz-wx)
+
+    GD_MATRIX_STORE( &pResultMatrix(0,0), _mm_set_ps( 0, a[0], b[1], d[0] ) );
+    GD_MATRIX_STORE( &pResultMatrix(1,0), _mm_set_ps( 0, b[2], d[1], a[1] ) );
+    GD_MATRIX_STORE( &pResultMatrix(2,0), _mm_set_ps( 0, d[2], a[2], b[0] ) );
+    GD_MATRIX_STORE( &pResultMatrix(3,0), _mm_set_ps( 1, 0, 0, 0 ) );
+
+    return pResultMatrix;
+}
+
+#endif  //  #if GD_CFG_USE_SSE2
+
+
 } // namespace Gamedesk
 
 
@@ -0,0 +1,121 @@
+/**
+ *  @file       LinearAllocator.cpp
+ *  @brief      Arena that allocates by moving a pointer forward.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "LinearAllocator.h"
+
+
+namespace Gamedesk {
+
+
+static UInt32 AlignUp( UInt32 pSize )
+{
+    return (pSize + LinearAllocator::ALIGNMENT - 1) & ~(LinearAllocator::ALIGNMENT - 1);
+}
+
+
+LinearAllocator::LinearAllocator( UInt32 pCapacity, const Char* pTag )
+    : mTag(pTag)
+    , mOffset(0)
+    , mUsedBytes(0)
+    , mPeakBytes(0)
+    , mCapacity(0)
+{
+    AddBlock( AlignUp(pCapacity) );
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    FreeBlocks();
+}
+
+void* LinearAllocator::Allocate( UInt32 pSize )
+{
+    pSize = AlignUp( pSize );
+
+    if( mOffset + pSize > mBlocks.back().mSize )
+        AddBlock( Maths::Max(pSize, mBlocks.back().mSize) );
+
+    void* memory = mBlocks.back().mData + mOffset;
+    mOffset += pSize;
+
+    mUsedBytes += pSize;
+    if( mUsedBytes > mPeakBytes )
+        mPeakBytes = mUsedBytes;
+
+    return memory;
+}
+
+void LinearAllocator::Reset()
+{
+    // Chained blocks are merged so the next cycle fits in one block.
+    if( mBlocks.size() > 1 )
+    {
+        FreeBlocks();
+        AddBlock( mPeakBytes );
+    }
+
+    mOffset = 0;
+    mUsedBytes = 0;
+}
+
+UInt32 LinearAllocator::GetUsedBytes() const
+{
+    return mUsedBytes;
+}
+
+UInt32 LinearAllocator::GetPeakBytes() const
+{
+    return mPeakBytes;
+}
+
+UInt32 LinearAllocator::GetCapacity() const
+{
+    return mCapacity;
+}
+
+void LinearAllocator::AddBlock( UInt32 pSize )
+{
+    Block block;
+    block.mSize   = pSize;
+    block.mMemory = GD_ALLOC(Byte, pSize + ALIGNMENT - 1, this, mTag);
+    block.mData   = (Byte*)(((size_t)block.mMemory + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1));
+
+    mBlocks.push_back( block );
+    mOffset = 0;
+    mCapacity += pSize;
+}
+
+void LinearAllocator::FreeBlocks()
+{
+    for( UInt32 i = 0; i < mBlocks.size(); i++ )
+        GD_FREE( mBlocks[i].mMemory );
+
+    mBlocks.clear();
+    mCapacity = 0;
+}
+
+
+} // namespace Gamedesk
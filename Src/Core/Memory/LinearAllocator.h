@@ -0,0 +1,102 @@
+/**
+ *  @file       LinearAllocator.h
+ *  @brief      Arena that allocates by moving a pointer forward.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _LINEAR_ALLOCATOR_H_
+#define     _LINEAR_ALLOCATOR_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Arena for short lived allocations (per frame data, loading scratch).
+ *  Allocating moves an offset forward; nothing is released until Reset().
+ *  When the arena is full a new block is chained, and Reset() replaces the
+ *  blocks by a single one large enough for the peak usage.
+ *  Objects are constructed in it with GD_NEW_IN and destroyed with GD_DELETE_IN.
+ *  Not thread safe.
+ */
+class CORE_API LinearAllocator
+{
+public:
+    static const UInt32 ALIGNMENT = 16;     //!< Alignment of every allocation.
+
+public:
+    /**
+     *  Constructor.
+     *  @param  pCapacity   Initial size in bytes.
+     *  @param  pTag        Tag of the arena blocks for the memory tracker.
+     */
+    LinearAllocator( UInt32 pCapacity, const Char* pTag );
+    ~LinearAllocator();
+
+    //! Allocate pSize bytes aligned on ALIGNMENT.
+    void* Allocate( UInt32 pSize );
+
+    //! Allocations are released all at once by Reset().
+    void Free( void* /*pMemory*/ )
+    {
+    }
+
+    //! Release every allocation. Destructors of objects in the arena are not called.
+    void Reset();
+
+    //! Bytes allocated since the last Reset().
+    UInt32 GetUsedBytes() const;
+
+    //! Highest number of bytes allocated between two Reset().
+    UInt32 GetPeakBytes() const;
+
+    //! Total size of the blocks.
+    UInt32 GetCapacity() const;
+
+private:
+    CLASS_DISABLE_COPY(LinearAllocator);
+
+    void AddBlock( UInt32 pSize );
+    void FreeBlocks();
+
+    class Block
+    {
+    public:
+        Byte*   mMemory;        //!< As returned by GD_ALLOC.
+        Byte*   mData;          //!< mMemory aligned on ALIGNMENT.
+        UInt32  mSize;
+    };
+
+private:
+    const Char*     mTag;
+    Vector<Block>   mBlocks;
+    UInt32          mOffset;        //!< In the last block.
+    UInt32          mUsedBytes;
+    UInt32          mPeakBytes;
+    UInt32          mCapacity;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _LINEAR_ALLOCATOR_H_
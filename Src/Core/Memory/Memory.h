@@ -26,7 +26,32 @@
 #ifndef     _MEMORY_H_
 #define     _MEMORY_H_
 
- 
+
+#include "MemoryTracker.h"
+
+
+#if GD_CFG_USE_MEMORY_TRACKING == GD_ENABLED
+
+#define GD_ALLOC(ObjType, Count, pParent, pId) \
+            (ObjType*)Gamedesk::MemoryTracker::Track( malloc(sizeof(ObjType) * (Count)), sizeof(ObjType) * (Count), pId )
+
+#define GD_FREE(pMemory) \
+            free( Gamedesk::MemoryTracker::Release(pMemory) )
+
+#define GD_NEW(ObjType, pParent, pId) \
+            new (Gamedesk::MemoryTag(pId)) ObjType
+
+#define GD_NEW_ARRAY(ObjType, Count, pParent, pId) \
+            Gamedesk::MemoryTracker::TrackArray( new ObjType[Count], sizeof(ObjType) * (Count), pId )
+
+#define GD_DELETE(pObj) \
+            delete Gamedesk::MemoryTracker::Release(pObj)
+
+#define GD_DELETE_ARRAY(pArrayObj) \
+            delete[] Gamedesk::MemoryTracker::Release(pArrayObj)
+
+#else
+
 #define GD_ALLOC(ObjType, Count, pParent, pId) \
             (ObjType*)malloc(sizeof(ObjType) * Count)
 
@@ -45,5 +70,35 @@
 #define GD_DELETE_ARRAY(pArrayObj) \
             delete[] pArrayObj
 
+#endif
+
+
+/**
+ *  Construct an object in a LinearAllocator or a PoolAllocator, the allocator
+ *  accounts for the memory. Release it with GD_DELETE_IN.
+ */
+#define GD_NEW_IN(Allocator, ObjType) \
+            new ((Allocator).Allocate(sizeof(ObjType))) ObjType
+
+#define GD_DELETE_IN(Allocator, pObj) \
+            Gamedesk::DeleteIn( Allocator, pObj )
+
+
+namespace Gamedesk {
+
+
+template <class A, class T>
+void DeleteIn( A& pAllocator, T* pObj )
+{
+    if( pObj )
+    {
+        pObj->~T();
+        pAllocator.Free( pObj );
+    }
+}
+
+
+} // namespace Gamedesk
+
 
 #endif  //  _MEMORY_H_
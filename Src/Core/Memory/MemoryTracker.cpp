@@ -0,0 +1,290 @@
+/**
+ *  @file       MemoryTracker.cpp
+ *  @brief      Tracking of the allocations made through the GD_ALLOC/GD_NEW macros.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "MemoryTracker.h"
+
+
+#if GD_CFG_USE_MEMORY_TRACKING == GD_ENABLED
+
+
+#include "Thread/Mutex.h"
+
+
+namespace Gamedesk {
+
+
+static const Char*  UNTAGGED = "Untagged";
+static const UInt32 MAX_REPORTED_LEAKS = 64;
+
+
+class TrackedAllocation
+{
+public:
+    size_t      mSize;
+    UInt32      mTag;       //!< Index in TrackerState::mTags.
+};
+
+
+class TrackerState
+{
+public:
+    UInt32 GetTagIndex( const Char* pTag );
+
+public:
+    Mutex                               mMutex;
+    Map<const void*, TrackedAllocation> mAllocations;
+    Vector<MemoryTracker::TagStats>     mTags;
+    Map<const Char*, UInt32>            mTagsByAddress;     //!< Avoid comparing the tag strings on every allocation.
+    Map<String, UInt32>                 mTagsByName;        //!< Owns the tag strings.
+    UInt64                              mTotalLiveBytes;
+};
+
+
+UInt32 TrackerState::GetTagIndex( const Char* pTag )
+{
+    if( pTag == NULL )
+        pTag = UNTAGGED;
+
+    Map<const Char*, UInt32>::const_iterator itAddress = mTagsByAddress.find( pTag );
+    if( itAddress != mTagsByAddress.end() )
+        return itAddress->second;
+
+    // The same tag can be used from different modules, each with its own copy of the string.
+    UInt32 index;
+    Map<String, UInt32>::const_iterator itName = mTagsByName.find( pTag );
+    if( itName != mTagsByName.end() )
+    {
+        index = itName->second;
+    }
+    else
+    {
+        index = mTags.size();
+        itName = mTagsByName.insert( std::make_pair( String(pTag), index ) ).first;
+
+        // Map nodes don't move, the key outlives the module that gave the tag.
+        MemoryTracker::TagStats stats;
+        stats.mTag              = itName->first.c_str();
+        stats.mLiveBytes        = 0;
+        stats.mPeakBytes        = 0;
+        stats.mLiveAllocations  = 0;
+        stats.mTotalAllocations = 0;
+        mTags.push_back( stats );
+    }
+
+    mTagsByAddress[pTag] = index;
+    return index;
+}
+
+
+//! Created on first use, allocations can be made by static constructors of any module.
+static TrackerState* gState = NULL;
+
+static TrackerState* GetState()
+{
+    if( gState == NULL )
+    {
+        gState = new TrackerState;
+        gState->mTotalLiveBytes = 0;
+    }
+
+    return gState;
+}
+
+
+void* MemoryTracker::Track( void* pMemory, size_t pSize, const Char* pTag )
+{
+    if( pMemory == NULL )
+        return NULL;
+
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    TrackedAllocation allocation;
+    allocation.mSize = pSize;
+    allocation.mTag  = state->GetTagIndex( pTag );
+    state->mAllocations[pMemory] = allocation;
+
+    TagStats& stats = state->mTags[allocation.mTag];
+    stats.mLiveBytes += pSize;
+    stats.mLiveAllocations++;
+    stats.mTotalAllocations++;
+    if( stats.mLiveBytes > stats.mPeakBytes )
+        stats.mPeakBytes = stats.mLiveBytes;
+
+    state->mTotalLiveBytes += pSize;
+
+    state->mMutex.Unlock();
+    return pMemory;
+}
+
+void MemoryTracker::Untrack( const void* pMemory )
+{
+    if( pMemory == NULL )
+        return;
+
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    Map<const void*, TrackedAllocation>::iterator itAlloc = state->mAllocations.find( pMemory );
+    if( itAlloc != state->mAllocations.end() )
+    {
+        TagStats& stats = state->mTags[itAlloc->second.mTag];
+        stats.mLiveBytes -= itAlloc->second.mSize;
+        stats.mLiveAllocations--;
+
+        state->mTotalLiveBytes -= itAlloc->second.mSize;
+        state->mAllocations.erase( itAlloc );
+    }
+
+    state->mMutex.Unlock();
+}
+
+UInt64 MemoryTracker::GetLiveBytes( const Char* pTag )
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    UInt64 bytes = state->mTags[state->GetTagIndex(pTag)].mLiveBytes;
+
+    state->mMutex.Unlock();
+    return bytes;
+}
+
+UInt64 MemoryTracker::GetPeakBytes( const Char* pTag )
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    UInt64 bytes = state->mTags[state->GetTagIndex(pTag)].mPeakBytes;
+
+    state->mMutex.Unlock();
+    return bytes;
+}
+
+UInt64 MemoryTracker::GetTotalLiveBytes()
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    UInt64 bytes = state->mTotalLiveBytes;
+
+    state->mMutex.Unlock();
+    return bytes;
+}
+
+UInt32 MemoryTracker::GetNbTags()
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    UInt32 count = state->mTags.size();
+
+    state->mMutex.Unlock();
+    return count;
+}
+
+void MemoryTracker::GetTagStats( UInt32 pIndex, TagStats& pStats )
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    GD_ASSERT( pIndex < state->mTags.size() );
+    pStats = state->mTags[pIndex];
+
+    state->mMutex.Unlock();
+}
+
+void MemoryTracker::DumpStats()
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    Core::DebugOut( "Memory usage (live KB / peak KB / live allocations / total allocations):\n" );
+    for( UInt32 i = 0; i < state->mTags.size(); i++ )
+    {
+        const TagStats& stats = state->mTags[i];
+        Core::DebugOut( "    %-48s %10.1f %10.1f %8u %10u\n", stats.mTag,
+                        stats.mLiveBytes / 1024.0, stats.mPeakBytes / 1024.0,
+                        stats.mLiveAllocations, stats.mTotalAllocations );
+    }
+    Core::DebugOut( "    Total: %.1f KB\n", state->mTotalLiveBytes / 1024.0 );
+
+    state->mMutex.Unlock();
+}
+
+void MemoryTracker::ForgetTagAddresses()
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    state->mTagsByAddress.clear();
+
+    state->mMutex.Unlock();
+}
+
+UInt32 MemoryTracker::ReportLeaks()
+{
+    TrackerState* state = GetState();
+    state->mMutex.Lock();
+
+    UInt32 leakCount = state->mAllocations.size();
+    if( leakCount > 0 )
+    {
+        Core::DebugOut( "Memory leaks: %u allocations, %.1f KB\n", leakCount, state->mTotalLiveBytes / 1024.0 );
+
+        UInt32 reported = 0;
+        Map<const void*, TrackedAllocation>::const_iterator itAlloc;
+        for( itAlloc = state->mAllocations.begin(); itAlloc != state->mAllocations.end() && reported < MAX_REPORTED_LEAKS; ++itAlloc, ++reported )
+        {
+            Core::DebugOut( "    0x%p: %u bytes (%s)\n", itAlloc->first, (UInt32)itAlloc->second.mSize, state->mTags[itAlloc->second.mTag].mTag );
+        }
+
+        if( leakCount > reported )
+            Core::DebugOut( "    ... %u more\n", leakCount - reported );
+    }
+
+    state->mMutex.Unlock();
+    return leakCount;
+}
+
+
+//! Report the leaks when the Core module is unloaded, after every module that depends on it.
+class MemoryLeakReporter
+{
+public:
+    ~MemoryLeakReporter()
+    {
+        MemoryTracker::ReportLeaks();
+    }
+};
+
+static MemoryLeakReporter gLeakReporter;
+
+
+} // namespace Gamedesk
+
+
+#endif  //  #if GD_CFG_USE_MEMORY_TRACKING
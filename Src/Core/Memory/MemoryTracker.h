@@ -0,0 +1,146 @@
+/**
+ *  @file       MemoryTracker.h
+ *  @brief      Tracking of the allocations made through the GD_ALLOC/GD_NEW macros.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _MEMORY_TRACKER_H_
+#define     _MEMORY_TRACKER_H_
+
+
+#if GD_CFG_USE_MEMORY_TRACKING == GD_ENABLED
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Keeps the live allocations made through the GD_ALLOC/GD_NEW macros, and
+ *  their byte counts per tag (the pId parameter of the macros).
+ *  Tags are compared by content and copied on first use, a tag only has to
+ *  stay valid until the module holding it is unloaded.
+ *  Releasing memory that is not tracked is ignored, so a pointer obtained
+ *  with a plain new can still be released with GD_DELETE. An object released
+ *  through a base class pointer that has a different address (multiple
+ *  inheritance) stays tracked and is reported as a leak.
+ */
+class CORE_API MemoryTracker
+{
+public:
+    class TagStats
+    {
+    public:
+        const Char* mTag;                   //!< Copy owned by the tracker.
+        UInt64      mLiveBytes;
+        UInt64      mPeakBytes;             //!< High-water mark of mLiveBytes.
+        UInt32      mLiveAllocations;
+        UInt32      mTotalAllocations;
+    };
+
+public:
+    //! Record pMemory as pSize bytes allocated for pTag. Return pMemory.
+    static void* Track( void* pMemory, size_t pSize, const Char* pTag );
+
+    //! Forget an allocation, if it is tracked.
+    static void Untrack( const void* pMemory );
+
+    template <class T>
+    static T* TrackArray( T* pArray, size_t pSize, const Char* pTag )
+    {
+        Track( pArray, pSize, pTag );
+        return pArray;
+    }
+
+    template <class T>
+    static T* Release( T* pMemory )
+    {
+        Untrack( pMemory );
+        return pMemory;
+    }
+
+    //! Bytes currently allocated for pTag.
+    static UInt64 GetLiveBytes( const Char* pTag );
+
+    //! Highest number of bytes allocated at once for pTag.
+    static UInt64 GetPeakBytes( const Char* pTag );
+
+    //! Bytes currently allocated for all tags.
+    static UInt64 GetTotalLiveBytes();
+
+    //! Number of tags that have been used.
+    static UInt32 GetNbTags();
+
+    //! Copy the stats of the pIndex'th tag.
+    static void GetTagStats( UInt32 pIndex, TagStats& pStats );
+
+    //! Output the stats of every tag to the debug output.
+    static void DumpStats();
+
+    /**
+     *  Forget the tag addresses seen so far, called when a module is unloaded.
+     *  Its string literals are gone and their addresses can be reused by another module.
+     */
+    static void ForgetTagAddresses();
+
+    /**
+     *  Output every live allocation to the debug output.
+     *  Called when the Core module is unloaded.
+     *  @return The number of live allocations.
+     */
+    static UInt32 ReportLeaks();
+};
+
+
+/**
+ *  Tag given to the placement new used by GD_NEW.
+ */
+class MemoryTag
+{
+public:
+    explicit MemoryTag( const Char* pTag ) : mTag(pTag)
+    {
+    }
+
+    const Char* mTag;
+};
+
+
+} // namespace Gamedesk
+
+
+inline void* operator new( size_t pSize, const Gamedesk::MemoryTag& pTag )
+{
+    return Gamedesk::MemoryTracker::Track( ::operator new(pSize), pSize, pTag.mTag );
+}
+
+//! Only called if the constructor throws.
+inline void operator delete( void* pMemory, const Gamedesk::MemoryTag& )
+{
+    Gamedesk::MemoryTracker::Untrack( pMemory );
+    ::operator delete( pMemory );
+}
+
+
+#endif  //  #if GD_CFG_USE_MEMORY_TRACKING
+
+
+#endif  //  _MEMORY_TRACKER_H_
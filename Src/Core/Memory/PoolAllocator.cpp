@@ -0,0 +1,110 @@
+/**
+ *  @file       PoolAllocator.cpp
+ *  @brief      Allocator of fixed size blocks.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "PoolAllocator.h"
+
+
+namespace Gamedesk {
+
+
+PoolAllocator::PoolAllocator( UInt32 pBlockSize, UInt32 pBlocksPerChunk, const Char* pTag )
+    : mTag(pTag)
+    , mBlockSize((Maths::Max<UInt32>(pBlockSize, sizeof(FreeBlock)) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+    , mBlocksPerChunk(pBlocksPerChunk)
+    , mFreeBlocks(NULL)
+    , mNbUsedBlocks(0)
+{
+    GD_ASSERT( pBlocksPerChunk > 0 );
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    GD_ASSERT_M( mNbUsedBlocks == 0, "[PoolAllocator::~PoolAllocator] Blocks are still in use!" );
+
+    for( UInt32 i = 0; i < mChunks.size(); i++ )
+        GD_FREE( mChunks[i] );
+}
+
+void* PoolAllocator::Allocate( UInt32 pSize )
+{
+    GD_ASSERT_M( pSize <= mBlockSize, "[PoolAllocator::Allocate] Size is larger than the block size!" );
+
+    if( mFreeBlocks == NULL )
+        AddChunk();
+
+    FreeBlock* block = mFreeBlocks;
+    mFreeBlocks = block->mNext;
+    mNbUsedBlocks++;
+
+    return block;
+}
+
+void PoolAllocator::Free( void* pMemory )
+{
+    if( pMemory == NULL )
+        return;
+
+    GD_ASSERT( mNbUsedBlocks > 0 );
+
+    FreeBlock* block = (FreeBlock*)pMemory;
+    block->mNext = mFreeBlocks;
+    mFreeBlocks = block;
+    mNbUsedBlocks--;
+}
+
+UInt32 PoolAllocator::GetBlockSize() const
+{
+    return mBlockSize;
+}
+
+UInt32 PoolAllocator::GetNbUsedBlocks() const
+{
+    return mNbUsedBlocks;
+}
+
+UInt32 PoolAllocator::GetNbBlocks() const
+{
+    return mChunks.size() * mBlocksPerChunk;
+}
+
+void PoolAllocator::AddChunk()
+{
+    Byte* chunk = GD_ALLOC(Byte, mBlockSize * mBlocksPerChunk + ALIGNMENT - 1, this, mTag);
+    mChunks.push_back( chunk );
+
+    Byte* blocks = (Byte*)(((size_t)chunk + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1));
+
+    // Link the blocks backward so they are handed out in address order.
+    for( Int32 i = mBlocksPerChunk - 1; i >= 0; i-- )
+    {
+        FreeBlock* block = (FreeBlock*)(blocks + i * mBlockSize);
+        block->mNext = mFreeBlocks;
+        mFreeBlocks = block;
+    }
+}
+
+
+} // namespace Gamedesk
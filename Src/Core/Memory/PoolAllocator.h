@@ -0,0 +1,94 @@
+/**
+ *  @file       PoolAllocator.h
+ *  @brief      Allocator of fixed size blocks.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _POOL_ALLOCATOR_H_
+#define     _POOL_ALLOCATOR_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Allocate blocks of a fixed size from chunks, for objects that are created
+ *  and destroyed often (particles, glyphs). Free blocks are kept in a list
+ *  threaded through the blocks themselves, so allocating and releasing a
+ *  block are constant time. Chunks are only released by the destructor.
+ *  Objects are constructed in it with GD_NEW_IN and destroyed with GD_DELETE_IN.
+ *  Not thread safe.
+ */
+class CORE_API PoolAllocator
+{
+public:
+    static const UInt32 ALIGNMENT = 16;     //!< Alignment of every block.
+
+public:
+    /**
+     *  Constructor.
+     *  @param  pBlockSize      Size of the blocks, rounded up to ALIGNMENT.
+     *  @param  pBlocksPerChunk Number of blocks allocated at once when the pool is empty.
+     *  @param  pTag            Tag of the chunks for the memory tracker.
+     */
+    PoolAllocator( UInt32 pBlockSize, UInt32 pBlocksPerChunk, const Char* pTag );
+    ~PoolAllocator();
+
+    //! Allocate a block, pSize must not be larger than the block size.
+    void* Allocate( UInt32 pSize );
+
+    //! Give a block back to the pool.
+    void Free( void* pMemory );
+
+    UInt32 GetBlockSize() const;
+
+    //! Number of blocks currently allocated.
+    UInt32 GetNbUsedBlocks() const;
+
+    //! Number of blocks in all the chunks.
+    UInt32 GetNbBlocks() const;
+
+private:
+    CLASS_DISABLE_COPY(PoolAllocator);
+
+    void AddChunk();
+
+    class FreeBlock
+    {
+    public:
+        FreeBlock*  mNext;
+    };
+
+private:
+    const Char*     mTag;
+    UInt32          mBlockSize;
+    UInt32          mBlocksPerChunk;
+    Vector<Byte*>   mChunks;
+    FreeBlock*      mFreeBlocks;
+    UInt32          mNbUsedBlocks;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _POOL_ALLOCATOR_H_
@@ -46,7 +46,13 @@ Module::~Module()
     ModuleManager::Instance()->UnregisterModule( this );
     
     if( mDynamicLoad && mHandle != 0 )
+    {
         Core::CloseLibrary( mHandle );
+
+#if GD_CFG_USE_MEMORY_TRACKING == GD_ENABLED
+        MemoryTracker::ForgetTagAddresses();
+#endif
+    }
 }
 
 
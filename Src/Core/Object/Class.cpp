@@ -43,6 +43,11 @@ Class::Class()
     mClassSize      = 0;        // class size in bytes
     mFuncClassNew   = NULL;     // Function pointer to the constructor
     mAbstract       = true;
+
+#if GD_CFG_USE_PROPERTIES == GD_ENABLED
+    mFuncSerializeProperties    = NULL;
+    mFuncDiffProperties         = NULL;
+#endif
 }
 
 
@@ -54,6 +59,12 @@ Class::Class( const Char* pStrName, Class* pClsSuper, UInt32 pClassSize, Object*
     mFuncClassNew   = pFuncClassNew;    // Function pointer to the constructor
     mAbstract       = pAbstract;        // Class is abstract or not ?
 
+#if GD_CFG_USE_PROPERTIES == GD_ENABLED
+    // Set by the generated StaticRegisterProperties
+    mFuncSerializeProperties    = NULL;
+    mFuncDiffProperties         = NULL;
+#endif
+
     // Register properties...
     if( pFuncRegisterProperties )
         pFuncRegisterProperties( this );
@@ -98,4 +109,46 @@ Class* Class::GetClassByName( const Char* pStrName )
 }
 
 
+#if GD_CFG_USE_PROPERTIES == GD_ENABLED
+void Class::SerializeProperties( Object* pObject, Stream& pStream ) const
+{
+    if( mSuperClass )
+        mSuperClass->SerializeProperties( pObject, pStream );
+
+    if( mFuncSerializeProperties )
+        mFuncSerializeProperties( pObject, pStream );
+}
+
+
+void Class::DiffProperties( const Object* pObject, const Byte* pSnapshot, Bool* pChanged ) const
+{
+    DiffClassProperties( pObject, pSnapshot, pChanged );
+}
+
+
+Bool* Class::DiffClassProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged ) const
+{
+    if( mSuperClass )
+        pChanged = mSuperClass->DiffClassProperties( pObject, pSnapshot, pChanged );
+
+    UInt32 count = (UInt32)mProperties.size();
+
+    if( mFuncDiffProperties )
+    {
+        // The generated function only flags the properties that changed.
+        memset( pChanged, 0, count * sizeof(Bool) );
+        mFuncDiffProperties( pObject, pSnapshot, pChanged );
+    }
+    else
+    {
+        // Not part of the snapshot, assume it changed.
+        for( UInt32 i = 0; i < count; i++ )
+            pChanged[i] = true;
+    }
+
+    return pChanged + count;
+}
+#endif
+
+
 } // namespace Gamedesk
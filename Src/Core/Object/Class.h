@@ -301,6 +301,40 @@ public:
         GD_ASSERT_EX(pProperty != NULL);
         mProperties.push_back(pProperty);
     }
+
+    typedef void (*SerializePropertiesFunc)( Object* pObject, Stream& pStream );
+    typedef void (*DiffPropertiesFunc)( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged );
+
+    /**
+     *  Set the functions generated by gdprop for the properties of this class.
+     *  @param  pFuncSerialize  Serialize the properties of this class (not those of the super classes).
+     *  @param  pFuncDiff       Compare the properties of this class to their snapshot and flag the changed ones.
+     */
+    void SetPropertyFunctions( SerializePropertiesFunc pFuncSerialize, DiffPropertiesFunc pFuncDiff )
+    {
+        mFuncSerializeProperties = pFuncSerialize;
+        mFuncDiffProperties = pFuncDiff;
+    }
+
+    /**
+     *  Serialize the properties of an object, starting with those of the root class.
+     *  Classes without generated property functions are skipped.
+     *  @param  pObject     Object of this class.
+     *  @param  pStream     Stream used for serialization.
+     */
+    void SerializeProperties( Object* pObject, Stream& pStream ) const;
+
+    /**
+     *  Compare the properties of an object to a snapshot written by SerializeProperties().
+     *  Properties of classes without generated property functions are always flagged.
+     *  @param  pObject     Object of this class.
+     *  @param  pSnapshot   Snapshot of the properties of the object.
+     *  @param  pChanged    Receives GetPropertyCount() flags, in PropertyIterator order.
+     */
+    void DiffProperties( const Object* pObject, const Byte* pSnapshot, Bool* pChanged ) const;
+
+private:
+    Bool* DiffClassProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged ) const;
 #endif
 
 protected:
@@ -311,6 +345,8 @@ protected:
 
 #if GD_CFG_USE_PROPERTIES == GD_ENABLED
     Vector<Property*>   mProperties;
+    SerializePropertiesFunc mFuncSerializeProperties;   //!< Generated serialization of the properties of this class, may be NULL.
+    DiffPropertiesFunc  mFuncDiffProperties;            //!< Generated snapshot comparison of the properties of this class, may be NULL.
 #endif
 };
 
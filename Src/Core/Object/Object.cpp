@@ -42,7 +42,7 @@ Object*  Object::mLastObject    = NULL;
 
 Object::Object() :
     mOwner(NULL),
-    mFlags(0),
+    mFlags(OBJ_Dirty),
     mNextObject( NULL ),
     mPrevObject( NULL )
 {
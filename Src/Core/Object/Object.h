@@ -55,7 +55,8 @@ public:
     enum ObjectFlags
     {
         OBJ_Internal = 0x00000001,
-        OBJ_External = 0x00000002
+        OBJ_External = 0x00000002,
+        OBJ_Dirty    = 0x00000004   //!< Modified since its package was last loaded or saved.
     };
 
 public:
@@ -138,6 +139,16 @@ public:
         return (mFlags & pFlags) == pFlags;
     }
 
+    /**
+     *  Flag this object as modified so that it's serialized by the next Package::Save().
+     *  Clean objects are saved by copying their data from the previous package file.
+     *  New objects start dirty.
+     */
+    void MarkDirty()
+    {
+        mFlags |= OBJ_Dirty;
+    }
+
     // Object List Methods
 
     /**
@@ -42,6 +42,8 @@ namespace Gamedesk {
 
 
 class ObjectProperties;
+class Object;
+class Stream;
 
 /**
  *  Used to generate unique id for property classes (see DECLARE_PROPERTY_CLASS)
@@ -618,13 +620,66 @@ public:
     }
 };
 
+
+/**
+ *  Compare the properties of an object to a snapshot of them, written by the
+ *  SerializeProperties() function generated by gdprop.
+ *  Used by the generated StaticDiffProperties() functions.
+ */
+class PropertySnapshot
+{
+public:
+    /**
+     *  Test if a run of properties is unchanged, in a single compare when the run is contiguous in memory.
+     *  @param  pSnapshot   Snapshot of the run.
+     *  @param  pFirst      First property of the run.
+     *  @param  pEnd        One past the last property of the run.
+     *  @param  pSize       Sum of the sizes of the properties of the run.
+     *  @return \b True if the run is contiguous and did not change.
+     */
+    static Bool RunEqual( const Byte* pSnapshot, const void* pFirst, const void* pEnd, UInt32 pSize )
+    {
+        return (UInt32)((const Byte*)pEnd - (const Byte*)pFirst) == pSize && memcmp(pSnapshot, pFirst, pSize) == 0;
+    }
+
+    //! Test if a property changed and move pSnapshot past it.
+    template <class T>
+    static Bool Changed( const Byte*& pSnapshot, const T& pValue )
+    {
+        Bool changed = memcmp(pSnapshot, &pValue, sizeof(T)) != 0;
+        pSnapshot += sizeof(T);
+        return changed;
+    }
+
+    //! Test if a string property changed and move pSnapshot past it.
+    static Bool Changed( const Byte*& pSnapshot, const String& pValue )
+    {
+        UInt32 len;
+        memcpy( &len, pSnapshot, sizeof(len) );
+
+        Bool changed = len != pValue.length() || memcmp(pSnapshot + sizeof(len), pValue.c_str(), len) != 0;
+        pSnapshot += sizeof(len) + len + 1;
+        return changed;
+    }
+};
+
+
+/**
+ *  Declare the functions generated by gdprop for the properties of a class.
+ *  SerializeProperties() only handles the properties of the class itself, Serialize()
+ *  should call it after Super::Serialize().
+ */
 #if GD_CFG_USE_PROPERTIES == GD_ENABLED
-    #define properties                                                          \
-            static void StaticRegisterProperties(Gamedesk::Class* pClass);      \
+    #define properties                                                                                              \
+            static void StaticRegisterProperties(Gamedesk::Class* pClass);                                          \
+            static void StaticSerializeProperties(Gamedesk::Object* pObject, Gamedesk::Stream& pStream);            \
+            static void StaticDiffProperties(const Gamedesk::Object* pObject, const Byte*& pSnapshot, Bool* pChanged); \
+            void SerializeProperties(Gamedesk::Stream& pStream);                                                    \
         protected
 #else
     #define properties                                                          \
             static void StaticRegisterProperties(Gamedesk::Class*) {}           \
+            void SerializeProperties(Gamedesk::Stream& pStream);                \
         protected
 #endif
 
@@ -29,6 +29,8 @@
 #include "Package.h"
 
 #include "FileManager/FileManager.h"
+#include "Stream/CompressedStream.h"
+#include "Stream/MemoryStream.h"
 
 
 namespace Gamedesk {
@@ -37,6 +39,10 @@ namespace Gamedesk {
 IMPLEMENT_CLASS(Package)
 
 
+static const UInt32 PackageTag      = ('G') + ('D'<<8) + ('P'<<16) + ('K'<<24);
+static const UInt32 PackageVersion  = 5;
+
+
 // Singleton Instance
 PackageManager PackageManager::mInstance;
 
@@ -67,8 +73,24 @@ Package* PackageManager::GetPackage( const String& pPackageName )
     return NULL;
 }
 
+void PackageManager::SetSynchronizedFile( const String& pFileName )
+{
+    mSynchronizedFile     = pFileName;
+    mSynchronizedFileTime = FileManager::GetLastWriteTime( pFileName );
+}
+
+Bool PackageManager::IsSynchronizedFile( const String& pFileName ) const
+{
+    // A file modified by someone else can't be trusted.
+    return mSynchronizedFile == pFileName && 
+           mSynchronizedFileTime != 0 &&
+           mSynchronizedFileTime == FileManager::GetLastWriteTime( pFileName );
+}
+
 Package::Package()
-    : mMustBeSaved(false)
+    : mCodec(Compression::Codec_None)
+    , mCompressionLevel(Compression::LEVEL_FAST)
+    , mMustBeSaved(false)
 {
 }
 
@@ -81,59 +103,6 @@ Package::~Package()
 namespace PackageHelper
 {
 
-class PreprocessOuputStream : public OutputStream
-{
-    CLASS_DISABLE_COPY(PreprocessOuputStream);
-
-public:
-    PreprocessOuputStream()
-        : mPos(0)
-        , mNbExternalObjects(0)
-    {
-    }
-
-    Stream& operator << ( Object*& pObj )
-    {
-        // Check if an object is referenced, but is not part of this package.
-        if( pObj && !pObj->HasFlags(Object::OBJ_Internal) && !pObj->HasFlags(Object::OBJ_External) )
-        {
-            pObj->SetFlags(Object::OBJ_External);
-            mNbExternalObjects++;
-        }
-
-        // For each reference to an object, an index is serialized.
-        Serialize( NULL, sizeof(Int32) );
-
-        if( pObj && pObj->GetOwner() )
-        {
-            Object* owner = pObj->GetOwner();
-            (*this) << owner;
-        }
-
-        return *this;
-    }
-
-    void Serialize( void* /*pData*/, UInt32 pLen )
-    {
-        mPos += pLen;
-    }
-
-    UInt32 GetPos() const
-    {
-        return mPos;
-    }
-
-    UInt32 GetNbExternalObjects() const
-    {
-        return mNbExternalObjects;
-    }
-
-private:
-    UInt32  mPos;
-    UInt32  mNbExternalObjects;
-};
-
-
 class InternalOutputStream : public OutputStream
 {
     CLASS_DISABLE_COPY(InternalOutputStream);
@@ -153,8 +122,10 @@ public:
 
     Stream& operator << ( class Object*& pObj ) 
     {
-        // Save entry in package mObjectIndices
-        mStream << mPackage->mObjectIndices[pObj];
+        // Save entry in package mObjectIndices, objects not found are not part of this package.
+        Int32* index = mPackage->mObjectIndices.Find( pObj );
+        Int32  entry = index ? *index : mPackage->AddExternalObject( pObj );
+        mStream << entry;
 
         if( pObj != NULL )
         {
@@ -211,21 +182,72 @@ private:
     Package*        mPackage;
 };
 
+
+//! Object data written to a package, copied from the previous file or newly serialized.
+class DataChunk
+{
+public:
+    const Byte* GetData( const Byte* pPreviousData, const Vector<Byte>& pNewData ) const
+    {
+        if( mIsNew )
+            return pNewData.empty() ? NULL : &pNewData[0] + mSourceOffset;
+
+        return pPreviousData + mSourceOffset;
+    }
+
+    Bool        mIsNew;
+    UInt32      mSourceOffset;  //!< Offset in the previous file data or in the new data.
+    UInt32      mSize;
+    UInt32      mOffset;        //!< Offset in the data of the package being saved.
+};
+
+
+//! Read a whole file, the tables are then parsed from memory instead of by many small reads.
+static Bool ReadFile( const String& pFileName, Vector<Byte>& pBuffer )
+{
+    UInt32  size   = FileManager::GetFileSize( pFileName );
+    Stream* stream = size ? FileManager::CreateInputStream( pFileName ) : NULL;
+    if( stream == NULL )
+        return false;
+
+    pBuffer.resize( size );
+    stream->Serialize( &pBuffer[0], size );
+    GD_DELETE(stream);
+
+    return true;
+}
+
+
+//! Key used to match the objects with the entries of the previous file.
+static String GetObjectKey( const String& pClassName, const String& pParentName, const String& pObjectName )
+{
+    String key;
+    key.reserve( pClassName.size() + pParentName.size() + pObjectName.size() + 2 );
+    key += pClassName;
+    key += '\n';
+    key += pParentName;
+    key += '\n';
+    key += pObjectName;
+    return key;
+}
+
 }
 
 void Package::Reset()
 {
-    mHeader.mTag                    = ('G') + ('D'<<8) + ('P'<<16) + ('K'<<24);
-    mHeader.mVersion                = 0;
+    mHeader.mTag                    = PackageTag;
+    mHeader.mVersion                = PackageVersion;
+    mHeader.mCodec                  = mCodec;
     mHeader.mName                   = GetName();
     mHeader.mDependencyCount        = 0;
     mHeader.mInternalObjectCount    = 0;
     mHeader.mExternalObjectCount    = 0;
+    mHeader.mDataSize               = 0;
 
     mDependencies.clear();
     mInternalObjects.clear();
     mExternalObjects.clear();
-    mObjectIndices.clear();
+    mObjectIndices.Clear();
 
     mObjectIndices[NULL] = 0;
 
@@ -242,42 +264,197 @@ Object* Package::GetObjectFromIndex( Int32 pIndex )
     return NULL;
 }
 
+Int32 Package::AddExternalObject( Object* pObject )
+{
+    ExternalObject externalObj;
+    externalObj.mObject     = pObject;
+    externalObj.mObjectName = pObject->GetName();
+
+    Package* package = pObject->GetPackage();
+    if( package != NULL )
+    {
+        if( std::find( mDependencies.begin(), mDependencies.end(), package->GetName() ) == mDependencies.end() )
+            mDependencies.push_back( package->GetName() );
+    }
+
+    externalObj.mPackageName = package ? package->GetName() : "None";
+    mExternalObjects.push_back( externalObj );
+
+    // Index 0 is reserved for NULL!
+    Int32 index = -(Int32)mExternalObjects.size();
+    mObjectIndices[pObject] = index;
+
+    return index;
+}
+
+Bool Package::LoadPreviousFile( Vector<Byte>& pFile, const Byte*& pData )
+{
+    // The clean objects must match the content of the file.
+    if( !PackageManager::Instance()->IsSynchronizedFile( GetName() ) )
+        return false;
+
+    const Byte* body;
+    UInt32      bodySize;
+    if( !ReadFile( GetName(), pFile, body, bodySize ) )
+        return false;
+
+    MemoryInputStream bodyStream( body, bodySize );
+    SerializeHeader( bodyStream );
+    GD_ASSERT_M( bodyStream.Pos() + mHeader.mDataSize == bodySize, "Invalid package size!" );
+
+    pData = body + bodyStream.Pos();
+
+    // The file is saved with the current codec, not the previous one.
+    mHeader.mCodec = mCodec;
+
+    return true;
+}
+
+Bool Package::MatchPreviousObjects( const Vector<Object*>& pObjects )
+{
+    // Index (+1) of the previous entries by key, entries sharing a key are chained in file order.
+    // Only built if the objects are not found in the same order as in the file.
+    HashMap<String, UInt32> firstEntries;
+    Vector<UInt32>          nextEntries;
+
+    UInt32 nbPreviousObjects = mInternalObjects.size();
+    UInt32 nextPrevious      = 0;
+
+    mObjectIndices.Reserve( pObjects.size() + mExternalObjects.size() );
+
+    // Objects keep their previous index so that the references in the data of 
+    // clean objects stay valid. New objects are added at the end.
+    for( Vector<Object*>::const_iterator itObj = pObjects.begin(); itObj != pObjects.end(); ++itObj )
+    {
+        Object* obj   = *itObj;
+        Object* owner = obj->GetOwner();
+        UInt32  index = 0;
+
+        const String& className  = obj->SerializeAs()->GetName();
+        const Char* parentName = owner ? owner->GetName().c_str() : "";
+
+        // Fast path, the next entry of the file.
+        while( nextPrevious < nbPreviousObjects && mInternalObjects[nextPrevious].mObject != NULL )
+            nextPrevious++;
+
+        if( nextPrevious < nbPreviousObjects )
+        {
+            const InternalObject& internalObj = mInternalObjects[nextPrevious];
+            if( internalObj.mObjectName == obj->GetName() && 
+                internalObj.mParentName == parentName && 
+                internalObj.mClassName == className )
+            {
+                index = ++nextPrevious;
+            }
+        }
+
+        if( index == 0 && nbPreviousObjects != 0 )
+        {
+            if( nextEntries.empty() )
+            {
+                firstEntries.Reserve( nbPreviousObjects );
+                nextEntries.resize( nbPreviousObjects );
+
+                for( UInt32 i = nbPreviousObjects; i > 0; i-- )
+                {
+                    const InternalObject& internalObj = mInternalObjects[i - 1];
+                    UInt32& first = firstEntries[PackageHelper::GetObjectKey(internalObj.mClassName, internalObj.mParentName, internalObj.mObjectName)];
+                    nextEntries[i - 1] = first;
+                    first = i;
+                }
+            }
+
+            // Skip the entries already matched by the fast path.
+            UInt32* first = firstEntries.Find( PackageHelper::GetObjectKey(className, parentName, obj->GetName()) );
+            while( first != NULL && *first != 0 && index == 0 )
+            {
+                if( mInternalObjects[*first - 1].mObject == NULL )
+                    index = *first;
+
+                *first = nextEntries[*first - 1];
+            }
+        }
+
+        if( index != 0 )
+        {
+            mInternalObjects[index - 1].mObject = obj;
+        }
+        else
+        {
+            InternalObject internalObj;
+            internalObj.mObject     = obj;
+            internalObj.mObjectName = obj->GetName();
+            internalObj.mClassName  = className;
+            internalObj.mParentName = parentName;
+
+            mInternalObjects.push_back( internalObj );
+            index = mInternalObjects.size();
+        }
+
+        mObjectIndices[obj] = index;
+    }
+
+    // Objects were removed, renamed or moved: clean objects could reference their old index.
+    for( UInt32 i = 0; i < nbPreviousObjects; i++ )
+    {
+        if( mInternalObjects[i].mObject == NULL )
+            return false;
+    }
+
+    return true;
+}
+
+Bool Package::ResolvePreviousExternalObjects()
+{
+    for( UInt32 i = 0; i < mExternalObjects.size(); i++ )
+    {
+        ExternalObject& externalObj = mExternalObjects[i];
+
+        externalObj.mObject = Object::FindObject( externalObj.mObjectName, externalObj.mPackageName );
+        if( externalObj.mObject == NULL || mObjectIndices.Find( externalObj.mObject ) != NULL )
+            return false;
+
+        mObjectIndices[externalObj.mObject] = -(Int32)(i + 1);
+    }
+
+    return true;
+}
+
 void Package::Save()
 {
     Reset();
 
-    mHeader.mName = GetName();
+    // Load the tables and the object data of the previous file, if it can be reused.
+    Vector<Byte> previousFile;
+    const Byte*  previousData = NULL;
+    Bool incremental = LoadPreviousFile( previousFile, previousData );
 
-    // We must build the tables.
+    mHeader.mName = GetName();
 
     // Iterate through all the objects, add objects owned by this package to the list.
-    // Flag them as OBJ_Internal
+    Vector<Object*> objects;
     for( ObjectIterator<Object> itObj; itObj; ++itObj )
     {
         if( (*itObj)->IsOwnedBy(this) )
-        {
-            (*itObj)->SetFlags( Object::OBJ_Internal );
-            mHeader.mInternalObjectCount++;
-        }
+            objects.push_back( *itObj );
     }
 
-    // Create the internal objects table.
-    mInternalObjects.resize( mHeader.mInternalObjectCount );
-
-    // Next, iterate through all the objects.
-    // Serialize the objects flagged as internal to a special stream.
-    // This stream will look for references to objects not in this package.
-    // Flag them as OBJ_External.
-    // This stream will also count the number of bytes outputted.
-    PackageHelper::PreprocessOuputStream packageHelperStream;
-    Vector<InternalObject>::iterator itInternalObj = mInternalObjects.begin();
+    UInt32 nbPreviousObjects = mInternalObjects.size();
+    if( incremental )
+        incremental = MatchPreviousObjects( objects ) && ResolvePreviousExternalObjects();
 
-    UInt32 previousPos = 0;
-    UInt32 currentPos  = 0;
-    Int32  index       = 1; // Index 0 is reserved for NULL objects.
-    for( ObjectIterator<Object> itObj; itObj; ++itObj )
+    if( !incremental )
     {
-        if( (*itObj)->HasFlags( Object::OBJ_Internal ) )
+        Reset();
+        nbPreviousObjects = 0;
+
+        // Create the internal objects table.
+        Int32 index = 1; // Index 0 is reserved for NULL objects.
+        mInternalObjects.resize( objects.size() );
+        mObjectIndices.Reserve( objects.size() );
+
+        Vector<InternalObject>::iterator itInternalObj = mInternalObjects.begin();
+        for( Vector<Object*>::iterator itObj = objects.begin(); itObj != objects.end(); ++itObj, ++itInternalObj )
         {
             mObjectIndices[*itObj]       = index++;
 
@@ -285,63 +462,135 @@ void Package::Save()
             (*itInternalObj).mObjectName = (*itObj)->GetName();
             (*itInternalObj).mClassName  = (*itObj)->SerializeAs()->GetName();
             (*itInternalObj).mParentName = (*itObj)->GetOwner() ? (*itObj)->GetOwner()->GetName() : "";
-
-            // Compute object size...
-            previousPos = currentPos;
-            (*itObj)->Serialize( packageHelperStream );
-            currentPos = packageHelperStream.GetPos();
-            (*itInternalObj).mSize = currentPos - previousPos;
-
-            ++itInternalObj;
         }
     }
 
-    // Create the external objects table.
-    index = -1;  // Index 0 is reserved for NULL!
-    mHeader.mExternalObjectCount = packageHelperStream.GetNbExternalObjects();
-    mExternalObjects.resize( mHeader.mExternalObjectCount );
-    Vector<ExternalObject>::iterator itExternalObj = mExternalObjects.begin();
-    for( ObjectIterator<Object> itObj; itObj; ++itObj )
+    // Build the object data. Dirty and new objects are serialized, the data of the 
+    // others is copied from the previous file. External objects are added to their 
+    // table as they are referenced. Data is stored once per content hash.
+    Vector<Byte>                        newData;
+    Vector<PackageHelper::DataChunk>    chunks;
+    HashMap<XXHashChecksum::Value, UInt32> chunkIndices;
+    UInt32                              dataSize = 0;
+
+    chunks.reserve( mInternalObjects.size() );
+    chunkIndices.Reserve( mInternalObjects.size() );
+
+    for( UInt32 i = 0; i < mInternalObjects.size(); i++ )
     {
-        if( (*itObj)->HasFlags( Object::OBJ_External ) )
+        InternalObject&          internalObj = mInternalObjects[i];
+        PackageHelper::DataChunk chunk;
+
+        if( i < nbPreviousObjects && !internalObj.mObject->HasFlags(Object::OBJ_Dirty) )
         {
-            mObjectIndices[*itObj]        = index--;
+            chunk.mIsNew        = false;
+            chunk.mSourceOffset = internalObj.mOffset;
+            chunk.mSize         = internalObj.mSize;
+        }
+        else
+        {
+            chunk.mIsNew        = true;
+            chunk.mSourceOffset = newData.size();
+
+            MemoryOutputStream   memoryStream( newData );
+            PackageHelper::InternalOutputStream internalStream( memoryStream, this );
+            internalObj.mObject->Serialize( internalStream );
 
-            (*itExternalObj).mObject      = (*itObj);
-            (*itExternalObj).mObjectName  = (*itObj)->GetName();
+            chunk.mSize       = newData.size() - chunk.mSourceOffset;
+            internalObj.mSize = chunk.mSize;
+            internalObj.mHash = XXHashChecksum::Compute( chunk.GetData(previousData, newData), chunk.mSize );
+        }
+
+        UInt32* chunkIndex = chunkIndices.Find( internalObj.mHash );
+        if( chunkIndex != NULL && chunks[*chunkIndex].mSize == chunk.mSize &&
+            memcmp( chunks[*chunkIndex].GetData(previousData, newData), chunk.GetData(previousData, newData), chunk.mSize ) == 0 )
+        {
+            internalObj.mOffset = chunks[*chunkIndex].mOffset;
+
+            if( chunk.mIsNew )
+                newData.resize( chunk.mSourceOffset );
+        }
+        else
+        {
+            chunk.mOffset       = dataSize;
+            internalObj.mOffset = dataSize;
+            dataSize += chunk.mSize;
 
-            Package* pPackage = (*itObj)->GetPackage();
-            if( pPackage != NULL )
-                mDependencies.push_back( pPackage->GetName() );
+            if( chunkIndex == NULL )
+                chunkIndices[internalObj.mHash] = chunks.size();
 
-            (*itExternalObj).mPackageName = pPackage ? pPackage->GetName() : "None";
-            ++itExternalObj;
+            chunks.push_back( chunk );
         }
     }
 
-    mHeader.mDependencyCount = mDependencies.size();
+    mHeader.mDependencyCount     = mDependencies.size();
+    mHeader.mInternalObjectCount = mInternalObjects.size();
+    mHeader.mExternalObjectCount = mExternalObjects.size();
+    mHeader.mDataSize            = dataSize;
 
-    Stream* stream = FileManager::CreateOutputStream( GetName() );
+    // Build the header and tables in memory, they are written in one call.
+    Vector<Byte> header;
+    MemoryOutputStream headerStream( header );
+    SerializeHeader( headerStream );
 
-    SerializeHeader( *stream );
+    Stream* fileStream = FileManager::CreateOutputStream( GetName() );
+    GD_ASSERT_M( fileStream != NULL, "Package file could not be created!" );
 
-    // Save all internal objects
-    PackageHelper::InternalOutputStream internalStream(*stream, this);
-    for( Vector<InternalObject>::iterator it = mInternalObjects.begin(); it != mInternalObjects.end(); ++it )
-        (*it).mObject->Serialize( internalStream );
+    SerializeFileTag( *fileStream );
 
-    GD_DELETE(stream);
+    Stream* stream = fileStream;
+    if( mHeader.mCodec != Compression::Codec_None )
+        stream = GD_NEW(CompressedOutputStream, this, "Core::Package::Package")( *fileStream, mCodec, mCompressionLevel );
+
+    stream->Serialize( &header[0], header.size() );
+
+    // Chunks following each other in memory (usually clean objects) are written in one call.
+    for( UInt32 i = 0; i < chunks.size(); )
+    {
+        const Byte* data = chunks[i].GetData( previousData, newData );
+        UInt32      size = chunks[i].mSize;
+
+        for( i++; i < chunks.size() && chunks[i].GetData(previousData, newData) == data + size; i++ )
+            size += chunks[i].mSize;
+
+        if( size != 0 )
+            stream->Serialize( (void*)data, size );
+    }
+
+    if( stream != fileStream )
+        GD_DELETE(stream);
+    GD_DELETE(fileStream);
+
+    // All objects of the package now match the file.
+    for( Vector<Object*>::iterator itObj = objects.begin(); itObj != objects.end(); ++itObj )
+        (*itObj)->ClearFlags( Object::OBJ_Dirty );
+
+    PackageManager::Instance()->SetSynchronizedFile( GetName() );
 }
 
 void Package::Load()
 {
     Reset();
 
-    Stream* stream = FileManager::CreateInputStream( GetName() );
+    String fileName = GetName();
+
+    // The data of the objects is not stored in table order, read the whole file.
+    Vector<Byte> file;
+    const Byte*  body;
+    UInt32       bodySize;
+    Bool found = ReadFile( fileName, file, body, bodySize );
+    GD_ASSERT_M( found, "Package file not found or corrupted!" );
+
+    // Saving again keeps the codec of the file.
+    mCodec = (Compression::Codec)mHeader.mCodec;
 
-    SerializeHeader( *stream );
+    MemoryInputStream bodyStream( body, bodySize );
+    SerializeHeader( bodyStream );
     SetName( mHeader.mName );
 
+    GD_ASSERT_M( bodyStream.Pos() + mHeader.mDataSize == bodySize, "Invalid package size!" );
+    const Byte* data = body + bodyStream.Pos();
+
     // First, make sure all dependencies are loaded.
     for( Vector<String>::iterator itDep = mDependencies.begin(); itDep != mDependencies.end(); ++itDep )
     {
@@ -384,22 +633,81 @@ void Package::Load()
     }
 
     // Load all internal objects
-    PackageHelper::InternalInputStream internalStream(*stream, this);
     for( Vector<InternalObject>::iterator it = mInternalObjects.begin(); it != mInternalObjects.end(); ++it )
+    {
+        MemoryInputStream   memoryStream( data + (*it).mOffset, (*it).mSize );
+        PackageHelper::InternalInputStream internalStream( memoryStream, this );
         (*it).mObject->Serialize( internalStream );
+        (*it).mObject->ClearFlags( Object::OBJ_Dirty );
+    }
 
-    GD_DELETE(stream);
+    PackageManager::Instance()->SetSynchronizedFile( fileName );
 }
 
-void Package::SerializeHeader( Stream& pStream )
+void Package::SetCompression( Compression::Codec pCodec, Int32 pLevel )
 {
-    // Serialize the header
+    mCodec = pCodec;
+    mCompressionLevel = pLevel;
+}
+
+Compression::Codec Package::GetCompression() const
+{
+    return mCodec;
+}
+
+Bool Package::ReadFile( const String& pFileName, Vector<Byte>& pFile, const Byte*& pBody, UInt32& pBodySize )
+{
+    if( !PackageHelper::ReadFile( pFileName, pFile ) )
+        return false;
+
+    MemoryInputStream fileStream( &pFile[0], pFile.size() );
+    SerializeFileTag( fileStream );
+
+    pBody     = &pFile[0] + fileStream.Pos();
+    pBodySize = pFile.size() - fileStream.Pos();
+
+    // Compressed packages are decompressed in memory, blocks are decoded in parallel.
+    if( mHeader.mCodec != Compression::Codec_None )
+    {
+        CompressedInputStream compressedStream( pBody, pBodySize );
+        if( !compressedStream.IsValid() || compressedStream.GetCodec() != mHeader.mCodec )
+            return false;
+
+        Vector<Byte> body;
+        body.resize( compressedStream.Size() );
+        if( !body.empty() )
+            compressedStream.Serialize( &body[0], body.size() );
+
+        if( !compressedStream.IsValid() )
+            return false;
+
+        pFile.swap( body );
+        pBody     = pFile.empty() ? NULL : &pFile[0];
+        pBodySize = pFile.size();
+    }
+
+    return true;
+}
+
+void Package::SerializeFileTag( Stream& pStream )
+{
+    // Never compressed, tells how to read the rest of the file.
     pStream << mHeader.mTag;
     pStream << mHeader.mVersion;
+    GD_ASSERT_M( mHeader.mTag == PackageTag && mHeader.mVersion == PackageVersion, "Unsupported package format!" );
+
+    pStream << mHeader.mCodec;
+    GD_ASSERT_M( mHeader.mCodec == Compression::Codec_None || mHeader.mCodec == Compression::Codec_LZ4, "Unsupported package codec!" );
+}
+
+void Package::SerializeHeader( Stream& pStream )
+{
+    // Serialize the header
     pStream << mHeader.mName;
     pStream << mHeader.mDependencyCount;
     pStream << mHeader.mInternalObjectCount;
     pStream << mHeader.mExternalObjectCount;
+    pStream << mHeader.mDataSize;
 
     // Serialize dependencies list.
     pStream << mDependencies;
@@ -29,6 +29,11 @@
 #define     _PACKAGE_H_
 
 
+#include "Containers/HashMap.h"
+#include "FileManager/Checksum.h"
+#include "Stream/Compression.h"
+
+
 namespace Gamedesk {
 
 
@@ -56,10 +61,23 @@ public:
 
     Package* CreatePackage( const String& pPackageName );
     Package* GetPackage( const String& pPackageName );
+
+    /**
+     *  Remember that the clean objects of a package match the content of its file,
+     *  as it is right after a load or a save. Objects have a single dirty flag so only
+     *  the last synchronized file is kept, saving to any other file is a full save.
+     *  @param  pFileName   Name of the package file that was just loaded or saved.
+     */
+    void SetSynchronizedFile( const String& pFileName );
+
+    //! Tell if the clean objects still match the content of a package file.
+    Bool IsSynchronizedFile( const String& pFileName ) const;
     
 private:
-    Map<String,Package*>    mPackages;  //!< Map containing loaded packages.
-    static PackageManager   mInstance;  //!< Singleton instance.
+    Map<String,Package*>    mPackages;              //!< Map containing loaded packages.
+    String                  mSynchronizedFile;      //!< Last package file loaded or saved.
+    UInt64                  mSynchronizedFileTime;  //!< Write time of mSynchronizedFile after it was loaded or saved.
+    static PackageManager   mInstance;              //!< Singleton instance.
 };
 
 
@@ -82,8 +100,29 @@ public:
     virtual ~Package();
 
     void Load();
+
+    /**
+     *  Save the objects owned by this package.
+     *  Only the objects flagged OBJ_Dirty are serialized, the data of the other objects
+     *  is copied from the previous file. A full save is done when the previous file
+     *  can't be trusted (written by someone else, or saved from other objects) or when
+     *  objects were removed, renamed or moved to another owner.
+     *  Object data is stored once per content hash, identical objects share their data.
+     */
     void Save();
 
+    /**
+     *  Select the codec used to compress this package on the next Save().
+     *  The object data and tables are compressed by independent blocks (see 
+     *  CompressedOutputStream). Packages are not compressed by default, a 
+     *  loaded package keeps the codec of its file.
+     *  @param  pCodec  Codec used to compress the package file.
+     *  @param  pLevel  Compression level, see Compression.
+     */
+    void SetCompression( Compression::Codec pCodec, Int32 pLevel = Compression::LEVEL_FAST );
+
+    Compression::Codec GetCompression() const;
+
 protected:
     Package();
 
@@ -94,10 +133,12 @@ protected:
     public:
         UInt32                  mTag;
         UInt32                  mVersion;
+        UInt32                  mCodec;                 //!< Codec of everything following the tag, version and codec.
         String                  mName;
         UInt32                  mDependencyCount;
         UInt32                  mInternalObjectCount;
         UInt32                  mExternalObjectCount;
+        UInt32                  mDataSize;              //!< Size of the object data following the tables.
     };
 
     class InternalObject
@@ -107,21 +148,28 @@ protected:
         String      mObjectName;    //!< Name of the object.
         String      mParentName;    //!< Name of parent object.
         String      mClassName;     //!< Name of the class.
+        UInt32      mOffset;        //!< Offset of this object data in the package data.
         UInt32      mSize;          //!< Size of this object data in the package.
+        XXHashChecksum::Value   mHash;  //!< Hash of this object data.
 
         InternalObject() 
             : mObject(NULL)
             , mObjectName()
             , mClassName()
+            , mOffset(0)
             , mSize(0)
+            , mHash(0)
         {
         }
 
         friend Stream& operator << ( Stream& pStream, InternalObject& pInternalObject )
         {
             pStream << pInternalObject.mObjectName;
+            pStream << pInternalObject.mParentName;
             pStream << pInternalObject.mClassName;
+            pStream << pInternalObject.mOffset;
             pStream << pInternalObject.mSize;
+            pStream << pInternalObject.mHash;
 
             return pStream;
         }
@@ -150,8 +198,15 @@ protected:
         }
     };
 
+    void    SerializeFileTag( Stream& pStream );
     void    SerializeHeader( Stream& pStream );
+    Bool    ReadFile( const String& pFileName, Vector<Byte>& pFile, const Byte*& pBody, UInt32& pBodySize );
     Object* GetObjectFromIndex( Int32 pIndex );
+    Int32   AddExternalObject( Object* pObject );
+
+    Bool    LoadPreviousFile( Vector<Byte>& pFile, const Byte*& pData );
+    Bool    MatchPreviousObjects( const Vector<Object*>& pObjects );
+    Bool    ResolvePreviousExternalObjects();
 
 
 protected:
@@ -160,8 +215,11 @@ protected:
     Vector<InternalObject>  mInternalObjects;
     Vector<ExternalObject>  mExternalObjects;
 
-    Map<Object*, Int32>     mObjectIndices; // Save only
-    
+    HashMap<Object*, Int32> mObjectIndices; // Save only
+
+
+    Compression::Codec      mCodec;
+    Int32                   mCompressionLevel;
 
     Bool mMustBeSaved;
 };
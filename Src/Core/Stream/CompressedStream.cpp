@@ -0,0 +1,618 @@
+/**
+ *  @file       CompressedStream.cpp
+ *  @brief      Streams compressed by independent blocks.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "CompressedStream.h"
+#include "Maths/Maths.h"
+#include "Thread/JobManager.h"
+
+
+namespace Gamedesk {
+
+
+static const UInt32 COMPRESSED_STREAM_MAGIC     = 0x5A434447;   // "GDCZ"
+static const UInt32 COMPRESSED_INDEX_MAGIC      = 0x49434447;   // "GDCI"
+static const UInt32 COMPRESSED_STREAM_VERSION   = 1;
+static const UInt32 COMPRESSED_HEADER_SIZE      = 4 * sizeof(UInt32);
+static const UInt32 COMPRESSED_TRAILER_SIZE     = 2 * sizeof(UInt32);
+static const UInt32 COMPRESSED_MAX_BLOCK_SIZE   = 16 * 1024 * 1024;
+static const UInt32 COMPRESSED_BATCH_BLOCKS     = 16;           // Blocks compressed/decompressed in parallel.
+
+
+static inline UInt32 ReadUInt32( const Byte* pData )
+{
+    UInt32 val;
+    memcpy( &val, pData, sizeof(val) );
+    return val;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Compress the blocks of a batch.
+class CompressBlocksBody : public ParallelForBody
+{
+public:
+    CompressBlocksBody( Compression::Codec pCodec, Int32 pLevel, UInt32 pBlockSize, const Vector<Byte>& pSource, Vector<Byte>& pDest, Vector<UInt32>& pDestSizes )
+        : mCodec(pCodec)
+        , mLevel(pLevel)
+        , mBlockSize(pBlockSize)
+        , mSource(pSource)
+        , mDest(pDest)
+        , mDestSizes(pDestSizes)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        UInt32 maxSize = Compression::GetMaxCompressedSize( mBlockSize );
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+        {
+            UInt32 offset = i * mBlockSize;
+            UInt32 size = Maths::Min( mBlockSize, (UInt32)mSource.size() - offset );
+            mDestSizes[i] = Compression::Compress( mCodec, mLevel, &mSource[offset], size, &mDest[i * maxSize] );
+        }
+    }
+
+private:
+    Compression::Codec      mCodec;
+    Int32                   mLevel;
+    UInt32                  mBlockSize;
+    const Vector<Byte>&     mSource;
+    Vector<Byte>&           mDest;
+    Vector<UInt32>&         mDestSizes;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressedOutputStream
+CompressedOutputStream::CompressedOutputStream( Stream& pStream, Compression::Codec pCodec, Int32 pLevel, UInt32 pBlockSize )
+    : mStream(pStream)
+    , mCodec(pCodec)
+    , mLevel(pLevel)
+    , mBlockSize(pBlockSize)
+    , mStreamPos(0)
+    , mPos(0)
+    , mClosed(false)
+{
+    GD_ASSERT( mStream.Out() );
+    GD_ASSERT( mBlockSize > 0 && mBlockSize <= COMPRESSED_MAX_BLOCK_SIZE );
+
+    mPending.reserve( mBlockSize * COMPRESSED_BATCH_BLOCKS );
+
+    UInt32 magic    = COMPRESSED_STREAM_MAGIC;
+    UInt32 version  = COMPRESSED_STREAM_VERSION;
+    UInt32 codec    = mCodec;
+    mStream << magic << version << codec << mBlockSize;
+    mStreamPos += COMPRESSED_HEADER_SIZE;
+
+    mIsValid = mStream.IsValid();
+}
+
+CompressedOutputStream::~CompressedOutputStream()
+{
+    Close();
+}
+
+Bool CompressedOutputStream::Close()
+{
+    if( mClosed )
+        return false;
+
+    FlushBlocks( true );
+
+    // End frame.
+    UInt32 zero = 0;
+    mStream << zero << zero;
+    mStreamPos += 2 * sizeof(UInt32);
+
+    // Seek index.
+    UInt32 indexOffset = mStreamPos;
+    UInt32 nbBlocks = (UInt32)mFrameOffsets.size();
+    mStream << nbBlocks;
+    if( nbBlocks )
+        mStream.Serialize( &mFrameOffsets[0], nbBlocks * sizeof(UInt32) );
+    mStream << mPos;
+
+    UInt32 magic = COMPRESSED_INDEX_MAGIC;
+    mStream << indexOffset << magic;
+
+    mClosed = true;
+    return true;
+}
+
+void CompressedOutputStream::Serialize( void* pData, UInt32 pLen )
+{
+    GD_ASSERT_M( !mClosed, "Writing to a closed compressed stream" );
+
+    const Byte* data = (const Byte*)pData;
+    UInt32 batchSize = mBlockSize * COMPRESSED_BATCH_BLOCKS;
+    
+    while( pLen > 0 )
+    {
+        UInt32 size = Maths::Min( pLen, batchSize - (UInt32)mPending.size() );
+        mPending.insert( mPending.end(), data, data + size );
+        data += size;
+        pLen -= size;
+        mPos += size;
+
+        if( mPending.size() == batchSize )
+            FlushBlocks( false );
+    }
+}
+
+UInt32 CompressedOutputStream::Pos() const
+{
+    return mPos;
+}
+
+void CompressedOutputStream::FlushBlocks( Bool pAll )
+{
+    UInt32 nbBlocks = (UInt32)mPending.size() / mBlockSize;
+    if( pAll && (mPending.size() % mBlockSize) != 0 )
+        nbBlocks++;
+
+    if( nbBlocks == 0 )
+        return;
+
+    UInt32 maxSize = Compression::GetMaxCompressedSize( mBlockSize );
+    mCompressed.resize( nbBlocks * maxSize );
+    mCompressedSizes.resize( nbBlocks );
+
+    CompressBlocksBody body( mCodec, mLevel, mBlockSize, mPending, mCompressed, mCompressedSizes );
+    JobManager::Instance()->ParallelFor( nbBlocks, 1, body );
+
+    for( UInt32 i = 0; i < nbBlocks; i++ )
+    {
+        UInt32 offset = i * mBlockSize;
+        UInt32 rawSize = Maths::Min( mBlockSize, (UInt32)mPending.size() - offset );
+        
+        // Blocks that don't compress are stored as is.
+        Byte* data = &mCompressed[i * maxSize];
+        UInt32 storedSize = mCompressedSizes[i];
+        if( storedSize >= rawSize )
+        {
+            data = &mPending[offset];
+            storedSize = rawSize;
+        }
+
+        mFrameOffsets.push_back( mStreamPos );
+        mStream << storedSize << rawSize;
+        mStream.Serialize( data, storedSize );
+        mStreamPos += 2 * sizeof(UInt32) + storedSize;
+    }
+
+    // Batches are flushed when full, so every pending block was written.
+    mPending.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Decompress the blocks of a batch.
+class DecompressBlocksBody : public ParallelForBody
+{
+public:
+    DecompressBlocksBody( Compression::Codec pCodec, Vector<CompressedInputStream::Block>& pBlocks, Byte* pDest )
+        : mCodec(pCodec)
+        , mBlocks(pBlocks)
+        , mDest(pDest)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+        {
+            CompressedInputStream::Block& block = mBlocks[i];
+            Byte* dest = mDest + block.mDestOffset;
+
+            if( block.mStoredSize == block.mRawSize )
+            {
+                memcpy( dest, block.mData, block.mRawSize );
+                block.mValid = true;
+            }
+            else
+            {
+                block.mValid = Compression::Decompress( mCodec, block.mData, block.mStoredSize, dest, block.mRawSize );
+            }
+        }
+    }
+
+private:
+    Compression::Codec                      mCodec;
+    Vector<CompressedInputStream::Block>&   mBlocks;
+    Byte*                                   mDest;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressedInputStream
+CompressedInputStream::CompressedInputStream( Stream& pStream )
+    : mStream(&pStream)
+    , mData(NULL)
+    , mDataSize(0)
+    , mSize(0)
+    , mPos(0)
+    , mDataPos(0)
+    , mFrameStoredSize(0)
+    , mFrameRawSize(0)
+    , mFramePeeked(false)
+    , mEnded(false)
+    , mDecodedPos(0)
+{
+    GD_ASSERT( mStream->In() );
+    ReadHeader();
+}
+
+CompressedInputStream::CompressedInputStream( const Byte* pData, UInt32 pSize )
+    : mStream(NULL)
+    , mData(pData)
+    , mDataSize(pSize)
+    , mSize(0)
+    , mPos(0)
+    , mDataPos(0)
+    , mFrameStoredSize(0)
+    , mFrameRawSize(0)
+    , mFramePeeked(false)
+    , mEnded(false)
+    , mDecodedPos(0)
+{
+    ReadHeader();
+    if( !mIsValid )
+        return;
+
+    // Seek index.
+    if( mDataSize < COMPRESSED_HEADER_SIZE + COMPRESSED_TRAILER_SIZE + 3 * sizeof(UInt32) )
+    {
+        SetCorrupted( "Compressed stream is truncated" );
+        return;
+    }
+
+    if( ReadUInt32(mData + mDataSize - sizeof(UInt32)) != COMPRESSED_INDEX_MAGIC )
+    {
+        SetCorrupted( "Compressed stream has no seek index" );
+        return;
+    }
+    
+    UInt32 indexOffset = ReadUInt32( mData + mDataSize - COMPRESSED_TRAILER_SIZE );
+    if( indexOffset > mDataSize - COMPRESSED_TRAILER_SIZE - 2 * sizeof(UInt32) )
+    {
+        SetCorrupted( "Compressed stream seek index is corrupted" );
+        return;
+    }
+
+    UInt32 nbBlocks = ReadUInt32( mData + indexOffset );
+    if( nbBlocks > (mDataSize - COMPRESSED_TRAILER_SIZE - indexOffset) / sizeof(UInt32) - 2 )
+    {
+        SetCorrupted( "Compressed stream seek index is corrupted" );
+        return;
+    }
+
+    mFrameOffsets.resize( nbBlocks );
+    if( nbBlocks )
+        memcpy( &mFrameOffsets[0], mData + indexOffset + sizeof(UInt32), nbBlocks * sizeof(UInt32) );
+    mSize = ReadUInt32( mData + indexOffset + (nbBlocks + 1) * sizeof(UInt32) );
+}
+
+void CompressedInputStream::ReadHeader()
+{
+    UInt32 magic, version, codec;
+    mCodec = Compression::Codec_None;
+    mBlockSize = 0;
+
+    if( mStream )
+    {
+        (*mStream) << magic << version << codec << mBlockSize;
+        mIsValid = mStream->IsValid();
+    }
+    else
+    {
+        if( mDataSize < COMPRESSED_HEADER_SIZE )
+        {
+            SetCorrupted( "Compressed stream is truncated" );
+            return;
+        }
+
+        magic       = ReadUInt32( mData );
+        version     = ReadUInt32( mData + 4 );
+        codec       = ReadUInt32( mData + 8 );
+        mBlockSize  = ReadUInt32( mData + 12 );
+        mDataPos    = COMPRESSED_HEADER_SIZE;
+        mIsValid    = true;
+    }
+
+    if( !mIsValid )
+        return;
+
+    if( magic != COMPRESSED_STREAM_MAGIC )
+        SetCorrupted( "Not a compressed stream" );
+    else if( version != COMPRESSED_STREAM_VERSION )
+        SetCorrupted( "Unsupported compressed stream version" );
+    else if( codec != Compression::Codec_None && codec != Compression::Codec_LZ4 )
+        SetCorrupted( "Unsupported compression codec" );
+    else if( mBlockSize == 0 || mBlockSize > COMPRESSED_MAX_BLOCK_SIZE )
+        SetCorrupted( "Compressed stream is corrupted" );
+
+    mCodec = (Compression::Codec)codec;
+}
+
+void CompressedInputStream::Serialize( void* pData, UInt32 pLen )
+{
+    Byte* dest = (Byte*)pData;
+
+    while( pLen > 0 )
+    {
+        // Nothing valid can be read from a corrupted stream.
+        if( !mIsValid )
+        {
+            memset( dest, 0, pLen );
+            return;
+        }
+
+        // Data left in the current block.
+        if( mDecodedPos < mDecoded.size() )
+        {
+            UInt32 size = Maths::Min( pLen, (UInt32)mDecoded.size() - mDecodedPos );
+            memcpy( dest, &mDecoded[mDecodedPos], size );
+            mDecodedPos += size;
+            mPos += size;
+            dest += size;
+            pLen -= size;
+            continue;
+        }
+
+        Vector<Block> blocks;
+
+        // Whole blocks are decompressed directly in the destination.
+        if( pLen >= mBlockSize )
+        {
+            FetchBlocks( Maths::Min( pLen / mBlockSize, COMPRESSED_BATCH_BLOCKS ), pLen, blocks );
+            if( !blocks.empty() )
+            {
+                if( !DecompressBlocks( blocks, dest ) )
+                    continue;
+                
+                UInt32 size = blocks.back().mDestOffset + blocks.back().mRawSize;
+                mPos += size;
+                dest += size;
+                pLen -= size;
+                continue;
+            }
+        }
+
+        // Partial block.
+        FetchBlocks( 1, 0xFFFFFFFF, blocks );
+        if( blocks.empty() )
+        {
+            if( mIsValid )
+                SetCorrupted( "Reading past the end of a compressed stream" );
+            continue;
+        }
+
+        mDecoded.resize( blocks[0].mRawSize );
+        mDecodedPos = 0;
+        if( !DecompressBlocks( blocks, &mDecoded[0] ) )
+            mDecoded.clear();
+    }
+}
+
+UInt32 CompressedInputStream::Size() const
+{
+    return mSize;
+}
+
+UInt32 CompressedInputStream::Pos() const
+{
+    return mPos;
+}
+
+Bool CompressedInputStream::Seek( UInt32 pPos )
+{
+    if( mStream != NULL || !mIsValid || pPos > mSize )
+        return false;
+
+    UInt32 block = pPos / mBlockSize;
+
+    mDecoded.clear();
+    mDecodedPos = 0;
+    mFramePeeked = false;
+    mEnded = block >= mFrameOffsets.size();
+    mPos = pPos;
+    if( mEnded )
+        return true;
+
+    mDataPos = mFrameOffsets[block];
+    if( mDataPos >= mDataSize )
+    {
+        SetCorrupted( "Compressed stream seek index is corrupted" );
+        return false;
+    }
+
+    // Position inside a block, decode it.
+    UInt32 offset = pPos % mBlockSize;
+    if( offset )
+    {
+        Vector<Block> blocks;
+        FetchBlocks( 1, 0xFFFFFFFF, blocks );
+        if( blocks.size() != 1 || offset > blocks[0].mRawSize )
+        {
+            SetCorrupted( "Compressed stream seek index is corrupted" );
+            return false;
+        }
+
+        mDecoded.resize( blocks[0].mRawSize );
+        if( !DecompressBlocks( blocks, &mDecoded[0] ) )
+        {
+            mDecoded.clear();
+            return false;
+        }
+        mDecodedPos = offset;
+    }
+
+    return true;
+}
+
+Compression::Codec CompressedInputStream::GetCodec() const
+{
+    return mCodec;
+}
+
+Bool CompressedInputStream::PeekFrame( UInt32& pStoredSize, UInt32& pRawSize )
+{
+    if( !mFramePeeked )
+    {
+        if( mEnded || !mIsValid )
+            return false;
+
+        if( mStream )
+        {
+            (*mStream) << mFrameStoredSize << mFrameRawSize;
+            if( !mStream->IsValid() )
+            {
+                SetCorrupted( "Compressed stream is truncated" );
+                return false;
+            }
+        }
+        else
+        {
+            if( mDataSize - mDataPos < 2 * sizeof(UInt32) )
+            {
+                SetCorrupted( "Compressed stream is truncated" );
+                return false;
+            }
+
+            mFrameStoredSize = ReadUInt32( mData + mDataPos );
+            mFrameRawSize = ReadUInt32( mData + mDataPos + sizeof(UInt32) );
+            mDataPos += 2 * sizeof(UInt32);
+        }
+
+        if( mFrameStoredSize == 0 && mFrameRawSize == 0 )
+        {
+            mEnded = true;
+            return false;
+        }
+
+        if( mFrameRawSize > mBlockSize || mFrameStoredSize > mFrameRawSize || mFrameStoredSize == 0 )
+        {
+            SetCorrupted( "Compressed stream is corrupted" );
+            return false;
+        }
+
+        mFramePeeked = true;
+    }
+
+    pStoredSize = mFrameStoredSize;
+    pRawSize = mFrameRawSize;
+    return true;
+}
+
+void CompressedInputStream::FetchBlocks( UInt32 pMaxBlocks, UInt32 pMaxRawSize, Vector<Block>& pBlocks )
+{
+    pBlocks.clear();
+    if( mStream )
+        mCompressed.clear();
+
+    Vector<UInt32> offsets;
+    UInt32 rawSize = 0;
+    UInt32 storedSize;
+    UInt32 blockRawSize;
+    while( pBlocks.size() < pMaxBlocks && PeekFrame( storedSize, blockRawSize ) && rawSize + blockRawSize <= pMaxRawSize )
+    {
+        mFramePeeked = false;
+
+        Block block;
+        block.mStoredSize = storedSize;
+        block.mRawSize = blockRawSize;
+        block.mDestOffset = rawSize;
+        block.mValid = false;
+
+        if( mStream )
+        {
+            // mCompressed may be reallocated by the next blocks, mData is set at the end.
+            UInt32 offset = (UInt32)mCompressed.size();
+            mCompressed.resize( offset + storedSize );
+            mStream->Serialize( &mCompressed[offset], storedSize );
+            if( !mStream->IsValid() )
+            {
+                SetCorrupted( "Compressed stream is truncated" );
+                break;
+            }
+
+            offsets.push_back( offset );
+            block.mData = NULL;
+        }
+        else
+        {
+            if( mDataSize - mDataPos < storedSize )
+            {
+                SetCorrupted( "Compressed stream is truncated" );
+                break;
+            }
+
+            block.mData = mData + mDataPos;
+            mDataPos += storedSize;
+        }
+
+        pBlocks.push_back( block );
+        rawSize += blockRawSize;
+    }
+
+    if( !mIsValid )
+    {
+        pBlocks.clear();
+        return;
+    }
+
+    if( mStream )
+    {
+        for( UInt32 i = 0; i < pBlocks.size(); i++ )
+            pBlocks[i].mData = &mCompressed[offsets[i]];
+    }
+}
+
+Bool CompressedInputStream::DecompressBlocks( Vector<Block>& pBlocks, Byte* pDest )
+{
+    DecompressBlocksBody body( mCodec, pBlocks, pDest );
+    JobManager::Instance()->ParallelFor( (UInt32)pBlocks.size(), 1, body );
+
+    for( UInt32 i = 0; i < pBlocks.size(); i++ )
+    {
+        if( !pBlocks[i].mValid )
+        {
+            SetCorrupted( "Compressed stream is corrupted" );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CompressedInputStream::SetCorrupted( const Char* pReason )
+{
+    Core::DebugOut( "CompressedInputStream: %s\n", pReason );
+    mIsValid = false;
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,187 @@
+/**
+ *  @file       CompressedStream.h
+ *  @brief      Streams compressed by independent blocks.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _COMPRESSED_STREAM_H_
+#define     _COMPRESSED_STREAM_H_
+
+
+#include "Stream/Stream.h"
+#include "Stream/Compression.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Compress the data written to another stream.
+ *  Data is cut in blocks compressed independently, batches of blocks are 
+ *  compressed in parallel by the JobManager. Close() must be called (or the
+ *  stream destroyed) before the underlying stream.
+ *
+ *  Format:
+ *  - Header: magic "GDCZ", version, codec, block size.
+ *  - One frame per block: stored size, raw size, data. Blocks that don't 
+ *    compress are stored as is (stored size == raw size).
+ *  - End frame: 0, 0.
+ *  - Seek index: block count, offset of each frame, total raw size.
+ *  - Trailer: offset of the seek index, magic "GDCI".
+ *
+ *  @brief  Stream compressed by independent blocks.
+ */
+class CORE_API CompressedOutputStream : public OutputStream
+{
+    CLASS_DISABLE_COPY(CompressedOutputStream);
+
+public:
+    static const UInt32 DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+public:
+    /**
+     *  Constructor.
+     *  @param  pStream     Stream receiving the compressed data.
+     *  @param  pCodec      Codec used to compress the blocks.
+     *  @param  pLevel      Compression level, see Compression.
+     *  @param  pBlockSize  Size of the uncompressed blocks.
+     */
+    CompressedOutputStream( Stream& pStream, Compression::Codec pCodec, Int32 pLevel = Compression::LEVEL_FAST, UInt32 pBlockSize = DEFAULT_BLOCK_SIZE );
+
+    //! Destructor, close the stream.
+    virtual ~CompressedOutputStream();
+
+    //! Compress the pending data and write the seek index.
+    Bool Close();
+
+    void Serialize( void* pData, UInt32 pLen );
+
+    //! Number of uncompressed bytes written.
+    UInt32 Pos() const;
+
+private:
+    //! Compress and write the complete blocks, and the last incomplete one if pAll.
+    void FlushBlocks( Bool pAll );
+
+private:
+    Stream&             mStream;
+    Compression::Codec  mCodec;
+    Int32               mLevel;
+    UInt32              mBlockSize;
+
+    Vector<Byte>        mPending;           //!< Data not compressed yet.
+    Vector<Byte>        mCompressed;        //!< Compressed blocks of the current batch.
+    Vector<UInt32>      mCompressedSizes;   //!< Compressed size of the blocks of the current batch.
+    Vector<UInt32>      mFrameOffsets;      //!< Seek index.
+    UInt32              mStreamPos;         //!< Bytes written to mStream.
+    UInt32              mPos;               //!< Uncompressed bytes written.
+    Bool                mClosed;
+};
+
+
+/**
+ *  Decompress data written by a CompressedOutputStream.
+ *  Reads covering whole blocks are decompressed in parallel, directly in the
+ *  destination. When reading from memory (ex. a MemoryFile) the seek index is
+ *  used to provide Size() and Seek().
+ *  A truncated or corrupted source makes the stream invalid (see IsValid()),
+ *  reads then return zeros and Seek() fails.
+ *  @brief  Stream compressed by independent blocks.
+ */
+class CORE_API CompressedInputStream : public InputStream
+{
+    CLASS_DISABLE_COPY(CompressedInputStream);
+
+public:
+    //! Read compressed data sequentially from another stream.
+    CompressedInputStream( Stream& pStream );
+
+    //! Read compressed data from memory, pData must stay valid.
+    CompressedInputStream( const Byte* pData, UInt32 pSize );
+
+    void Serialize( void* pData, UInt32 pLen );
+
+    //! Uncompressed size, only known when reading from memory (0 otherwise).
+    UInt32 Size() const;
+
+    //! Number of uncompressed bytes read.
+    UInt32 Pos() const;
+
+    //! Move to an uncompressed position, only available when reading from memory.
+    Bool Seek( UInt32 pPos );
+
+    Compression::Codec GetCodec() const;
+
+private:
+    friend class DecompressBlocksBody;
+
+    class Block
+    {
+    public:
+        const Byte* mData;
+        UInt32      mStoredSize;
+        UInt32      mRawSize;
+        UInt32      mDestOffset;    //!< Offset of the block in the destination buffer.
+        Bool        mValid;         //!< Set by the decompression.
+    };
+
+    void ReadHeader();
+
+    //! Read the header of the next frame without consuming it, false at the end of the stream.
+    Bool PeekFrame( UInt32& pStoredSize, UInt32& pRawSize );
+
+    //! Get the next blocks (at most pMaxBlocks), as long as their total raw size fits in pMaxRawSize.
+    void FetchBlocks( UInt32 pMaxBlocks, UInt32 pMaxRawSize, Vector<Block>& pBlocks );
+
+    //! Decompress the blocks in pDest, false (and the stream becomes invalid) if one of them is corrupted.
+    Bool DecompressBlocks( Vector<Block>& pBlocks, Byte* pDest );
+
+    //! Make the stream invalid.
+    void SetCorrupted( const Char* pReason );
+
+private:
+    Stream*             mStream;            //!< Source stream, NULL when reading from memory.
+    const Byte*         mData;              //!< Source memory.
+    UInt32              mDataSize;
+
+    Compression::Codec  mCodec;
+    UInt32              mBlockSize;
+    UInt32              mSize;              //!< Uncompressed size (memory only).
+    UInt32              mPos;
+
+    Vector<UInt32>      mFrameOffsets;      //!< Seek index (memory only).
+    UInt32              mDataPos;           //!< Position of the next frame in the source (memory only).
+    UInt32              mFrameStoredSize;   //!< Header of the peeked frame.
+    UInt32              mFrameRawSize;
+    Bool                mFramePeeked;
+    Bool                mEnded;             //!< End frame reached.
+
+    Vector<Byte>        mCompressed;        //!< Compressed data read from mStream.
+    Vector<Byte>        mDecoded;           //!< Current decompressed block.
+    UInt32              mDecodedPos;        //!< Read position in mDecoded.
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _COMPRESSED_STREAM_H_
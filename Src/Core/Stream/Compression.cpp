@@ -0,0 +1,379 @@
+/**
+ *  @file       Compression.cpp
+ *  @brief      Block compression codecs.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "Compression.h"
+#include "Maths/Maths.h"
+
+
+namespace Gamedesk {
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LZ4 block format, see http://lz4.github.io/lz4/
+static const UInt32 LZ4_MIN_MATCH       = 4;
+static const UInt32 LZ4_MF_LIMIT        = 12;       // A match can't start in the last 12 bytes.
+static const UInt32 LZ4_LAST_LITERALS   = 5;        // The last 5 bytes are always literals.
+static const UInt32 LZ4_MAX_DISTANCE    = 65535;
+static const UInt32 LZ4_NO_POSITION     = 0xFFFFFFFF;
+static const UInt32 LZ4_CHAIN_SIZE      = 65536;
+
+static inline UInt32 LZ4Read32( const Byte* pData )
+{
+    UInt32 value;
+    memcpy( &value, pData, sizeof(value) );
+    return value;
+}
+
+static inline UInt32 LZ4Hash( UInt32 pSequence, UInt32 pHashLog )
+{
+    return (pSequence * 2654435761U) >> (32 - pHashLog);
+}
+
+//! Number of bytes matching at pIn and pMatch, stopping at pInLimit.
+static inline UInt32 LZ4Count( const Byte* pIn, const Byte* pMatch, const Byte* pInLimit )
+{
+    const Byte* start = pIn;
+
+    while( pIn + 4 <= pInLimit && LZ4Read32(pIn) == LZ4Read32(pMatch) )
+    {
+        pIn    += 4;
+        pMatch += 4;
+    }
+
+    while( pIn < pInLimit && *pIn == *pMatch )
+    {
+        pIn++;
+        pMatch++;
+    }
+
+    return (UInt32)(pIn - start);
+}
+
+static inline Byte* LZ4WriteLength( Byte* pOut, UInt32 pLength )
+{
+    while( pLength >= 255 )
+    {
+        *pOut++ = 255;
+        pLength -= 255;
+    }
+
+    *pOut++ = (Byte)pLength;
+    return pOut;
+}
+
+//! Write literals followed by a match, pMatchLength is 0 for the last sequence.
+static Byte* LZ4WriteSequence( Byte* pOut, const Byte* pLiterals, UInt32 pLiteralLength, UInt32 pOffset, UInt32 pMatchLength )
+{
+    Byte* token = pOut++;
+
+    *token = (Byte)((pLiteralLength >= 15 ? 15 : pLiteralLength) << 4);
+    if( pLiteralLength >= 15 )
+        pOut = LZ4WriteLength( pOut, pLiteralLength - 15 );
+
+    memcpy( pOut, pLiterals, pLiteralLength );
+    pOut += pLiteralLength;
+
+    if( pMatchLength == 0 )
+        return pOut;
+
+    *pOut++ = (Byte)(pOffset);
+    *pOut++ = (Byte)(pOffset >> 8);
+
+    UInt32 length = pMatchLength - LZ4_MIN_MATCH;
+    *token |= (Byte)(length >= 15 ? 15 : length);
+    if( length >= 15 )
+        pOut = LZ4WriteLength( pOut, length - 15 );
+
+    return pOut;
+}
+
+static UInt32 LZ4Compress( Int32 pLevel, const Byte* pSource, UInt32 pSize, Byte* pDest )
+{
+    Byte*       out    = pDest;
+    const Byte* anchor = pSource;
+
+    if( pSize > LZ4_MF_LIMIT )
+    {
+        const Byte* ip          = pSource;
+        const Byte* searchLimit = pSource + pSize - LZ4_MF_LIMIT;
+        const Byte* matchLimit  = pSource + pSize - LZ4_LAST_LITERALS;
+
+        // The fast level keeps the last position of each hash, others chain the 
+        // previous positions sharing the same hash.
+        Bool    chained     = pLevel > Compression::LEVEL_FAST;
+        UInt32  hashLog     = chained ? 15 : 12;
+        UInt32  maxAttempts = chained ? 1 << (Maths::Min(pLevel, Compression::LEVEL_MAX) - 1) : 1;
+        UInt32  nextInsert  = 0;
+        UInt32  misses      = 0;
+
+        Vector<UInt32> head;
+        Vector<UInt16> chain;
+        head.assign( 1 << hashLog, LZ4_NO_POSITION );
+        if( chained )
+            chain.assign( LZ4_CHAIN_SIZE, 0 );
+
+        while( ip <= searchLimit )
+        {
+            UInt32 pos          = (UInt32)(ip - pSource);
+            UInt32 bestLength   = 0;
+            UInt32 bestOffset   = 0;
+
+            if( chained )
+            {
+                // Add the positions skipped by the previous match.
+                for( ; nextInsert < pos; nextInsert++ )
+                {
+                    UInt32  hash     = LZ4Hash( LZ4Read32(pSource + nextInsert), hashLog );
+                    UInt32  previous = head[hash];
+                    UInt32  delta    = previous == LZ4_NO_POSITION ? 0 : nextInsert - previous;
+
+                    chain[nextInsert & (LZ4_CHAIN_SIZE - 1)] = (UInt16)(delta > LZ4_MAX_DISTANCE ? 0 : delta);
+                    head[hash] = nextInsert;
+                }
+
+                UInt32 sequence  = LZ4Read32( ip );
+                UInt32 candidate = head[LZ4Hash(sequence, hashLog)];
+                for( UInt32 attempt = 0; attempt < maxAttempts && candidate != LZ4_NO_POSITION && pos - candidate <= LZ4_MAX_DISTANCE; attempt++ )
+                {
+                    const Byte* match = pSource + candidate;
+                    if( match[bestLength] == ip[bestLength] && LZ4Read32(match) == sequence )
+                    {
+                        UInt32 length = LZ4_MIN_MATCH + LZ4Count( ip + LZ4_MIN_MATCH, match + LZ4_MIN_MATCH, matchLimit );
+                        if( length > bestLength )
+                        {
+                            bestLength = length;
+                            bestOffset = pos - candidate;
+                        }
+                    }
+
+                    UInt32 delta = chain[candidate & (LZ4_CHAIN_SIZE - 1)];
+                    if( delta == 0 || delta > candidate )
+                        break;
+
+                    candidate -= delta;
+                }
+            }
+            else
+            {
+                UInt32  sequence  = LZ4Read32( ip );
+                UInt32  hash      = LZ4Hash( sequence, hashLog );
+                UInt32  candidate = head[hash];
+                head[hash] = pos;
+
+                if( candidate != LZ4_NO_POSITION && pos - candidate <= LZ4_MAX_DISTANCE && LZ4Read32(pSource + candidate) == sequence )
+                {
+                    bestLength = LZ4_MIN_MATCH + LZ4Count( ip + LZ4_MIN_MATCH, pSource + candidate + LZ4_MIN_MATCH, matchLimit );
+                    bestOffset = pos - candidate;
+                }
+            }
+
+            if( bestLength == 0 )
+            {
+                // Skip faster through data that doesn't compress.
+                ip += chained ? 1 : 1 + (misses++ >> 6);
+                continue;
+            }
+
+            misses = 0;
+
+            // Extend the match backward over the pending literals.
+            const Byte* match = ip - bestOffset;
+            while( ip > anchor && match > pSource && ip[-1] == match[-1] )
+            {
+                ip--;
+                match--;
+                bestLength++;
+            }
+
+            out = LZ4WriteSequence( out, anchor, (UInt32)(ip - anchor), bestOffset, bestLength );
+
+            ip    += bestLength;
+            anchor = ip;
+
+            // Position inside the match, helps the next search.
+            if( !chained && ip <= searchLimit )
+                head[LZ4Hash( LZ4Read32(ip - 2), hashLog )] = (UInt32)(ip - 2 - pSource);
+        }
+    }
+
+    out = LZ4WriteSequence( out, anchor, (UInt32)(pSource + pSize - anchor), 0, 0 );
+
+    return (UInt32)(out - pDest);
+}
+
+static inline Bool LZ4ReadLength( const Byte*& pIn, const Byte* pInEnd, UInt32& pLength )
+{
+    Byte value;
+    do
+    {
+        if( pIn >= pInEnd )
+            return false;
+
+        value = *pIn++;
+        pLength += value;
+    } while( value == 255 );
+
+    return true;
+}
+
+static Bool LZ4Decompress( const Byte* pSource, UInt32 pSourceSize, Byte* pDest, UInt32 pDestSize )
+{
+    const Byte* ip      = pSource;
+    const Byte* ipEnd   = pSource + pSourceSize;
+    Byte*       op      = pDest;
+    Byte*       opEnd   = pDest + pDestSize;
+
+    while( ip < ipEnd )
+    {
+        UInt32 token = *ip++;
+
+        UInt32 literalLength = token >> 4;
+        if( literalLength == 15 && !LZ4ReadLength( ip, ipEnd, literalLength ) )
+            return false;
+
+        if( literalLength <= 16 && ipEnd - ip >= 16 && opEnd - op >= 16 )
+        {
+            // Short literals, copy a fixed size: the extra bytes are overwritten next.
+            memcpy( op, ip, 16 );
+        }
+        else
+        {
+            if( literalLength > (UInt32)(ipEnd - ip) || literalLength > (UInt32)(opEnd - op) )
+                return false;
+
+            memcpy( op, ip, literalLength );
+        }
+        op += literalLength;
+        ip += literalLength;
+
+        // The last sequence has no match.
+        if( ip == ipEnd )
+            break;
+
+        if( ipEnd - ip < 2 )
+            return false;
+
+        UInt32 offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if( offset == 0 || offset > (UInt32)(op - pDest) )
+            return false;
+
+        UInt32 matchLength = token & 15;
+        if( matchLength == 15 && !LZ4ReadLength( ip, ipEnd, matchLength ) )
+            return false;
+
+        matchLength += LZ4_MIN_MATCH;
+        if( matchLength > (UInt32)(opEnd - op) )
+            return false;
+
+        const Byte* match = op - offset;
+        if( offset >= 8 )
+        {
+            // Copy 8 bytes at a time, the source is always far enough behind.
+            Byte* copyEnd = op + matchLength;
+            if( opEnd - copyEnd >= 8 )
+            {
+                // Room to overshoot, the extra bytes are overwritten next.
+                do
+                {
+                    memcpy( op, match, 8 );
+                    op    += 8;
+                    match += 8;
+                } while( op < copyEnd );
+
+                op = copyEnd;
+            }
+            else
+            {
+                while( op + 8 <= copyEnd )
+                {
+                    memcpy( op, match, 8 );
+                    op    += 8;
+                    match += 8;
+                }
+
+                while( op < copyEnd )
+                    *op++ = *match++;
+            }
+        }
+        else
+        {
+            // Overlapping copy, repeats the last offset bytes.
+            for( UInt32 i = 0; i < matchLength; i++ )
+                *op++ = *match++;
+        }
+    }
+
+    return op == opEnd;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Compression
+const Int32 Compression::LEVEL_FAST;
+const Int32 Compression::LEVEL_MAX;
+
+UInt32 Compression::GetMaxCompressedSize( UInt32 pSize )
+{
+    return pSize + pSize / 255 + 16;
+}
+
+UInt32 Compression::Compress( Codec pCodec, Int32 pLevel, const Byte* pSource, UInt32 pSize, Byte* pDest )
+{
+    switch( pCodec )
+    {
+    case Codec_LZ4:
+        return LZ4Compress( pLevel, pSource, pSize, pDest );
+
+    case Codec_None:
+    default:
+        memcpy( pDest, pSource, pSize );
+        return pSize;
+    }
+}
+
+Bool Compression::Decompress( Codec pCodec, const Byte* pSource, UInt32 pSourceSize, Byte* pDest, UInt32 pDestSize )
+{
+    switch( pCodec )
+    {
+    case Codec_LZ4:
+        return LZ4Decompress( pSource, pSourceSize, pDest, pDestSize );
+
+    case Codec_None:
+        if( pSourceSize != pDestSize )
+            return false;
+
+        memcpy( pDest, pSource, pDestSize );
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+} // namespace Gamedesk
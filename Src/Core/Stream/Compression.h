@@ -0,0 +1,84 @@
+/**
+ *  @file       Compression.h
+ *  @brief      Block compression codecs.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _COMPRESSION_H_
+#define     _COMPRESSION_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Compress independent blocks of memory.
+ *  Codec_LZ4 produces the standard LZ4 block format (http://lz4.github.io/lz4/),
+ *  it's implemented here so that no external library is needed. Level 1 is the
+ *  fast single probe compressor, higher levels search hash chains of up to 
+ *  2^(level-1) candidates: slower compression, same decompression speed.
+ *  @brief  Block compression codecs.
+ */
+class CORE_API Compression
+{
+public:
+    enum Codec
+    {
+        Codec_None  = 0,    //!< Data is stored as is.
+        Codec_LZ4   = 1
+    };
+
+    static const Int32  LEVEL_FAST  = 1;
+    static const Int32  LEVEL_MAX   = 12;
+
+public:
+    //! Size of the buffer needed to compress pSize bytes, in the worst case.
+    static UInt32 GetMaxCompressedSize( UInt32 pSize );
+
+    /**
+     *  Compress a block of memory.
+     *  @param  pCodec      Codec to use.
+     *  @param  pLevel      Compression level, from LEVEL_FAST to LEVEL_MAX.
+     *  @param  pSource     Data to compress.
+     *  @param  pSize       Size of pSource.
+     *  @param  pDest       Receives the compressed data, must hold GetMaxCompressedSize(pSize) bytes.
+     *  @return The size of the compressed data.
+     */
+    static UInt32 Compress( Codec pCodec, Int32 pLevel, const Byte* pSource, UInt32 pSize, Byte* pDest );
+
+    /**
+     *  Decompress a block of memory.
+     *  @param  pCodec      Codec used to compress the block.
+     *  @param  pSource     Compressed data.
+     *  @param  pSourceSize Size of pSource.
+     *  @param  pDest       Receives the decompressed data.
+     *  @param  pDestSize   Size of the decompressed data.
+     *  @return False if the compressed data is corrupted.
+     */
+    static Bool Decompress( Codec pCodec, const Byte* pSource, UInt32 pSourceSize, Byte* pDest, UInt32 pDestSize );
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _COMPRESSION_H_
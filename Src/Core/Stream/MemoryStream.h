@@ -0,0 +1,111 @@
+/**
+ *  @file       MemoryStream.h
+ *  @brief      Streams reading from and writing to memory.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _MEMORY_STREAM_H_
+#define     _MEMORY_STREAM_H_
+
+
+#include "Stream/Stream.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Append the data written to a buffer.
+ *  @brief  Stream writing to memory.
+ */
+class CORE_API MemoryOutputStream : public OutputStream
+{
+    CLASS_DISABLE_COPY(MemoryOutputStream);
+
+public:
+    MemoryOutputStream( Vector<Byte>& pBuffer )
+        : mBuffer(pBuffer)
+    {
+        mIsValid = true;
+    }
+
+    void Serialize( void* pData, UInt32 pLen )
+    {
+        const Byte* data = (const Byte*)pData;
+        mBuffer.insert( mBuffer.end(), data, data + pLen );
+    }
+
+    UInt32 Pos() const
+    {
+        return mBuffer.size();
+    }
+
+private:
+    Vector<Byte>&   mBuffer;
+};
+
+
+/**
+ *  Read data from memory, pData must stay valid.
+ *  @brief  Stream reading from memory.
+ */
+class CORE_API MemoryInputStream : public InputStream
+{
+    CLASS_DISABLE_COPY(MemoryInputStream);
+
+public:
+    MemoryInputStream( const Byte* pData, UInt32 pSize )
+        : mData(pData)
+        , mSize(pSize)
+        , mPos(0)
+    {
+        mIsValid = true;
+    }
+
+    void Serialize( void* pData, UInt32 pLen )
+    {
+        GD_ASSERT_M( mPos + pLen <= mSize, "Reading past the end of a memory stream!" );
+        memcpy( pData, mData + mPos, pLen );
+        mPos += pLen;
+    }
+
+    UInt32 Size() const
+    {
+        return mSize;
+    }
+
+    UInt32 Pos() const
+    {
+        return mPos;
+    }
+
+private:
+    const Byte*     mData;
+    UInt32          mSize;
+    UInt32          mPos;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _MEMORY_STREAM_H_
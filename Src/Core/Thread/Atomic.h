@@ -0,0 +1,112 @@
+/**
+ *  @file       Atomic.h
+ *  @brief      Atomic integer operations.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _ATOMIC_H_
+#define     _ATOMIC_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  32 bits integer that can be safely modified from multiple threads.
+ *  All operations are full memory barriers.
+ */
+class AtomicInt32
+{
+public:
+    AtomicInt32( Int32 pValue = 0 ) : mValue(pValue)
+    {
+    }
+
+    //! Increment the value and return the new value.
+    Int32 Increment()
+    {
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+        return ::InterlockedIncrement( (volatile LONG*)&mValue );
+#else
+        return __sync_add_and_fetch( &mValue, 1 );
+#endif
+    }
+
+    //! Decrement the value and return the new value.
+    Int32 Decrement()
+    {
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+        return ::InterlockedDecrement( (volatile LONG*)&mValue );
+#else
+        return __sync_sub_and_fetch( &mValue, 1 );
+#endif
+    }
+
+    //! Add pAmount to the value and return the value it had before the addition.
+    Int32 FetchAdd( Int32 pAmount )
+    {
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+        return ::InterlockedExchangeAdd( (volatile LONG*)&mValue, pAmount );
+#else
+        return __sync_fetch_and_add( &mValue, pAmount );
+#endif
+    }
+
+    //! Set the value to pExchange if it is equal to pComparand, return the previous value.
+    Int32 CompareExchange( Int32 pExchange, Int32 pComparand )
+    {
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+        return ::InterlockedCompareExchange( (volatile LONG*)&mValue, pExchange, pComparand );
+#else
+        return __sync_val_compare_and_swap( &mValue, pComparand, pExchange );
+#endif
+    }
+
+    //! Set the value and return the previous one.
+    Int32 Exchange( Int32 pValue )
+    {
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+        return ::InterlockedExchange( (volatile LONG*)&mValue, pValue );
+#else
+        return __sync_lock_test_and_set( &mValue, pValue );
+#endif
+    }
+
+    Int32 Get() const
+    {
+        return mValue;
+    }
+
+    void Set( Int32 pValue )
+    {
+        Exchange( pValue );
+    }
+
+private:
+    volatile Int32  mValue;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _ATOMIC_H_
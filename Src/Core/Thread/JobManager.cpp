@@ -0,0 +1,229 @@
+/**
+ *  @file       JobManager.cpp
+ *  @brief      Pool of worker threads executing small jobs.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Core.h"
+#include "Thread/JobManager.h"
+#include "Thread/Thread.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Maths/Maths.h"
+#include "Debug/PerformanceMonitor.h"
+
+
+namespace Gamedesk {
+
+
+IMPLEMENT_SINGLETON(JobManager);
+
+
+static const UInt32 MAX_QUEUED_JOBS = 0x7FFFFFFF;
+
+
+class JobManager::Worker : public Thread
+{
+public:
+    Worker( JobManager& pManager ) : mManager(pManager)
+    {
+    }
+
+    virtual void Run()
+    {
+#if GD_CFG_USE_PERF_MONITOR == GD_ENABLED
+        Profiler::SetThreadName( "JobManager::Worker" );
+#endif
+
+        for(;;)
+        {
+            mManager.mJobAvailable.Lock();
+
+            if( mManager.mQuit )
+                break;
+
+            Profile("Job");
+            mManager.ExecuteNextJob();
+        }
+    }
+
+private:
+    JobManager&     mManager;
+};
+
+
+/**
+ *  Job used by ParallelFor() to process one chunk of the range.
+ */
+class ParallelForJob : public Job
+{
+public:
+    ParallelForJob() : mBody(NULL), mBegin(0), mEnd(0)
+    {
+    }
+
+    virtual void Execute()
+    {
+        mBody->Execute( mBegin, mEnd );
+    }
+
+    ParallelForBody*    mBody;
+    UInt32              mBegin;
+    UInt32              mEnd;
+};
+
+
+JobManager::JobManager()
+    : mJobAvailable(0, MAX_QUEUED_JOBS)
+    , mQuit(false)
+{
+}
+
+JobManager::~JobManager()
+{
+    Kill();
+}
+
+void JobManager::Init( Int32 pWorkerCount )
+{
+    GD_ASSERT_M( mWorkers.empty(), "[JobManager::Init] Already initialized!" );
+
+    if( pWorkerCount < 0 )
+        pWorkerCount = SystemInfo::Instance()->GetNumCpu() - 1;
+
+    mQuit = false;
+
+    for( Int32 i = 0; i < pWorkerCount; i++ )
+    {
+        Worker* worker = GD_NEW(Worker, this, "Core::Thread::JobManager::Worker")(*this);
+        worker->Start( Thread::PriorityNormal, 64*1024 );
+        mWorkers.push_back( worker );
+    }
+}
+
+void JobManager::Kill()
+{
+    if( mWorkers.empty() )
+        return;
+
+    mQuit = true;
+
+    for( UInt32 i = 0; i < mWorkers.size(); i++ )
+        mJobAvailable.Unlock();
+
+    for( UInt32 i = 0; i < mWorkers.size(); i++ )
+    {
+        mWorkers[i]->WaitUntilStopped();
+        GD_DELETE(mWorkers[i]);
+    }
+
+    mWorkers.clear();
+
+    // Execute what could have been left by the workers.
+    while( ExecuteNextJob() );
+}
+
+UInt32 JobManager::GetWorkerCount() const
+{
+    return mWorkers.size();
+}
+
+void JobManager::Submit( Job* pJob, JobGroup& pGroup )
+{
+    QueuedJob queuedJob;
+    queuedJob.mJob   = pJob;
+    queuedJob.mGroup = &pGroup;
+
+    pGroup.mPending.Increment();
+
+    mQueueMutex.Lock();
+    mQueue.push_back( queuedJob );
+    mQueueMutex.Unlock();
+
+    if( !mWorkers.empty() )
+        mJobAvailable.Unlock();
+}
+
+void JobManager::Wait( JobGroup& pGroup )
+{
+    while( !pGroup.IsDone() )
+    {
+        // Help the workers instead of blocking.
+        if( !ExecuteNextJob() )
+            Thread::Sleep(0);
+    }
+}
+
+Bool JobManager::ExecuteNextJob()
+{
+    QueuedJob queuedJob;
+
+    mQueueMutex.Lock();
+    if( mQueue.empty() )
+    {
+        mQueueMutex.Unlock();
+        return false;
+    }
+
+    queuedJob = mQueue.front();
+    mQueue.pop_front();
+    mQueueMutex.Unlock();
+
+    queuedJob.mJob->Execute();
+    queuedJob.mGroup->mPending.Decrement();
+
+    return true;
+}
+
+void JobManager::ParallelFor( UInt32 pCount, UInt32 pGrainSize, ParallelForBody& pBody )
+{
+    if( pCount == 0 )
+        return;
+
+    if( pGrainSize == 0 )
+        pGrainSize = 1;
+
+    // Not worth scheduling anything.
+    if( mWorkers.empty() || pCount <= pGrainSize )
+    {
+        pBody.Execute( 0, pCount );
+        return;
+    }
+
+    UInt32 numChunks = (pCount + pGrainSize - 1) / pGrainSize;
+
+    Vector<ParallelForJob> jobs;
+    jobs.resize( numChunks );
+
+    JobGroup group;
+    for( UInt32 i = 0; i < numChunks; i++ )
+    {
+        jobs[i].mBody  = &pBody;
+        jobs[i].mBegin = i * pGrainSize;
+        jobs[i].mEnd   = Maths::Min( jobs[i].mBegin + pGrainSize, pCount );
+        Submit( &jobs[i], group );
+    }
+
+    Wait( group );
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,155 @@
+/**
+ *  @file       JobManager.h
+ *  @brief      Pool of worker threads executing small jobs.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _JOB_MANAGER_H_
+#define     _JOB_MANAGER_H_
+
+
+#include "Patterns/Singleton.h"
+#include "Thread/Atomic.h"
+#include "Thread/Mutex.h"
+#include "Thread/Semaphore.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Unit of work executed by the JobManager. A job must not touch the renderer
+ *  or any other object that is not thread safe.
+ */
+class CORE_API Job
+{
+public:
+    virtual ~Job() {}
+
+    //! Called from a worker thread (or from the thread waiting on the job group).
+    virtual void Execute() = 0;
+};
+
+
+/**
+ *  Counts the jobs that are still pending, used to wait for a batch of jobs.
+ */
+class CORE_API JobGroup
+{
+    friend class JobManager;
+
+public:
+    JobGroup() : mPending(0)
+    {
+    }
+
+    //! Returns true once every job submitted with this group has been executed.
+    Bool IsDone() const
+    {
+        return mPending.Get() == 0;
+    }
+
+private:
+    AtomicInt32     mPending;
+};
+
+
+/**
+ *  Body of a JobManager::ParallelFor() loop. Execute() is called once per chunk
+ *  of the iteration range, possibly from several threads at the same time.
+ */
+class CORE_API ParallelForBody
+{
+public:
+    virtual ~ParallelForBody() {}
+
+    //! Process the items in [pBegin, pEnd).
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd ) = 0;
+};
+
+
+/**
+ *  Manage a pool of worker threads to which jobs can be submitted. When the
+ *  manager has no worker (not initialized or initialized with 0 worker), jobs
+ *  are executed by the thread waiting on them, so callers don't need to
+ *  special case single threaded configurations.
+ */
+class CORE_API JobManager
+{
+    DECLARE_SINGLETON(JobManager);
+
+public:
+    /**
+     *  Start the worker threads.
+     *  @param  pWorkerCount    Number of workers, -1 to use one worker per cpu
+     *                          (minus the calling thread).
+     */
+    void Init( Int32 pWorkerCount = -1 );
+
+    //! Stop and destroy the worker threads.
+    void Kill();
+
+    //! Number of worker threads (not counting the calling thread).
+    UInt32 GetWorkerCount() const;
+
+    //! Queue a job. pJob must stay alive until pGroup is done.
+    void Submit( Job* pJob, JobGroup& pGroup );
+
+    //! Wait until every job of pGroup has been executed, helping to execute queued jobs meanwhile.
+    void Wait( JobGroup& pGroup );
+
+    /**
+     *  Split [0, pCount) in chunks of pGrainSize items and execute them in parallel.
+     *  Return once every chunk has been processed.
+     */
+    void ParallelFor( UInt32 pCount, UInt32 pGrainSize, ParallelForBody& pBody );
+
+private:
+    JobManager();
+    ~JobManager();
+
+    //! Pop a job from the queue and execute it, return false if the queue was empty.
+    Bool ExecuteNextJob();
+
+private:
+    class Worker;
+    friend class Worker;
+
+    struct QueuedJob
+    {
+        Job*        mJob;
+        JobGroup*   mGroup;
+    };
+
+    List<QueuedJob>     mQueue;
+    Mutex               mQueueMutex;
+    Semaphore           mJobAvailable;
+
+    Vector<Worker*>     mWorkers;
+    volatile Bool       mQuit;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _JOB_MANAGER_H_
@@ -36,6 +36,7 @@ class CORE_API Semaphore
 {
 public:
     Semaphore(UInt32 pMaxCount = 1);
+    Semaphore(UInt32 pInitialCount, UInt32 pMaxCount);
     ~Semaphore();
 
     void Lock();
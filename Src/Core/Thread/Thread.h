@@ -30,6 +30,7 @@
 
 
 #include "Thread/Event.h"
+#include "Debug/PerformanceMonitor.h"
 
 
 namespace Gamedesk {
@@ -60,6 +61,12 @@ public:
     inline Handle  GetHandle() const;
     inline UInt32  GetId() const;
 
+    //! Give up the remaining of the calling thread's time slice for at least pMilliseconds.
+    static void    Sleep(UInt32 pMilliseconds);
+
+    //! Return the id of the calling thread.
+    static UInt32  GetCurrentId();
+
 private:
     static unsigned int WINAPI Win32ThreadEntryPoint(void* pParam);
 
@@ -110,6 +117,10 @@ void Thread::EntryPoint()
 
     Run();
 
+#if GD_CFG_USE_PERF_MONITOR == GD_ENABLED
+    Profiler::ReleaseThread();
+#endif
+
     mStopEvent.SetDone();
 }
 
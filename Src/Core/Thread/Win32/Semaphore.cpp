@@ -38,6 +38,12 @@ Semaphore::Semaphore(UInt32 pMaxCount)
     GD_ASSERT(mSemaphore);
 }
 
+Semaphore::Semaphore(UInt32 pInitialCount, UInt32 pMaxCount)
+{
+    mSemaphore = ::CreateSemaphore(NULL, pInitialCount, pMaxCount, NULL);
+    GD_ASSERT(mSemaphore);
+}
+
 Semaphore::~Semaphore()
 {
     ::CloseHandle(mSemaphore);
@@ -53,6 +53,16 @@ void Thread::Start(Priority pPriority, UInt32 stackSize)
     ::ResumeThread(mHandle);
 }
 
+void Thread::Sleep(UInt32 pMilliseconds)
+{
+    ::Sleep(pMilliseconds);
+}
+
+UInt32 Thread::GetCurrentId()
+{
+    return ::GetCurrentThreadId();
+}
+
 unsigned int WINAPI Thread::Win32ThreadEntryPoint(void* pParam)
 {
     Thread* thread = (Thread*)pParam;
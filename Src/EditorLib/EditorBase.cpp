@@ -75,6 +75,8 @@ EditorBase::~EditorBase()
     Core::DebugOut( "############################################\n" );
     Core::DebugOut( "Profiling results (~%d Mhz)\n", SystemInfo::Instance()->GetCpuFrequency() / 1000 );
 
+    Profiler::Collect();
+
 	for (tree<PerformanceStats>::iterator itr = PerformanceMonitor::mStats.begin(); itr != PerformanceMonitor::mStats.end(); ++itr)
 	{
 		for( Int32 i = 0; i < PerformanceMonitor::mStats.depth(itr) * 4; i++ )
@@ -387,6 +389,8 @@ void EditorBase::OnTick()
     }
     }
 
+    ProfileFrame();
+
     mLastTime = mTime;
 }
 
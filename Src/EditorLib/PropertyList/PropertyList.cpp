@@ -2,22 +2,74 @@
 #include "PropertyList.h"
 #include "PropertyHelper.h"
 
+#include "Stream/MemoryStream.h"
 #include "World/Entity.h"
 
 
 QPropertyModel::QPropertyModel(QObject* parent)
     : QAbstractItemModel(parent)
     , mEdited(NULL)
+    , mChanged(NULL)
 {
 }
 
 QPropertyModel::~QPropertyModel()
 {
+    GD_DELETE_ARRAY(mChanged);
 }
 
 void QPropertyModel::SetEdited(Object* pEdited)
 {
     mEdited = pEdited;
+
+    GD_DELETE_ARRAY(mChanged);
+    mChanged = NULL;
+
+    if( mEdited )
+        mChanged = GD_NEW_ARRAY(Bool, mEdited->GetClass()->GetPropertyCount(), this, "EditorLib::QPropertyModel");
+
+    TakeSnapshot();
+}
+
+void QPropertyModel::Refresh()
+{
+    if( !mEdited )
+        return;
+
+    // The generated diff functions compare the properties to the snapshot without going through each Property.
+    Class* editedClass = mEdited->GetClass();
+    editedClass->DiffProperties( mEdited, mSnapshot.empty() ? NULL : &mSnapshot[0], mChanged );
+
+    Bool changed = false;
+    int  row = 0;
+    for( Class::PropertyIterator itProp(editedClass); itProp; ++itProp, ++row )
+    {
+        if( !mChanged[row] )
+            continue;
+
+        QModelIndex valueIndex = createIndex( row, VALUE_COLUMN, *itProp );
+        dataChanged( valueIndex, valueIndex );
+
+        UInt32 componentCount = (*itProp)->GetComponentCount();
+        if( componentCount )
+            dataChanged( createIndex(0, VALUE_COLUMN, row), createIndex(componentCount-1, VALUE_COLUMN, row) );
+
+        changed = true;
+    }
+
+    if( changed )
+        TakeSnapshot();
+}
+
+void QPropertyModel::TakeSnapshot()
+{
+    mSnapshot.clear();
+
+    if( mEdited )
+    {
+        MemoryOutputStream snapshotStream( mSnapshot );
+        mEdited->GetClass()->SerializeProperties( mEdited, snapshotStream );
+    }
 }
 
 Object* QPropertyModel::GetEdited()
@@ -229,7 +281,10 @@ void QPropertyDelegate::setModelData(QWidget* pEditor, QAbstractItemModel* pMode
     
     QPropertyHelper* propHelper = QPropertyHelpersManager::GetHelper(baseProp->GetID());
     if( propHelper && model )
+    {
         propHelper->SetModelData(pEditor, model->GetEdited(), baseProp, QPropertyModel::GetComponentIndex(pIndex));
+        model->GetEdited()->MarkDirty();
+    }
 
     model->setData(pIndex, QVariant(), Qt::DisplayRole);
 }
@@ -25,6 +25,9 @@ public:
     ~QPropertyModel();
 
     void SetEdited(Object* pEdited);
+
+    //! Update the rows of the properties that changed since the last refresh.
+    void Refresh();
     Object* GetEdited();
     const Object* GetEdited() const;
 
@@ -46,7 +49,12 @@ public:
     static UInt32    GetComponentIndex(const QModelIndex& index);
 
 private:
-    Object* mEdited;
+    void TakeSnapshot();
+
+private:
+    Object*         mEdited;
+    Vector<Byte>    mSnapshot;      //!< Properties of the edited object at the last refresh.
+    Bool*           mChanged;       //!< Changed flag per property, filled by Class::DiffProperties().
 };
 
 
@@ -88,10 +96,14 @@ public:
         setRootIsDecorated(false);
         setAlternatingRowColors(true);
         setEditTriggers(QAbstractItemView::CurrentChanged|QAbstractItemView::SelectedClicked);
+
+        // Follow the changes made to the edited object outside of the property list.
+        mRefreshTimerID = startTimer(1000 / 30);
     }
 
     virtual ~QPropertyList() 
     {
+        killTimer(mRefreshTimerID);
     }
 
     void SetEditedObject( Object* pEditedObject )
@@ -99,9 +111,16 @@ public:
         mModel.SetEdited(pEditedObject);
     }
 
+protected:
+    void timerEvent( QTimerEvent* /*pEvent*/ )
+    {
+        mModel.Refresh();
+    }
+
 private:
     QPropertyModel     mModel;
     QPropertyDelegate  mDelegate;
+    int                mRefreshTimerID;
 };
 
 
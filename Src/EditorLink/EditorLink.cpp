@@ -140,6 +140,8 @@ public:
 				renderWindow->SwapBuffers();
 			}
         }
+
+        ProfileFrame();
     }
 
     void OnResizeWindow( const Gamedesk::Window& pWindow )
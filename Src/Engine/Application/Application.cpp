@@ -31,6 +31,7 @@
 #include "Debug/PerformanceMonitor.h"
 #include "Module/ModuleManager.h"
 #include "FileManager/FileManager.h"
+#include "Thread/JobManager.h"
 
 #include "Graphic/RenderTarget/RenderWindow.h"
 #include "Subsystem/Subsystem.h"
@@ -111,10 +112,18 @@ void Application::Init()
 
     InitSingletons();
     InitSubsystems();
+
+    // Worker threads used for parallel updates, -1 means one per additional cpu.
+    Int32 jobWorkers = mSubsystemConfig.Get( "General", "JobWorkers", Int32(-1) );
+    JobManager::Instance()->Init( jobWorkers );
 }
 
 void Application::Kill()
 {
+#if GD_CFG_USE_MEMORY_TRACKING == GD_ENABLED
+    MemoryTracker::DumpStats();
+#endif
+
     KillSubsystems();
     KillSingletons();
 
@@ -169,6 +178,7 @@ void Application::InitSubsystems()
 
 void Application::KillSingletons()
 {
+    JobManager::Instance()->Kill();
     ResourceManager::Instance()->Kill();
 }
 
@@ -209,12 +219,14 @@ Subsystem* Application::LoadSubsystem( Class* pSubsystemClass )
 void Application::SetupSubsystems( ConfigFile& pConfigFile )
 {
     pConfigFile.Get( "General",          "ShowSubsystemDlg", true );
+    pConfigFile.Get( "General",          "JobWorkers",       Int32(-1) );
     pConfigFile.Get( "GraphicSubsystem", "PluginDir",        String("Plugins/Graphic/") );
     pConfigFile.Get( "GraphicSubsystem", "Current",          String("None") );
     pConfigFile.Get( "SoundSubsystem",   "PluginDir",        String("Plugins/Sound/") );
     pConfigFile.Get( "SoundSubsystem",   "Current",          String("None") );
     pConfigFile.Get( "InputSubsystem",   "PluginDir",        String("Plugins/Input/") );
     pConfigFile.Get( "InputSubsystem",   "Current",          String("None") );
+    pConfigFile.Get( "NetworkSubsystem", "Current",          String("None") );
 }
 
 Window* Application::GetWindow()
@@ -51,6 +51,9 @@
 #include "Graphic/Shader/ShaderProgram.h"
 #include "Sound/Sound.h"
 #include "Sound/SoundData.h"
+#include "Sound/SoundStream.h"
+#include "Sound/SoftwareSound.h"
+#include "Sound/SoftwareSoundSubsystem.h"
 #include "Sound/SoundSubsystem.h"
 #include "Input/InputSubsystem.h"
 #include "Input/Keyboard.h"
@@ -58,6 +61,8 @@
 #include "World/SpacePartition/SpacePartition.h"
 #include "World/SpacePartition/Octree.h"
 #include "World/SpacePartition/BSP.h"
+#include "World/SpacePartition/PortalMap.h"
+#include "World/SpacePartition/PortalPartition.h"
 #include "World/Camera.h"
 #include "World/Character.h"
 #include "World/CharacterCamera.h"
@@ -72,6 +77,7 @@
 #include "World/Terrain.h"
 #include "World/World.h"
 #include "World/WorldTile.h"
+#include "World/WorldTileManager.h"
 #include "Resource/Resource.h"
 #include "Resource/ResourceManager.h"
 #include "Subsystem/Subsystem.h"
@@ -115,6 +121,9 @@ void StaticInitEngineClasses()
 	ShaderProgram::StaticClass();
 	Sound::StaticClass();
 	SoundData::StaticClass();
+	SoundStream::StaticClass();
+	SoftwareSound::StaticClass();
+	SoftwareSoundSubsystem::StaticClass();
 	SoundSubsystem::StaticClass();
 	InputDevice::StaticClass();
 	InputSubsystem::StaticClass();
@@ -123,6 +132,8 @@ void StaticInitEngineClasses()
 	SpacePartition::StaticClass();
 	Octree::StaticClass();
 	Bsp::StaticClass();
+	PortalMap::StaticClass();
+	PortalPartition::StaticClass();
 	Camera::StaticClass();
 	Character::StaticClass();
 	CharacterCamera::StaticClass();
@@ -137,6 +148,7 @@ void StaticInitEngineClasses()
 	Terrain::StaticClass();
 	World::StaticClass();
 	WorldTile::StaticClass();
+	WorldTileManager::StaticClass();
 	Resource::StaticClass();
 	ResourceImporter::StaticClass();
 	ResourceExporter::StaticClass();
@@ -9,8 +9,6 @@
 #include "Engine.h"
 #include "EngineEnums.h"
 
-#if GD_CFG_USE_PROPERTIES == GD_ENABLED
-
 #include ".\World\Camera.h"
 #include ".\World\Entity.h"
 #include ".\World\FollowCamera.h"
@@ -23,6 +21,108 @@
 namespace Gamedesk {
 
 
+void Camera::SerializeProperties( Stream& pStream )
+{
+    // mFovAngle, mNearView, mFarView
+    if( (Byte*)(&mFarView + 1) - (Byte*)&mFovAngle == sizeof(mFovAngle) + sizeof(mNearView) + sizeof(mFarView) )
+        pStream.Serialize( &mFovAngle, sizeof(mFovAngle) + sizeof(mNearView) + sizeof(mFarView) );
+    else
+    {
+        pStream.Serialize( &mFovAngle, sizeof(mFovAngle) );
+        pStream.Serialize( &mNearView, sizeof(mNearView) );
+        pStream.Serialize( &mFarView, sizeof(mFarView) );
+    }
+}
+
+void Entity::SerializeProperties( Stream& pStream )
+{
+    // mPosition, mOrientation
+    if( (Byte*)(&mOrientation + 1) - (Byte*)&mPosition == sizeof(mPosition) + sizeof(mOrientation) )
+        pStream.Serialize( &mPosition, sizeof(mPosition) + sizeof(mOrientation) );
+    else
+    {
+        pStream.Serialize( &mPosition, sizeof(mPosition) );
+        pStream.Serialize( &mOrientation, sizeof(mOrientation) );
+    }
+}
+
+void FollowCamera::SerializeProperties( Stream& pStream )
+{
+    // mSpringForce, mFollowDistance, mUpOffset
+    if( (Byte*)(&mUpOffset + 1) - (Byte*)&mSpringForce == sizeof(mSpringForce) + sizeof(mFollowDistance) + sizeof(mUpOffset) )
+        pStream.Serialize( &mSpringForce, sizeof(mSpringForce) + sizeof(mFollowDistance) + sizeof(mUpOffset) );
+    else
+    {
+        pStream.Serialize( &mSpringForce, sizeof(mSpringForce) );
+        pStream.Serialize( &mFollowDistance, sizeof(mFollowDistance) );
+        pStream.Serialize( &mUpOffset, sizeof(mUpOffset) );
+    }
+}
+
+void ParticleEmitter::SerializeProperties( Stream& pStream )
+{
+    // mMaxParticleCount, mEmissionConeAngle, mBirthrate, mLife, mLifeRand, mSizeStart, mSizeStartRand, mSizeEnd, mSizeEndRand, mColorStart, mColorEnd, mInitialSpeed, mInitialSpeedRand, mAccel, mGravity
+    if( (Byte*)(&mGravity + 1) - (Byte*)&mMaxParticleCount == sizeof(mMaxParticleCount) + sizeof(mEmissionConeAngle) + sizeof(mBirthrate) + sizeof(mLife) + sizeof(mLifeRand) + sizeof(mSizeStart) + sizeof(mSizeStartRand) + sizeof(mSizeEnd) + sizeof(mSizeEndRand) + sizeof(mColorStart) + sizeof(mColorEnd) + sizeof(mInitialSpeed) + sizeof(mInitialSpeedRand) + sizeof(mAccel) + sizeof(mGravity) )
+        pStream.Serialize( &mMaxParticleCount, sizeof(mMaxParticleCount) + sizeof(mEmissionConeAngle) + sizeof(mBirthrate) + sizeof(mLife) + sizeof(mLifeRand) + sizeof(mSizeStart) + sizeof(mSizeStartRand) + sizeof(mSizeEnd) + sizeof(mSizeEndRand) + sizeof(mColorStart) + sizeof(mColorEnd) + sizeof(mInitialSpeed) + sizeof(mInitialSpeedRand) + sizeof(mAccel) + sizeof(mGravity) );
+    else
+    {
+        pStream.Serialize( &mMaxParticleCount, sizeof(mMaxParticleCount) );
+        pStream.Serialize( &mEmissionConeAngle, sizeof(mEmissionConeAngle) );
+        pStream.Serialize( &mBirthrate, sizeof(mBirthrate) );
+        pStream.Serialize( &mLife, sizeof(mLife) );
+        pStream.Serialize( &mLifeRand, sizeof(mLifeRand) );
+        pStream.Serialize( &mSizeStart, sizeof(mSizeStart) );
+        pStream.Serialize( &mSizeStartRand, sizeof(mSizeStartRand) );
+        pStream.Serialize( &mSizeEnd, sizeof(mSizeEnd) );
+        pStream.Serialize( &mSizeEndRand, sizeof(mSizeEndRand) );
+        pStream.Serialize( &mColorStart, sizeof(mColorStart) );
+        pStream.Serialize( &mColorEnd, sizeof(mColorEnd) );
+        pStream.Serialize( &mInitialSpeed, sizeof(mInitialSpeed) );
+        pStream.Serialize( &mInitialSpeedRand, sizeof(mInitialSpeedRand) );
+        pStream.Serialize( &mAccel, sizeof(mAccel) );
+        pStream.Serialize( &mGravity, sizeof(mGravity) );
+    }
+}
+
+void SkyDome::SerializeProperties( Stream& pStream )
+{
+    pStream << mTextureName;
+}
+
+void Terrain::SerializeProperties( Stream& pStream )
+{
+    pStream << mTextureName;
+}
+
+void TestProperties::SerializeProperties( Stream& pStream )
+{
+    // mBool, mChar, mInt16, mInt32, mInt64, mByte, mUInt16, mUInt32, mUInt64, mFloat, mDouble, mColor3, mColor4, mVector3, mQuaternion
+    if( (Byte*)(&mQuaternion + 1) - (Byte*)&mBool == sizeof(mBool) + sizeof(mChar) + sizeof(mInt16) + sizeof(mInt32) + sizeof(mInt64) + sizeof(mByte) + sizeof(mUInt16) + sizeof(mUInt32) + sizeof(mUInt64) + sizeof(mFloat) + sizeof(mDouble) + sizeof(mColor3) + sizeof(mColor4) + sizeof(mVector3) + sizeof(mQuaternion) )
+        pStream.Serialize( &mBool, sizeof(mBool) + sizeof(mChar) + sizeof(mInt16) + sizeof(mInt32) + sizeof(mInt64) + sizeof(mByte) + sizeof(mUInt16) + sizeof(mUInt32) + sizeof(mUInt64) + sizeof(mFloat) + sizeof(mDouble) + sizeof(mColor3) + sizeof(mColor4) + sizeof(mVector3) + sizeof(mQuaternion) );
+    else
+    {
+        pStream.Serialize( &mBool, sizeof(mBool) );
+        pStream.Serialize( &mChar, sizeof(mChar) );
+        pStream.Serialize( &mInt16, sizeof(mInt16) );
+        pStream.Serialize( &mInt32, sizeof(mInt32) );
+        pStream.Serialize( &mInt64, sizeof(mInt64) );
+        pStream.Serialize( &mByte, sizeof(mByte) );
+        pStream.Serialize( &mUInt16, sizeof(mUInt16) );
+        pStream.Serialize( &mUInt32, sizeof(mUInt32) );
+        pStream.Serialize( &mUInt64, sizeof(mUInt64) );
+        pStream.Serialize( &mFloat, sizeof(mFloat) );
+        pStream.Serialize( &mDouble, sizeof(mDouble) );
+        pStream.Serialize( &mColor3, sizeof(mColor3) );
+        pStream.Serialize( &mColor4, sizeof(mColor4) );
+        pStream.Serialize( &mVector3, sizeof(mVector3) );
+        pStream.Serialize( &mQuaternion, sizeof(mQuaternion) );
+    }
+    pStream << mString;
+    pStream.Serialize( &mEnum, sizeof(mEnum) );
+}
+
+#if GD_CFG_USE_PROPERTIES == GD_ENABLED
+
 void Camera::StaticRegisterProperties( Class* pClass )
 {
     if( pClass != Camera::StaticClass() )
@@ -49,8 +149,30 @@ void Camera::StaticRegisterProperties( Class* pClass )
     mFarViewProperty.SetMinimum((Float)100);
     mFarViewProperty.SetMaximum((Float)3.40282e+038);
 
+    pClass->SetPropertyFunctions( &Camera::StaticSerializeProperties, &Camera::StaticDiffProperties );
 }
 
+void Camera::StaticSerializeProperties( Object* pObject, Stream& pStream )
+{
+    static_cast<Camera*>(pObject)->SerializeProperties( pStream );
+}
+
+void Camera::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )
+{
+    const Camera* obj = static_cast<const Camera*>(pObject);
+
+    // mFovAngle, mNearView, mFarView
+    if( PropertySnapshot::RunEqual( pSnapshot, &obj->mFovAngle, &obj->mFarView + 1, sizeof(obj->mFovAngle) + sizeof(obj->mNearView) + sizeof(obj->mFarView) ) )
+        pSnapshot += sizeof(obj->mFovAngle) + sizeof(obj->mNearView) + sizeof(obj->mFarView);
+    else
+    {
+        pChanged[0] = PropertySnapshot::Changed( pSnapshot, obj->mFovAngle );
+        pChanged[1] = PropertySnapshot::Changed( pSnapshot, obj->mNearView );
+        pChanged[2] = PropertySnapshot::Changed( pSnapshot, obj->mFarView );
+    }
+}
+
+
 void Entity::StaticRegisterProperties( Class* pClass )
 {
     if( pClass != Entity::StaticClass() )
@@ -64,8 +186,29 @@ void Entity::StaticRegisterProperties( Class* pClass )
     static PropertyQuaternionf mOrientationProperty("Orientation", "Orientation of the entity in the world", (UInt32)&((Entity*)(0))->mOrientation );
     pClass->AddProperty(&mOrientationProperty);
 
+    pClass->SetPropertyFunctions( &Entity::StaticSerializeProperties, &Entity::StaticDiffProperties );
+}
+
+void Entity::StaticSerializeProperties( Object* pObject, Stream& pStream )
+{
+    static_cast<Entity*>(pObject)->SerializeProperties( pStream );
 }
 
+void Entity::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )
+{
+    const Entity* obj = static_cast<const Entity*>(pObject);
+
+    // mPosition, mOrientation
+    if( PropertySnapshot::RunEqual( pSnapshot, &obj->mPosition, &obj->mOrientation + 1, sizeof(obj->mPosition) + sizeof(obj->mOrientation) ) )
+        pSnapshot += sizeof(obj->mPosition) + sizeof(obj->mOrientation);
+    else
+    {
+        pChanged[0] = PropertySnapshot::Changed( pSnapshot, obj->mPosition );
+        pChanged[1] = PropertySnapshot::Changed( pSnapshot, obj->mOrientation );
+    }
+}
+
+
 void FollowCamera::StaticRegisterProperties( Class* pClass )
 {
     if( pClass != FollowCamera::StaticClass() )
@@ -92,8 +235,30 @@ void FollowCamera::StaticRegisterProperties( Class* pClass )
     mUpOffsetProperty.SetMinimum((Float)0);
     mUpOffsetProperty.SetMaximum((Float)10);
 
+    pClass->SetPropertyFunctions( &FollowCamera::StaticSerializeProperties, &FollowCamera::StaticDiffProperties );
 }
 
+void FollowCamera::StaticSerializeProperties( Object* pObject, Stream& pStream )
+{
+    static_cast<FollowCamera*>(pObject)->SerializeProperties( pStream );
+}
+
+void FollowCamera::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )
+{
+    const FollowCamera* obj = static_cast<const FollowCamera*>(pObject);
+
+    // mSpringForce, mFollowDistance, mUpOffset
+    if( PropertySnapshot::RunEqual( pSnapshot, &obj->mSpringForce, &obj->mUpOffset + 1, sizeof(obj->mSpringForce) + sizeof(obj->mFollowDistance) + sizeof(obj->mUpOffset) ) )
+        pSnapshot += sizeof(obj->mSpringForce) + sizeof(obj->mFollowDistance) + sizeof(obj->mUpOffset);
+    else
+    {
+        pChanged[0] = PropertySnapshot::Changed( pSnapshot, obj->mSpringForce );
+        pChanged[1] = PropertySnapshot::Changed( pSnapshot, obj->mFollowDistance );
+        pChanged[2] = PropertySnapshot::Changed( pSnapshot, obj->mUpOffset );
+    }
+}
+
+
 void ParticleEmitter::StaticRegisterProperties( Class* pClass )
 {
     if( pClass != ParticleEmitter::StaticClass() )
@@ -195,8 +360,42 @@ void ParticleEmitter::StaticRegisterProperties( Class* pClass )
     static PropertyVector3f mGravityProperty("Gravity", "Force of the gravity", (UInt32)&((ParticleEmitter*)(0))->mGravity );
     pClass->AddProperty(&mGravityProperty);
 
+    pClass->SetPropertyFunctions( &ParticleEmitter::StaticSerializeProperties, &ParticleEmitter::StaticDiffProperties );
+}
+
+void ParticleEmitter::StaticSerializeProperties( Object* pObject, Stream& pStream )
+{
+    static_cast<ParticleEmitter*>(pObject)->SerializeProperties( pStream );
 }
 
+void ParticleEmitter::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )
+{
+    const ParticleEmitter* obj = static_cast<const ParticleEmitter*>(pObject);
+
+    // mMaxParticleCount, mEmissionConeAngle, mBirthrate, mLife, mLifeRand, mSizeStart, mSizeStartRand, mSizeEnd, mSizeEndRand, mColorStart, mColorEnd, mInitialSpeed, mInitialSpeedRand, mAccel, mGravity
+    if( PropertySnapshot::RunEqual( pSnapshot, &obj->mMaxParticleCount, &obj->mGravity + 1, sizeof(obj->mMaxParticleCount) + sizeof(obj->mEmissionConeAngle) + sizeof(obj->mBirthrate) + sizeof(obj->mLife) + sizeof(obj->mLifeRand) + sizeof(obj->mSizeStart) + sizeof(obj->mSizeStartRand) + sizeof(obj->mSizeEnd) + sizeof(obj->mSizeEndRand) + sizeof(obj->mColorStart) + sizeof(obj->mColorEnd) + sizeof(obj->mInitialSpeed) + sizeof(obj->mInitialSpeedRand) + sizeof(obj->mAccel) + sizeof(obj->mGravity) ) )
+        pSnapshot += sizeof(obj->mMaxParticleCount) + sizeof(obj->mEmissionConeAngle) + sizeof(obj->mBirthrate) + sizeof(obj->mLife) + sizeof(obj->mLifeRand) + sizeof(obj->mSizeStart) + sizeof(obj->mSizeStartRand) + sizeof(obj->mSizeEnd) + sizeof(obj->mSizeEndRand) + sizeof(obj->mColorStart) + sizeof(obj->mColorEnd) + sizeof(obj->mInitialSpeed) + sizeof(obj->mInitialSpeedRand) + sizeof(obj->mAccel) + sizeof(obj->mGravity);
+    else
+    {
+        pChanged[0] = PropertySnapshot::Changed( pSnapshot, obj->mMaxParticleCount );
+        pChanged[1] = PropertySnapshot::Changed( pSnapshot, obj->mEmissionConeAngle );
+        pChanged[2] = PropertySnapshot::Changed( pSnapshot, obj->mBirthrate );
+        pChanged[3] = PropertySnapshot::Changed( pSnapshot, obj->mLife );
+        pChanged[4] = PropertySnapshot::Changed( pSnapshot, obj->mLifeRand );
+        pChanged[5] = PropertySnapshot::Changed( pSnapshot, obj->mSizeStart );
+        pChanged[6] = PropertySnapshot::Changed( pSnapshot, obj->mSizeStartRand );
+        pChanged[7] = PropertySnapshot::Changed( pSnapshot, obj->mSizeEnd );
+        pChanged[8] = PropertySnapshot::Changed( pSnapshot, obj->mSizeEndRand );
+        pChanged[9] = PropertySnapshot::Changed( pSnapshot, obj->mColorStart );
+        pChanged[10] = PropertySnapshot::Changed( pSnapshot, obj->mColorEnd );
+        pChanged[11] = PropertySnapshot::Changed( pSnapshot, obj->mInitialSpeed );
+        pChanged[12] = PropertySnapshot::Changed( pSnapshot, obj->mInitialSpeedRand );
+        pChanged[13] = PropertySnapshot::Changed( pSnapshot, obj->mAccel );
+        pChanged[14] = PropertySnapshot::Changed( pSnapshot, obj->mGravity );
+    }
+}
+
+
 void SkyDome::StaticRegisterProperties( Class* pClass )
 {
     if( pClass != SkyDome::StaticClass() )
@@ -206,8 +405,22 @@ void SkyDome::StaticRegisterProperties( Class* pClass )
     static PropertyString mTextureNameProperty("TextureName", "Texture name (currently does nothing...)", (UInt32)&((SkyDome*)(0))->mTextureName );
     pClass->AddProperty(&mTextureNameProperty);
 
+    pClass->SetPropertyFunctions( &SkyDome::StaticSerializeProperties, &SkyDome::StaticDiffProperties );
+}
+
+void SkyDome::StaticSerializeProperties( Object* pObject, Stream& pStream )
+{
+    static_cast<SkyDome*>(pObject)->SerializeProperties( pStream );
+}
+
+void SkyDome::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )
+{
+    const SkyDome* obj = static_cast<const SkyDome*>(pObject);
+
+    pChanged[0] = PropertySnapshot::Changed( pSnapshot, obj->mTextureName );
 }
 
+
 void Terrain::StaticRegisterProperties( Class* pClass )
 {
     if( pClass != Terrain::StaticClass() )
@@ -217,8 +430,22 @@ void Terrain::StaticRegisterProperties( Class* pClass )
     static PropertyString mTextureNameProperty("TextureName", "Texture name (does nothing...)", (UInt32)&((Terrain*)(0))->mTextureName );
     pClass->AddProperty(&mTextureNameProperty);
 
+    pClass->SetPropertyFunctions( &Terrain::StaticSerializeProperties, &Terrain::StaticDiffProperties );
+}
+
+void Terrain::StaticSerializeProperties( Object* pObject, Stream& pStream )
+{
+    static_cast<Terrain*>(pObject)->SerializeProperties( pStream );
+}
+
+void Terrain::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )
+{
+    const Terrain* obj = static_cast<const Terrain*>(pObject);
+
+    pChanged[0] = PropertySnapshot::Changed( pSnapshot, obj->mTextureName );
 }
 
+
 void TestProperties::StaticRegisterProperties( Class* pClass )
 {
     if( pClass != TestProperties::StaticClass() )
@@ -322,10 +549,45 @@ void TestProperties::StaticRegisterProperties( Class* pClass )
     static TPropertyEnum<EnumInfo::TestProperties::MyEnum> mEnumProperty("Enum", "", (UInt32)&((TestProperties*)(0))->mEnum );
     pClass->AddProperty(&mEnumProperty);
 
+    pClass->SetPropertyFunctions( &TestProperties::StaticSerializeProperties, &TestProperties::StaticDiffProperties );
 }
 
+void TestProperties::StaticSerializeProperties( Object* pObject, Stream& pStream )
+{
+    static_cast<TestProperties*>(pObject)->SerializeProperties( pStream );
+}
 
-} // namespace Gamedesk
+void TestProperties::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )
+{
+    const TestProperties* obj = static_cast<const TestProperties*>(pObject);
+
+    // mBool, mChar, mInt16, mInt32, mInt64, mByte, mUInt16, mUInt32, mUInt64, mFloat, mDouble, mColor3, mColor4, mVector3, mQuaternion
+    if( PropertySnapshot::RunEqual( pSnapshot, &obj->mBool, &obj->mQuaternion + 1, sizeof(obj->mBool) + sizeof(obj->mChar) + sizeof(obj->mInt16) + sizeof(obj->mInt32) + sizeof(obj->mInt64) + sizeof(obj->mByte) + sizeof(obj->mUInt16) + sizeof(obj->mUInt32) + sizeof(obj->mUInt64) + sizeof(obj->mFloat) + sizeof(obj->mDouble) + sizeof(obj->mColor3) + sizeof(obj->mColor4) + sizeof(obj->mVector3) + sizeof(obj->mQuaternion) ) )
+        pSnapshot += sizeof(obj->mBool) + sizeof(obj->mChar) + sizeof(obj->mInt16) + sizeof(obj->mInt32) + sizeof(obj->mInt64) + sizeof(obj->mByte) + sizeof(obj->mUInt16) + sizeof(obj->mUInt32) + sizeof(obj->mUInt64) + sizeof(obj->mFloat) + sizeof(obj->mDouble) + sizeof(obj->mColor3) + sizeof(obj->mColor4) + sizeof(obj->mVector3) + sizeof(obj->mQuaternion);
+    else
+    {
+        pChanged[0] = PropertySnapshot::Changed( pSnapshot, obj->mBool );
+        pChanged[1] = PropertySnapshot::Changed( pSnapshot, obj->mChar );
+        pChanged[2] = PropertySnapshot::Changed( pSnapshot, obj->mInt16 );
+        pChanged[3] = PropertySnapshot::Changed( pSnapshot, obj->mInt32 );
+        pChanged[4] = PropertySnapshot::Changed( pSnapshot, obj->mInt64 );
+        pChanged[5] = PropertySnapshot::Changed( pSnapshot, obj->mByte );
+        pChanged[6] = PropertySnapshot::Changed( pSnapshot, obj->mUInt16 );
+        pChanged[7] = PropertySnapshot::Changed( pSnapshot, obj->mUInt32 );
+        pChanged[8] = PropertySnapshot::Changed( pSnapshot, obj->mUInt64 );
+        pChanged[9] = PropertySnapshot::Changed( pSnapshot, obj->mFloat );
+        pChanged[10] = PropertySnapshot::Changed( pSnapshot, obj->mDouble );
+        pChanged[11] = PropertySnapshot::Changed( pSnapshot, obj->mColor3 );
+        pChanged[12] = PropertySnapshot::Changed( pSnapshot, obj->mColor4 );
+        pChanged[13] = PropertySnapshot::Changed( pSnapshot, obj->mVector3 );
+        pChanged[14] = PropertySnapshot::Changed( pSnapshot, obj->mQuaternion );
+    }
+    pChanged[15] = PropertySnapshot::Changed( pSnapshot, obj->mString );
+    pChanged[16] = PropertySnapshot::Changed( pSnapshot, obj->mEnum );
+}
 
 
 #endif
+
+
+} // namespace Gamedesk
@@ -89,9 +89,20 @@ void Font::AddFontPage( Texture* pPage )
 
 Font::FontGlyph& Font::GetGlyph( UInt32 pCaracter )
 {
+    MarkDirty();
     return mGlyphs[pCaracter-32];
 }
 
+const Font::FontGlyph& Font::GetGlyph( UInt32 pCaracter ) const
+{
+    return mGlyphs[pCaracter-32];
+}
+
+Texture* Font::GetFontPage( UInt32 pPage ) const
+{
+    return mFontPages[pPage];
+}
+
 void Font::DrawString( UInt32 pX, UInt32 pY, const Char* pString, ... ) const
 {
     va_list	    ptrArguments;
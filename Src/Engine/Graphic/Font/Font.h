@@ -75,7 +75,12 @@ public:
     void     DrawString( UInt32 pX, UInt32 pY, const Char* pString, ... ) const;
     Vector2i GetStringSize( const Char* pString, ... ) const;
 
+    //! Glyph of a character, for editing. Marks the font dirty.
     FontGlyph& GetGlyph( UInt32 pCaracter );
+    const FontGlyph& GetGlyph( UInt32 pCaracter ) const;
+
+    //! Texture page on which glyphs with FontGlyph::texture == pPage are found.
+    Texture* GetFontPage( UInt32 pPage ) const;
 
 private:
     FontGlyph           mGlyphs[GLYPH_COUNT];
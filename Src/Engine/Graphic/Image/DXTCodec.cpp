@@ -0,0 +1,1026 @@
+/**
+ *  @file       DXTCodec.cpp
+ *  @brief      DXT1/3/5 (S3TC) block compression.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "DXTCodec.h"
+
+#include "Maths/Maths.h"
+#include "Thread/JobManager.h"
+
+#include <float.h>
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    #include <xmmintrin.h>
+#endif
+
+
+namespace Gamedesk {
+
+
+//! Rows of blocks processed by each job.
+static const UInt32 BLOCK_ROWS_PER_JOB      = 4;
+
+//! DXT1 pixels with a lower alpha are encoded as transparent.
+static const Byte   DXT1_ALPHA_THRESHOLD    = 128;
+
+
+/**
+ *  Four floats, used for the colors and the color sums of the endpoint fitting.
+ *  Maps to an SSE register when enabled. Only SSE1 instructions are used, so
+ *  unlike the Image operations there's no need for a runtime check.
+ */
+class Vec4
+{
+public:
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    Vec4()
+    {
+    }
+
+    explicit Vec4( __m128 pValue ) : mValue(pValue)
+    {
+    }
+
+    explicit Vec4( Float pValue ) : mValue(_mm_set1_ps(pValue))
+    {
+    }
+
+    Vec4( Float pX, Float pY, Float pZ, Float pW ) : mValue(_mm_setr_ps(pX, pY, pZ, pW))
+    {
+    }
+
+    Vec4 operator + ( const Vec4& pOther ) const    { return Vec4( _mm_add_ps(mValue, pOther.mValue) ); }
+    Vec4 operator - ( const Vec4& pOther ) const    { return Vec4( _mm_sub_ps(mValue, pOther.mValue) ); }
+    Vec4 operator * ( const Vec4& pOther ) const    { return Vec4( _mm_mul_ps(mValue, pOther.mValue) ); }
+    Vec4 operator * ( Float pValue ) const          { return Vec4( _mm_mul_ps(mValue, _mm_set1_ps(pValue)) ); }
+
+    Vec4 Clamp01() const
+    {
+        return Vec4( _mm_min_ps( _mm_max_ps(mValue, _mm_setzero_ps()), _mm_set1_ps(1.0f) ) );
+    }
+
+    //! Round to the nearest integer, for values smaller than 2^22.
+    Vec4 Round() const
+    {
+        const __m128 magic = _mm_set1_ps( 12582912.0f );
+        return Vec4( _mm_sub_ps( _mm_add_ps(mValue, magic), magic ) );
+    }
+
+    void Store( Float* pValues ) const
+    {
+        _mm_storeu_ps( pValues, mValue );
+    }
+
+    __m128  mValue;
+#else
+    Vec4()
+    {
+    }
+
+    explicit Vec4( Float pValue )
+    {
+        mValue[0] = mValue[1] = mValue[2] = mValue[3] = pValue;
+    }
+
+    Vec4( Float pX, Float pY, Float pZ, Float pW )
+    {
+        mValue[0] = pX;
+        mValue[1] = pY;
+        mValue[2] = pZ;
+        mValue[3] = pW;
+    }
+
+    Vec4 operator + ( const Vec4& pOther ) const    { return Vec4( mValue[0] + pOther.mValue[0], mValue[1] + pOther.mValue[1], mValue[2] + pOther.mValue[2], mValue[3] + pOther.mValue[3] ); }
+    Vec4 operator - ( const Vec4& pOther ) const    { return Vec4( mValue[0] - pOther.mValue[0], mValue[1] - pOther.mValue[1], mValue[2] - pOther.mValue[2], mValue[3] - pOther.mValue[3] ); }
+    Vec4 operator * ( const Vec4& pOther ) const    { return Vec4( mValue[0] * pOther.mValue[0], mValue[1] * pOther.mValue[1], mValue[2] * pOther.mValue[2], mValue[3] * pOther.mValue[3] ); }
+    Vec4 operator * ( Float pValue ) const          { return Vec4( mValue[0] * pValue, mValue[1] * pValue, mValue[2] * pValue, mValue[3] * pValue ); }
+
+    Vec4 Clamp01() const
+    {
+        Vec4 result;
+        for( UInt32 i = 0; i < 4; i++ )
+            result.mValue[i] = mValue[i] < 0.0f ? 0.0f : (mValue[i] > 1.0f ? 1.0f : mValue[i]);
+        return result;
+    }
+
+    Vec4 Round() const
+    {
+        return Vec4( floorf(mValue[0] + 0.5f), floorf(mValue[1] + 0.5f), floorf(mValue[2] + 0.5f), floorf(mValue[3] + 0.5f) );
+    }
+
+    void Store( Float* pValues ) const
+    {
+        memcpy( pValues, mValue, sizeof(mValue) );
+    }
+
+    Float   mValue[4];
+#endif
+
+    //! Sum of the x, y and z components.
+    Float SumXYZ() const
+    {
+        Float values[4];
+        Store( values );
+        return values[0] + values[1] + values[2];
+    }
+};
+
+
+/**
+ *  Color channels of a block in [0,1]. The pixels are stored one array per
+ *  channel for the index search, and as a list of the opaque pixels (the ones
+ *  the endpoints are fitted to).
+ */
+class ColorBlock
+{
+public:
+    ColorBlock( const Byte* pPixels, Bool pDXT1 ) : mNumPoints(0), mHasTransparent(false)
+    {
+        for( UInt32 i = 0; i < 16; i++, pPixels += 4 )
+        {
+            mRed[i]   = pPixels[0] / 255.0f;
+            mGreen[i] = pPixels[1] / 255.0f;
+            mBlue[i]  = pPixels[2] / 255.0f;
+
+            mTransparent[i] = pDXT1 && pPixels[3] < DXT1_ALPHA_THRESHOLD;
+
+            if( mTransparent[i] )
+                mHasTransparent = true;
+            else
+                mPoints[mNumPoints++] = Vec4( mRed[i], mGreen[i], mBlue[i], 0.0f );
+        }
+    }
+
+    Float   mRed[16];
+    Float   mGreen[16];
+    Float   mBlue[16];
+    Bool    mTransparent[16];
+
+    Vec4    mPoints[16];
+    UInt32  mNumPoints;
+    Bool    mHasTransparent;
+};
+
+
+//! Result of the encoding of the color endpoints of a block.
+class ColorEncoding
+{
+public:
+    UInt16  mColor0;
+    UInt16  mColor1;
+    Byte    mIndices[16];
+    Float   mError;         //!< Sum of the squared distances, in [0,1] units.
+};
+
+
+/**
+ *  Direction along which the colors of the block vary the most, computed by
+ *  power iteration on the covariance matrix.
+ */
+static Vec4 ComputePrincipalAxis( const ColorBlock& pBlock )
+{
+    Float points[16][4];
+    Float mean[3] = { 0.0f, 0.0f, 0.0f };
+
+    for( UInt32 i = 0; i < pBlock.mNumPoints; i++ )
+    {
+        pBlock.mPoints[i].Store( points[i] );
+        mean[0] += points[i][0];
+        mean[1] += points[i][1];
+        mean[2] += points[i][2];
+    }
+
+    for( UInt32 c = 0; c < 3; c++ )
+        mean[c] /= pBlock.mNumPoints;
+
+    // Symmetric, only the upper half is computed.
+    Float covariance[3][3] = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    for( UInt32 i = 0; i < pBlock.mNumPoints; i++ )
+    {
+        Float r = points[i][0] - mean[0];
+        Float g = points[i][1] - mean[1];
+        Float b = points[i][2] - mean[2];
+
+        covariance[0][0] += r*r;
+        covariance[0][1] += r*g;
+        covariance[0][2] += r*b;
+        covariance[1][1] += g*g;
+        covariance[1][2] += g*b;
+        covariance[2][2] += b*b;
+    }
+
+    covariance[1][0] = covariance[0][1];
+    covariance[2][0] = covariance[0][2];
+    covariance[2][1] = covariance[1][2];
+
+    // Start from the row of the channel with the largest variance.
+    UInt32 row = 0;
+    if( covariance[1][1] > covariance[row][row] )   row = 1;
+    if( covariance[2][2] > covariance[row][row] )   row = 2;
+
+    Float axis[3] = { covariance[row][0], covariance[row][1], covariance[row][2] };
+
+    for( UInt32 iteration = 0; iteration < 8; iteration++ )
+    {
+        Float x = covariance[0][0]*axis[0] + covariance[0][1]*axis[1] + covariance[0][2]*axis[2];
+        Float y = covariance[1][0]*axis[0] + covariance[1][1]*axis[1] + covariance[1][2]*axis[2];
+        Float z = covariance[2][0]*axis[0] + covariance[2][1]*axis[1] + covariance[2][2]*axis[2];
+
+        Float norm = Maths::Max( fabsf(x), fabsf(y), fabsf(z) );
+        if( norm < FLT_EPSILON )
+            break;
+
+        axis[0] = x / norm;
+        axis[1] = y / norm;
+        axis[2] = z / norm;
+    }
+
+    return Vec4( axis[0], axis[1], axis[2], 0.0f );
+}
+
+//! Use the extreme colors of the block along pAxis as endpoints.
+static void RangeFit( const ColorBlock& pBlock, const Vec4& pAxis, Vec4& pStart, Vec4& pEnd )
+{
+    UInt32 minIndex      = 0;
+    UInt32 maxIndex      = 0;
+    Float  minProjection = FLT_MAX;
+    Float  maxProjection = -FLT_MAX;
+
+    for( UInt32 i = 0; i < pBlock.mNumPoints; i++ )
+    {
+        Float projection = (pBlock.mPoints[i] * pAxis).SumXYZ();
+
+        if( projection < minProjection )
+        {
+            minProjection = projection;
+            minIndex      = i;
+        }
+
+        if( projection > maxProjection )
+        {
+            maxProjection = projection;
+            maxIndex      = i;
+        }
+    }
+
+    pStart = pBlock.mPoints[maxIndex];
+    pEnd   = pBlock.mPoints[minIndex];
+}
+
+/**
+ *  Sort the colors along pAxis, then try every split of the sorted colors in
+ *  3 or 4 consecutive clusters, one per palette entry. For each split the
+ *  endpoints minimizing the squared error are solved by least squares and
+ *  snapped to the 565 grid; the split with the lowest error wins.
+ *  Return false if no split gives a solvable system (single color blocks).
+ */
+static Bool ClusterFit( const ColorBlock& pBlock, const Vec4& pAxis, Bool pFourColors, Vec4& pStart, Vec4& pEnd )
+{
+    const UInt32 count = pBlock.mNumPoints;
+
+    UInt32 order[16];
+    Float  projections[16];
+
+    for( UInt32 i = 0; i < count; i++ )
+    {
+        Float  projection = (pBlock.mPoints[i] * pAxis).SumXYZ();
+        UInt32 j          = i;
+
+        for( ; j > 0 && projections[j - 1] > projection; j-- )
+        {
+            projections[j] = projections[j - 1];
+            order[j]       = order[j - 1];
+        }
+
+        projections[j] = projection;
+        order[j]       = i;
+    }
+
+    // Prefix sums of the sorted colors, a cluster sum is the difference of two.
+    Vec4 sums[17];
+    sums[0] = Vec4( 0.0f );
+    for( UInt32 i = 0; i < count; i++ )
+        sums[i + 1] = sums[i] + pBlock.mPoints[order[i]];
+
+    const Vec4 grid( 31.0f, 63.0f, 31.0f, 0.0f );
+    const Vec4 gridRcp( 1.0f / 31.0f, 1.0f / 63.0f, 1.0f / 31.0f, 0.0f );
+
+    Float bestError = FLT_MAX;
+
+    // Each cluster is weighted by the contribution of the start (alpha) and
+    // end (beta) colors to its palette entry.
+    for( UInt32 i = 0; i <= count; i++ )
+    {
+        for( UInt32 j = i; j <= count; j++ )
+        {
+            UInt32 kBegin = pFourColors ? j : count;
+
+            for( UInt32 k = kBegin; k <= count; k++ )
+            {
+                Float alpha2, beta2, alphaBeta;
+                Vec4  alphaX, betaX;
+
+                if( pFourColors )
+                {
+                    Float count1 = Float(j - i);
+                    Float count2 = Float(k - j);
+
+                    Vec4 x1 = sums[j] - sums[i];
+                    Vec4 x2 = sums[k] - sums[j];
+
+                    alpha2    = Float(i)         + (count1 * 4.0f + count2) * (1.0f / 9.0f);
+                    beta2     = Float(count - k) + (count1 + count2 * 4.0f) * (1.0f / 9.0f);
+                    alphaBeta = (count1 + count2) * (2.0f / 9.0f);
+
+                    alphaX = sums[i] + x1 * (2.0f / 3.0f) + x2 * (1.0f / 3.0f);
+                    betaX  = (sums[count] - sums[k]) + x1 * (1.0f / 3.0f) + x2 * (2.0f / 3.0f);
+                }
+                else
+                {
+                    Float count1 = Float(j - i);
+                    Vec4  x1     = sums[j] - sums[i];
+
+                    alpha2    = Float(i)         + count1 * 0.25f;
+                    beta2     = Float(count - j) + count1 * 0.25f;
+                    alphaBeta = count1 * 0.25f;
+
+                    alphaX = sums[i] + x1 * 0.5f;
+                    betaX  = (sums[count] - sums[j]) + x1 * 0.5f;
+                }
+
+                Float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+                if( determinant < 1e-4f )
+                    continue;
+
+                Float factor = 1.0f / determinant;
+
+                Vec4 a = (alphaX * beta2 - betaX * alphaBeta) * factor;
+                Vec4 b = (betaX * alpha2 - alphaX * alphaBeta) * factor;
+
+                a = (a.Clamp01() * grid).Round() * gridRcp;
+                b = (b.Clamp01() * grid).Round() * gridRcp;
+
+                // Squared error, minus the sum of the squared colors which is the same for every split.
+                Vec4 error = a * a * alpha2 + b * b * beta2 + (a * b * alphaBeta - a * alphaX - b * betaX) * 2.0f;
+
+                Float sum = error.SumXYZ();
+                if( sum < bestError )
+                {
+                    bestError = sum;
+                    pStart    = a;
+                    pEnd      = b;
+                }
+            }
+        }
+    }
+
+    return bestError != FLT_MAX;
+}
+
+static inline UInt32 Quantize( Float pValue, Int32 pMax )
+{
+    Int32 value = (Int32)(pValue * pMax + 0.5f);
+    return value < 0 ? 0 : (value > pMax ? pMax : value);
+}
+
+static UInt16 PackColor565( const Vec4& pColor )
+{
+    Float values[4];
+    pColor.Store( values );
+
+    return (UInt16)((Quantize(values[0], 31) << 11) | (Quantize(values[1], 63) << 5) | Quantize(values[2], 31));
+}
+
+static void UnpackColor565( UInt16 pColor, Byte* pRGBA )
+{
+    UInt32 red   = (pColor >> 11) & 0x1F;
+    UInt32 green = (pColor >> 5)  & 0x3F;
+    UInt32 blue  = (pColor >> 0)  & 0x1F;
+
+    pRGBA[0] = (Byte)((red << 3)   | (red >> 2));
+    pRGBA[1] = (Byte)((green << 2) | (green >> 4));
+    pRGBA[2] = (Byte)((blue << 3)  | (blue >> 2));
+    pRGBA[3] = 255;
+}
+
+//! Palette of a color block, shared by the encoder and the decoder so they agree on the rounding.
+static void BuildColorPalette( UInt16 pColor0, UInt16 pColor1, Bool pFourColors, Byte pPalette[4][4] )
+{
+    UnpackColor565( pColor0, pPalette[0] );
+    UnpackColor565( pColor1, pPalette[1] );
+
+    for( UInt32 c = 0; c < 3; c++ )
+    {
+        if( pFourColors )
+        {
+            pPalette[2][c] = (Byte)((2 * pPalette[0][c] + pPalette[1][c]) / 3);
+            pPalette[3][c] = (Byte)((pPalette[0][c] + 2 * pPalette[1][c]) / 3);
+        }
+        else
+        {
+            pPalette[2][c] = (Byte)((pPalette[0][c] + pPalette[1][c]) / 2);
+            pPalette[3][c] = 0;
+        }
+    }
+
+    pPalette[2][3] = 255;
+    pPalette[3][3] = pFourColors ? 255 : 0;
+}
+
+/**
+ *  Pick the nearest palette entry of each pixel, transparent pixels get entry 3.
+ *  Return the sum of the squared distances of the opaque pixels.
+ */
+static Float FindColorIndices( const ColorBlock& pBlock, const Byte pPalette[4][4], UInt32 pPaletteSize, Byte* pIndices )
+{
+    Float distances[16];
+    Float indices[16];
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    // 4 pixels against one palette entry at a time.
+    __m128 paletteRed[4];
+    __m128 paletteGreen[4];
+    __m128 paletteBlue[4];
+
+    for( UInt32 p = 0; p < pPaletteSize; p++ )
+    {
+        paletteRed[p]   = _mm_set1_ps( pPalette[p][0] / 255.0f );
+        paletteGreen[p] = _mm_set1_ps( pPalette[p][1] / 255.0f );
+        paletteBlue[p]  = _mm_set1_ps( pPalette[p][2] / 255.0f );
+    }
+
+    for( UInt32 i = 0; i < 16; i += 4 )
+    {
+        __m128 red   = _mm_loadu_ps( &pBlock.mRed[i] );
+        __m128 green = _mm_loadu_ps( &pBlock.mGreen[i] );
+        __m128 blue  = _mm_loadu_ps( &pBlock.mBlue[i] );
+
+        __m128 best  = _mm_set1_ps( FLT_MAX );
+        __m128 index = _mm_setzero_ps();
+
+        for( UInt32 p = 0; p < pPaletteSize; p++ )
+        {
+            __m128 dr = _mm_sub_ps( red,   paletteRed[p] );
+            __m128 dg = _mm_sub_ps( green, paletteGreen[p] );
+            __m128 db = _mm_sub_ps( blue,  paletteBlue[p] );
+
+            __m128 distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg) ), _mm_mul_ps(db, db) );
+            __m128 closer   = _mm_cmplt_ps( distance, best );
+
+            best  = _mm_min_ps( distance, best );
+            index = _mm_or_ps( _mm_and_ps(closer, _mm_set1_ps(Float(p))), _mm_andnot_ps(closer, index) );
+        }
+
+        _mm_storeu_ps( &distances[i], best );
+        _mm_storeu_ps( &indices[i], index );
+    }
+#else
+    for( UInt32 i = 0; i < 16; i++ )
+    {
+        distances[i] = FLT_MAX;
+        indices[i]   = 0.0f;
+
+        for( UInt32 p = 0; p < pPaletteSize; p++ )
+        {
+            Float dr = pBlock.mRed[i]   - pPalette[p][0] / 255.0f;
+            Float dg = pBlock.mGreen[i] - pPalette[p][1] / 255.0f;
+            Float db = pBlock.mBlue[i]  - pPalette[p][2] / 255.0f;
+
+            Float distance = dr*dr + dg*dg + db*db;
+            if( distance < distances[i] )
+            {
+                distances[i] = distance;
+                indices[i]   = Float(p);
+            }
+        }
+    }
+#endif
+
+    Float error = 0.0f;
+    for( UInt32 i = 0; i < 16; i++ )
+    {
+        if( pBlock.mTransparent[i] )
+        {
+            pIndices[i] = 3;
+        }
+        else
+        {
+            pIndices[i] = (Byte)indices[i];
+            error += distances[i];
+        }
+    }
+
+    return error;
+}
+
+//! Snap the endpoints to 565, order them for the wanted mode and pick the indices.
+static void EncodeColorEndpoints( const ColorBlock& pBlock, const Vec4& pStart, const Vec4& pEnd, Bool pFourColors, ColorEncoding& pEncoding )
+{
+    UInt16 color0 = PackColor565( pStart );
+    UInt16 color1 = PackColor565( pEnd );
+
+    // The decoder picks the mode from the order of the endpoints.
+    if( (pFourColors && color0 < color1) || (!pFourColors && color0 > color1) )
+    {
+        UInt16 temp = color0;
+        color0 = color1;
+        color1 = temp;
+    }
+
+    Byte palette[4][4];
+    BuildColorPalette( color0, color1, pFourColors, palette );
+
+    // Equal endpoints read as a 3 colors block in DXT1, the first 3 entries are all that's safe to use.
+    UInt32 paletteSize = (pFourColors && color0 != color1) ? 4 : 3;
+
+    pEncoding.mColor0 = color0;
+    pEncoding.mColor1 = color1;
+    pEncoding.mError  = FindColorIndices( pBlock, palette, paletteSize, pEncoding.mIndices );
+}
+
+static void WriteColorBlock( const ColorEncoding& pEncoding, Byte* pBlock )
+{
+    UInt32 bits = 0;
+    for( UInt32 i = 0; i < 16; i++ )
+        bits |= pEncoding.mIndices[i] << (i * 2);
+
+    pBlock[0] = (Byte)(pEncoding.mColor0 & 0xFF);
+    pBlock[1] = (Byte)(pEncoding.mColor0 >> 8);
+    pBlock[2] = (Byte)(pEncoding.mColor1 & 0xFF);
+    pBlock[3] = (Byte)(pEncoding.mColor1 >> 8);
+    pBlock[4] = (Byte)(bits >> 0);
+    pBlock[5] = (Byte)(bits >> 8);
+    pBlock[6] = (Byte)(bits >> 16);
+    pBlock[7] = (Byte)(bits >> 24);
+}
+
+static void CompressColor( const Byte* pPixels, Bool pDXT1, DXTCodec::Quality pQuality, Byte* pBlock )
+{
+    ColorBlock block( pPixels, pDXT1 );
+
+    ColorEncoding encoding;
+
+    if( block.mNumPoints == 0 )
+    {
+        // Fully transparent.
+        encoding.mColor0 = 0;
+        encoding.mColor1 = 0;
+        memset( encoding.mIndices, 3, sizeof(encoding.mIndices) );
+        WriteColorBlock( encoding, pBlock );
+        return;
+    }
+
+    // Transparent pixels need the 3 colors mode, where entry 3 is transparent black.
+    Bool fourColors = !block.mHasTransparent;
+    Vec4 axis = ComputePrincipalAxis( block );
+
+    Vec4 start, end;
+    RangeFit( block, axis, start, end );
+    EncodeColorEndpoints( block, start, end, fourColors, encoding );
+
+    if( pQuality == DXTCodec::Quality_High && ClusterFit( block, axis, fourColors, start, end ) )
+    {
+        // The cluster fit error is measured before the interpolation is rounded, keep the range fit if it ends up better.
+        ColorEncoding clusterEncoding;
+        EncodeColorEndpoints( block, start, end, fourColors, clusterEncoding );
+
+        if( clusterEncoding.mError < encoding.mError )
+            encoding = clusterEncoding;
+    }
+
+    WriteColorBlock( encoding, pBlock );
+}
+
+static void DecompressColor( const Byte* pBlock, Bool pDXT1, Byte* pPixels )
+{
+    UInt16 color0 = (UInt16)(pBlock[0] | (pBlock[1] << 8));
+    UInt16 color1 = (UInt16)(pBlock[2] | (pBlock[3] << 8));
+    UInt32 bits   = pBlock[4] | (pBlock[5] << 8) | (pBlock[6] << 16) | (pBlock[7] << 24);
+
+    // DXT3 and DXT5 color blocks are always in 4 colors mode.
+    Byte palette[4][4];
+    BuildColorPalette( color0, color1, !pDXT1 || color0 > color1, palette );
+
+    for( UInt32 i = 0; i < 16; i++ )
+        memcpy( pPixels + i * 4, palette[(bits >> (i * 2)) & 3], 4 );
+}
+
+static void CompressAlphaDXT3( const Byte* pPixels, Byte* pBlock )
+{
+    for( UInt32 i = 0; i < 8; i++ )
+    {
+        UInt32 alpha0 = (pPixels[(i * 2 + 0) * 4 + 3] + 8) / 17;
+        UInt32 alpha1 = (pPixels[(i * 2 + 1) * 4 + 3] + 8) / 17;
+
+        pBlock[i] = (Byte)(alpha0 | (alpha1 << 4));
+    }
+}
+
+static void DecompressAlphaDXT3( const Byte* pBlock, Byte* pPixels )
+{
+    for( UInt32 i = 0; i < 16; i++ )
+        pPixels[i * 4 + 3] = (Byte)(((pBlock[i / 2] >> ((i & 1) * 4)) & 0x0F) * 17);
+}
+
+//! 8 interpolated values if pAlpha0 > pAlpha1, 6 interpolated values plus 0 and 255 otherwise.
+static void BuildAlphaPalette( UInt32 pAlpha0, UInt32 pAlpha1, Byte* pPalette )
+{
+    pPalette[0] = (Byte)pAlpha0;
+    pPalette[1] = (Byte)pAlpha1;
+
+    if( pAlpha0 > pAlpha1 )
+    {
+        for( UInt32 i = 1; i < 7; i++ )
+            pPalette[i + 1] = (Byte)(((7 - i) * pAlpha0 + i * pAlpha1) / 7);
+    }
+    else
+    {
+        for( UInt32 i = 1; i < 5; i++ )
+            pPalette[i + 1] = (Byte)(((5 - i) * pAlpha0 + i * pAlpha1) / 5);
+
+        pPalette[6] = 0;
+        pPalette[7] = 255;
+    }
+}
+
+//! Pick the nearest palette entry of each alpha, return the sum of the squared differences.
+static UInt32 FindAlphaIndices( const Byte* pPixels, UInt32 pAlpha0, UInt32 pAlpha1, Byte* pIndices )
+{
+    Byte palette[8];
+    BuildAlphaPalette( pAlpha0, pAlpha1, palette );
+
+    UInt32 error = 0;
+    for( UInt32 i = 0; i < 16; i++ )
+    {
+        Int32  alpha    = pPixels[i * 4 + 3];
+        UInt32 bestDist = 0xFFFFFFFF;
+
+        for( UInt32 p = 0; p < 8; p++ )
+        {
+            UInt32 dist = (alpha - palette[p]) * (alpha - palette[p]);
+            if( dist < bestDist )
+            {
+                bestDist    = dist;
+                pIndices[i] = (Byte)p;
+            }
+        }
+
+        error += bestDist;
+    }
+
+    return error;
+}
+
+static void CompressAlphaDXT5( const Byte* pPixels, Byte* pBlock )
+{
+    UInt32 minAlpha = 255;
+    UInt32 maxAlpha = 0;
+
+    // Range of the alphas that aren't exactly represented in the 6 values mode.
+    UInt32 minInner = 255;
+    UInt32 maxInner = 0;
+
+    for( UInt32 i = 0; i < 16; i++ )
+    {
+        UInt32 alpha = pPixels[i * 4 + 3];
+
+        minAlpha = Maths::Min( minAlpha, alpha );
+        maxAlpha = Maths::Max( maxAlpha, alpha );
+
+        if( alpha != 0 && alpha != 255 )
+        {
+            minInner = Maths::Min( minInner, alpha );
+            maxInner = Maths::Max( maxInner, alpha );
+        }
+    }
+
+    Byte   indices[16];
+    UInt32 alpha0 = maxAlpha;
+    UInt32 alpha1 = minAlpha;
+    UInt32 error  = FindAlphaIndices( pPixels, alpha0, alpha1, indices );
+
+    // Blocks mixing fully transparent or opaque pixels with others are usually better in 6 values mode.
+    if( minInner <= maxInner && error > 0 )
+    {
+        Byte   indices6[16];
+        UInt32 error6 = FindAlphaIndices( pPixels, minInner, maxInner, indices6 );
+
+        if( error6 < error )
+        {
+            alpha0 = minInner;
+            alpha1 = maxInner;
+            memcpy( indices, indices6, sizeof(indices) );
+        }
+    }
+
+    pBlock[0] = (Byte)alpha0;
+    pBlock[1] = (Byte)alpha1;
+
+    // Two groups of 8 indices of 3 bits.
+    for( UInt32 group = 0; group < 2; group++ )
+    {
+        UInt32 bits = 0;
+        for( UInt32 i = 0; i < 8; i++ )
+            bits |= indices[group * 8 + i] << (i * 3);
+
+        pBlock[2 + group * 3] = (Byte)(bits >> 0);
+        pBlock[3 + group * 3] = (Byte)(bits >> 8);
+        pBlock[4 + group * 3] = (Byte)(bits >> 16);
+    }
+}
+
+static void DecompressAlphaDXT5( const Byte* pBlock, Byte* pPixels )
+{
+    Byte palette[8];
+    BuildAlphaPalette( pBlock[0], pBlock[1], palette );
+
+    for( UInt32 group = 0; group < 2; group++ )
+    {
+        const Byte* src  = pBlock + 2 + group * 3;
+        UInt32      bits = src[0] | (src[1] << 8) | (src[2] << 16);
+
+        for( UInt32 i = 0; i < 8; i++ )
+            pPixels[(group * 8 + i) * 4 + 3] = palette[(bits >> (i * 3)) & 0x07];
+    }
+}
+
+//! Read a pixel of an uncompressed format as RGBA.
+static inline void ReadPixel( const Byte* pSrc, Image::Format pFormat, Byte* pRGBA )
+{
+    switch( pFormat )
+    {
+    case Image::Format_L8:
+        pRGBA[0] = pRGBA[1] = pRGBA[2] = pSrc[0];
+        pRGBA[3] = 255;
+        break;
+
+    case Image::Format_A8:
+        pRGBA[0] = pRGBA[1] = pRGBA[2] = 255;
+        pRGBA[3] = pSrc[0];
+        break;
+
+    case Image::Format_L8A8:
+        pRGBA[0] = pRGBA[1] = pRGBA[2] = pSrc[0];
+        pRGBA[3] = pSrc[1];
+        break;
+
+    case Image::Format_R8G8B8:
+        pRGBA[0] = pSrc[0];
+        pRGBA[1] = pSrc[1];
+        pRGBA[2] = pSrc[2];
+        pRGBA[3] = 255;
+        break;
+
+    case Image::Format_R8G8B8A8:
+        memcpy( pRGBA, pSrc, 4 );
+        break;
+
+    case Image::Format_B8G8R8:
+        pRGBA[0] = pSrc[2];
+        pRGBA[1] = pSrc[1];
+        pRGBA[2] = pSrc[0];
+        pRGBA[3] = 255;
+        break;
+
+    case Image::Format_B8G8R8A8:
+        pRGBA[0] = pSrc[2];
+        pRGBA[1] = pSrc[1];
+        pRGBA[2] = pSrc[0];
+        pRGBA[3] = pSrc[3];
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+/**
+ *  Compress a range of block rows of one mipmap. Blocks that go past the border
+ *  of the image repeat the last row and column.
+ */
+class DXTCompressBody : public ParallelForBody
+{
+public:
+    DXTCompressBody( const Byte* pSrc, Image::Format pSrcFormat, UInt32 pWidth, UInt32 pHeight,
+                     Byte* pDst, Image::Format pDstFormat, DXTCodec::Quality pQuality )
+        : mSrc(pSrc)
+        , mSrcFormat(pSrcFormat)
+        , mWidth(pWidth)
+        , mHeight(pHeight)
+        , mDst(pDst)
+        , mDstFormat(pDstFormat)
+        , mQuality(pQuality)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        UInt32 pixelSize  = Image::GetNumChannels( mSrcFormat );
+        UInt32 blockSize  = Image::GetSize( mDstFormat, 4, 4 );
+        UInt32 numBlocksX = (mWidth + 3) / 4;
+        Byte   pixels[16 * 4];
+
+        for( UInt32 blockY = pBegin; blockY < pEnd; blockY++ )
+        {
+            Byte* dst = mDst + blockY * numBlocksX * blockSize;
+
+            for( UInt32 blockX = 0; blockX < numBlocksX; blockX++, dst += blockSize )
+            {
+                for( UInt32 y = 0; y < 4; y++ )
+                {
+                    UInt32 srcY = Maths::Min( blockY * 4 + y, mHeight - 1 );
+
+                    for( UInt32 x = 0; x < 4; x++ )
+                    {
+                        UInt32 srcX = Maths::Min( blockX * 4 + x, mWidth - 1 );
+                        ReadPixel( mSrc + (srcY * mWidth + srcX) * pixelSize, mSrcFormat, &pixels[(y * 4 + x) * 4] );
+                    }
+                }
+
+                DXTCodec::CompressBlock( pixels, mDstFormat, mQuality, dst );
+            }
+        }
+    }
+
+private:
+    const Byte*         mSrc;
+    Image::Format       mSrcFormat;
+    UInt32              mWidth;
+    UInt32              mHeight;
+    Byte*               mDst;
+    Image::Format       mDstFormat;
+    DXTCodec::Quality   mQuality;
+};
+
+
+/**
+ *  Decompress a range of block rows of one mipmap to RGBA.
+ */
+class DXTDecompressBody : public ParallelForBody
+{
+public:
+    DXTDecompressBody( const Byte* pSrc, Image::Format pSrcFormat, UInt32 pWidth, UInt32 pHeight, Byte* pDst )
+        : mSrc(pSrc)
+        , mSrcFormat(pSrcFormat)
+        , mWidth(pWidth)
+        , mHeight(pHeight)
+        , mDst(pDst)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        UInt32 blockSize  = Image::GetSize( mSrcFormat, 4, 4 );
+        UInt32 numBlocksX = (mWidth + 3) / 4;
+        Byte   pixels[16 * 4];
+
+        for( UInt32 blockY = pBegin; blockY < pEnd; blockY++ )
+        {
+            const Byte* src = mSrc + blockY * numBlocksX * blockSize;
+
+            UInt32 rows = Maths::Min<UInt32>( mHeight - blockY * 4, 4 );
+
+            for( UInt32 blockX = 0; blockX < numBlocksX; blockX++, src += blockSize )
+            {
+                DXTCodec::DecompressBlock( src, mSrcFormat, pixels );
+
+                UInt32 columns = Maths::Min<UInt32>( mWidth - blockX * 4, 4 );
+
+                for( UInt32 y = 0; y < rows; y++ )
+                    memcpy( mDst + ((blockY * 4 + y) * mWidth + blockX * 4) * 4, &pixels[y * 16], columns * 4 );
+            }
+        }
+    }
+
+private:
+    const Byte*     mSrc;
+    Image::Format   mSrcFormat;
+    UInt32          mWidth;
+    UInt32          mHeight;
+    Byte*           mDst;
+};
+
+
+void DXTCodec::Compress( const Image& pSource, Image::Format pFormat, Quality pQuality, Image& pDest )
+{
+    GD_ASSERT_M( !pSource.IsCompressed(), "[DXTCodec::Compress] Image is already compressed!" );
+    GD_ASSERT_M( Image::IsCompressed(pFormat), "[DXTCodec::Compress] Destination format must be DXT1, DXT3 or DXT5!" );
+    GD_ASSERT_M( !pSource.IsVolume(), "[DXTCodec::Compress] Volume images are not supported!" );
+
+    pDest.Create( pSource.GetWidth(), pSource.GetHeight(), pFormat, pSource.GetNumMipmaps() );
+
+    const Byte* src    = pSource.GetData();
+    Byte*       dst    = pDest.GetData();
+    UInt32      width  = pSource.GetWidth();
+    UInt32      height = pSource.GetHeight();
+
+    for( UInt32 level = 0; level < pSource.GetNumMipmaps(); level++ )
+    {
+        DXTCompressBody compressBody( src, pSource.GetFormat(), width, height, dst, pFormat, pQuality );
+        JobManager::Instance()->ParallelFor( (height + 3) / 4, BLOCK_ROWS_PER_JOB, compressBody );
+
+        src += Image::GetSize( pSource.GetFormat(), width, height );
+        dst += Image::GetSize( pFormat, width, height );
+
+        width  = Maths::Max<UInt32>( width >> 1, 1 );
+        height = Maths::Max<UInt32>( height >> 1, 1 );
+    }
+}
+
+void DXTCodec::Decompress( const Image& pSource, Image& pDest )
+{
+    GD_ASSERT_M( pSource.IsCompressed(), "[DXTCodec::Decompress] Image is not compressed!" );
+
+    pDest.Create( pSource.GetWidth(), pSource.GetHeight(), Image::Format_R8G8B8A8, pSource.GetNumMipmaps() );
+
+    const Byte* src    = pSource.GetData();
+    Byte*       dst    = pDest.GetData();
+    UInt32      width  = pSource.GetWidth();
+    UInt32      height = pSource.GetHeight();
+
+    for( UInt32 level = 0; level < pSource.GetNumMipmaps(); level++ )
+    {
+        DXTDecompressBody decompressBody( src, pSource.GetFormat(), width, height, dst );
+        JobManager::Instance()->ParallelFor( (height + 3) / 4, BLOCK_ROWS_PER_JOB, decompressBody );
+
+        src += Image::GetSize( pSource.GetFormat(), width, height );
+        dst += Image::GetSize( Image::Format_R8G8B8A8, width, height );
+
+        width  = Maths::Max<UInt32>( width >> 1, 1 );
+        height = Maths::Max<UInt32>( height >> 1, 1 );
+    }
+}
+
+void DXTCodec::CompressBlock( const Byte* pPixels, Image::Format pFormat, Quality pQuality, Byte* pBlock )
+{
+    switch( pFormat )
+    {
+    case Image::Format_DXT1:
+        CompressColor( pPixels, true, pQuality, pBlock );
+        break;
+
+    case Image::Format_DXT3:
+        CompressAlphaDXT3( pPixels, pBlock );
+        CompressColor( pPixels, false, pQuality, pBlock + 8 );
+        break;
+
+    case Image::Format_DXT5:
+        CompressAlphaDXT5( pPixels, pBlock );
+        CompressColor( pPixels, false, pQuality, pBlock + 8 );
+        break;
+
+    default:
+        GD_ASSERT_M( false, "[DXTCodec::CompressBlock] Not a DXT format!" );
+        break;
+    }
+}
+
+void DXTCodec::DecompressBlock( const Byte* pBlock, Image::Format pFormat, Byte* pPixels )
+{
+    switch( pFormat )
+    {
+    case Image::Format_DXT1:
+        DecompressColor( pBlock, true, pPixels );
+        break;
+
+    case Image::Format_DXT3:
+        DecompressColor( pBlock + 8, false, pPixels );
+        DecompressAlphaDXT3( pBlock, pPixels );
+        break;
+
+    case Image::Format_DXT5:
+        DecompressColor( pBlock + 8, false, pPixels );
+        DecompressAlphaDXT5( pBlock, pPixels );
+        break;
+
+    default:
+        GD_ASSERT_M( false, "[DXTCodec::DecompressBlock] Not a DXT format!" );
+        break;
+    }
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,76 @@
+/**
+ *  @file       DXTCodec.h
+ *  @brief      DXT1/3/5 (S3TC) block compression.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _DXT_CODEC_H_
+#define     _DXT_CODEC_H_
+
+
+#include "Image.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Encode and decode DXT1, DXT3 and DXT5 images. Each 4x4 block is independent,
+ *  images are processed by rows of blocks in parallel over the JobManager.
+ *  Pixels are exchanged as RGBA bytes; DXT1 stores pixels with alpha < 128 as
+ *  transparent black.
+ */
+class ENGINE_API DXTCodec
+{
+public:
+    enum Quality
+    {
+        Quality_Fast,   //!< Range fit: endpoints are the extreme colors along the principal axis.
+        Quality_High    //!< Cluster fit: least squares endpoints for every ordering of the block along its principal axis.
+    };
+
+public:
+    /**
+     *  Compress every mipmap of an uncompressed 2D image.
+     *  Sizes that are not a multiple of 4 are padded by repeating the border pixels.
+     *  @param  pSource     Image to compress.
+     *  @param  pFormat     Format_DXT1, Format_DXT3 or Format_DXT5.
+     *  @param  pQuality    Method used to fit the color endpoints.
+     *  @param  pDest       Receives the compressed image.
+     */
+    static void Compress( const Image& pSource, Image::Format pFormat, Quality pQuality, Image& pDest );
+
+    //! Decompress every mipmap of a DXT image to Format_R8G8B8A8.
+    static void Decompress( const Image& pSource, Image& pDest );
+
+    //! Compress 16 RGBA pixels (4 rows of 4 pixels) to a block of pFormat.
+    static void CompressBlock( const Byte* pPixels, Image::Format pFormat, Quality pQuality, Byte* pBlock );
+
+    //! Decompress a block of pFormat to 16 RGBA pixels (4 rows of 4 pixels).
+    static void DecompressBlock( const Byte* pBlock, Image::Format pFormat, Byte* pPixels );
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _DXT_CODEC_H_
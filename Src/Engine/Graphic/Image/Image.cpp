@@ -27,8 +27,15 @@
 */
 #include "Engine.h"
 #include "Image.h"
+#include "DXTCodec.h"
 
 #include "Maths/Maths.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Thread/JobManager.h"
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    #include <emmintrin.h>
+#endif
 
 
 namespace Gamedesk {
@@ -50,6 +57,867 @@ const UInt32 SIZE_TABLE[Image::Format_Num] =
 };
 
 
+//! Rows processed by each job when an image is processed in parallel.
+static const UInt32 ROWS_PER_JOB    = 32;
+
+//! Pixels processed by each job when the image layout doesn't matter.
+static const UInt32 PIXELS_PER_JOB  = 64*1024;
+
+
+static Bool CanUseSSE2()
+{
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    return SystemInfo::Instance()->CpuSupportSSE2();
+#else
+    return false;
+#endif
+}
+
+
+/**
+ *  Change the intensity of a range of rows. Each pixel is multiplied by the
+ *  gamma factor, pixels that would saturate are scaled so their brightest
+ *  color component ends up at 255, which keeps their hue. The components
+ *  past pNumColors (alpha) are left as is.
+ */
+class ImageGammaBody : public ParallelForBody
+{
+public:
+    ImageGammaBody( Byte* pData, UInt32 pRowSize, UInt32 pNumComponents, UInt32 pNumColors, Float pGamma )
+        : mData(pData)
+        , mRowSize(pRowSize)
+        , mNumComponents(pNumComponents)
+        , mNumColors(pNumColors)
+        , mMaxUnsaturated(0)
+    {
+        for( UInt32 i = 0; i < 256; i++ )
+        {
+            Float scaled = i * pGamma;
+            if( scaled <= 255.0f )
+                mMaxUnsaturated = i;
+
+            mScaled[i] = (Byte)Maths::Min( scaled, 255.0f );
+
+            // Rounded up so (c * mReciprocal[m]) >> 16 == (c * 255) / m for any c <= m.
+            mReciprocal[i] = i ? (255*65536 + i - 1) / i : 0;
+        }
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        Byte*       data = mData + pBegin * mRowSize;
+        const Byte* end  = mData + pEnd * mRowSize;
+
+        for( ; data < end; data += mNumComponents )
+        {
+            UInt32 maxComponent = data[0];
+            for( UInt32 j = 1; j < mNumColors; j++ )
+                maxComponent = Maths::Max<UInt32>( maxComponent, data[j] );
+
+            if( maxComponent <= mMaxUnsaturated )
+            {
+                for( UInt32 j = 0; j < mNumColors; j++ )
+                    data[j] = mScaled[data[j]];
+            }
+            else
+            {
+                UInt32 reciprocal = mReciprocal[maxComponent];
+                for( UInt32 j = 0; j < mNumColors; j++ )
+                    data[j] = (Byte)((data[j] * reciprocal) >> 16);
+            }
+        }
+    }
+
+private:
+    Byte*       mData;
+    UInt32      mRowSize;
+    UInt32      mNumComponents;
+    UInt32      mNumColors;
+    UInt32      mMaxUnsaturated;    //!< Highest component value that doesn't saturate.
+    Byte        mScaled[256];
+    UInt32      mReciprocal[256];
+};
+
+
+/**
+ *  Convert a range of pixels to luminance.
+ */
+class ImageGrayscaleBody : public ParallelForBody
+{
+public:
+    ImageGrayscaleBody( const Byte* pSrc, Byte* pDest, UInt32 pNumChannels, Bool pBGR, Bool pUseSSE2 )
+        : mSrc(pSrc)
+        , mDest(pDest)
+        , mNumChannels(pNumChannels)
+        , mUseSSE2(pUseSSE2)
+    {
+        mWeights[0] = pBGR ? 28 : 77;
+        mWeights[1] = 151;
+        mWeights[2] = pBGR ? 77 : 28;
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        const Byte* src  = mSrc + pBegin * mNumChannels;
+        Byte*       dest = mDest + pBegin;
+        UInt32      i    = pBegin;
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+        if( mUseSSE2 && mNumChannels == 4 )
+        {
+            const __m128i zero    = _mm_setzero_si128();
+            const __m128i round   = _mm_set1_epi32( 128 );
+            const __m128i weights = _mm_setr_epi16( mWeights[0], mWeights[1], mWeights[2], 0,
+                                                    mWeights[0], mWeights[1], mWeights[2], 0 );
+
+            for( ; i + 4 <= pEnd; i += 4, src += 16, dest += 4 )
+            {
+                __m128i pixels = _mm_loadu_si128( (const __m128i*)src );
+
+                // (c0*w0 + c1*w1, c2*w2) for each pixel.
+                __m128i lo = _mm_madd_epi16( _mm_unpacklo_epi8( pixels, zero ), weights );
+                __m128i hi = _mm_madd_epi16( _mm_unpackhi_epi8( pixels, zero ), weights );
+                lo = _mm_add_epi32( lo, _mm_shuffle_epi32( lo, _MM_SHUFFLE(2,3,0,1) ) );
+                hi = _mm_add_epi32( hi, _mm_shuffle_epi32( hi, _MM_SHUFFLE(2,3,0,1) ) );
+
+                __m128i sums = _mm_unpacklo_epi64( _mm_shuffle_epi32( lo, _MM_SHUFFLE(3,3,2,0) ),
+                                                   _mm_shuffle_epi32( hi, _MM_SHUFFLE(3,3,2,0) ) );
+                sums = _mm_srli_epi32( _mm_add_epi32( sums, round ), 8 );
+                sums = _mm_packs_epi32( sums, sums );
+                sums = _mm_packus_epi16( sums, sums );
+
+                *(Int32*)dest = _mm_cvtsi128_si32( sums );
+            }
+        }
+#endif
+
+        for( ; i < pEnd; i++, src += mNumChannels, dest++ )
+            *dest = (Byte)((mWeights[0] * src[0] + mWeights[1] * src[1] + mWeights[2] * src[2] + 128) >> 8);
+    }
+
+private:
+    const Byte* mSrc;
+    Byte*       mDest;
+    UInt32      mNumChannels;
+    Bool        mUseSSE2;
+    Int16       mWeights[3];
+};
+
+
+//! Sobel filter on one pixel of a height map, output an RGB normal.
+static inline void SobelPixel( const Byte* pRow0, const Byte* pRow1, const Byte* pRow2, UInt32 pPredX, UInt32 pX, UInt32 pSuccX, Byte* pDest )
+{
+    UInt32 sx = (pRow0[pPredX] + 2 * pRow1[pPredX] + pRow2[pPredX]) - (pRow0[pSuccX] + 2 * pRow1[pSuccX] + pRow2[pSuccX]);
+    UInt32 sy = (pRow0[pPredX] + 2 * pRow0[pX]     + pRow0[pSuccX]) - (pRow2[pPredX] + 2 * pRow2[pX]     + pRow2[pSuccX]);
+
+    UInt32 len = UInt32(Float(0x000FF000) / sqrtf(Float(sx * sx + sy * sy + 256*256)));
+    sx *= len;
+    sy *= len;
+
+    pDest[0] = (Byte)((sx  + 0x000FF000) >> 13);
+    pDest[1] = (Byte)((sy  + 0x000FF000) >> 13);
+    pDest[2] = (Byte)((len + 0x00000FF0) >> 5);
+}
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+//! Sobel filter on the 8 pixels starting at pX, pX-1 and pX+8 must be in the row.
+static inline void SobelPixelsSSE2( const Byte* pRow0, const Byte* pRow1, const Byte* pRow2, UInt32 pX, Byte* pDest )
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    #define LOAD_8_PIXELS(p) _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*)(p) ), zero )
+    __m128i pred0 = LOAD_8_PIXELS( pRow0 + pX - 1 );
+    __m128i cur0  = LOAD_8_PIXELS( pRow0 + pX );
+    __m128i succ0 = LOAD_8_PIXELS( pRow0 + pX + 1 );
+    __m128i pred1 = LOAD_8_PIXELS( pRow1 + pX - 1 );
+    __m128i succ1 = LOAD_8_PIXELS( pRow1 + pX + 1 );
+    __m128i pred2 = LOAD_8_PIXELS( pRow2 + pX - 1 );
+    __m128i cur2  = LOAD_8_PIXELS( pRow2 + pX );
+    __m128i succ2 = LOAD_8_PIXELS( pRow2 + pX + 1 );
+    #undef LOAD_8_PIXELS
+
+    // Fits in 16 bits, |sx| and |sy| are at most 4*255.
+    __m128i sx = _mm_sub_epi16( _mm_add_epi16( _mm_add_epi16( pred0, pred2 ), _mm_slli_epi16( pred1, 1 ) ),
+                                _mm_add_epi16( _mm_add_epi16( succ0, succ2 ), _mm_slli_epi16( succ1, 1 ) ) );
+    __m128i sy = _mm_sub_epi16( _mm_add_epi16( _mm_add_epi16( pred0, succ0 ), _mm_slli_epi16( cur0, 1 ) ),
+                                _mm_add_epi16( _mm_add_epi16( pred2, succ2 ), _mm_slli_epi16( cur2, 1 ) ) );
+
+    // Same fixed point math as SobelPixel(), every intermediate value is an
+    // integer small enough to be exact in a float.
+    const __m128 scale     = _mm_set1_ps( Float(0x000FF000) );
+    const __m128 bias      = _mm_set1_ps( Float(0x000FF000) );
+    const __m128 biasZ     = _mm_set1_ps( Float(0x00000FF0) );
+    const __m128 shiftXY   = _mm_set1_ps( 1.0f / 8192.0f );
+    const __m128 shiftZ    = _mm_set1_ps( 1.0f / 32.0f );
+    const __m128 flat      = _mm_set1_ps( 256.0f * 256.0f );
+
+    Int32 normals[3][8];
+    for( UInt32 half = 0; half < 2; half++ )
+    {
+        __m128i sx32 = half ? _mm_unpackhi_epi16( sx, sx ) : _mm_unpacklo_epi16( sx, sx );
+        __m128i sy32 = half ? _mm_unpackhi_epi16( sy, sy ) : _mm_unpacklo_epi16( sy, sy );
+        __m128  fx   = _mm_cvtepi32_ps( _mm_srai_epi32( sx32, 16 ) );
+        __m128  fy   = _mm_cvtepi32_ps( _mm_srai_epi32( sy32, 16 ) );
+
+        __m128  lenSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( fx, fx ), _mm_mul_ps( fy, fy ) ), flat );
+        __m128  len   = _mm_cvtepi32_ps( _mm_cvttps_epi32( _mm_div_ps( scale, _mm_sqrt_ps( lenSq ) ) ) );
+
+        __m128i nx = _mm_cvttps_epi32( _mm_mul_ps( _mm_add_ps( _mm_mul_ps( fx, len ), bias ), shiftXY ) );
+        __m128i ny = _mm_cvttps_epi32( _mm_mul_ps( _mm_add_ps( _mm_mul_ps( fy, len ), bias ), shiftXY ) );
+        __m128i nz = _mm_cvttps_epi32( _mm_mul_ps( _mm_add_ps( len, biasZ ), shiftZ ) );
+
+        _mm_storeu_si128( (__m128i*)&normals[0][half*4], nx );
+        _mm_storeu_si128( (__m128i*)&normals[1][half*4], ny );
+        _mm_storeu_si128( (__m128i*)&normals[2][half*4], nz );
+    }
+
+    for( UInt32 i = 0; i < 8; i++, pDest += 3 )
+    {
+        pDest[0] = (Byte)normals[0][i];
+        pDest[1] = (Byte)normals[1][i];
+        pDest[2] = (Byte)normals[2][i];
+    }
+}
+#endif
+
+/**
+ *  Build a range of rows of a normal map from a height map (one mip level).
+ *  The image wraps around, so edge pixels use the opposite edge as neighbours.
+ */
+class ImageNormalMapBody : public ParallelForBody
+{
+public:
+    ImageNormalMapBody( const Byte* pSrc, Byte* pDest, UInt32 pWidth, UInt32 pHeight, Bool pUseSSE2 )
+        : mSrc(pSrc)
+        , mDest(pDest)
+        , mWidth(pWidth)
+        , mHeight(pHeight)
+        , mUseSSE2(pUseSSE2)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 y = pBegin; y < pEnd; y++ )
+        {
+            const Byte* row0 = mSrc + ((y + mHeight - 1) % mHeight) * mWidth;
+            const Byte* row1 = mSrc + y * mWidth;
+            const Byte* row2 = mSrc + ((y + 1) % mHeight) * mWidth;
+            Byte*       dest = mDest + y * mWidth * 3;
+
+            UInt32 x = 0;
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+            if( mUseSSE2 && mWidth > 9 )
+            {
+                SobelPixel( row0, row1, row2, mWidth - 1, 0, 1, dest );
+
+                for( x = 1; x + 8 < mWidth; x += 8 )
+                    SobelPixelsSSE2( row0, row1, row2, x, dest + x * 3 );
+            }
+#endif
+
+            for( ; x < mWidth; x++ )
+            {
+                UInt32 predX = x == 0 ? mWidth - 1 : x - 1;
+                UInt32 succX = x + 1 == mWidth ? 0 : x + 1;
+                SobelPixel( row0, row1, row2, predX, x, succX, dest + x * 3 );
+            }
+        }
+    }
+
+private:
+    const Byte* mSrc;
+    Byte*       mDest;
+    UInt32      mWidth;
+    UInt32      mHeight;
+    Bool        mUseSSE2;
+};
+
+
+//! Swap the content of two non overlapping buffers.
+static inline void SwapMemory( Byte* pFirst, Byte* pSecond, UInt32 pSize )
+{
+    Byte swapTmp[512];
+
+    while( pSize )
+    {
+        UInt32 size = Maths::Min<UInt32>( pSize, sizeof(swapTmp) );
+
+        memcpy( swapTmp, pFirst, size );
+        memcpy( pFirst, pSecond, size );
+        memcpy( pSecond, swapTmp, size );
+
+        pFirst  += size;
+        pSecond += size;
+        pSize   -= size;
+    }
+}
+
+/**
+ *  Swap a range of rows with the rows at the opposite side of the image.
+ */
+class ImageFlipBody : public ParallelForBody
+{
+public:
+    ImageFlipBody( Byte* pData, UInt32 pLineSize, UInt32 pHeight )
+        : mData(pData)
+        , mLineSize(pLineSize)
+        , mHeight(pHeight)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+            SwapMemory( mData + i * mLineSize, mData + (mHeight - 1 - i) * mLineSize, mLineSize );
+    }
+
+private:
+    Byte*       mData;
+    UInt32      mLineSize;
+    UInt32      mHeight;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Mipmap generation
+
+
+//! Samples taken in each source pixel to integrate the filters.
+static const UInt32 FILTER_SAMPLES  = 8;
+
+//! Precision of the linear to sRGB conversion table.
+static const UInt32 SRGB_TABLE_SIZE = 16384;
+
+
+/**
+ *  Reconstruction filter used to downsample an image. The filter is expressed
+ *  in destination pixels, it is stretched by the downsampling factor.
+ */
+class MipmapFilterKernel
+{
+public:
+    virtual ~MipmapFilterKernel() {}
+
+    //! Radius of the filter support.
+    virtual Float GetWidth() const = 0;
+
+    virtual Float Evaluate( Float pX ) const = 0;
+};
+
+static Float Sinc( Float pX )
+{
+    if( Maths::Abs(pX) < 0.0001f )
+        return 1.0f;
+
+    Float x = pX * Maths::PI;
+    return sinf(x) / x;
+}
+
+//! Zero order modified Bessel function of the first kind.
+static Float BesselI0( Float pX )
+{
+    Float sum   = 1.0f;
+    Float term  = 1.0f;
+    Float halfX = pX * 0.5f;
+
+    for( UInt32 k = 1; k < 32 && term > sum * 1e-8f; k++ )
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum  += term;
+    }
+
+    return sum;
+}
+
+class BoxKernel : public MipmapFilterKernel
+{
+public:
+    virtual Float GetWidth() const
+    {
+        return 0.5f;
+    }
+
+    virtual Float Evaluate( Float pX ) const
+    {
+        return Maths::Abs(pX) <= 0.5f ? 1.0f : 0.0f;
+    }
+};
+
+class KaiserKernel : public MipmapFilterKernel
+{
+public:
+    KaiserKernel( Float pWidth = 3.0f, Float pAlpha = 4.0f )
+        : mWidth(pWidth)
+        , mAlpha(pAlpha)
+        , mInvI0Alpha(1.0f / BesselI0(pAlpha))
+    {
+    }
+
+    virtual Float GetWidth() const
+    {
+        return mWidth;
+    }
+
+    virtual Float Evaluate( Float pX ) const
+    {
+        Float t = pX / mWidth;
+        if( t <= -1.0f || t >= 1.0f )
+            return 0.0f;
+
+        return Sinc(pX) * BesselI0( mAlpha * sqrtf(1.0f - t*t) ) * mInvI0Alpha;
+    }
+
+private:
+    Float   mWidth;
+    Float   mAlpha;
+    Float   mInvI0Alpha;
+};
+
+class LanczosKernel : public MipmapFilterKernel
+{
+public:
+    virtual Float GetWidth() const
+    {
+        return 3.0f;
+    }
+
+    virtual Float Evaluate( Float pX ) const
+    {
+        if( pX <= -3.0f || pX >= 3.0f )
+            return 0.0f;
+
+        return Sinc(pX) * Sinc(pX / 3.0f);
+    }
+};
+
+
+/**
+ *  Weights of the source pixels contributing to each destination pixel along
+ *  one axis. Pixels outside of the image are clamped to the edge.
+ */
+class MipmapFilterWeights
+{
+public:
+    struct Tap
+    {
+        UInt32  mIndex;
+        Float   mWeight;
+    };
+
+    void Compute( const MipmapFilterKernel& pKernel, UInt32 pSrcSize, UInt32 pDstSize )
+    {
+        Float scale   = Float(pSrcSize) / Float(pDstSize);
+        Float support = pKernel.GetWidth() * scale;
+
+        mTaps.clear();
+        mFirstTap.resize( pDstSize + 1 );
+
+        for( UInt32 i = 0; i < pDstSize; i++ )
+        {
+            Float center = (i + 0.5f) * scale;
+            Int32 left   = (Int32)floorf( center - support );
+            Int32 right  = (Int32)ceilf( center + support );
+
+            mFirstTap[i] = mTaps.size();
+
+            Float total = 0.0f;
+            for( Int32 s = left; s < right; s++ )
+            {
+                // Integrate the filter over the source pixel.
+                Float weight = 0.0f;
+                for( UInt32 k = 0; k < FILTER_SAMPLES; k++ )
+                    weight += pKernel.Evaluate( (s + (k + 0.5f) / FILTER_SAMPLES - center) / scale );
+                weight /= FILTER_SAMPLES;
+
+                if( weight == 0.0f )
+                    continue;
+
+                UInt32 index = (UInt32)Maths::Min<Int32>( Maths::Max<Int32>( s, 0 ), pSrcSize - 1 );
+                if( mTaps.size() > mFirstTap[i] && mTaps.back().mIndex == index )
+                {
+                    mTaps.back().mWeight += weight;
+                }
+                else
+                {
+                    Tap tap;
+                    tap.mIndex  = index;
+                    tap.mWeight = weight;
+                    mTaps.push_back( tap );
+                }
+
+                total += weight;
+            }
+
+            if( total != 0.0f )
+            {
+                for( UInt32 t = mFirstTap[i]; t < mTaps.size(); t++ )
+                    mTaps[t].mWeight /= total;
+            }
+        }
+
+        mFirstTap[pDstSize] = mTaps.size();
+    }
+
+    const Tap* GetTaps( UInt32 pDst ) const     { return &mTaps[mFirstTap[pDst]]; }
+    UInt32     GetTapCount( UInt32 pDst ) const { return mFirstTap[pDst+1] - mFirstTap[pDst]; }
+
+private:
+    Vector<Tap>     mTaps;
+    Vector<UInt32>  mFirstTap;      //!< Index of the first tap of each destination pixel, plus one past the end.
+};
+
+
+/**
+ *  Conversion between the stored bytes and the linear values that are filtered.
+ */
+class MipmapPixelConverter
+{
+public:
+    MipmapPixelConverter( UInt32 pNumChannels, Int32 pAlphaChannel, Bool pSRGB )
+        : mNumChannels(pNumChannels)
+    {
+        for( UInt32 i = 0; i < 256; i++ )
+        {
+            Float value = i / 255.0f;
+            mFromLinear[i] = value;
+            mFromSRGB[i]   = value <= 0.04045f ? value / 12.92f : powf( (value + 0.055f) / 1.055f, 2.4f );
+        }
+
+        for( UInt32 i = 0; i < SRGB_TABLE_SIZE; i++ )
+        {
+            Float value = i / Float(SRGB_TABLE_SIZE - 1);
+            value = value <= 0.0031308f ? value * 12.92f : 1.055f * powf( value, 1.0f / 2.4f ) - 0.055f;
+            mToSRGB[i] = (Byte)(value * 255.0f + 0.5f);
+        }
+
+        for( UInt32 c = 0; c < pNumChannels; c++ )
+            mIsSRGB[c] = pSRGB && (Int32)c != pAlphaChannel;
+    }
+
+    void Decode( const Byte* pSrc, Float* pDst, UInt32 pNumPixels ) const
+    {
+        for( UInt32 i = 0; i < pNumPixels; i++ )
+        {
+            for( UInt32 c = 0; c < mNumChannels; c++, pSrc++, pDst++ )
+                *pDst = mIsSRGB[c] ? mFromSRGB[*pSrc] : mFromLinear[*pSrc];
+        }
+    }
+
+    void Encode( const Float* pSrc, Byte* pDst, UInt32 pNumPixels ) const
+    {
+        for( UInt32 i = 0; i < pNumPixels; i++ )
+        {
+            for( UInt32 c = 0; c < mNumChannels; c++, pSrc++, pDst++ )
+            {
+                Float value = Maths::Min( Maths::Max( *pSrc, 0.0f ), 1.0f );
+
+                if( mIsSRGB[c] )
+                    *pDst = mToSRGB[(UInt32)(value * (SRGB_TABLE_SIZE - 1) + 0.5f)];
+                else
+                    *pDst = (Byte)(value * 255.0f + 0.5f);
+            }
+        }
+    }
+
+private:
+    UInt32      mNumChannels;
+    Bool        mIsSRGB[4];
+    Float       mFromLinear[256];
+    Float       mFromSRGB[256];
+    Byte        mToSRGB[SRGB_TABLE_SIZE];
+};
+
+
+//! pDst[i] += pWeight * pSrc[i]
+static inline void AccumulateRow( Float* pDst, const Float* pSrc, Float pWeight, UInt32 pCount, Bool pUseSSE2 )
+{
+    UInt32 i = 0;
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    if( pUseSSE2 )
+    {
+        __m128 weight = _mm_set1_ps( pWeight );
+        for( ; i + 4 <= pCount; i += 4 )
+            _mm_storeu_ps( pDst + i, _mm_add_ps( _mm_loadu_ps( pDst + i ), _mm_mul_ps( weight, _mm_loadu_ps( pSrc + i ) ) ) );
+    }
+#endif
+
+    for( ; i < pCount; i++ )
+        pDst[i] += pWeight * pSrc[i];
+}
+
+/**
+ *  Downsample a range of rows of one slice with a separable filter. Each job
+ *  filters horizontally the source rows it needs, then combines them
+ *  vertically. The result is either encoded to bytes or kept as floats (for
+ *  volumes, that still need to be filtered along the depth).
+ */
+class MipmapFilterBody : public ParallelForBody
+{
+public:
+    MipmapFilterBody( const Byte* pSrc, UInt32 pSrcWidth, UInt32 pNumChannels,
+                      const MipmapFilterWeights& pWeightsX, const MipmapFilterWeights& pWeightsY, UInt32 pDstWidth,
+                      const MipmapPixelConverter& pConverter, Byte* pDst, Float* pDstFloat, Bool pUseSSE2 )
+        : mSrc(pSrc)
+        , mSrcWidth(pSrcWidth)
+        , mNumChannels(pNumChannels)
+        , mWeightsX(pWeightsX)
+        , mWeightsY(pWeightsY)
+        , mDstWidth(pDstWidth)
+        , mConverter(pConverter)
+        , mDst(pDst)
+        , mDstFloat(pDstFloat)
+        , mUseSSE2(pUseSSE2)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        UInt32 dstRowSize = mDstWidth * mNumChannels;
+
+        // Source rows needed by this range.
+        UInt32 firstRow = 0xFFFFFFFF;
+        UInt32 lastRow  = 0;
+        for( UInt32 y = pBegin; y < pEnd; y++ )
+        {
+            const MipmapFilterWeights::Tap* taps = mWeightsY.GetTaps(y);
+            for( UInt32 t = 0; t < mWeightsY.GetTapCount(y); t++ )
+            {
+                firstRow = Maths::Min( firstRow, taps[t].mIndex );
+                lastRow  = Maths::Max( lastRow, taps[t].mIndex );
+            }
+        }
+
+        if( firstRow > lastRow )
+            return;
+
+        Vector<Float> srcRow;
+        Vector<Float> filteredRows;
+        Vector<Float> dstRow;
+        srcRow.resize( mSrcWidth * mNumChannels );
+        filteredRows.resize( (lastRow - firstRow + 1) * dstRowSize );
+        dstRow.resize( dstRowSize );
+
+        for( UInt32 row = firstRow; row <= lastRow; row++ )
+        {
+            mConverter.Decode( mSrc + row * mSrcWidth * mNumChannels, &srcRow[0], mSrcWidth );
+            FilterRow( &srcRow[0], &filteredRows[(row - firstRow) * dstRowSize] );
+        }
+
+        for( UInt32 y = pBegin; y < pEnd; y++ )
+        {
+            Float* dst = mDstFloat ? mDstFloat + y * dstRowSize : &dstRow[0];
+            memset( dst, 0, dstRowSize * sizeof(Float) );
+
+            const MipmapFilterWeights::Tap* taps = mWeightsY.GetTaps(y);
+            for( UInt32 t = 0; t < mWeightsY.GetTapCount(y); t++ )
+                AccumulateRow( dst, &filteredRows[(taps[t].mIndex - firstRow) * dstRowSize], taps[t].mWeight, dstRowSize, mUseSSE2 );
+
+            if( mDst )
+                mConverter.Encode( dst, mDst + y * dstRowSize, mDstWidth );
+        }
+    }
+
+private:
+    void FilterRow( const Float* pSrc, Float* pDst ) const
+    {
+        for( UInt32 x = 0; x < mDstWidth; x++, pDst += mNumChannels )
+        {
+            const MipmapFilterWeights::Tap* taps = mWeightsX.GetTaps(x);
+            UInt32 tapCount = mWeightsX.GetTapCount(x);
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+            if( mUseSSE2 && mNumChannels == 4 )
+            {
+                __m128 sum = _mm_setzero_ps();
+                for( UInt32 t = 0; t < tapCount; t++ )
+                    sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( taps[t].mWeight ), _mm_loadu_ps( pSrc + taps[t].mIndex * 4 ) ) );
+                _mm_storeu_ps( pDst, sum );
+                continue;
+            }
+#endif
+
+            for( UInt32 c = 0; c < mNumChannels; c++ )
+            {
+                Float sum = 0.0f;
+                for( UInt32 t = 0; t < tapCount; t++ )
+                    sum += taps[t].mWeight * pSrc[taps[t].mIndex * mNumChannels + c];
+                pDst[c] = sum;
+            }
+        }
+    }
+
+private:
+    const Byte*                 mSrc;
+    UInt32                      mSrcWidth;
+    UInt32                      mNumChannels;
+    const MipmapFilterWeights&  mWeightsX;
+    const MipmapFilterWeights&  mWeightsY;
+    UInt32                      mDstWidth;
+    const MipmapPixelConverter& mConverter;
+    Byte*                       mDst;
+    Float*                      mDstFloat;
+    Bool                        mUseSSE2;
+};
+
+/**
+ *  Filter along the depth the slices produced by MipmapFilterBody. Each item
+ *  is a row of the destination volume (slice * height + y).
+ */
+class MipmapFilterDepthBody : public ParallelForBody
+{
+public:
+    MipmapFilterDepthBody( const Vector<Float>& pSlices, UInt32 pSliceSize, UInt32 pRowSize, UInt32 pHeight,
+                           const MipmapFilterWeights& pWeightsZ, const MipmapPixelConverter& pConverter, UInt32 pWidth, Byte* pDst, Bool pUseSSE2 )
+        : mSlices(pSlices)
+        , mSliceSize(pSliceSize)
+        , mRowSize(pRowSize)
+        , mHeight(pHeight)
+        , mWeightsZ(pWeightsZ)
+        , mConverter(pConverter)
+        , mWidth(pWidth)
+        , mDst(pDst)
+        , mUseSSE2(pUseSSE2)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        Vector<Float> dstRow;
+        dstRow.resize( mRowSize );
+
+        for( UInt32 row = pBegin; row < pEnd; row++ )
+        {
+            UInt32 z = row / mHeight;
+            UInt32 y = row % mHeight;
+
+            memset( &dstRow[0], 0, mRowSize * sizeof(Float) );
+
+            const MipmapFilterWeights::Tap* taps = mWeightsZ.GetTaps(z);
+            for( UInt32 t = 0; t < mWeightsZ.GetTapCount(z); t++ )
+                AccumulateRow( &dstRow[0], &mSlices[taps[t].mIndex * mSliceSize + y * mRowSize], taps[t].mWeight, mRowSize, mUseSSE2 );
+
+            mConverter.Encode( &dstRow[0], mDst + row * mRowSize, mWidth );
+        }
+    }
+
+private:
+    const Vector<Float>&        mSlices;
+    UInt32                      mSliceSize;
+    UInt32                      mRowSize;
+    UInt32                      mHeight;
+    const MipmapFilterWeights&  mWeightsZ;
+    const MipmapPixelConverter& mConverter;
+    UInt32                      mWidth;
+    Byte*                       mDst;
+    Bool                        mUseSSE2;
+};
+
+/**
+ *  Box filter for dimensions that are even (or 1), averaging 2x2 (2x2x2 for
+ *  volumes) blocks of bytes directly. Each item is a row of the destination
+ *  (slice * height + y).
+ */
+class MipmapBoxBody : public ParallelForBody
+{
+public:
+    MipmapBoxBody( const Byte* pSrc, UInt32 pSrcWidth, UInt32 pSrcHeight, UInt32 pSrcDepth,
+                   Byte* pDst, UInt32 pDstWidth, UInt32 pDstHeight, UInt32 pNumChannels, Bool pUseSSE2 )
+        : mSrc(pSrc)
+        , mSrcWidth(pSrcWidth)
+        , mSrcHeight(pSrcHeight)
+        , mSrcDepth(pSrcDepth)
+        , mDst(pDst)
+        , mDstWidth(pDstWidth)
+        , mDstHeight(pDstHeight)
+        , mNumChannels(pNumChannels)
+        , mUseSSE2(pUseSSE2)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        UInt32 srcRowSize   = mSrcWidth * mNumChannels;
+        UInt32 srcSliceSize = srcRowSize * mSrcHeight;
+        UInt32 dstRowSize   = mDstWidth * mNumChannels;
+
+        for( UInt32 row = pBegin; row < pEnd; row++ )
+        {
+            UInt32 z = row / mDstHeight;
+            UInt32 y = row % mDstHeight;
+
+            // Source rows averaged in this destination row.
+            const Byte* rows[4];
+            UInt32      numRows = 0;
+            UInt32      numSlices = mSrcDepth > 1 ? 2 : 1;
+            UInt32      numLines  = mSrcHeight > 1 ? 2 : 1;
+
+            for( UInt32 i = 0; i < numSlices; i++ )
+            {
+                for( UInt32 j = 0; j < numLines; j++ )
+                    rows[numRows++] = mSrc + (z * numSlices + i) * srcSliceSize + (y * numLines + j) * srcRowSize;
+            }
+
+            UInt32 numColumns = mSrcWidth > 1 ? 2 : 1;
+            UInt32 count      = numRows * numColumns;
+            Byte*  dst        = mDst + row * dstRowSize;
+            UInt32 x          = 0;
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+            if( mUseSSE2 && mNumChannels == 4 && numRows == 2 && numColumns == 2 )
+            {
+                const __m128i zero  = _mm_setzero_si128();
+                const __m128i round = _mm_set1_epi16( 2 );
+
+                // 4 source pixels from each row give 2 destination pixels.
+                for( ; x + 2 <= mDstWidth; x += 2 )
+                {
+                    __m128i row0 = _mm_loadu_si128( (const __m128i*)(rows[0] + x * 8) );
+                    __m128i row1 = _mm_loadu_si128( (const __m128i*)(rows[1] + x * 8) );
+
+                    __m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( row0, zero ), _mm_unpacklo_epi8( row1, zero ) );
+                    __m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( row0, zero ), _mm_unpackhi_epi8( row1, zero ) );
+                    lo = _mm_add_epi16( lo, _mm_srli_si128( lo, 8 ) );
+                    hi = _mm_add_epi16( hi, _mm_srli_si128( hi, 8 ) );
+
+                    __m128i sum = _mm_srli_epi16( _mm_add_epi16( _mm_unpacklo_epi64( lo, hi ), round ), 2 );
+                    _mm_storel_epi64( (__m128i*)(dst + x * 4), _mm_packus_epi16( sum, sum ) );
+                }
+            }
+#endif
+
+            for( ; x < mDstWidth; x++ )
+            {
+                for( UInt32 c = 0; c < mNumChannels; c++ )
+                {
+                    UInt32 sum = 0;
+                    for( UInt32 r = 0; r < numRows; r++ )
+                    {
+                        for( UInt32 i = 0; i < numColumns; i++ )
+                            sum += rows[r][(x * numColumns + i) * mNumChannels + c];
+                    }
+
+                    dst[x * mNumChannels + c] = (Byte)((sum + count / 2) / count);
+                }
+            }
+        }
+    }
+
+private:
+    const Byte* mSrc;
+    UInt32      mSrcWidth;
+    UInt32      mSrcHeight;
+    UInt32      mSrcDepth;
+    Byte*       mDst;
+    UInt32      mDstWidth;
+    UInt32      mDstHeight;
+    UInt32      mNumChannels;
+    Bool        mUseSSE2;
+};
+
+
 Image::Image()
     : mWidth(0)
     , mHeight(0)
@@ -182,7 +1050,8 @@ UInt32 Image::GetSizeWithMipmaps( Image::Format pFormat, UInt32 pWidth, UInt32 p
     UInt32 depth  = pDepth;
     UInt32 mip    = pMipmapCount == -1 ? 0x7FFFFFFF : pMipmapCount;
 
-    while( (width || height) && mip != 0 )
+    // Volumes keep halving their depth after their width and height reached 1.
+    while( (width || height || depth > 1) && mip != 0 )
     {
         dataSize += Image::GetSize( pFormat, width, height, depth );
 
@@ -221,6 +1090,33 @@ Bool Image::IsCompressed( Image::Format pFormat )
     return pFormat >= Format_DXT1 && pFormat <= Format_DXT5;
 }
 
+UInt32 Image::GetMaxNumMipmaps( UInt32 pWidth, UInt32 pHeight, UInt32 pDepth )
+{
+    UInt32 numMipmaps = 1;
+    UInt32 size = Maths::Max( Maths::Max( pWidth, pHeight ), pDepth );
+
+    while( size > 1 )
+    {
+        size >>= 1;
+        numMipmaps++;
+    }
+
+    return numMipmaps;
+}
+
+//! Index of the alpha channel of a format, -1 if it has none.
+static Int32 GetAlphaChannel( Image::Format pFormat )
+{
+    switch( pFormat )
+    {
+        case Image::Format_A8:          return 0;
+        case Image::Format_L8A8:        return 1;
+        case Image::Format_R8G8B8A8:    return 3;
+        case Image::Format_B8G8R8A8:    return 3;
+        default:                        return -1;
+    }
+}
+
 void Image::Create( UInt32 pWidth, UInt32 pHeight, Image::Format pFormat, UInt32 pNumMipmaps, UInt32 pDepth )
 {
     GD_ASSERT_M( pWidth > 0, "[Image::Create] Width is 0!" );
@@ -283,80 +1179,55 @@ Bool Image::Copy( const Image& pImage, UInt32 pX, UInt32 pY )
 
 void Image::ChangeGamma( Float pGamma )
 {
-    GD_ASSERT_M( !IsCompressed(), "[Image::ChangeGamma] Gamma change of compressed images not supported yet!" );
     GD_ASSERT_M( !IsVolume(), "[Image::ChangeGamma] Gamma change of volume images not supported yet!" );
 
+    // Lossy, see Image.h.
+    if( IsCompressed() )
+    {
+        Format format = mFormat;
+        Decompress();
+        ChangeGamma( pGamma );
+        Compress( format );
+        return;
+    }
+
     // This function was taken from a couple engines that I saw,
     // which most likely originated from the Aftershock engine.
     // Kudos to them!  What it does is increase/decrease the intensity
     // of the lightmap so that it isn't so dark.  Quake uses hardware to
     // do this, but we will do it in code.
-    UInt32 numComponents = SIZE_TABLE[mFormat];
-    UInt32 size = mWidth * mHeight;
-    Byte*  data = mData;
-
-    const UInt32 MAX_COMPONENTS      = 4;
-    const Float  MAX_COMPONENT_VALUE = 255.0f;
-
-    Float components[MAX_COMPONENTS];
 
     // Nothing to do in this case!
-    if( pGamma == 1.0f )
+    if( pGamma == 1.0f || mFormat == Format_A8 )
         return;
 
-    // Go through every pixel in the image
-    for( UInt32 i = 0; i < size; i++, data += numComponents )
-    {
-        Float scale = 1.0f;
-        Float temp  = 0.0f;
-
-        for( UInt32 j = 0; j < numComponents; j++ )
-        {
-            // Extract the current component value
-            components[j] = (Float)data[j];
-
-            // Multiply the factor by the component value, while keeping it to a 255 ratio
-            components[j] *= pGamma;
-
-            // Check if the the value went past the highest value
-            if( components[j] > MAX_COMPONENT_VALUE && (temp = (MAX_COMPONENT_VALUE/components[j])) < scale )
-                scale = temp;
-        }
-
-        for( UInt32 j = 0; j < numComponents; j++ )
-        {
-            // Get the scale for this pixel and multiply it by the component value
-            components[j] *= scale;
+    UInt32 numComponents = SIZE_TABLE[mFormat];
+    UInt32 numColors = (mFormat == Format_L8 || mFormat == Format_L8A8) ? 1 : 3;
 
-            // Assign the new gamma'nized value to the image
-            data[j] = (Byte)components[j];
-        }
-    }
+    ImageGammaBody gammaBody( mData, mWidth * numComponents, numComponents, numColors, pGamma );
+    JobManager::Instance()->ParallelFor( mHeight, ROWS_PER_JOB, gammaBody );
 }
 
 void Image::ToGrayscale()
 {
     Int32 numChannels = GetNumChannels();
 
-    if( !IsCompressed() || numChannels < 3 )
+    if( IsCompressed() || numChannels < 3 )
         return;
 
-    UInt32 size, len;
-    Byte* src = mData;
+    UInt32 numPixels = GetSizeWithMipmaps(Format_L8, mWidth, mHeight, mDepth, mNumMipmaps);
+    Byte*  dest = GD_NEW_ARRAY(Byte, numPixels, this, "Engine::Graphic::Image");
 
-    size = len = GetSizeWithMipmaps(Format_L8, mWidth, mHeight, mDepth, mNumMipmaps);
-    Byte* dest = GD_NEW_ARRAY(Byte, size, this, "Engine::Graphic::Image");
+    Bool bgr = mFormat == Format_B8G8R8 || mFormat == Format_B8G8R8A8;
 
-    do
-    {
-        *dest++ = (77 * src[0] + 151 * src[1] + 28 * src[2] + 128) >> 8;
-        src += numChannels;
-    } while (--len);
+    ImageGrayscaleBody grayscaleBody( mData, dest, numChannels, bgr, CanUseSSE2() );
+    JobManager::Instance()->ParallelFor( numPixels, PIXELS_PER_JOB, grayscaleBody );
 
     GD_DELETE_ARRAY(mData);
     mData = dest;
 
-    mFormat = Format_L8;
+    mFormat   = Format_L8;
+    mDataSize = numPixels;
 }
 
 void Image::ToNormalMap()
@@ -364,10 +1235,6 @@ void Image::ToNormalMap()
     if( mFormat != Format_L8 )
         return;
 
-    Byte *row0, *row1, *row2;
-    UInt32 x,y,w,h,mipmap;
-    UInt32 sx, sy, len, predx, succx;
-
     mFormat = Format_R8G8B8;
     mDataSize = GetSizeWithMipmaps(mFormat, mWidth, mHeight, mDepth, mNumMipmaps);
 
@@ -375,64 +1242,158 @@ void Image::ToNormalMap()
     Byte* dest = newPixels;
     Byte* src = mData;
 
-    mipmap = 0;
-    w = mWidth;
-    h = mHeight;
+    UInt32 w = mWidth;
+    UInt32 h = mHeight;
+    Bool   useSSE2 = CanUseSSE2();
 
-    do
+    for( UInt32 mipmap = 0; mipmap < mNumMipmaps; mipmap++ )
     {
-        row1 = src + (h - 1) * w;
-        row2 = src;
+        ImageNormalMapBody normalMapBody( src, dest, w, h, useSSE2 );
+        JobManager::Instance()->ParallelFor( h, ROWS_PER_JOB, normalMapBody );
 
-        y = h;
+        src  += w * h;
+        dest += w * h * 3;
 
-        do
-        {
-            row0 = row1;
-            row1 = row2;
-            row2 += w;
+        if( w > 1 )
+            w >>= 1;
 
-            if( y == 1 )
-                row2 = src;
+        if( h > 1 )
+            h >>= 1;
+    }
 
-            x = w - 1;
-            succx = 0;
+    GD_DELETE_ARRAY(mData);
+    mData = newPixels;
+}
 
-            do
-            {
-                predx = x;
-                x = succx++;
+void Image::GenerateMipmaps( MipmapFilter pFilter, Bool pSRGB, Int32 pNumMipmaps )
+{
+    GD_ASSERT_M( mData != NULL, "[Image::GenerateMipmaps] Image has no data!" );
+
+    // Lossy, see Image.h.
+    if( IsCompressed() )
+    {
+        Format format = mFormat;
+        Decompress();
+        GenerateMipmaps( pFilter, pSRGB, pNumMipmaps );
+        Compress( format );
+        return;
+    }
 
-                if(succx == w)
-                    succx = 0;
+    UInt32 numMipmaps = GetMaxNumMipmaps( mWidth, mHeight, mDepth );
+    if( pNumMipmaps > 0 )
+        numMipmaps = Maths::Min( numMipmaps, (UInt32)pNumMipmaps );
 
-                sx = (row0[predx] + 2 * row1[predx] + row2[predx]) - (row0[succx] + 2 * row1[succx] + row2[succx]);
-                sy = (row0[predx] + 2 * row0[x]     + row0[succx]) - (row2[predx] + 2 * row2[x]     + row2[succx]);
+    UInt32 numChannels = SIZE_TABLE[mFormat];
+    UInt32 dataSize    = GetSizeWithMipmaps( mFormat, mWidth, mHeight, mDepth, numMipmaps );
+    Byte*  data        = GD_NEW_ARRAY(Byte, dataSize, this, "Engine::Graphic::Image");
 
-                len = UInt32(0x000FF000 * Maths::FastRSqrt(Float(sx * sx + sy * sy + 256*256)));
-                sx *= len;
-                sy *= len;
+    memcpy( data, mData, GetSize( mFormat, mWidth, mHeight, mDepth ) );
 
-                dest[0] = ((sx  + 0x000FF000) >> 13);
-                dest[1] = ((sy  + 0x000FF000) >> 13);
-                dest[2] = ((len + 0x00000FF0) >> 5);
-                dest += 3;
-            } while (succx);
-        } while (--y);
+    BoxKernel       boxKernel;
+    KaiserKernel    kaiserKernel;
+    LanczosKernel   lanczosKernel;
 
-        src += w * h;
+    const MipmapFilterKernel* kernel = &boxKernel;
+    if( pFilter == MipmapFilter_Kaiser )
+        kernel = &kaiserKernel;
+    else if( pFilter == MipmapFilter_Lanczos )
+        kernel = &lanczosKernel;
 
-        if( w > 1 )
-            w >>= 1;
+    MipmapPixelConverter converter( numChannels, GetAlphaChannel(mFormat), pSRGB );
+    Bool useSSE2 = CanUseSSE2();
 
-        if( h > 1 )
-            h >>= 1;
+    Byte*  src       = data;
+    UInt32 srcWidth  = mWidth;
+    UInt32 srcHeight = mHeight;
+    UInt32 srcDepth  = mDepth;
+
+    for( UInt32 level = 1; level < numMipmaps; level++ )
+    {
+        Byte*  dst       = src + GetSize( mFormat, srcWidth, srcHeight, srcDepth );
+        UInt32 dstWidth  = Maths::Max<UInt32>( srcWidth >> 1, 1 );
+        UInt32 dstHeight = Maths::Max<UInt32>( srcHeight >> 1, 1 );
+        UInt32 dstDepth  = Maths::Max<UInt32>( srcDepth >> 1, 1 );
+
+        Bool evenSize = (srcWidth  == 1 || (srcWidth  & 1) == 0) &&
+                        (srcHeight == 1 || (srcHeight & 1) == 0) &&
+                        (srcDepth  == 1 || (srcDepth  & 1) == 0);
+
+        if( pFilter == MipmapFilter_Box && !pSRGB && evenSize )
+        {
+            // Plain 2x2 average, done on the bytes.
+            MipmapBoxBody boxBody( src, srcWidth, srcHeight, srcDepth, dst, dstWidth, dstHeight, numChannels, useSSE2 );
+            JobManager::Instance()->ParallelFor( dstHeight * dstDepth, ROWS_PER_JOB, boxBody );
+        }
+        else
+        {
+            MipmapFilterWeights weightsX;
+            MipmapFilterWeights weightsY;
+            weightsX.Compute( *kernel, srcWidth, dstWidth );
+            weightsY.Compute( *kernel, srcHeight, dstHeight );
+
+            if( srcDepth == 1 )
+            {
+                MipmapFilterBody filterBody( src, srcWidth, numChannels, weightsX, weightsY, dstWidth, converter, dst, NULL, useSSE2 );
+                JobManager::Instance()->ParallelFor( dstHeight, ROWS_PER_JOB, filterBody );
+            }
+            else
+            {
+                // Filter each source slice, then filter the slices along the depth.
+                UInt32 srcSliceSize = srcWidth * srcHeight * numChannels;
+                UInt32 dstSliceSize = dstWidth * dstHeight * numChannels;
+
+                Vector<Float> slices;
+                slices.resize( dstSliceSize * srcDepth );
 
-        mipmap++;
-    } while (mipmap < mNumMipmaps);
+                for( UInt32 z = 0; z < srcDepth; z++ )
+                {
+                    MipmapFilterBody filterBody( src + z * srcSliceSize, srcWidth, numChannels, weightsX, weightsY, dstWidth, converter, NULL, &slices[z * dstSliceSize], useSSE2 );
+                    JobManager::Instance()->ParallelFor( dstHeight, ROWS_PER_JOB, filterBody );
+                }
+
+                MipmapFilterWeights weightsZ;
+                weightsZ.Compute( *kernel, srcDepth, dstDepth );
+
+                MipmapFilterDepthBody depthBody( slices, dstSliceSize, dstWidth * numChannels, dstHeight, weightsZ, converter, dstWidth, dst, useSSE2 );
+                JobManager::Instance()->ParallelFor( dstHeight * dstDepth, ROWS_PER_JOB, depthBody );
+            }
+        }
+
+        src       = dst;
+        srcWidth  = dstWidth;
+        srcHeight = dstHeight;
+        srcDepth  = dstDepth;
+    }
 
     GD_DELETE_ARRAY(mData);
-    mData = newPixels;
+    mData       = data;
+    mDataSize   = dataSize;
+    mNumMipmaps = numMipmaps;
+}
+
+void Image::Compress( Format pFormat, Bool pHighQuality )
+{
+    Image compressed;
+    DXTCodec::Compress( *this, pFormat, pHighQuality ? DXTCodec::Quality_High : DXTCodec::Quality_Fast, compressed );
+    Swap( compressed );
+}
+
+void Image::Decompress()
+{
+    Image decompressed;
+    DXTCodec::Decompress( *this, decompressed );
+    Swap( decompressed );
+}
+
+void Image::Swap( Image& pOther )
+{
+    std::swap( mWidth, pOther.mWidth );
+    std::swap( mHeight, pOther.mHeight );
+    std::swap( mDepth, pOther.mDepth );
+    std::swap( mNumMipmaps, pOther.mNumMipmaps );
+    std::swap( mFormat, pOther.mFormat );
+    std::swap( mData, pOther.mData );
+    std::swap( mDataSize, pOther.mDataSize );
 }
 
 void Image::FlipY()
@@ -495,28 +1456,13 @@ void Image::FlipY( Byte* pData, UInt32 pWidth, UInt32 pHeight, UInt32 pDepth )
         UInt32 imageSize = GetSize(mFormat, pWidth, pHeight);
         UInt32 lineSize  = imageSize / pHeight;
 
-        Byte* swapTmp = GD_ALLOC(Byte, lineSize, this, "TempBuffer");
-		GD_ASSERT(swapTmp);
-
         for( UInt32 n = 0; n < pDepth; n++ )
         {
             offset = imageSize * n;
 
-            Byte* top    = pData + offset;
-            Byte* bottom = top + (imageSize-lineSize);
-
-            for( UInt32 i = 0; i < (pHeight >> 1); i++ )
-            {
-                memcpy( swapTmp, bottom, lineSize );
-                memcpy( bottom, top, lineSize );
-                memcpy( top, swapTmp, lineSize );
-
-                top += lineSize;
-                bottom -= lineSize;
-            }
+            ImageFlipBody flipBody( pData + offset, lineSize, pHeight );
+            JobManager::Instance()->ParallelFor( pHeight >> 1, ROWS_PER_JOB, flipBody );
         }
-
-		GD_FREE(swapTmp);
     }
     else
     {
@@ -52,6 +52,13 @@ public:
         Format_MAX = 0xFF
     };
 
+    enum MipmapFilter
+    {
+        MipmapFilter_Box,       //!< Average of the covered pixels, fastest.
+        MipmapFilter_Kaiser,    //!< Kaiser windowed sinc, sharp with little ringing.
+        MipmapFilter_Lanczos    //!< Lanczos 3, sharpest, can ring on hard edges.
+    };
+
 public:
     Image();
     Image( const Image& pOther );
@@ -83,21 +90,51 @@ public:
     //! Works only for normal textures (not compressed and no volume)
     Bool Copy( const Image& pImage, UInt32 pX, UInt32 pY );
 
+    /**
+     *  Scale the color channels by pGamma, alpha is left unchanged.
+     *  A compressed image is decompressed, adjusted and compressed back with the fast
+     *  encoder. Each round trip is lossy, adjust the image before compressing it when possible.
+     */
     void ChangeGamma( Float pGamma );
     
     void ToGrayscale();
     void ToNormalMap();
 
+    /**
+     *  Build the mipmap chain from the first level, replacing the existing mipmaps.
+     *  Each level is filtered from the previous one. A compressed image is decompressed, filtered
+     *  and compressed back with the fast encoder. The round trip is lossy for the first level too,
+     *  generate the mipmaps before compressing when possible.
+     *  @param  pFilter         Filter used to downsample the levels.
+     *  @param  pSRGB           The color channels are sRGB encoded and are filtered in linear space.
+     *  @param  pNumMipmaps     Number of levels wanted (including the first one), -1 for the full chain.
+     */
+    void GenerateMipmaps( MipmapFilter pFilter = MipmapFilter_Box, Bool pSRGB = false, Int32 pNumMipmaps = -1 );
+
+    /**
+     *  Compress every mipmap of the image, see DXTCodec.
+     *  @param  pFormat         Format_DXT1, Format_DXT3 or Format_DXT5.
+     *  @param  pHighQuality    Use the cluster fit instead of the faster range fit.
+     */
+    void Compress( Format pFormat, Bool pHighQuality = false );
+
+    //! Decompress a DXT image to Format_R8G8B8A8.
+    void Decompress();
+
     //! Serialize
     friend Stream& operator << ( Stream& pStream, Image& pImage );
 
     void DumpRaw( const String& pFilename ) const;
 
+    //! Exchange the content of two images, without copying the data.
+    void Swap( Image& pOther );
+
 public:
     static UInt32 GetSize( Format pFormat, UInt32 pWidth, UInt32 pHeight, UInt32 pDepth = 1 );
     static UInt32 GetSizeWithMipmaps( Format pFormat, UInt32 pWidth, UInt32 pHeight, UInt32 pDepth = 1, Int32 pMipmapCount = -1 );
     static UInt32 GetNumChannels( Format pFormat );
     static Bool   IsCompressed( Format pFormat );
+    static UInt32 GetMaxNumMipmaps( UInt32 pWidth, UInt32 pHeight, UInt32 pDepth = 1 );
 
 private:
     void FlipY( Byte* pData, UInt32 pWidth, UInt32 pHeight, UInt32 pDepth );
@@ -133,13 +133,46 @@ void SkeletalMesh::AddAnim( SkeletalAnim* pAnim )
 }
 
 void SkeletalMesh::Update( Double /*pElapsed*/ )
+{
+    EvaluatePose( UpdateAnimTime() );
+    Skin();
+    UploadBuffers();
+}
+
+Float SkeletalMesh::UpdateAnimTime()
 {
     Double time = SystemInfo::Instance()->GetSeconds() - mTimeStart;
     if( time >= mAnims[0]->mAnimLength )
         mTimeStart = SystemInfo::Instance()->GetSeconds();
- 
-    UpdateBone( 0, time );
+
+    return time;
+}
+
+void SkeletalMesh::EvaluatePose( Float pTime )
+{
+    UpdateBone( 0, pTime );
+}
+
+void SkeletalMesh::Skin()
+{
     ApplyWeight();
+    ComputeTriangleNormals();
+    ComputeVertexNormals();
+}
+
+void SkeletalMesh::UploadBuffers()
+{
+    // Fill position buffer
+    Vector3f* points = reinterpret_cast<Vector3f*>(mBufPositions->Lock( VertexBuffer::Lock_Write ));
+    if( points )
+        memcpy( points, &(mVertexPositions[0]), mVertexPositions.size() * sizeof(Vector3f) );
+    mBufPositions->Unlock();
+
+    // Fill normal buffer
+    Vector3f* normals = reinterpret_cast<Vector3f*>(mBufNormals->Lock( VertexBuffer::Lock_Write ));
+    if( normals )
+        memcpy( normals, &(mVertexNormals[0]), mVertexNormals.size() * sizeof(Vector3f) );
+    mBufNormals->Unlock();
 }
 
 void SkeletalMesh::UpdateBone( UInt32 pIndex, Float pTime )
@@ -194,15 +227,6 @@ void SkeletalMesh::ApplyWeight()
         mVertexPositions[i] = sum;
         mBoundingBox.Grow( sum );
     }
-
-    // Fill position buffer
-    Vector3f* points = reinterpret_cast<Vector3f*>(mBufPositions->Lock( VertexBuffer::Lock_Write ));
-    if( points )
-        memcpy( points, &(mVertexPositions[0]), mVertexPositions.size() * sizeof(Vector3f) );
-    mBufPositions->Unlock();
-
-    ComputeTriangleNormals();
-    ComputeVertexNormals();
 }
 
 void SkeletalMesh::ComputeTriangleNormals()
@@ -237,12 +261,6 @@ void SkeletalMesh::ComputeVertexNormals()
 
         mVertexNormals[iVertex].Normalize();
     }
-
-    // Fill position buffer
-    Vector3f* normals = reinterpret_cast<Vector3f*>(mBufNormals->Lock( VertexBuffer::Lock_Write ));
-    if( normals )
-        memcpy( normals, &(mVertexNormals[0]), mVertexNormals.size() * sizeof(Vector3f) );
-    mBufNormals->Unlock();
 }
 
 void SkeletalMesh::Render(Bool /*pRenderChild*/) const
@@ -107,6 +107,18 @@ public:
     void Render( Bool pRenderChild = true ) const;
     void AddAnim( SkeletalAnim* pAnim );
 
+    //! Advance the animation clock and return the time at which the pose must be evaluated.
+    Float UpdateAnimTime();
+
+    //! Compute the bone transforms for pTime. Thread safe with respect to other meshes.
+    void EvaluatePose( Float pTime );
+
+    //! Skin the vertices and compute the normals on the CPU. Thread safe with respect to other meshes.
+    void Skin();
+
+    //! Copy the skinned positions and normals to the vertex buffers. Must be called from the render thread.
+    void UploadBuffers();
+
 	BoundingBox	GetBoundingBox( const Matrix4f& pTransformation = Matrix4f::IDENTITY );
 
 private:
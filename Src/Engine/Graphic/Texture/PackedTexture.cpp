@@ -30,14 +30,199 @@
 
 #include "Graphic/Texture/Texture.h"
 #include "Graphic/GraphicSubsystem.h"
+#include "Thread/JobManager.h"
 
 
 namespace Gamedesk {
+
+
+//! Orders in which InsertImages() tries to pack a batch, largest images first.
+enum SortOrder
+{
+    SortOrder_Area,
+    SortOrder_LongSide,
+    SortOrder_Perimeter,
+    SortOrder_Count
+};
+
+static const UInt32 INVALID_PAGE = 0xFFFFFFFF;
+
+
+//! Copy pSource at (pX,pY) in pDest, swapping its rows and columns if pTransposed.
+static void CopyImage( Image& pDest, const Image& pSource, UInt32 pX, UInt32 pY, Bool pTransposed )
+{
+    if( !pTransposed )
+    {
+        pDest.Copy( pSource, pX, pY );
+        return;
+    }
+
+    GD_ASSERT( !pSource.IsCompressed() && pSource.GetFormat() == pDest.GetFormat() );
+    GD_ASSERT( pX + pSource.GetHeight() <= pDest.GetWidth() && pY + pSource.GetWidth() <= pDest.GetHeight() );
+
+    UInt32      bpp = Image::GetSize( pSource.GetFormat(), 1, 1 );
+    const Byte* src = pSource.GetData();
+    Byte*       dst = pDest.GetData();
+
+    for( UInt32 y = 0; y < pSource.GetHeight(); y++ )
+    {
+        for( UInt32 x = 0; x < pSource.GetWidth(); x++ )
+            memcpy( &dst[((pY + x) * pDest.GetWidth() + pX + y) * bpp], &src[(y * pSource.GetWidth() + x) * bpp], bpp );
+    }
+}
+
+
+//! Placement of a batch of images, for one sort order and heuristic.
+class PackedTexture::Layout
+{
+public:
+    Vector<RectPacker>          mPackers;
+    Vector<UInt32>              mPages;
+    Vector<RectPacker::Rect>    mRects;
+    Vector<Byte>                mRotated;
+};
+
+
+//! Sort image indices by decreasing key.
+class ImageOrder
+{
+public:
+    ImageOrder( const Vector<UInt32>& pKeys )
+        : mKeys(pKeys)
+    {
+    }
+
+    Bool operator()( UInt32 pLeft, UInt32 pRight ) const
+    {
+        return mKeys[pLeft] > mKeys[pRight];
+    }
+
+private:
+    const Vector<UInt32>& mKeys;
+};
+
+
+//! Compute the layout of every (sort order, heuristic) pair.
+class PackedTexture::LayoutBody : public ParallelForBody
+{
+public:
+    LayoutBody( const PackedTexture& pOwner, const Vector<const Image*>& pImages, Vector<Layout>& pLayouts )
+        : mOwner(pOwner)
+        , mImages(pImages)
+        , mLayouts(pLayouts)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+            Pack( SortOrder(i / RectPacker::Heuristic_Count), RectPacker::Heuristic(i % RectPacker::Heuristic_Count), mLayouts[i] );
+    }
+
+private:
+    void Pack( SortOrder pOrder, RectPacker::Heuristic pHeuristic, Layout& pLayout ) const
+    {
+        UInt32 count = mImages.size();
+
+        Vector<UInt32> keys;
+        Vector<UInt32> order;
+        keys.resize( count );
+        order.resize( count );
+
+        for( UInt32 i = 0; i < count; i++ )
+        {
+            UInt32 width  = mImages[i]->GetWidth();
+            UInt32 height = mImages[i]->GetHeight();
+
+            switch( pOrder )
+            {
+            case SortOrder_Area:        keys[i] = width * height;                   break;
+            case SortOrder_LongSide:    keys[i] = Maths::Max( width, height );      break;
+            case SortOrder_Perimeter:   keys[i] = width + height;                   break;
+            default:                    keys[i] = 0;                                break;
+            }
+
+            order[i] = i;
+        }
+
+        std::stable_sort( order.begin(), order.end(), ImageOrder(keys) );
+
+        pLayout.mPackers = mOwner.mPackers;
+        pLayout.mPages.resize( count );
+        pLayout.mRects.resize( count );
+        pLayout.mRotated.resize( count );
+
+        for( UInt32 i = 0; i < count; i++ )
+        {
+            UInt32 index  = order[i];
+            UInt32 width  = mImages[index]->GetWidth();
+            UInt32 height = mImages[index]->GetHeight();
+            Bool   rotated = false;
+
+            pLayout.mPages[index] = INVALID_PAGE;
+
+            if( width > mOwner.mTexSize || height > mOwner.mTexSize )
+                continue;
+
+            // First page with room for it.
+            UInt32 page = 0;
+            for( ; page < pLayout.mPackers.size(); page++ )
+            {
+                if( pLayout.mPackers[page].Insert( width, height, pHeuristic, pLayout.mRects[index], rotated ) )
+                    break;
+            }
+
+            if( page == pLayout.mPackers.size() )
+            {
+                pLayout.mPackers.push_back( RectPacker(mOwner.mTexSize, mOwner.mTexSize, mOwner.mAllowRotation) );
+                pLayout.mPackers.back().Insert( width, height, pHeuristic, pLayout.mRects[index], rotated );
+            }
+
+            pLayout.mPages[index]   = page;
+            pLayout.mRotated[index] = rotated;
+        }
+    }
+
+private:
+    const PackedTexture&            mOwner;
+    const Vector<const Image*>&     mImages;
+    Vector<Layout>&                 mLayouts;
+};
+
+
+//! Copy the images of a batch in their page.
+class PackedTexture::CopyBody : public ParallelForBody
+{
+public:
+    CopyBody( const Vector<Image*>& pPages, const Vector<const Image*>& pImages, const Layout& pLayout )
+        : mPages(pPages)
+        , mImages(pImages)
+        , mLayout(pLayout)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        // Images don't overlap, so images of the same page can be copied concurrently.
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+        {
+            if( mLayout.mPages[i] != INVALID_PAGE )
+                CopyImage( *mPages[mLayout.mPages[i]], *mImages[i], mLayout.mRects[i].mX, mLayout.mRects[i].mY, mLayout.mRotated[i] != 0 );
+        }
+    }
+
+private:
+    const Vector<Image*>&           mPages;
+    const Vector<const Image*>&     mImages;
+    const Layout&                   mLayout;
+};
+
 	
-	
-PackedTexture::PackedTexture( UInt32 pSize, Image::Format pFormat )
+PackedTexture::PackedTexture( UInt32 pSize, Image::Format pFormat, Bool pAllowRotation )
     : mTexSize(pSize)
     , mTexFormat(pFormat)
+    , mAllowRotation(pAllowRotation && !Image::IsCompressed(pFormat))
+    , mHeuristic(RectPacker::Heuristic_BestShortSideFit)
 {
 }
 
@@ -48,11 +233,7 @@ PackedTexture::~PackedTexture()
 
 void PackedTexture::ClearAll()
 {
-    for( UInt32 i = 0; i < mTexTrees.size(); i++ )
-    {
-        GD_DELETE(mTexTrees[i]);
-    }
-    mTexTrees.clear();
+    mPackers.clear();
 
     for( UInt32 i = 0; i < mImages.size(); i++ )
     {
@@ -65,6 +246,8 @@ void PackedTexture::ClearAll()
         GD_DELETE(mTextures[i]);
     }
     mTextures.clear();
+
+    mReport = Report();
 }
 
 void PackedTexture::BeginPacking()
@@ -74,12 +257,8 @@ void PackedTexture::BeginPacking()
 
 void PackedTexture::EndPacking()
 {
-    // Trees are now useless.
-    for( UInt32 i = 0; i < mTexTrees.size(); i++ )
-    {
-        GD_DELETE(mTexTrees[i]);
-    }
-    mTexTrees.clear();
+    // Packers are now useless.
+    mPackers.clear();
 
     mTextures.resize( mImages.size() );
 
@@ -108,41 +287,103 @@ Bool PackedTexture::InsertImage( const Image& pImg, PackedTexture::Info& info )
     if( pImg.GetWidth() > mTexSize || pImg.GetHeight() > mTexSize )
         return false;
 
-    // Copy to one of the existing image
-    TextureTree::Node* node     = NULL;
-    UInt32             nodeTree = 0;
+    // Find room in one of the existing pages
+    RectPacker::Rect rect;
+    Bool             rotated = false;
+    UInt32           page    = 0;
 
-    for( UInt32 i = 0; i < mTexTrees.size(); i++ )
+    for( ; page < mPackers.size(); page++ )
     {
-        node = mTexTrees[i]->InsertImage( pImg );
-        nodeTree = i;
+        if( mPackers[page].Insert( pImg.GetWidth(), pImg.GetHeight(), mHeuristic, rect, rotated ) )
+            break;
     }
     
-    // No space found, create a new tree
-    if( !node )
+    // No space found, create a new page
+    if( page == mPackers.size() )
     {
-        mTexTrees.push_back( GD_NEW(TextureTree, this, "Engine::Graphic::Texture::PackedTexture")(mTexSize) );
-        mImages.push_back( GD_NEW(Image, this, "Engine::Graphic::Texture::PackedTexture") );
+        page = AddPage();
+
+        // Always fits, the image is not larger than a page.
+        mPackers[page].Insert( pImg.GetWidth(), pImg.GetHeight(), mHeuristic, rect, rotated );
+    }
 
-        node = mTexTrees[mTexTrees.size()-1]->InsertImage( pImg );
-        nodeTree = mTexTrees.size()-1;
+    // Copy image there
+    CopyImage( *mImages[page], pImg, rect.mX, rect.mY, rotated );
+
+    // Copy values back into info structure.
+    info = PackedTexture::Info( page, rect.mX, rect.mY, rotated );
+
+    mReport.mNbImages++;
+    mReport.mUsedTexels += pImg.GetWidth() * pImg.GetHeight();
+
+    return true;
+}
+
+Bool PackedTexture::InsertImages( const Vector<const Image*>& pImages, Vector<PackedTexture::Info>& pInfos )
+{
+    pInfos.clear();
+    pInfos.resize( pImages.size() );
 
-        mImages[mImages.size()-1]->Create( mTexSize, mTexSize, mTexFormat );
+    if( pImages.empty() )
+        return true;
+
+    // Pack with every sort order and heuristic, each on its own thread.
+    Vector<Layout> layouts;
+    layouts.resize( SortOrder_Count * RectPacker::Heuristic_Count );
+
+    LayoutBody layoutBody( *this, pImages, layouts );
+    JobManager::Instance()->ParallelFor( layouts.size(), 1, layoutBody );
+
+    // Keep the layout with the fewest pages, then the one leaving the most room in its last page.
+    // A layout has no page when the atlas is empty and every image is larger than a page.
+    UInt32 best = 0;
+    for( UInt32 i = 1; i < layouts.size(); i++ )
+    {
+        UInt32 pageCount     = layouts[i].mPackers.size();
+        UInt32 bestPageCount = layouts[best].mPackers.size();
+
+        if( pageCount < bestPageCount ||
+            (pageCount == bestPageCount && pageCount > 0 && layouts[i].mPackers.back().GetUsedArea() < layouts[best].mPackers.back().GetUsedArea()) )
+        {
+            best = i;
+        }
     }
 
-    // A node must have been found.
-    GD_ASSERT( node );
-    
-    // Copy texture there
-    if( node )
+    Layout& layout = layouts[best];
+
+    UInt32 firstNewPage = mPackers.size();
+    for( UInt32 i = firstNewPage; i < layout.mPackers.size(); i++ )
+        AddPage();
+
+    mPackers.swap( layout.mPackers );
+
+    CopyBody copyBody( mImages, pImages, layout );
+    JobManager::Instance()->ParallelFor( pImages.size(), 16, copyBody );
+
+    UInt32 nbOversized = 0;
+    for( UInt32 i = 0; i < pImages.size(); i++ )
     {
-        mImages[nodeTree]->Copy( pImg, node->mRect.mLeft, node->mRect.mTop );
+        if( layout.mPages[i] == INVALID_PAGE )
+        {
+            nbOversized++;
+            continue;
+        }
 
-        // Copy values back into info structure.
-        info = PackedTexture::Info( nodeTree, node->mRect.mLeft, node->mRect.mTop );
+        pInfos[i] = PackedTexture::Info( layout.mPages[i], layout.mRects[i].mX, layout.mRects[i].mY, layout.mRotated[i] != 0 );
+
+        mReport.mNbImages++;
+        mReport.mUsedTexels += pImages[i]->GetWidth() * pImages[i]->GetHeight();
     }
 
-    return node != NULL;
+    if( nbOversized > 0 )
+        Core::DebugOut( "[PackedTexture::InsertImages] %u images are larger than a %ux%u page.\n", nbOversized, mTexSize, mTexSize );
+
+    return nbOversized == 0;
+}
+
+void PackedTexture::SetHeuristic( RectPacker::Heuristic pHeuristic )
+{
+    mHeuristic = pHeuristic;
 }
 
 Texture2D& PackedTexture::GetTexture( UInt32 pTexture )
@@ -152,86 +393,32 @@ Texture2D& PackedTexture::GetTexture( UInt32 pTexture )
     return *mTextures[pTexture];
 }
 
-PackedTexture::TextureTree::Node::Node()
+UInt32 PackedTexture::GetTextureCount() const
 {
-    mChilds[0] = NULL;
-    mChilds[1] = NULL;
-    mInUse     = 0;
+    return mTextures.size();
 }
 
-PackedTexture::TextureTree::Node::~Node()
+UInt32 PackedTexture::GetTextureSize() const
 {
-    if( mChilds[0] )
-        GD_DELETE(mChilds[0]);
-
-    if( mChilds[1] )
-        GD_DELETE(mChilds[1]);
+    return mTexSize;
 }
 
-PackedTexture::TextureTree::Node* PackedTexture::TextureTree::Node::InsertImage( const Image& pImg )
+const PackedTexture::Report& PackedTexture::GetReport() const
 {
-    Node* result = NULL;
-
-    // We're in a full node/leaf, return immediately.
-    if( mInUse )
-        return NULL;
-
-    // If we're not a leaf, try inserting in childs
-    if( mChilds[0] )
-    {
-        result = mChilds[0]->InsertImage( pImg );
-        
-        if( !result )
-            result = mChilds[1]->InsertImage( pImg );
-
-        mInUse = mChilds[0]->mInUse && mChilds[1]->mInUse;
-        return result;
-    }
-
-    Int32 diffW = (mRect.mRight-mRect.mLeft+1) - pImg.GetWidth();
-    Int32 diffH = (mRect.mBottom-mRect.mTop+1) - pImg.GetHeight();
-    
-    // If we're too small, return.
-    if( diffW < 0 || diffH < 0 )
-        return NULL;
-
-    // Perfect match !
-    if( diffW == 0 && diffH == 0 )
-    {
-        mInUse = true;
-        return this;
-    }
-
-    // Otherwise, gotta split this node and create some kids.
-    mChilds[0] = GD_NEW(Node, this, "Engine::Graphic::Texture::PackedTexture");
-    mChilds[1] = GD_NEW(Node, this, "Engine::Graphic::Texture::PackedTexture");
-    
-    if( diffW > diffH )
-    {
-        mChilds[0]->mRect = Rect( mRect.mLeft, mRect.mTop, mRect.mLeft + pImg.GetWidth() - 1, mRect.mBottom );
-        mChilds[1]->mRect = Rect( mRect.mLeft + pImg.GetWidth(), mRect.mTop, mRect.mRight, mRect.mBottom );
-    }
-    else
-    {
-        mChilds[0]->mRect = Rect( mRect.mLeft, mRect.mTop, mRect.mRight, mRect.mTop + pImg.GetHeight() - 1 );
-        mChilds[1]->mRect = Rect( mRect.mLeft, mRect.mTop + pImg.GetHeight(), mRect.mRight, mRect.mBottom );
-    }
-    
-    // Insert into first child we created
-    return mChilds[0]->InsertImage( pImg );
+    return mReport;
 }
 
-PackedTexture::TextureTree::TextureTree( UInt32 pSize )
+UInt32 PackedTexture::AddPage()
 {
-    mRoot.mRect.mLeft = 0;
-    mRoot.mRect.mRight = pSize-1;
-    mRoot.mRect.mTop = 0;
-    mRoot.mRect.mBottom = pSize-1;
-}
+    mPackers.push_back( RectPacker(mTexSize, mTexSize, mAllowRotation) );
 
-PackedTexture::TextureTree::Node* PackedTexture::TextureTree::InsertImage( const Image& pImg )
-{
-    return mRoot.InsertImage( pImg );
+    mImages.push_back( GD_NEW(Image, this, "Engine::Graphic::Texture::PackedTexture") );
+    mImages.back()->Create( mTexSize, mTexSize, mTexFormat );
+
+    mReport.mNbPages++;
+    mReport.mTotalTexels += mTexSize * mTexSize;
+
+    return mImages.size() - 1;
 }
 
 
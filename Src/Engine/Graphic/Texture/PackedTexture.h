@@ -36,11 +36,18 @@ namespace Gamedesk
 
 
 #include "Graphic/Image/Image.h"
+#include "Graphic/Texture/RectPacker.h"
 
 
 namespace Gamedesk {
 
 
+/**
+ *  Pack images in pages of pSize x pSize texels, then create a texture for each page.
+ *  Images are placed with a RectPacker. InsertImages() packs a whole batch at once,
+ *  trying several sort orders and heuristics in parallel and keeping the layout
+ *  that uses the fewest pages.
+ */
 class ENGINE_API PackedTexture
 {
 public:
@@ -52,11 +59,12 @@ public:
         {
         }
 
-        Info( UInt32 pTextureIndex, UInt32 pOffsetU, UInt32 pOffsetV )
+        Info( UInt32 pTextureIndex, UInt32 pOffsetU, UInt32 pOffsetV, Bool pRotated = false )
             : mTextureIndex(pTextureIndex)
             , mOffsetU(pOffsetU)
             , mOffsetV(pOffsetV)
             , mValid(true)
+            , mRotated(pRotated)
         {
         }
 
@@ -64,10 +72,35 @@ public:
         UInt32 mOffsetU;
         UInt32 mOffsetV;
         Byte   mValid;
+        Byte   mRotated;    //!< Image stored transposed: texel (x,y) is at (mOffsetU + y, mOffsetV + x).
+    };
+
+    //! Packing efficiency, for the images inserted since BeginPacking().
+    class Report
+    {
+    public:
+        Report()
+            : mNbImages(0)
+            , mNbPages(0)
+            , mUsedTexels(0)
+            , mTotalTexels(0)
+        {
+        }
+
+        //! Ratio of the page texels covered by images, between 0 and 1.
+        Float GetEfficiency() const
+        {
+            return mTotalTexels ? Float(mUsedTexels) / Float(mTotalTexels) : 0.0f;
+        }
+
+        UInt32 mNbImages;
+        UInt32 mNbPages;
+        UInt32 mUsedTexels;
+        UInt32 mTotalTexels;
     };
 
 public:
-    PackedTexture( UInt32 pSize, Image::Format pFormat );
+    PackedTexture( UInt32 pSize, Image::Format pFormat, Bool pAllowRotation = false );
     ~PackedTexture();
 
     void ClearAll();
@@ -77,61 +110,40 @@ public:
 
     Bool InsertImage( const Image& pImg, PackedTexture::Info& info );
 
-    Texture2D& GetTexture( UInt32 pTexture );
+    /**
+     *  Insert a batch of images. Packing all of them at once is much tighter than
+     *  inserting them one by one in an arbitrary order.
+     *  @param  pImages     Images to insert, pInfos[i] receives the placement of pImages[i].
+     *  @return false if an image is larger than a page, its info is left invalid.
+     */
+    Bool InsertImages( const Vector<const Image*>& pImages, Vector<PackedTexture::Info>& pInfos );
 
-protected:
-    class TextureTree
-    {   
-    public:
-        class Rect
-        {
-        public:
-            Rect()
-            {
-            }
-            Rect( UInt32 pLeft, UInt32 pTop, UInt32 pRight, UInt32 pBottom )
-                : mLeft(pLeft)
-                , mRight(pRight)
-                , mTop(pTop)
-                , mBottom(pBottom)
-            {
-            }
-
-            UInt32  mLeft;
-            UInt32  mRight;
-            UInt32  mTop;
-            UInt32  mBottom;
-        };
-        
-        class Node
-        {
-        public:
-            Node();
-            ~Node();
+    //! Heuristic used by InsertImage(), InsertImages() tries all of them.
+    void SetHeuristic( RectPacker::Heuristic pHeuristic );
 
-            Node* InsertImage( const Image& pImg );
+    Texture2D& GetTexture( UInt32 pTexture );
+    UInt32     GetTextureCount() const;
+    UInt32     GetTextureSize() const;
 
-        public:
-            Node*       mChilds[2];
-            Rect        mRect;
-            Byte        mInUse;
-        };
+    const Report& GetReport() const;
 
-    public:
-        TextureTree( UInt32 pSize );
-        Node* InsertImage( const Image& pImg );
+protected:
+    class Layout;
+    class LayoutBody;
+    class CopyBody;
 
-    private:
-        Node    mRoot;
-    };
+    UInt32 AddPage();
 
 private:
     Vector<Image*>          mImages;
     Vector<Texture2D*>      mTextures;
-    Vector<TextureTree*>    mTexTrees;
+    Vector<RectPacker>      mPackers;
 
     UInt32                  mTexSize;
     Image::Format           mTexFormat;
+    Bool                    mAllowRotation;
+    RectPacker::Heuristic   mHeuristic;
+    Report                  mReport;
 };
 
 
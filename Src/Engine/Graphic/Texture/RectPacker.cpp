@@ -0,0 +1,277 @@
+/**
+ *  @file       RectPacker.cpp
+ *  @brief      Pack rectangles in a fixed size area (MaxRects).
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "Graphic/Texture/RectPacker.h"
+
+
+namespace Gamedesk {
+
+
+RectPacker::RectPacker( UInt32 pWidth, UInt32 pHeight, Bool pAllowRotation )
+{
+    Reset( pWidth, pHeight, pAllowRotation );
+}
+
+void RectPacker::Reset( UInt32 pWidth, UInt32 pHeight, Bool pAllowRotation )
+{
+    mWidth          = pWidth;
+    mHeight         = pHeight;
+    mAllowRotation  = pAllowRotation;
+    mUsedArea       = 0;
+
+    mUsedRects.clear();
+    mNewFreeRects.clear();
+    mFreeRects.clear();
+    mFreeRects.push_back( Rect(0, 0, pWidth, pHeight) );
+}
+
+Bool RectPacker::Insert( UInt32 pWidth, UInt32 pHeight, Heuristic pHeuristic, Rect& pResult, Bool& pRotated )
+{
+    if( pWidth == 0 || pHeight == 0 )
+        return false;
+
+    if( !FindPosition( pWidth, pHeight, pHeuristic, pResult, pRotated ) )
+        return false;
+
+    PlaceRect( pResult );
+    return true;
+}
+
+UInt32 RectPacker::GetWidth() const
+{
+    return mWidth;
+}
+
+UInt32 RectPacker::GetHeight() const
+{
+    return mHeight;
+}
+
+UInt32 RectPacker::GetUsedArea() const
+{
+    return mUsedArea;
+}
+
+Float RectPacker::GetOccupancy() const
+{
+    if( mWidth == 0 || mHeight == 0 )
+        return 0.0f;
+
+    return Float(mUsedArea) / (Float(mWidth) * Float(mHeight));
+}
+
+Bool RectPacker::FindPosition( UInt32 pWidth, UInt32 pHeight, Heuristic pHeuristic, Rect& pResult, Bool& pRotated ) const
+{
+    Bool  found = false;
+    Int32 bestScore1 = 0;
+    Int32 bestScore2 = 0;
+
+    for( UInt32 i = 0; i < mFreeRects.size(); i++ )
+    {
+        const Rect& freeRect = mFreeRects[i];
+
+        for( UInt32 rotation = 0; rotation < (mAllowRotation ? 2U : 1U); rotation++ )
+        {
+            UInt32 width  = rotation ? pHeight : pWidth;
+            UInt32 height = rotation ? pWidth  : pHeight;
+
+            if( width > freeRect.mWidth || height > freeRect.mHeight )
+                continue;
+
+            Rect  candidate( freeRect.mX, freeRect.mY, width, height );
+            Int32 score1;
+            Int32 score2;
+            ScorePosition( freeRect, candidate, pHeuristic, score1, score2 );
+
+            if( !found || score1 < bestScore1 || (score1 == bestScore1 && score2 < bestScore2) )
+            {
+                found      = true;
+                bestScore1 = score1;
+                bestScore2 = score2;
+                pResult    = candidate;
+                pRotated   = rotation != 0;
+            }
+        }
+    }
+
+    return found;
+}
+
+void RectPacker::ScorePosition( const Rect& pFreeRect, const Rect& pCandidate, Heuristic pHeuristic, Int32& pScore1, Int32& pScore2 ) const
+{
+    Int32 leftoverX = pFreeRect.mWidth  - pCandidate.mWidth;
+    Int32 leftoverY = pFreeRect.mHeight - pCandidate.mHeight;
+    Int32 shortSide = Maths::Min( leftoverX, leftoverY );
+    Int32 longSide  = Maths::Max( leftoverX, leftoverY );
+
+    // Lower scores are better.
+    switch( pHeuristic )
+    {
+    case Heuristic_BestShortSideFit:
+        pScore1 = shortSide;
+        pScore2 = longSide;
+        break;
+
+    case Heuristic_BestLongSideFit:
+        pScore1 = longSide;
+        pScore2 = shortSide;
+        break;
+
+    case Heuristic_BestAreaFit:
+        pScore1 = pFreeRect.mWidth * pFreeRect.mHeight - pCandidate.mWidth * pCandidate.mHeight;
+        pScore2 = shortSide;
+        break;
+
+    case Heuristic_BottomLeft:
+        pScore1 = pCandidate.mY + pCandidate.mHeight;
+        pScore2 = pCandidate.mX;
+        break;
+
+    case Heuristic_ContactPoint:
+        pScore1 = -GetContactScore( pCandidate );
+        pScore2 = 0;
+        break;
+
+    default:
+        debugBreak();
+        pScore1 = 0;
+        pScore2 = 0;
+        break;
+    }
+}
+
+//! Length of the segment shared by [pStart1, pEnd1] and [pStart2, pEnd2], 0 if they don't overlap.
+static Int32 CommonIntervalLength( UInt32 pStart1, UInt32 pEnd1, UInt32 pStart2, UInt32 pEnd2 )
+{
+    if( pEnd1 < pStart2 || pEnd2 < pStart1 )
+        return 0;
+
+    return Maths::Min( pEnd1, pEnd2 ) - Maths::Max( pStart1, pStart2 );
+}
+
+Int32 RectPacker::GetContactScore( const Rect& pCandidate ) const
+{
+    UInt32 left   = pCandidate.mX;
+    UInt32 right  = pCandidate.mX + pCandidate.mWidth;
+    UInt32 top    = pCandidate.mY;
+    UInt32 bottom = pCandidate.mY + pCandidate.mHeight;
+
+    Int32 score = 0;
+
+    if( left == 0 || right == mWidth )
+        score += pCandidate.mHeight;
+
+    if( top == 0 || bottom == mHeight )
+        score += pCandidate.mWidth;
+
+    for( UInt32 i = 0; i < mUsedRects.size(); i++ )
+    {
+        const Rect& used = mUsedRects[i];
+
+        if( used.mX == right || used.mX + used.mWidth == left )
+            score += CommonIntervalLength( used.mY, used.mY + used.mHeight, top, bottom );
+
+        if( used.mY == bottom || used.mY + used.mHeight == top )
+            score += CommonIntervalLength( used.mX, used.mX + used.mWidth, left, right );
+    }
+
+    return score;
+}
+
+void RectPacker::PlaceRect( const Rect& pRect )
+{
+    for( UInt32 i = 0; i < mFreeRects.size(); )
+    {
+        if( mFreeRects[i].Intersects( pRect ) )
+        {
+            SplitFreeRect( mFreeRects[i], pRect );
+
+            mFreeRects[i] = mFreeRects.back();
+            mFreeRects.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    PruneFreeRects();
+
+    mUsedRects.push_back( pRect );
+    mUsedArea += pRect.mWidth * pRect.mHeight;
+}
+
+void RectPacker::SplitFreeRect( const Rect& pFreeRect, const Rect& pUsedRect )
+{
+    // Keep the maximal free rectangles on each side of the used one.
+    if( pUsedRect.mX > pFreeRect.mX )
+        mNewFreeRects.push_back( Rect(pFreeRect.mX, pFreeRect.mY, pUsedRect.mX - pFreeRect.mX, pFreeRect.mHeight) );
+
+    if( pUsedRect.mX + pUsedRect.mWidth < pFreeRect.mX + pFreeRect.mWidth )
+    {
+        UInt32 x = pUsedRect.mX + pUsedRect.mWidth;
+        mNewFreeRects.push_back( Rect(x, pFreeRect.mY, pFreeRect.mX + pFreeRect.mWidth - x, pFreeRect.mHeight) );
+    }
+
+    if( pUsedRect.mY > pFreeRect.mY )
+        mNewFreeRects.push_back( Rect(pFreeRect.mX, pFreeRect.mY, pFreeRect.mWidth, pUsedRect.mY - pFreeRect.mY) );
+
+    if( pUsedRect.mY + pUsedRect.mHeight < pFreeRect.mY + pFreeRect.mHeight )
+    {
+        UInt32 y = pUsedRect.mY + pUsedRect.mHeight;
+        mNewFreeRects.push_back( Rect(pFreeRect.mX, y, pFreeRect.mWidth, pFreeRect.mY + pFreeRect.mHeight - y) );
+    }
+}
+
+void RectPacker::PruneFreeRects()
+{
+    // The remaining free rectangles don't contain each other, and none of them
+    // can be contained in a new one (it's a part of a rectangle that didn't
+    // contain them). Only the new rectangles need to be tested.
+    for( UInt32 i = 0; i < mNewFreeRects.size(); i++ )
+    {
+        const Rect& newRect = mNewFreeRects[i];
+        Bool        contained = false;
+
+        for( UInt32 j = 0; j < mFreeRects.size() && !contained; j++ )
+            contained = mFreeRects[j].Contains( newRect );
+
+        // Among identical new rectangles, keep the last one.
+        for( UInt32 j = 0; j < mNewFreeRects.size() && !contained; j++ )
+        {
+            if( j != i && mNewFreeRects[j].Contains( newRect ) )
+                contained = j > i || !newRect.Contains( mNewFreeRects[j] );
+        }
+
+        if( !contained )
+            mFreeRects.push_back( newRect );
+    }
+
+    mNewFreeRects.clear();
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,137 @@
+/**
+ *  @file       RectPacker.h
+ *  @brief      Pack rectangles in a fixed size area (MaxRects).
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _RECT_PACKER_H_
+#define     _RECT_PACKER_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Place rectangles in a fixed size area using the MaxRects algorithm: the free
+ *  space is kept as a list of maximal, possibly overlapping, free rectangles.
+ *  Each insertion picks the free rectangle that scores best for the selected
+ *  heuristic, then splits every free rectangle it overlaps.
+ */
+class ENGINE_API RectPacker
+{
+public:
+    enum Heuristic
+    {
+        Heuristic_BestShortSideFit,     //!< Smallest leftover on the shortest side.
+        Heuristic_BestLongSideFit,      //!< Smallest leftover on the longest side.
+        Heuristic_BestAreaFit,          //!< Smallest free rectangle.
+        Heuristic_BottomLeft,           //!< Lowest position, then leftmost (Tetris like).
+        Heuristic_ContactPoint,         //!< Touch the area borders and the placed rectangles as much as possible.
+        Heuristic_Count
+    };
+
+    class Rect
+    {
+    public:
+        Rect()
+            : mX(0)
+            , mY(0)
+            , mWidth(0)
+            , mHeight(0)
+        {
+        }
+
+        Rect( UInt32 pX, UInt32 pY, UInt32 pWidth, UInt32 pHeight )
+            : mX(pX)
+            , mY(pY)
+            , mWidth(pWidth)
+            , mHeight(pHeight)
+        {
+        }
+
+        Bool Contains( const Rect& pOther ) const
+        {
+            return pOther.mX >= mX && pOther.mY >= mY &&
+                   pOther.mX + pOther.mWidth  <= mX + mWidth &&
+                   pOther.mY + pOther.mHeight <= mY + mHeight;
+        }
+
+        Bool Intersects( const Rect& pOther ) const
+        {
+            return pOther.mX < mX + mWidth && mX < pOther.mX + pOther.mWidth &&
+                   pOther.mY < mY + mHeight && mY < pOther.mY + pOther.mHeight;
+        }
+
+        UInt32  mX;
+        UInt32  mY;
+        UInt32  mWidth;
+        UInt32  mHeight;
+    };
+
+public:
+    RectPacker( UInt32 pWidth = 0, UInt32 pHeight = 0, Bool pAllowRotation = false );
+
+    //! Remove every rectangle and resize the area.
+    void Reset( UInt32 pWidth, UInt32 pHeight, Bool pAllowRotation );
+
+    /**
+     *  Find a place for a pWidth x pHeight rectangle and reserve it.
+     *  @param  pResult     Receives the placed rectangle, with width and height swapped if rotated.
+     *  @param  pRotated    Receives true if the rectangle was rotated by 90 degrees to fit.
+     *  @return false if there's no room left for the rectangle.
+     */
+    Bool Insert( UInt32 pWidth, UInt32 pHeight, Heuristic pHeuristic, Rect& pResult, Bool& pRotated );
+
+    UInt32 GetWidth() const;
+    UInt32 GetHeight() const;
+
+    //! Area covered by the inserted rectangles.
+    UInt32 GetUsedArea() const;
+
+    //! Ratio of the area covered by the inserted rectangles, between 0 and 1.
+    Float  GetOccupancy() const;
+
+private:
+    Bool   FindPosition( UInt32 pWidth, UInt32 pHeight, Heuristic pHeuristic, Rect& pResult, Bool& pRotated ) const;
+    void   ScorePosition( const Rect& pFreeRect, const Rect& pCandidate, Heuristic pHeuristic, Int32& pScore1, Int32& pScore2 ) const;
+    Int32  GetContactScore( const Rect& pCandidate ) const;
+
+    void   PlaceRect( const Rect& pRect );
+    void   SplitFreeRect( const Rect& pFreeRect, const Rect& pUsedRect );
+    void   PruneFreeRects();
+
+private:
+    UInt32          mWidth;
+    UInt32          mHeight;
+    Bool            mAllowRotation;
+    UInt32          mUsedArea;
+
+    Vector<Rect>    mFreeRects;
+    Vector<Rect>    mUsedRects;
+    Vector<Rect>    mNewFreeRects;      //!< Free rectangles created by the last split, not yet pruned.
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _RECT_PACKER_H_
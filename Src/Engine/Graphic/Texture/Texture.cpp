@@ -40,6 +40,19 @@ IMPLEMENT_ABSTRACT_CLASS(Texture2D);
 IMPLEMENT_ABSTRACT_CLASS(Texture3D);
 IMPLEMENT_ABSTRACT_CLASS(Cubemap);
 
+
+//! Bytes of pImage sent to the renderer, starting at pFirstMipmap. Mipmaps built by the renderer are included.
+static UInt32 GetUploadedSize( const Image& pImage, Bool pHasMipmaps, UInt32 pFirstMipmap = 0 )
+{
+    if( pImage.GetData() == NULL )
+        return 0;
+
+    if( pImage.GetNumMipmaps() == 1 && pHasMipmaps )
+        return pImage.GetDataSize() + pImage.GetDataSize() / 3;
+
+    return pImage.GetDataSize() - Image::GetSizeWithMipmaps( pImage.GetFormat(), pImage.GetWidth(), pImage.GetHeight(), pImage.GetDepth(), pFirstMipmap );
+}
+
 void Texture::Serialize( Stream& pStream )
 {
     Super::Serialize( pStream );
@@ -114,6 +127,7 @@ Bool Texture1D::Create( const Image& pImage, Bool pCreateMipmaps )
 
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -129,6 +143,7 @@ Bool Texture1D::Create( UInt32 pWidth, Image::Format pFormat)
     mMinFilter = MinFilter_Linear;
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -143,6 +158,11 @@ void Texture1D::Update()
     Init();
 }
 
+UInt32 Texture1D::GetResidentSize() const
+{
+    return GetUploadedSize( mImage, mHasMipmaps );
+}
+
 Bool Texture2D::Create( const Image& pImage, Bool pCreateMipmaps )
 {
     mImage  = pImage;
@@ -151,6 +171,10 @@ Bool Texture2D::Create( const Image& pImage, Bool pCreateMipmaps )
     mHeight = pImage.GetHeight();
     mHasMipmaps = pCreateMipmaps;
 
+    // Keep the streamed resolution, as long as the new image has this mipmap.
+    if( mFirstMipmap >= mImage.GetNumMipmaps() )
+        mFirstMipmap = 0;
+
     // Filtering
     if( mHasMipmaps )
     {
@@ -165,6 +189,7 @@ Bool Texture2D::Create( const Image& pImage, Bool pCreateMipmaps )
 
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -175,12 +200,14 @@ Bool Texture2D::Create( UInt32 pWidth, UInt32 pHeight, Image::Format pFormat )
     mHeight = pHeight;
     mFormat = pFormat;
     mHasMipmaps = false;
+    mFirstMipmap = 0;
 
     // Filtering
     mMagFilter = MagFilter_Linear; 
     mMinFilter = MinFilter_Linear;
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -195,6 +222,21 @@ void Texture2D::Update()
     Init();
 }
 
+UInt32 Texture2D::GetResidentSize() const
+{
+    return GetUploadedSize( mImage, mHasMipmaps, mFirstMipmap );
+}
+
+void Texture2D::RequestSize( Float pScreenSize )
+{
+    mRequestedSize = Maths::Max( mRequestedSize, pScreenSize );
+}
+
+UInt32 Texture2D::GetFirstMipmap() const
+{
+    return mFirstMipmap;
+}
+
 Bool Texture3D::Create( const Image& pImage, Bool pCreateMipmaps )
 {
     mImage  = pImage;
@@ -218,6 +260,7 @@ Bool Texture3D::Create( const Image& pImage, Bool pCreateMipmaps )
 
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -235,6 +278,7 @@ Bool Texture3D::Create( UInt32 pWidth, UInt32 pHeight, UInt32 pDepth, Image::For
     mMinFilter = MinFilter_Linear;
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -249,6 +293,11 @@ void Texture3D::Update()
     Init();
 }
 
+UInt32 Texture3D::GetResidentSize() const
+{
+    return GetUploadedSize( mImage, mHasMipmaps );
+}
+
 Bool Cubemap::Create( const Vector<Image*>& pImages, Bool pCreateMipmaps )
 {
     // User must provide 6 images.
@@ -298,6 +347,7 @@ Bool Cubemap::Create( const Vector<Image*>& pImages, Bool pCreateMipmaps )
 
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -320,6 +370,7 @@ Bool Cubemap::Create( UInt32 pWidth, UInt32 pHeight, Image::Format pFormat )
     mMinFilter = MinFilter_Linear;
     mAnisotropy = GraphicSubsystem::Instance()->GetRenderer()->GetMaxAnisotropy();
 
+    MarkDirty();
     return true;
 }
 
@@ -343,5 +394,23 @@ void Cubemap::Update()
     Init();
 }
 
+UInt32 Cubemap::GetResidentSize() const
+{
+    UInt32 size = 0;
+    for( UInt32 i = 0; i < Cubemap::NumFaces; i++ )
+        size += GetUploadedSize( mImages[i], mHasMipmaps );
+
+    return size;
+}
+
+void Cubemap::GenerateMipmaps( Image::MipmapFilter pFilter, Bool pSRGB )
+{
+    for( UInt32 i = 0; i < Cubemap::NumFaces; i++ )
+        mImages[i].GenerateMipmaps( pFilter, pSRGB );
+
+    mHasMipmaps = true;
+    MarkDirty();
+}
+
 
 } // namespace Gamedesk
@@ -106,22 +106,26 @@ public:
         
     virtual void SetWrapMode( WrapAxis pWrapAxis, WrapMode pWrapMode )
     {
-        mWrapMode[pWrapAxis] = pWrapMode;        
+        mWrapMode[pWrapAxis] = pWrapMode;
+        MarkDirty();
     }
     
     virtual void SetMagFilter( MagFilter pFilter )
     {
         mMagFilter = pFilter;
+        MarkDirty();
     }
     
     virtual void SetMinFilter( MinFilter pFilter )
     {
         mMinFilter = pFilter;
+        MarkDirty();
     }
 
     virtual void SetAnisotropy( Float pAnisotropy )
     {
         mAnisotropy = pAnisotropy;
+        MarkDirty();
     }
 
     Bool HasMipmaps() const
@@ -149,6 +153,9 @@ public:
         return mAnisotropy;
     }
 
+    //! Size in bytes of the data sent to the renderer, mipmaps included.
+    virtual UInt32 GetResidentSize() const = 0;
+
     virtual void Serialize( Stream& pStream );
     
 protected:
@@ -194,6 +201,8 @@ public:
     Image&  GetImage();
     void    Update();
 
+    virtual UInt32 GetResidentSize() const;
+
 protected:
     Texture1D() {}
 
@@ -216,10 +225,20 @@ public:
     Image&  GetImage();
     void    Update();
 
+    virtual UInt32 GetResidentSize() const;
+
+    //! Report the size in pixels the texture covers on screen, used to stream its mipmaps.
+    void    RequestSize( Float pScreenSize );
+
+    //! First mipmap of the image sent to the renderer, the ones above are not resident.
+    UInt32  GetFirstMipmap() const;
+
 protected:
-    Texture2D() {} 
+    Texture2D() : mFirstMipmap(0), mRequestedSize(0.0f) {}
 
     Image   mImage;
+    UInt32  mFirstMipmap;
+    Float   mRequestedSize;     //!< Largest size requested since the last TextureManager::Update().
 };
 
 
@@ -238,6 +257,8 @@ public:
     Image&  GetImage();
     void    Update();
 
+    virtual UInt32 GetResidentSize() const;
+
 protected:
     Texture3D() {}
 
@@ -272,6 +293,11 @@ public:
     Image&  GetImage( CubemapFace pFace );
     void    Update();
 
+    virtual UInt32 GetResidentSize() const;
+
+    //! Build the mipmaps of the six faces on the cpu, call Update() to send them to the renderer.
+    void    GenerateMipmaps( Image::MipmapFilter pFilter = Image::MipmapFilter_Box, Bool pSRGB = false );
+
 protected:
     Cubemap() {}   
 
@@ -34,10 +34,70 @@
 
 
 #include "Graphic/GraphicSubsystem.h"
+#include "Graphic/Renderer.h"
 
 
 namespace Gamedesk {
 	
+
+static const UInt32 DEFAULT_BUDGET          = 128 * 1024 * 1024;
+static const UInt32 DEFAULT_UPLOAD_BUDGET   = 2 * 1024 * 1024;
+
+static const UInt32 STREAMING_MIN_SIZE      = 512;  //!< 2D textures larger than this have their mipmaps streamed.
+static const UInt32 STREAMING_BASE_SIZE     = 64;   //!< Size of the first mipmap sent for a streamed texture.
+static const UInt32 IDLE_FRAMES             = 60;   //!< Frames without request after which streamed mipmaps can be dropped.
+
+
+//! Bytes of pImage from pFirstMipmap to the last mipmap.
+static UInt32 GetMipmapsSize( const Image& pImage, UInt32 pFirstMipmap )
+{
+    return pImage.GetDataSize() - Image::GetSizeWithMipmaps( pImage.GetFormat(), pImage.GetWidth(), pImage.GetHeight(), 1, pFirstMipmap );
+}
+
+
+class TextureManager::StreamRequest
+{
+public:
+    Entry*      mEntry;
+    UInt32      mFirstMipmap;   //!< Mipmap needed to cover the requested size.
+};
+
+
+//! Textures missing the most mipmaps are streamed first.
+class TextureManager::StreamRequestOrder
+{
+public:
+    Bool operator()( const StreamRequest& pLeft, const StreamRequest& pRight ) const
+    {
+        return (pLeft.mEntry->mStreamed->mFirstMipmap - pLeft.mFirstMipmap) >
+               (pRight.mEntry->mStreamed->mFirstMipmap - pRight.mFirstMipmap);
+    }
+};
+
+
+TextureManager::Stats::Stats()
+    : mResidentSize(0)
+    , mNbTextures(0)
+    , mNbCachedTextures(0)
+    , mNbLoads(0)
+    , mNbCacheHits(0)
+    , mNbEvictions(0)
+    , mNbMipmapLoads(0)
+    , mNbMipmapDrops(0)
+{
+}
+
+
+TextureManager::Entry::Entry()
+    : mTexture(NULL)
+    , mStreamed(NULL)
+    , mResidentSize(0)
+    , mBaseMipmap(0)
+    , mLastRequestFrame(0)
+    , mCached(false)
+{
+}
+
 	
 TextureManager TextureManager::mInstance;
 TextureManager& TextureManager::Instance()
@@ -47,103 +107,306 @@ TextureManager& TextureManager::Instance()
 
 
 TextureManager::TextureManager()
+    : mBudget(DEFAULT_BUDGET)
+    , mUploadBudget(DEFAULT_UPLOAD_BUDGET)
+    , mFrame(0)
 {
 }
 
 
 Texture1D* TextureManager::CreateTexture1D( const String& pImageFile )
 {
-    std::map<String,Texture*>::iterator  itFind = mLoadedTextures.find( pImageFile );
-    if( itFind != mLoadedTextures.end() )
-    {
-        itFind->second->AddRef();
-        return Cast<Texture1D>(itFind->second);
-    }
-    else
+    return Cast<Texture1D>( Acquire(pImageFile) );
+}
+
+
+Texture2D* TextureManager::CreateTexture2D( const String& pImageFile )
+{
+    return Cast<Texture2D>( Acquire(pImageFile) );
+}
+
+Texture3D* TextureManager::CreateTexture3D( const String& pImageFile )
+{
+    return Cast<Texture3D>( Acquire(pImageFile) );
+}
+
+Cubemap* TextureManager::CreateCubemap( const String& pImageFile )
+{
+    return Cast<Cubemap>( Acquire(pImageFile) );
+}
+
+void TextureManager::Release( const String& pTextureFile )
+{
+    EntryMap::iterator itFind = mLoadedTextures.find( pTextureFile );
+    GD_ASSERT( itFind != mLoadedTextures.end() );
+    
+    Entry& entry = itFind->second;
+    if( entry.mTexture->RemoveRef() )
     {
-        ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile( pImageFile, Texture::StaticClass() );
+        // Keep it around until the budget is exceeded, it's likely to be used again.
+        mCachedTextures.push_front( pTextureFile );
+        entry.mCachePosition = mCachedTextures.begin();
+        entry.mCached = true;
+
+        mStats.mNbTextures--;
+        mStats.mNbCachedTextures++;
 
-        Texture1D* texture = Cast<Texture1D>(importer->Import(pImageFile) );
-        texture->Init();
-        texture->AddRef();
-        mLoadedTextures[pImageFile] = texture;
-        return texture;
-    }        
+        MakeRoom( 0, NULL );
+    }
 }
 
+Bool TextureManager::IsLoaded( const String& pTextureFile ) const
+{
+    return mLoadedTextures.find( pTextureFile ) != mLoadedTextures.end();
+}
 
-Texture2D* TextureManager::CreateTexture2D( const String& pImageFile )
+void TextureManager::Update()
 {
-    std::map<String,Texture*>::iterator  itFind = mLoadedTextures.find( pImageFile );
-    if( itFind != mLoadedTextures.end() )
+    mFrame++;
+
+    Vector<StreamRequest> requests;
+
+    for( EntryMap::iterator itEntry = mLoadedTextures.begin(); itEntry != mLoadedTextures.end(); ++itEntry )
     {
-        itFind->second->AddRef();
-        return Cast<Texture2D>(itFind->second);
+        Entry& entry = itEntry->second;
+        Texture2D* texture = entry.mStreamed;
+        if( texture == NULL || entry.mCached || texture->mRequestedSize <= 0.0f )
+            continue;
+
+        entry.mLastRequestFrame = mFrame;
+
+        // Lowest resolution that still covers the requested size.
+        const Image& image = texture->mImage;
+        UInt32 maxSize = Maths::Max( image.GetWidth(), image.GetHeight() );
+        UInt32 firstMipmap = entry.mBaseMipmap;
+        while( firstMipmap > 0 && Float(maxSize >> firstMipmap) < texture->mRequestedSize )
+            firstMipmap--;
+
+        texture->mRequestedSize = 0.0f;
+
+        if( firstMipmap < texture->mFirstMipmap )
+        {
+            StreamRequest request;
+            request.mEntry = &entry;
+            request.mFirstMipmap = firstMipmap;
+            requests.push_back( request );
+        }
     }
-    else
+
+    std::sort( requests.begin(), requests.end(), StreamRequestOrder() );
+
+    UInt32 uploadedSize = 0;
+    for( Vector<StreamRequest>::iterator itRequest = requests.begin(); itRequest != requests.end(); ++itRequest )
     {
-        ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile( pImageFile, Texture::StaticClass() );
+        Entry& entry = *itRequest->mEntry;
+        const Image& image = entry.mStreamed->mImage;
+        UInt32 currentMipmap = entry.mStreamed->mFirstMipmap;
+        UInt32 firstMipmap = currentMipmap;
+
+        // Go up one mipmap at a time, the whole chain is sent again so it's what counts against the upload budget.
+        while( firstMipmap > itRequest->mFirstMipmap )
+        {
+            UInt32 size = GetMipmapsSize( image, firstMipmap - 1 );
+            Bool firstUpload = uploadedSize == 0 && firstMipmap == currentMipmap;
+            if( uploadedSize + size > mUploadBudget && !firstUpload )
+                break;
 
-        Texture2D* texture = Cast<Texture2D>(importer->Import(pImageFile) );
-        texture->Init();
-        texture->AddRef();
-        mLoadedTextures[pImageFile] = texture;
-        return texture;
-    }        
+            if( !MakeRoom( size - entry.mResidentSize, &entry ) )
+                break;
+
+            firstMipmap--;
+        }
+
+        // No room for this one, a smaller request may still fit.
+        if( firstMipmap == currentMipmap )
+            continue;
+
+        SetFirstMipmap( entry, firstMipmap );
+        uploadedSize += entry.mResidentSize;
+        mStats.mNbMipmapLoads += currentMipmap - firstMipmap;
+    }
 }
 
-Texture3D* TextureManager::CreateTexture3D( const String& pImageFile )
+void TextureManager::Flush()
+{
+    while( !mCachedTextures.empty() )
+        Destroy( mLoadedTextures.find(mCachedTextures.back()) );
+}
+
+void TextureManager::SetBudget( UInt32 pBudget )
 {
-    std::map<String,Texture*>::iterator  itFind = mLoadedTextures.find( pImageFile );
+    mBudget = pBudget;
+    MakeRoom( 0, NULL );
+}
+
+UInt32 TextureManager::GetBudget() const
+{
+    return mBudget;
+}
+
+void TextureManager::SetUploadBudget( UInt32 pUploadBudget )
+{
+    mUploadBudget = pUploadBudget;
+}
+
+UInt32 TextureManager::GetUploadBudget() const
+{
+    return mUploadBudget;
+}
+
+const TextureManager::Stats& TextureManager::GetStats() const
+{
+    return mStats;
+}
+
+Float TextureManager::GetScreenScale()
+{
+    Renderer* renderer = GraphicSubsystem::Instance()->GetRenderer();
+
+    Matrix4f projectionMatrix;
+    renderer->GetProjectionMatrix( projectionMatrix );
+
+    Int32 viewport[4];
+    renderer->GetViewport( viewport );
+
+    return Float(viewport[3]) * 0.5f * projectionMatrix(1,1);
+}
+
+Texture* TextureManager::Acquire( const String& pTextureFile )
+{
+    EntryMap::iterator itFind = mLoadedTextures.find( pTextureFile );
+
+    // A released texture whose file changed since it was imported is imported again.
+    if( itFind != mLoadedTextures.end() && itFind->second.mCached &&
+        ResourceManager::Instance()->IsSourceModified( pTextureFile, itFind->second.mSourceChecksum ) )
+    {
+        Destroy( itFind );
+        itFind = mLoadedTextures.end();
+    }
+
     if( itFind != mLoadedTextures.end() )
     {
-        itFind->second->AddRef();
-        return Cast<Texture3D>(itFind->second);
+        Entry& entry = itFind->second;
+        if( entry.mCached )
+        {
+            mCachedTextures.erase( entry.mCachePosition );
+            entry.mCached = false;
+
+            mStats.mNbCachedTextures--;
+            mStats.mNbTextures++;
+            mStats.mNbCacheHits++;
+        }
+
+        entry.mTexture->AddRef();
+        return entry.mTexture;
     }
-    else
+
+    ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile( pTextureFile, Texture::StaticClass() );
+    Texture* texture = Cast<Texture>( importer->Import(pTextureFile) );
+
+    Entry& entry = mLoadedTextures[pTextureFile];
+    entry.mTexture = texture;
+    entry.mLastRequestFrame = mFrame;
+    entry.mSourceChecksum = ResourceManager::Instance()->GetSourceChecksum( pTextureFile );
+
+    // Large 2D textures start with a low resolution, Update() streams in the rest.
+    if( texture->IsA(Texture2D::StaticClass()) && texture->HasMipmaps() )
     {
-        ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile( pImageFile, Texture::StaticClass() );
+        Texture2D* texture2D = Cast<Texture2D>(texture);
+        Image& image = texture2D->mImage;
+
+        // Generating the mipmaps of a compressed image here would stall the load on a lossy
+        // re-encode, those are loaded whole unless their mipmaps were generated at import.
+        if( Maths::Max(image.GetWidth(), image.GetHeight()) > STREAMING_MIN_SIZE &&
+            (!image.IsCompressed() || image.GetNumMipmaps() > 1) )
+        {
+            if( image.GetNumMipmaps() == 1 )
+                image.GenerateMipmaps();
+
+            UInt32 firstMipmap = 0;
+            while( firstMipmap + 1 < image.GetNumMipmaps() &&
+                   Maths::Max(image.GetWidth() >> firstMipmap, image.GetHeight() >> firstMipmap) > STREAMING_BASE_SIZE )
+            {
+                firstMipmap++;
+            }
+
+            texture2D->mFirstMipmap = firstMipmap;
+            entry.mStreamed = texture2D;
+            entry.mBaseMipmap = firstMipmap;
+        }
+    }
+
+    texture->Init();
+    texture->AddRef();
+
+    entry.mResidentSize = texture->GetResidentSize();
+    mStats.mResidentSize += entry.mResidentSize;
+    mStats.mNbTextures++;
+    mStats.mNbLoads++;
+
+    MakeRoom( 0, &entry );
 
-        Texture3D* texture = Cast<Texture3D>(importer->Import(pImageFile) );
-        texture->Init();
-        texture->AddRef();
-        mLoadedTextures[pImageFile] = texture;
-        return texture;
-    }        
+    return texture;
 }
 
-Cubemap* TextureManager::CreateCubemap( const String& pImageFile )
+void TextureManager::Destroy( EntryMap::iterator pEntry )
 {
-    std::map<String,Texture*>::iterator  itFind = mLoadedTextures.find( pImageFile );
-    if( itFind != mLoadedTextures.end() )
+    Entry& entry = pEntry->second;
+    if( entry.mCached )
     {
-        itFind->second->AddRef();
-        return Cast<Cubemap>(itFind->second);
+        mCachedTextures.erase( entry.mCachePosition );
+        mStats.mNbCachedTextures--;
     }
     else
     {
-        ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile( pImageFile, Texture::StaticClass() );
+        mStats.mNbTextures--;
+    }
+
+    mStats.mResidentSize -= entry.mResidentSize;
 
-        Cubemap* texture = Cast<Cubemap>(importer->Import(pImageFile) );
-        texture->Init();
-        texture->AddRef();
-        mLoadedTextures[pImageFile] = texture;
-        return texture;
-    }        
+    entry.mTexture->Kill();
+    GD_DELETE(entry.mTexture);
+
+    mLoadedTextures.erase( pEntry );
 }
 
-void TextureManager::Release( const String& pTextureFile )
+void TextureManager::SetFirstMipmap( Entry& pEntry, UInt32 pFirstMipmap )
 {
-    std::map<String,Texture*>::iterator  itFind = mLoadedTextures.find( pTextureFile );
-    GD_ASSERT( itFind != mLoadedTextures.end() );
-            
-    if( itFind->second->RemoveRef() )
+    pEntry.mStreamed->mFirstMipmap = pFirstMipmap;
+    pEntry.mStreamed->Init();
+
+    mStats.mResidentSize -= pEntry.mResidentSize;
+    pEntry.mResidentSize = pEntry.mStreamed->GetResidentSize();
+    mStats.mResidentSize += pEntry.mResidentSize;
+}
+
+Bool TextureManager::MakeRoom( UInt32 pSize, const Entry* pRequester )
+{
+    // Least recently released textures go first.
+    while( mStats.mResidentSize + pSize > mBudget && !mCachedTextures.empty() )
     {
-        itFind->second->Kill();
-        GD_DELETE(itFind->second);
+        Destroy( mLoadedTextures.find(mCachedTextures.back()) );
+        mStats.mNbEvictions++;
+    }
 
-        mLoadedTextures.erase( itFind );
+    // Then the streamed mipmaps nobody asked for lately.
+    for( EntryMap::iterator itEntry = mLoadedTextures.begin(); 
+         itEntry != mLoadedTextures.end() && mStats.mResidentSize + pSize > mBudget; 
+         ++itEntry )
+    {
+        Entry& entry = itEntry->second;
+        if( &entry == pRequester || entry.mStreamed == NULL )
+            continue;
+
+        UInt32 firstMipmap = entry.mStreamed->mFirstMipmap;
+        if( firstMipmap < entry.mBaseMipmap && mFrame - entry.mLastRequestFrame > IDLE_FRAMES )
+        {
+            SetFirstMipmap( entry, entry.mBaseMipmap );
+            mStats.mNbMipmapDrops += entry.mBaseMipmap - firstMipmap;
+        }
     }
+
+    return mStats.mResidentSize + pSize <= mBudget;
 }
 
 
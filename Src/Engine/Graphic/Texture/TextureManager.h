@@ -30,15 +30,42 @@
 
 
 #include "Texture.h"
+#include "FileManager/FileChecksumCache.h"
 
 
 namespace Gamedesk {
 
 
+/**
+ *  Load textures from files and share them. Textures that are no longer
+ *  referenced stay in a least recently used list and are only destroyed when
+ *  the resident size goes over the budget, or imported again if their file
+ *  changed when they are requested.
+ *  Large 2D textures are first sent to the renderer with a low resolution, the
+ *  higher mipmaps are streamed in by Update() when Texture2D::RequestSize()
+ *  reports that they are needed, within an upload budget per frame.
+ */
 class ENGINE_API TextureManager
 {
     CLASS_DISABLE_COPY(TextureManager);
 
+public:
+    //! Statistics of the texture cache.
+    class Stats
+    {
+    public:
+        Stats();
+
+        UInt32  mResidentSize;          //!< Bytes of texture data sent to the renderer.
+        UInt32  mNbTextures;            //!< Textures in use.
+        UInt32  mNbCachedTextures;      //!< Textures no longer referenced, kept in the LRU.
+        UInt32  mNbLoads;               //!< Textures imported from a file.
+        UInt32  mNbCacheHits;           //!< Textures taken back from the LRU instead of being imported.
+        UInt32  mNbEvictions;           //!< Textures destroyed to stay within the budget.
+        UInt32  mNbMipmapLoads;         //!< Mipmaps streamed in.
+        UInt32  mNbMipmapDrops;         //!< Mipmaps dropped to stay within the budget.
+    };
+
 public:
     static TextureManager& Instance();
 
@@ -55,13 +82,69 @@ public:
     Cubemap*   CreateCubemap( const String& pTextureFile );
     
     void Release( const String& pTextureFile );
+
+    //! Returns true if pTextureFile is in use or cached, creating it again won't import the file.
+    Bool IsLoaded( const String& pTextureFile ) const;
+
+    //! Stream in the mipmaps requested since the last call. Call once per frame, from the render thread.
+    void Update();
+
+    //! Destroy the textures that are no longer referenced. Must be called while the renderer is alive.
+    void Flush();
+
+    //! Resident size over which unreferenced textures and unused mipmaps are dropped, in bytes.
+    void   SetBudget( UInt32 pBudget );
+    UInt32 GetBudget() const;
+
+    //! Maximum size of the mipmaps sent to the renderer by each Update(), in bytes.
+    void   SetUploadBudget( UInt32 pUploadBudget );
+    UInt32 GetUploadBudget() const;
+
+    const Stats& GetStats() const;
+
+    //! Pixels covered by an object of size 1 at a distance of 1, with the current projection and viewport.
+    static Float GetScreenScale();
     
 protected:
     // Disable creation from outside.
     TextureManager();
 
 private:
-    std::map<String,Texture*>    mLoadedTextures;
+    class Entry
+    {
+    public:
+        Entry();
+
+        Texture*                mTexture;
+        Texture2D*              mStreamed;          //!< mTexture if its mipmaps are streamed, NULL otherwise.
+        UInt32                  mResidentSize;
+        UInt32                  mBaseMipmap;        //!< First mipmap when loaded, the lowest resolution ever kept.
+        UInt32                  mLastRequestFrame;
+        Bool                    mCached;            //!< No longer referenced, in the LRU.
+        List<String>::iterator  mCachePosition;
+        FileChecksum            mSourceChecksum;    //!< Checksum of the file when it was imported.
+    };
+
+    typedef std::map<String,Entry> EntryMap;
+
+    class StreamRequest;
+    class StreamRequestOrder;
+
+    Texture*    Acquire( const String& pTextureFile );
+    void        Destroy( EntryMap::iterator pEntry );
+    void        SetFirstMipmap( Entry& pEntry, UInt32 pFirstMipmap );
+
+    //! Evict textures then mipmaps until pSize more bytes fit in the budget. pRequester keeps its mipmaps.
+    Bool        MakeRoom( UInt32 pSize, const Entry* pRequester );
+
+private:
+    EntryMap                    mLoadedTextures;
+    List<String>                mCachedTextures;    //!< Most recently released first.
+
+    UInt32                      mBudget;
+    UInt32                      mUploadBudget;
+    UInt32                      mFrame;
+    Stats                       mStats;
     
     static TextureManager        mInstance;
 };
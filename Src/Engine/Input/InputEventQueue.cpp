@@ -0,0 +1,72 @@
+/**
+ *  @file       InputEventQueue.cpp
+ *  @brief      Timestamped input events passed from the input thread to the game thread.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "InputEventQueue.h"
+
+
+namespace Gamedesk {
+
+
+InputEventQueue::InputEventQueue()
+{
+}
+
+Bool InputEventQueue::Push( const InputEvent& pEvent )
+{
+    UInt32 written = (UInt32)mWritten.Get();
+    if( written - (UInt32)mRead.Get() >= CAPACITY )
+    {
+        mDropped.Increment();
+        return false;
+    }
+
+    mEvents[written & (CAPACITY - 1)] = pEvent;
+
+    // Publish the event to the consumer.
+    mWritten.Set( written + 1 );
+    return true;
+}
+
+Bool InputEventQueue::Pop( InputEvent& pEvent )
+{
+    UInt32 read = (UInt32)mRead.Get();
+    if( read == (UInt32)mWritten.Get() )
+        return false;
+
+    pEvent = mEvents[read & (CAPACITY - 1)];
+
+    // Give the slot back to the producer.
+    mRead.Set( read + 1 );
+    return true;
+}
+
+UInt32 InputEventQueue::GetNbDroppedEvents() const
+{
+    return (UInt32)mDropped.Get();
+}
+
+
+} // namespace Gamedesk
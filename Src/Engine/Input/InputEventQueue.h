@@ -0,0 +1,96 @@
+/**
+ *  @file       InputEventQueue.h
+ *  @brief      Timestamped input events passed from the input thread to the game thread.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _INPUT_EVENT_QUEUE_H_
+#define     _INPUT_EVENT_QUEUE_H_
+
+
+#include "Thread/Atomic.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  A change of a key, a mouse button or a mouse axis.
+ */
+class ENGINE_API InputEvent
+{
+public:
+    enum Type
+    {
+        Type_Key,                   //!< mCode is a Keyboard::Key, mValue is 1 when down, 0 when up.
+        Type_MouseButton,           //!< mCode is a Mouse::Button, mValue is 1 when down, 0 when up.
+        Type_MouseMotion            //!< mCode is a Mouse::Axis, mValue is the relative movement.
+    };
+
+public:
+    Type        mType;
+    UInt32      mCode;
+    Int32       mValue;
+    UInt64      mTime;              //!< When the event happened, in SystemInfo::GetMicroSec64() time.
+};
+
+
+/**
+ *  Fixed size ring of input events, lock free for one producer thread and
+ *  one consumer thread. The producer is the only writer of mWritten, the
+ *  consumer the only writer of mRead.
+ */
+class ENGINE_API InputEventQueue
+{
+public:
+    static const UInt32 CAPACITY = 1024;    //!< Must be a power of two.
+
+public:
+    InputEventQueue();
+
+    /**
+     *  Add an event, called by the producer thread.
+     *  @return \b false if the queue is full, the event is dropped.
+     */
+    Bool Push( const InputEvent& pEvent );
+
+    /**
+     *  Remove the oldest event, called by the consumer thread.
+     *  @return \b false if the queue is empty.
+     */
+    Bool Pop( InputEvent& pEvent );
+
+    //! Number of events dropped because the consumer was late.
+    UInt32 GetNbDroppedEvents() const;
+
+private:
+    InputEvent      mEvents[CAPACITY];
+    AtomicInt32     mWritten;
+    AtomicInt32     mRead;
+    AtomicInt32     mDropped;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _INPUT_EVENT_QUEUE_H_
@@ -28,6 +28,8 @@
 #include "Engine.h"
 #include "InputSubsystem.h"
 
+#include "SystemInfo/SystemInfo.h"
+
 
 namespace Gamedesk {
 	
@@ -36,7 +38,7 @@ IMPLEMENT_ABSTRACT_CLASS(InputSubsystem);
 IMPLEMENT_ABSTRACT_SINGLETON(InputSubsystem);
 
 
-InputSubsystem::InputSubsystem()
+InputSubsystem::InputSubsystem() : mAverageLatency(0), mMaxLatency(0)
 {
     mInstance = this;
 }
@@ -62,19 +64,34 @@ Keyboard& InputSubsystem::GetKeyboard()
         throw NullPointerException("mInstance",Here);
 }
 
+UInt64 InputSubsystem::GetAverageLatency() const
+{
+    return mAverageLatency;
+}
+
+UInt64 InputSubsystem::GetMaxLatency() const
+{
+    return mMaxLatency;
+}
+
+UInt32 InputSubsystem::GetNbDroppedEvents() const
+{
+    return mEventQueue.GetNbDroppedEvents();
+}
+
 void InputSubsystem::SetKeyboardState( Keyboard::Key pKey, Keyboard::KeyState pState )
 {
-    mKeyboard.mKeysStates[pKey] = pState;
+    mKeyboard.SetKeyState( pKey, pState );
 }
 
 void InputSubsystem::SetMouseButtonState( Mouse::Button pButton, Mouse::ButtonState pState )
 {
-    mMouse.mButtonsStates[pButton] = pState;
+    mMouse.SetButtonState( pButton, pState );
 }
 
 void InputSubsystem::SetMouseAxisValue( Mouse::Axis pAxis, Int32 pValue )
 {
-    mMouse.mAxis[pAxis] = pValue;
+    mMouse.SetAxis( pAxis, pValue );
 }
 
 void InputSubsystem::SetMousePosition( Int32 pPosX, Int32 pPosY )
@@ -83,11 +100,126 @@ void InputSubsystem::SetMousePosition( Int32 pPosX, Int32 pPosY )
     mMouse.mPosition[1] = pPosY;
 }
 
+Bool InputSubsystem::PostKeyEvent( Keyboard::Key pKey, Bool pDown, UInt64 pTime )
+{
+    InputEvent event;
+    event.mType  = InputEvent::Type_Key;
+    event.mCode  = pKey;
+    event.mValue = pDown ? 1 : 0;
+    event.mTime  = pTime;
+    return mEventQueue.Push( event );
+}
+
+Bool InputSubsystem::PostMouseButtonEvent( Mouse::Button pButton, Bool pDown, UInt64 pTime )
+{
+    InputEvent event;
+    event.mType  = InputEvent::Type_MouseButton;
+    event.mCode  = pButton;
+    event.mValue = pDown ? 1 : 0;
+    event.mTime  = pTime;
+    return mEventQueue.Push( event );
+}
+
+Bool InputSubsystem::PostMouseMotionEvent( Mouse::Axis pAxis, Int32 pValue, UInt64 pTime )
+{
+    InputEvent event;
+    event.mType  = InputEvent::Type_MouseMotion;
+    event.mCode  = pAxis;
+    event.mValue = pValue;
+    event.mTime  = pTime;
+    return mEventQueue.Push( event );
+}
+
 void InputSubsystem::FireEvents()
 {
+    mKeyboard.AdvanceStates();
+    mMouse.AdvanceStates();
+
+    ApplyEvents();
+
     mKeyboard.FireEvents();
     mMouse.FireEvents();
 }
 
+void InputSubsystem::ApplyEvents()
+{
+    UInt64 now = SystemInfo::Instance()->GetMicroSec64();
+    UInt64 totalLatency = 0;
+    UInt32 nbEvents = 0;
+
+    mMaxLatency = 0;
+
+    // Events deferred by the last frame come first, they may be deferred again.
+    Vector<InputEvent> deferredEvents;
+    deferredEvents.swap( mDeferredEvents );
+
+    InputEvent event;
+    UInt32 iDeferred = 0;
+    while( iDeferred < deferredEvents.size() || mEventQueue.Pop( event ) )
+    {
+        if( iDeferred < deferredEvents.size() )
+            event = deferredEvents[iDeferred++];
+
+        if( !ApplyEvent( event ) )
+        {
+            mDeferredEvents.push_back( event );
+            continue;
+        }
+
+        UInt64 latency = now > event.mTime ? now - event.mTime : 0;
+        totalLatency += latency;
+        mMaxLatency = Maths::Max( mMaxLatency, latency );
+        nbEvents++;
+    }
+
+    mAverageLatency = nbEvents ? totalLatency / nbEvents : 0;
+}
+
+Bool InputSubsystem::ApplyEvent( const InputEvent& pEvent )
+{
+    if( pEvent.mType == InputEvent::Type_MouseMotion )
+    {
+        mMouse.AddMotion( (Mouse::Axis)pEvent.mCode, pEvent.mValue );
+        return true;
+    }
+
+    // Keep the order of the events of a key or a button: once one is deferred, the following ones are too.
+    for( UInt32 i = 0; i < mDeferredEvents.size(); i++ )
+    {
+        if( mDeferredEvents[i].mType == pEvent.mType && mDeferredEvents[i].mCode == pEvent.mCode )
+            return false;
+    }
+
+    Bool down = pEvent.mValue != 0;
+
+    if( pEvent.mType == InputEvent::Type_Key )
+    {
+        Keyboard::Key key = (Keyboard::Key)pEvent.mCode;
+        
+        // Repeated key down or up, nothing changes.
+        if( down == mKeyboard.IsDown( key ) )
+            return true;
+
+        if( mKeyboard.HasChanged( key ) )
+            return false;
+
+        mKeyboard.SetKeyState( key, down ? Keyboard::Key_Pressed : Keyboard::Key_Released );
+    }
+    else
+    {
+        Mouse::Button button = (Mouse::Button)pEvent.mCode;
+
+        if( down == mMouse.IsDown( button ) )
+            return true;
+
+        if( mMouse.HasChanged( button ) )
+            return false;
+
+        mMouse.SetButtonState( button, down ? Mouse::Button_Pressed : Mouse::Button_Released );
+    }
+
+    return true;
+}
+
 
 } // namespace Gamedesk
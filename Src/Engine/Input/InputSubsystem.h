@@ -34,6 +34,7 @@
 
 #include "Mouse.h"
 #include "Keyboard.h"
+#include "InputEventQueue.h"
 
 
 namespace Gamedesk {
@@ -41,6 +42,12 @@ namespace Gamedesk {
 
 /**
  *  Manage access to input devices.
+ *
+ *  Devices are updated either by setting their state directly, or by posting
+ *  timestamped events from an input thread. Posted events are applied by
+ *  FireEvents(), one state change per key or button per frame: a key pressed
+ *  and released between two frames is seen pressed, then released at the
+ *  next frame.
  */
 class ENGINE_API InputSubsystem : public Subsystem
 {
@@ -70,6 +77,15 @@ public:
      *  Will thrown an exception if there is no InputSybsystem instance.
      */
     static Keyboard&  GetKeyboard();
+
+    //! Average time between the posting and the dispatch of the events applied by the last FireEvents(), in microseconds.
+    UInt64 GetAverageLatency() const;
+
+    //! Longest time between the posting and the dispatch of the events applied by the last FireEvents(), in microseconds.
+    UInt64 GetMaxLatency() const;
+
+    //! Number of posted events that were dropped because the event queue was full.
+    UInt32 GetNbDroppedEvents() const;
     
 protected:
     /**
@@ -108,9 +124,47 @@ protected:
      */
     void SetMousePosition( Int32 pPosX, Int32 pPosY );
 
-    //! Fire events (notify the device listeners of the changes to theses devices).
+    /**
+     *  Post a key event, it will be applied by the next FireEvents().
+     *  Only one thread may post events, it can be other than the one calling FireEvents().
+     *  @param  pKey    The key that changed.
+     *  @param  pDown   \btrue if the key went down, \bfalse if it went up.
+     *  @param  pTime   When the key changed, in SystemInfo::GetMicroSec64() time.
+     *  @return \bfalse if the event queue is full, the event is dropped and must be posted again later.
+     */
+    Bool PostKeyEvent( Keyboard::Key pKey, Bool pDown, UInt64 pTime );
+
+    /**
+     *  Post a mouse button event, it will be applied by the next FireEvents().
+     *  @param  pButton The button that changed.
+     *  @param  pDown   \btrue if the button went down, \bfalse if it went up.
+     *  @param  pTime   When the button changed, in SystemInfo::GetMicroSec64() time.
+     *  @return \bfalse if the event queue is full, the event is dropped and must be posted again later.
+     */
+    Bool PostMouseButtonEvent( Mouse::Button pButton, Bool pDown, UInt64 pTime );
+
+    /**
+     *  Post a mouse movement, movements are summed until the next FireEvents().
+     *  @param  pAxis   The axis that moved.
+     *  @param  pValue  The relative movement.
+     *  @param  pTime   When the mouse moved, in SystemInfo::GetMicroSec64() time.
+     *  @return \bfalse if the event queue is full, the movement is lost.
+     */
+    Bool PostMouseMotionEvent( Mouse::Axis pAxis, Int32 pValue, UInt64 pTime );
+
+    /**
+     *  Apply the posted events, then fire events (notify the device listeners
+     *  of the changes to theses devices).
+     */
     void FireEvents();
 
+private:
+    //! Apply the posted events to the devices.
+    void ApplyEvents();
+
+    //! Apply an event, return \bfalse if it must wait for the next frame.
+    Bool ApplyEvent( const InputEvent& pEvent );
+
 protected:
     //! Constructor.
     InputSubsystem();
@@ -119,6 +173,12 @@ protected:
     Mouse                   mMouse;             //!< Mouse device.
     Keyboard                mKeyboard;          //!< Keyboard device.
     Vector<InputDevice*>    mOtherDevices;      //!< List of other possible devices.
+
+private:
+    InputEventQueue         mEventQueue;        //!< Events posted by the input thread.
+    Vector<InputEvent>      mDeferredEvents;    //!< Events that changed a key or a button already changed in their frame.
+    UInt64                  mAverageLatency;
+    UInt64                  mMaxLatency;
 };
 
 
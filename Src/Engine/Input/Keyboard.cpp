@@ -28,6 +28,8 @@
 #include "Engine.h"
 #include "Keyboard.h"
 
+#include <algorithm>
+
 
 namespace Gamedesk {
 	
@@ -35,9 +37,10 @@ namespace Gamedesk {
 IMPLEMENT_CLASS(Keyboard);
 
 
-Keyboard::Keyboard()
+Keyboard::Keyboard() : mFrame(1)
 {
     memset( mKeysStates, Key_Up, sizeof(KeyState)*Key_NumKeys );
+    memset( mKeysFrames, 0, sizeof(mKeysFrames) );
 }
 
 Keyboard::KeyState Keyboard::GetKeyState( const Keyboard::Key& pKey ) const
@@ -90,6 +93,9 @@ void Keyboard::AddKeyListener( Keyboard::Listener* pListener, const Key& pKey )
 
 void Keyboard::AddKeyListener( Keyboard::Listener* pListener, const Key& pKey, const KeyState& pState )
 {
+    if( pState == Key_Up && mKeysListeners[pKey][pState].empty() )
+        mUpListenedKeys.push_back( pKey );
+
     mKeysListeners[pKey][pState].push_back( pListener );
 }
 
@@ -103,53 +109,98 @@ void Keyboard::RemoveKeyListener( Keyboard::Listener* pListener, const Key& pKey
 
 void Keyboard::RemoveKeyListener( Keyboard::Listener* pListener, const Key& pKey, const KeyState& pState )
 {
-    mKeysListeners[pKey][pState].remove( pListener );
+    Vector<Listener*>& listeners = mKeysListeners[pKey][pState];
+    listeners.erase( std::remove( listeners.begin(), listeners.end(), pListener ), listeners.end() );
+
+    if( pState == Key_Up && listeners.empty() )
+        mUpListenedKeys.erase( std::remove( mUpListenedKeys.begin(), mUpListenedKeys.end(), pKey ), mUpListenedKeys.end() );
 }
 
-void Keyboard::FireEvents()
+void Keyboard::SetKeyState( Key pKey, KeyState pState )
 {
-    std::list<Listener*>::const_iterator     itList;
-    std::list<Listener*>::const_iterator     itListEnd;
-    Key                                      key;
-    KeyState                                 keyState;
+    KeyState oldState = mKeysStates[pKey];
+    if( oldState == pState )
+        return;
+
+    if( oldState == Key_Up )
+        mActiveKeys.push_back( pKey );
+    else if( pState == Key_Up )
+        mActiveKeys.erase( std::find( mActiveKeys.begin(), mActiveKeys.end(), pKey ) );
+
+    mKeysStates[pKey] = pState;
+    mKeysFrames[pKey] = mFrame;
+}
+
+Bool Keyboard::HasChanged( Key pKey ) const
+{
+    return mKeysFrames[pKey] == mFrame;
+}
+
+void Keyboard::AdvanceStates()
+{
+    for( Int32 i = (Int32)mActiveKeys.size() - 1; i >= 0; i-- )
+    {
+        Key key = mActiveKeys[i];
+        if( HasChanged( key ) )
+            continue;
 
-    // For each key.
-    for( UInt32 iKey = 0; iKey < Key_NumKeys; iKey++ )
+        if( mKeysStates[key] == Key_Pressed )
+        {
+            mKeysStates[key] = Key_Down;
+        }
+        else if( mKeysStates[key] == Key_Released )
+        {
+            mKeysStates[key] = Key_Up;
+            mActiveKeys[i] = mActiveKeys.back();
+            mActiveKeys.pop_back();
+        }
+    }
+}
+
+void Keyboard::FireEvents()
+{
+    // Up keys, only those somebody listens to.
+    for( UInt32 iKey = 0; iKey < mUpListenedKeys.size(); iKey++ )
     {
-        // Get the state of the current key.   
-        key      = (Key)iKey;
-        keyState = mKeysStates[key];
+        Key key = mUpListenedKeys[iKey];
+        if( mKeysStates[key] != Key_Up )
+            continue;
 
-        // Get an iterator to the beginning and end of the list.
-        itList    = mKeysListeners[key][keyState].begin();
-        itListEnd = mKeysListeners[key][keyState].end();
+        const Vector<Listener*>& listeners = mKeysListeners[key][Key_Up];
+        for( UInt32 i = 0; i < listeners.size(); i++ )
+            listeners[i]->OnKeyUp( key );
+    }
+
+    // Pressed, down and released keys.
+    for( UInt32 iKey = 0; iKey < mActiveKeys.size(); iKey++ )
+    {
+        Key                         key       = mActiveKeys[iKey];
+        KeyState                    keyState  = mKeysStates[key];
+        const Vector<Listener*>&    listeners = mKeysListeners[key][keyState];
 
         switch( keyState )
         {
-        case Key_Up:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnKeyUp( key );
-            break;
-
         case Key_Pressed:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnKeyPressed( key );
+            for( UInt32 i = 0; i < listeners.size(); i++ )
+                listeners[i]->OnKeyPressed( key );
             break;
 
         case Key_Down:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnKeyDown( key );
+            for( UInt32 i = 0; i < listeners.size(); i++ )
+                listeners[i]->OnKeyDown( key );
             break;
 
         case Key_Released:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnKeyReleased( key );
+            for( UInt32 i = 0; i < listeners.size(); i++ )
+                listeners[i]->OnKeyReleased( key );
             break;
 
 		default:
 			break;
         }        
     }
+
+    mFrame++;
 }
 
 void Keyboard::Listener::OnKeyUp        ( const Keyboard::Key& /*pKey*/ ) {}
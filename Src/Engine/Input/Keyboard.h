@@ -252,14 +252,31 @@ private:
     //! Private constructor.  Only the InputSubsystem is allowed to create a Keyboard object.
     Keyboard();
 
-    //! Fire events (notify listeners of the changes in the mouse state).
+    //! Change the state of a key.
+    void SetKeyState( Key pKey, KeyState pState );
+
+    //! Return \btrue if the state of the given key already changed since the last FireEvents().
+    Bool HasChanged( Key pKey ) const;
+
+    //! Pressed keys become down and released keys become up, unless they changed since the last FireEvents().
+    void AdvanceStates();
+
+    /**
+     *  Fire events (notify listeners of the changes in the keyboard state).
+     *  Only the keys that are not up are visited, and the up keys that have Key_Up listeners.
+     */
     void FireEvents();
 
 private:
     KeyState                    mKeysStates[Key_NumKeys];                       //!< State of each key.
+    UInt32                      mKeysFrames[Key_NumKeys];                       //!< Frame of the last change of each key.
+    UInt32                      mFrame;                                         //!< Incremented by each FireEvents().
+
+    Vector<Key>                 mActiveKeys;                                    //!< Keys that are not up.
+    Vector<Key>                 mUpListenedKeys;                                //!< Keys with Key_Up listeners.
 
     //! Key listeners list for each key possible state.
-    std::list<Listener*>        mKeysListeners[Key_NumKeys][Key_NumStates];     
+    Vector<Listener*>           mKeysListeners[Key_NumKeys][Key_NumStates];     
 };
 
 
@@ -28,6 +28,8 @@
 #include "Engine.h"
 #include "Mouse.h"
 
+#include <algorithm>
+
 
 namespace Gamedesk {
 	
@@ -35,9 +37,10 @@ namespace Gamedesk {
 IMPLEMENT_CLASS(Mouse);
 
 
-Mouse::Mouse()
+Mouse::Mouse() : mAxisFrame(0), mFrame(1)
 {
     memset( mButtonsStates, Button_Up, sizeof(mButtonsStates) );
+    memset( mButtonsFrames, 0, sizeof(mButtonsFrames) );
     memset( mAxis, 0, sizeof(mAxis) );
 }
 
@@ -105,7 +108,7 @@ void Mouse::AddMoveListener( Mouse::Listener* pListener )
 
 void Mouse::RemoveMoveListener( Mouse::Listener* pListener )
 {
-    mMoveListeners.remove( pListener );
+    mMoveListeners.erase( std::remove( mMoveListeners.begin(), mMoveListeners.end(), pListener ), mMoveListeners.end() );
 }
 
 // Mouse button listeners management.
@@ -119,6 +122,9 @@ void Mouse::AddButtonListener( Mouse::Listener* pListener, const Mouse::Button&
 
 void Mouse::AddButtonListener( Mouse::Listener* pListener, const Mouse::Button& pButton, const Mouse::ButtonState& pState )
 {
+    if( pState == Button_Up && mButtonsListeners[pButton][pState].empty() )
+        mUpListenedButtons.push_back( pButton );
+
     mButtonsListeners[pButton][pState].push_back( pListener );
 }
 
@@ -132,47 +138,105 @@ void Mouse::RemoveButtonListener( Mouse::Listener* pListener, const Mouse::Butto
 
 void Mouse::RemoveButtonListener( Mouse::Listener* pListener, const Mouse::Button& pButton, const Mouse::ButtonState& pState )
 {
-    mButtonsListeners[pButton][pState].remove( pListener );
+    Vector<Listener*>& listeners = mButtonsListeners[pButton][pState];
+    listeners.erase( std::remove( listeners.begin(), listeners.end(), pListener ), listeners.end() );
+
+    if( pState == Button_Up && listeners.empty() )
+        mUpListenedButtons.erase( std::remove( mUpListenedButtons.begin(), mUpListenedButtons.end(), pButton ), mUpListenedButtons.end() );
 }
 
-void Mouse::FireEvents()
+void Mouse::SetButtonState( Button pButton, ButtonState pState )
 {
-    std::list<Listener*>::const_iterator     itList;
-    std::list<Listener*>::const_iterator     itListEnd;
-    Button                                   button;
-    ButtonState                              buttonState;
+    ButtonState oldState = mButtonsStates[pButton];
+    if( oldState == pState )
+        return;
+
+    if( oldState == Button_Up )
+        mActiveButtons.push_back( pButton );
+    else if( pState == Button_Up )
+        mActiveButtons.erase( std::find( mActiveButtons.begin(), mActiveButtons.end(), pButton ) );
 
-    // For each button.
-    for( UInt32 iButton = 0; iButton < Button_NumButtons; iButton++ )
+    mButtonsStates[pButton] = pState;
+    mButtonsFrames[pButton] = mFrame;
+}
+
+Bool Mouse::HasChanged( Button pButton ) const
+{
+    return mButtonsFrames[pButton] == mFrame;
+}
+
+void Mouse::SetAxis( Axis pAxis, Int32 pValue )
+{
+    mAxis[pAxis] = pValue;
+    mAxisFrame = mFrame;
+}
+
+void Mouse::AddMotion( Axis pAxis, Int32 pValue )
+{
+    mAxis[pAxis] += pValue;
+    mAxisFrame = mFrame;
+}
+
+void Mouse::AdvanceStates()
+{
+    for( Int32 i = (Int32)mActiveButtons.size() - 1; i >= 0; i-- )
     {
-        // Get the state of the current button.   
-        button      = (Button)iButton;
-        buttonState = mButtonsStates[button];
+        Button button = mActiveButtons[i];
+        if( HasChanged( button ) )
+            continue;
 
-        // Get an iterator to the beginning and end of the list.
-        itList    = mButtonsListeners[button][buttonState].begin();
-        itListEnd = mButtonsListeners[button][buttonState].end();
+        if( mButtonsStates[button] == Button_Pressed )
+        {
+            mButtonsStates[button] = Button_Down;
+        }
+        else if( mButtonsStates[button] == Button_Released )
+        {
+            mButtonsStates[button] = Button_Up;
+            mActiveButtons[i] = mActiveButtons.back();
+            mActiveButtons.pop_back();
+        }
+    }
+
+    if( mAxisFrame != mFrame )
+        memset( mAxis, 0, sizeof(mAxis) );
+}
+
+void Mouse::FireEvents()
+{
+    // Up buttons, only those somebody listens to.
+    for( UInt32 iButton = 0; iButton < mUpListenedButtons.size(); iButton++ )
+    {
+        Button button = mUpListenedButtons[iButton];
+        if( mButtonsStates[button] != Button_Up )
+            continue;
+
+        const Vector<Listener*>& listeners = mButtonsListeners[button][Button_Up];
+        for( UInt32 i = 0; i < listeners.size(); i++ )
+            listeners[i]->OnMouseButtonUp( button );
+    }
+
+    // Pressed, down and released buttons.
+    for( UInt32 iButton = 0; iButton < mActiveButtons.size(); iButton++ )
+    {
+        Button                      button      = mActiveButtons[iButton];
+        ButtonState                 buttonState = mButtonsStates[button];
+        const Vector<Listener*>&    listeners   = mButtonsListeners[button][buttonState];
 
         switch( buttonState )
         {
-        case Button_Up:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnMouseButtonUp( button );
-            break;
-
         case Button_Pressed:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnMouseButtonPressed( button );
+            for( UInt32 i = 0; i < listeners.size(); i++ )
+                listeners[i]->OnMouseButtonPressed( button );
             break;
 
         case Button_Down:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnMouseButtonDown( button );
+            for( UInt32 i = 0; i < listeners.size(); i++ )
+                listeners[i]->OnMouseButtonDown( button );
             break;
 
         case Button_Released:
-            for( ; itList != itListEnd; ++itList )
-                (*itList)->OnMouseButtonReleased( button );
+            for( UInt32 i = 0; i < listeners.size(); i++ )
+                listeners[i]->OnMouseButtonReleased( button );
             break;
 
 		default:
@@ -183,9 +247,11 @@ void Mouse::FireEvents()
     // If axis X or Y changed, fire OnMove
     if( mAxis[Axis_X] != 0 || mAxis[Axis_Y] != 0 )
     {
-        for( std::list<Listener*>::const_iterator itList = mMoveListeners.begin(); itList != mMoveListeners.end(); ++itList )
-            (*itList)->OnMouseMove( mAxis[Axis_X], mAxis[Axis_Y] );
+        for( UInt32 i = 0; i < mMoveListeners.size(); i++ )
+            mMoveListeners[i]->OnMouseMove( mAxis[Axis_X], mAxis[Axis_Y] );
     }
+
+    mFrame++;
 }
 
 void Mouse::Listener::OnMouseMove            ( Int32 /*pRelX*/, Int32 /*pRelY*/ ) {}
@@ -181,18 +181,45 @@ private:
     //! Private constructor.  Only the InputSubsystem is allowed to create a Mouse object.
     Mouse();
 
-    //! Fire events (notify listeners of the changes in the mouse state).
+    //! Change the state of a button.
+    void SetButtonState( Button pButton, ButtonState pState );
+
+    //! Return \btrue if the state of the given button already changed since the last FireEvents().
+    Bool HasChanged( Button pButton ) const;
+
+    //! Change the relative position of an axis.
+    void SetAxis( Axis pAxis, Int32 pValue );
+
+    //! Add a relative movement to an axis.
+    void AddMotion( Axis pAxis, Int32 pValue );
+
+    /**
+     *  Pressed buttons become down and released buttons become up, axis are reset,
+     *  unless they changed since the last FireEvents().
+     */
+    void AdvanceStates();
+
+    /**
+     *  Fire events (notify listeners of the changes in the mouse state).
+     *  Only the buttons that are not up are visited, and the up buttons that have Button_Up listeners.
+     */
     void FireEvents();
 
 private:
     ButtonState             mButtonsStates[Button_NumButtons];          //!< State of each button.
+    UInt32                  mButtonsFrames[Button_NumButtons];          //!< Frame of the last change of each button.
     Int32                   mAxis[Axis_NumAxis];                        //!< Relative changes in position of each axis.
+    UInt32                  mAxisFrame;                                 //!< Frame of the last change of the axis.
     Vector2i                mPosition;                                  //!< Current mouse position.
+    UInt32                  mFrame;                                     //!< Incremented by each FireEvents().
+
+    Vector<Button>          mActiveButtons;                             //!< Buttons that are not up.
+    Vector<Button>          mUpListenedButtons;                         //!< Buttons with Button_Up listeners.
 
-    std::list<Listener*>    mMoveListeners;                             //! Mouse movement listeners list.
+    Vector<Listener*>       mMoveListeners;                             //! Mouse movement listeners list.
 
     //! Button listeners list for each button possible state.
-    std::list<Listener*>    mButtonsListeners[Button_NumButtons][Button_NumStates];     
+    Vector<Listener*>       mButtonsListeners[Button_NumButtons][Button_NumStates];     
 };
 
 
@@ -0,0 +1,173 @@
+/**
+ *  @file       BitStream.cpp
+ *  @brief      Bit packed writer and reader used by the network packets.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "BitStream.h"
+#include "Maths/Maths.h"
+
+
+namespace Gamedesk {
+
+
+BitWriter::BitWriter( Vector<Byte>& pBuffer )
+    : mBuffer(pBuffer)
+    , mStart((UInt32)pBuffer.size())
+    , mNbBits(0)
+{
+}
+
+void BitWriter::WriteBits( UInt32 pValue, UInt32 pNbBits )
+{
+    GD_ASSERT( pNbBits > 0 && pNbBits <= 32 );
+
+    if( pNbBits < 32 )
+        pValue &= (1u << pNbBits) - 1;
+
+    mBuffer.resize( mStart + (mNbBits + pNbBits + 7) / 8, 0 );
+
+    while( pNbBits > 0 )
+    {
+        UInt32 bitOffset = mNbBits & 7;
+        UInt32 nbBits    = Maths::Min( 8 - bitOffset, pNbBits );
+
+        mBuffer[mStart + mNbBits / 8] |= (Byte)((pValue & ((1u << nbBits) - 1)) << bitOffset);
+
+        pValue  >>= nbBits;
+        pNbBits -= nbBits;
+        mNbBits += nbBits;
+    }
+}
+
+void BitWriter::WriteVarUInt32( UInt32 pValue )
+{
+    while( pValue >= 0x80 )
+    {
+        WriteBits( (pValue & 0x7F) | 0x80, 8 );
+        pValue >>= 7;
+    }
+
+    WriteBits( pValue, 8 );
+}
+
+void BitWriter::WriteBytes( const Byte* pData, UInt32 pSize )
+{
+    for( UInt32 i = 0; i < pSize; i++ )
+        WriteBits( pData[i], 8 );
+}
+
+void BitWriter::WriteString( const String& pString )
+{
+    WriteVarUInt32( (UInt32)pString.size() );
+    WriteBytes( (const Byte*)pString.c_str(), (UInt32)pString.size() );
+}
+
+void BitWriter::WriteBitArray( const Byte* pData, UInt32 pNbBits )
+{
+    UInt32 nbBytes = pNbBits / 8;
+    for( UInt32 i = 0; i < nbBytes; i++ )
+        WriteBits( pData[i], 8 );
+
+    if( pNbBits & 7 )
+        WriteBits( pData[nbBytes], pNbBits & 7 );
+}
+
+
+BitReader::BitReader( const Byte* pData, UInt32 pSize )
+    : mData(pData)
+    , mSize(pSize)
+    , mBitPos(0)
+    , mOverflow(false)
+{
+}
+
+UInt32 BitReader::ReadBits( UInt32 pNbBits )
+{
+    GD_ASSERT( pNbBits > 0 && pNbBits <= 32 );
+
+    if( mOverflow || mBitPos + pNbBits > mSize * 8 )
+    {
+        mOverflow = true;
+        return 0;
+    }
+
+    UInt32 value = 0;
+    UInt32 shift = 0;
+
+    while( pNbBits > 0 )
+    {
+        UInt32 bitOffset = mBitPos & 7;
+        UInt32 nbBits    = Maths::Min( 8 - bitOffset, pNbBits );
+
+        value |= ((mData[mBitPos / 8] >> bitOffset) & ((1u << nbBits) - 1)) << shift;
+
+        shift   += nbBits;
+        pNbBits -= nbBits;
+        mBitPos += nbBits;
+    }
+
+    return value;
+}
+
+UInt32 BitReader::ReadVarUInt32()
+{
+    UInt32 value = 0;
+
+    for( UInt32 shift = 0; shift < 35; shift += 7 )
+    {
+        UInt32 group = ReadBits( 8 );
+        value |= (group & 0x7F) << shift;
+
+        if( (group & 0x80) == 0 )
+            return value;
+    }
+
+    // More than 5 groups, corrupted data.
+    mOverflow = true;
+    return 0;
+}
+
+void BitReader::ReadBytes( Byte* pData, UInt32 pSize )
+{
+    for( UInt32 i = 0; i < pSize; i++ )
+        pData[i] = (Byte)ReadBits( 8 );
+}
+
+void BitReader::ReadString( String& pString, UInt32 pMaxLength )
+{
+    UInt32 length = ReadVarUInt32();
+    if( length > pMaxLength || length * 8 > GetNbBitsLeft() )
+    {
+        mOverflow = true;
+        pString.clear();
+        return;
+    }
+
+    pString.resize( length );
+    for( UInt32 i = 0; i < length; i++ )
+        pString[i] = (Char)ReadBits( 8 );
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,135 @@
+/**
+ *  @file       BitStream.h
+ *  @brief      Bit packed writer and reader used by the network packets.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _BIT_STREAM_H_
+#define     _BIT_STREAM_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Append values to a byte buffer using only the number of bits they need.
+ *  Bits are packed from the least significant bit of each byte.
+ */
+class ENGINE_API BitWriter
+{
+public:
+    //! Write at the end of pBuffer, it must stay valid while the writer is used.
+    BitWriter( Vector<Byte>& pBuffer );
+
+    //! Write the pNbBits low bits of pValue (1 to 32 bits).
+    void WriteBits( UInt32 pValue, UInt32 pNbBits );
+
+    void WriteBool( Bool pValue )
+    {
+        WriteBits( pValue ? 1 : 0, 1 );
+    }
+
+    void WriteFloat( Float pValue )
+    {
+        WriteBits( *(UInt32*)&pValue, 32 );
+    }
+
+    //! Write an integer in groups of 7 bits, small values take 8 bits.
+    void WriteVarUInt32( UInt32 pValue );
+
+    //! Write pSize bytes.
+    void WriteBytes( const Byte* pData, UInt32 pSize );
+
+    //! Write a string, prefixed by its length.
+    void WriteString( const String& pString );
+
+    //! Write the first pNbBits bits of pData, written by another BitWriter.
+    void WriteBitArray( const Byte* pData, UInt32 pNbBits );
+
+    //! Number of bits written since the creation of the writer.
+    UInt32 GetNbBits() const
+    {
+        return mNbBits;
+    }
+
+private:
+    Vector<Byte>&   mBuffer;
+    UInt32          mStart;     //!< Size of the buffer when the writer was created.
+    UInt32          mNbBits;
+};
+
+
+/**
+ *  Read values written by a BitWriter. The data comes from the network so
+ *  reading past the end is not an error: it returns zeros and sets the
+ *  overflow flag, to be checked once the whole packet has been read.
+ */
+class ENGINE_API BitReader
+{
+public:
+    BitReader( const Byte* pData, UInt32 pSize );
+
+    //! Read pNbBits bits (1 to 32 bits).
+    UInt32 ReadBits( UInt32 pNbBits );
+
+    Bool ReadBool()
+    {
+        return ReadBits( 1 ) != 0;
+    }
+
+    Float ReadFloat()
+    {
+        UInt32 value = ReadBits( 32 );
+        return *(Float*)&value;
+    }
+
+    UInt32 ReadVarUInt32();
+
+    void ReadBytes( Byte* pData, UInt32 pSize );
+
+    //! Read a string, fails (overflow) if it is longer than pMaxLength.
+    void ReadString( String& pString, UInt32 pMaxLength = 256 );
+
+    //! Return \c true if the reader went past the end of the data.
+    Bool IsOverflow() const
+    {
+        return mOverflow;
+    }
+
+    //! Number of bits left to read.
+    UInt32 GetNbBitsLeft() const
+    {
+        return mOverflow ? 0 : mSize * 8 - mBitPos;
+    }
+
+private:
+    const Byte*     mData;
+    UInt32          mSize;
+    UInt32          mBitPos;
+    Bool            mOverflow;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _BIT_STREAM_H_
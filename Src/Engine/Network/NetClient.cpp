@@ -0,0 +1,343 @@
+/**
+ *  @file       NetClient.cpp
+ *  @brief      Client side of the network game: connection and replicated objects.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "NetClient.h"
+#include "BitStream.h"
+#include "Maths/Maths.h"
+
+
+namespace Gamedesk {
+
+
+const Double NetClient::CONNECT_RETRY_DELAY = 0.5;
+const Double NetClient::TIMEOUT             = 10.0;
+
+
+NetClient::NetClient()
+    : mState(State_Disconnected)
+    , mConnection(NULL)
+    , mListener(NULL)
+    , mSendRate(20)
+    , mTime(0)
+    , mSendAccumulator(0)
+    , mConnectStartTime(0)
+    , mLastConnectTime(0)
+    , mDecodedTick(0)
+{
+}
+
+NetClient::~NetClient()
+{
+    Disconnect();
+}
+
+void NetClient::Connect( const NetAddress& pServer )
+{
+    Disconnect();
+
+    mSocket.Open();
+
+    mServer           = pServer;
+    mState            = State_Connecting;
+    mConnection       = GD_NEW(NetConnection, this, "Engine::Network")( mSocket, pServer );
+    mConnectStartTime = mTime;
+    mLastConnectTime  = mTime;
+    mSendAccumulator  = 0;
+
+    SendControl( NetPacket::Type_Connect );
+}
+
+void NetClient::Disconnect()
+{
+    if( mState == State_Disconnected )
+        return;
+
+    SendControl( NetPacket::Type_Disconnect );
+    Reset();
+}
+
+NetClient::State NetClient::GetState() const
+{
+    return mState;
+}
+
+void NetClient::SetSendRate( Float pPacketsPerSecond )
+{
+    GD_ASSERT( pPacketsPerSecond > 0 );
+    mSendRate = pPacketsPerSecond;
+}
+
+void NetClient::SetListener( NetClientListener* pListener )
+{
+    mListener = pListener;
+}
+
+void NetClient::Update( Double pElapsedTime )
+{
+    mTime += pElapsedTime;
+
+    if( mState == State_Disconnected )
+        return;
+
+    ReceivePackets();
+
+    if( mState == State_Connecting )
+    {
+        if( mTime - mConnectStartTime > TIMEOUT )
+        {
+            Reset();
+        }
+        else if( mTime - mLastConnectTime >= CONNECT_RETRY_DELAY )
+        {
+            mLastConnectTime = mTime;
+            SendControl( NetPacket::Type_Connect );
+        }
+    }
+    else if( mState == State_Connected )
+    {
+        if( mTime - Maths::Max( mConnectStartTime, mConnection->GetLastReceiveTime() ) > TIMEOUT )
+        {
+            Reset();
+            return;
+        }
+
+        Double period = 1.0 / mSendRate;
+        mSendAccumulator += pElapsedTime;
+        if( mSendAccumulator >= period )
+        {
+            mSendAccumulator = Maths::Min( mSendAccumulator - period, period );
+            SendPacket();
+        }
+    }
+}
+
+NetConnection* NetClient::GetConnection() const
+{
+    return mConnection;
+}
+
+Object* NetClient::GetObject( UInt32 pNetId ) const
+{
+    Map<UInt32, Object*>::const_iterator itObject = mObjects.find( pNetId );
+    return itObject != mObjects.end() ? itObject->second : NULL;
+}
+
+UInt32 NetClient::GetNbObjects() const
+{
+    return (UInt32)mObjects.size();
+}
+
+UInt32 NetClient::GetSnapshotTick() const
+{
+    return mApplied.GetTick();
+}
+
+void NetClient::ReceivePackets()
+{
+    Byte       datagram[NetPacket::MAX_DATAGRAM_SIZE];
+    NetAddress address;
+    UInt32     size;
+
+    while( mState != State_Disconnected && (size = mSocket.Receive( address, datagram, sizeof(datagram) )) != 0 )
+    {
+        if( address == mServer )
+            HandleDatagram( datagram, size );
+    }
+}
+
+void NetClient::HandleDatagram( const Byte* pDatagram, UInt32 pSize )
+{
+    NetPacket::Type type;
+    if( !NetPacket::ReadHeader( pDatagram, pSize, type ) )
+        return;
+
+    switch( type )
+    {
+    case NetPacket::Type_Accept:
+        if( mState == State_Connecting )
+            mState = State_Connected;
+        break;
+
+    case NetPacket::Type_Reject:
+        if( mState == State_Connecting )
+            Reset();
+        break;
+
+    case NetPacket::Type_Disconnect:
+        Reset();
+        break;
+
+    case NetPacket::Type_Data:
+        {
+            // The accept was lost, but the server sends us snapshots.
+            if( mState == State_Connecting )
+                mState = State_Connected;
+
+            if( !mConnection->ReceiveDatagram( pDatagram, pSize, mTime, mReceivedPacket ) )
+                break;
+
+            BitReader reader( mReceivedPacket.empty() ? NULL : &mReceivedPacket[0], (UInt32)mReceivedPacket.size() );
+            if( mConnection->ReadPacket( reader, mTime ) )
+                ReadSnapshot( reader );
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void NetClient::ReadSnapshot( BitReader& pReader )
+{
+    if( !pReader.ReadBool() )
+        return;
+
+    UInt32 tick = pReader.ReadBits( 32 );
+    UInt32 age  = pReader.ReadBits( 5 );
+    if( pReader.IsOverflow() || tick == 0 || age >= tick )
+        return;
+
+    NetSnapshot& snapshot = mSnapshots[tick % SNAPSHOT_HISTORY];
+    if( snapshot.GetTick() == tick )
+        return;
+
+    // The baseline must be one of ours, else we can't decode the delta.
+    const NetSnapshot* baseline = NULL;
+    if( age != 0 )
+    {
+        baseline = &mSnapshots[(tick - age) % SNAPSHOT_HISTORY];
+        if( baseline->GetTick() != tick - age )
+            return;
+    }
+
+    if( !NetSnapshot::ReadDelta( pReader, baseline, snapshot ) )
+    {
+        snapshot.Clear();
+        return;
+    }
+
+    snapshot.SetTick( tick );
+
+    if( tick > mDecodedTick )
+    {
+        mDecodedTick = tick;
+        ApplySnapshot( snapshot );
+    }
+}
+
+void NetClient::ApplySnapshot( const NetSnapshot& pSnapshot )
+{
+    UInt32 nbOld = mApplied.GetNbEntries();
+    UInt32 nbNew = pSnapshot.GetNbEntries();
+    UInt32 iOld  = 0;
+    UInt32 iNew  = 0;
+
+    while( iOld < nbOld || iNew < nbNew )
+    {
+        const NetSnapshot::Entry* oldEntry = iOld < nbOld ? &mApplied.GetEntry( iOld ) : NULL;
+        const NetSnapshot::Entry* newEntry = iNew < nbNew ? &pSnapshot.GetEntry( iNew ) : NULL;
+
+        if( newEntry && (!oldEntry || newEntry->mNetId < oldEntry->mNetId) )
+        {
+            // Name the object after its net id, generating a unique name scans every object.
+            Object* object = newEntry->mLayout->GetClass()->AllocateNew( String("NetObject_") + ToString(newEntry->mNetId) );
+            newEntry->mLayout->ApplyState( pSnapshot.GetState( iNew ), object );
+            mObjects[newEntry->mNetId] = object;
+
+            if( mListener )
+                mListener->OnObjectCreated( newEntry->mNetId, object );
+
+            iNew++;
+        }
+        else if( oldEntry && (!newEntry || oldEntry->mNetId < newEntry->mNetId) )
+        {
+            Map<UInt32, Object*>::iterator itObject = mObjects.find( oldEntry->mNetId );
+            if( mListener )
+                mListener->OnObjectDestroyed( itObject->first, itObject->second );
+
+            GD_DELETE(itObject->second);
+            mObjects.erase( itObject );
+
+            iOld++;
+        }
+        else
+        {
+            const Byte* state = pSnapshot.GetState( iNew );
+            if( memcmp( mApplied.GetState( iOld ), state, newEntry->mLayout->GetStateSize() ) != 0 )
+                newEntry->mLayout->ApplyState( state, mObjects[newEntry->mNetId] );
+
+            iOld++;
+            iNew++;
+        }
+    }
+
+    mApplied = pSnapshot;
+}
+
+void NetClient::SendPacket()
+{
+    mPacket.clear();
+    BitWriter writer( mPacket );
+
+    mConnection->WritePacket( writer, mTime );
+    writer.WriteBits( mDecodedTick, 32 );
+
+    mConnection->SendPacket( mPacket );
+}
+
+void NetClient::SendControl( NetPacket::Type pType )
+{
+    Byte datagram[NetPacket::HEADER_SIZE];
+    NetPacket::WriteHeader( datagram, pType );
+    mSocket.Send( mServer, datagram, sizeof(datagram) );
+}
+
+void NetClient::Reset()
+{
+    for( Map<UInt32, Object*>::iterator itObject = mObjects.begin(); itObject != mObjects.end(); ++itObject )
+    {
+        if( mListener )
+            mListener->OnObjectDestroyed( itObject->first, itObject->second );
+
+        GD_DELETE(itObject->second);
+    }
+    mObjects.clear();
+
+    for( UInt32 i = 0; i < SNAPSHOT_HISTORY; i++ )
+        mSnapshots[i].Clear();
+
+    mApplied.Clear();
+    mDecodedTick = 0;
+
+    GD_DELETE(mConnection);
+    mConnection = NULL;
+
+    mSocket.Close();
+    mState = State_Disconnected;
+}
+
+
+} // namespace Gamedesk
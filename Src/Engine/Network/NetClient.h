@@ -0,0 +1,145 @@
+/**
+ *  @file       NetClient.h
+ *  @brief      Client side of the network game: connection and replicated objects.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _NET_CLIENT_H_
+#define     _NET_CLIENT_H_
+
+
+#include "UdpSocket.h"
+#include "NetConnection.h"
+#include "NetReplication.h"
+
+
+namespace Gamedesk {
+
+
+//! Notified when a NetClient creates or deletes a replicated object.
+class ENGINE_API NetClientListener
+{
+public:
+    virtual ~NetClientListener() {}
+
+    //! Called once the object has its replicated state.
+    virtual void OnObjectCreated( UInt32 pNetId, Object* pObject ) = 0;
+    //! Called before the object is deleted.
+    virtual void OnObjectDestroyed( UInt32 pNetId, Object* pObject ) = 0;
+};
+
+
+/**
+ *  Connect to a NetServer and keep a copy of its replicated objects.
+ *
+ *  Objects are created from the class name sent by the server and deleted
+ *  when the server stops replicating them or the client disconnects.
+ *  Snapshots older than the last one applied are kept as baselines but not
+ *  applied.
+ */
+class ENGINE_API NetClient
+{
+public:
+    static const UInt32 SNAPSHOT_HISTORY    = 32;
+    static const Double CONNECT_RETRY_DELAY;
+    static const Double TIMEOUT;
+
+    enum State
+    {
+        State_Disconnected,
+        State_Connecting,
+        State_Connected
+    };
+
+public:
+    NetClient();
+    ~NetClient();
+
+    /**
+     *  Start connecting to a server, GetState() tells when it's done.
+     *  @exception NetworkException when the socket can't be opened.
+     */
+    void Connect( const NetAddress& pServer );
+
+    //! Tell the server we're leaving and delete the replicated objects.
+    void Disconnect();
+
+    State GetState() const;
+
+    //! Number of packets sent per second once connected (20 by default).
+    void SetSendRate( Float pPacketsPerSecond );
+
+    void SetListener( NetClientListener* pListener );
+
+    /**
+     *  Receive the server packets and send ours.
+     *  @param  pElapsedTime    Time since the last update, in seconds.
+     */
+    void Update( Double pElapsedTime );
+
+    //! Connection to the server, NULL when disconnected.
+    NetConnection* GetConnection() const;
+
+    //! Replicated object with net id pNetId, NULL if there's none.
+    Object* GetObject( UInt32 pNetId ) const;
+
+    UInt32 GetNbObjects() const;
+
+    //! Server tick of the last snapshot applied, 0 if none.
+    UInt32 GetSnapshotTick() const;
+
+private:
+    void ReceivePackets();
+    void HandleDatagram( const Byte* pDatagram, UInt32 pSize );
+    void ReadSnapshot( BitReader& pReader );
+    void ApplySnapshot( const NetSnapshot& pSnapshot );
+    void SendPacket();
+    void SendControl( NetPacket::Type pType );
+    void Reset();
+
+private:
+    UdpSocket               mSocket;
+    NetAddress              mServer;
+    State                   mState;
+    NetConnection*          mConnection;
+    NetClientListener*      mListener;
+
+    Float                   mSendRate;
+    Double                  mTime;
+    Double                  mSendAccumulator;
+    Double                  mConnectStartTime;
+    Double                  mLastConnectTime;
+
+    NetSnapshot             mSnapshots[SNAPSHOT_HISTORY];
+    NetSnapshot             mApplied;       //!< Snapshot the objects are in.
+    UInt32                  mDecodedTick;   //!< Last snapshot decoded, acknowledged to the server.
+    Map<UInt32, Object*>    mObjects;
+
+    Vector<Byte>            mPacket;
+    Vector<Byte>            mReceivedPacket;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _NET_CLIENT_H_
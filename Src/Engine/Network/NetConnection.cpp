@@ -0,0 +1,498 @@
+/**
+ *  @file       NetConnection.cpp
+ *  @brief      Sequenced, acknowledged packets with reliable and unreliable messages.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "NetConnection.h"
+#include "BitStream.h"
+#include "Maths/Maths.h"
+
+#include <algorithm>
+
+
+namespace Gamedesk {
+
+
+// Integral constants are initialized in the class, they still need a definition when bound to a reference (ex. Maths::Min).
+const UInt16 NetPacket::PROTOCOL_ID;
+const UInt32 NetPacket::HEADER_SIZE;
+const UInt32 NetPacket::MAX_DATAGRAM_SIZE;
+
+const UInt32 NetConnection::PACKET_HISTORY;
+const UInt32 NetConnection::MAX_FRAGMENTS;
+const UInt32 NetConnection::FRAGMENT_HEADER_SIZE;
+const UInt32 NetConnection::MAX_FRAGMENT_SIZE;
+const UInt32 NetConnection::MAX_PACKET_SIZE;
+const UInt32 NetConnection::MAX_MESSAGE_SIZE;
+const UInt32 NetConnection::MAX_RELIABLE_PER_PACKET;
+const UInt32 NetConnection::MAX_PENDING_RELIABLE;
+const Double NetConnection::RESEND_DELAY = 0.1;
+
+
+void NetPacket::WriteHeader( Byte* pDatagram, Type pType )
+{
+    pDatagram[0] = (Byte)(PROTOCOL_ID & 0xFF);
+    pDatagram[1] = (Byte)(PROTOCOL_ID >> 8);
+    pDatagram[2] = (Byte)pType;
+}
+
+Bool NetPacket::ReadHeader( const Byte* pDatagram, UInt32 pSize, Type& pType )
+{
+    if( pSize < HEADER_SIZE || (pDatagram[0] | (pDatagram[1] << 8)) != PROTOCOL_ID || pDatagram[2] >= Type_Count )
+        return false;
+
+    pType = (Type)pDatagram[2];
+    return true;
+}
+
+
+NetConnection::NetConnection( UdpSocket& pSocket, const NetAddress& pAddress )
+    : mSocket(pSocket)
+    , mAddress(pAddress)
+    , mLocalSequence(0)
+    , mHasAcked(false)
+    , mLastAckedSequence(0)
+    , mNextReliableId(0)
+    , mHasReceived(false)
+    , mRemoteSequence(0)
+    , mReceivedBits(0)
+    , mReceivedSequence(0)
+    , mLastReceiveTime(0)
+    , mNextReceiveId(0)
+    , mHasFragments(false)
+    , mFragmentSequence(0)
+    , mFragmentCount(0)
+    , mFragmentMask(0)
+    , mLastFragmentSize(0)
+    , mRoundTripTime(0)
+    , mNbBytesSent(0)
+    , mNbBytesReceived(0)
+    , mNbPacketsSent(0)
+    , mNbPacketsReceived(0)
+    , mNbPacketsLost(0)
+{
+}
+
+const NetAddress& NetConnection::GetAddress() const
+{
+    return mAddress;
+}
+
+void NetConnection::SendReliable( const Byte* pData, UInt32 pSize )
+{
+    GD_ASSERT_M( pSize <= MAX_MESSAGE_SIZE, "Message too large" );
+
+    mReliableQueue.push_back( ReliableMessage() );
+    ReliableMessage& message = mReliableQueue.back();
+    message.mId = mNextReliableId++;
+    message.mLastSendTime = -1;
+    message.mData.assign( pData, pData + pSize );
+}
+
+void NetConnection::SendUnreliable( const Byte* pData, UInt32 pSize )
+{
+    GD_ASSERT_M( pSize <= MAX_MESSAGE_SIZE, "Message too large" );
+
+    mUnreliableQueue.push_back( Vector<Byte>() );
+    mUnreliableQueue.back().assign( pData, pData + pSize );
+}
+
+Bool NetConnection::ReceiveMessage( Vector<Byte>& pMessage )
+{
+    if( mReceivedMessages.empty() )
+        return false;
+
+    pMessage.swap( mReceivedMessages.front() );
+    mReceivedMessages.pop_front();
+    return true;
+}
+
+UInt16 NetConnection::WritePacket( BitWriter& pWriter, Double pTime )
+{
+    UInt16 sequence = mLocalSequence++;
+
+    SentPacket& sent = mSentPackets[sequence % PACKET_HISTORY];
+    if( sent.mValid && !sent.mAcked )
+        mNbPacketsLost++;
+
+    sent.mSequence = sequence;
+    sent.mValid    = true;
+    sent.mAcked    = false;
+    sent.mTime     = pTime;
+    sent.mReliableIds.clear();
+
+    // Acks
+    pWriter.WriteBits( mRemoteSequence, 16 );
+    pWriter.WriteBits( mHasReceived ? mReceivedBits : 0, 32 );
+    pWriter.WriteBool( mHasReceived );
+
+    // Reliable messages due for a (re)send, oldest first.
+    UInt32 size = 0;
+    List<ReliableMessage>::iterator itMessage;
+    for( itMessage = mReliableQueue.begin(); itMessage != mReliableQueue.end(); ++itMessage )
+    {
+        if( itMessage->mLastSendTime >= 0 && pTime - itMessage->mLastSendTime < RESEND_DELAY )
+            continue;
+
+        if( size + itMessage->mData.size() > MAX_RELIABLE_PER_PACKET )
+            break;
+
+        size += (UInt32)itMessage->mData.size();
+        sent.mReliableIds.push_back( itMessage->mId );
+    }
+
+    pWriter.WriteVarUInt32( (UInt32)sent.mReliableIds.size() );
+    for( itMessage = mReliableQueue.begin(); itMessage != mReliableQueue.end(); ++itMessage )
+    {
+        if( std::find( sent.mReliableIds.begin(), sent.mReliableIds.end(), itMessage->mId ) == sent.mReliableIds.end() )
+            continue;
+
+        itMessage->mLastSendTime = pTime;
+        pWriter.WriteBits( itMessage->mId, 16 );
+        pWriter.WriteVarUInt32( (UInt32)itMessage->mData.size() );
+        if( !itMessage->mData.empty() )
+            pWriter.WriteBytes( &itMessage->mData[0], (UInt32)itMessage->mData.size() );
+    }
+
+    // Unreliable messages
+    pWriter.WriteVarUInt32( (UInt32)mUnreliableQueue.size() );
+    for( UInt32 i = 0; i < mUnreliableQueue.size(); i++ )
+    {
+        pWriter.WriteVarUInt32( (UInt32)mUnreliableQueue[i].size() );
+        if( !mUnreliableQueue[i].empty() )
+            pWriter.WriteBytes( &mUnreliableQueue[i][0], (UInt32)mUnreliableQueue[i].size() );
+    }
+    mUnreliableQueue.clear();
+
+    return sequence;
+}
+
+void NetConnection::SendPacket( const Vector<Byte>& pPacket )
+{
+    GD_ASSERT_M( pPacket.size() <= MAX_PACKET_SIZE, "Packet too large" );
+
+    UInt16 sequence = (UInt16)(mLocalSequence - 1);
+    UInt32 count = Maths::Max<UInt32>( 1, ((UInt32)pPacket.size() + MAX_FRAGMENT_SIZE - 1) / MAX_FRAGMENT_SIZE );
+
+    Byte datagram[NetPacket::MAX_DATAGRAM_SIZE];
+    NetPacket::WriteHeader( datagram, NetPacket::Type_Data );
+    datagram[3] = (Byte)(sequence & 0xFF);
+    datagram[4] = (Byte)(sequence >> 8);
+    datagram[6] = (Byte)count;
+
+    for( UInt32 i = 0; i < count; i++ )
+    {
+        UInt32 offset = i * MAX_FRAGMENT_SIZE;
+        UInt32 size   = Maths::Min<UInt32>( MAX_FRAGMENT_SIZE, (UInt32)pPacket.size() - offset );
+
+        datagram[5] = (Byte)i;
+        if( size > 0 )
+            memcpy( datagram + NetPacket::HEADER_SIZE + FRAGMENT_HEADER_SIZE, &pPacket[offset], size );
+
+        UInt32 datagramSize = NetPacket::HEADER_SIZE + FRAGMENT_HEADER_SIZE + size;
+        mSocket.Send( mAddress, datagram, datagramSize );
+        mNbBytesSent += datagramSize;
+    }
+
+    mNbPacketsSent++;
+}
+
+Bool NetConnection::ReceiveDatagram( const Byte* pDatagram, UInt32 pSize, Double pTime, Vector<Byte>& pPacket )
+{
+    const UInt32 headerSize = NetPacket::HEADER_SIZE + FRAGMENT_HEADER_SIZE;
+    if( pSize < headerSize )
+        return false;
+
+    mNbBytesReceived += pSize;
+
+    UInt16 sequence = (UInt16)(pDatagram[3] | (pDatagram[4] << 8));
+    UInt32 index    = pDatagram[5];
+    UInt32 count    = pDatagram[6];
+    UInt32 size     = pSize - headerSize;
+
+    if( count == 0 || count > MAX_FRAGMENTS || index >= count )
+        return false;
+
+    // Not fragmented.
+    if( count == 1 )
+    {
+        pPacket.assign( pDatagram + headerSize, pDatagram + pSize );
+        mReceivedSequence = sequence;
+        return true;
+    }
+
+    // Only every fragment but the last one can be (and must be) full.
+    if( (index < count - 1 && size != MAX_FRAGMENT_SIZE) || size > MAX_FRAGMENT_SIZE )
+        return false;
+
+    // Only the most recent fragmented packet is reassembled.
+    if( !mHasFragments || IsSequenceMoreRecent( sequence, mFragmentSequence ) )
+    {
+        mHasFragments     = true;
+        mFragmentSequence = sequence;
+        mFragmentCount    = count;
+        mFragmentMask     = 0;
+        mFragmentBuffer.resize( count * MAX_FRAGMENT_SIZE );
+    }
+    else if( sequence != mFragmentSequence || count != mFragmentCount )
+    {
+        return false;
+    }
+
+    UInt64 bit = (UInt64)1 << index;
+    if( mFragmentMask & bit )
+        return false;
+
+    mFragmentMask |= bit;
+    memcpy( &mFragmentBuffer[index * MAX_FRAGMENT_SIZE], pDatagram + headerSize, size );
+    if( index == count - 1 )
+        mLastFragmentSize = size;
+
+    UInt64 complete = count == 64 ? ~(UInt64)0 : (((UInt64)1 << count) - 1);
+    if( mFragmentMask != complete )
+        return false;
+
+    pPacket.assign( mFragmentBuffer.begin(), mFragmentBuffer.begin() + (count - 1) * MAX_FRAGMENT_SIZE + mLastFragmentSize );
+    mReceivedSequence = sequence;
+    mHasFragments = false;
+    return true;
+}
+
+Bool NetConnection::ReadPacket( BitReader& pReader, Double pTime )
+{
+    UInt16 sequence = mReceivedSequence;
+
+    // Duplicates and packets older than the ack window are dropped.
+    if( mHasReceived && !IsSequenceMoreRecent( sequence, mRemoteSequence ) )
+    {
+        UInt16 age = (UInt16)(mRemoteSequence - sequence);
+        if( age == 0 || age > 32 || (mReceivedBits & (1u << (age - 1))) )
+            return false;
+    }
+
+    // Read everything first, a corrupted packet must not be acknowledged.
+    UInt16 ack     = (UInt16)pReader.ReadBits( 16 );
+    UInt32 ackBits = pReader.ReadBits( 32 );
+    Bool   hasAck  = pReader.ReadBool();
+
+    UInt32 nbReliable = pReader.ReadVarUInt32();
+    if( nbReliable > MAX_PENDING_RELIABLE )
+        return false;
+
+    Vector<UInt16>          reliableIds;
+    Vector< Vector<Byte> >  reliableMessages;
+    reliableIds.resize( nbReliable );
+    reliableMessages.resize( nbReliable );
+    for( UInt32 i = 0; i < nbReliable && !pReader.IsOverflow(); i++ )
+    {
+        reliableIds[i] = (UInt16)pReader.ReadBits( 16 );
+        UInt32 size = pReader.ReadVarUInt32();
+        if( size > MAX_MESSAGE_SIZE || size * 8 > pReader.GetNbBitsLeft() )
+            return false;
+
+        reliableMessages[i].resize( size );
+        if( size > 0 )
+            pReader.ReadBytes( &reliableMessages[i][0], size );
+    }
+
+    UInt32 nbUnreliable = pReader.ReadVarUInt32();
+    if( nbUnreliable * 8 > pReader.GetNbBitsLeft() )
+        return false;
+
+    Vector< Vector<Byte> > unreliableMessages;
+    unreliableMessages.resize( nbUnreliable );
+    for( UInt32 i = 0; i < nbUnreliable && !pReader.IsOverflow(); i++ )
+    {
+        UInt32 size = pReader.ReadVarUInt32();
+        if( size > MAX_MESSAGE_SIZE || size * 8 > pReader.GetNbBitsLeft() )
+            return false;
+
+        unreliableMessages[i].resize( size );
+        if( size > 0 )
+            pReader.ReadBytes( &unreliableMessages[i][0], size );
+    }
+
+    if( pReader.IsOverflow() )
+        return false;
+
+    // The packet is valid, acknowledge it.
+    if( !mHasReceived )
+    {
+        mHasReceived    = true;
+        mRemoteSequence = sequence;
+        mReceivedBits   = 0;
+    }
+    else if( IsSequenceMoreRecent( sequence, mRemoteSequence ) )
+    {
+        UInt16 shift = (UInt16)(sequence - mRemoteSequence);
+        if( shift > 32 )
+            mReceivedBits = 0;
+        else
+            mReceivedBits = (shift == 32 ? 0 : mReceivedBits << shift) | (1u << (shift - 1));
+
+        mRemoteSequence = sequence;
+    }
+    else
+    {
+        mReceivedBits |= 1u << ((UInt16)(mRemoteSequence - sequence) - 1);
+    }
+
+    // Reliable messages are delivered in order, once.
+    for( UInt32 i = 0; i < nbReliable; i++ )
+    {
+        UInt16 id = reliableIds[i];
+
+        if( id == mNextReceiveId )
+        {
+            mReceivedMessages.push_back( Vector<Byte>() );
+            mReceivedMessages.back().swap( reliableMessages[i] );
+            mNextReceiveId++;
+
+            // Deliver the messages that were waiting for this one.
+            Map< UInt16, Vector<Byte> >::iterator itEarly;
+            while( (itEarly = mEarlyMessages.find( mNextReceiveId )) != mEarlyMessages.end() )
+            {
+                mReceivedMessages.push_back( Vector<Byte>() );
+                mReceivedMessages.back().swap( itEarly->second );
+                mEarlyMessages.erase( itEarly );
+                mNextReceiveId++;
+            }
+        }
+        else if( IsSequenceMoreRecent( id, mNextReceiveId ) && (UInt16)(id - mNextReceiveId) < MAX_PENDING_RELIABLE )
+        {
+            mEarlyMessages[id].swap( reliableMessages[i] );
+        }
+    }
+
+    for( UInt32 i = 0; i < nbUnreliable; i++ )
+    {
+        mReceivedMessages.push_back( Vector<Byte>() );
+        mReceivedMessages.back().swap( unreliableMessages[i] );
+    }
+
+    if( hasAck )
+    {
+        AckPacket( ack, pTime );
+        for( UInt32 i = 0; i < 32; i++ )
+        {
+            if( ackBits & (1u << i) )
+                AckPacket( (UInt16)(ack - i - 1), pTime );
+        }
+    }
+
+    mLastReceiveTime = pTime;
+    mNbPacketsReceived++;
+    return true;
+}
+
+void NetConnection::AckPacket( UInt16 pSequence, Double pTime )
+{
+    SentPacket& sent = mSentPackets[pSequence % PACKET_HISTORY];
+    if( !sent.mValid || sent.mSequence != pSequence || sent.mAcked )
+        return;
+
+    sent.mAcked = true;
+
+    // Smoothed round trip time.
+    Double rtt = pTime - sent.mTime;
+    mRoundTripTime = mRoundTripTime == 0 ? rtt : mRoundTripTime + (rtt - mRoundTripTime) * 0.1;
+
+    if( !mHasAcked || IsSequenceMoreRecent( pSequence, mLastAckedSequence ) )
+    {
+        mHasAcked = true;
+        mLastAckedSequence = pSequence;
+    }
+
+    // The reliable messages of this packet were received.
+    for( UInt32 i = 0; i < sent.mReliableIds.size(); i++ )
+    {
+        List<ReliableMessage>::iterator itMessage;
+        for( itMessage = mReliableQueue.begin(); itMessage != mReliableQueue.end(); ++itMessage )
+        {
+            if( itMessage->mId == sent.mReliableIds[i] )
+            {
+                mReliableQueue.erase( itMessage );
+                break;
+            }
+        }
+    }
+}
+
+UInt16 NetConnection::GetReceivedSequence() const
+{
+    return mReceivedSequence;
+}
+
+Bool NetConnection::HasAckedPacket() const
+{
+    return mHasAcked;
+}
+
+UInt16 NetConnection::GetLastAckedSequence() const
+{
+    return mLastAckedSequence;
+}
+
+Double NetConnection::GetLastReceiveTime() const
+{
+    return mLastReceiveTime;
+}
+
+Bool NetConnection::IsOverflowed() const
+{
+    return mReliableQueue.size() > MAX_PENDING_RELIABLE;
+}
+
+Double NetConnection::GetRoundTripTime() const
+{
+    return mRoundTripTime;
+}
+
+UInt64 NetConnection::GetNbBytesSent() const
+{
+    return mNbBytesSent;
+}
+
+UInt64 NetConnection::GetNbBytesReceived() const
+{
+    return mNbBytesReceived;
+}
+
+UInt32 NetConnection::GetNbPacketsSent() const
+{
+    return mNbPacketsSent;
+}
+
+UInt32 NetConnection::GetNbPacketsReceived() const
+{
+    return mNbPacketsReceived;
+}
+
+UInt32 NetConnection::GetNbPacketsLost() const
+{
+    return mNbPacketsLost;
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,237 @@
+/**
+ *  @file       NetConnection.h
+ *  @brief      Sequenced, acknowledged packets with reliable and unreliable messages.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _NET_CONNECTION_H_
+#define     _NET_CONNECTION_H_
+
+
+#include "UdpSocket.h"
+
+
+namespace Gamedesk {
+
+
+class BitWriter;
+class BitReader;
+
+
+/**
+ *  Datagram header shared by the NetServer and NetClient.
+ */
+class ENGINE_API NetPacket
+{
+public:
+    static const UInt16 PROTOCOL_ID         = 0x4447;   //!< "GD"
+    static const UInt32 HEADER_SIZE         = 3;        //!< Protocol id and packet type.
+    static const UInt32 MAX_DATAGRAM_SIZE   = 1200;     //!< Stays below the usual MTU.
+
+    enum Type
+    {
+        Type_Connect,       //!< Client -> server, connection request.
+        Type_Accept,        //!< Server -> client, the connection is accepted.
+        Type_Reject,        //!< Server -> client, the server is full.
+        Type_Disconnect,    //!< Both ways.
+        Type_Data,          //!< Both ways, handled by a NetConnection.
+        Type_Count
+    };
+
+    //! Write the datagram header.
+    static void WriteHeader( Byte* pDatagram, Type pType );
+
+    //! Read the datagram header, return \c false if it's not one of our datagrams.
+    static Bool ReadHeader( const Byte* pDatagram, UInt32 pSize, Type& pType );
+};
+
+
+/**
+ *  One end of a connection over a UdpSocket.
+ *
+ *  Every packet has a 16 bit sequence number and acknowledges the last
+ *  packets received from the remote (the latest sequence and a bit for each
+ *  of the 32 before it). Packets larger than a datagram are split in
+ *  fragments and reassembled, a lost fragment loses the whole packet.
+ *
+ *  Messages sent with SendUnreliable() go in the next packet only. Messages
+ *  sent with SendReliable() are repeated every RESEND_DELAY seconds until a
+ *  packet holding them is acknowledged, and are received once, in order.
+ *
+ *  The owner builds each packet: WritePacket() writes the acks and messages,
+ *  the owner appends its own data and calls SendPacket().
+ */
+class ENGINE_API NetConnection
+{
+public:
+    static const UInt32 PACKET_HISTORY          = 256;      //!< Sent packets remembered, to match the acks.
+    static const UInt32 MAX_FRAGMENTS           = 64;
+    static const UInt32 FRAGMENT_HEADER_SIZE    = 4;        //!< Sequence, fragment index and count.
+    static const UInt32 MAX_FRAGMENT_SIZE       = NetPacket::MAX_DATAGRAM_SIZE - NetPacket::HEADER_SIZE - FRAGMENT_HEADER_SIZE;
+    static const UInt32 MAX_PACKET_SIZE         = MAX_FRAGMENTS * MAX_FRAGMENT_SIZE;
+    static const UInt32 MAX_MESSAGE_SIZE        = 1024;
+    static const UInt32 MAX_RELIABLE_PER_PACKET = 4096;     //!< Bytes of reliable messages in a packet.
+    static const UInt32 MAX_PENDING_RELIABLE    = 1024;     //!< Unacknowledged reliable messages before the connection is considered broken.
+    static const Double RESEND_DELAY;
+
+public:
+    NetConnection( UdpSocket& pSocket, const NetAddress& pAddress );
+
+    const NetAddress& GetAddress() const;
+
+    //! Queue a message, it's delivered once and in order.
+    void SendReliable( const Byte* pData, UInt32 pSize );
+
+    //! Queue a message for the next packet only.
+    void SendUnreliable( const Byte* pData, UInt32 pSize );
+
+    //! Pop the next received message, return \c false if there's none.
+    Bool ReceiveMessage( Vector<Byte>& pMessage );
+
+    /**
+     *  Start a new packet: write the acks and the queued messages.
+     *  @param  pWriter     Writer over an empty buffer.
+     *  @param  pTime       Current time, in seconds.
+     *  @return The sequence number of the packet.
+     */
+    UInt16 WritePacket( BitWriter& pWriter, Double pTime );
+
+    //! Send the packet started by WritePacket(), in fragments if needed.
+    void SendPacket( const Vector<Byte>& pPacket );
+
+    /**
+     *  Process a Type_Data datagram from the remote.
+     *  @param  pDatagram   The datagram, header included.
+     *  @param  pSize       Size of the datagram.
+     *  @param  pTime       Current time, in seconds.
+     *  @param  pPacket     Receives the packet when it's complete.
+     *  @return \c true if pPacket holds a complete packet to pass to ReadPacket().
+     */
+    Bool ReceiveDatagram( const Byte* pDatagram, UInt32 pSize, Double pTime, Vector<Byte>& pPacket );
+
+    /**
+     *  Read the acks and messages of the packet returned by ReceiveDatagram(),
+     *  the owner then reads its own data from pReader.
+     *  @return \c false if the packet is a duplicate, too old or corrupted.
+     */
+    Bool ReadPacket( BitReader& pReader, Double pTime );
+
+    //! Sequence of the packet returned by the last ReceiveDatagram().
+    UInt16 GetReceivedSequence() const;
+
+    //! Return \c true if at least one packet was acknowledged.
+    Bool HasAckedPacket() const;
+
+    //! Most recent packet acknowledged by the remote.
+    UInt16 GetLastAckedSequence() const;
+
+    //! Time the last packet was received.
+    Double GetLastReceiveTime() const;
+
+    //! Return \c true if too many reliable messages are waiting for an ack.
+    Bool IsOverflowed() const;
+
+    //! Smoothed round trip time, in seconds.
+    Double GetRoundTripTime() const;
+
+    UInt64 GetNbBytesSent() const;
+    UInt64 GetNbBytesReceived() const;
+    UInt32 GetNbPacketsSent() const;
+    UInt32 GetNbPacketsReceived() const;
+    //! Packets that fell out of the history without being acknowledged.
+    UInt32 GetNbPacketsLost() const;
+
+    //! Return \c true if pFirst is more recent than pSecond, wrapping around.
+    static Bool IsSequenceMoreRecent( UInt16 pFirst, UInt16 pSecond )
+    {
+        return pFirst != pSecond && (UInt16)(pFirst - pSecond) < 0x8000;
+    }
+
+private:
+    void AckPacket( UInt16 pSequence, Double pTime );
+
+private:
+    class SentPacket
+    {
+    public:
+        SentPacket() : mSequence(0), mValid(false), mAcked(false), mTime(0) {}
+
+        UInt16          mSequence;
+        Bool            mValid;
+        Bool            mAcked;
+        Double          mTime;
+        Vector<UInt16>  mReliableIds;   //!< Reliable messages held by the packet.
+    };
+
+    class ReliableMessage
+    {
+    public:
+        UInt16          mId;
+        Double          mLastSendTime;  //!< Negative when never sent.
+        Vector<Byte>    mData;
+    };
+
+    UdpSocket&              mSocket;
+    NetAddress              mAddress;
+
+    // Sending
+    UInt16                  mLocalSequence;
+    SentPacket              mSentPackets[PACKET_HISTORY];
+    Bool                    mHasAcked;
+    UInt16                  mLastAckedSequence;
+
+    List<ReliableMessage>   mReliableQueue;
+    UInt16                  mNextReliableId;
+    Vector< Vector<Byte> >  mUnreliableQueue;
+
+    // Receiving
+    Bool                    mHasReceived;
+    UInt16                  mRemoteSequence;
+    UInt32                  mReceivedBits;      //!< Bit n: remote sequence - n - 1 was received.
+    UInt16                  mReceivedSequence;
+    Double                  mLastReceiveTime;
+
+    UInt16                  mNextReceiveId;
+    Map< UInt16, Vector<Byte> > mEarlyMessages; //!< Reliable messages received before the previous ones.
+    List< Vector<Byte> >    mReceivedMessages;
+
+    Bool                    mHasFragments;
+    UInt16                  mFragmentSequence;
+    UInt32                  mFragmentCount;
+    UInt64                  mFragmentMask;
+    UInt32                  mLastFragmentSize;
+    Vector<Byte>            mFragmentBuffer;
+
+    // Statistics
+    Double                  mRoundTripTime;
+    UInt64                  mNbBytesSent;
+    UInt64                  mNbBytesReceived;
+    UInt32                  mNbPacketsSent;
+    UInt32                  mNbPacketsReceived;
+    UInt32                  mNbPacketsLost;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _NET_CONNECTION_H_
@@ -0,0 +1,426 @@
+/**
+ *  @file       NetReplication.cpp
+ *  @brief      Replicated object states and their delta compression.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "NetReplication.h"
+#include "BitStream.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Owns the layouts, one per replicated class.
+ */
+class NetClassLayoutRegistry
+{
+public:
+    ~NetClassLayoutRegistry()
+    {
+        for( Map<Class*, NetClassLayout*>::iterator itLayout = mLayouts.begin(); itLayout != mLayouts.end(); ++itLayout )
+            GD_DELETE(itLayout->second);
+    }
+
+    const NetClassLayout* Get( Class* pClass )
+    {
+        NetClassLayout*& layout = mLayouts[pClass];
+        if( !layout )
+            layout = GD_NEW(NetClassLayout, this, "Engine::Network")( pClass );
+
+        return layout;
+    }
+
+private:
+    Map<Class*, NetClassLayout*>    mLayouts;
+};
+
+
+const NetClassLayout* NetClassLayout::Get( Class* pClass )
+{
+    GD_ASSERT( pClass );
+
+    static NetClassLayoutRegistry registry;
+    return registry.Get( pClass );
+}
+
+NetClassLayout::NetClassLayout( Class* pClass )
+    : mClass(pClass)
+    , mStateSize(0)
+{
+#if GD_CFG_USE_PROPERTIES == GD_ENABLED
+    for( Class::PropertyIterator itProperty( pClass ); itProperty; ++itProperty )
+    {
+        const Property* property = *itProperty;
+        UInt32 id     = property->GetID();
+        UInt32 offset = property->GetOffset();
+
+        if( id == PropertyBool::ID() )
+            AddField( offset, sizeof(Bool), true );
+        else if( id == PropertyChar::ID() || id == PropertyByte::ID() )
+            AddField( offset, 1 );
+        else if( id == PropertyInt16::ID() || id == PropertyUInt16::ID() )
+            AddField( offset, 2 );
+        else if( id == PropertyInt32::ID() || id == PropertyUInt32::ID() || id == PropertyFloat::ID() || id == PropertyEnum::ID() )
+            AddField( offset, 4 );
+        else if( id == PropertyInt64::ID() || id == PropertyUInt64::ID() || id == PropertyDouble::ID() )
+            AddField( offset, 8 );
+        else if( id == PropertyVector3f::ID() || id == PropertyColor3f::ID() )
+        {
+            for( UInt32 i = 0; i < 3; i++ )
+                AddField( offset + i * sizeof(Float), sizeof(Float) );
+        }
+        else if( id == PropertyQuaternionf::ID() || id == PropertyColor4f::ID() )
+        {
+            for( UInt32 i = 0; i < 4; i++ )
+                AddField( offset + i * sizeof(Float), sizeof(Float) );
+        }
+    }
+#endif
+}
+
+void NetClassLayout::AddField( UInt32 pObjectOffset, UInt32 pSize, Bool pIsBool )
+{
+    Field field;
+    field.mObjectOffset = pObjectOffset;
+    field.mStateOffset  = mStateSize;
+    field.mSize         = pSize;
+    field.mNbBits       = pIsBool ? 1 : pSize * 8;
+
+    mFields.push_back( field );
+    mStateSize += pSize;
+}
+
+Class* NetClassLayout::GetClass() const
+{
+    return mClass;
+}
+
+UInt32 NetClassLayout::GetStateSize() const
+{
+    return mStateSize;
+}
+
+UInt32 NetClassLayout::GetNbFields() const
+{
+    return (UInt32)mFields.size();
+}
+
+void NetClassLayout::CaptureState( const Object* pObject, Byte* pState ) const
+{
+    const Byte* object = (const Byte*)pObject;
+    for( UInt32 i = 0; i < mFields.size(); i++ )
+        memcpy( pState + mFields[i].mStateOffset, object + mFields[i].mObjectOffset, mFields[i].mSize );
+}
+
+void NetClassLayout::ApplyState( const Byte* pState, Object* pObject ) const
+{
+    Byte* object = (Byte*)pObject;
+    for( UInt32 i = 0; i < mFields.size(); i++ )
+        memcpy( object + mFields[i].mObjectOffset, pState + mFields[i].mStateOffset, mFields[i].mSize );
+}
+
+void NetClassLayout::WriteDelta( BitWriter& pWriter, const Byte* pBaseline, const Byte* pState ) const
+{
+    static const Byte ZEROS[8] = { 0 };
+
+    for( UInt32 i = 0; i < mFields.size(); i++ )
+    {
+        const Field& field = mFields[i];
+        const Byte*  value = pState + field.mStateOffset;
+        const Byte*  base  = pBaseline ? pBaseline + field.mStateOffset : ZEROS;
+
+        if( memcmp( value, base, field.mSize ) == 0 )
+        {
+            pWriter.WriteBool( false );
+            continue;
+        }
+
+        pWriter.WriteBool( true );
+
+        if( field.mNbBits == 1 )
+        {
+            pWriter.WriteBool( *(const Bool*)value );
+            continue;
+        }
+
+        // Little endian, by blocks of up to 32 bits.
+        for( UInt32 offset = 0; offset < field.mSize; offset += 4 )
+        {
+            UInt32 nbBytes = field.mSize - offset < 4 ? field.mSize - offset : 4;
+            UInt32 bits = 0;
+            for( UInt32 b = 0; b < nbBytes; b++ )
+                bits |= value[offset + b] << (b * 8);
+
+            pWriter.WriteBits( bits, nbBytes * 8 );
+        }
+    }
+}
+
+void NetClassLayout::ReadDelta( BitReader& pReader, const Byte* pBaseline, Byte* pState ) const
+{
+    if( pBaseline != pState )
+    {
+        if( pBaseline )
+            memcpy( pState, pBaseline, mStateSize );
+        else
+            memset( pState, 0, mStateSize );
+    }
+
+    for( UInt32 i = 0; i < mFields.size(); i++ )
+    {
+        if( !pReader.ReadBool() )
+            continue;
+
+        const Field& field = mFields[i];
+        Byte*        value = pState + field.mStateOffset;
+
+        if( field.mNbBits == 1 )
+        {
+            *(Bool*)value = pReader.ReadBool();
+            continue;
+        }
+
+        for( UInt32 offset = 0; offset < field.mSize; offset += 4 )
+        {
+            UInt32 nbBytes = field.mSize - offset < 4 ? field.mSize - offset : 4;
+            UInt32 bits = pReader.ReadBits( nbBytes * 8 );
+            for( UInt32 b = 0; b < nbBytes; b++ )
+                value[offset + b] = (Byte)(bits >> (b * 8));
+        }
+    }
+}
+
+
+NetSnapshot::NetSnapshot()
+    : mTick(0)
+{
+}
+
+void NetSnapshot::Clear()
+{
+    mTick = 0;
+    mEntries.clear();
+    mData.clear();
+}
+
+UInt32 NetSnapshot::GetTick() const
+{
+    return mTick;
+}
+
+void NetSnapshot::SetTick( UInt32 pTick )
+{
+    mTick = pTick;
+}
+
+Byte* NetSnapshot::AddEntry( UInt32 pNetId, const NetClassLayout* pLayout )
+{
+    GD_ASSERT( mEntries.empty() || mEntries.back().mNetId < pNetId );
+
+    Entry entry;
+    entry.mNetId  = pNetId;
+    entry.mLayout = pLayout;
+    entry.mOffset = (UInt32)mData.size();
+    mEntries.push_back( entry );
+
+    mData.resize( mData.size() + pLayout->GetStateSize() );
+    return pLayout->GetStateSize() ? &mData[entry.mOffset] : NULL;
+}
+
+UInt32 NetSnapshot::GetNbEntries() const
+{
+    return (UInt32)mEntries.size();
+}
+
+const NetSnapshot::Entry& NetSnapshot::GetEntry( UInt32 pIndex ) const
+{
+    return mEntries[pIndex];
+}
+
+const Byte* NetSnapshot::GetState( UInt32 pIndex ) const
+{
+    return mData.empty() ? NULL : &mData[0] + mEntries[pIndex].mOffset;
+}
+
+Int32 NetSnapshot::Find( UInt32 pNetId ) const
+{
+    Int32 first = 0;
+    Int32 last  = (Int32)mEntries.size() - 1;
+
+    while( first <= last )
+    {
+        Int32 middle = (first + last) / 2;
+        if( mEntries[middle].mNetId < pNetId )
+            first = middle + 1;
+        else if( mEntries[middle].mNetId > pNetId )
+            last = middle - 1;
+        else
+            return middle;
+    }
+
+    return -1;
+}
+
+void NetSnapshot::WriteDelta( BitWriter& pWriter, const NetSnapshot* pBaseline, const NetSnapshot& pSnapshot )
+{
+    UInt32 nbBase = pBaseline ? pBaseline->GetNbEntries() : 0;
+    UInt32 nbNew  = pSnapshot.GetNbEntries();
+    UInt32 iBase  = 0;
+    UInt32 iNew   = 0;
+    UInt32 lastId = 0;
+
+    // Both snapshots are sorted by net id, walk them together.
+    while( iBase < nbBase || iNew < nbNew )
+    {
+        const Entry* base  = iBase < nbBase ? &pBaseline->mEntries[iBase] : NULL;
+        const Entry* entry = iNew  < nbNew  ? &pSnapshot.mEntries[iNew]   : NULL;
+
+        if( entry && (!base || entry->mNetId < base->mNetId) )
+        {
+            pWriter.WriteBool( true );
+            pWriter.WriteVarUInt32( entry->mNetId - lastId );
+            pWriter.WriteBits( Operation_Create, 2 );
+            pWriter.WriteString( entry->mLayout->GetClass()->GetName() );
+            entry->mLayout->WriteDelta( pWriter, NULL, pSnapshot.GetState( iNew ) );
+
+            lastId = entry->mNetId;
+            iNew++;
+        }
+        else if( base && (!entry || base->mNetId < entry->mNetId) )
+        {
+            pWriter.WriteBool( true );
+            pWriter.WriteVarUInt32( base->mNetId - lastId );
+            pWriter.WriteBits( Operation_Remove, 2 );
+
+            lastId = base->mNetId;
+            iBase++;
+        }
+        else
+        {
+            const Byte* baseState = pBaseline->GetState( iBase );
+            const Byte* state     = pSnapshot.GetState( iNew );
+
+            if( memcmp( baseState, state, entry->mLayout->GetStateSize() ) != 0 )
+            {
+                pWriter.WriteBool( true );
+                pWriter.WriteVarUInt32( entry->mNetId - lastId );
+                pWriter.WriteBits( Operation_Update, 2 );
+                entry->mLayout->WriteDelta( pWriter, baseState, state );
+
+                lastId = entry->mNetId;
+            }
+
+            iBase++;
+            iNew++;
+        }
+    }
+
+    pWriter.WriteBool( false );
+}
+
+Bool NetSnapshot::ReadDelta( BitReader& pReader, const NetSnapshot* pBaseline, NetSnapshot& pSnapshot )
+{
+    GD_ASSERT( pBaseline != &pSnapshot );
+
+    pSnapshot.mEntries.clear();
+    pSnapshot.mData.clear();
+
+    UInt32 nbBase = pBaseline ? pBaseline->GetNbEntries() : 0;
+    UInt32 iBase  = 0;
+    UInt32 lastId = 0;
+
+    while( pReader.ReadBool() && !pReader.IsOverflow() )
+    {
+        UInt32 delta = pReader.ReadVarUInt32();
+        UInt32 netId = lastId + delta;
+        UInt32 op    = pReader.ReadBits( 2 );
+
+        if( delta == 0 || pReader.IsOverflow() )
+            return false;
+
+        // Objects of the baseline before this one did not change.
+        while( iBase < nbBase && pBaseline->mEntries[iBase].mNetId < netId )
+        {
+            const Entry& base = pBaseline->mEntries[iBase];
+            UInt32 size = base.mLayout->GetStateSize();
+            Byte* state = pSnapshot.AddEntry( base.mNetId, base.mLayout );
+            if( size )
+                memcpy( state, pBaseline->GetState( iBase ), size );
+            iBase++;
+        }
+
+        Bool inBaseline = iBase < nbBase && pBaseline->mEntries[iBase].mNetId == netId;
+
+        if( op == Operation_Create )
+        {
+            String className;
+            pReader.ReadString( className );
+
+            Class* objectClass = Class::GetClassByName( className.c_str() );
+            if( inBaseline || !objectClass || objectClass->IsAbstract() )
+                return false;
+
+            const NetClassLayout* layout = NetClassLayout::Get( objectClass );
+            layout->ReadDelta( pReader, NULL, pSnapshot.AddEntry( netId, layout ) );
+        }
+        else if( op == Operation_Update )
+        {
+            if( !inBaseline )
+                return false;
+
+            const Entry& base = pBaseline->mEntries[iBase];
+            base.mLayout->ReadDelta( pReader, pBaseline->GetState( iBase ), pSnapshot.AddEntry( netId, base.mLayout ) );
+            iBase++;
+        }
+        else if( op == Operation_Remove )
+        {
+            if( !inBaseline )
+                return false;
+
+            iBase++;
+        }
+        else
+        {
+            return false;
+        }
+
+        lastId = netId;
+    }
+
+    // The rest of the baseline did not change.
+    for( ; iBase < nbBase; iBase++ )
+    {
+        const Entry& base = pBaseline->mEntries[iBase];
+        UInt32 size = base.mLayout->GetStateSize();
+        Byte* state = pSnapshot.AddEntry( base.mNetId, base.mLayout );
+        if( size )
+            memcpy( state, pBaseline->GetState( iBase ), size );
+    }
+
+    return !pReader.IsOverflow();
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,162 @@
+/**
+ *  @file       NetReplication.h
+ *  @brief      Replicated object states and their delta compression.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _NET_REPLICATION_H_
+#define     _NET_REPLICATION_H_
+
+
+namespace Gamedesk {
+
+
+class BitWriter;
+class BitReader;
+
+
+/**
+ *  Replicated state of a class, built from the properties of the Class
+ *  (see gdprop). Numbers, Bool, enums, vectors, quaternions and colors are
+ *  replicated; strings are not.
+ *
+ *  The state of an object is a copy of its replicated properties, packed
+ *  one after the other. Deltas are written per component: a bit telling if
+ *  it changed, then its value. Bool components take a single bit.
+ */
+class ENGINE_API NetClassLayout
+{
+public:
+    //! Layout of pClass, created on first use.
+    static const NetClassLayout* Get( Class* pClass );
+
+    Class* GetClass() const;
+
+    //! Size of the state of an object, in bytes.
+    UInt32 GetStateSize() const;
+
+    //! Number of replicated components.
+    UInt32 GetNbFields() const;
+
+    //! Copy the replicated properties of pObject to pState.
+    void CaptureState( const Object* pObject, Byte* pState ) const;
+
+    //! Copy pState to the replicated properties of pObject.
+    void ApplyState( const Byte* pState, Object* pObject ) const;
+
+    /**
+     *  Write the components of pState that differ from pBaseline.
+     *  @param  pBaseline   State known by the receiver, \c NULL for a state of zeros.
+     */
+    void WriteDelta( BitWriter& pWriter, const Byte* pBaseline, const Byte* pState ) const;
+
+    //! Read a delta written by WriteDelta(), pBaseline and pState can be the same.
+    void ReadDelta( BitReader& pReader, const Byte* pBaseline, Byte* pState ) const;
+
+private:
+    NetClassLayout( Class* pClass );
+
+    void AddField( UInt32 pObjectOffset, UInt32 pSize, Bool pIsBool = false );
+
+    friend class NetClassLayoutRegistry;
+
+private:
+    class Field
+    {
+    public:
+        UInt32  mObjectOffset;
+        UInt32  mStateOffset;
+        UInt32  mSize;          //!< 1, 2, 4 or 8 bytes.
+        UInt32  mNbBits;
+    };
+
+    Class*          mClass;
+    Vector<Field>   mFields;
+    UInt32          mStateSize;
+};
+
+
+/**
+ *  States of the replicated objects at a server tick, sorted by net id.
+ */
+class ENGINE_API NetSnapshot
+{
+public:
+    class Entry
+    {
+    public:
+        UInt32                  mNetId;
+        const NetClassLayout*   mLayout;
+        UInt32                  mOffset;    //!< Offset of the state in the snapshot data.
+    };
+
+public:
+    NetSnapshot();
+
+    void Clear();
+
+    //! Server tick of the snapshot, 0 when the snapshot is not valid.
+    UInt32 GetTick() const;
+    void SetTick( UInt32 pTick );
+
+    //! Add an entry, net ids must be added in increasing order. Return its state.
+    Byte* AddEntry( UInt32 pNetId, const NetClassLayout* pLayout );
+
+    UInt32 GetNbEntries() const;
+    const Entry& GetEntry( UInt32 pIndex ) const;
+    const Byte* GetState( UInt32 pIndex ) const;
+
+    //! Index of the entry with net id pNetId, -1 if there's none.
+    Int32 Find( UInt32 pNetId ) const;
+
+    /**
+     *  Write pSnapshot as a delta from pBaseline: the objects created and
+     *  removed, and the components that changed. Objects that did not change
+     *  are not written at all.
+     *  @param  pBaseline   Snapshot known by the receiver, \c NULL if none.
+     */
+    static void WriteDelta( BitWriter& pWriter, const NetSnapshot* pBaseline, const NetSnapshot& pSnapshot );
+
+    /**
+     *  Read a delta written by WriteDelta() into pSnapshot.
+     *  @return \c false if the data is corrupted or refers to an unknown class.
+     */
+    static Bool ReadDelta( BitReader& pReader, const NetSnapshot* pBaseline, NetSnapshot& pSnapshot );
+
+private:
+    enum Operation
+    {
+        Operation_Update,
+        Operation_Create,
+        Operation_Remove
+    };
+
+    UInt32          mTick;
+    Vector<Entry>   mEntries;
+    Vector<Byte>    mData;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _NET_REPLICATION_H_
@@ -0,0 +1,377 @@
+/**
+ *  @file       NetServer.cpp
+ *  @brief      Server side of the network game: connections and snapshots.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "NetServer.h"
+#include "BitStream.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Debug/PerformanceMonitor.h"
+#include "Maths/Maths.h"
+
+#include <algorithm>
+
+
+namespace Gamedesk {
+
+
+const Double NetServer::TIMEOUT = 10.0;
+
+
+NetServer::NetServer()
+    : mMaxClients(0)
+    , mListener(NULL)
+    , mNextNetId(1)
+    , mTickRate(20)
+    , mTime(0)
+    , mTickAccumulator(0)
+    , mTick(0)
+    , mLastTickTime(0)
+    , mLastSnapshotBytes(0)
+{
+    for( UInt32 i = 0; i < SNAPSHOT_HISTORY; i++ )
+        mDeltas[i].mTick = 0;
+}
+
+NetServer::~NetServer()
+{
+    Stop();
+}
+
+void NetServer::Start( UInt16 pPort, UInt32 pMaxClients )
+{
+    Stop();
+
+    mSocket.Open( pPort );
+    mMaxClients = pMaxClients;
+}
+
+void NetServer::Stop()
+{
+    while( !mClients.empty() )
+        RemoveClient( mClients.back(), true );
+
+    mSocket.Close();
+}
+
+Bool NetServer::IsStarted() const
+{
+    return mSocket.IsOpen();
+}
+
+UInt16 NetServer::GetPort() const
+{
+    return mSocket.GetPort();
+}
+
+void NetServer::SetTickRate( Float pTicksPerSecond )
+{
+    GD_ASSERT( pTicksPerSecond > 0 );
+    mTickRate = pTicksPerSecond;
+}
+
+Float NetServer::GetTickRate() const
+{
+    return mTickRate;
+}
+
+void NetServer::SetListener( NetServerListener* pListener )
+{
+    mListener = pListener;
+}
+
+void NetServer::Update( Double pElapsedTime )
+{
+    if( !IsStarted() )
+        return;
+
+    mTime += pElapsedTime;
+
+    ReceivePackets();
+
+    // Drop the clients that went silent or stopped acknowledging.
+    for( Int32 i = (Int32)mClients.size() - 1; i >= 0; i-- )
+    {
+        Client* client = mClients[i];
+        Double lastReceive = Maths::Max( client->mConnectTime, client->mConnection.GetLastReceiveTime() );
+
+        if( mTime - lastReceive > TIMEOUT || client->mConnection.IsOverflowed() )
+            RemoveClient( client, true );
+    }
+
+    // Tick at most once per update, a slow frame doesn't cause a burst of snapshots.
+    Double period = 1.0 / mTickRate;
+    mTickAccumulator += pElapsedTime;
+    if( mTickAccumulator >= period )
+    {
+        mTickAccumulator = Maths::Min( mTickAccumulator - period, period );
+        Tick();
+    }
+}
+
+void NetServer::Tick()
+{
+    Profile("NetServer::Tick");
+
+    UInt64 start = SystemInfo::Instance()->GetMicroSec64();
+
+    mTick++;
+
+    // Capture the state of the replicated objects.
+    NetSnapshot& snapshot = mSnapshots[mTick % SNAPSHOT_HISTORY];
+    snapshot.Clear();
+    snapshot.SetTick( mTick );
+
+    for( UInt32 i = 0; i < mObjects.size(); i++ )
+    {
+        const ReplicatedObject& object = mObjects[i];
+        Byte* state = snapshot.AddEntry( object.mNetId, object.mLayout );
+        if( state )
+            object.mLayout->CaptureState( object.mObject, state );
+    }
+
+    // Send it to every client, as a delta from the last snapshot they decoded.
+    mLastSnapshotBytes = 0;
+    for( UInt32 i = 0; i < mClients.size(); i++ )
+    {
+        Client* client = mClients[i];
+
+        UInt32 baselineTick = 0;
+        if( client->mAckedTick != 0 && mTick - client->mAckedTick < SNAPSHOT_HISTORY &&
+            mSnapshots[client->mAckedTick % SNAPSHOT_HISTORY].GetTick() == client->mAckedTick )
+        {
+            baselineTick = client->mAckedTick;
+        }
+
+        const EncodedDelta& delta = GetDelta( baselineTick );
+
+        mPacket.clear();
+        BitWriter writer( mPacket );
+        client->mConnection.WritePacket( writer, mTime );
+
+        UInt32 deltaSize = (delta.mNbBits + 7) / 8;
+        Bool   hasSnapshot = mPacket.size() + deltaSize + 8 <= NetConnection::MAX_PACKET_SIZE;
+
+        writer.WriteBool( hasSnapshot );
+        if( hasSnapshot )
+        {
+            writer.WriteBits( mTick, 32 );
+            writer.WriteBits( baselineTick ? mTick - baselineTick : 0, 5 );
+            if( delta.mNbBits )
+                writer.WriteBitArray( &delta.mData[0], delta.mNbBits );
+
+            mLastSnapshotBytes += deltaSize;
+        }
+        else
+        {
+            Core::DebugOut( "NetServer: snapshot too large for %s (%u bytes)\n", client->mConnection.GetAddress().ToString().c_str(), deltaSize );
+        }
+
+        client->mConnection.SendPacket( mPacket );
+    }
+
+    mLastTickTime = SystemInfo::Instance()->GetMicroSec64() - start;
+}
+
+const NetServer::EncodedDelta& NetServer::GetDelta( UInt32 pBaselineTick )
+{
+    UInt32 age = pBaselineTick ? mTick - pBaselineTick : 0;
+    EncodedDelta& delta = mDeltas[age];
+
+    if( delta.mTick != mTick )
+    {
+        delta.mTick = mTick;
+        delta.mData.clear();
+
+        BitWriter writer( delta.mData );
+        NetSnapshot::WriteDelta( writer, pBaselineTick ? &mSnapshots[pBaselineTick % SNAPSHOT_HISTORY] : NULL,
+                                 mSnapshots[mTick % SNAPSHOT_HISTORY] );
+        delta.mNbBits = writer.GetNbBits();
+    }
+
+    return delta;
+}
+
+UInt32 NetServer::Replicate( Object* pObject )
+{
+    GD_ASSERT( pObject );
+
+    ReplicatedObject object;
+    object.mNetId  = mNextNetId++;
+    object.mObject = pObject;
+    object.mLayout = NetClassLayout::Get( pObject->GetClass() );
+
+    // Net ids only grow, the objects stay sorted.
+    mObjects.push_back( object );
+    return object.mNetId;
+}
+
+void NetServer::StopReplicating( Object* pObject )
+{
+    for( Vector<ReplicatedObject>::iterator itObject = mObjects.begin(); itObject != mObjects.end(); ++itObject )
+    {
+        if( itObject->mObject == pObject )
+        {
+            mObjects.erase( itObject );
+            return;
+        }
+    }
+}
+
+UInt32 NetServer::GetNbReplicatedObjects() const
+{
+    return (UInt32)mObjects.size();
+}
+
+UInt32 NetServer::GetNbClients() const
+{
+    return (UInt32)mClients.size();
+}
+
+NetConnection* NetServer::GetClient( UInt32 pIndex ) const
+{
+    return &mClients[pIndex]->mConnection;
+}
+
+void NetServer::Disconnect( NetConnection* pClient )
+{
+    GD_ASSERT( pClient );
+
+    Client* client = FindClient( pClient->GetAddress() );
+    if( client )
+        RemoveClient( client, true );
+}
+
+UInt32 NetServer::GetTick() const
+{
+    return mTick;
+}
+
+UInt64 NetServer::GetLastTickTime() const
+{
+    return mLastTickTime;
+}
+
+UInt32 NetServer::GetLastSnapshotBytes() const
+{
+    return mLastSnapshotBytes;
+}
+
+void NetServer::ReceivePackets()
+{
+    Byte       datagram[NetPacket::MAX_DATAGRAM_SIZE];
+    NetAddress address;
+    UInt32     size;
+
+    while( (size = mSocket.Receive( address, datagram, sizeof(datagram) )) != 0 )
+        HandleDatagram( address, datagram, size );
+}
+
+void NetServer::HandleDatagram( const NetAddress& pAddress, const Byte* pDatagram, UInt32 pSize )
+{
+    NetPacket::Type type;
+    if( !NetPacket::ReadHeader( pDatagram, pSize, type ) )
+        return;
+
+    Client* client = FindClient( pAddress );
+
+    switch( type )
+    {
+    case NetPacket::Type_Connect:
+        if( client )
+        {
+            // Our accept was lost.
+            SendControl( pAddress, NetPacket::Type_Accept );
+        }
+        else if( mClients.size() < mMaxClients )
+        {
+            client = GD_NEW(Client, this, "Engine::Network")( mSocket, pAddress, mTime );
+            mClients.push_back( client );
+            mClientsByAddress[pAddress] = client;
+            SendControl( pAddress, NetPacket::Type_Accept );
+
+            if( mListener )
+                mListener->OnClientConnected( this, &client->mConnection );
+        }
+        else
+        {
+            SendControl( pAddress, NetPacket::Type_Reject );
+        }
+        break;
+
+    case NetPacket::Type_Disconnect:
+        if( client )
+            RemoveClient( client, false );
+        break;
+
+    case NetPacket::Type_Data:
+        if( client )
+        {
+            if( !client->mConnection.ReceiveDatagram( pDatagram, pSize, mTime, mReceivedPacket ) )
+                break;
+
+            BitReader reader( mReceivedPacket.empty() ? NULL : &mReceivedPacket[0], (UInt32)mReceivedPacket.size() );
+            if( !client->mConnection.ReadPacket( reader, mTime ) )
+                break;
+
+            // Last snapshot decoded by the client.
+            UInt32 ackedTick = reader.ReadBits( 32 );
+            if( !reader.IsOverflow() && ackedTick <= mTick && ackedTick > client->mAckedTick )
+                client->mAckedTick = ackedTick;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void NetServer::SendControl( const NetAddress& pAddress, NetPacket::Type pType )
+{
+    Byte datagram[NetPacket::HEADER_SIZE];
+    NetPacket::WriteHeader( datagram, pType );
+    mSocket.Send( pAddress, datagram, sizeof(datagram) );
+}
+
+void NetServer::RemoveClient( Client* pClient, Bool pNotifyClient )
+{
+    if( pNotifyClient )
+        SendControl( pClient->mConnection.GetAddress(), NetPacket::Type_Disconnect );
+
+    if( mListener )
+        mListener->OnClientDisconnected( this, &pClient->mConnection );
+
+    mClients.erase( std::find( mClients.begin(), mClients.end(), pClient ) );
+    mClientsByAddress.erase( pClient->mConnection.GetAddress() );
+    GD_DELETE(pClient);
+}
+
+NetServer::Client* NetServer::FindClient( const NetAddress& pAddress ) const
+{
+    Map<NetAddress, Client*>::const_iterator itClient = mClientsByAddress.find( pAddress );
+    return itClient != mClientsByAddress.end() ? itClient->second : NULL;
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,200 @@
+/**
+ *  @file       NetServer.h
+ *  @brief      Server side of the network game: connections and snapshots.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _NET_SERVER_H_
+#define     _NET_SERVER_H_
+
+
+#include "UdpSocket.h"
+#include "NetConnection.h"
+#include "NetReplication.h"
+
+
+namespace Gamedesk {
+
+
+class NetServer;
+
+
+//! Notified when clients connect to or leave a NetServer.
+class ENGINE_API NetServerListener
+{
+public:
+    virtual ~NetServerListener() {}
+
+    virtual void OnClientConnected( NetServer* pServer, NetConnection* pClient ) = 0;
+    //! Called before the connection is deleted.
+    virtual void OnClientDisconnected( NetServer* pServer, NetConnection* pClient ) = 0;
+};
+
+
+/**
+ *  Accept clients on a UDP port and send them a snapshot of the replicated
+ *  objects at every tick.
+ *
+ *  Each snapshot is sent as a delta from the last snapshot the client
+ *  decoded (it tells the server in each of its packets), or in full when
+ *  the client has none of the last SNAPSHOT_HISTORY snapshots. Clients that
+ *  decoded the same baseline receive the same delta, it's encoded once.
+ */
+class ENGINE_API NetServer
+{
+public:
+    static const UInt32 SNAPSHOT_HISTORY    = 32;
+    static const Double TIMEOUT;                    //!< Seconds without packets before a client is dropped.
+
+public:
+    NetServer();
+    ~NetServer();
+
+    /**
+     *  Start listening.
+     *  @param  pPort           UDP port, 0 to let the system choose one.
+     *  @param  pMaxClients     Clients beyond this number are rejected.
+     *  @exception NetworkException when the port can't be opened.
+     */
+    void Start( UInt16 pPort, UInt32 pMaxClients );
+
+    //! Disconnect every client and close the socket.
+    void Stop();
+
+    Bool IsStarted() const;
+
+    //! Port the server listens to.
+    UInt16 GetPort() const;
+
+    //! Number of snapshots sent per second (20 by default).
+    void SetTickRate( Float pTicksPerSecond );
+    Float GetTickRate() const;
+
+    void SetListener( NetServerListener* pListener );
+
+    /**
+     *  Receive the client packets, and tick when it's time to.
+     *  @param  pElapsedTime    Time since the last update, in seconds.
+     */
+    void Update( Double pElapsedTime );
+
+    //! Capture a snapshot of the replicated objects and send it to every client.
+    void Tick();
+
+    /**
+     *  Start replicating an object to the clients, the object must stay valid
+     *  until StopReplicating() is called.
+     *  @return The net id of the object, the same on every client.
+     */
+    UInt32 Replicate( Object* pObject );
+
+    //! Stop replicating an object, the clients delete their copy.
+    void StopReplicating( Object* pObject );
+
+    UInt32 GetNbReplicatedObjects() const;
+
+    UInt32 GetNbClients() const;
+    NetConnection* GetClient( UInt32 pIndex ) const;
+
+    //! Disconnect a client, the connection is deleted.
+    void Disconnect( NetConnection* pClient );
+
+    //! Current tick, incremented by every Tick().
+    UInt32 GetTick() const;
+
+    //! Time spent in the last Tick(), in microseconds.
+    UInt64 GetLastTickTime() const;
+
+    //! Size of the snapshot part of the last packets, summed over every client, in bytes.
+    UInt32 GetLastSnapshotBytes() const;
+
+private:
+    class Client
+    {
+    public:
+        Client( UdpSocket& pSocket, const NetAddress& pAddress, Double pTime )
+            : mConnection(pSocket, pAddress)
+            , mConnectTime(pTime)
+            , mAckedTick(0)
+        {
+        }
+
+        NetConnection   mConnection;
+        Double          mConnectTime;
+        UInt32          mAckedTick;     //!< Last snapshot decoded by the client, 0 if none.
+    };
+
+    class ReplicatedObject
+    {
+    public:
+        UInt32                  mNetId;
+        Object*                 mObject;
+        const NetClassLayout*   mLayout;
+    };
+
+    //! Delta from a baseline, shared by the clients that have this baseline.
+    class EncodedDelta
+    {
+    public:
+        UInt32          mTick;          //!< Tick the delta was encoded for.
+        Vector<Byte>    mData;
+        UInt32          mNbBits;
+    };
+
+    void ReceivePackets();
+    void HandleDatagram( const NetAddress& pAddress, const Byte* pDatagram, UInt32 pSize );
+    void SendControl( const NetAddress& pAddress, NetPacket::Type pType );
+    void RemoveClient( Client* pClient, Bool pNotifyClient );
+    Client* FindClient( const NetAddress& pAddress ) const;
+
+    const EncodedDelta& GetDelta( UInt32 pBaselineTick );
+
+private:
+    UdpSocket                   mSocket;
+    UInt32                      mMaxClients;
+    Vector<Client*>             mClients;
+    Map<NetAddress, Client*>    mClientsByAddress;
+    NetServerListener*          mListener;
+
+    Vector<ReplicatedObject>    mObjects;       //!< Sorted by net id.
+    UInt32                      mNextNetId;
+
+    Float                       mTickRate;
+    Double                      mTime;
+    Double                      mTickAccumulator;
+    UInt32                      mTick;
+
+    NetSnapshot                 mSnapshots[SNAPSHOT_HISTORY];
+    EncodedDelta                mDeltas[SNAPSHOT_HISTORY];  //!< By baseline age, 0 for the full snapshot.
+
+    Vector<Byte>                mPacket;
+    Vector<Byte>                mReceivedPacket;
+
+    UInt64                      mLastTickTime;
+    UInt32                      mLastSnapshotBytes;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _NET_SERVER_H_
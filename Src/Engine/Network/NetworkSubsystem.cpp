@@ -1,6 +1,6 @@
 /**
  *  @file       NetworkSubsystem.cpp
- *  @brief	    
+ *  @brief      Client/server networking over UDP.
  *  @author     Sbastien Lussier.
  *  @date       15/01/03.
  */
@@ -27,12 +27,89 @@
  */
 #include "Engine.h"
 #include "NetworkSubsystem.h"
+#include "NetServer.h"
+#include "NetClient.h"
+#include "UdpSocket.h"
+
+#include <algorithm>
 
 
 namespace Gamedesk {
 	
 	
-IMPLEMENT_ABSTRACT_CLASS(NetworkSubsystem);
+IMPLEMENT_CLASS(NetworkSubsystem);
+IMPLEMENT_ABSTRACT_SINGLETON(NetworkSubsystem);
+
+
+NetworkSubsystem::NetworkSubsystem()
+{
+    mInstance = this;
+}
+
+NetworkSubsystem::~NetworkSubsystem()
+{
+    mInstance = NULL;
+}
+
+void NetworkSubsystem::Init()
+{
+    Super::Init();
+    UdpSocket::Startup();
+}
+
+void NetworkSubsystem::Kill()
+{
+    while( !mClients.empty() )
+        DestroyClient( mClients.back() );
+
+    while( !mServers.empty() )
+        DestroyServer( mServers.back() );
+
+    UdpSocket::Shutdown();
+    Super::Kill();
+}
+
+NetServer* NetworkSubsystem::CreateServer()
+{
+    NetServer* server = GD_NEW(NetServer, this, "Engine::Network");
+    mServers.push_back( server );
+    return server;
+}
+
+void NetworkSubsystem::DestroyServer( NetServer* pServer )
+{
+    Vector<NetServer*>::iterator itServer = std::find( mServers.begin(), mServers.end(), pServer );
+    GD_ASSERT( itServer != mServers.end() );
+
+    mServers.erase( itServer );
+    GD_DELETE(pServer);
+}
+
+NetClient* NetworkSubsystem::CreateClient()
+{
+    NetClient* client = GD_NEW(NetClient, this, "Engine::Network");
+    mClients.push_back( client );
+    return client;
+}
+
+void NetworkSubsystem::DestroyClient( NetClient* pClient )
+{
+    Vector<NetClient*>::iterator itClient = std::find( mClients.begin(), mClients.end(), pClient );
+    GD_ASSERT( itClient != mClients.end() );
+
+    mClients.erase( itClient );
+    GD_DELETE(pClient);
+}
+
+void NetworkSubsystem::Update( Double pElapsedTime )
+{
+    // Clients first, the server then ticks with their latest acks.
+    for( UInt32 i = 0; i < mClients.size(); i++ )
+        mClients[i]->Update( pElapsedTime );
+
+    for( UInt32 i = 0; i < mServers.size(); i++ )
+        mServers[i]->Update( pElapsedTime );
+}
 
 
 } // namespace Gamedesk
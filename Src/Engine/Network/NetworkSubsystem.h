@@ -1,6 +1,6 @@
 /**
  *  @file       NetworkSubsystem.h
- *  @brief	    
+ *  @brief      Client/server networking over UDP.
  *  @author     Sbastien Lussier.
  *  @date       15/01/03.
  */
@@ -29,16 +29,53 @@
 #define     _NETWORK_SUBSYSTEM_H_
 
 
+#include "Patterns/Singleton.h"
 #include "Subsystem/Subsystem.h"
 
 
 namespace Gamedesk {
 
 
+class NetServer;
+class NetClient;
+
+
+/**
+ *  Client/server networking over UDP. Load it with Current=NetworkSubsystem
+ *  in the NetworkSubsystem section of the subsystem config.
+ *
+ *  The servers and clients created here are updated by Update(), a single
+ *  process can run a server and any number of clients (over the loopback).
+ *  See NetServer for the replication of objects.
+ */
 class ENGINE_API NetworkSubsystem : public Subsystem
 {
-    DECLARE_ABSTRACT_CLASS(NetworkSubsystem, Subsystem);
+    DECLARE_CLASS(NetworkSubsystem, Subsystem);
+    DECLARE_ABSTRACT_SINGLETON(NetworkSubsystem);
+
+public:
+    NetworkSubsystem();
+    virtual ~NetworkSubsystem();
+
+    //! Start the socket library.
+    virtual void Init();
+    //! Delete the servers and clients and stop the socket library.
+    virtual void Kill();
+
+    //! Create a server, start it with NetServer::Start().
+    NetServer* CreateServer();
+    void DestroyServer( NetServer* pServer );
+
+    //! Create a client, connect it with NetClient::Connect().
+    NetClient* CreateClient();
+    void DestroyClient( NetClient* pClient );
+
+    //! Update every server and client.
+    void Update( Double pElapsedTime );
 
+private:
+    Vector<NetServer*>  mServers;
+    Vector<NetClient*>  mClients;
 };
 
 
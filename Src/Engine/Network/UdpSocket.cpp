@@ -0,0 +1,188 @@
+/**
+ *  @file       UdpSocket.cpp
+ *  @brief      Non blocking UDP socket.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "UdpSocket.h"
+
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+    #pragma comment(lib, "ws2_32.lib")
+
+    typedef int socklen_t;
+    #define GD_CLOSE_SOCKET     closesocket
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+
+    #define INVALID_SOCKET      (-1)
+    #define GD_CLOSE_SOCKET     close
+#endif
+
+
+namespace Gamedesk {
+
+
+String NetAddress::ToString() const
+{
+    Char address[32];
+    sprintf( address, "%u.%u.%u.%u:%u", (mIP >> 24) & 0xFF, (mIP >> 16) & 0xFF, (mIP >> 8) & 0xFF, mIP & 0xFF, mPort );
+    return address;
+}
+
+
+UdpSocket::UdpSocket()
+    : mHandle((size_t)INVALID_SOCKET)
+    , mPort(0)
+{
+}
+
+UdpSocket::~UdpSocket()
+{
+    Close();
+}
+
+void UdpSocket::Open( UInt16 pPort )
+{
+    Close();
+
+    mHandle = (size_t)socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+    if( mHandle == (size_t)INVALID_SOCKET )
+        throw NetworkException( "Can't create a UDP socket.", Here );
+
+    sockaddr_in address;
+    memset( &address, 0, sizeof(address) );
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_ANY );
+    address.sin_port        = htons( pPort );
+
+    if( bind( mHandle, (const sockaddr*)&address, sizeof(address) ) != 0 )
+    {
+        Close();
+        throw NetworkException( "Can't bind a UDP socket to port " + Gamedesk::ToString(pPort) + ".", Here );
+    }
+
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+    u_long nonBlocking = 1;
+    Bool failed = ioctlsocket( mHandle, FIONBIO, &nonBlocking ) != 0;
+#else
+    Bool failed = fcntl( mHandle, F_SETFL, O_NONBLOCK ) != 0;
+#endif
+
+    if( failed )
+    {
+        Close();
+        throw NetworkException( "Can't make a UDP socket non blocking.", Here );
+    }
+
+    socklen_t size = sizeof(address);
+    getsockname( mHandle, (sockaddr*)&address, &size );
+    mPort = ntohs( address.sin_port );
+}
+
+void UdpSocket::Close()
+{
+    if( mHandle != (size_t)INVALID_SOCKET )
+    {
+        GD_CLOSE_SOCKET( mHandle );
+        mHandle = (size_t)INVALID_SOCKET;
+        mPort = 0;
+    }
+}
+
+Bool UdpSocket::IsOpen() const
+{
+    return mHandle != (size_t)INVALID_SOCKET;
+}
+
+UInt16 UdpSocket::GetPort() const
+{
+    return mPort;
+}
+
+Bool UdpSocket::Send( const NetAddress& pAddress, const Byte* pData, UInt32 pSize )
+{
+    GD_ASSERT( IsOpen() );
+
+    sockaddr_in address;
+    memset( &address, 0, sizeof(address) );
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl( pAddress.GetIP() );
+    address.sin_port        = htons( pAddress.GetPort() );
+
+    Int32 sent = sendto( mHandle, (const char*)pData, pSize, 0, (const sockaddr*)&address, sizeof(address) );
+    return sent == (Int32)pSize;
+}
+
+UInt32 UdpSocket::Receive( NetAddress& pAddress, Byte* pBuffer, UInt32 pSize )
+{
+    GD_ASSERT( IsOpen() );
+
+    for(;;)
+    {
+        sockaddr_in address;
+        socklen_t   size = sizeof(address);
+
+        Int32 received = recvfrom( mHandle, (char*)pBuffer, pSize, 0, (sockaddr*)&address, &size );
+
+        // Nothing left (would block) or an error (on Win32, ICMP port unreachable
+        // shows up here when a peer closed its socket), skip it.
+        if( received < 0 )
+        {
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+            Int32 error = WSAGetLastError();
+            if( error == WSAECONNRESET || error == WSAEMSGSIZE )
+                continue;
+#endif
+            return 0;
+        }
+
+        if( received == 0 )
+            continue;
+
+        pAddress = NetAddress( ntohl( address.sin_addr.s_addr ), ntohs( address.sin_port ) );
+        return (UInt32)received;
+    }
+}
+
+void UdpSocket::Startup()
+{
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+    WSADATA data;
+    if( WSAStartup( MAKEWORD(2, 2), &data ) != 0 )
+        throw NetworkException( "Can't start Winsock 2.2.", Here );
+#endif
+}
+
+void UdpSocket::Shutdown()
+{
+#if GD_PLATFORM == GD_PLATFORM_WIN32
+    WSACleanup();
+#endif
+}
+
+
+} // namespace Gamedesk
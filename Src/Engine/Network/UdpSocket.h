@@ -0,0 +1,164 @@
+/**
+ *  @file       UdpSocket.h
+ *  @brief      Non blocking UDP socket.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _UDP_SOCKET_H_
+#define     _UDP_SOCKET_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  IPv4 address and port, in host byte order.
+ */
+class ENGINE_API NetAddress
+{
+public:
+    NetAddress()
+        : mIP(0)
+        , mPort(0)
+    {
+    }
+
+    NetAddress( UInt32 pIP, UInt16 pPort )
+        : mIP(pIP)
+        , mPort(pPort)
+    {
+    }
+
+    NetAddress( Byte pA, Byte pB, Byte pC, Byte pD, UInt16 pPort )
+        : mIP((pA << 24) | (pB << 16) | (pC << 8) | pD)
+        , mPort(pPort)
+    {
+    }
+
+    //! Address of this computer (127.0.0.1) on port pPort.
+    static NetAddress Loopback( UInt16 pPort )
+    {
+        return NetAddress( 127, 0, 0, 1, pPort );
+    }
+
+    UInt32 GetIP() const
+    {
+        return mIP;
+    }
+
+    UInt16 GetPort() const
+    {
+        return mPort;
+    }
+
+    //! Return the address as "a.b.c.d:port".
+    String ToString() const;
+
+    Bool operator == ( const NetAddress& pOther ) const
+    {
+        return mIP == pOther.mIP && mPort == pOther.mPort;
+    }
+
+    Bool operator != ( const NetAddress& pOther ) const
+    {
+        return !(*this == pOther);
+    }
+
+    Bool operator < ( const NetAddress& pOther ) const
+    {
+        return mIP < pOther.mIP || (mIP == pOther.mIP && mPort < pOther.mPort);
+    }
+
+private:
+    UInt32  mIP;
+    UInt16  mPort;
+};
+
+
+/**
+ *  Non blocking UDP socket. The NetworkSubsystem must be initialized
+ *  before a socket is opened (it starts the socket library on Win32).
+ */
+class ENGINE_API UdpSocket
+{
+public:
+    UdpSocket();
+    ~UdpSocket();
+
+    /**
+     *  Open the socket and bind it to a port on every interface.
+     *  @param  pPort   Port to bind to, 0 to let the system choose one.
+     *  @exception NetworkException when the socket can't be created or bound.
+     */
+    void Open( UInt16 pPort = 0 );
+
+    void Close();
+
+    Bool IsOpen() const;
+
+    //! Port the socket is bound to.
+    UInt16 GetPort() const;
+
+    //! Send a datagram, return \c false if it could not be sent.
+    Bool Send( const NetAddress& pAddress, const Byte* pData, UInt32 pSize );
+
+    /**
+     *  Receive a datagram, without blocking.
+     *  @param  pAddress    Receives the address of the sender.
+     *  @param  pBuffer     Receives the datagram.
+     *  @param  pSize       Size of pBuffer, longer datagrams are discarded.
+     *  @return The size of the datagram, 0 if there's nothing to receive.
+     */
+    UInt32 Receive( NetAddress& pAddress, Byte* pBuffer, UInt32 pSize );
+
+    //! Start the socket library, called by the NetworkSubsystem.
+    static void Startup();
+    //! Stop the socket library, called by the NetworkSubsystem.
+    static void Shutdown();
+
+private:
+    UdpSocket( const UdpSocket& );
+    const UdpSocket& operator = ( const UdpSocket& );
+
+private:
+    size_t  mHandle;
+    UInt16  mPort;
+};
+
+
+class ENGINE_API NetworkException : public Exception
+{
+    DECLARE_EXCEPTION(NetworkException);
+
+public:
+    NetworkException( const String& pMessage, CodeLocation pLoc ) : Exception( pLoc )
+    {
+        mMessage = pMessage;
+        DebugOut();
+    }
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _UDP_SOCKET_H_
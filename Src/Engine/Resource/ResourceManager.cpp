@@ -55,6 +55,23 @@ void ResourceImporter::AddSupportedType( const String& pExtension )
         mSupportedTypes.push_back( pExtension );
 }
 
+void ResourceImporter::ImportBatch( const Vector<String>& pFilenames, Vector<Resource*>& pResources, const String& pParams )
+{
+    pResources.resize( pFilenames.size() );
+
+    for( UInt32 i = 0; i < pFilenames.size(); i++ )
+    {
+        try
+        {
+            pResources[i] = Import( pFilenames[i], pParams );
+        }
+        catch( Exception& /*e*/ )
+        {
+            pResources[i] = NULL;
+        }
+    }
+}
+
 Bool ResourceExporter::IsSupportedType( const String& pFilename ) const
 {
     Vector<String>::const_iterator it;
@@ -71,8 +88,11 @@ void ResourceExporter::AddSupportedType( const String& pExtension )
 
 ResourceManager ResourceManager::mInstance;
 
+static const Char* SOURCE_CHECKSUMS_FILE = "Config/SourceChecksums.cache";
+
 ResourceManager::ResourceManager() :
-    mInitialized(false)
+    mInitialized(false),
+    mSourceChecksums( FileChecksum::Algorithm_XXHash )
 {
 }
 
@@ -87,6 +107,8 @@ void ResourceManager::Init()
     {
         mInitialized = true;
 
+        mSourceChecksums.Load( SOURCE_CHECKSUMS_FILE );
+
         ModuleManager::Instance()->LoadModulesInFolder( "Plugins/ImportExport/" );
 
         Class::Iterator itImpClasses( ResourceImporter::StaticClass() );
@@ -116,6 +138,19 @@ void ResourceManager::Kill()
 
     for( itExporters = mExporters.begin(); itExporters != mExporters.end(); ++itExporters )
         GD_DELETE(*itExporters);
+
+    if( mInitialized )
+        mSourceChecksums.Save( SOURCE_CHECKSUMS_FILE );
+}
+
+FileChecksum ResourceManager::GetSourceChecksum( const String& pFilename )
+{
+    return mSourceChecksums.GetChecksum( pFilename );
+}
+
+Bool ResourceManager::IsSourceModified( const String& pFilename, const FileChecksum& pImportedChecksum )
+{
+    return mSourceChecksums.GetChecksum( pFilename ) != pImportedChecksum;
 }
 
 
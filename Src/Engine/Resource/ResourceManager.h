@@ -29,6 +29,9 @@
 #define     _RESOURCE_MANAGER_H_
 
 
+#include "FileManager/FileChecksumCache.h"
+
+
 namespace Gamedesk {
 
 
@@ -45,6 +48,13 @@ public:
     virtual Class*    GetResourceClass() = 0;
     virtual Resource* Import( const String& pFilename, const String& pParams = "" ) = 0;
 
+    /**
+     *  Import several files at once. Importers that can share work between the
+     *  files override this, the default imports them one after the other.
+     *  @param  pResources  Receives one resource per file, NULL for the files that could not be imported.
+     */
+    virtual void      ImportBatch( const Vector<String>& pFilenames, Vector<Resource*>& pResources, const String& pParams = "" );
+
 protected:
     ResourceImporter()
     {
@@ -154,10 +164,22 @@ public:
     ResourceImporter* GetImporterForFile( const String& pFilename, Class* pResourceClassWanted );
     ResourceExporter* GetExporterForFile( const String& pFilename, Class* pResourceClassWanted );
 
+    /**
+     *  Get the checksum of a source file. Store it with the imported resource and give it
+     *  back to IsSourceModified() to know if the file must be imported again.
+     *  Checksums are cached between runs, unchanged files are not read again.
+     */
+    FileChecksum GetSourceChecksum( const String& pFilename );
+
+    //! Return true if pFilename changed since it was imported with the checksum pImportedChecksum.
+    Bool IsSourceModified( const String& pFilename, const FileChecksum& pImportedChecksum );
+
 private:
     ResourceManager();
     
     Bool                        mInitialized;
+
+    FileChecksumCache           mSourceChecksums;
     
     Vector<ResourceImporter*>   mImporters;
     Vector<ResourceExporter*>   mExporters;
@@ -0,0 +1,312 @@
+/**
+ *  @file       SoftwareSound.cpp
+ *  @brief      Voice of the software sound subsystem.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "SoftwareSound.h"
+#include "SoftwareSoundSubsystem.h"
+#include "SoundData.h"
+#include "SoundStream.h"
+#include "Maths/Maths.h"
+
+
+namespace Gamedesk {
+
+
+IMPLEMENT_CLASS(SoftwareSound);
+
+
+SoftwareSound::SoftwareSound()
+    : mIs3DSound(true)
+    , mVirtual(false)
+    , mStream(NULL)
+    , mNbChannels(1)
+    , mBitsPerSample(16)
+    , mBytesPerFrame(2)
+    , mNbFrames(0)
+    , mSourceFrame(0)
+    , mWindowFrames(0)
+    , mEndFrame(NO_END)
+    , mFraction(0)
+{
+    mGain[0] = mGain[1] = 0.0f;
+    mTargetGain[0] = mTargetGain[1] = 0.0f;
+}
+
+SoftwareSound::~SoftwareSound()
+{
+    SoundSubsystem* subsystem = SoundSubsystem::Instance();
+    if(subsystem && subsystem->IsA(SoftwareSoundSubsystem::StaticClass()))
+        Cast<SoftwareSoundSubsystem>(subsystem)->RemoveSound(this);
+}
+
+void SoftwareSound::Create(SoundData* pSoundData, Bool pIs3DSound)
+{
+    Sound::Create(pSoundData, pIs3DSound);
+
+    GD_ASSERT(pSoundData);
+    GD_ASSERT_M(pSoundData->GetNbChannels() == 1 || pSoundData->GetNbChannels() == 2, "[SoftwareSound::Create] Only mono and stereo sounds are supported.");
+    GD_ASSERT_M(pSoundData->GetBitsPerSample() == 8 || pSoundData->GetBitsPerSample() == 16, "[SoftwareSound::Create] Only 8 and 16 bits sounds are supported.");
+
+    mIs3DSound      = pIs3DSound;
+    mStream         = pSoundData->IsA(SoundStream::StaticClass()) ? Cast<SoundStream>(pSoundData) : NULL;
+    mNbChannels     = pSoundData->GetNbChannels();
+    mBitsPerSample  = pSoundData->GetBitsPerSample();
+    mBytesPerFrame  = mNbChannels * mBitsPerSample / 8;
+    mNbFrames       = mStream ? 0 : pSoundData->GetSoundDataSize() / mBytesPerFrame;
+
+    // Set the frequency
+    Sound::SetFrequency(pSoundData->GetSampleRate());
+
+    ResetWindow();
+}
+
+void SoftwareSound::Kill()
+{
+    Sound::Stop();
+    Super::Kill();
+}
+
+Bool SoftwareSound::Play()
+{
+    Sound::Play();
+
+    ResetWindow();
+    if(mStream)
+    {
+        mStream->SetLooping(GetMode() == kSoundModeLoop);
+        mStream->Rewind();
+    }
+
+    // Fade in during the first block.
+    mGain[0] = mGain[1] = 0.0f;
+    return true;
+}
+
+Bool SoftwareSound::SetMode(eSoundMode pMode)
+{
+    Sound::SetMode(pMode);
+
+    if(mStream)
+        mStream->SetLooping(pMode == kSoundModeLoop);
+
+    return true;
+}
+
+Bool SoftwareSound::Is3DSound() const
+{
+    return mIs3DSound;
+}
+
+Bool SoftwareSound::IsVirtual() const
+{
+    return mVirtual;
+}
+
+Bool SoftwareSound::Mix(Float* pMix, UInt32 pNbFrames, UInt32 pStep, SoundMixer::Interpolation pMode)
+{
+    mVirtual = false;
+
+    UInt32 end     = mFraction + pStep * pNbFrames;
+    UInt32 advance = end >> SoundMixer::FRACTION_BITS;
+    UInt32 last    = (mFraction + pStep * (pNbFrames - 1)) >> SoundMixer::FRACTION_BITS;
+
+    FillWindow(Maths::Max(SoundMixer::FRAMES_BEFORE + last + 1 + SoundMixer::FRAMES_AFTER, SoundMixer::FRAMES_BEFORE + advance));
+
+    if(mResampled.size() < pNbFrames * mNbChannels)
+        mResampled.resize(pNbFrames * mNbChannels);
+
+    const Float* source = &mWindow[SoundMixer::FRAMES_BEFORE * mNbChannels];
+    for(UInt32 channel = 0; channel < mNbChannels; channel++)
+        SoundMixer::Resample(source, mNbChannels, channel, mFraction, pStep, pMode, &mResampled[channel * pNbFrames], pNbFrames);
+
+    Float gainStepLeft  = (mTargetGain[0] - mGain[0]) / pNbFrames;
+    Float gainStepRight = (mTargetGain[1] - mGain[1]) / pNbFrames;
+
+    if(mNbChannels == 1)
+        SoundMixer::AccumulateMono(&mResampled[0], pNbFrames, mGain[0], mGain[1], gainStepLeft, gainStepRight, pMix);
+    else
+        SoundMixer::AccumulateStereo(&mResampled[0], &mResampled[pNbFrames], pNbFrames, mGain[0], mGain[1], gainStepLeft, gainStepRight, pMix);
+
+    mGain[0] = mTargetGain[0];
+    mGain[1] = mTargetGain[1];
+
+    mFraction = end & (SoundMixer::FRACTION_ONE - 1);
+    ShiftWindow(advance);
+
+    return !IsFinished();
+}
+
+Bool SoftwareSound::Skip(UInt32 pNbFrames, UInt32 pStep)
+{
+    mVirtual = true;
+
+    // Fade in if it makes it back to the mix, the window will have lost its history.
+    mGain[0] = mGain[1] = 0.0f;
+
+    UInt32 end     = mFraction + pStep * pNbFrames;
+    UInt32 advance = end >> SoundMixer::FRACTION_BITS;
+    mFraction = end & (SoundMixer::FRACTION_ONE - 1);
+
+    UInt32 available = mWindowFrames - SoundMixer::FRAMES_BEFORE;
+    if(advance < available)
+    {
+        ShiftWindow(advance);
+        return !IsFinished();
+    }
+
+    if(mEndFrame == NO_END)
+        SkipSource(advance - available);
+
+    mWindowFrames = SoundMixer::FRAMES_BEFORE;
+    memset(&mWindow[0], 0, mWindowFrames * mNbChannels * sizeof(Float));
+
+    // The position is past everything that was decoded, including the end if it was reached.
+    if(mEndFrame != NO_END)
+        mEndFrame = 0;
+
+    return !IsFinished();
+}
+
+void SoftwareSound::FillWindow(UInt32 pNbFrames)
+{
+    if(mWindow.size() < pNbFrames * mNbChannels)
+        mWindow.resize(pNbFrames * mNbChannels);
+
+    while(mWindowFrames < pNbFrames && mEndFrame == NO_END)
+    {
+        UInt32 wanted = pNbFrames - mWindowFrames;
+        Float* dest   = &mWindow[mWindowFrames * mNbChannels];
+
+        if(mStream)
+        {
+            UInt32 wantedBytes = wanted * mBytesPerFrame;
+            if(mStreamBuffer.size() < wantedBytes)
+                mStreamBuffer.resize(wantedBytes);
+
+            UInt32 readBytes = mStream->Read(&mStreamBuffer[0], wantedBytes);
+            UInt32 frames    = readBytes / mBytesPerFrame;
+
+            SoundMixer::Decode(&mStreamBuffer[0], mBitsPerSample, frames * mNbChannels, dest);
+            mWindowFrames += frames;
+
+            // Read() only returns less at the end of a non looping stream.
+            if(readBytes < wantedBytes)
+                mEndFrame = mWindowFrames;
+        }
+        else
+        {
+            UInt32 frames = Maths::Min(wanted, mNbFrames - mSourceFrame);
+            const Byte* source = (const Byte*)GetSoundData().GetSoundData() + mSourceFrame * mBytesPerFrame;
+
+            SoundMixer::Decode(source, mBitsPerSample, frames * mNbChannels, dest);
+            mWindowFrames += frames;
+            mSourceFrame  += frames;
+
+            if(mSourceFrame == mNbFrames)
+            {
+                if(GetMode() == kSoundModeLoop && mNbFrames > 0)
+                    mSourceFrame = 0;
+                else
+                    mEndFrame = mWindowFrames;
+            }
+        }
+    }
+
+    // Silence after the end.
+    if(mWindowFrames < pNbFrames)
+    {
+        memset(&mWindow[mWindowFrames * mNbChannels], 0, (pNbFrames - mWindowFrames) * mNbChannels * sizeof(Float));
+        mWindowFrames = pNbFrames;
+    }
+}
+
+void SoftwareSound::ShiftWindow(UInt32 pNbFrames)
+{
+    GD_ASSERT(pNbFrames <= mWindowFrames);
+
+    mWindowFrames -= pNbFrames;
+    if(mWindowFrames)
+        memmove(&mWindow[0], &mWindow[pNbFrames * mNbChannels], mWindowFrames * mNbChannels * sizeof(Float));
+
+    if(mEndFrame != NO_END)
+        mEndFrame = mEndFrame > pNbFrames ? mEndFrame - pNbFrames : 0;
+}
+
+void SoftwareSound::SkipSource(UInt32 pNbFrames)
+{
+    if(mStream)
+    {
+        const UInt32 chunkFrames = SoundStream::CHUNK_SIZE / mBytesPerFrame;
+        if(mStreamBuffer.size() < chunkFrames * mBytesPerFrame)
+            mStreamBuffer.resize(chunkFrames * mBytesPerFrame);
+
+        while(pNbFrames)
+        {
+            UInt32 wantedBytes = Maths::Min(pNbFrames, chunkFrames) * mBytesPerFrame;
+            UInt32 readBytes   = mStream->Read(&mStreamBuffer[0], wantedBytes);
+            if(readBytes < wantedBytes)
+            {
+                mEndFrame = 0;
+                return;
+            }
+
+            pNbFrames -= readBytes / mBytesPerFrame;
+        }
+    }
+    else if(GetMode() == kSoundModeLoop && mNbFrames > 0)
+    {
+        mSourceFrame = (mSourceFrame + pNbFrames) % mNbFrames;
+    }
+    else if(mSourceFrame + pNbFrames >= mNbFrames)
+    {
+        mSourceFrame = mNbFrames;
+        mEndFrame = 0;
+    }
+    else
+    {
+        mSourceFrame += pNbFrames;
+    }
+}
+
+void SoftwareSound::ResetWindow()
+{
+    mSourceFrame  = 0;
+    mFraction     = 0;
+    mEndFrame     = NO_END;
+    mWindowFrames = SoundMixer::FRAMES_BEFORE;
+
+    if(mWindow.size() < mWindowFrames * mNbChannels)
+        mWindow.resize(mWindowFrames * mNbChannels);
+
+    memset(&mWindow[0], 0, mWindowFrames * mNbChannels * sizeof(Float));
+}
+
+Bool SoftwareSound::IsFinished() const
+{
+    return mEndFrame != NO_END && mEndFrame <= SoundMixer::FRAMES_BEFORE;
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,129 @@
+/**
+ *  @file       SoftwareSound.h
+ *  @brief      Voice of the software sound subsystem.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _SOFTWARE_SOUND_H_
+#define     _SOFTWARE_SOUND_H_
+
+
+#include "Sound.h"
+#include "SoundMixer.h"
+
+
+namespace Gamedesk {
+
+
+class SoundStream;
+
+
+/**
+ *  A sound played by the SoftwareSoundSubsystem. The sound data (resident or
+ *  streamed) is decoded to floats in a small window around the play position,
+ *  resampled to the output rate and added to the mix with the gains computed
+ *  by the subsystem.
+ */
+class ENGINE_API SoftwareSound : public Sound
+{
+    DECLARE_CLASS(SoftwareSound, Sound);
+
+public:
+    //! Default constructor.
+    SoftwareSound();
+    //! Destructor.
+    virtual ~SoftwareSound();
+
+    //! Creates a sound.
+    virtual void Create(SoundData* pSoundData, Bool pIs3DSound = true);
+    //! Kill the sound.
+    virtual void Kill();
+
+    //! Play the sound from the beginning.
+    virtual Bool Play();
+
+    //! Set the sound mode.
+    virtual Bool SetMode(eSoundMode pMode);
+
+    //! Returns whether the sound is positional or not.
+    Bool Is3DSound() const;
+
+    //! Returns true when the sound was skipped instead of mixed during the last block.
+    Bool IsVirtual() const;
+
+private:
+    friend class SoftwareSoundSubsystem;
+
+    /**
+     *  Mix the next pNbFrames output frames. The gains ramp from the ones of
+     *  the last block to mTargetGain.
+     *  @return false once a one shot sound reached its end.
+     */
+    Bool Mix(Float* pMix, UInt32 pNbFrames, UInt32 pStep, SoundMixer::Interpolation pMode);
+
+    /**
+     *  Move the play position as if pNbFrames were mixed, without decoding
+     *  when possible. Used for the voices that don't make it to the mix.
+     *  @return false once a one shot sound reached its end.
+     */
+    Bool Skip(UInt32 pNbFrames, UInt32 pStep);
+
+    //! Decode source frames until the window holds pNbFrames frames.
+    void FillWindow(UInt32 pNbFrames);
+    //! Drop the first pNbFrames frames of the window.
+    void ShiftWindow(UInt32 pNbFrames);
+    //! Skip pNbFrames frames of the source without decoding them.
+    void SkipSource(UInt32 pNbFrames);
+    //! Restart at the first frame, the window only holds silence before it.
+    void ResetWindow();
+
+    Bool IsFinished() const;
+
+private:
+    static const UInt32 NO_END = 0xFFFFFFFF;
+
+    Bool            mIs3DSound;
+    Bool            mVirtual;
+    SoundStream*    mStream;            //!< The sound data when it's streamed, NULL when it's resident.
+    UInt32          mNbChannels;
+    UInt32          mBitsPerSample;
+    UInt32          mBytesPerFrame;
+    UInt32          mNbFrames;          //!< Frames of resident sound data.
+    UInt32          mSourceFrame;       //!< Next frame of resident sound data to decode.
+
+    Vector<Float>   mWindow;            //!< Decoded frames, starting SoundMixer::FRAMES_BEFORE frames before the play position.
+    UInt32          mWindowFrames;
+    UInt32          mEndFrame;          //!< Window frame where the sound data ends, NO_END until it's known.
+    UInt32          mFraction;          //!< Fractional part of the play position.
+
+    Vector<Float>   mResampled;         //!< One block of output frames, one array per channel.
+    Vector<Byte>    mStreamBuffer;
+
+    Float           mGain[2];           //!< Gains at the end of the last mixed block.
+    Float           mTargetGain[2];     //!< Gains for the end of the next block, set by the subsystem.
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _SOFTWARE_SOUND_H_
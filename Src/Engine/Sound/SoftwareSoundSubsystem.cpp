@@ -0,0 +1,358 @@
+/**
+ *  @file       SoftwareSoundSubsystem.cpp
+ *  @brief      Sound subsystem mixing in software, without any sound library.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "SoftwareSoundSubsystem.h"
+#include "SoftwareSound.h"
+#include "Maths/Maths.h"
+
+#include <algorithm>
+
+
+namespace Gamedesk {
+
+
+IMPLEMENT_CLASS(SoftwareSoundSubsystem);
+
+
+// Integral constants are initialized in the class, they still need a definition when bound to a reference (ex. Maths::Min).
+const UInt32 SoftwareSoundSubsystem::BLOCK_SIZE;
+const UInt32 SoftwareSoundSubsystem::MAX_STEP;
+
+
+SoftwareSoundSubsystem::SoftwareSoundSubsystem()
+    : mSink(NULL)
+    , mStarted(false)
+    , mOutputRate(44100)
+    , mMaxNbVoices(64)
+    , mInterpolation(SoundMixer::Interpolation_Linear)
+    , mPendingFrames(0)
+    , mListenerPosition(0, 0, 0)
+    , mListenerVelocity(0, 0, 0)
+    , mListenerForward(0, 0, -1)
+    , mListenerUp(0, 1, 0)
+    , mNbMixedVoices(0)
+    , mNbVirtualVoices(0)
+{
+    mLastListenerPosition = Vector3f(0, 0, 0);
+}
+
+SoftwareSoundSubsystem::~SoftwareSoundSubsystem()
+{
+}
+
+void SoftwareSoundSubsystem::Init()
+{
+    Super::Init();
+    StartSoundSystem();
+}
+
+void SoftwareSoundSubsystem::Kill()
+{
+    Super::Kill();
+    StopSoundSystem();
+}
+
+Object* SoftwareSoundSubsystem::Create(Class* pResourceClass)
+{
+    if(pResourceClass == Sound::StaticClass())
+    {
+        SoftwareSound* sound = GD_NEW(SoftwareSound, this, "SoftwareSound");
+        mSounds.push_back(sound);
+        return sound;
+    }
+    
+    return Super::Create(pResourceClass);
+}
+
+Bool SoftwareSoundSubsystem::StartSoundSystem()
+{
+    if(mStarted)
+        return true;
+
+    mMixBuffer.resize(BLOCK_SIZE * 2);
+    mOutputBuffer.resize(BLOCK_SIZE * 2);
+    mPendingFrames = 0;
+
+    GetSink()->Open(mOutputRate);
+    mStarted = true;
+    return true;
+}
+
+Bool SoftwareSoundSubsystem::StopSoundSystem()
+{
+    if(!mStarted)
+        return true;
+
+    GetSink()->Close();
+    mStarted = false;
+    return true;
+}
+
+void SoftwareSoundSubsystem::SetOutputRate(Int32 pOutputRate)
+{
+    GD_ASSERT_M(!mStarted, "[SoftwareSoundSubsystem::SetOutputRate] The sound system must be stopped.");
+    mOutputRate = pOutputRate;
+}
+
+Int32 SoftwareSoundSubsystem::GetOutputRate()
+{
+    return mOutputRate;
+}
+
+void SoftwareSoundSubsystem::SetMaxNbSoftwareChannels(Int32 pNbSoftwareChannels)
+{
+    mMaxNbVoices = pNbSoftwareChannels;
+}
+
+Int32 SoftwareSoundSubsystem::GetNbPlayingChannels()
+{
+    return mNbMixedVoices;
+}
+
+Int32 SoftwareSoundSubsystem::GetNbChannels()
+{
+    return mMaxNbVoices;
+}
+
+SoundSubsystem::eOutputType SoftwareSoundSubsystem::GetOutputType()
+{
+    return kOutputTypeNoSound;
+}
+
+SoundSubsystem::eSpeakerMode SoftwareSoundSubsystem::GetSpeakerMode() const
+{
+    return kSpeakerModeStereo;
+}
+
+void SoftwareSoundSubsystem::Get3DListenerAttributes(Vector3f& pPosition, 
+                                                     Vector3f& pVelocity,
+                                                     Vector3f& pForward, 
+                                                     Vector3f& pUp)
+{
+    pPosition = mListenerPosition;
+    pVelocity = mListenerVelocity;
+    pForward  = mListenerForward;
+    pUp       = mListenerUp;
+}
+
+void SoftwareSoundSubsystem::Set3DListenerAttributes(const Vector3f& pPosition, 
+                                                     const Vector3f& pVelocity,
+                                                     const Vector3f& pForward, 
+                                                     const Vector3f& pUp)
+{
+    Super::Set3DListenerAttributes(pPosition, pVelocity, pForward, pUp);
+
+    mListenerPosition = pPosition;
+    mListenerVelocity = pVelocity;
+    mListenerForward  = pForward;
+    mListenerUp       = pUp;
+}
+
+void SoftwareSoundSubsystem::Update(Double pElapsedTime,
+                                    const Vector3f& pListenerPosition,
+                                    const Vector3f& pListenerForward,
+                                    const Vector3f& pListenerUp)
+{
+    // Calculate the velocity.
+    Vector3f velocity(0, 0, 0);
+    if(pElapsedTime > 0)
+        velocity = (pListenerPosition - mLastListenerPosition) / pElapsedTime;
+    
+    // Update the last listener's position.
+    mLastListenerPosition = pListenerPosition;
+
+    Set3DListenerAttributes(pListenerPosition, velocity, pListenerForward, pListenerUp);
+
+    if(!mStarted)
+        return;
+
+    mPendingFrames += pElapsedTime * mOutputRate;
+    UInt32 nbFrames = UInt32(mPendingFrames);
+    mPendingFrames -= nbFrames;
+
+    Mix(nbFrames);
+}
+
+void SoftwareSoundSubsystem::SetSink(SoundSink* pSink)
+{
+    if(mStarted)
+        GetSink()->Close();
+
+    mSink = pSink;
+
+    if(mStarted)
+        GetSink()->Open(mOutputRate);
+}
+
+SoundSink* SoftwareSoundSubsystem::GetSink() const
+{
+    return mSink ? mSink : (SoundSink*)&mNullSink;
+}
+
+void SoftwareSoundSubsystem::SetInterpolation(SoundMixer::Interpolation pInterpolation)
+{
+    mInterpolation = pInterpolation;
+}
+
+SoundMixer::Interpolation SoftwareSoundSubsystem::GetInterpolation() const
+{
+    return mInterpolation;
+}
+
+void SoftwareSoundSubsystem::Mix(UInt32 pNbFrames)
+{
+    GD_ASSERT_M(mStarted, "[SoftwareSoundSubsystem::Mix] The sound system is not started.");
+
+    while(pNbFrames)
+    {
+        UInt32 nbFrames = Maths::Min(pNbFrames, BLOCK_SIZE);
+        MixBlock(nbFrames);
+        pNbFrames -= nbFrames;
+    }
+}
+
+UInt32 SoftwareSoundSubsystem::GetNbVirtualVoices() const
+{
+    return mNbVirtualVoices;
+}
+
+void SoftwareSoundSubsystem::RemoveSound(SoftwareSound* pSound)
+{
+    Vector<SoftwareSound*>::iterator itFind = std::find(mSounds.begin(), mSounds.end(), pSound);
+    if(itFind != mSounds.end())
+        mSounds.erase(itFind);
+}
+
+void SoftwareSoundSubsystem::MixBlock(UInt32 pNbFrames)
+{
+    memset(&mMixBuffer[0], 0, pNbFrames * 2 * sizeof(Float));
+
+    mVoices.clear();
+    for(Vector<SoftwareSound*>::iterator itSound = mSounds.begin(); itSound != mSounds.end(); ++itSound)
+    {
+        if((*itSound)->IsPlaying() && !(*itSound)->IsPaused())
+        {
+            ComputeGains(*itSound);
+            mVoices.push_back(*itSound);
+        }
+    }
+
+    // Only the most important voices are mixed, no need to sort the others.
+    UInt32 nbMixed = Maths::Min<UInt32>(mVoices.size(), mMaxNbVoices);
+    if(nbMixed < mVoices.size())
+        std::nth_element(mVoices.begin(), mVoices.begin() + nbMixed, mVoices.end(), IsMoreImportant);
+
+    for(UInt32 i = 0; i < mVoices.size(); i++)
+    {
+        SoftwareSound* sound = mVoices[i];
+        UInt32 step = ComputeStep(sound);
+
+        Bool playing = i < nbMixed ? sound->Mix(&mMixBuffer[0], pNbFrames, step, mInterpolation) 
+                                   : sound->Skip(pNbFrames, step);
+        if(!playing)
+            sound->Stop();
+    }
+
+    mNbMixedVoices   = nbMixed;
+    mNbVirtualVoices = mVoices.size() - nbMixed;
+
+    SoundMixer::ToInt16(&mMixBuffer[0], pNbFrames * 2, &mOutputBuffer[0]);
+    GetSink()->Write(&mOutputBuffer[0], pNbFrames);
+}
+
+void SoftwareSoundSubsystem::ComputeGains(SoftwareSound* pSound)
+{
+    Float volume = pSound->IsMuted() ? 0.0f : (pSound->GetVolume() / 255.0f) * (GetSFXMasterVolume() / 255.0f);
+    Float pan    = 0.0f;
+
+    if(pSound->Is3DSound())
+    {
+        Vector3f delta    = pSound->GetPosition() - mListenerPosition;
+        Float    distance = delta.GetLength();
+        Float    minDistance = pSound->GetMinDistance();
+
+        if(distance > minDistance)
+        {
+            Float clampedDistance = Maths::Min(distance, pSound->GetMaxDistance());
+            volume *= minDistance / (minDistance + GetRolloffFactor() * (clampedDistance - minDistance));
+        }
+
+        Vector3f right = mListenerForward cross mListenerUp;
+        Float    rightLength = right.GetLength();
+        if(distance > 0.0f && rightLength > 0.0f)
+            pan = (delta dot right) / (distance * rightLength);
+
+        // Sounds closer than the min distance surround the listener.
+        if(distance < minDistance)
+            pan *= distance / minDistance;
+    }
+    else if(pSound->IsStereoPan())
+    {
+        pSound->mTargetGain[0] = volume;
+        pSound->mTargetGain[1] = volume;
+        return;
+    }
+    else
+    {
+        pan = pSound->GetPan() / 127.5f - 1.0f;
+    }
+
+    Maths::Clamp(pan, -1.0f, 1.0f);
+
+    if(pSound->mNbChannels == 2)
+    {
+        // Balance, the channels of a stereo sound are not mixed together.
+        pSound->mTargetGain[0] = volume * Maths::Min(1.0f, 1.0f - pan);
+        pSound->mTargetGain[1] = volume * Maths::Min(1.0f, 1.0f + pan);
+    }
+    else
+    {
+        // Constant power.
+        Float angle = (pan + 1.0f) * Maths::PI * 0.25f;
+        pSound->mTargetGain[0] = volume * Maths::Cos(angle);
+        pSound->mTargetGain[1] = volume * Maths::Sin(angle);
+    }
+}
+
+UInt32 SoftwareSoundSubsystem::ComputeStep(SoftwareSound* pSound)
+{
+    Float  rate = Maths::Abs(pSound->GetFrequency() * GetSpeedRatio());
+    UInt32 step = UInt32(rate / mOutputRate * SoundMixer::FRACTION_ONE);
+
+    return Maths::Max<UInt32>(1, Maths::Min<UInt32>(step, MAX_STEP));
+}
+
+Bool SoftwareSoundSubsystem::IsMoreImportant(const SoftwareSound* pSoundA, const SoftwareSound* pSoundB)
+{
+    if(pSoundA->GetPriority() != pSoundB->GetPriority())
+        return pSoundA->GetPriority() > pSoundB->GetPriority();
+
+    return Maths::Max(pSoundA->mTargetGain[0], pSoundA->mTargetGain[1]) > 
+           Maths::Max(pSoundB->mTargetGain[0], pSoundB->mTargetGain[1]);
+}
+
+
+} // namespace Gamedesk
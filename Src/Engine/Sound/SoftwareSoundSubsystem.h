@@ -0,0 +1,169 @@
+/**
+ *  @file       SoftwareSoundSubsystem.h
+ *  @brief      Sound subsystem mixing in software, without any sound library.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _SOFTWARE_SOUND_SUBSYSTEM_H_
+#define     _SOFTWARE_SOUND_SUBSYSTEM_H_
+
+
+#include "SoundSubsystem.h"
+#include "SoundMixer.h"
+#include "SoundSink.h"
+
+
+namespace Gamedesk {
+
+
+class SoftwareSound;
+
+
+/**
+ *  Sound subsystem doing its own mixing, the output goes to a SoundSink
+ *  (discarded by default). Update() mixes the frames covering the elapsed
+ *  time, in blocks of BLOCK_SIZE frames.
+ *
+ *  Any number of sounds can play, only the GetNbChannels() most important
+ *  ones (highest priority, then loudest) are mixed. The others are virtual:
+ *  their position moves on but they are not decoded, and they fade in if they
+ *  make it back to the mix.
+ *
+ *  3D sounds are attenuated with the distance the same way as FMOD
+ *  (minDistance / (minDistance + rolloff * (distance - minDistance)))
+ *  and panned from their direction relative to the listener. There's no
+ *  doppler effect, and negative frequencies play forward.
+ */
+class ENGINE_API SoftwareSoundSubsystem : public SoundSubsystem
+{
+    DECLARE_CLASS(SoftwareSoundSubsystem, SoundSubsystem);
+
+public:
+    static const UInt32 BLOCK_SIZE  = 512;                                  //!< Frames mixed at once.
+    static const UInt32 MAX_STEP    = 8 * SoundMixer::FRACTION_ONE;         //!< Sounds can't play faster than 8 times the output rate.
+
+public:
+    SoftwareSoundSubsystem();
+    virtual ~SoftwareSoundSubsystem();
+
+    //! Initialize the sound subsystem and start mixing.
+    virtual void Init();
+    //! Kill the sound subsystem.
+    virtual void Kill();
+
+    //! Creates a resource.
+    virtual Object* Create(Class* pResourceClass);
+
+    //! Start the sound system.
+    virtual Bool StartSoundSystem();
+    //! Stop the sound system.
+    virtual Bool StopSoundSystem();
+
+    //! Sets the output rate in hz. (Between 4000 and 65535).
+    virtual void SetOutputRate(Int32 pOutputRate);
+    //! Returns the current mixing rate in hz.
+    virtual Int32 GetOutputRate();
+
+    //! Sets the maximum number of sounds mixed at once, the others are virtual.
+    virtual void SetMaxNbSoftwareChannels(Int32 pNbSoftwareChannels);
+
+    //! Returns the number of sounds mixed during the last block.
+    virtual Int32 GetNbPlayingChannels();
+    //! Returns the maximum number of sounds mixed at once.
+    virtual Int32 GetNbChannels();
+
+    virtual eOutputType GetOutputType();
+    virtual eSpeakerMode GetSpeakerMode() const;
+
+    virtual void Get3DListenerAttributes(Vector3f& pPosition, Vector3f& pVelocity,
+                                         Vector3f& pForward, Vector3f& pUp);
+    virtual void Set3DListenerAttributes(const Vector3f& pPosition, const Vector3f& pVelocity,
+                                         const Vector3f& pForward, const Vector3f& pUp);
+
+    //! Update the listener and mix the frames covering pElapsedTime.
+    virtual void Update(Double pElapsedTime,
+                        const Vector3f& pListenerPosition,
+                        const Vector3f& pListenerForward,
+                        const Vector3f& pListenerUp);
+
+    /**
+     *  Set where the output goes. The sink is not owned by the subsystem.
+     *  @param  pSink   The new sink, NULL to discard the output.
+     */
+    void SetSink(SoundSink* pSink);
+    //! Get the sink the output goes to.
+    SoundSink* GetSink() const;
+
+    //! Set the interpolation used when the sound and output rates differ.
+    void SetInterpolation(SoundMixer::Interpolation pInterpolation);
+    //! Get the interpolation used when the sound and output rates differ.
+    SoundMixer::Interpolation GetInterpolation() const;
+
+    //! Mix pNbFrames frames and write them to the sink.
+    void Mix(UInt32 pNbFrames);
+
+    //! Number of sounds that were playing but not mixed during the last block.
+    UInt32 GetNbVirtualVoices() const;
+
+private:
+    friend class SoftwareSound;
+
+    //! Called when a sound is deleted.
+    void RemoveSound(SoftwareSound* pSound);
+
+    void MixBlock(UInt32 pNbFrames);
+    void ComputeGains(SoftwareSound* pSound);
+    UInt32 ComputeStep(SoftwareSound* pSound);
+
+    //! Sort order of the voices, the ones that matter the most first.
+    static Bool IsMoreImportant(const SoftwareSound* pSoundA, const SoftwareSound* pSoundB);
+
+private:
+    Vector<SoftwareSound*>      mSounds;
+    Vector<SoftwareSound*>      mVoices;        //!< Sounds playing during the current block.
+
+    SoundSink*                  mSink;
+    NullSoundSink               mNullSink;
+    Bool                        mStarted;
+
+    UInt32                      mOutputRate;
+    UInt32                      mMaxNbVoices;
+    SoundMixer::Interpolation   mInterpolation;
+    Double                      mPendingFrames; //!< Fraction of a frame left from the last Update().
+
+    Vector<Float>               mMixBuffer;
+    Vector<Int16>               mOutputBuffer;
+
+    Vector3f                    mListenerPosition;
+    Vector3f                    mListenerVelocity;
+    Vector3f                    mListenerForward;
+    Vector3f                    mListenerUp;
+
+    UInt32                      mNbMixedVoices;
+    UInt32                      mNbVirtualVoices;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _SOFTWARE_SOUND_SUBSYSTEM_H_
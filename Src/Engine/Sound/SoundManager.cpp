@@ -30,6 +30,8 @@
 #include "SoundSubsystem.h"
 #include "Sound.h"
 #include "SoundData.h"
+#include "SoundStream.h"
+#include "FileManager/FileManager.h"
 #include "Resource/ResourceManager.h"
 
 
@@ -44,12 +46,39 @@ SoundManager& SoundManager::Instance()
 
 
 SoundManager::SoundManager()
+    : mStreamThreshold(1024 * 1024)
 {
 }
 
 
 Sound* SoundManager::Create(const String& pSoundFileName, Bool pIs3DSound)
 {
+    // Big files are streamed, a stream can't be shared.
+    if(FileManager::GetFileSize(pSoundFileName) >= mStreamThreshold)
+    {
+        ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile(pSoundFileName, SoundData::StaticClass());
+        if(!importer)
+            throw NullPointerException("importer", Here);
+
+        Resource* resource = importer->Import(pSoundFileName, "Stream");
+        if(!resource)
+            throw NullPointerException("resource", Here);
+
+        // Release() only deletes the data of a stream, anything else would leak.
+        if(!resource->IsA(SoundStream::StaticClass()))
+        {
+            InvalidClassException exception(resource->GetClass(), SoundStream::StaticClass(), Here);
+            resource->Kill();
+            GD_DELETE(resource);
+            throw exception;
+        }
+
+        Sound* sound = Cast<Sound>(SoundSubsystem::Instance()->Create(Sound::StaticClass()));
+        sound->Create(Cast<SoundData>(resource), pIs3DSound);
+        sound->Init();
+        return sound;
+    }
+
     // Ask the sound subsystem to create a sound for us.
     Sound* sound = Cast<Sound>(SoundSubsystem::Instance()->Create(Sound::StaticClass()));
 
@@ -77,6 +106,19 @@ Sound* SoundManager::Create(const String& pSoundFileName, Bool pIs3DSound)
 
 void SoundManager::Release(Sound* pSound)
 {
+    if(pSound->GetSoundData().IsA(SoundStream::StaticClass()))
+    {
+        // The sound must stop pulling from the stream before it's deleted.
+        SoundData* soundStream = &pSound->GetSoundData();
+        pSound->Stop();
+        pSound->Kill();
+        GD_DELETE(pSound);
+
+        soundStream->Kill();
+        GD_DELETE(soundStream);
+        return;
+    }
+
     String soundFileName = pSound->GetSoundData().GetFileName();
     std::map<String, SoundData*>::iterator itFind = mLoadedSounds.find(soundFileName);
     GD_ASSERT(itFind != mLoadedSounds.end());
@@ -92,5 +134,15 @@ void SoundManager::Release(Sound* pSound)
     GD_DELETE(pSound);
 }
 
+void SoundManager::SetStreamThreshold(UInt32 pStreamThreshold)
+{
+    mStreamThreshold = pStreamThreshold;
+}
+
+UInt32 SoundManager::GetStreamThreshold() const
+{
+    return mStreamThreshold;
+}
+
 
 } // namespace Gamedesk
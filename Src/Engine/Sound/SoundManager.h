@@ -43,8 +43,22 @@ class ENGINE_API SoundManager
 public:
     static SoundManager& Instance();
 
+    /**
+     *  Create a sound playing the given file.
+     *  Files smaller than the stream threshold are loaded once and shared by
+     *  all the sounds using them. Bigger files are streamed, each sound gets
+     *  its own SoundStream.
+     *  @param  pSoundFileName  The sound file.
+     *  @param  pIs3DSound      true for a positional sound.
+     *  @return The sound, to give back to Release().
+     */
     Sound* Create(const String& pSoundFileName, Bool pIs3DSound = true);
     void Release(Sound* pSound);
+
+    //! Set the file size, in bytes, from which sounds are streamed instead of loaded.
+    void SetStreamThreshold(UInt32 pStreamThreshold);
+    //! Get the file size, in bytes, from which sounds are streamed instead of loaded.
+    UInt32 GetStreamThreshold() const;
     
 protected:
     // Disable creation from outside.
@@ -52,6 +66,7 @@ protected:
 
 private:
     std::map<String,SoundData*> mLoadedSounds;
+    UInt32                      mStreamThreshold;
     
     static SoundManager         mInstance;
 };
@@ -0,0 +1,316 @@
+/**
+ *  @file       SoundMixer.cpp
+ *  @brief      Sample conversion, resampling and mixing kernels of the software sound subsystem.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "SoundMixer.h"
+
+#include "Maths/Maths.h"
+#include "SystemInfo/SystemInfo.h"
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    #include <emmintrin.h>
+#endif
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Four samples, maps to an SSE register when enabled. Everything but the
+ *  final conversion to integers is SSE1, so only ToInt16() checks the cpu.
+ */
+class Sample4
+{
+public:
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    Sample4()
+    {
+    }
+
+    explicit Sample4( __m128 pValue ) : mValue(pValue)
+    {
+    }
+
+    explicit Sample4( Float pValue ) : mValue(_mm_set1_ps(pValue))
+    {
+    }
+
+    Sample4( Float p0, Float p1, Float p2, Float p3 ) : mValue(_mm_setr_ps(p0, p1, p2, p3))
+    {
+    }
+
+    static Sample4 Load( const Float* pValues )                         { return Sample4( _mm_loadu_ps(pValues) ); }
+    void Store( Float* pValues ) const                                  { _mm_storeu_ps( pValues, mValue ); }
+
+    Sample4 operator + ( const Sample4& pOther ) const                   { return Sample4( _mm_add_ps(mValue, pOther.mValue) ); }
+    Sample4 operator - ( const Sample4& pOther ) const                  { return Sample4( _mm_sub_ps(mValue, pOther.mValue) ); }
+    Sample4 operator * ( const Sample4& pOther ) const                  { return Sample4( _mm_mul_ps(mValue, pOther.mValue) ); }
+
+    //! (a0, b0, a1, b1)
+    static Sample4 InterleaveLow( const Sample4& pA, const Sample4& pB )    { return Sample4( _mm_unpacklo_ps(pA.mValue, pB.mValue) ); }
+    //! (a2, b2, a3, b3)
+    static Sample4 InterleaveHigh( const Sample4& pA, const Sample4& pB )   { return Sample4( _mm_unpackhi_ps(pA.mValue, pB.mValue) ); }
+
+    __m128  mValue;
+#else
+    Sample4()
+    {
+    }
+
+    explicit Sample4( Float pValue )
+    {
+        mValue[0] = mValue[1] = mValue[2] = mValue[3] = pValue;
+    }
+
+    Sample4( Float p0, Float p1, Float p2, Float p3 )
+    {
+        mValue[0] = p0;
+        mValue[1] = p1;
+        mValue[2] = p2;
+        mValue[3] = p3;
+    }
+
+    static Sample4 Load( const Float* pValues )                         { return Sample4( pValues[0], pValues[1], pValues[2], pValues[3] ); }
+    void Store( Float* pValues ) const                                  { memcpy( pValues, mValue, sizeof(mValue) ); }
+
+    Sample4 operator + ( const Sample4& pOther ) const                  { return Sample4( mValue[0] + pOther.mValue[0], mValue[1] + pOther.mValue[1], mValue[2] + pOther.mValue[2], mValue[3] + pOther.mValue[3] ); }
+    Sample4 operator - ( const Sample4& pOther ) const                  { return Sample4( mValue[0] - pOther.mValue[0], mValue[1] - pOther.mValue[1], mValue[2] - pOther.mValue[2], mValue[3] - pOther.mValue[3] ); }
+    Sample4 operator * ( const Sample4& pOther ) const                  { return Sample4( mValue[0] * pOther.mValue[0], mValue[1] * pOther.mValue[1], mValue[2] * pOther.mValue[2], mValue[3] * pOther.mValue[3] ); }
+
+    static Sample4 InterleaveLow( const Sample4& pA, const Sample4& pB )    { return Sample4( pA.mValue[0], pB.mValue[0], pA.mValue[1], pB.mValue[1] ); }
+    static Sample4 InterleaveHigh( const Sample4& pA, const Sample4& pB )   { return Sample4( pA.mValue[2], pB.mValue[2], pA.mValue[3], pB.mValue[3] ); }
+
+    Float   mValue[4];
+#endif
+};
+
+
+static const Float FRACTION_TO_FLOAT = 1.0f / SoundMixer::FRACTION_ONE;
+
+
+static inline Float Cubic( Float p0, Float p1, Float p2, Float p3, Float t )
+{
+    return p1 + 0.5f * t * (p2 - p0 + t * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3 + t * (3.0f * (p1 - p2) + p3 - p0)));
+}
+
+static inline Sample4 Cubic( const Sample4& p0, const Sample4& p1, const Sample4& p2, const Sample4& p3, const Sample4& t )
+{
+    const Sample4 half(0.5f), two(2.0f), three(3.0f), four(4.0f), five(5.0f);
+    return p1 + half * t * (p2 - p0 + t * (two * p0 - five * p1 + four * p2 - p3 + t * (three * (p1 - p2) + p3 - p0)));
+}
+
+
+void SoundMixer::Decode( const Byte* pSource, UInt32 pBitsPerSample, UInt32 pNbSamples, Float* pDest )
+{
+    if( pBitsPerSample == 8 )
+    {
+        for( UInt32 i = 0; i < pNbSamples; i++ )
+            pDest[i] = (Int32(pSource[i]) - 128) * (1.0f / 128.0f);
+    }
+    else
+    {
+        GD_ASSERT_M( pBitsPerSample == 16, "[SoundMixer::Decode] Only 8 and 16 bits samples are supported." );
+
+        const Int16* source = (const Int16*)pSource;
+        for( UInt32 i = 0; i < pNbSamples; i++ )
+            pDest[i] = source[i] * (1.0f / 32768.0f);
+    }
+}
+
+void SoundMixer::Resample( const Float* pSource, UInt32 pNbChannels, UInt32 pChannel, UInt32 pFraction, UInt32 pStep, 
+                           Interpolation pMode, Float* pDest, UInt32 pNbFrames )
+{
+    const Float* source = pSource + pChannel;
+    UInt32 i = 0;
+
+    // Same rate, the source is only deinterleaved.
+    if( pStep == FRACTION_ONE && pFraction == 0 )
+    {
+        for( ; i < pNbFrames; i++ )
+            pDest[i] = source[i * pNbChannels];
+        return;
+    }
+
+    UInt32 pos = pFraction;
+
+    if( pMode == Interpolation_Linear )
+    {
+        for( ; i + 4 <= pNbFrames; i += 4, pos += 4 * pStep )
+        {
+            const Float* s0 = source + ( pos              >> FRACTION_BITS) * pNbChannels;
+            const Float* s1 = source + ((pos +     pStep) >> FRACTION_BITS) * pNbChannels;
+            const Float* s2 = source + ((pos + 2 * pStep) >> FRACTION_BITS) * pNbChannels;
+            const Float* s3 = source + ((pos + 3 * pStep) >> FRACTION_BITS) * pNbChannels;
+
+            Sample4 a( s0[0], s1[0], s2[0], s3[0] );
+            Sample4 b( s0[pNbChannels], s1[pNbChannels], s2[pNbChannels], s3[pNbChannels] );
+            Sample4 t( ( pos              & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT,
+                       ((pos +     pStep) & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT,
+                       ((pos + 2 * pStep) & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT,
+                       ((pos + 3 * pStep) & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT );
+
+            (a + t * (b - a)).Store( pDest + i );
+        }
+
+        for( ; i < pNbFrames; i++, pos += pStep )
+        {
+            const Float* s = source + (pos >> FRACTION_BITS) * pNbChannels;
+            Float t = (pos & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT;
+            pDest[i] = s[0] + t * (s[pNbChannels] - s[0]);
+        }
+    }
+    else
+    {
+        const Int32 before = -Int32(pNbChannels);
+        const Int32 after  = 2 * pNbChannels;
+
+        for( ; i + 4 <= pNbFrames; i += 4, pos += 4 * pStep )
+        {
+            const Float* s0 = source + ( pos              >> FRACTION_BITS) * pNbChannels;
+            const Float* s1 = source + ((pos +     pStep) >> FRACTION_BITS) * pNbChannels;
+            const Float* s2 = source + ((pos + 2 * pStep) >> FRACTION_BITS) * pNbChannels;
+            const Float* s3 = source + ((pos + 3 * pStep) >> FRACTION_BITS) * pNbChannels;
+
+            Sample4 p0( s0[before], s1[before], s2[before], s3[before] );
+            Sample4 p1( s0[0], s1[0], s2[0], s3[0] );
+            Sample4 p2( s0[pNbChannels], s1[pNbChannels], s2[pNbChannels], s3[pNbChannels] );
+            Sample4 p3( s0[after], s1[after], s2[after], s3[after] );
+            Sample4 t( ( pos              & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT,
+                       ((pos +     pStep) & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT,
+                       ((pos + 2 * pStep) & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT,
+                       ((pos + 3 * pStep) & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT );
+
+            Cubic( p0, p1, p2, p3, t ).Store( pDest + i );
+        }
+
+        for( ; i < pNbFrames; i++, pos += pStep )
+        {
+            const Float* s = source + (pos >> FRACTION_BITS) * pNbChannels;
+            Float t = (pos & (FRACTION_ONE - 1)) * FRACTION_TO_FLOAT;
+            pDest[i] = Cubic( s[before], s[0], s[pNbChannels], s[after], t );
+        }
+    }
+}
+
+void SoundMixer::AccumulateMono( const Float* pSource, UInt32 pNbFrames, Float pGainLeft, Float pGainRight,
+                                 Float pGainStepLeft, Float pGainStepRight, Float* pMix )
+{
+    UInt32 i = 0;
+
+    Sample4 gainLow ( pGainLeft,                     pGainRight,                     pGainLeft + pGainStepLeft,     pGainRight + pGainStepRight );
+    Sample4 gainHigh( pGainLeft + 2 * pGainStepLeft, pGainRight + 2 * pGainStepRight, pGainLeft + 3 * pGainStepLeft, pGainRight + 3 * pGainStepRight );
+    Sample4 gainStep( 4 * pGainStepLeft, 4 * pGainStepRight, 4 * pGainStepLeft, 4 * pGainStepRight );
+
+    for( ; i + 4 <= pNbFrames; i += 4, pMix += 8 )
+    {
+        Sample4 samples = Sample4::Load( pSource + i );
+
+        (Sample4::Load( pMix )     + Sample4::InterleaveLow ( samples, samples ) * gainLow ).Store( pMix );
+        (Sample4::Load( pMix + 4 ) + Sample4::InterleaveHigh( samples, samples ) * gainHigh).Store( pMix + 4 );
+
+        gainLow  = gainLow  + gainStep;
+        gainHigh = gainHigh + gainStep;
+    }
+
+    pGainLeft  += i * pGainStepLeft;
+    pGainRight += i * pGainStepRight;
+
+    for( ; i < pNbFrames; i++, pMix += 2 )
+    {
+        pMix[0] += pSource[i] * pGainLeft;
+        pMix[1] += pSource[i] * pGainRight;
+
+        pGainLeft  += pGainStepLeft;
+        pGainRight += pGainStepRight;
+    }
+}
+
+void SoundMixer::AccumulateStereo( const Float* pLeft, const Float* pRight, UInt32 pNbFrames, Float pGainLeft, Float pGainRight,
+                                   Float pGainStepLeft, Float pGainStepRight, Float* pMix )
+{
+    UInt32 i = 0;
+
+    Sample4 gainLow ( pGainLeft,                     pGainRight,                     pGainLeft + pGainStepLeft,     pGainRight + pGainStepRight );
+    Sample4 gainHigh( pGainLeft + 2 * pGainStepLeft, pGainRight + 2 * pGainStepRight, pGainLeft + 3 * pGainStepLeft, pGainRight + 3 * pGainStepRight );
+    Sample4 gainStep( 4 * pGainStepLeft, 4 * pGainStepRight, 4 * pGainStepLeft, 4 * pGainStepRight );
+
+    for( ; i + 4 <= pNbFrames; i += 4, pMix += 8 )
+    {
+        Sample4 left  = Sample4::Load( pLeft + i );
+        Sample4 right = Sample4::Load( pRight + i );
+
+        (Sample4::Load( pMix )     + Sample4::InterleaveLow ( left, right ) * gainLow ).Store( pMix );
+        (Sample4::Load( pMix + 4 ) + Sample4::InterleaveHigh( left, right ) * gainHigh).Store( pMix + 4 );
+
+        gainLow  = gainLow  + gainStep;
+        gainHigh = gainHigh + gainStep;
+    }
+
+    pGainLeft  += i * pGainStepLeft;
+    pGainRight += i * pGainStepRight;
+
+    for( ; i < pNbFrames; i++, pMix += 2 )
+    {
+        pMix[0] += pLeft[i]  * pGainLeft;
+        pMix[1] += pRight[i] * pGainRight;
+
+        pGainLeft  += pGainStepLeft;
+        pGainRight += pGainStepRight;
+    }
+}
+
+void SoundMixer::ToInt16( const Float* pMix, UInt32 pNbSamples, Int16* pDest )
+{
+    UInt32 i = 0;
+
+#if GD_CFG_USE_SSE2 == GD_ENABLED
+    if( SystemInfo::Instance()->CpuSupportSSE2() )
+    {
+        const __m128 scale = _mm_set1_ps( 32767.0f );
+        const __m128 one   = _mm_set1_ps( 1.0f );
+        const __m128 minusOne = _mm_set1_ps( -1.0f );
+
+        for( ; i + 8 <= pNbSamples; i += 8 )
+        {
+            // Clamp first, out of range floats convert to 0x80000000.
+            __m128 low  = _mm_mul_ps( _mm_min_ps( _mm_max_ps( _mm_loadu_ps(pMix + i),     minusOne ), one ), scale );
+            __m128 high = _mm_mul_ps( _mm_min_ps( _mm_max_ps( _mm_loadu_ps(pMix + i + 4), minusOne ), one ), scale );
+
+            _mm_storeu_si128( (__m128i*)(pDest + i), _mm_packs_epi32( _mm_cvtps_epi32(low), _mm_cvtps_epi32(high) ) );
+        }
+    }
+#endif
+
+    for( ; i < pNbSamples; i++ )
+    {
+        Float value = pMix[i];
+        Maths::Clamp( value, -1.0f, 1.0f );
+        value *= 32767.0f;
+        pDest[i] = Int16( value >= 0.0f ? value + 0.5f : value - 0.5f );
+    }
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,99 @@
+/**
+ *  @file       SoundMixer.h
+ *  @brief      Sample conversion, resampling and mixing kernels of the software sound subsystem.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _SOUND_MIXER_H_
+#define     _SOUND_MIXER_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Low level operations of the software mixer. Samples are floats in [-1, 1],
+ *  the mix is interleaved stereo. The inner loops process four samples at a
+ *  time with SSE when GD_CFG_USE_SSE2 is enabled.
+ */
+class ENGINE_API SoundMixer
+{
+public:
+    enum Interpolation
+    {
+        Interpolation_Linear,   //!< Two source frames per output frame.
+        Interpolation_Cubic     //!< Catmull-Rom spline through four source frames.
+    };
+
+    static const UInt32 FRACTION_BITS   = 16;                   //!< Positions are fixed point, 16.16.
+    static const UInt32 FRACTION_ONE    = 1 << FRACTION_BITS;
+
+    //! Number of source frames before the current position that Resample() reads.
+    static const UInt32 FRAMES_BEFORE   = 1;
+    //! Number of source frames after the last position that Resample() reads.
+    static const UInt32 FRAMES_AFTER    = 2;
+
+public:
+    /**
+     *  Convert PCM samples to floats.
+     *  @param  pSource         The samples, unsigned 8 bits or signed 16 bits.
+     *  @param  pBitsPerSample  8 or 16.
+     *  @param  pNbSamples      Number of samples (frames * channels).
+     *  @param  pDest           Receives pNbSamples floats.
+     */
+    static void Decode( const Byte* pSource, UInt32 pBitsPerSample, UInt32 pNbSamples, Float* pDest );
+
+    /**
+     *  Resample one channel of interleaved frames.
+     *  @param  pSource     Frame at the integer part of the start position, 
+     *                      FRAMES_BEFORE frames before and FRAMES_AFTER frames after the last position must be readable.
+     *  @param  pNbChannels Number of interleaved channels of pSource.
+     *  @param  pChannel    Channel to resample.
+     *  @param  pFraction   Fractional part of the start position, in [0, FRACTION_ONE).
+     *  @param  pStep       Position increment per output frame, FRACTION_ONE plays at the source rate.
+     *  @param  pMode       Interpolation used between source frames.
+     *  @param  pDest       Receives pNbFrames samples.
+     *  @param  pNbFrames   Number of frames to output.
+     */
+    static void Resample( const Float* pSource, UInt32 pNbChannels, UInt32 pChannel, UInt32 pFraction, UInt32 pStep, 
+                          Interpolation pMode, Float* pDest, UInt32 pNbFrames );
+
+    /**
+     *  Add a mono signal to the stereo mix. The gains move linearly from their
+     *  start value by pGainStep per frame, to avoid clicks when they change.
+     */
+    static void AccumulateMono( const Float* pSource, UInt32 pNbFrames, Float pGainLeft, Float pGainRight,
+                                Float pGainStepLeft, Float pGainStepRight, Float* pMix );
+
+    //! Add a stereo signal, one array per channel, to the stereo mix. See AccumulateMono().
+    static void AccumulateStereo( const Float* pLeft, const Float* pRight, UInt32 pNbFrames, Float pGainLeft, Float pGainRight,
+                                  Float pGainStepLeft, Float pGainStepRight, Float* pMix );
+
+    //! Convert the mix to signed 16 bits samples, saturating the values out of [-1, 1].
+    static void ToInt16( const Float* pMix, UInt32 pNbSamples, Int16* pDest );
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _SOUND_MIXER_H_
@@ -0,0 +1,104 @@
+/**
+ *  @file       SoundSink.cpp
+ *  @brief      Destinations of the software sound subsystem output.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "SoundSink.h"
+
+#include "FileManager/FileManager.h"
+
+
+namespace Gamedesk {
+
+
+NullSoundSink::NullSoundSink()
+    : mNbFrames(0)
+{
+}
+
+void NullSoundSink::Write( const Int16* /*pFrames*/, UInt32 pNbFrames )
+{
+    mNbFrames += pNbFrames;
+}
+
+UInt64 NullSoundSink::GetNbFrames() const
+{
+    return mNbFrames;
+}
+
+
+WavFileSoundSink::WavFileSoundSink( const String& pFileName )
+    : mFileName(pFileName)
+    , mSampleRate(44100)
+{
+}
+
+void WavFileSoundSink::Open( UInt32 pSampleRate )
+{
+    mSampleRate = pSampleRate;
+    mSamples.clear();
+}
+
+void WavFileSoundSink::Close()
+{
+    Stream* stream = FileManager::CreateOutputStream( mFileName );
+    if( !stream )
+        return;
+
+    UInt32 dataSize       = mSamples.size() * sizeof(Int16);
+    UInt32 riffSize       = 4 + (8 + 16) + (8 + dataSize);
+    UInt32 formatSize     = 16;
+    UInt16 formatTag      = 1;      // PCM
+    UInt16 nbChannels     = 2;
+    UInt32 bytesPerSecond = mSampleRate * 4;
+    UInt16 blockAlign     = 4;
+    UInt16 bitsPerSample  = 16;
+
+    stream->Serialize( (void*)"RIFF", 4 );
+    *stream << riffSize;
+    stream->Serialize( (void*)"WAVE", 4 );
+
+    stream->Serialize( (void*)"fmt ", 4 );
+    *stream << formatSize << formatTag << nbChannels << mSampleRate << bytesPerSecond << blockAlign << bitsPerSample;
+
+    stream->Serialize( (void*)"data", 4 );
+    *stream << dataSize;
+    if( dataSize )
+        stream->Serialize( &mSamples[0], dataSize );
+
+    GD_DELETE(stream);
+}
+
+void WavFileSoundSink::Write( const Int16* pFrames, UInt32 pNbFrames )
+{
+    mSamples.insert( mSamples.end(), pFrames, pFrames + pNbFrames * 2 );
+}
+
+const Vector<Int16>& WavFileSoundSink::GetSamples() const
+{
+    return mSamples;
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,95 @@
+/**
+ *  @file       SoundSink.h
+ *  @brief      Destinations of the software sound subsystem output.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _SOUND_SINK_H_
+#define     _SOUND_SINK_H_
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Receives the mixed output of the SoftwareSoundSubsystem, 16 bits
+ *  interleaved stereo frames.
+ */
+class ENGINE_API SoundSink
+{
+public:
+    //! Destructor.
+    virtual ~SoundSink() {}
+
+    //! Called when the sound system starts.
+    virtual void Open( UInt32 /*pSampleRate*/ ) {}
+    //! Called when the sound system stops.
+    virtual void Close() {}
+
+    //! Output pNbFrames stereo frames.
+    virtual void Write( const Int16* pFrames, UInt32 pNbFrames ) = 0;
+};
+
+
+//! Discard the output, only count the frames.
+class ENGINE_API NullSoundSink : public SoundSink
+{
+public:
+    NullSoundSink();
+
+    virtual void Write( const Int16* pFrames, UInt32 pNbFrames );
+
+    //! Number of frames written since the creation of the sink.
+    UInt64 GetNbFrames() const;
+
+private:
+    UInt64  mNbFrames;
+};
+
+
+/**
+ *  Write the output to a 16 bits stereo WAV file. The frames are kept in
+ *  memory, the file is written when the sink is closed.
+ */
+class ENGINE_API WavFileSoundSink : public SoundSink
+{
+public:
+    WavFileSoundSink( const String& pFileName );
+
+    virtual void Open( UInt32 pSampleRate );
+    virtual void Close();
+    virtual void Write( const Int16* pFrames, UInt32 pNbFrames );
+
+    //! The samples written since Open().
+    const Vector<Int16>& GetSamples() const;
+
+private:
+    String          mFileName;
+    UInt32          mSampleRate;
+    Vector<Int16>   mSamples;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _SOUND_SINK_H_
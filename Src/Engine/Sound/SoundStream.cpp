@@ -0,0 +1,306 @@
+/**
+ *  @file       SoundStream.cpp
+ *  @brief      Sound data streamed from the file while it plays.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "SoundStream.h"
+
+#include "Thread/Thread.h"
+#include "Thread/Mutex.h"
+#include "Thread/Event.h"
+
+
+namespace Gamedesk {
+
+
+IMPLEMENT_CLASS(SoundStream);
+
+
+// Integral constants are initialized in the class, they still need a definition when bound to a reference (ex. Maths::Min).
+const UInt32 SoundStream::RING_SIZE;
+const UInt32 SoundStream::CHUNK_SIZE;
+
+
+/**
+ *  Background thread filling the ring buffer of every open stream. It's
+ *  started with the first stream and stopped with the last one.
+ */
+class SoundStreamThread : public Thread
+{
+public:
+    static const UInt32 FILL_PERIOD_MS = 10;
+
+    static void Add( SoundStream* pStream )
+    {
+        if( !mInstance )
+        {
+            mInstance = GD_NEW(SoundStreamThread, 0, "Engine::Sound::SoundStreamThread");
+            mInstance->Start( Thread::PriorityAboveNormal );
+        }
+
+        mInstance->mMutex.Lock();
+        mInstance->mStreams.push_back( pStream );
+        mInstance->mMutex.Unlock();
+    }
+
+    static void Remove( SoundStream* pStream )
+    {
+        if( !mInstance )
+            return;
+
+        mInstance->mMutex.Lock();
+        mInstance->mStreams.remove( pStream );
+        Bool isEmpty = mInstance->mStreams.empty();
+        mInstance->mMutex.Unlock();
+
+        if( isEmpty )
+        {
+            mInstance->mQuit.Set( 1 );
+            mInstance->mWakeUp.SetDone();
+            mInstance->WaitUntilStopped();
+
+            GD_DELETE(mInstance);
+            mInstance = NULL;
+        }
+    }
+
+    //! Keep the thread from filling the streams, while one of them is modified.
+    static void Lock()
+    {
+        if( mInstance )
+            mInstance->mMutex.Lock();
+    }
+
+    static void Unlock()
+    {
+        if( mInstance )
+            mInstance->mMutex.Unlock();
+    }
+
+    virtual void Run()
+    {
+        while( !mQuit.Get() )
+        {
+            mMutex.Lock();
+            for( List<SoundStream*>::iterator it = mStreams.begin(); it != mStreams.end(); ++it )
+                (*it)->Fill();
+            mMutex.Unlock();
+
+            mWakeUp.TryWait( FILL_PERIOD_MS );
+        }
+    }
+
+private:
+    SoundStreamThread() : mQuit(0)
+    {
+    }
+
+private:
+    Mutex                       mMutex;
+    Event                       mWakeUp;
+    AtomicInt32                 mQuit;
+    List<SoundStream*>          mStreams;
+
+    static SoundStreamThread*   mInstance;
+};
+
+SoundStreamThread* SoundStreamThread::mInstance = NULL;
+
+
+SoundStream::SoundStream()
+    : mPCMData(NULL)
+    , mPCMSize(0)
+    , mFilePos(0)
+    , mLooping(false)
+    , mWritten(0)
+    , mRead(0)
+    , mEndOfData(0)
+    , mNbUnderruns(0)
+{
+    mRing.resize( RING_SIZE );
+}
+
+SoundStream::~SoundStream()
+{
+    Close();
+}
+
+void SoundStream::Open(const String& pFileName, UInt32 pDataOffset, UInt32 pDataSize)
+{
+    Close();
+
+    SetFileName( pFileName );
+    mFile.Open( pFileName, true );
+
+    GD_ASSERT_M( pDataOffset <= mFile.GetSize(), "[SoundStream::Open] The sound data is past the end of the file!" );
+    mPCMData = mFile.GetMemory() + pDataOffset;
+    mPCMSize = Maths::Min( pDataSize, mFile.GetSize() - pDataOffset );
+
+    SetFileDataSize( mFile.GetSize() );
+    SetSoundDataSize( mPCMSize );
+    SetSoundDataOffset( pDataOffset );
+
+    mFilePos = 0;
+    mWritten.Set( 0 );
+    mRead.Set( 0 );
+    mEndOfData.Set( 0 );
+    mNbUnderruns = 0;
+
+    // Have data ready for the first Read().
+    Fill();
+
+    SoundStreamThread::Add( this );
+}
+
+void SoundStream::Close()
+{
+    if( !mPCMData )
+        return;
+
+    SoundStreamThread::Remove( this );
+
+    mFile.Close();
+    mPCMData = NULL;
+    mPCMSize = 0;
+}
+
+void SoundStream::SetLooping(Bool pLooping)
+{
+    SoundStreamThread::Lock();
+    mReadMutex.Lock();
+
+    mLooping = pLooping;
+
+    // The whole data is in the ring already, the streaming thread won't
+    // wrap around by itself anymore.
+    if( pLooping && mEndOfData.Get() && mPCMData )
+    {
+        mFilePos = 0;
+        mEndOfData.Set( 0 );
+        Fill();
+    }
+
+    mReadMutex.Unlock();
+    SoundStreamThread::Unlock();
+}
+
+Bool SoundStream::IsLooping() const
+{
+    return mLooping;
+}
+
+void SoundStream::Rewind()
+{
+    SoundStreamThread::Lock();
+    mReadMutex.Lock();
+
+    mFilePos = 0;
+    mWritten.Set( 0 );
+    mRead.Set( 0 );
+    mEndOfData.Set( 0 );
+
+    mReadMutex.Unlock();
+
+    if( mPCMData )
+        Fill();
+
+    SoundStreamThread::Unlock();
+}
+
+void SoundStream::Fill()
+{
+    while( !mEndOfData.Get() )
+    {
+        UInt32 used  = UInt32(mWritten.Get() - mRead.Get());
+        UInt32 space = RING_SIZE - used;
+        UInt32 size  = Maths::Min( Maths::Min( space, CHUNK_SIZE ), mPCMSize - mFilePos );
+
+        if( size == 0 )
+            break;
+
+        UInt32 ringPos   = UInt32(mWritten.Get()) & (RING_SIZE - 1);
+        UInt32 firstPart = Maths::Min( size, RING_SIZE - ringPos );
+
+        memcpy( &mRing[ringPos], mPCMData + mFilePos, firstPart );
+        memcpy( &mRing[0], mPCMData + mFilePos + firstPart, size - firstPart );
+
+        mFilePos += size;
+
+        // Publish the data before the end of stream flag.
+        mWritten.FetchAdd( size );
+
+        if( mFilePos == mPCMSize )
+        {
+            if( mLooping )
+                mFilePos = 0;
+            else
+                mEndOfData.Set( 1 );
+        }
+    }
+}
+
+UInt32 SoundStream::Read(Byte* pBuffer, UInt32 pSize)
+{
+    mReadMutex.Lock();
+
+    // Check the end of stream flag first, mWritten is final once it's set.
+    Bool   endOfData = mEndOfData.Get() != 0;
+    UInt32 available = UInt32(mWritten.Get() - mRead.Get());
+    UInt32 size      = Maths::Min( pSize, available );
+
+    UInt32 ringPos   = UInt32(mRead.Get()) & (RING_SIZE - 1);
+    UInt32 firstPart = Maths::Min( size, RING_SIZE - ringPos );
+
+    memcpy( pBuffer, &mRing[ringPos], firstPart );
+    memcpy( pBuffer + firstPart, &mRing[0], size - firstPart );
+
+    mRead.FetchAdd( size );
+
+    mReadMutex.Unlock();
+
+    if( size == pSize )
+        return size;
+
+    // Silence is 0x80 for 8 bit samples (unsigned), 0 for 16 bit samples.
+    memset( pBuffer + size, GetBitsPerSample() == 8 ? 0x80 : 0, pSize - size );
+
+    if( endOfData )
+        return size;
+
+    mNbUnderruns++;
+    return pSize;
+}
+
+Bool SoundStream::IsFinished() const
+{
+    return mEndOfData.Get() && mWritten.Get() == mRead.Get();
+}
+
+UInt32 SoundStream::GetNbUnderruns() const
+{
+    return mNbUnderruns;
+}
+
+
+} // namespace Gamedesk
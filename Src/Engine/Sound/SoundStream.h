@@ -0,0 +1,121 @@
+/**
+ *  @file       SoundStream.h
+ *  @brief      Sound data streamed from the file while it plays.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _SOUND_STREAM_H_
+#define     _SOUND_STREAM_H_
+
+
+#include "SoundData.h"
+#include "FileManager/MemoryFile.h"
+#include "Thread/Atomic.h"
+#include "Thread/Mutex.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Sound data read from the file while it plays, instead of being loaded at
+ *  once. A background thread copies the PCM data of the memory mapped file to
+ *  a ring buffer, one chunk at a time, and the sound subsystem pulls it with
+ *  Read() from its mixing thread. A stream has a single read position, each
+ *  playing sound needs its own.
+ */
+class ENGINE_API SoundStream : public SoundData
+{
+    DECLARE_CLASS(SoundStream, SoundData);
+
+public:
+    static const UInt32 RING_SIZE   = 256 * 1024;   //!< Must be a power of 2.
+    static const UInt32 CHUNK_SIZE  = 32 * 1024;    //!< Bytes copied from the file at once.
+
+public:
+    //! Constructor.
+    SoundStream();
+    //! Destructor.
+    virtual ~SoundStream();
+
+    /**
+     *  Map the file and start filling the ring buffer. The format of the
+     *  sound data (channels, sample rate, ...) must be set before.
+     *  @param  pFileName   The file name.
+     *  @param  pDataOffset Offset of the PCM data in the file.
+     *  @param  pDataSize   Size of the PCM data, in bytes.
+     */
+    void Open(const String& pFileName, UInt32 pDataOffset, UInt32 pDataSize);
+
+    //! Stop filling the ring buffer and unmap the file.
+    void Close();
+
+    //! Restart at the beginning of the PCM data once the end is reached, even if it was reached already.
+    void SetLooping(Bool pLooping);
+    //! Returns whether the stream loops or not.
+    Bool IsLooping() const;
+
+    //! Go back to the beginning of the PCM data.
+    void Rewind();
+
+    /**
+     *  Pull PCM data, called by the sound subsystem. It only waits for a
+     *  Rewind() or SetLooping() in progress: if the background thread is late,
+     *  the missing part is filled with silence.
+     *  @param  pBuffer Receives pSize bytes.
+     *  @param  pSize   Number of bytes wanted.
+     *  @return Number of bytes of sound copied, less than pSize only at the end of a non looping stream.
+     */
+    UInt32 Read(Byte* pBuffer, UInt32 pSize);
+
+    //! Returns true once all the data of a non looping stream was read.
+    Bool IsFinished() const;
+
+    //! Returns the number of Read() that had to output silence because the ring buffer was empty.
+    UInt32 GetNbUnderruns() const;
+
+private:
+    friend class SoundStreamThread;
+
+    //! Copy chunks of the file to the ring buffer until it's full, called by the streaming thread.
+    void Fill();
+
+private:
+    MemoryFile      mFile;
+    const Byte*     mPCMData;
+    UInt32          mPCMSize;
+    UInt32          mFilePos;       //!< Next byte of PCM data to copy, used by the streaming thread only.
+    volatile Bool   mLooping;
+
+    Vector<Byte>    mRing;
+    AtomicInt32     mWritten;       //!< Total bytes written to the ring, wraps around.
+    AtomicInt32     mRead;          //!< Total bytes read from the ring, wraps around.
+    AtomicInt32     mEndOfData;     //!< Set when the last byte of a non looping stream is in the ring.
+    UInt32          mNbUnderruns;
+    Mutex           mReadMutex;     //!< Keeps Read() out while the read position is reset.
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _SOUND_STREAM_H_
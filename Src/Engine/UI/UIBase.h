@@ -2,6 +2,7 @@
 #define     _UI_BASE_H_
 
 
+#include "Maths/Maths.h"
 #include "Maths/Vector2.h"
 #include "Graphic/Color4.h"
 
@@ -77,6 +78,27 @@ public:
     {
         return UIRect( mP1.x + pX1, mP1.y + pY1, mP2.x + pX2, mP2.y + pY2 );
     }
+
+    //! Intersection of both rects, empty if they don't overlap.
+    UIRect Intersect( const UIRect& pOther ) const
+    {
+        return UIRect( Maths::Max(mP1.x, pOther.mP1.x), Maths::Max(mP1.y, pOther.mP1.y), Maths::Min(mP2.x, pOther.mP2.x), Maths::Min(mP2.y, pOther.mP2.y) );
+    }
+
+    Bool IsEmpty() const
+    {
+        return mP2.x <= mP1.x || mP2.y <= mP1.y;
+    }
+
+    Bool operator == ( const UIRect& pOther ) const
+    {
+        return mP1 == pOther.mP1 && mP2 == pOther.mP2;
+    }
+
+    Bool operator != ( const UIRect& pOther ) const
+    {
+        return !(*this == pOther);
+    }
     
     UIScalar& Left()                { return mP1.x; }
     const UIScalar& Left() const    { return mP1.x; }
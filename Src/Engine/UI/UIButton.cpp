@@ -21,6 +21,7 @@ const String& UIButton::GetText() const
 void UIButton::SetText( const String& pText )
 {
     mText = pText;
+    Invalidate();
 }
 
 Bool UIButton::IsDown() const
@@ -31,6 +32,7 @@ Bool UIButton::IsDown() const
 void UIButton::SetDown( Bool pDown )
 {
     mIsDown = pDown;
+    Invalidate();
 }
 
 Bool UIButton::IsCheckable() const
@@ -49,23 +51,24 @@ Bool UIButton::IsChecked() const
 void UIButton::SetChecked( Bool pChecked )
 {
     mIsChecked = pChecked;
+    Invalidate();
 }
 
 Bool UIButton::EventMousePress( const UIMousePressEventArgs& pEventArgs )
 {
-    mIsDown = true;
+    SetDown( true );
     return Super::EventMousePress( pEventArgs );
 }
 
 Bool UIButton::EventMouseRelease( const UIMouseReleaseEventArgs& pEventArgs )
 {
-    mIsDown = false;
+    SetDown( false );
     return Super::EventMouseRelease( pEventArgs );
 }
 
 Bool UIButton::EventMouseLeave( const UIMouseLeaveEventArgs& pEventArgs )
 {
-    mIsDown = false;
+    SetDown( false );
     return Super::EventMouseLeave( pEventArgs );
 }
 
@@ -17,9 +17,12 @@ UIDefaultStyle::UIDefaultStyle()
 {
     mPalette = GetDefaultPalette();
 
-    mTex_ComboBoxCheck = Cast<Texture2D>(Texture2D::StaticClass()->AllocateNew("DefaultStyle_ComboBox"));
-    mTex_ComboBoxCheck->Create( Image(IMG_UICheckBox_Check), false );
-    mTex_ComboBoxCheck->Init();
+    Image imgCheckBoxCheck(IMG_UICheckBox_Check);
+
+    Vector<const Image*> images;
+    images.resize( Sprite_NUM );
+    images[Sprite_CheckBoxCheck] = &imgCheckBoxCheck;
+    mPainter->SetSprites( images, mSprites );
 }
 
 UIPalette UIDefaultStyle::GetDefaultPalette() const
@@ -197,7 +200,7 @@ void UIDefaultStyle::DrawCheckBox( UICheckBox* pCheckBox )
     if( pCheckBox->IsChecked() ) 
     {
         mPainter->SetBrush( borderColor );
-        mPainter->DrawTexture( UIPoint(rectCheck.Left() + 2, rectCheck.Bottom() + 2), mTex_ComboBoxCheck );
+        mPainter->DrawSprite( UIPoint(rectCheck.Left() + 2, rectCheck.Bottom() + 2), mSprites[Sprite_CheckBoxCheck] );
     }
 
     // Text!
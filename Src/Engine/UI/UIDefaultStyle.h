@@ -36,7 +36,13 @@ private:
     void DrawRoundedRect( const UIRect& pRect, const UIColor& pColor );
 
 private:
-    Texture2D*  mTex_ComboBoxCheck;
+    enum Sprite
+    {
+        Sprite_CheckBoxCheck,
+        Sprite_NUM
+    };
+
+    Vector<UISprite>    mSprites;   //!< Style bitmaps, packed in the painter atlas.
 };
 
 
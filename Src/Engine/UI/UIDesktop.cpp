@@ -70,9 +70,10 @@ void UIDesktop::UpdateLayout()
     {
         mRect = UIRect(0,0,viewWidth,viewHeight);
         SetFlags( Flag_ValidPos );
-
-        UIElement::UpdateLayout();
     }
+
+    // Returns right away when no element moved or changed its constraints.
+    UIElement::UpdateLayout();
 }
 
 void UIDesktop::Draw()
@@ -80,7 +81,7 @@ void UIDesktop::Draw()
     UpdateLayout();
 
     GetStyle().GetPainter().Begin();
-    UIElement::Draw();
+    UIWidget::Draw();
     GetStyle().GetPainter().End();
 }
 
@@ -121,6 +122,7 @@ void UIDesktop::OnMouseMove( Int32 /*pRelX*/, Int32 /*pRelY*/ )
             if( widget->HasFlags(Flag_MouseOver) )
             {
                 widget->ClearFlags(Flag_MouseOver);
+                widget->Invalidate();
                 widget->EventMouseLeave( UIMouseLeaveEventArgs(newMousePos) );
             }
         }
@@ -137,6 +139,7 @@ void UIDesktop::OnMouseMove( Int32 /*pRelX*/, Int32 /*pRelY*/ )
             if( !widget->HasFlags(Flag_MouseOver) )
             {
                 widget->SetFlags(Flag_MouseOver);
+                widget->Invalidate();
                 widget->EventMouseEnter( UIMouseEnterEventArgs(newMousePos) );
             }
         }
@@ -0,0 +1,143 @@
+/**
+ *  @file       UIDrawList.cpp
+ *  @brief      Triangles recorded by the UIPainter, grouped by texture.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "UIDrawList.h"
+
+
+namespace Gamedesk {
+
+
+void UIDrawList::Clear()
+{
+    mBatches.clear();
+    mPositions.clear();
+    mColors.clear();
+    mTexCoords.clear();
+}
+
+UIDrawList::Batch& UIDrawList::GetBatchFor( Texture* pTexture, UInt32 pNbVertices, const Vector2f& pMin, const Vector2f& pMax )
+{
+    if( mBatches.empty() || mBatches.back().mTexture != pTexture )
+    {
+        Batch batch;
+        batch.mTexture     = pTexture;
+        batch.mFirstVertex = mPositions.size();
+        batch.mNbVertices  = 0;
+        batch.mMin         = pMin;
+        batch.mMax         = pMax;
+        mBatches.push_back( batch );
+    }
+
+    Batch& batch = mBatches.back();
+    batch.mNbVertices += pNbVertices;
+    batch.mMin = Vector2f( Maths::Min(batch.mMin.x, pMin.x), Maths::Min(batch.mMin.y, pMin.y) );
+    batch.mMax = Vector2f( Maths::Max(batch.mMax.x, pMax.x), Maths::Max(batch.mMax.y, pMax.y) );
+    return batch;
+}
+
+void UIDrawList::AddQuad( Texture* pTexture, const Vector2f* pPositions, const UIColor* pColors, const Vector2f* pUVs )
+{
+    static const UInt32 QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+
+    // Quads are axis aligned, opposite corners bound them.
+    Vector2f min( Maths::Min(pPositions[0].x, pPositions[2].x), Maths::Min(pPositions[0].y, pPositions[2].y) );
+    Vector2f max( Maths::Max(pPositions[0].x, pPositions[2].x), Maths::Max(pPositions[0].y, pPositions[2].y) );
+    GetBatchFor( pTexture, 6, min, max );
+
+    for( UInt32 i = 0; i < 6; i++ )
+    {
+        UInt32 corner = QUAD_INDICES[i];
+        mPositions.push_back( Vector3f(pPositions[corner].x, pPositions[corner].y, 0.0f) );
+        mColors.push_back( pColors[corner] );
+        mTexCoords.push_back( pUVs[corner] );
+    }
+}
+
+void UIDrawList::Append( const UIDrawList& pOther, UInt32 pBatch )
+{
+    const Batch& batch = pOther.mBatches[pBatch];
+    UInt32 first = batch.mFirstVertex;
+    UInt32 last  = batch.mFirstVertex + batch.mNbVertices;
+
+    GetBatchFor( batch.mTexture, batch.mNbVertices, batch.mMin, batch.mMax );
+
+    mPositions.insert( mPositions.end(), pOther.mPositions.begin() + first, pOther.mPositions.begin() + last );
+    mColors.insert( mColors.end(), pOther.mColors.begin() + first, pOther.mColors.begin() + last );
+    mTexCoords.insert( mTexCoords.end(), pOther.mTexCoords.begin() + first, pOther.mTexCoords.begin() + last );
+}
+
+void UIDrawList::Compose( const Vector<BatchRef>& pBatches )
+{
+    // Batches of the same texture are gathered in groups, a group is bounded by its batches.
+    Vector<Batch>           groups;
+    Vector< Vector<UInt32> > groupBatches;
+
+    for( UInt32 i = 0; i < pBatches.size(); i++ )
+    {
+        const Batch& batch = pBatches[i].mList->GetBatch( pBatches[i].mBatch );
+
+        // Look back for a group of the same texture, a batch it overlaps must stay under it.
+        UInt32 group = groups.size();
+        for( UInt32 j = groups.size(); j > 0; j-- )
+        {
+            if( groups[j-1].mTexture == batch.mTexture )
+            {
+                group = j-1;
+                break;
+            }
+
+            if( groups[j-1].Overlaps( batch ) )
+                break;
+        }
+
+        if( group == groups.size() )
+        {
+            groups.push_back( batch );
+            groupBatches.push_back( Vector<UInt32>() );
+        }
+        else
+        {
+            Batch& bounds = groups[group];
+            bounds.mMin = Vector2f( Maths::Min(bounds.mMin.x, batch.mMin.x), Maths::Min(bounds.mMin.y, batch.mMin.y) );
+            bounds.mMax = Vector2f( Maths::Max(bounds.mMax.x, batch.mMax.x), Maths::Max(bounds.mMax.y, batch.mMax.y) );
+        }
+
+        groupBatches[group].push_back( i );
+    }
+
+    Clear();
+    for( UInt32 i = 0; i < groupBatches.size(); i++ )
+    {
+        for( UInt32 j = 0; j < groupBatches[i].size(); j++ )
+        {
+            const BatchRef& ref = pBatches[groupBatches[i][j]];
+            Append( *ref.mList, ref.mBatch );
+        }
+    }
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,123 @@
+/**
+ *  @file       UIDrawList.h
+ *  @brief      Triangles recorded by the UIPainter, grouped by texture.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _UI_DRAW_LIST_H_
+#define     _UI_DRAW_LIST_H_
+
+
+#include "Maths/Vector2.h"
+#include "Maths/Vector3.h"
+
+#include "UI/UIBase.h"
+
+
+namespace Gamedesk {
+
+
+class Texture;
+
+
+/**
+ *  Textured triangles, in painting order. Consecutive triangles sampling the
+ *  same texture share a batch, so a widget painted with the style atlas and
+ *  a font page holds two batches and is drawn with two draw calls.
+ *  Vertices are stored by component, ready to be copied in vertex buffers.
+ */
+class UIDrawList
+{
+public:
+    class Batch
+    {
+    public:
+        //! Test if the bounds of two batches intersect, touching edges don't.
+        Bool Overlaps( const Batch& pOther ) const
+        {
+            return mMin.x < pOther.mMax.x && pOther.mMin.x < mMax.x &&
+                   mMin.y < pOther.mMax.y && pOther.mMin.y < mMax.y;
+        }
+
+        Texture*    mTexture;
+        UInt32      mFirstVertex;
+        UInt32      mNbVertices;
+        Vector2f    mMin;       //!< Bounds of the triangles.
+        Vector2f    mMax;
+    };
+
+    //! A batch of another list.
+    class BatchRef
+    {
+    public:
+        const UIDrawList*   mList;
+        UInt32              mBatch;
+    };
+
+public:
+    //! Remove every triangle.
+    void Clear();
+
+    /**
+     *  Add a quad, as two triangles.
+     *  @param  pTexture    Texture sampled by the quad.
+     *  @param  pPositions  The 4 corners, counter clockwise.
+     *  @param  pColors     Color of each corner.
+     *  @param  pUVs        Texture coordinates of each corner.
+     */
+    void AddQuad( Texture* pTexture, const Vector2f* pPositions, const UIColor* pColors, const Vector2f* pUVs );
+
+    //! Append the triangles of a batch of another list.
+    void Append( const UIDrawList& pOther, UInt32 pBatch );
+
+    /**
+     *  Replace the triangles by the given batches, painted in order. A batch is
+     *  moved back next to the last batch sampling the same texture when it overlaps
+     *  none of the batches in between, so the result paints the same with fewer batches.
+     */
+    void Compose( const Vector<BatchRef>& pBatches );
+
+    Bool            IsEmpty() const             { return mBatches.empty();  }
+    UInt32          GetNbBatches() const        { return mBatches.size();   }
+    const Batch&    GetBatch( UInt32 pBatch ) const { return mBatches[pBatch]; }
+
+    UInt32          GetNbVertices() const       { return mPositions.size(); }
+    const Vector3f* GetPositions() const        { return &mPositions[0];    }
+    const UIColor*  GetColors() const           { return &mColors[0];       }
+    const Vector2f* GetTexCoords() const        { return &mTexCoords[0];    }
+
+private:
+    //! Get the batch receiving pNbVertices vertices sampling pTexture, bounded by pMin and pMax.
+    Batch& GetBatchFor( Texture* pTexture, UInt32 pNbVertices, const Vector2f& pMin, const Vector2f& pMax );
+
+private:
+    Vector<Batch>       mBatches;
+    Vector<Vector3f>    mPositions;
+    Vector<UIColor>     mColors;
+    Vector<Vector2f>    mTexCoords;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _UI_DRAW_LIST_H_
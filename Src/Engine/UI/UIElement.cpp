@@ -36,12 +36,17 @@ namespace Gamedesk {
 // UIElement
 UIElement::UIElement()
     : mParent(NULL)
+    , mRect(0,0,0,0)
+    , mLayoutRect(0,0,0,0)
     , mFlags(0)
 {
 }
 
 UIElement::UIElement( UIElement* pParent )
-    : mFlags(0)
+    : mParent(NULL)
+    , mRect(0,0,0,0)
+    , mLayoutRect(0,0,0,0)
+    , mFlags(0)
 {
     if( pParent )
         pParent->AddChild(this);
@@ -64,9 +69,24 @@ void UIElement::Draw()
 
 void UIElement::UpdateLayout()
 {
-    // Invalidate position/size
-    for( List<UIElement*>::iterator itChild = mChilds.begin(); itChild != mChilds.end(); ++itChild )
-        (*itChild)->ClearFlags( Flag_ValidPos );        
+    Bool movedSides[UI::Side_NUM];
+    Bool moved = false;
+
+    for( UInt32 side = 0; side < UI::Side_NUM; side++ )
+    {
+        movedSides[side] = mRect[side] != mLayoutRect[side];
+        moved = moved || movedSides[side];
+    }
+
+    // Nothing changed in this subtree.
+    if( !moved && !HasFlags(Flag_LayoutDirty) && !HasFlags(Flag_ChildLayoutDirty) )
+        return;
+
+    mLayoutRect = mRect;
+    ClearFlags( Flag_LayoutDirty | Flag_ChildLayoutDirty );
+
+    // Invalidate position/size of the children that depend on what changed.
+    InvalidateChildren( movedSides );
 
     UInt32 numResolved;
     do
@@ -101,9 +121,87 @@ void UIElement::UpdateLayout()
         // Only update if resolve was successful.
         if( (*itChild)->HasFlags(Flag_ValidPos) )
             (*itChild)->UpdateLayout();
+        else
+        {
+            // Keep Flag_LayoutDirty so the child and its subtree are laid out once it resolves,
+            // but let the invalidations of its descendants reach us meanwhile.
+            (*itChild)->ClearFlags( Flag_ChildLayoutDirty );
+        }
     }
 }
 
+void UIElement::InvalidateLayout()
+{
+    SetFlags( Flag_LayoutDirty );
+
+    for( UIElement* parent = mParent; parent != NULL && !parent->HasFlags(Flag_ChildLayoutDirty); parent = parent->mParent )
+        parent->SetFlags( Flag_ChildLayoutDirty );
+}
+
+void UIElement::InvalidateChildren( const Bool* pMovedSides )
+{
+    static const UI::Side AXES[] = { UI::Left, UI::Bottom };
+
+    // Each axis is resolved as a whole, invalidate it when one of its constraints
+    // leads to a moved side of this element or to an invalidated sibling.
+    UInt32 numInvalidated;
+    do
+    {
+        numInvalidated = 0;
+
+        for( List<UIElement*>::iterator itChild = mChilds.begin(); itChild != mChilds.end(); ++itChild )
+        {
+            UIElement* child = (*itChild);
+
+            for( UInt32 axis = 0; axis < 2; axis++ )
+            {
+                UI::Side side      = AXES[axis];
+                UI::Side otherSide = OppositeSide(side);
+                UInt32   axisFlags = SideToFlag(side) | SideToFlag(otherSide);
+
+                if( !child->HasFlags(axisFlags) )
+                {
+                    if( !child->IsResizable(side) )
+                        continue;
+
+                    // Resizable, the resizable siblings it is attached to share space with it.
+                    for( UInt32 i = 0; i < 2; i++ )
+                    {
+                        UIElement* attach = child->mConstraints[i == 0 ? side : otherSide].mAttach;
+                        if( attach != NULL && attach != this && attach != child && attach->mParent == this &&
+                            attach->HasFlags(axisFlags) && attach->IsResizable(side) )
+                        {
+                            attach->ClearFlags( axisFlags );
+                            numInvalidated++;
+                        }
+                    }
+                    continue;
+                }
+
+                if( child->HasFlags(Flag_LayoutDirty) || child->DependsOnInvalid(side, pMovedSides) || child->DependsOnInvalid(otherSide, pMovedSides) )
+                {
+                    child->ClearFlags( axisFlags );
+                    numInvalidated++;
+                }
+            }
+        }
+    } while( numInvalidated != 0 );
+}
+
+Bool UIElement::DependsOnInvalid( UI::Side pSide, const Bool* pMovedSides ) const
+{
+    const UIConstraint& constraint = mConstraints[pSide];
+
+    // Not attached, or attached to our own opposite side (which is on the same axis).
+    if( !constraint.IsValid() || constraint.mAttach == this )
+        return false;
+
+    if( constraint.mAttach == mParent )
+        return pMovedSides[constraint.mAttachSide];
+
+    return !constraint.mAttach->HasFlags( SideToFlag(constraint.mAttachSide) );
+}
+
 Bool UIElement::IsResizable( UI::Side pSide ) const
 {
     return mConstraints[pSide].mAttach != this && mConstraints[OppositeSide(pSide)].mAttach != this;
@@ -165,7 +263,13 @@ Bool UIElement::ResolveAttach( UI::Side pSide, UIScalar& pAttachPos, UIScalar& p
     if( IsResizable(pSide) && !pSecondPass )
         pNumResizableElements++;
 
-    if( !mConstraints[pSide].mAttach->ResolveAttach( pNumResizableElements > 0 ? pSide : mConstraints[pSide].mAttachSide, pAttachPos, pNumResizableElements, pSpace, pSecondPass ) )
+    // An attach already resolved gives its position directly, otherwise go through it
+    // (along its own side when it shares space with us).
+    UIElement* attach = mConstraints[pSide].mAttach;
+    UI::Side attachSide = mConstraints[pSide].mAttachSide;
+    if( attach->HasFlags(SideToFlag(attachSide)) )
+        pAttachPos = attach->mRect[attachSide];
+    else if( !attach->ResolveAttach( pNumResizableElements > 0 ? pSide : attachSide, pAttachPos, pNumResizableElements, pSpace, pSecondPass ) )
         return false;
 
     if( !pSecondPass && pNumResizableElements != 0 )
@@ -199,11 +303,26 @@ void UIElement::AddChild( UIElement* pWidget )
 {
     pWidget->mParent = this;
     mChilds.push_back(pWidget);
+
+    pWidget->InvalidateLayout();
 }
 
 void UIElement::RemoveChild( UIElement* pWidget )
 {
     mChilds.remove(pWidget);
+
+    // Siblings attached to the removed element must be resolved again.
+    for( List<UIElement*>::iterator itChild = mChilds.begin(); itChild != mChilds.end(); ++itChild )
+    {
+        for( UInt32 side = 0; side < UI::Side_NUM; side++ )
+        {
+            if( (*itChild)->mConstraints[side].mAttach == pWidget )
+            {
+                (*itChild)->InvalidateLayout();
+                break;
+            }
+        }
+    }
 }
 
 UIElement* UIElement::GetParent()
@@ -218,7 +337,12 @@ const UIElement* UIElement::GetParent() const
 
 void UIElement::SetWidth( UIScalar pWidth )
 {
-    if( !mConstraints[UI::Right].IsValid() )
+    // Width already set, change it.
+    if( mConstraints[UI::Right].mAttach == this )
+        mConstraints[UI::Right].mSpacing = pWidth;
+    else if( mConstraints[UI::Left].mAttach == this )
+        mConstraints[UI::Left].mSpacing = -pWidth;
+    else if( !mConstraints[UI::Right].IsValid() )
     {
         mConstraints[UI::Right].mAttach     = this;
         mConstraints[UI::Right].mAttachSide = UI::Left;
@@ -233,11 +357,18 @@ void UIElement::SetWidth( UIScalar pWidth )
 
     // Element is attached from both side, 
     // so Width is already specified indirectly.
+
+    InvalidateLayout();
 }
 
 void UIElement::SetHeight( UIScalar pHeight )
 {
-    if( !mConstraints[UI::Top].IsValid() )
+    // Height already set, change it.
+    if( mConstraints[UI::Top].mAttach == this )
+        mConstraints[UI::Top].mSpacing = pHeight;
+    else if( mConstraints[UI::Bottom].mAttach == this )
+        mConstraints[UI::Bottom].mSpacing = -pHeight;
+    else if( !mConstraints[UI::Top].IsValid() )
     {
         mConstraints[UI::Top].mAttach     = this;
         mConstraints[UI::Top].mAttachSide = UI::Bottom;
@@ -252,6 +383,8 @@ void UIElement::SetHeight( UIScalar pHeight )
 
     // Element is attached from both side, 
     // so Width is already specified indirectly.
+
+    InvalidateLayout();
 }
 
 void UIElement::SetSize( const UIPoint& pSize )
@@ -274,6 +407,8 @@ void UIElement::Attach( UI::Side pSide, UIElement* pAttach, UI::Side pAttachSide
     }
 
     mConstraints[pSide] = UIConstraint( pAttach, pAttachSide, pSpacing );
+
+    InvalidateLayout();
 }
 
 void UIElement::AttachParent( UI::Side pSide, UI::Side pAttachSide, UIScalar pSpacing )
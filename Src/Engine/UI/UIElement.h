@@ -35,7 +35,7 @@
 namespace Gamedesk {
 
 
-class UIElement
+class ENGINE_API UIElement
 {
     DECLARE_BASE_UI_CLASS(UIElement);
 
@@ -45,8 +45,18 @@ public:
     virtual ~UIElement();
 
     virtual void Draw();
+
+    /**
+     *  Resolve the constraints of the children, then lay them out recursively.
+     *  Only the children attached to a side that moved since the last layout, or
+     *  whose constraints changed, are resolved again. The others keep their
+     *  cached position, and subtrees that didn't move are skipped.
+     */
     virtual void UpdateLayout();
 
+    //! The constraints of this element changed, it will be resolved again by the next layout.
+    void InvalidateLayout();
+
     void AddChild( UIElement* pWidget );
     void RemoveChild( UIElement* pWidget );
 
@@ -78,6 +88,9 @@ protected:
 
     virtual void Paint() = 0;
     
+    void InvalidateChildren( const Bool* pMovedSides );
+    Bool DependsOnInvalid( UI::Side pSide, const Bool* pMovedSides ) const;
+
     Bool ResolveAttach( UI::Side pSide );
     Bool ResolveAttach( UI::Side pSide, UIScalar& pAttachPos, UIScalar& pNumResizableElements, UIScalar& pSpace, Bool pSecondPass );
 
@@ -101,7 +114,10 @@ protected:
         Flag_ValidRight         = 0x00000004,
         Flag_ValidTop           = 0x00000008,
         Flag_ValidPos           = Flag_ValidLeft | Flag_ValidRight | Flag_ValidTop | Flag_ValidBottom,
-        Flag_MouseOver          = 0x00000010
+        Flag_MouseOver          = 0x00000010,
+        Flag_Dirty              = 0x00000020,   //!< The widget must be painted again.
+        Flag_LayoutDirty        = 0x00000040,   //!< Constraints changed, the parent must resolve this element again.
+        Flag_ChildLayoutDirty   = 0x00000080    //!< A descendant has Flag_LayoutDirty.
     };
 
     class UIConstraint
@@ -128,6 +144,7 @@ protected:
     //! Constraints are used to update position and size automatically.
     UIConstraint            mConstraints[UI::Side_NUM]; 
     UIRect                  mRect;      //!< Computed using constraints, can't be set directly.
+    UIRect                  mLayoutRect; //!< mRect when the children were last laid out.
     UInt32                  mFlags;
 };
 
@@ -24,6 +24,7 @@ const String& UILabel::GetText() const
 void UILabel::SetText( const String& pText )
 {
     mText = pText;
+    Invalidate();
 }
 
 
@@ -4,6 +4,8 @@
 #include "Graphic/GraphicSubsystem.h"
 #include "Graphic/Renderer.h"
 #include "Graphic/Font/Font.h"
+#include "Graphic/Texture/Texture.h"
+#include "Graphic/Buffer/VertexBuffer.h"
 
 
 namespace Gamedesk {
@@ -43,17 +45,112 @@ void UIPen::MakeCurrent()
 
 ///////////////////////////////////////////////////////////////////////////////
 // UIPainter
+const UInt32 ATLAS_SIZE = 256;
+const UInt32 WHITE_SIZE = 4;
+
 UIPainter::UIPainter()
+    : mAtlas( ATLAS_SIZE, Image::Format_R8G8B8A8 )
+    , mWhiteTexture(NULL)
+    , mRecording(NULL)
+    , mNbRecordedLists(0)
+    , mNbDrawCalls(0)
+    , mBufPositions(NULL)
+    , mBufColors(NULL)
+    , mBufTexCoords(NULL)
 {
     mRenderer = GraphicSubsystem::Instance()->GetRenderer();
 
     mFont.mFont.GetFont( "Data\\Fonts\\Tahoma.ttf", 12 );
+
+    // Pack the white texel alone until the style gives its sprites.
+    Vector<const Image*> noImages;
+    Vector<UISprite>     noSprites;
+    SetSprites( noImages, noSprites );
+}
+
+UIPainter::~UIPainter()
+{
+    if( mBufPositions )
+    {
+        GD_DELETE(mBufPositions);
+        GD_DELETE(mBufColors);
+        GD_DELETE(mBufTexCoords);
+    }
+}
+
+void UIPainter::SetSprites( const Vector<const Image*>& pImages, Vector<UISprite>& pSprites )
+{
+    // The first image is a white square sampled by the untextured primitives.
+    Image white;
+    white.Create( WHITE_SIZE, WHITE_SIZE, Image::Format_R8G8B8A8 );
+    memset( white.GetData(), 0xFF, white.GetDataSize() );
+
+    Vector<const Image*> images;
+    images.push_back( &white );
+    images.insert( images.end(), pImages.begin(), pImages.end() );
+
+    Vector<PackedTexture::Info> infos;
+    mAtlas.BeginPacking();
+    mAtlas.InsertImages( images, infos );
+    mAtlas.EndPacking();
+
+    Float texelSize = 1.0f / Float(ATLAS_SIZE);
+
+    // Sample the center of the white square, linear filtering won't reach its neighbours.
+    mWhiteTexture = &mAtlas.GetTexture( infos[0].mTextureIndex );
+    mWhiteUV = Vector2f( (infos[0].mOffsetU + WHITE_SIZE/2) * texelSize, (infos[0].mOffsetV + WHITE_SIZE/2) * texelSize );
+
+    pSprites.resize( pImages.size() );
+    for( UInt32 i = 0; i < pImages.size(); i++ )
+    {
+        const PackedTexture::Info& info = infos[i+1];
+        GD_ASSERT_M( info.mValid, "[UIPainter::SetSprites] Image is larger than the atlas." );
+
+        UISprite& sprite = pSprites[i];
+        sprite.mTexture = &mAtlas.GetTexture( info.mTextureIndex );
+        sprite.mSize    = UIPoint( pImages[i]->GetWidth(), pImages[i]->GetHeight() );
+        sprite.mUVStart = Vector2f( info.mOffsetU * texelSize, info.mOffsetV * texelSize );
+        sprite.mUVEnd   = Vector2f( (info.mOffsetU + sprite.mSize.x) * texelSize, (info.mOffsetV + sprite.mSize.y) * texelSize );
+    }
 }
 
 void UIPainter::Begin()
 {
     Int32 viewport[4];
     mRenderer->GetViewport( viewport );
+
+    mClipRects.clear();
+    mClipRects.push_back( UIRect(viewport[0], viewport[1], viewport[2], viewport[3]) );
+
+    mQueue.clear();
+    mNbRecordedLists = 0;
+}
+
+void UIPainter::End()
+{
+    GD_ASSERT_M( mRecording == NULL, "[UIPainter::End] A draw list is still being recorded." );
+
+    // Merge again only when a list was recorded or the queue changed (widgets added, removed or culled).
+    Bool queueChanged = mQueue.size() != mLastQueue.size();
+    for( UInt32 i = 0; i < mQueue.size() && !queueChanged; i++ )
+    {
+        queueChanged = mQueue[i].mList  != mLastQueue[i].mList ||
+                       mQueue[i].mBatch != mLastQueue[i].mBatch;
+    }
+
+    if( queueChanged || mNbRecordedLists != 0 )
+    {
+        Compose();
+        Upload();
+        mLastQueue.swap( mQueue );
+    }
+
+    mNbDrawCalls = 0;
+    if( mFrameList.IsEmpty() )
+        return;
+
+    Int32 viewport[4];
+    mRenderer->GetViewport( viewport );
     mRenderer->Begin2DProjection( viewport[0], viewport[2], viewport[1], viewport[3], -1, 1 );
     mRenderer->SetRenderState( Renderer::Lighting, false );
     mRenderer->SetRenderState( Renderer::DepthTest, false );
@@ -61,10 +158,23 @@ void UIPainter::Begin()
 
     mRenderer->SetRenderState( Renderer::Blend, true );
     mRenderer->SetBlendFunc( Renderer::BlendSrcAlpha, Renderer::BlendInvSrcAlpha );
-}
 
-void UIPainter::End()
-{
+    mRenderer->SetVertexFormat( VertexFormat::Component(VertexFormat::Position3 | VertexFormat::Color4 | VertexFormat::TexCoord2) );
+    mRenderer->SetStreamSource( VertexFormat::Position3, mBufPositions );
+    mRenderer->SetStreamSource( VertexFormat::Color4,    mBufColors );
+    mRenderer->SetStreamSource( VertexFormat::TexCoord2, mBufTexCoords );
+
+    for( UInt32 i = 0; i < mFrameList.GetNbBatches(); i++ )
+    {
+        const UIDrawList::Batch& batch = mFrameList.GetBatch(i);
+
+        mRenderer->GetTextureStage(0)->SetTexture( *batch.mTexture );
+        mRenderer->DrawPrimitive( Renderer::TriangleList, batch.mFirstVertex, batch.mNbVertices );
+        mNbDrawCalls++;
+    }
+
+    mRenderer->GetTextureStage(0)->ResetTexture();
+
     mRenderer->End2DProjection();
     mRenderer->SetRenderState( Renderer::Lighting, true );
     mRenderer->SetRenderState( Renderer::DepthTest, true );
@@ -74,6 +184,169 @@ void UIPainter::End()
     mRenderer->SetRenderState( Renderer::Blend, false );
 }
 
+void UIPainter::BeginRecording( UIDrawList& pDrawList )
+{
+    GD_ASSERT_M( mRecording == NULL, "[UIPainter::BeginRecording] A draw list is already being recorded." );
+
+    mRecording = &pDrawList;
+    mRecording->Clear();
+    mNbRecordedLists++;
+}
+
+void UIPainter::EndRecording()
+{
+    mRecording = NULL;
+}
+
+void UIPainter::DrawList( const UIDrawList& pDrawList )
+{
+    for( UInt32 i = 0; i < pDrawList.GetNbBatches(); i++ )
+    {
+        UIDrawList::BatchRef ref;
+        ref.mList  = &pDrawList;
+        ref.mBatch = i;
+        mQueue.push_back( ref );
+    }
+}
+
+void UIPainter::Compose()
+{
+    mFrameList.Compose( mQueue );
+}
+
+void UIPainter::Upload()
+{
+    UInt32 nbVertices = mFrameList.GetNbVertices();
+    if( nbVertices == 0 )
+        return;
+
+    if( mBufPositions == NULL || mBufPositions->GetItemCount() < nbVertices )
+    {
+        if( mBufPositions )
+        {
+            GD_DELETE(mBufPositions);
+            GD_DELETE(mBufColors);
+            GD_DELETE(mBufTexCoords);
+        }
+
+        // Keep some room for widgets added later.
+        UInt32 capacity = nbVertices + nbVertices / 2;
+
+        mBufPositions = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
+        mBufPositions->Create( capacity, sizeof(Vector3f), VertexBuffer::Usage_Dynamic );
+
+        mBufColors = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
+        mBufColors->Create( capacity, sizeof(UIColor), VertexBuffer::Usage_Dynamic );
+
+        mBufTexCoords = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
+        mBufTexCoords->Create( capacity, sizeof(Vector2f), VertexBuffer::Usage_Dynamic );
+    }
+
+    void* data;
+
+    data = mBufPositions->Lock( VertexBuffer::Lock_Write );
+    if( data )
+        memcpy( data, mFrameList.GetPositions(), nbVertices * sizeof(Vector3f) );
+    mBufPositions->Unlock();
+
+    data = mBufColors->Lock( VertexBuffer::Lock_Write );
+    if( data )
+        memcpy( data, mFrameList.GetColors(), nbVertices * sizeof(UIColor) );
+    mBufColors->Unlock();
+
+    data = mBufTexCoords->Lock( VertexBuffer::Lock_Write );
+    if( data )
+        memcpy( data, mFrameList.GetTexCoords(), nbVertices * sizeof(Vector2f) );
+    mBufTexCoords->Unlock();
+}
+
+void UIPainter::AddRect( Texture* pTexture, Float pX1, Float pY1, Float pX2, Float pY2, const UIColor* pColors, const Vector2f* pUVs )
+{
+    GD_ASSERT_M( mRecording != NULL, "[UIPainter::AddRect] Painting outside of BeginRecording() / EndRecording()." );
+
+    const UIRect& clip = GetClipRect();
+    Float x1 = Maths::Max( pX1, Float(clip.mP1.x) );
+    Float y1 = Maths::Max( pY1, Float(clip.mP1.y) );
+    Float x2 = Maths::Min( pX2, Float(clip.mP2.x) );
+    Float y2 = Maths::Min( pY2, Float(clip.mP2.y) );
+
+    if( x1 >= x2 || y1 >= y2 )
+        return;
+
+    Vector2f positions[4] = { Vector2f(x1, y1), Vector2f(x2, y1), Vector2f(x2, y2), Vector2f(x1, y2) };
+
+    if( x1 == pX1 && y1 == pY1 && x2 == pX2 && y2 == pY2 )
+    {
+        mRecording->AddQuad( pTexture, positions, pColors, pUVs );
+        return;
+    }
+
+    // Clipped, interpolate the corner attributes at the new corners.
+    UIColor  colors[4];
+    Vector2f uvs[4];
+
+    for( UInt32 i = 0; i < 4; i++ )
+    {
+        Float s = (positions[i].x - pX1) / (pX2 - pX1);
+        Float t = (positions[i].y - pY1) / (pY2 - pY1);
+
+        colors[i] = (pColors[0] * (1 - s) + pColors[1] * s) * (1 - t) + (pColors[3] * (1 - s) + pColors[2] * s) * t;
+        uvs[i]    = (pUVs[0] * (1 - s) + pUVs[1] * s) * (1 - t) + (pUVs[3] * (1 - s) + pUVs[2] * s) * t;
+    }
+
+    mRecording->AddQuad( pTexture, positions, colors, uvs );
+}
+
+void UIPainter::AddRect( Float pX1, Float pY1, Float pX2, Float pY2, const UIColor& pColorStart, const UIColor& pColorEnd, Bool pHorizontal )
+{
+    UIColor  colors[4] = { pColorStart, pHorizontal ? pColorEnd : pColorStart, pColorEnd, pHorizontal ? pColorStart : pColorEnd };
+    Vector2f uvs[4]    = { mWhiteUV, mWhiteUV, mWhiteUV, mWhiteUV };
+
+    AddRect( mWhiteTexture, pX1, pY1, pX2, pY2, colors, uvs );
+}
+
+void UIPainter::AddLine( const UIPoint& pP1, const UIPoint& pP2, const UIColor& pColorStart, const UIColor& pColorEnd )
+{
+    Float width = mPen.GetLineWidth();
+    if( width <= 0 )
+        return;
+
+    // Both end points are covered, as in a line loop.
+    if( pP1.y == pP2.y )
+    {
+        if( pP1.x <= pP2.x )
+            AddRect( Float(pP1.x), Float(pP1.y), pP2.x + width, pP1.y + width, pColorStart, pColorEnd, true );
+        else
+            AddRect( Float(pP2.x), Float(pP2.y), pP1.x + width, pP2.y + width, pColorEnd, pColorStart, true );
+        return;
+    }
+
+    if( pP1.x == pP2.x )
+    {
+        if( pP1.y <= pP2.y )
+            AddRect( Float(pP1.x), Float(pP1.y), pP1.x + width, pP2.y + width, pColorStart, pColorEnd, false );
+        else
+            AddRect( Float(pP2.x), Float(pP2.y), pP2.x + width, pP1.y + width, pColorEnd, pColorStart, false );
+        return;
+    }
+
+    // Diagonal lines are rasterized with a square of the pen width per pixel.
+    // They are only used for small details, like rounded corners.
+    Int32 deltaX  = pP2.x - pP1.x;
+    Int32 deltaY  = pP2.y - pP1.y;
+    Int32 nbSteps = Maths::Max( abs(deltaX), abs(deltaY) );
+
+    for( Int32 i = 0; i <= nbSteps; i++ )
+    {
+        Float   t = Float(i) / Float(nbSteps);
+        Float   x = floor( pP1.x + deltaX * t + 0.5f );
+        Float   y = floor( pP1.y + deltaY * t + 0.5f );
+        UIColor color = pColorStart * (1 - t) + pColorEnd * t;
+
+        AddRect( x, y, x + width, y + width, color, color, true );
+    }
+}
+
 void UIPainter::DrawPoint( UIScalar pX, UIScalar pY )
 {
     DrawPoint( UIPoint(pX, pY) );
@@ -81,11 +354,7 @@ void UIPainter::DrawPoint( UIScalar pX, UIScalar pY )
 
 void UIPainter::DrawPoint( const UIPoint& pPoint )
 {
-    mPen.MakeCurrent();
-
-    mRenderer->BeginScene( Renderer::PointList );
-    mRenderer->SetVertex( pPoint );
-    mRenderer->EndScene();
+    AddLine( pPoint, pPoint, mPen.GetColor(), mPen.GetColor() );
 }
 
 void UIPainter::DrawPoints( const Vector<UIPoint>& pPoints )
@@ -97,14 +366,8 @@ void UIPainter::DrawPoints( const UIPoint* pPoints, UIScalar pCount )
 {
     GD_ASSERT( pCount > 0 );
 
-    mPen.MakeCurrent();
-
-    const UIPoint* point = pPoints;
-
-    mRenderer->BeginScene( Renderer::PointList );
-    for( Int32 i = 0; i < pCount; i++, point++ )
-        mRenderer->SetVertex( *point );
-    mRenderer->EndScene();
+    for( Int32 i = 0; i < pCount; i++ )
+        DrawPoint( pPoints[i] );
 }
 
 void UIPainter::DrawLine( UIScalar pLeft, UIScalar pBottom, UIScalar pRight, UIScalar pTop )
@@ -114,12 +377,7 @@ void UIPainter::DrawLine( UIScalar pLeft, UIScalar pBottom, UIScalar pRight, UIS
 
 void UIPainter::DrawLine( const UILine& pLine )
 {
-    mPen.MakeCurrent();
-
-    mRenderer->BeginScene( Renderer::LineList );
-    mRenderer->SetVertex( pLine.mP1 );
-    mRenderer->SetVertex( pLine.mP2 );
-    mRenderer->EndScene();
+    AddLine( pLine.mP1, pLine.mP2, mPen.GetColor(), mPen.GetColor() );
 }
 
 void UIPainter::DrawLineList( const Vector<UILine>& pLines )
@@ -129,17 +387,8 @@ void UIPainter::DrawLineList( const Vector<UILine>& pLines )
 
 void UIPainter::DrawLineList( const UILine* pLines, UIScalar pCount )
 {
-    mPen.MakeCurrent();
-
-    const UILine* line = pLines;
-
-    mRenderer->BeginScene( Renderer::LineList );
-    for( Int32 i = 0; i < pCount; i++, line++ )
-    {
-        mRenderer->SetVertex( line->mP1 );
-        mRenderer->SetVertex( line->mP2 );
-    }
-    mRenderer->EndScene();
+    for( Int32 i = 0; i < pCount; i++ )
+        DrawLine( pLines[i] );
 }
 
 void UIPainter::DrawLineLoop( const Vector<UIPoint>& pPoints )
@@ -150,95 +399,84 @@ void UIPainter::DrawLineLoop( const Vector<UIPoint>& pPoints )
 void UIPainter::DrawLineLoop( const UIPoint* pPoints, UIScalar pCount )
 {
     GD_ASSERT_M( pCount > 1, "[UIPainter::DrawLineLoop] Array must at least contain 2 points to form a line..." );
-    mPen.MakeCurrent();
 
-    const UIPoint* point = pPoints;
-
-    mRenderer->BeginScene( Renderer::LineLoop );
-    for( Int32 i = 0; i < pCount; i++, point++ )
-        mRenderer->SetVertex( *point );
-    mRenderer->EndScene();
+    for( Int32 i = 0; i < pCount; i++ )
+        AddLine( pPoints[i], pPoints[(i + 1) % pCount], mPen.GetColor(), mPen.GetColor() );
 }
 
 void UIPainter::DrawRect( const UIRect& pRect )
 {
-    UIScalar halfPenWidth = mPen.GetLineWidth()/2;
-    UIPoint P1 = pRect.mP1 + UIPoint(halfPenWidth, halfPenWidth);
-    UIPoint P2 = UIPoint(pRect.mP2.x - mPen.GetLineWidth(), pRect.mP1.y);
-    UIPoint P3 = pRect.mP2 - UIPoint(mPen.GetLineWidth(), mPen.GetLineWidth());
-    UIPoint P4 = UIPoint(pRect.mP1.x, pRect.mP2.y - mPen.GetLineWidth());
+    Float x1 = Float(pRect.mP1.x);
+    Float y1 = Float(pRect.mP1.y);
+    Float x2 = Float(pRect.mP2.x);
+    Float y2 = Float(pRect.mP2.y);
 
-    mBrush.MakeCurrent();
-    mRenderer->BeginScene( Renderer::TriangleFan );
-        mRenderer->SetVertex( P1 );
-        mRenderer->SetVertex( P2 );
-        mRenderer->SetVertex( P3 );
-        mRenderer->SetVertex( P4 );
-    mRenderer->EndScene();
-
-    if( mPen.GetStyle() != UIPen::STYLE_Empty )
-    {        
-        mPen.MakeCurrent();
-        mRenderer->BeginScene( Renderer::LineLoop );
-            mRenderer->SetVertex( P1 );
-            mRenderer->SetVertex( P2 );
-            mRenderer->SetVertex( P3 );
-            mRenderer->SetVertex( P4 );
-        mRenderer->EndScene();
+    // The outline is drawn inside the rect, the fill covers the remaining space.
+    Float penWidth = mPen.GetLineWidth();
+    if( penWidth > 0 )
+    {
+        const UIColor& color = mPen.GetColor();
+        AddRect( x1, y1, x2, y1 + penWidth, color, color, true );
+        AddRect( x1, y2 - penWidth, x2, y2, color, color, true );
+        AddRect( x1, y1 + penWidth, x1 + penWidth, y2 - penWidth, color, color, true );
+        AddRect( x2 - penWidth, y1 + penWidth, x2, y2 - penWidth, color, color, true );
     }
+
+    if( mBrush.GetStyle() != UIBrush::STYLE_Empty )
+        AddRect( x1 + penWidth, y1 + penWidth, x2 - penWidth, y2 - penWidth, mBrush.GetColor(), mBrush.GetColor(), true );
+}
+
+void UIPainter::DrawRects( const Vector<UIRect>& pRects )
+{
+    for( UInt32 i = 0; i < pRects.size(); i++ )
+        DrawRect( pRects[i] );
 }
 
 void UIPainter::DrawGradient( const UILine& pLine, const UIColor& pColorStart, const UIColor& pColorEnd )
 {
-    mRenderer->BeginScene( Renderer::LineList );
-        mRenderer->SetColor( pColorStart );
-        mRenderer->SetVertex( pLine.mP1 );
-        mRenderer->SetColor( pColorEnd );
-        mRenderer->SetVertex( pLine.mP2 );
-    mRenderer->EndScene();
+    AddLine( pLine.mP1, pLine.mP2, pColorStart, pColorEnd );
 }
 
 void UIPainter::DrawGradient( const UIRect& pRect, const UIColor& pColorStart, const UIColor& pColorEnd, UI::Direction pDirection )
 {
-    UIPoint P1 = pRect.mP1;
-    UIPoint P2 = UIPoint(pRect.mP2.x, pRect.mP1.y);
-    UIPoint P3 = pRect.mP2;
-    UIPoint P4 = UIPoint(pRect.mP1.x, pRect.mP2.y);
-
-    mRenderer->BeginScene( Renderer::TriangleFan );
-        
-        mRenderer->SetColor( pColorStart );
-        mRenderer->SetVertex( P1 );
-
-        if( pDirection & UI::Horizontal )
-            mRenderer->SetColor( pColorEnd );
-        mRenderer->SetVertex( P2 );
-        
-        mRenderer->SetColor( pColorEnd );
-        mRenderer->SetVertex( P3 );
-        
-        if( pDirection & UI::Horizontal )
-            mRenderer->SetColor( pColorStart );
-        mRenderer->SetVertex( P4 );
-    mRenderer->EndScene();
+    AddRect( Float(pRect.mP1.x), Float(pRect.mP1.y), Float(pRect.mP2.x), Float(pRect.mP2.y), pColorStart, pColorEnd, (pDirection & UI::Horizontal) != 0 );
 }
 
-void UIPainter::DrawRects( const Vector<UIRect>& /*pRects*/ )
+void UIPainter::DrawText( const String& pString, const UIPoint& pPos )
 {
-}
+    const Font*    font  = *mFont.mFont;
+    const UIColor& color = mPen.GetColor();
+    UIColor        colors[4] = { color, color, color, color };
 
+    Int32 penX = pPos.x;
+    Int32 penY = pPos.y;
 
+    for( UInt32 car = 0; car < pString.size(); ++car )
+    {
+        UInt32 character = (Byte)pString[car];
+        if( character < 32 )
+            continue;
 
-void UIPainter::DrawText( const String& pString, const UIPoint& pPos )
-{
-    mFont.mFont->DrawString( pPos.x, pPos.y, pString.c_str() );
-    mRenderer->SetRenderState( Renderer::Blend, true );
+        const Font::FontGlyph& glyph = font->GetGlyph( character );
+
+        Float x = Float(penX + glyph.draw_offset.x);
+        Float y = Float(penY + glyph.draw_offset.y);
+
+        // Same mapping as Renderer::Draw2DTile().
+        Vector2f uvs[4] = { Vector2f(glyph.uv_end.x,   glyph.uv_start.y),
+                            Vector2f(glyph.uv_start.x, glyph.uv_start.y),
+                            Vector2f(glyph.uv_start.x, glyph.uv_end.y),
+                            Vector2f(glyph.uv_end.x,   glyph.uv_end.y) };
+
+        AddRect( font->GetFontPage(glyph.texture), x, y, x + glyph.size.x, y + glyph.size.y, colors, uvs );
+
+        penX += glyph.advance.x;
+        penY += glyph.advance.y;
+    }
 }
 
 void UIPainter::DrawText( const String& pString, const UIRect& pRect, UIAlignment pAlignment )
 {
-    mPen.MakeCurrent();
-
     UIPoint stringSize = mFont.mFont->GetStringSize( pString.c_str() );
     
     UIScalar availableSpaceH = pRect.mP2.x - pRect.mP1.x;
@@ -260,9 +498,19 @@ void UIPainter::DrawText( const String& pString, const UIRect& pRect, UIAlignmen
     else
         pos.y = pRect.mP1.y + ((availableSpaceV - stringSize.y) >> 1);
 
-    mFont.mFont->DrawString( pos.x, pos.y, pString.c_str() );
+    DrawText( pString, pos );
+}
+
+void UIPainter::DrawSprite( const UIPoint& pPos, const UISprite& pSprite )
+{
+    const UIColor& color = mBrush.GetColor();
+    UIColor  colors[4] = { color, color, color, color };
+    Vector2f uvs[4]    = { Vector2f(pSprite.mUVStart.x, pSprite.mUVEnd.y),
+                           Vector2f(pSprite.mUVEnd.x,   pSprite.mUVEnd.y),
+                           Vector2f(pSprite.mUVEnd.x,   pSprite.mUVStart.y),
+                           Vector2f(pSprite.mUVStart.x, pSprite.mUVStart.y) };
 
-    mRenderer->SetRenderState( Renderer::Blend, true );
+    AddRect( pSprite.mTexture, Float(pPos.x), Float(pPos.y), Float(pPos.x + pSprite.mSize.x), Float(pPos.y + pSprite.mSize.y), colors, uvs );
 }
 
 void UIPainter::DrawTexture( const UIPoint& /*pPos*/, const HTexture1D& /*pTexture*/ )
@@ -280,24 +528,11 @@ void UIPainter::DrawTextureTiled( const UIRect& /*pDestRect*/, const HTexture1D&
 
 void UIPainter::DrawTexture( const UIPoint& pPos, Texture2D* pTexture )
 {
-    mRenderer->GetTextureStage(0)->SetTexture( *pTexture );
-
-    mBrush.MakeCurrent();
-    mRenderer->BeginScene( Renderer::TriangleFan );
-        mRenderer->SetUV( 0, 1 );
-        mRenderer->SetVertex( pPos );
+    const UIColor& color = mBrush.GetColor();
+    UIColor  colors[4] = { color, color, color, color };
+    Vector2f uvs[4]    = { Vector2f(0, 1), Vector2f(1, 1), Vector2f(1, 0), Vector2f(0, 0) };
 
-        mRenderer->SetUV( 1, 1 );
-        mRenderer->SetVertex( UIPoint(pPos.x + pTexture->GetWidth(), pPos.y) );
-
-        mRenderer->SetUV( 1, 0 );
-        mRenderer->SetVertex( UIPoint(pPos.x + pTexture->GetWidth(), pPos.y + pTexture->GetHeight()) );
-
-        mRenderer->SetUV( 0, 0 );
-        mRenderer->SetVertex( UIPoint(pPos.x, pPos.y + pTexture->GetHeight()) );
-    mRenderer->EndScene();
-
-    mRenderer->GetTextureStage(0)->ResetTexture();
+    AddRect( pTexture, Float(pPos.x), Float(pPos.y), Float(pPos.x + pTexture->GetWidth()), Float(pPos.y + pTexture->GetHeight()), colors, uvs );
 }
 
 void UIPainter::DrawTexture( const UIRect& /*pDestRect*/, const HTexture2D& /*pTexture*/, const UIRect& /*pSrcRect*/ )
@@ -343,17 +578,20 @@ void UIPainter::DrawElipse( const UIRect& /*pRect*/ )
 {
 }
 
-Bool UIPainter::IsVisible( const UIRect& /*pRect*/ )
+Bool UIPainter::IsVisible( const UIRect& pRect ) const
 {
-    return true;
+    return !GetClipRect().Intersect(pRect).IsEmpty();
 }
 
-void UIPainter::PushClipRect( const UIRect& /*pClipRect*/ )
+void UIPainter::PushClipRect( const UIRect& pClipRect )
 {
+    mClipRects.push_back( GetClipRect().Intersect(pClipRect) );
 }
 
 void UIPainter::PopClipRect()
 {
+    GD_ASSERT_M( mClipRects.size() > 1, "[UIPainter::PopClipRect] No clip rect pushed." );
+    mClipRects.pop_back();
 }
 
 
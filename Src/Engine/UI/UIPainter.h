@@ -7,13 +7,18 @@
 #include "Graphic/Image/Image.h"
 #include "Graphic/Texture/TextureHdl.h"
 #include "Graphic/Font/FontHdl.h"
+#include "Graphic/Texture/PackedTexture.h"
 
 #include "UI/UIBase.h"
+#include "UI/UIDrawList.h"
 
 
 namespace Gamedesk {
 
 
+class VertexBuffer;
+
+
 class UIGradient
 {
 public:
@@ -268,14 +273,58 @@ private:
 };
 
 
+//! Image packed in the painter atlas, see UIPainter::SetSprites().
+class UISprite
+{
+public:
+    Texture*    mTexture;
+    Vector2f    mUVStart;   //!< Texture coordinates of the top left corner.
+    Vector2f    mUVEnd;     //!< Texture coordinates of the bottom right corner.
+    UIPoint     mSize;
+};
+
+
+/**
+ *  Paint widgets in retained mode. The primitives are not drawn right away,
+ *  they are recorded as textured quads in the UIDrawList bound with
+ *  BeginRecording(), clipped to the current clip rect. Untextured primitives
+ *  sample a white texel of the painter atlas, so they end up in the same batch
+ *  as the style sprites and only text switches to a font page.
+ *
+ *  Every frame, the recorded lists are queued with DrawList() between Begin()
+ *  and End(), in painting order. End() merges the batches sampling the same
+ *  texture unless a batch queued in between overlaps them, see
+ *  UIDrawList::Compose(). The merged list is kept in vertex buffers until a
+ *  list is recorded again or the queue changes, so an idle UI costs one draw
+ *  call per texture, plus one per overlap forcing a texture switch.
+ */
 class UIPainter
 {
 public:
     UIPainter();
+    ~UIPainter();
 
+    //! Start a frame, the clip rect is reset to the viewport.
     void Begin();
+
+    //! Merge the draw lists queued since Begin() and draw them.
     void End();
 
+    //! Record the primitives painted until EndRecording() in pDrawList, which is cleared.
+    void BeginRecording( UIDrawList& pDrawList );
+    void EndRecording();
+
+    //! Queue a recorded list, it is drawn over the lists queued before it.
+    void DrawList( const UIDrawList& pDrawList );
+
+    /**
+     *  Pack images in the painter atlas. Lists recorded with sprites of a previous
+     *  call must be recorded again.
+     *  @param  pImages     Format_R8G8B8A8 images.
+     *  @param  pSprites    Receives the sprite of each image.
+     */
+    void SetSprites( const Vector<const Image*>& pImages, Vector<UISprite>& pSprites );
+
     void DrawPoint( UIScalar pX, UIScalar pY );
     void DrawPoint( const UIPoint& pPoint );
     void DrawPoints( const Vector<UIPoint>& pPoints );
@@ -297,6 +346,8 @@ public:
     void DrawText( const String& pString, const UIPoint& pPos );
     void DrawText( const String& pString, const UIRect& pRect, UIAlignment pAlignemnt );
 
+    void DrawSprite( const UIPoint& pPos, const UISprite& pSprite );
+
     void DrawTexture( const UIPoint& pPos, const HTexture1D& pTexture );
     void DrawTexture( const UIRect& pDestRect, const HTexture1D& pTexture, const UIRect& pSrcRect );
     void DrawTextureTiled( const UIRect& pDestRect, const HTexture1D& pTexture );
@@ -326,11 +377,36 @@ public:
     void SetFont( const UIFont& pFont )     { mFont = pFont; }
 
     //! Test if the given rect is visible taking into account clipping.
-    Bool IsVisible( const UIRect& pRect );
+    Bool IsVisible( const UIRect& pRect ) const;
 
+    //! Restrict painting to the intersection of pClipRect and the current clip rect.
     void PushClipRect( const UIRect& pClipRect );
     void PopClipRect();
 
+    const UIRect& GetClipRect() const       { return mClipRects.back(); }
+
+    //! Number of draw calls issued by the last End().
+    UInt32 GetNbDrawCalls() const           { return mNbDrawCalls; }
+
+    //! Number of lists recorded during the last frame.
+    UInt32 GetNbRecordedLists() const       { return mNbRecordedLists; }
+
+private:
+    /**
+     *  Add an axis aligned rect, clipped to the current clip rect.
+     *  Corner attributes are given in bottom left, bottom right, top right, top left order.
+     */
+    void AddRect( Texture* pTexture, Float pX1, Float pY1, Float pX2, Float pY2, const UIColor* pColors, const Vector2f* pUVs );
+
+    //! Add an untextured axis aligned rect.
+    void AddRect( Float pX1, Float pY1, Float pX2, Float pY2, const UIColor& pColorStart, const UIColor& pColorEnd, Bool pHorizontal );
+
+    //! Add a line of the pen width, rasterized as rects.
+    void AddLine( const UIPoint& pP1, const UIPoint& pP2, const UIColor& pColorStart, const UIColor& pColorEnd );
+
+    void Compose();
+    void Upload();
+
 private:
     class Renderer* mRenderer;
     UIFont          mFont;
@@ -338,6 +414,22 @@ private:
     UIPen           mPen;
 
     Vector<UIRect>  mClipRects;
+
+    PackedTexture   mAtlas;
+    Texture*        mWhiteTexture;
+    Vector2f        mWhiteUV;
+
+    UIDrawList*     mRecording;
+    UInt32          mNbRecordedLists;
+    UInt32          mNbDrawCalls;
+
+    Vector<UIDrawList::BatchRef> mQueue;
+    Vector<UIDrawList::BatchRef> mLastQueue;
+
+    UIDrawList      mFrameList;         //!< Batches of the queued lists, merged by texture.
+    VertexBuffer*   mBufPositions;
+    VertexBuffer*   mBufColors;
+    VertexBuffer*   mBufTexCoords;
 };
 
 
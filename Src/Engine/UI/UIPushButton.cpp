@@ -25,6 +25,7 @@ Bool UIPushButton::IsFlat() const
 void UIPushButton::SetFlat( Bool pFlat )
 {
     mIsFlat = pFlat;
+    Invalidate();
 }
 
 
@@ -10,11 +10,45 @@ namespace Gamedesk {
 UIWidget::UIWidget()
     : UIElement(NULL)
 {
+    SetFlags( Flag_Dirty );
 }
 
 UIWidget::UIWidget( UIElement* pParent )
     : UIElement(pParent)
 {
+    SetFlags( Flag_Dirty );
+}
+
+void UIWidget::Draw()
+{
+    UIPainter& painter = UIDesktop::Instance()->GetStyle().GetPainter();
+
+    // Children are inside their parent, the whole branch is clipped out.
+    if( !painter.IsVisible(mRect) )
+        return;
+
+    if( HasFlags(Flag_Dirty) || mDrawRect != mRect || mDrawClipRect != painter.GetClipRect() )
+    {
+        painter.BeginRecording( mDrawList );
+        Paint();
+        painter.EndRecording();
+
+        mDrawRect     = mRect;
+        mDrawClipRect = painter.GetClipRect();
+        ClearFlags( Flag_Dirty );
+    }
+
+    painter.DrawList( mDrawList );
+
+    painter.PushClipRect( mRect );
+    for( List<UIElement*>::iterator itChild = mChilds.begin(); itChild != mChilds.end(); ++itChild )
+        (*itChild)->Draw();
+    painter.PopClipRect();
+}
+
+void UIWidget::Invalidate()
+{
+    SetFlags( Flag_Dirty );
 }
 
 void UIWidget::Paint()
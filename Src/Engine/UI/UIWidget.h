@@ -3,6 +3,7 @@
 
 
 #include "UIElement.h"
+#include "UIDrawList.h"
 #include "Patterns/Delegate.h"
 
 
@@ -217,6 +218,12 @@ public:
 
     Bool IsMouseOver() const;
 
+    //! Paint the widget if it was invalidated, then queue its draw list and draw its children.
+    virtual void Draw();
+
+    //! The widget will be painted again before the next draw.
+    void Invalidate();
+
     ChildIterator BeginChilds()            {   return ChildIterator( mChilds.begin(), this );    }
     ConstChildIterator BeginChilds() const {   return ConstChildIterator( mChilds.begin(), this );    }
 
@@ -234,6 +241,10 @@ protected:
 private:
     Bool mEnabled;
     Bool mVisible;
+
+    UIDrawList  mDrawList;      //!< Primitives painted the last time the widget was invalidated.
+    UIRect      mDrawRect;      //!< Rect of the widget when mDrawList was recorded.
+    UIRect      mDrawClipRect;  //!< Clip rect when mDrawList was recorded.
 };
 
 
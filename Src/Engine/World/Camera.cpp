@@ -122,6 +122,7 @@ void Camera::Pitch(Float pAngle)
    
     mRight = mView cross mUp;
     mRight.Normalize();
+    MarkDirty();
 }
 
 void Camera::Yaw(Float pAngle)
@@ -133,6 +134,7 @@ void Camera::Yaw(Float pAngle)
         
     mView.Normalize();
     mRight.Normalize();
+    MarkDirty();
 }
 
 void Camera::Roll(Float /*pAngle*/)
@@ -143,21 +145,25 @@ void Camera::Roll(Float /*pAngle*/)
 void Camera::Move(Float pMovement)
 {
     mPosition += mView * pMovement;
+    MarkDirty();
 }
 
 void Camera::PanLeftRight(Float pMovement)
 {
 	mPosition += mRight * pMovement;
+	MarkDirty();
 }
 
 void Camera::PanUpDown(Float pMovement)
 {
 	mPosition += mUp * pMovement;
+	MarkDirty();
 }
 
 void Camera::SetFovAngle(Float pAngle)
 {
     mFovAngle = pAngle;
+    MarkDirty();
 }
 
 Float Camera::GetFovAngle() const 
@@ -168,6 +174,7 @@ Float Camera::GetFovAngle() const
 void Camera::SetFarView(Float pFarView)
 {
 	mFarView = pFarView;
+	MarkDirty();
 }
 
 Float Camera::GetFarView() const
@@ -178,6 +185,7 @@ Float Camera::GetFarView() const
 void Camera::SetNearView(Float pNearView)
 {
 	mNearView = pNearView;
+	MarkDirty();
 }
 
 Float Camera::GetNearView() const
@@ -286,15 +294,13 @@ void Camera::LookAt( const Vector3f& pLookAtPos )
 
      mRight = mUp cross mView;
      mRight.Normalize();
+     MarkDirty();
 }
 
 void Camera::Serialize( Stream& pStream )
 {
     Super::Serialize( pStream );
-
-    pStream << mFovAngle;
-    pStream << mFarView;
-    pStream << mNearView;
+    SerializeProperties( pStream );
 
     pStream << mView;
     pStream << mUp;
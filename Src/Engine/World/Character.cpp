@@ -108,6 +108,7 @@ void Character::Update( Double pElapsedTime )
     mViewDirection.x = Maths::Cos(mRotationAngle);
     mViewDirection.z = Maths::Sin(mRotationAngle);
     mOrientation = Quaternionf(Vector3f(0,1,0), mRotationAngle);
+    MarkDirty();
 }
 
 void Character::Render() const
@@ -82,6 +82,7 @@ void Entity::RenderSelected() const
 void Entity::SetPosition(const Vector3f& pPosition)
 {
     mPosition = pPosition;
+    MarkDirty();
 }
 
 const Vector3f& Entity::GetPosition() const
@@ -92,6 +93,7 @@ const Vector3f& Entity::GetPosition() const
 void Entity::SetOrientation(const Quaternionf& pOrientation)
 {
     mOrientation = pOrientation;
+    MarkDirty();
 }
 
 const Quaternionf& Entity::GetOrientation() const
@@ -107,9 +109,8 @@ const BoundingBox& Entity::GetBoundingBox() const
 void Entity::Serialize( Stream& pStream )
 {
     Super::Serialize( pStream );
+    SerializeProperties( pStream );
 
-    pStream << mPosition;
-    pStream << mOrientation;
     pStream << mBoundingBox;
     pStream << mSelected;
 }
@@ -112,6 +112,7 @@ public:
     void Select( Bool pSelect )
     {
         mSelected = pSelect;
+        MarkDirty();
     }
 
     virtual void Serialize( Stream& pStream );
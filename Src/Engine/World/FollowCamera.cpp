@@ -87,6 +87,7 @@ void FollowCamera::SetFollowedEntity(Entity* pEntity)
 void FollowCamera::SetSpringForce(Float pSpringForce)
 {
     mSpringForce = pSpringForce;
+    MarkDirty();
 }
 
 Float FollowCamera::GetSpringForce() const
@@ -97,6 +98,7 @@ Float FollowCamera::GetSpringForce() const
 void FollowCamera::SetFollowDistance(Float pFollowDistance)
 {
     mFollowDistance = pFollowDistance;
+    MarkDirty();
 }
 
 Float FollowCamera::GetFollowDistance() const
@@ -107,6 +109,7 @@ Float FollowCamera::GetFollowDistance() const
 void FollowCamera::SetUpOffset(Float pUpOffset)
 {
     mUpOffset = pUpOffset;
+    MarkDirty();
 }
 
 Float FollowCamera::GetUpOffset() const
@@ -114,5 +117,11 @@ Float FollowCamera::GetUpOffset() const
     return mUpOffset;
 }
 
+void FollowCamera::Serialize( Stream& pStream )
+{
+    Super::Serialize( pStream );
+    SerializeProperties( pStream );
+}
+
 
 } // namespace Gamedesk
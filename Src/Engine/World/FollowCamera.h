@@ -77,6 +77,8 @@ public:
     //! Get the up offset.
     Float GetUpOffset() const;
 
+    virtual void Serialize( Stream& pStream );
+
 properties:
     /**
     * @name    Spring Force
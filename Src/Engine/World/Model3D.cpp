@@ -28,6 +28,7 @@
 #include "Engine.h"
 #include "Model3D.h"
 #include "Graphic/Mesh/Mesh.h"
+#include "Graphic/Mesh/SkeletalMesh.h"
 #include "Graphic/Renderer.h"
 #include "Graphic/GraphicSubsystem.h"
 
@@ -52,11 +53,22 @@ void Model3D::Update( Double pElapsedTime )
 {
     if(mMesh)
     {
-        (*mMesh)->Update(pElapsedTime);
-        mBoundingBox = (*mMesh)->GetBoundingBox();
+        // Skeletal meshes are animated in batch by World::UpdateAnimations(),
+        // which updates the bounding box once they are skinned.
+        if( !(*mMesh)->IsA(SkeletalMesh::StaticClass()) )
+        {
+            (*mMesh)->Update(pElapsedTime);
+            UpdateBoundingBox();
+        }
     }
 }
 
+void Model3D::UpdateBoundingBox()
+{
+    if(mMesh)
+        mBoundingBox = (*mMesh)->GetBoundingBox();
+}
+
 void Model3D::Render() const
 {
     Renderer* renderer = GraphicSubsystem::Instance()->GetRenderer();
@@ -74,6 +86,11 @@ void Model3D::SetMesh(const String& pMeshFileName)
 	mBoundingBox = (*mMesh)->GetBoundingBox();
 }
 
+Mesh* Model3D::GetMesh() const
+{
+    return mMesh ? *mMesh : NULL;
+}
+
 Bool Model3D::LineCheck( const Ray3f& pRay ) const
 {
     if( mMesh )
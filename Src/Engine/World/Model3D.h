@@ -58,11 +58,17 @@ public:
     //! Update the model (in case it is animated).
     virtual void Update( Double pElapsedTime );
 
+    //! Take the bounding box of the mesh, once it has been animated.
+    void UpdateBoundingBox();
+
     //! Render the model.
     virtual void Render() const;
 	
     void SetMesh( const String& pMeshFileName );
 
+    //! Returns the mesh used by this model, NULL if none.
+    Mesh* GetMesh() const;
+
     Bool LineCheck( const Ray3f& pRay ) const;
 
 private:
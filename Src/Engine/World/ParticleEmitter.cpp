@@ -42,6 +42,7 @@ IMPLEMENT_CLASS(ParticleEmitter);
 
 
 ParticleEmitter::ParticleEmitter()
+    : mParticlePool(sizeof(Particle), 256, "Engine::World::ParticleEmitter")
 {
     mParticleCount      = 0;
 
@@ -79,7 +80,7 @@ ParticleEmitter::ParticleEmitter()
     Particle* particle;
     for( UInt32 i = 0; i < mMaxParticleCount; i++ )
     {
-        particle = GD_NEW(Particle, this, "Engine::World::ParticleEmitter");
+        particle = GD_NEW_IN(mParticlePool, Particle);
         particle->mDead = true;
 
         mParticles.push_back(particle);
@@ -92,7 +93,7 @@ ParticleEmitter::~ParticleEmitter()
     List<Particle*>::iterator itPart;
     for( itPart = mParticles.begin(); itPart != mParticles.end(); ++itPart )
     {
-        GD_DELETE(*itPart);
+        GD_DELETE_IN(mParticlePool, *itPart);
     }
 }
 
@@ -327,6 +328,7 @@ void ParticleEmitter::RenderSelected() const
 void ParticleEmitter::SetBirthrate( UInt32 pBirthrate )
 {
     mBirthrate = pBirthrate;
+    MarkDirty();
 }
 UInt32 ParticleEmitter::GetBirthrate() const
 {
@@ -336,6 +338,7 @@ UInt32 ParticleEmitter::GetBirthrate() const
 void ParticleEmitter::SetLife( Float pLife )
 {
     mLife = pLife;
+    MarkDirty();
 }
 Float ParticleEmitter::GetLife() const
 {
@@ -345,6 +348,7 @@ Float ParticleEmitter::GetLife() const
 void ParticleEmitter::SetLifeRand( Float pLifeRand )
 {
     mLifeRand = pLifeRand;
+    MarkDirty();
 }
 Float ParticleEmitter::GetLifeRand() const
 {
@@ -354,10 +358,12 @@ Float ParticleEmitter::GetLifeRand() const
 void ParticleEmitter::SetSizeStart( Float pSizeStart )
 {
     mSizeStart = pSizeStart;
+    MarkDirty();
 }
 void ParticleEmitter::SetSizeStartRand( Float pSizeStartRand )
 {
     mSizeStartRand = pSizeStartRand;
+    MarkDirty();
 }
 Float ParticleEmitter::GetSizeStart() const
 {
@@ -372,6 +378,7 @@ Float ParticleEmitter::GetSizeStartRand() const
 void ParticleEmitter::SetGravity( const Vector3f& pGravity )
 {
     mGravity = pGravity;
+    MarkDirty();
 }
 
 const Vector3f& ParticleEmitter::GetGravity() const
@@ -383,10 +390,12 @@ const Vector3f& ParticleEmitter::GetGravity() const
 void ParticleEmitter::SetSizeEnd( Float pSizeEnd )
 {
     mSizeEnd = pSizeEnd;
+    MarkDirty();
 }
 void ParticleEmitter::SetSizeEndRand( Float pSizeEndRand )
 {
     mSizeEndRand = pSizeEndRand;
+    MarkDirty();
 }
 Float ParticleEmitter::GetSizeEnd() const
 {
@@ -400,6 +409,7 @@ Float ParticleEmitter::GetSizeEndRand() const
 void ParticleEmitter::SetColorStart( const Color4f& pColorStart )
 {
     mColorStart = pColorStart;
+    MarkDirty();
 }
 const Color4f& ParticleEmitter::GetColorStart() const
 {
@@ -409,6 +419,7 @@ const Color4f& ParticleEmitter::GetColorStart() const
 void ParticleEmitter::SetColorEnd( const Color4f& pColorEnd )
 {
     mColorEnd = pColorEnd;
+    MarkDirty();
 }
 const Color4f& ParticleEmitter::GetColorEnd() const
 {
@@ -418,6 +429,7 @@ const Color4f& ParticleEmitter::GetColorEnd() const
 void ParticleEmitter::SetInitialSpeed( Float pSpeed )
 {
     mInitialSpeed = pSpeed;
+    MarkDirty();
 }
 Float ParticleEmitter::GetInitialSpeed() const
 {
@@ -426,6 +438,7 @@ Float ParticleEmitter::GetInitialSpeed() const
 void ParticleEmitter::SetInitialSpeedRand( Float pSpeedRand )
 {
     mInitialSpeedRand = pSpeedRand;
+    MarkDirty();
 }
 Float ParticleEmitter::GetInitialSpeedRand() const
 {
@@ -435,6 +448,7 @@ Float ParticleEmitter::GetInitialSpeedRand() const
 void ParticleEmitter::SetAccel( Float pAccel )
 {
     mAccel = pAccel;
+    MarkDirty();
 }
 Float ParticleEmitter::GetAccel() const
 {
@@ -444,6 +458,7 @@ Float ParticleEmitter::GetAccel() const
 void ParticleEmitter::SetEmissionConeAngle( UInt32 pConeAngle )
 {
     mEmissionConeAngle = pConeAngle;
+    MarkDirty();
 }
 
 UInt32 ParticleEmitter::GetEmissionConeAngle() const
@@ -459,7 +474,7 @@ void ParticleEmitter::SetMaxParticleCount( UInt32 pMaxParticleCount )
         {
             Particle* particle;
        
-            particle = GD_NEW(Particle, this, "Engine::World::ParticleEmitter");
+            particle = GD_NEW_IN(mParticlePool, Particle);
             particle->mDead = true;
 
             mParticles.push_back(particle);
@@ -480,10 +495,12 @@ void ParticleEmitter::SetMaxParticleCount( UInt32 pMaxParticleCount )
             else
                 mParticleCount--;
 
-            GD_DELETE(particle);
+            GD_DELETE_IN(mParticlePool, particle);
             mMaxParticleCount--;
         }
     }
+
+    MarkDirty();
 }
 
 
@@ -495,6 +512,7 @@ UInt32 ParticleEmitter::GetMaxParticleCount() const
 void ParticleEmitter::Serialize( Stream& pStream )
 {
     Super::Serialize( pStream );
+    SerializeProperties( pStream );
 
     UInt32 num = mParticles.size();
     pStream << num;
@@ -36,6 +36,7 @@
 #include "Graphic/Color4.h"
 
 #include "Graphic/Texture/TextureHdl.h"
+#include "Memory/PoolAllocator.h"
 
 
 namespace Gamedesk {
@@ -224,6 +225,7 @@ private:
     Vector3f GetRandomVectorFromDir( const Vector3f& dir, Float angle );
 
 private:
+    PoolAllocator      mParticlePool;
     List<Particle*>    mParticles;
     List<Particle*>    mDeadParticles;
     
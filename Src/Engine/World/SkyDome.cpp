@@ -188,6 +188,7 @@ void SkyDome::SetTexture(const String& pTextureName)
     mTexture.GetTexture( mTextureName );
     mTexture->SetWrapMode( Texture::Wrap_S, Texture::Wrap_Repeat );
     mTexture->SetWrapMode( Texture::Wrap_T, Texture::Wrap_Clamp );
+    MarkDirty();
 }
 
 const String& SkyDome::GetTextureName() const
@@ -195,6 +196,15 @@ const String& SkyDome::GetTextureName() const
     return mTextureName;
 }
 
+void SkyDome::Serialize( Stream& pStream )
+{
+    Super::Serialize( pStream );
+    SerializeProperties( pStream );
+
+    if( pStream.In() )
+        SetTexture( mTextureName );
+}
+
 IMPLEMENT_CLASS(SkyDome);
 
 
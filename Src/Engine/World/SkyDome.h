@@ -58,6 +58,8 @@ public:
     void SetTexture(const String& pTextureName);
     const String& GetTextureName() const;
 
+    virtual void Serialize( Stream& pStream );
+
 properties:
     //! Texture name (currently does nothing...)
     String              mTextureName;
@@ -31,6 +31,7 @@
 #include "Maths/Vector3.h"
 #include "Graphic/Renderer.h"
 #include "Graphic/GraphicSubsystem.h"
+#include "Sound/SoundSubsystem.h"
 
 
 namespace Gamedesk {
@@ -40,7 +41,9 @@ static const Float sgk_soundSize = 0.1f;
 
 
 Sound3D::Sound3D() : 
-    mLastSoundPosition(0, 0, 0)
+    mLastSoundPosition(0, 0, 0),
+    mMoving(false),
+    mLastSpeedRatio(0)
 {
     Float halfSize = sgk_soundSize / 2.0f;
     mBoundingBox.SetMin( Vector3f(-halfSize, 0, -halfSize) );
@@ -74,20 +77,23 @@ void Sound3D::Update(Double pElapsedTime)
 		Vector3f velocity = (mPosition - mLastSoundPosition) / pElapsedTime;
         mSound->SetAttributes(mPosition, velocity);
 		mLastSoundPosition = mPosition;
+        mMoving = true;
 	}
-    // If it didn't move we must set the velocity back to 0.
-    else
+    // If it stopped moving we must set the velocity back to 0, once.
+    else if(mMoving)
     {
-        Vector3f velocity;
-        Vector3f position;
-        mSound->GetAttributes(position, velocity);
-        if(velocity.GetLength() > 0 || mSound->IsPlaying())
-        {
-            mSound->SetAttributes(mSound->GetPosition(), Vector3f(0, 0, 0));
-        }
+        mSound->SetAttributes(mPosition, Vector3f(0, 0, 0));
+        mMoving = false;
     }
 
-    mSound->SetFrequency(mSound->GetFrequency());
+    // The frequency only needs to be pushed again when the speed ratio changes.
+    // Keep trying until it reaches a playing sound.
+    Float speedRatio = SoundSubsystem::Instance()->GetSpeedRatio();
+    if(speedRatio != mLastSpeedRatio)
+    {
+        if(mSound->SetFrequency(mSound->GetFrequency()))
+            mLastSpeedRatio = speedRatio;
+    }
 }
 
 void Sound3D::Render() const
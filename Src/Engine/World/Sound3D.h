@@ -69,6 +69,8 @@ private:
     SoundHdl    mSound;
 
 	Vector3f	mLastSoundPosition;
+    Bool        mMoving;            //!< The velocity sent to the sound is not 0.
+    Float       mLastSpeedRatio;    //!< Speed ratio when the frequency was last sent to the sound.
 };
 
 
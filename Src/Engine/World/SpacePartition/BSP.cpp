@@ -28,7 +28,7 @@ Bsp::Bsp()
 	: mBufPositions(NULL)
 	, mBufNormals(NULL)
 	, mBufIndices(NULL)
-    , mPackedLightmaps( 1024, Image::Format_R8G8B8 )
+    , mPackedLightmaps( 1024, Image::Format_R8G8B8, true )
 {
 }
 
@@ -63,13 +63,36 @@ void Bsp::Init()
     for( UInt32 i = 0; i < mFaces.size(); i++ )
         CalculateFaceExtent(i);
 
-    // Create all the lightmaps (pack them in 2048x2048 textures)
-    mPackedLightmaps.BeginPacking();
+    // Create all the lightmaps
+    Vector<const Image*> lightmaps;
+    Vector<UInt32>       lightmapFaces;
 
     for( UInt32 i = 0; i < mFaces.size(); i++ )
-        CreateFaceLightmap(i);
+    {
+        Image* lightmap = GD_NEW(Image, this, "Engine::World::Bsp");
+        if( CreateFaceLightmap(i, *lightmap) )
+        {
+            lightmaps.push_back( lightmap );
+            lightmapFaces.push_back( i );
+        }
+        else
+        {
+            GD_DELETE(lightmap);
+        }
+    }
 
+    // Pack them all at once in 1024x1024 textures, it needs less pages than packing them one by one.
+    Vector<PackedTexture::Info> lightmapInfos;
+
+    mPackedLightmaps.BeginPacking();
+    mPackedLightmaps.InsertImages( lightmaps, lightmapInfos );
     mPackedLightmaps.EndPacking();
+
+    for( UInt32 i = 0; i < lightmaps.size(); i++ )
+    {
+        mFaces[lightmapFaces[i]].mLightmapInfo = lightmapInfos[i];
+        GD_DELETE(lightmaps[i]);
+    }
 }
 
 void Bsp::CalculateFaceExtent( UInt32 iFace )
@@ -115,30 +138,29 @@ void Bsp::CalculateFaceExtent( UInt32 iFace )
 	face.mExtent = (bmax - bmin) * 16;
 }
 
-void Bsp::CreateFaceLightmap( UInt32 iFace )
+Bool Bsp::CreateFaceLightmap( UInt32 iFace, Image& pLightmap )
 {
-    BSPFace&          face    = mFaces[iFace];
+    const BSPFace&    face    = mFaces[iFace];
     const BSPTexInfo& texInfo = mTextureInfo[face.mTextureInfo];
 
     if( face.mNumEdges == 0 )
-        return;
+        return false;
 
     if( texInfo.mFlags & (SURF_SKY|SURF_TRANS33|SURF_TRANS66|SURF_WARP) )
-        return;    
+        return false;    
 
     UInt32 lightmapWidth  = (face.mExtent.x>>4)+1;
 	UInt32 lightmapHeight = (face.mExtent.y>>4)+1;
     
-    Image imgLight;
-    imgLight.Create( lightmapWidth, lightmapHeight, Image::Format_R8G8B8 );
+    pLightmap.Create( lightmapWidth, lightmapHeight, Image::Format_R8G8B8 );
     
-    Byte* dst = imgLight.GetData();
+    Byte* dst = pLightmap.GetData();
     Byte* src = &mLightmapData[face.mLightmapOffset];
     memcpy( dst, src, Image::GetSize(Image::Format_R8G8B8, lightmapWidth, lightmapHeight) );
     
-    imgLight.ChangeGamma( 2 );
+    pLightmap.ChangeGamma( 2 );
 
-    mPackedLightmaps.InsertImage( imgLight, face.mLightmapInfo );
+    return true;
 }
 
 const Bsp::BSPLeaf& Bsp::FindLeafContaining( const Vector3f& pPoint ) const
@@ -201,6 +223,7 @@ void Bsp::Render()
         currentCluster = cameraLeaf.mCluster;
 
     UInt32 lastLightMapPage = 0xFFFFFFFF;
+    Float  lightmapPageSize = Float(mPackedLightmaps.GetTextureSize());
 
     // Go through all the leafs and check their visibility
     int i = mLeaves.size();
@@ -286,17 +309,15 @@ void Bsp::Render()
                     
                     if( face.mLightmapInfo.mValid )
                     {
-                        texCoord.x  = (v dot texInfo.mAxisU) + texInfo.mOffsetU;
-                        texCoord.x += face.mLightmapInfo.mOffsetU*16;
-                        texCoord.x -= face.mTextureMin.x;
-                        texCoord.x += 8;
-                        texCoord.x /= 1024*16;
-
-                        texCoord.y  = (v dot texInfo.mAxisV) + texInfo.mOffsetV;
-                        texCoord.y += face.mLightmapInfo.mOffsetV*16;
-                        texCoord.y -= face.mTextureMin.y;
-                        texCoord.y += 8;
-                        texCoord.y /= 1024*16;
+                        // Position in the face lightmap, in texels (one texel every 16 units).
+                        Float lightmapS = ((v dot texInfo.mAxisU) + texInfo.mOffsetU - face.mTextureMin.x + 8) / 16;
+                        Float lightmapT = ((v dot texInfo.mAxisV) + texInfo.mOffsetV - face.mTextureMin.y + 8) / 16;
+
+                        if( face.mLightmapInfo.mRotated )
+                            std::swap( lightmapS, lightmapT );
+
+                        texCoord.x = (face.mLightmapInfo.mOffsetU + lightmapS) / lightmapPageSize;
+                        texCoord.y = (face.mLightmapInfo.mOffsetV + lightmapT) / lightmapPageSize;
 
                         renderer->SetUV( 1, texCoord );
                     }
@@ -159,7 +159,7 @@ public:
 
 private:
     void            CalculateFaceExtent( UInt32 iFace );
-    void            CreateFaceLightmap( UInt32 iFace );
+    Bool            CreateFaceLightmap( UInt32 iFace, Image& pLightmap );
 
     void            MarkVisibleLeafs( UInt32 pFromCluster );
     Bool            IsPotentiallyVisible( UInt32 pFromCluster, UInt32 pTestCluster ) const;
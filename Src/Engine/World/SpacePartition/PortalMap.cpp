@@ -0,0 +1,112 @@
+/**
+ *  @file       PortalMap.cpp
+ *  @brief      Map split in areas connected by portals.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "PortalMap.h"
+
+
+namespace Gamedesk {
+
+
+IMPLEMENT_CLASS(PortalMap);
+
+
+PortalMap::PortalMap()
+{
+}
+
+PortalMap::~PortalMap()
+{
+    // The surfaces are child meshes, deleted by ~Mesh().
+}
+
+void PortalMap::Init()
+{
+    Mesh::Init();
+
+    for( UInt32 iArea = 0; iArea < mAreas.size(); iArea++ )
+    {
+        Area& area = mAreas[iArea];
+
+        area.mPortals.clear();
+        area.mBoundingBox = BoundingBox();
+
+        for( UInt32 iSurface = 0; iSurface < area.mSurfaces.size(); iSurface++ )
+            area.mBoundingBox.Grow( area.mSurfaces[iSurface]->GetBoundingBox() );
+    }
+
+    for( UInt32 iPortal = 0; iPortal < mPortals.size(); iPortal++ )
+    {
+        Portal& portal = mPortals[iPortal];
+        GD_ASSERT( portal.mPoints.size() >= 3 );
+
+        // Newell's method, robust to nearly collinear points.
+        Vector3f normal( 0, 0, 0 );
+        Vector3f center( 0, 0, 0 );
+        for( UInt32 i = 0; i < portal.mPoints.size(); i++ )
+        {
+            const Vector3f& current = portal.mPoints[i];
+            const Vector3f& next    = portal.mPoints[(i + 1) % portal.mPoints.size()];
+
+            normal.x += (current.y - next.y) * (current.z + next.z);
+            normal.y += (current.z - next.z) * (current.x + next.x);
+            normal.z += (current.x - next.x) * (current.y + next.y);
+            center += current;
+        }
+
+        center /= Float(portal.mPoints.size());
+        portal.mPlane = Plane3f( normal.GetNormalized(), center );
+
+        for( UInt32 side = 0; side < 2; side++ )
+        {
+            if( portal.mAreas[side] < mAreas.size() )
+                mAreas[portal.mAreas[side]].mPortals.push_back( iPortal );
+        }
+    }
+}
+
+Int32 PortalMap::FindArea( const Vector3f& pPoint ) const
+{
+    if( mNodes.empty() )
+        return mAreas.empty() ? -1 : 0;
+
+    Int32 nodeIndex = 0;
+    for(;;)
+    {
+        const Node& node = mNodes[nodeIndex];
+        Int32 child = node.mChildren[node.mPlane.DistanceTo(pPoint) > 0 ? 0 : 1];
+
+        if( child == 0 )
+            return -1;
+
+        if( child < 0 )
+            return -1 - child;
+
+        nodeIndex = child;
+    }
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,99 @@
+/**
+ *  @file       PortalMap.h
+ *  @brief      Map split in areas connected by portals.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _PORTAL_MAP_H_
+#define     _PORTAL_MAP_H_
+
+
+#include "Graphic/Mesh/Mesh.h"
+#include "Maths/Plane3.h"
+
+
+namespace Gamedesk {
+
+
+/**
+ *  Map split in convex areas connected by portals, as stored in Doom 3 .proc
+ *  files. The surfaces of every area are child meshes, so the map renders as a
+ *  regular mesh; PortalPartition uses the areas and portals to only render
+ *  what can be seen from the camera.
+ */
+class ENGINE_API PortalMap : public Mesh
+{
+    DECLARE_CLASS(PortalMap, Mesh);
+
+public:
+    class Area
+    {
+    public:
+        String              mName;
+        Vector<Mesh*>       mSurfaces;      //!< Also children of the map, which owns them.
+        Vector<UInt32>      mPortals;       //!< Portals leading out of this area, filled by Init().
+        BoundingBox         mBoundingBox;   //!< Filled by Init().
+    };
+
+    class Portal
+    {
+    public:
+        UInt32              mAreas[2];
+        Vector<Vector3f>    mPoints;        //!< Convex polygon.
+        Plane3f             mPlane;         //!< Filled by Init().
+    };
+
+    class Node
+    {
+    public:
+        Plane3f             mPlane;
+        Int32               mChildren[2];   //!< Positive and negative side. A child > 0 is a node, 0 is solid and < 0 is area -1-child.
+    };
+
+public:
+    //! Default constructor.
+    PortalMap();
+
+    //! Destructor.
+    virtual ~PortalMap();
+
+    //! Create the surface buffers, compute the portal planes and link each area to its portals.
+    virtual void Init();
+
+    /**
+     *  Find the area containing a point by walking down the node tree.
+     *  @param  pPoint  Point to locate.
+     *  @return Index of the area, -1 if the point is in the solid.
+     */
+    Int32 FindArea( const Vector3f& pPoint ) const;
+
+public:
+    Vector<Area>        mAreas;
+    Vector<Portal>      mPortals;
+    Vector<Node>        mNodes;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _PORTAL_MAP_H_
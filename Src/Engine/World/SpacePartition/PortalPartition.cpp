@@ -0,0 +1,427 @@
+/**
+ *  @file       PortalPartition.cpp
+ *  @brief      Portal visibility over the areas of a PortalMap.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "PortalPartition.h"
+#include "PortalMap.h"
+
+#include "Maths/Intersection.h"
+#include "Debug/PerformanceMonitor.h"
+
+
+namespace Gamedesk {
+
+
+IMPLEMENT_CLASS(PortalPartition);
+
+
+static const Float PORTAL_EPSILON = 0.01f;      //!< Closer than this to a portal, the camera is standing in it.
+
+
+static BoundingBox GetWorldBoundingBox( const Entity* pEntity )
+{
+    const BoundingBox& box = pEntity->GetBoundingBox();
+    return BoundingBox( box.Min() + pEntity->GetPosition(), box.Max() + pEntity->GetPosition() );
+}
+
+static Bool BoxInVolume( const BoundingBox& pBox, const Plane3f* pPlanes, UInt32 pNumPlanes )
+{
+    for( UInt32 i = 0; i < pNumPlanes; i++ )
+    {
+        // Test the corner the furthest along the plane normal.
+        const Plane3f& plane = pPlanes[i];
+        Vector3f corner( plane(0) >= 0 ? pBox.Max().x : pBox.Min().x,
+                         plane(1) >= 0 ? pBox.Max().y : pBox.Min().y,
+                         plane(2) >= 0 ? pBox.Max().z : pBox.Min().z );
+
+        if( plane.DistanceTo( corner ) < 0 )
+            return false;
+    }
+
+    return true;
+}
+
+
+PortalPartition::PortalPartition()
+    : mMap(NULL)
+    , mViewPoint(0, 0, 0)
+    , mVisibilityUpdated(false)
+    , mNbVisitedPortals(0)
+    , mNbRenderedSurfaces(0)
+{
+}
+
+PortalPartition::~PortalPartition()
+{
+}
+
+void PortalPartition::SetMap( PortalMap* pMap )
+{
+    List<Entity*> entities;
+    Query( entities );
+
+    mMap = pMap;
+    UInt32 numAreas = mMap ? mMap->mAreas.size() : 0;
+
+    mAreaEntities.clear();
+    mAreaEntities.resize( numAreas );
+    mOutsideEntities.clear();
+    mEntityAreas.clear();
+
+    mAreaVolumes.clear();
+    mAreaVolumes.resize( numAreas );
+    mAreaOnPath.clear();
+    mAreaOnPath.resize( numAreas, 0 );
+    mVisibleAreas.clear();
+    mVisibilityUpdated = false;
+
+    // Place the entities in the new areas.
+    for( List<Entity*>::iterator it = entities.begin(); it != entities.end(); ++it )
+        Insert( *it );
+}
+
+PortalMap* PortalPartition::GetMap() const
+{
+    return mMap;
+}
+
+void PortalPartition::Initialize(Vector3f /*pPosition*/, Vector3f /*pRootSize*/, Vector3f /*pLeafSize*/)
+{
+}
+
+Int32 PortalPartition::FindEntityArea( Entity* pEntity ) const
+{
+    return mMap ? mMap->FindArea( GetWorldBoundingBox(pEntity).GetCenter() ) : -1;
+}
+
+Bool PortalPartition::Insert(Entity* pEntity)
+{
+    if( mEntityAreas.find(pEntity) != mEntityAreas.end() )
+        return false;
+
+    Int32 area = FindEntityArea( pEntity );
+    if( area >= 0 )
+        mAreaEntities[area].push_back( pEntity );
+    else
+        mOutsideEntities.push_back( pEntity );
+
+    mEntityAreas[pEntity] = area;
+    return true;
+}
+
+Bool PortalPartition::Remove(Entity* pEntity)
+{
+    Map<Entity*, Int32>::iterator itFind = mEntityAreas.find( pEntity );
+    if( itFind == mEntityAreas.end() )
+        return false;
+
+    if( itFind->second >= 0 )
+        mAreaEntities[itFind->second].remove( pEntity );
+    else
+        mOutsideEntities.remove( pEntity );
+
+    mEntityAreas.erase( itFind );
+    return true;
+}
+
+UInt32 PortalPartition::Query(List<Entity*>& pEntities, Class* pEntityType) const
+{
+    for( Map<Entity*, Int32>::const_iterator it = mEntityAreas.begin(); it != mEntityAreas.end(); ++it )
+    {
+        if( !pEntityType || it->first->IsA(pEntityType) )
+            pEntities.push_back( it->first );
+    }
+
+    return pEntities.size();
+}
+
+UInt32 PortalPartition::Query(const Ray3f& pRay, List<Entity*>& pEntities, Class* pEntityType) const
+{
+    for( Map<Entity*, Int32>::const_iterator it = mEntityAreas.begin(); it != mEntityAreas.end(); ++it )
+    {
+        if( (!pEntityType || it->first->IsA(pEntityType)) && Intersect( pRay, GetWorldBoundingBox(it->first) ) )
+            pEntities.push_back( it->first );
+    }
+
+    return pEntities.size();
+}
+
+UInt32 PortalPartition::Query(const BoundingBox& pBoundingBox, List<Entity*>& pEntities, Class* pEntityType) const
+{
+    for( Map<Entity*, Int32>::const_iterator it = mEntityAreas.begin(); it != mEntityAreas.end(); ++it )
+    {
+        if( (!pEntityType || it->first->IsA(pEntityType)) && pBoundingBox.Contains( GetWorldBoundingBox(it->first) ) )
+            pEntities.push_back( it->first );
+    }
+
+    return pEntities.size();
+}
+
+UInt32 PortalPartition::Query(const Frustum& pFrustum, List<Entity*>& pEntities, Class* pEntityType) const
+{
+    List<Entity*>::const_iterator it;
+
+    // Without visibility information, everything in the frustum.
+    if( !mVisibilityUpdated )
+    {
+        for( Map<Entity*, Int32>::const_iterator itEntity = mEntityAreas.begin(); itEntity != mEntityAreas.end(); ++itEntity )
+        {
+            if( (!pEntityType || itEntity->first->IsA(pEntityType)) && pFrustum.BoxInFrustum( GetWorldBoundingBox(itEntity->first) ) )
+                pEntities.push_back( itEntity->first );
+        }
+
+        return pEntities.size();
+    }
+
+    for( UInt32 i = 0; i < mVisibleAreas.size(); i++ )
+    {
+        const List<Entity*>& entities = mAreaEntities[mVisibleAreas[i]];
+        for( it = entities.begin(); it != entities.end(); ++it )
+        {
+            if( pEntityType && !(*it)->IsA(pEntityType) )
+                continue;
+
+            BoundingBox box = GetWorldBoundingBox( *it );
+            if( pFrustum.BoxInFrustum( box ) && IsVisible( box, mVisibleAreas[i] ) )
+                pEntities.push_back( *it );
+        }
+    }
+
+    for( it = mOutsideEntities.begin(); it != mOutsideEntities.end(); ++it )
+    {
+        if( (!pEntityType || (*it)->IsA(pEntityType)) && pFrustum.BoxInFrustum( GetWorldBoundingBox(*it) ) )
+            pEntities.push_back( *it );
+    }
+
+    return pEntities.size();
+}
+
+void PortalPartition::UpdateVisibility(const Vector3f& pViewPoint, const Frustum& pFrustum)
+{
+    Profile("Portal Visibility");
+
+    for( UInt32 i = 0; i < mVisibleAreas.size(); i++ )
+        mAreaVolumes[mVisibleAreas[i]].clear();
+
+    mVisibleAreas.clear();
+    mPlanes.clear();
+    mVolumes.clear();
+    mNbVisitedPortals = 0;
+    mViewPoint = pViewPoint;
+    mVisibilityUpdated = true;
+
+    if( !mMap )
+        return;
+
+    // The view frustum is the first volume.
+    ClipVolume frustumVolume;
+    frustumVolume.mFirstPlane = 0;
+    frustumVolume.mNumPlanes  = Frustum::NumSides;
+    mVolumes.push_back( frustumVolume );
+
+    // The frustum planes face outward, flip them so the inside is on the positive side like the portal volumes.
+    for( UInt32 i = 0; i < Frustum::NumSides; i++ )
+    {
+        const Plane3f& plane = pFrustum.GetPlane( Frustum::FrustumSide(i) );
+        mPlanes.push_back( Plane3f( -plane.GetNormal(), -plane.GetConstant() ) );
+    }
+
+    Int32 cameraArea = mMap->FindArea( pViewPoint );
+    if( cameraArea < 0 )
+    {
+        // Outside the map, there's no portal to start from: test every area against the frustum.
+        for( UInt32 i = 0; i < mMap->mAreas.size(); i++ )
+            AddVisibleArea( i, 0 );
+        return;
+    }
+
+    FloodArea( cameraArea, 0, 0 );
+}
+
+void PortalPartition::AddVisibleArea( UInt32 pArea, UInt32 pVolume )
+{
+    if( mAreaVolumes[pArea].empty() )
+        mVisibleAreas.push_back( pArea );
+
+    mAreaVolumes[pArea].push_back( pVolume );
+}
+
+void PortalPartition::FloodArea( UInt32 pArea, UInt32 pVolume, UInt32 pDepth )
+{
+    AddVisibleArea( pArea, pVolume );
+
+    if( pDepth >= MAX_FLOOD_DEPTH )
+        return;
+
+    mAreaOnPath[pArea] = 1;
+
+    Vector<Vector3f> polygon;
+    Vector<Vector3f> clipped;
+
+    const Vector<UInt32>& portals = mMap->mAreas[pArea].mPortals;
+    for( UInt32 iPortal = 0; iPortal < portals.size(); iPortal++ )
+    {
+        const PortalMap::Portal& portal = mMap->mPortals[portals[iPortal]];
+        UInt32 nextArea = portal.mAreas[0] == pArea ? portal.mAreas[1] : portal.mAreas[0];
+
+        if( nextArea >= mMap->mAreas.size() || mAreaOnPath[nextArea] )
+            continue;
+
+        mNbVisitedPortals++;
+
+        // Standing in the portal, it can't narrow the view.
+        Float viewDistance = portal.mPlane.DistanceTo( mViewPoint );
+        if( Maths::Abs(viewDistance) < PORTAL_EPSILON )
+        {
+            FloodArea( nextArea, pVolume, pDepth + 1 );
+            continue;
+        }
+
+        // Clip the portal to the current volume.
+        const ClipVolume volume = mVolumes[pVolume];
+        polygon = portal.mPoints;
+        for( UInt32 i = 0; i < volume.mNumPlanes && polygon.size() >= 3; i++ )
+        {
+            ClipPolygon( polygon, mPlanes[volume.mFirstPlane + i], clipped );
+            polygon.swap( clipped );
+        }
+
+        if( polygon.size() < 3 )
+            continue;
+
+        // Narrow the volume to the clipped portal: only what is beyond the portal,
+        // between the planes going from the eye through each polygon edge.
+        ClipVolume narrowed;
+        narrowed.mFirstPlane = mPlanes.size();
+
+        if( viewDistance > 0 )
+            mPlanes.push_back( Plane3f( -portal.mPlane.GetNormal(), -portal.mPlane.GetConstant() ) );
+        else
+            mPlanes.push_back( portal.mPlane );
+
+        Vector3f center( 0, 0, 0 );
+        for( UInt32 i = 0; i < polygon.size(); i++ )
+            center += polygon[i];
+        center /= Float(polygon.size());
+
+        for( UInt32 i = 0; i < polygon.size(); i++ )
+        {
+            Vector3f normal = (polygon[i] - mViewPoint) cross (polygon[(i + 1) % polygon.size()] - mViewPoint);
+            if( normal.GetLength() < PORTAL_EPSILON * PORTAL_EPSILON )
+                continue;
+
+            Plane3f edgePlane( normal, mViewPoint );
+            if( edgePlane.DistanceTo( center ) < 0 )
+                edgePlane = Plane3f( -normal, mViewPoint );
+
+            mPlanes.push_back( edgePlane );
+        }
+
+        narrowed.mNumPlanes = mPlanes.size() - narrowed.mFirstPlane;
+        mVolumes.push_back( narrowed );
+
+        FloodArea( nextArea, mVolumes.size() - 1, pDepth + 1 );
+    }
+
+    mAreaOnPath[pArea] = 0;
+}
+
+Bool PortalPartition::IsVisible( const BoundingBox& pBox, UInt32 pArea ) const
+{
+    const Vector<UInt32>& volumes = mAreaVolumes[pArea];
+    for( UInt32 i = 0; i < volumes.size(); i++ )
+    {
+        const ClipVolume& volume = mVolumes[volumes[i]];
+        if( BoxInVolume( pBox, &mPlanes[volume.mFirstPlane], volume.mNumPlanes ) )
+            return true;
+    }
+
+    return false;
+}
+
+void PortalPartition::Render() const
+{
+    Profile("Portal Render");
+
+    mNbRenderedSurfaces = 0;
+
+    if( !mMap )
+        return;
+
+    for( UInt32 i = 0; i < mVisibleAreas.size(); i++ )
+    {
+        const PortalMap::Area& area = mMap->mAreas[mVisibleAreas[i]];
+        for( UInt32 iSurface = 0; iSurface < area.mSurfaces.size(); iSurface++ )
+        {
+            const Mesh* surface = area.mSurfaces[iSurface];
+            if( IsVisible( surface->GetBoundingBox(), mVisibleAreas[i] ) )
+            {
+                surface->Render( false );
+                mNbRenderedSurfaces++;
+            }
+        }
+    }
+}
+
+UInt32 PortalPartition::GetNbVisitedAreas() const
+{
+    return mVisibleAreas.size();
+}
+
+UInt32 PortalPartition::GetNbVisitedPortals() const
+{
+    return mNbVisitedPortals;
+}
+
+UInt32 PortalPartition::GetNbRenderedSurfaces() const
+{
+    return mNbRenderedSurfaces;
+}
+
+void PortalPartition::ClipPolygon( const Vector<Vector3f>& pIn, const Plane3f& pPlane, Vector<Vector3f>& pOut )
+{
+    pOut.clear();
+
+    for( UInt32 i = 0; i < pIn.size(); i++ )
+    {
+        const Vector3f& current = pIn[i];
+        const Vector3f& next    = pIn[(i + 1) % pIn.size()];
+
+        Float currentDistance = pPlane.DistanceTo( current );
+        Float nextDistance    = pPlane.DistanceTo( next );
+
+        if( currentDistance >= 0 )
+            pOut.push_back( current );
+
+        if( (currentDistance >= 0) != (nextDistance >= 0) )
+        {
+            Float t = currentDistance / (currentDistance - nextDistance);
+            pOut.push_back( current + (next - current) * t );
+        }
+    }
+}
+
+
+} // namespace Gamedesk
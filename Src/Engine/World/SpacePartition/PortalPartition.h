@@ -0,0 +1,140 @@
+/**
+ *  @file       PortalPartition.h
+ *  @brief      Portal visibility over the areas of a PortalMap.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _PORTAL_PARTITION_H_
+#define     _PORTAL_PARTITION_H_
+
+
+#include "World/SpacePartition/SpacePartition.h"
+
+
+namespace Gamedesk {
+
+
+class PortalMap;
+
+
+/**
+ *  Space partition using the areas and portals of a PortalMap.
+ *  Each frame, the area containing the camera is found with the node tree, then
+ *  visibility floods through the portals: every portal polygon is clipped to the
+ *  current view volume, and the volume is narrowed to the clipped polygon before
+ *  entering the next area. Only the surfaces and entities of the areas reached
+ *  this way, and inside the volume they were reached with, are rendered.
+ *  Entities are stored in the area containing the center of their bounding box.
+ */
+class ENGINE_API PortalPartition : public SpacePartition
+{
+    DECLARE_CLASS(PortalPartition, SpacePartition);
+
+public:
+    //! Default constructor.
+    PortalPartition();
+
+    //! Destructor.
+    virtual ~PortalPartition();
+
+    //! Use the areas and portals of pMap, which is not owned by the partition.
+    void SetMap( PortalMap* pMap );
+
+    //! Map used by the partition.
+    PortalMap* GetMap() const;
+
+    //! Does nothing, the areas come from the map.
+    virtual void Initialize(Vector3f pPosition, Vector3f pRootSize, Vector3f pLeafSize);
+
+    virtual Bool Insert(Entity* pEntity);
+    virtual Bool Remove(Entity* pEntity);
+
+    virtual UInt32 Query(List<Entity*>& pEntities, Class* pEntityType = 0) const;
+    virtual UInt32 Query(const Ray3f& pRay, List<Entity*>& pEntities, Class* pEntityType = 0) const;
+    virtual UInt32 Query(const BoundingBox& pBoundingBox, List<Entity*>& pEntities, Class* pEntityType = 0) const;
+
+    //! Entities in the frustum and in the areas visible since the last UpdateVisibility().
+    virtual UInt32 Query(const Frustum& pFrustum, List<Entity*>& pEntities, Class* pEntityType = 0) const;
+
+    //! Flood through the portals from the area containing pViewPoint.
+    virtual void UpdateVisibility(const Vector3f& pViewPoint, const Frustum& pFrustum);
+
+    //! Render the map surfaces of the visible areas.
+    virtual void Render() const;
+
+    //! Number of distinct areas reached by the last UpdateVisibility().
+    UInt32 GetNbVisitedAreas() const;
+
+    //! Number of portals tested by the last UpdateVisibility().
+    UInt32 GetNbVisitedPortals() const;
+
+    //! Number of surfaces drawn by the last Render().
+    UInt32 GetNbRenderedSurfaces() const;
+
+    /**
+     *  Clip a convex polygon to a plane.
+     *  @param  pIn     Convex polygon to clip.
+     *  @param  pPlane  Clipping plane.
+     *  @param  pOut    Receive the part of pIn on the positive side of pPlane, empty if there's none.
+     */
+    static void ClipPolygon( const Vector<Vector3f>& pIn, const Plane3f& pPlane, Vector<Vector3f>& pOut );
+
+private:
+    static const UInt32 MAX_FLOOD_DEPTH = 64;
+
+    //! Convex volume, a range of mPlanes. Inside points are on the positive side of every plane.
+    class ClipVolume
+    {
+    public:
+        UInt32      mFirstPlane;
+        UInt32      mNumPlanes;
+    };
+
+    void    FloodArea( UInt32 pArea, UInt32 pVolume, UInt32 pDepth );
+    void    AddVisibleArea( UInt32 pArea, UInt32 pVolume );
+    Bool    IsVisible( const BoundingBox& pBox, UInt32 pArea ) const;
+    Int32   FindEntityArea( Entity* pEntity ) const;
+
+private:
+    PortalMap*                  mMap;
+
+    Vector< List<Entity*> >     mAreaEntities;
+    List<Entity*>               mOutsideEntities;       //!< Entities in the solid, or added without a map.
+    Map<Entity*, Int32>         mEntityAreas;
+
+    Vector3f                    mViewPoint;
+    Vector<Plane3f>             mPlanes;
+    Vector<ClipVolume>          mVolumes;
+    Vector< Vector<UInt32> >    mAreaVolumes;           //!< Volumes each area was reached with, this frame.
+    Vector<UInt32>              mVisibleAreas;
+    Vector<Byte>                mAreaOnPath;            //!< Areas on the current flood path, to avoid going back.
+    Bool                        mVisibilityUpdated;
+
+    UInt32                      mNbVisitedPortals;
+    mutable UInt32              mNbRenderedSurfaces;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _PORTAL_PARTITION_H_
@@ -15,5 +15,13 @@ SpacePartition::~SpacePartition()
 {
 }
 
+void SpacePartition::UpdateVisibility(const Vector3f& /*pViewPoint*/, const Frustum& /*pFrustum*/)
+{
+}
+
+void SpacePartition::Render() const
+{
+}
+
 
 } // namespace Gamedesk
@@ -54,6 +54,12 @@ public:
 	virtual UInt32 Query(const Ray3f& pRay, List<Entity*>& pEntities, Class* pEntityType = 0) const = 0;
 	virtual UInt32 Query(const BoundingBox& pBoundingBox, List<Entity*>& pEntities, Class* pEntityType = 0) const = 0;
 	virtual UInt32 Query(const Frustum& pFrustum, List<Entity*>& pEntities, Class* pEntityType = 0) const = 0;
+
+	//! Find what can be seen from pViewPoint, called once per frame before Render() and the queries.
+	virtual void UpdateVisibility(const Vector3f& pViewPoint, const Frustum& pFrustum);
+
+	//! Render the geometry owned by the partition, if any.
+	virtual void Render() const;
 };
 
 
@@ -39,196 +39,534 @@
 #include "Graphic/Renderer.h"
 #include "Graphic/GraphicSubsystem.h"
 
+#include "World/Camera.h"
+
+#include "Maths/Frustum.h"
+#include "Debug/PerformanceMonitor.h"
+#include "Thread/JobManager.h"
+
 
 namespace Gamedesk {
-	
-	
+
+
+static const Float SAMPLE_SPACING   = 5.0f;         // Distance between two heightmap samples.
+static const Float HEIGHT_SCALE     = 1 / 7.8125f;  // Heightmap value to world height.
+
+
+/**
+ *  Build the vertices of the patches being streamed in, one job per patch.
+ */
+class TerrainPatchBuilder : public ParallelForBody
+{
+public:
+    class Request
+    {
+    public:
+        UInt32      mPatchIndex;
+        Vector3f*   mPoints;
+        Vector3f*   mNormals;
+        Vector2f*   mTexCoords;
+        Float       mMinHeight;
+        Float       mMaxHeight;
+    };
+
+    TerrainPatchBuilder( const Terrain& pTerrain, Vector<Request>& pRequests )
+        : mTerrain(pTerrain)
+        , mRequests(pRequests)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+        {
+            Request& request = mRequests[i];
+            mTerrain.BuildPatchVertices( request.mPatchIndex % mTerrain.mNumPatches,
+                                         request.mPatchIndex / mTerrain.mNumPatches,
+                                         request.mPoints, request.mNormals, request.mTexCoords,
+                                         request.mMinHeight, request.mMaxHeight );
+        }
+    }
+
+private:
+    const Terrain&      mTerrain;
+    Vector<Request>&    mRequests;
+};
+
+
 Terrain::Terrain() :
     mTextureName("Data/Terrain/terrain001.dds"),
-    mBufPositions(NULL),
-    mBufNormals(NULL),
-    mBufTexCoords(NULL),
-    mBufIndices(NULL),
+    mHeightData(NULL),
     mMapSize(0),
     mMapWidth(0),
-    mHeightData(NULL)    
+    mNumPatches(0),
+    mBufIndices(NULL),
+    mStreamRadius(1500.0f),
+    mLodDistance(150.0f),
+    mMaxLoadsPerFrame(16),
+    mNbRenderedPatches(0),
+    mNbRenderedTriangles(0)
 {
-    LoadRawFile( "Data/Terrain/Terrain.raw" );
-    BuildBuffers();
+    OpenHeightMap( "Data/Terrain/Terrain.raw" );
+    BuildIndexBuffer();
 
     SetTexture(mTextureName);
 }
 
 Terrain::~Terrain()
 {
-    if( mHeightData )
-        GD_DELETE(mHeightData);
+    for( UInt32 i = 0; i < mBufferPool.size(); i++ )
+    {
+        GD_DELETE(mBufferPool[i].mPositions);
+        GD_DELETE(mBufferPool[i].mNormals);
+        GD_DELETE(mBufferPool[i].mTexCoords);
+    }
+
+    if( mBufIndices )
+        GD_DELETE(mBufIndices);
+
+    mHeightMap.Close();
+}
+
+void Terrain::Update( Double /*pElapsedTime*/ )
+{
+    if( !mWorld || !mWorld->GetCurrentCamera() || mNumPatches == 0 )
+        return;
+
+    Profile("Terrain Update");
+
+    // Work in the terrain space.
+    Vector3f cameraPos = mWorld->GetCurrentCamera()->GetPosition() - GetPosition();
+
+    StreamPatches( cameraPos );
+    SelectLods( cameraPos );
 }
 
 void Terrain::Render() const
 {
+    Profile("Terrain Render");
+
     Renderer* renderer = GraphicSubsystem::Instance()->GetRenderer();
     GD_ASSERT(renderer);
 
+    mNbRenderedPatches = 0;
+    mNbRenderedTriangles = 0;
+
+    if( mResidentPatches.empty() )
+        return;
+
+    // The model view matrix already contains the terrain transformation,
+    // so the frustum is expressed in the terrain space.
+    Matrix4f modelViewMatrix;
+    Matrix4f projectionMatrix;
+    Frustum  frustum;
+    renderer->GetModelViewMatrix(modelViewMatrix);
+    renderer->GetProjectionMatrix(projectionMatrix);
+    frustum.CalculateFrustum(projectionMatrix, modelViewMatrix);
+
     renderer->SetRenderState( Renderer::Lighting, true );
 
     renderer->SetVertexFormat( VertexFormat::Component(VertexFormat::Position3 | VertexFormat::TexCoord2 | VertexFormat::Normal3) );
-    renderer->SetStreamSource( VertexFormat::Position3, mBufPositions );
-    renderer->SetStreamSource( VertexFormat::TexCoord2, mBufTexCoords );
-    renderer->SetStreamSource( VertexFormat::Normal3,   mBufNormals );
     renderer->SetIndices( mBufIndices );
 
     renderer->SetMatrixMode( Renderer::TextureMatrix );
     renderer->PushMatrix();
     renderer->LoadIdentity();
     renderer->Scale( Vector3f( 10.0f, 10.0f, 10.0f ) );
-    
+
     renderer->GetTextureStage(0)->SetTexture( *mTexture );
-    renderer->DrawIndexedPrimitive( Renderer::TriangleList, 0, mBufIndices->GetItemCount() );
+
+    for( UInt32 i = 0; i < mResidentPatches.size(); i++ )
+    {
+        UInt32 patchIndex = mResidentPatches[i];
+        const Patch& patch = mPatches[patchIndex];
+
+        if( !frustum.BoxInFrustum( GetPatchBounds(patchIndex) ) )
+            continue;
+
+        const PatchBuffers& buffers = mBufferPool[patch.mSlot];
+        renderer->SetStreamSource( VertexFormat::Position3, buffers.mPositions );
+        renderer->SetStreamSource( VertexFormat::TexCoord2, buffers.mTexCoords );
+        renderer->SetStreamSource( VertexFormat::Normal3,   buffers.mNormals );
+
+        const IndexRange& range = mIndexRanges[patch.mLod][patch.mStitchMask];
+        renderer->DrawIndexedPrimitive( Renderer::TriangleList, range.mStart, range.mCount );
+
+        mNbRenderedPatches++;
+        mNbRenderedTriangles += range.mCount / 3;
+    }
+
     renderer->GetTextureStage(0)->ResetTexture();
 
     renderer->PopMatrix();
-    renderer->SetMatrixMode( Renderer::ModelViewMatrix );    
+    renderer->SetMatrixMode( Renderer::ModelViewMatrix );
 }
 
-void Terrain::LoadRawFile( const String& pHeightMapFile )
+void Terrain::OpenHeightMap( const String& pHeightMapFile )
 {
-    std::ifstream file( pHeightMapFile.c_str(), std::ios::in | std::ios_base::binary );
-        
-    if( file.fail() )
+    if( !FileManager::FileExist( pHeightMapFile ) )
         throw FileNotFoundException( pHeightMapFile, Here );
 
-    file.seekg( 0, std::ios_base::end );
-    int fileSize = file.tellg();
-    file.seekg( 0, std::ios_base::beg );
+    // The heightmap is mapped and never read as a whole, only the pages
+    // of the patches that get streamed in are touched.
+    mHeightMap.Open( pHeightMapFile, true );
+    mHeightData = mHeightMap.GetMemory();
 
-    mMapSize = Maths::Sqrt( (Float)fileSize );
-    mMapWidth = mMapSize * 5.0f;
+    mMapSize = Maths::Sqrt( (Float)mHeightMap.GetSize() );
+    mMapWidth = mMapSize * SAMPLE_SPACING;
 
-    mHeightData = GD_NEW_ARRAY(Byte, fileSize, this, "Engine::World::Terrain");
-    file.read( (Char*)mHeightData, fileSize );
+    mNumPatches = mMapSize > 1 ? (mMapSize - 1 + PATCH_QUADS - 1) / PATCH_QUADS : 0;
+    mPatches.resize( mNumPatches * mNumPatches );
 }
 
-void Terrain::BuildBuffers()
+void Terrain::BuildIndexBuffer()
 {
-    VertexList      terrainVertice;
-    TriangleBatch   terrainTriangles;
+    // Every LOD/stitching combination uses the same patch-local vertex layout,
+    // so all of them fit in one shared 16 bits index buffer.
+    Vector<UInt16> indices;
+    indices.reserve( Edge_Combinations * PATCH_QUADS * PATCH_QUADS * 6 * 4 / 3 );
 
-    UInt32 nbTrianglesIndex = ((mMapSize)-1) * ((mMapSize)-1) * 6;
-    UInt32 nbPoints         = mMapSize * mMapSize;
+    for( UInt32 lod = 0; lod < NUM_LODS; lod++ )
+    {
+        UInt32 step = 1 << lod;
 
-    terrainVertice.Allocate( nbPoints, VertexFormat::Component(VertexFormat::Position3 | VertexFormat::TexCoord2 | VertexFormat::Normal3) );
-    terrainTriangles.Allocate( TriangleBatch::TriangleList, nbTrianglesIndex );
+        for( UInt32 mask = 0; mask < Edge_Combinations; mask++ )
+        {
+            mIndexRanges[lod][mask].mStart = indices.size();
 
-    Vector3f*   points      = terrainVertice.GetPositions();
-    Vector3f*   normals     = terrainVertice.GetNormals();
-    Vector2f*   texCoords   = terrainVertice.GetTextureCoords();
-    UInt16*     indices     = terrainTriangles.GetIndices();
+            for( UInt32 z = 0; z < PATCH_QUADS; z += step )
+            {
+                for( UInt32 x = 0; x < PATCH_QUADS; x += step )
+                {
+                    UInt32 corners[4][2] = { { x,        z },           // 0
+                                             { x,        z + step },    // 1
+                                             { x + step, z },           // 2
+                                             { x + step, z + step } };  // 3
+                    UInt16 quad[4];
+
+                    // Snap the odd vertices of an edge shared with a coarser neighbour
+                    // on the previous even vertex, the edge then matches the neighbour's one.
+                    for( UInt32 c = 0; c < 4; c++ )
+                    {
+                        UInt32 vx = corners[c][0];
+                        UInt32 vz = corners[c][1];
+
+                        if( lod + 1 < NUM_LODS )
+                        {
+                            if( ((vz == 0 && (mask & Edge_NegZ)) || (vz == PATCH_QUADS && (mask & Edge_PosZ))) && (vx / step) % 2 == 1 )
+                                vx -= step;
+                            if( ((vx == 0 && (mask & Edge_NegX)) || (vx == PATCH_QUADS && (mask & Edge_PosX))) && (vz / step) % 2 == 1 )
+                                vz -= step;
+                        }
+
+                        quad[c] = vz * PATCH_VERTICES + vx;
+                    }
+
+                    // Same winding as the rest of the engine, degenerated triangles are dropped.
+                    if( quad[0] != quad[1] && quad[1] != quad[2] && quad[0] != quad[2] )
+                    {
+                        indices.push_back( quad[0] );
+                        indices.push_back( quad[1] );
+                        indices.push_back( quad[2] );
+                    }
+
+                    if( quad[1] != quad[3] && quad[3] != quad[2] && quad[1] != quad[2] )
+                    {
+                        indices.push_back( quad[1] );
+                        indices.push_back( quad[3] );
+                        indices.push_back( quad[2] );
+                    }
+                }
+            }
 
-    UInt32      n = 0;
-    UInt32      i = 0;
+            mIndexRanges[lod][mask].mCount = indices.size() - mIndexRanges[lod][mask].mStart;
+        }
+    }
 
-    for( UInt32 z = 0; z < mMapSize; z++ )
+    mBufIndices = Cast<IndexBuffer>( GraphicSubsystem::Instance()->Create( IndexBuffer::StaticClass() ) );
+    mBufIndices->Create( indices.size(), sizeof(UInt16), IndexBuffer::Usage_Static );
+
+    UInt16* indicesBuf = reinterpret_cast<UInt16*>(mBufIndices->Lock( IndexBuffer::Lock_Write ));
+    if( indicesBuf )
+        memcpy( indicesBuf, &indices[0], indices.size() * sizeof(UInt16) );
+    mBufIndices->Unlock();
+}
+
+void Terrain::StreamPatches( const Vector3f& pCameraPos )
+{
+    Profile("Streaming");
+
+    Float patchWidth = PATCH_QUADS * SAMPLE_SPACING;
+    Float halfWidth  = mMapWidth * 0.5f;
+
+    // Evict the patches that are too far, with some slack to avoid trashing.
+    Float evictRadius = mStreamRadius * 1.25f;
+    for( UInt32 i = 0; i < mResidentPatches.size(); )
     {
-        for( UInt32 x = 0; x < mMapSize; x++ )
+        UInt32 patchIndex = mResidentPatches[i];
+        Vector3f center = GetPatchBounds(patchIndex).GetCenter();
+        Float dx = center.x - pCameraPos.x;
+        Float dz = center.z - pCameraPos.z;
+
+        if( dx*dx + dz*dz > evictRadius*evictRadius )
+        {
+            mFreeSlots.push_back( mPatches[patchIndex].mSlot );
+            mPatches[patchIndex].mSlot = -1;
+            mResidentPatches[i] = mResidentPatches.back();
+            mResidentPatches.pop_back();
+        }
+        else
         {
-            points[n].x = x * 5.0f;
-            points[n].y = GetHeight( x, z ) / 7.8125f;
-            points[n].z = z * 5.0f;
+            i++;
+        }
+    }
 
-            points[n].x -= mMapWidth * 0.5f;
-            points[n].z -= mMapWidth * 0.5f;
+    // Find the missing patches in the streaming radius, closest first.
+    Int32 minX = Maths::Max<Int32>( 0, (Int32)((pCameraPos.x + halfWidth - mStreamRadius) / patchWidth) );
+    Int32 maxX = Maths::Min<Int32>( mNumPatches - 1, (Int32)((pCameraPos.x + halfWidth + mStreamRadius) / patchWidth) );
+    Int32 minZ = Maths::Max<Int32>( 0, (Int32)((pCameraPos.z + halfWidth - mStreamRadius) / patchWidth) );
+    Int32 maxZ = Maths::Min<Int32>( mNumPatches - 1, (Int32)((pCameraPos.z + halfWidth + mStreamRadius) / patchWidth) );
 
-			normals[n].x = 0;
-            normals[n].y = 0;
-            normals[n].z = 0;
-            
-            // Find the (u, v) coordinate for the current vertex
-            texCoords[n].x =  (Float)x / (Float)mMapSize;
-            texCoords[n].y =  (Float)z / (Float)mMapSize;
+    MultiMap<Float, UInt32> missingPatches;
+    for( Int32 z = minZ; z <= maxZ; z++ )
+    {
+        for( Int32 x = minX; x <= maxX; x++ )
+        {
+            UInt32 patchIndex = z * mNumPatches + x;
+            if( mPatches[patchIndex].mSlot != -1 )
+                continue;
+
+            Float dx = (x + 0.5f) * patchWidth - halfWidth - pCameraPos.x;
+            Float dz = (z + 0.5f) * patchWidth - halfWidth - pCameraPos.z;
+            Float distSqr = dx*dx + dz*dz;
+            if( distSqr <= mStreamRadius*mStreamRadius )
+                missingPatches.insert( std::make_pair(distSqr, patchIndex) );
+        }
+    }
+
+    if( missingPatches.empty() )
+        return;
+
+    // Build the vertices of the new patches in parallel.
+    UInt32 numLoads = Maths::Min<UInt32>( missingPatches.size(), mMaxLoadsPerFrame );
+    UInt32 numVertices = PATCH_VERTICES * PATCH_VERTICES;
+
+    Vector<Vector3f> points;
+    Vector<Vector3f> normals;
+    Vector<Vector2f> texCoords;
+    Vector<TerrainPatchBuilder::Request> requests;
+    points.resize( numLoads * numVertices );
+    normals.resize( numLoads * numVertices );
+    texCoords.resize( numLoads * numVertices );
+    requests.resize( numLoads );
 
-            if( z+1 != mMapSize && x+1 != mMapSize )
+    MultiMap<Float, UInt32>::iterator itPatch = missingPatches.begin();
+    for( UInt32 i = 0; i < numLoads; i++, ++itPatch )
+    {
+        requests[i].mPatchIndex = itPatch->second;
+        requests[i].mPoints     = &points[i * numVertices];
+        requests[i].mNormals    = &normals[i * numVertices];
+        requests[i].mTexCoords  = &texCoords[i * numVertices];
+    }
+
+    {Profile("Build");
+    TerrainPatchBuilder builder( *this, requests );
+    JobManager::Instance()->ParallelFor( numLoads, 1, builder );
+    }
+
+    // Upload, buffers can only be locked from the render thread.
+    {Profile("Upload");
+    for( UInt32 i = 0; i < numLoads; i++ )
+    {
+        Patch& patch = mPatches[requests[i].mPatchIndex];
+        patch.mSlot = AllocateSlot();
+        patch.mMinHeight = requests[i].mMinHeight;
+        patch.mMaxHeight = requests[i].mMaxHeight;
+
+        PatchBuffers& buffers = mBufferPool[patch.mSlot];
+
+        void* dest = buffers.mPositions->Lock( VertexBuffer::Lock_Write );
+        if( dest )
+            memcpy( dest, requests[i].mPoints, numVertices * sizeof(Vector3f) );
+        buffers.mPositions->Unlock();
+
+        dest = buffers.mNormals->Lock( VertexBuffer::Lock_Write );
+        if( dest )
+            memcpy( dest, requests[i].mNormals, numVertices * sizeof(Vector3f) );
+        buffers.mNormals->Unlock();
+
+        dest = buffers.mTexCoords->Lock( VertexBuffer::Lock_Write );
+        if( dest )
+            memcpy( dest, requests[i].mTexCoords, numVertices * sizeof(Vector2f) );
+        buffers.mTexCoords->Unlock();
+
+        mResidentPatches.push_back( requests[i].mPatchIndex );
+    }
+    }
+}
+
+void Terrain::SelectLods( const Vector3f& pCameraPos )
+{
+    // Distance based LOD, each LOD covers twice the distance of the previous one.
+    for( UInt32 i = 0; i < mResidentPatches.size(); i++ )
+    {
+        UInt32 patchIndex = mResidentPatches[i];
+        BoundingBox bounds = GetPatchBounds(patchIndex);
+
+        Vector3f closest( Maths::Min( Maths::Max(pCameraPos.x, bounds.Min().x), bounds.Max().x ),
+                          Maths::Min( Maths::Max(pCameraPos.y, bounds.Min().y), bounds.Max().y ),
+                          Maths::Min( Maths::Max(pCameraPos.z, bounds.Min().z), bounds.Max().z ) );
+        Float distance = (closest - pCameraPos).GetLength();
+
+        UInt32 lod = 0;
+        for( Float lodDistance = mLodDistance; distance > lodDistance && lod + 1 < NUM_LODS; lodDistance *= 2 )
+            lod++;
+
+        mPatches[patchIndex].mLod = lod;
+    }
+
+    // Stitching only handles neighbours one LOD apart, refine the patches until it's true.
+    Bool changed = true;
+    for( UInt32 pass = 0; changed && pass < NUM_LODS; pass++ )
+    {
+        changed = false;
+        for( UInt32 i = 0; i < mResidentPatches.size(); i++ )
+        {
+            UInt32 patchIndex = mResidentPatches[i];
+            UInt32 x = patchIndex % mNumPatches;
+            UInt32 z = patchIndex / mNumPatches;
+            Patch& patch = mPatches[patchIndex];
+
+            const Patch* neighbours[4] = { x > 0               ? &mPatches[patchIndex - 1]           : NULL,
+                                           x + 1 < mNumPatches ? &mPatches[patchIndex + 1]           : NULL,
+                                           z > 0               ? &mPatches[patchIndex - mNumPatches] : NULL,
+                                           z + 1 < mNumPatches ? &mPatches[patchIndex + mNumPatches] : NULL };
+
+            for( UInt32 n = 0; n < 4; n++ )
             {
-                indices[i+0] = n;
-                indices[i+1] = n + mMapSize;
-                indices[i+2] = n + 1;                
-
-                indices[i+3] = n + mMapSize;
-                indices[i+4] = n + mMapSize + 1;
-                indices[i+5] = n + 1;
-                
-                i += 6;
+                if( neighbours[n] && neighbours[n]->mSlot != -1 && patch.mLod > neighbours[n]->mLod + 1 )
+                {
+                    patch.mLod = neighbours[n]->mLod + 1;
+                    changed = true;
+                }
             }
+        }
+    }
 
-            n++;
+    for( UInt32 i = 0; i < mResidentPatches.size(); i++ )
+    {
+        UInt32 patchIndex = mResidentPatches[i];
+        UInt32 x = patchIndex % mNumPatches;
+        UInt32 z = patchIndex / mNumPatches;
+        Patch& patch = mPatches[patchIndex];
+
+        const Patch* neighbours[4] = { x > 0               ? &mPatches[patchIndex - 1]           : NULL,
+                                       x + 1 < mNumPatches ? &mPatches[patchIndex + 1]           : NULL,
+                                       z > 0               ? &mPatches[patchIndex - mNumPatches] : NULL,
+                                       z + 1 < mNumPatches ? &mPatches[patchIndex + mNumPatches] : NULL };
+        const Edge edges[4] = { Edge_NegX, Edge_PosX, Edge_NegZ, Edge_PosZ };
+
+        patch.mStitchMask = 0;
+        for( UInt32 n = 0; n < 4; n++ )
+        {
+            if( neighbours[n] && neighbours[n]->mSlot != -1 && neighbours[n]->mLod > patch.mLod )
+                patch.mStitchMask |= edges[n];
         }
     }
+}
+
+void Terrain::BuildPatchVertices( UInt32 pPatchX, UInt32 pPatchZ, Vector3f* pPoints, Vector3f* pNormals, Vector2f* pTexCoords, Float& pMinHeight, Float& pMaxHeight ) const
+{
+    Int32 startX = pPatchX * PATCH_QUADS;
+    Int32 startZ = pPatchZ * PATCH_QUADS;
+    Float halfWidth = mMapWidth * 0.5f;
 
-    // First pass, compute face normals.
-    for( i = 0; i < nbTrianglesIndex; i += 3 )
+    pMinHeight = FLT_MAX;
+    pMaxHeight = -FLT_MAX;
+
+    UInt32 n = 0;
+    for( UInt32 z = 0; z < PATCH_VERTICES; z++ )
     {
-        Vector3f v1 = points[indices[i+1]] - points[indices[i+0]];
-        Vector3f v2 = points[indices[i+2]] - points[indices[i+0]];
+        for( UInt32 x = 0; x < PATCH_VERTICES; x++, n++ )
+        {
+            Int32 mapX = startX + x;
+            Int32 mapZ = startZ + z;
 
-        Vector3f vn = (v1 cross v2).Normalize();
+            Float height = GetHeight( mapX, mapZ );
+            pMinHeight = Maths::Min( pMinHeight, height );
+            pMaxHeight = Maths::Max( pMaxHeight, height );
 
-        // Add normal to each point in the triangle.
-        normals[indices[i+0]] += vn;
-        normals[indices[i+1]] += vn;
-        normals[indices[i+2]] += vn;
-    }
+            pPoints[n].x = mapX * SAMPLE_SPACING - halfWidth;
+            pPoints[n].y = height;
+            pPoints[n].z = mapZ * SAMPLE_SPACING - halfWidth;
 
-    // Second pass, normalize!
-    for( i = 0; i < nbPoints; i++ )
-        normals[i].Normalize();
+            // Normal from the heightmap gradient, identical on both sides of a patch border.
+            pNormals[n].x = GetHeight( mapX - 1, mapZ ) - GetHeight( mapX + 1, mapZ );
+            pNormals[n].y = 2 * SAMPLE_SPACING;
+            pNormals[n].z = GetHeight( mapX, mapZ - 1 ) - GetHeight( mapX, mapZ + 1 );
+            pNormals[n].Normalize();
 
-    //TriangleBatch triangleStrip;
-    //terrainTriangles.Stripify( triangleStrip );
-    //terrainVertice.Reorder( triangleStrip );
-    
-    mBufPositions = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
-    mBufPositions->Create( terrainVertice.GetVertexCount(), sizeof(Vector3f), VertexBuffer::Usage_Static );
+            // Find the (u, v) coordinate for the current vertex
+            pTexCoords[n].x = (Float)mapX / (Float)mMapSize;
+            pTexCoords[n].y = (Float)mapZ / (Float)mMapSize;
+        }
+    }
+}
 
-    mBufNormals = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
-    mBufNormals->Create( terrainVertice.GetVertexCount(), sizeof(Vector3f), VertexBuffer::Usage_Static );
+Int32 Terrain::AllocateSlot()
+{
+    if( !mFreeSlots.empty() )
+    {
+        Int32 slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        return slot;
+    }
 
-    mBufTexCoords = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
-    mBufTexCoords->Create( terrainVertice.GetVertexCount(), sizeof(Vector2f), VertexBuffer::Usage_Static );
+    UInt32 numVertices = PATCH_VERTICES * PATCH_VERTICES;
+    PatchBuffers buffers;
 
-    mBufIndices = Cast<IndexBuffer>( GraphicSubsystem::Instance()->Create( IndexBuffer::StaticClass() ) );
-    mBufIndices->Create( terrainTriangles.GetIndicesCount(), sizeof(UInt16), IndexBuffer::Usage_Static );
+    buffers.mPositions = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
+    buffers.mPositions->Create( numVertices, sizeof(Vector3f), VertexBuffer::Usage_Static );
 
-    Vector3f* pointsBuf     = reinterpret_cast<Vector3f*>(mBufPositions->Lock( VertexBuffer::Lock_Write ));
-    Vector3f* normalsBuf    = reinterpret_cast<Vector3f*>(mBufNormals->Lock( VertexBuffer::Lock_Write ));
-    Vector2f* texCoordsBuf  = reinterpret_cast<Vector2f*>(mBufTexCoords->Lock( VertexBuffer::Lock_Write ));
-    UInt16*   indicesBuf    = reinterpret_cast<UInt16*>(mBufIndices->Lock( IndexBuffer::Lock_Write ));
+    buffers.mNormals = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
+    buffers.mNormals->Create( numVertices, sizeof(Vector3f), VertexBuffer::Usage_Static );
 
-    memcpy( pointsBuf, terrainVertice.GetPositions(), mBufPositions->GetItemCount() * mBufPositions->GetItemSize() );
-    memcpy( normalsBuf, terrainVertice.GetNormals(), mBufNormals->GetItemCount() * mBufNormals->GetItemSize() );
-    memcpy( texCoordsBuf, terrainVertice.GetTextureCoords(), mBufTexCoords->GetItemCount() * mBufTexCoords->GetItemSize() );
-    memcpy( indicesBuf, terrainTriangles.GetIndices(), mBufIndices->GetItemCount() * mBufIndices->GetItemSize() );
+    buffers.mTexCoords = Cast<VertexBuffer>( GraphicSubsystem::Instance()->Create( VertexBuffer::StaticClass() ) );
+    buffers.mTexCoords->Create( numVertices, sizeof(Vector2f), VertexBuffer::Usage_Static );
 
-    mBufPositions->Unlock();
-    mBufNormals->Unlock();
-    mBufTexCoords->Unlock();
-    mBufIndices->Unlock();
+    mBufferPool.push_back( buffers );
+    return mBufferPool.size() - 1;
 }
 
-Byte Terrain::GetHeight( UInt32 pX, UInt32 pZ )
+BoundingBox Terrain::GetPatchBounds( UInt32 pPatchIndex ) const
 {
-    UInt32 x = pX % mMapSize;
-    UInt32 z = pZ % mMapSize;
+    const Patch& patch = mPatches[pPatchIndex];
+    Float patchWidth = PATCH_QUADS * SAMPLE_SPACING;
+    Float halfWidth  = mMapWidth * 0.5f;
+    Float minX = (pPatchIndex % mNumPatches) * patchWidth - halfWidth;
+    Float minZ = (pPatchIndex / mNumPatches) * patchWidth - halfWidth;
+
+    return BoundingBox( Vector3f(minX, patch.mMinHeight, minZ),
+                        Vector3f(minX + patchWidth, patch.mMaxHeight, minZ + patchWidth) );
+}
 
+Float Terrain::GetHeight( Int32 pX, Int32 pZ ) const
+{
     if( !mHeightData )
         return 0;
 
-    return mHeightData[x + (z * mMapSize)];
+    // Clamp to the map borders.
+    UInt32 x = Maths::Min<Int32>( Maths::Max<Int32>(pX, 0), mMapSize - 1 );
+    UInt32 z = Maths::Min<Int32>( Maths::Max<Int32>(pZ, 0), mMapSize - 1 );
+
+    return mHeightData[x + (z * mMapSize)] * HEIGHT_SCALE;
 }
 
 void Terrain::SetTexture(const String& pTextureName)
 {
     mTextureName = pTextureName;
     mTexture.GetTexture( mTextureName );
+    MarkDirty();
 }
 
 const String& Terrain::GetTextureName() const
@@ -236,6 +574,30 @@ const String& Terrain::GetTextureName() const
     return mTextureName;
 }
 
+void Terrain::Serialize( Stream& pStream )
+{
+    Super::Serialize( pStream );
+    SerializeProperties( pStream );
+
+    if( pStream.In() )
+        SetTexture( mTextureName );
+}
+
+UInt32 Terrain::GetNbRenderedPatches() const
+{
+    return mNbRenderedPatches;
+}
+
+UInt32 Terrain::GetNbRenderedTriangles() const
+{
+    return mNbRenderedTriangles;
+}
+
+UInt32 Terrain::GetNbResidentPatches() const
+{
+    return mResidentPatches.size();
+}
+
 IMPLEMENT_CLASS(Terrain);
 
 
@@ -30,8 +30,10 @@
 
 
 #include "Entity.h"
+#include "Maths/Vector2.h"
 #include "Graphic/Texture/TextureHdl.h"
 #include "Input/Keyboard.h"
+#include "FileManager/MemoryFile.h"
 
 
 namespace Gamedesk {
@@ -42,6 +44,13 @@ class VertexBuffer;
 class IndexBuffer;
 
 
+/**
+ *  Heightmap terrain split in square patches (geomipmapping).
+ *  The heightmap is memory mapped, only the patches around the camera are
+ *  resident in vertex buffers. Each resident patch uses one of NUM_LODS index
+ *  sets, selected by distance, with a stitched variant for every combination
+ *  of coarser neighbours to avoid cracks. Patches are frustum culled.
+ */
 class ENGINE_API Terrain : public Entity
 {
     DECLARE_CLASS(Terrain, Entity)
@@ -49,41 +58,121 @@ class ENGINE_API Terrain : public Entity
 public:
     //! Default constructor.
 	Terrain();
-   
+
     //! Destructor.
     virtual ~Terrain();
 
+    //! Stream patches in/out around the camera and select their LOD.
+    virtual void Update( Double pElapsedTime );
+
     //! Render the model.
     virtual void Render() const;
 
     void SetTexture(const String& pTextureName);
     const String& GetTextureName() const;
 
+    virtual void Serialize( Stream& pStream );
+
+    //! Number of patches drawn during the last Render().
+    UInt32 GetNbRenderedPatches() const;
+
+    //! Number of triangles submitted during the last Render().
+    UInt32 GetNbRenderedTriangles() const;
+
+    //! Number of patches currently resident in vertex buffers.
+    UInt32 GetNbResidentPatches() const;
+
 properties:
     //! Texture name (does nothing...)
     String mTextureName;
 
 private:
-    void    LoadRawFile( const String& pHeightMapFile );
-    void    BuildBuffers();
+    static const UInt32 PATCH_QUADS     = 32;               //!< Quads per patch side.
+    static const UInt32 PATCH_VERTICES  = PATCH_QUADS + 1;  //!< Vertices per patch side.
+    static const UInt32 NUM_LODS        = 6;                //!< Step of 1, 2, 4, ... PATCH_QUADS.
+
+    //! Patch edges, used to tell which neighbours are rendered at a coarser LOD.
+    enum Edge
+    {
+        Edge_NegX   = 1 << 0,
+        Edge_PosX   = 1 << 1,
+        Edge_NegZ   = 1 << 2,
+        Edge_PosZ   = 1 << 3,
+        Edge_Combinations = 16
+    };
+
+    class Patch
+    {
+    public:
+        Patch() : mMinHeight(0), mMaxHeight(0), mSlot(-1), mLod(0), mStitchMask(0)
+        {
+        }
+
+        Float       mMinHeight;
+        Float       mMaxHeight;
+        Int32       mSlot;          //!< Index in the vertex buffer pool, -1 when not resident.
+        Byte        mLod;
+        Byte        mStitchMask;    //!< Edges whose neighbour is one LOD coarser.
+    };
+
+    class PatchBuffers
+    {
+    public:
+        VertexBuffer*   mPositions;
+        VertexBuffer*   mNormals;
+        VertexBuffer*   mTexCoords;
+    };
+
+    class IndexRange
+    {
+    public:
+        UInt32      mStart;
+        UInt32      mCount;
+    };
+
+    friend class TerrainPatchBuilder;
 
-    Byte    GetHeight( UInt32 pX, UInt32 pZ );
+private:
+    void    OpenHeightMap( const String& pHeightMapFile );
+    void    BuildIndexBuffer();
+
+    void    StreamPatches( const Vector3f& pCameraPos );
+    void    SelectLods( const Vector3f& pCameraPos );
+
+    void    BuildPatchVertices( UInt32 pPatchX, UInt32 pPatchZ, Vector3f* pPoints, Vector3f* pNormals, Vector2f* pTexCoords, Float& pMinHeight, Float& pMaxHeight ) const;
+    Int32   AllocateSlot();
+
+    BoundingBox GetPatchBounds( UInt32 pPatchIndex ) const;
+    Float   GetHeight( Int32 pX, Int32 pZ ) const;
 
 private:
     HTexture2D          mTexture;
-    
-    VertexBuffer*       mBufPositions;
-    VertexBuffer*       mBufNormals;
-    VertexBuffer*       mBufTexCoords;
-    IndexBuffer*        mBufIndices; 
 
+    MemoryFile          mHeightMap;
+    const Byte*         mHeightData;
     UInt32              mMapSize;
     Float               mMapWidth;
-    Byte*               mHeightData;
+
+    UInt32              mNumPatches;            //!< Patches per side.
+    Vector<Patch>       mPatches;
+    Vector<UInt32>      mResidentPatches;
+
+    Vector<PatchBuffers> mBufferPool;
+    Vector<Int32>       mFreeSlots;
+
+    IndexBuffer*        mBufIndices;
+    IndexRange          mIndexRanges[NUM_LODS][Edge_Combinations];
+
+    Float               mStreamRadius;          //!< Patches closer than this are loaded.
+    Float               mLodDistance;           //!< Distance at which LOD 1 kicks in, doubles for each LOD.
+    UInt32              mMaxLoadsPerFrame;
+
+    mutable UInt32      mNbRenderedPatches;
+    mutable UInt32      mNbRenderedTriangles;
 };
 
 
 } // namespace Gamedesk
 
 
-#endif  //  _SKY_DOME_H_
\ No newline at end of file
+#endif  //  _TERRAIN_H_
@@ -27,12 +27,15 @@
 #include "World/Entity.h"
 
 
+class TestPropertiesAccess;     // Unit tests.
+
 namespace Gamedesk {
 
 
 class ENGINE_API TestProperties : public Entity
 {
     DECLARE_CLASS(TestProperties, Entity);
+    friend class ::TestPropertiesAccess;
 
 public:
     TestProperties() 
@@ -58,6 +61,12 @@ public:
     
     virtual ~TestProperties() {}
 
+    virtual void Serialize( Stream& pStream )
+    {
+        Super::Serialize( pStream );
+        SerializeProperties( pStream );
+    }
+
     //! MyEnum
     enum MyEnum
     {
@@ -54,7 +54,10 @@
 #include "Graphic/GraphicSubsystem.h"
 #include "Graphic/Renderer.h"
 #include "Graphic/RenderTarget/RenderTarget.h"
+#include "Graphic/Texture/TextureManager.h"
+#include "Graphic/Mesh/SkeletalMesh.h"
 #include "Debug/PerformanceMonitor.h"
+#include "Thread/JobManager.h"
 
 
 namespace Gamedesk {
@@ -63,6 +66,52 @@ namespace Gamedesk {
 IMPLEMENT_CLASS(World);
 
 
+/**
+ *  Evaluate the skeleton pose of a range of skeletal meshes.
+ */
+class PoseJobBody : public ParallelForBody
+{
+public:
+    PoseJobBody( Vector<SkeletalMesh*>& pMeshes, Vector<Float>& pTimes )
+        : mMeshes(pMeshes)
+        , mTimes(pTimes)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+            mMeshes[i]->EvaluatePose( mTimes[i] );
+    }
+
+private:
+    Vector<SkeletalMesh*>&  mMeshes;
+    Vector<Float>&          mTimes;
+};
+
+
+/**
+ *  Skin a range of skeletal meshes using their last evaluated pose.
+ */
+class SkinJobBody : public ParallelForBody
+{
+public:
+    SkinJobBody( Vector<SkeletalMesh*>& pMeshes )
+        : mMeshes(pMeshes)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+            mMeshes[i]->Skin();
+    }
+
+private:
+    Vector<SkeletalMesh*>&  mMeshes;
+};
+
+
 World::World() :
     mCurrentCamera(NULL),
     mNbRenderedEntities(0),
@@ -132,6 +181,7 @@ void World::Kill()
 void World::AddCamera(Camera* pCamera)
 {
     mCameras.push_back( pCamera );
+    MarkDirty();
 }
 
 void World::RemoveCamera(Camera* pCamera)
@@ -141,6 +191,8 @@ void World::RemoveCamera(Camera* pCamera)
     {
         mCurrentCamera = 0;
     }
+
+    MarkDirty();
 }
 
 void World::SetCurrentCamera( UInt32 pCameraIndex )
@@ -152,6 +204,7 @@ void World::SetCurrentCamera( UInt32 pCameraIndex )
         itCamera++;
 
     mCurrentCamera = *itCamera;
+    MarkDirty();
 }
 
 void World::NextCamera()
@@ -218,6 +271,8 @@ void World::InsertEntity( Entity* pEntity )
 
     if( pEntity->IsA( Camera::StaticClass() ) )
         AddCamera( Cast<Camera>( pEntity ) );
+
+    MarkDirty();
 }
 
 void World::RemoveEntity( Entity* pEntity )
@@ -228,6 +283,8 @@ void World::RemoveEntity( Entity* pEntity )
 
     if( pEntity->IsA( Camera::StaticClass() ) )
         RemoveCamera( Cast<Camera>( pEntity ) );
+
+    MarkDirty();
 }
 
 const List<Entity*>& World::GetEntities() const
@@ -237,10 +294,67 @@ const List<Entity*>& World::GetEntities() const
 
 void World::Update( Double pElapsedTime )
 {
+    {Profile("Entities");
     // Update all the objects in the world.
     List<Entity*>::const_iterator itEntity;
     for(itEntity = mEntities.begin(); itEntity != mEntities.end(); ++itEntity)
         (*itEntity)->Update(pElapsedTime);
+    }
+
+    UpdateAnimations();
+}
+
+void World::UpdateAnimations()
+{
+    Profile("Animation");
+
+    // Collect the skeletal meshes, a mesh shared by several models is only animated once.
+    mAnimatedMeshes.clear();
+    mAnimatedModels.clear();
+    mAnimTimes.clear();
+
+    List<Entity*>::const_iterator itEntity;
+    for(itEntity = mEntities.begin(); itEntity != mEntities.end(); ++itEntity)
+    {
+        if( !(*itEntity)->IsA(Model3D::StaticClass()) )
+            continue;
+
+        Mesh* mesh = Cast<Model3D>(*itEntity)->GetMesh();
+        if( mesh == NULL || !mesh->IsA(SkeletalMesh::StaticClass()) )
+            continue;
+
+        mAnimatedModels.push_back( Cast<Model3D>(*itEntity) );
+
+        SkeletalMesh* skeletalMesh = Cast<SkeletalMesh>(mesh);
+        if( std::find(mAnimatedMeshes.begin(), mAnimatedMeshes.end(), skeletalMesh) == mAnimatedMeshes.end() )
+        {
+            mAnimatedMeshes.push_back( skeletalMesh );
+            mAnimTimes.push_back( skeletalMesh->UpdateAnimTime() );
+        }
+    }
+
+    if( mAnimatedMeshes.empty() )
+        return;
+
+    {Profile("Pose");
+    PoseJobBody poseBody( mAnimatedMeshes, mAnimTimes );
+    JobManager::Instance()->ParallelFor( mAnimatedMeshes.size(), 1, poseBody );
+    }
+
+    {Profile("Skin");
+    SkinJobBody skinBody( mAnimatedMeshes );
+    JobManager::Instance()->ParallelFor( mAnimatedMeshes.size(), 1, skinBody );
+    }
+
+    // The skinning grew the bounding boxes of the meshes.
+    for( UInt32 i = 0; i < mAnimatedModels.size(); i++ )
+        mAnimatedModels[i]->UpdateBoundingBox();
+
+    // Buffers can only be locked from the render thread.
+    {Profile("Upload");
+    for( UInt32 i = 0; i < mAnimatedMeshes.size(); i++ )
+        mAnimatedMeshes[i]->UploadBuffers();
+    }
 }
 
 void World::Render()
@@ -335,6 +449,13 @@ void World::Render()
 
 	mNbRenderedEntities = 0;
 
+    // Find what the space partition can see from the camera, and render its own geometry.
+    if( mSpacePartition )
+    {
+        mSpacePartition->UpdateVisibility( currentCamera->GetPosition(), frustum );
+        mSpacePartition->Render();
+    }
+
     // Render the objects in the world.
     /*
     List<Entity*> visibleEntities;
@@ -394,6 +515,9 @@ void World::Render()
     renderer->LoadIdentity();
     currentCamera->ApplyViewMatrix();
 
+    // Stream in the mipmaps requested while rendering.
+    TextureManager::Instance().Update();
+
     //renderer->EndScene();
 }
 
@@ -430,9 +554,10 @@ Entity* World::LineTrace( const Vector3f& pOrigin, const Vector3f& pDir )
     return NULL;
 }
 
-void World::SaveWorld( const String& pFilename )
+void World::SaveWorld( const String& pFilename, Compression::Codec pCodec, Int32 pLevel )
 {
     Package* package = PackageManager::Instance()->CreatePackage( pFilename );
+    package->SetCompression( pCodec, pLevel );
 
     SetOwner( package );
     package->Save();
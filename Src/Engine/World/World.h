@@ -31,6 +31,7 @@
 
 #include "Maths/Vector3.h"
 #include "Maths/Quaternion.h"
+#include "Stream/Compression.h"
 
 
 #include "Containers/Containers.h"
@@ -42,6 +43,8 @@ namespace Gamedesk {
 class Entity;
 class Camera;
 class SpacePartition;
+class SkeletalMesh;
+class Model3D;
 
 
 /**
@@ -100,7 +103,15 @@ public:
 
     Entity* LineTrace( const Vector3f& pOrigin, const Vector3f& pDir );
 
-    void SaveWorld( const String& pFilename );
+    /**
+     *  Save the world in a package file.
+     *  @param  pFilename   Name of the package file.
+     *  @param  pCodec      Codec used to compress the file.
+     *  @param  pLevel      Compression level, see Compression.
+     */
+    void SaveWorld( const String& pFilename, Compression::Codec pCodec = Compression::Codec_None, Int32 pLevel = Compression::LEVEL_FAST );
+
+    //! Load the world from a package file, compressed or not.
     void LoadWorld( const String& pFilename );
 
     virtual void Serialize( Stream& pStream );
@@ -108,6 +119,10 @@ public:
     void InsertEntity( Entity* pEntity );
     void RemoveEntity( Entity* pEntity );
 
+private:
+    //! Animate every skeletal mesh of the world, poses and skinning are done in parallel.
+    void UpdateAnimations();
+
 private:
     List<Camera*>			mCameras;
     Camera*					mCurrentCamera;
@@ -116,6 +131,10 @@ private:
     List<Entity*>			mEntities;
 
     UInt32                  mNbRenderedEntities;
+
+    Vector<SkeletalMesh*>   mAnimatedMeshes;
+    Vector<Model3D*>        mAnimatedModels;
+    Vector<Float>           mAnimTimes;
     
     Bool                    mWorldInitialized;
 };
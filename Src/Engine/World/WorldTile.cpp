@@ -34,9 +34,14 @@
 #include "Graphic/Shader/ShaderProgram.h"
 #include "Graphic/Shader/ShaderObject.h"
 #include "Graphic/Texture/Texture.h"
+#include "Graphic/Texture/TextureManager.h"
 #include "Graphic/Renderer.h"
 #include "Graphic/GraphicSubsystem.h"
 
+#include "World/Camera.h"
+#include "Maths/Frustum.h"
+#include "Debug/PerformanceMonitor.h"
+
 
 namespace Gamedesk {
 	
@@ -44,8 +49,33 @@ namespace Gamedesk {
 IMPLEMENT_CLASS(WorldTile);
 
 
+static const UInt32 MAX_TEXTURE_LAYERS = 4;
+
+
+//! Sort predicate used to group chunks using the same textures.
+class WorldTile::ChunkTextureOrder
+{
+public:
+    Bool operator () ( const TerrainChunk* pLeft, const TerrainChunk* pRight ) const
+    {
+        return pLeft->UsesTexturesBefore( *pRight );
+    }
+};
+
+
 //! Default constructor.
 WorldTile::WorldTile()
+    : mTerrainPositions(NULL)
+    , mTerrainNormals(NULL)
+    , mTerrainTexCoords(NULL)
+    , mTerrainTexCoords_2(NULL)
+    , mTerrainIndices(NULL)
+    , mPixelShader(NULL)
+    , mVertexShader(NULL)
+    , mShaderProgram(NULL)
+    , mHiResDistance(10.0f)
+    , mNbRenderedChunks(0)
+    , mNbHiResChunks(0)
 {
 }
 
@@ -57,6 +87,18 @@ WorldTile::~WorldTile()
         GD_DELETE(*itChunk);
     
     mTerrainChunks.clear();
+    mRenderOrder.clear();
+
+    if( mTerrainPositions )
+        GD_DELETE(mTerrainPositions);
+    if( mTerrainNormals )
+        GD_DELETE(mTerrainNormals);
+    if( mTerrainTexCoords )
+        GD_DELETE(mTerrainTexCoords);
+    if( mTerrainTexCoords_2 )
+        GD_DELETE(mTerrainTexCoords_2);
+    if( mTerrainIndices )
+        GD_DELETE(mTerrainIndices);
 }
 
 void WorldTile::Init()
@@ -122,37 +164,87 @@ void WorldTile::Init()
         mTerrainTexCoords_2->Unlock();
     }
 
+    // Both strips of every chunk go in the same index buffer, hi res first.
+    UInt32 totalIndices = 0;
+    Vector<TerrainChunk*>::iterator itChunk;
+    for( itChunk = mTerrainChunks.begin(); itChunk != mTerrainChunks.end(); ++itChunk )
+    {
+        totalIndices += (*itChunk)->GetHiResTriangles().GetIndicesCount();
+        totalIndices += (*itChunk)->GetLowResTriangles().GetIndicesCount();
+    }
+
     // Indices buffer
     mTerrainIndices = Cast<IndexBuffer>( GraphicSubsystem::Instance()->Create( IndexBuffer::StaticClass() ) );
-    mTerrainIndices->Create( 40448, sizeof(UInt16), IndexBuffer::Usage_Static );
+    mTerrainIndices->Create( totalIndices, sizeof(UInt16), IndexBuffer::Usage_Static );
+
+    const Vector3f* positions = mVertexList.GetPositions();
+    mBoundingBox = BoundingBox();
 
     UInt16* indices = reinterpret_cast<UInt16*>(mTerrainIndices->Lock( IndexBuffer::Lock_Write ));
     UInt32  numIndices = 0;
-    if( indices )
+    for( itChunk = mTerrainChunks.begin(); itChunk != mTerrainChunks.end(); ++itChunk )
     {
-        Vector<TerrainChunk*>::iterator itChunk;
-        UInt32 iChunk = 0;
+        TerrainChunk* chunk = *itChunk;
 
-        for( itChunk = ((WorldTile*)this)->mTerrainChunks.begin(); itChunk != ((WorldTile*)this)->mTerrainChunks.end(); ++itChunk, iChunk++ )
-        {
-            UInt16* chunkIndices = (*itChunk)->GetLowResTriangles().GetIndices();
-            UInt32  indicesCount = (*itChunk)->GetLowResTriangles().GetIndicesCount();
+        UInt16* hiIndices  = chunk->GetHiResTriangles().GetIndices();
+        UInt32  hiCount    = chunk->GetHiResTriangles().GetIndicesCount();
+        UInt16* lowIndices = chunk->GetLowResTriangles().GetIndices();
+        UInt32  lowCount   = chunk->GetLowResTriangles().GetIndicesCount();
+
+        chunk->mOffsetHi  = numIndices;
+        chunk->mOffsetLow = numIndices + hiCount;
 
-            memcpy( indices, chunkIndices, indicesCount*sizeof(UInt16) );
-            numIndices += indicesCount;
-            indices	   += indicesCount;
-            iChunk++;
+        if( indices )
+        {
+            memcpy( indices, hiIndices, hiCount*sizeof(UInt16) );
+            memcpy( indices + hiCount, lowIndices, lowCount*sizeof(UInt16) );
+            indices += hiCount + lowCount;
         }
-    }        
+        numIndices += hiCount + lowCount;
+
+        // The hi res strip references every vertex of the chunk.
+        chunk->mBoundingBox = BoundingBox();
+        for( UInt32 i = 0; i < hiCount; i++ )
+            chunk->mBoundingBox.Grow( positions[hiIndices[i]] );
+
+        mBoundingBox.Grow( chunk->mBoundingBox.Min() );
+        mBoundingBox.Grow( chunk->mBoundingBox.Max() );
+    }
     mTerrainIndices->Unlock();
+
+    mRenderOrder = mTerrainChunks;
+    std::sort( mRenderOrder.begin(), mRenderOrder.end(), ChunkTextureOrder() );
 }
 
 //! Render the model.
 void WorldTile::Render() const
 {
+    Profile("WorldTile Render");
+
     Renderer* renderer = GraphicSubsystem::Instance()->GetRenderer();
     GD_ASSERT(renderer);
 
+    mNbRenderedChunks = 0;
+    mNbHiResChunks = 0;
+
+    // The model view matrix contains the tile transformation,
+    // so the frustum is expressed in the tile space.
+    Matrix4f modelViewMatrix;
+    Matrix4f projectionMatrix;
+    Frustum  frustum;
+    renderer->GetModelViewMatrix(modelViewMatrix);
+    renderer->GetProjectionMatrix(projectionMatrix);
+    frustum.CalculateFrustum(projectionMatrix, modelViewMatrix);
+
+    if( !frustum.BoxInFrustum( mBoundingBox ) )
+        return;
+
+    // Without a camera, every chunk is drawn with its low res strip.
+    Bool     useHiRes = mWorld && mWorld->GetCurrentCamera();
+    Vector3f cameraPos;
+    if( useHiRes )
+        cameraPos = mWorld->GetCurrentCamera()->GetPosition() - GetPosition();
+
     renderer->SetVertexFormat( VertexFormat::Component(VertexFormat::Position3 | VertexFormat::TexCoord2 | VertexFormat::TexCoord2_2 | VertexFormat::Normal3) );
     renderer->SetStreamSource( VertexFormat::Position3,   mTerrainPositions );
     renderer->SetStreamSource( VertexFormat::TexCoord2,   mTerrainTexCoords );
@@ -169,91 +261,76 @@ void WorldTile::Render() const
     mShaderProgram->SetSampler( "Alpha1", 4 );
     mShaderProgram->SetSampler( "Alpha2", 5 );
     mShaderProgram->SetSampler( "Alpha3", 6 );
-    
 
-    //renderer->SetBlendFunc( Renderer::BlendSrcAlpha, Renderer::BlendInvSrcAlpha );
+    // Textures currently bound, chunks are sorted so consecutive chunks
+    // often share their layers. Alpha maps are unique to each chunk.
+    Texture2D* boundTextures[MAX_TEXTURE_LAYERS] = { NULL, NULL, NULL, NULL };
+    Int32      boundLayerCount = -1;
 
-    UInt32 startIndex = 0;
-	Vector<TerrainChunk*>::iterator itChunk;
-	for( itChunk = ((WorldTile*)this)->mTerrainChunks.begin(); itChunk != ((WorldTile*)this)->mTerrainChunks.end(); ++itChunk )
-    {
-		UInt32 indicesCount = (*itChunk)->GetLowResTriangles().GetIndicesCount();
-        Int32 layerCount   = (*itChunk)->GetLayerCount();
-        
-        mShaderProgram->SetUniform( "LayerCount", layerCount );
-
-        switch( layerCount )
-        {
-        case 4:
-            renderer->GetTextureStage(3)->SetTexture( (*itChunk)->GetTexture(3) );
-            renderer->GetTextureStage(6)->SetTexture( (*itChunk)->GetAlphaMap(3) );
+    Float hiResDistanceSq = mHiResDistance * mHiResDistance;
+    Float screenScale = TextureManager::GetScreenScale();
 
-        case 3:
-            renderer->GetTextureStage(2)->SetTexture( (*itChunk)->GetTexture(2) );
-            renderer->GetTextureStage(5)->SetTexture( (*itChunk)->GetAlphaMap(2) );
+	Vector<TerrainChunk*>::const_iterator itChunk;
+	for( itChunk = mRenderOrder.begin(); itChunk != mRenderOrder.end(); ++itChunk )
+    {
+        TerrainChunk* chunk = *itChunk;
+        const BoundingBox& bounds = chunk->GetBoundingBox();
 
-        case 2:
-            renderer->GetTextureStage(1)->SetTexture( (*itChunk)->GetTexture(1) );
-            renderer->GetTextureStage(4)->SetTexture( (*itChunk)->GetAlphaMap(1) );
+        if( !frustum.BoxInFrustum( bounds ) )
+            continue;
 
-        case 1:
-            renderer->GetTextureStage(0)->SetTexture( (*itChunk)->GetTexture(0) );
+        Int32 layerCount = Maths::Min<Int32>( chunk->GetLayerCount(), MAX_TEXTURE_LAYERS );
+        if( layerCount != boundLayerCount )
+        {
+            mShaderProgram->SetUniform( "LayerCount", layerCount );
+            boundLayerCount = layerCount;
         }
-        
-        renderer->DrawIndexedPrimitive( Renderer::TriangleStrip, startIndex, indicesCount );
-
-        startIndex += indicesCount;
 
-        /*if( layerCount < 1 )
+        for( Int32 iLayer = 0; iLayer < layerCount; iLayer++ )
         {
-            startIndex += indicesCount;
-            continue;
+            Texture2D* texture = chunk->GetTexturePtr(iLayer);
+            if( texture != boundTextures[iLayer] )
+            {
+                renderer->GetTextureStage(iLayer)->SetTexture( chunk->GetTexture(iLayer) );
+                boundTextures[iLayer] = texture;
+            }
+
+            if( iLayer > 0 )
+                renderer->GetTextureStage(MAX_TEXTURE_LAYERS + iLayer - 1)->SetTexture( chunk->GetAlphaMap(iLayer) );
         }
-        
-        renderer->SetRenderState( Renderer::Blend, false );           
-        renderer->SetDepthFunc( Renderer::CmpLessEqual );
-        renderer->SetRenderState( Renderer::DepthMask, true );
-
-        renderer->GetTextureStage(0)->SetTexture( (*itChunk)->GetTexture(0) );
-        renderer->GetTextureStage(1)->ResetTexture();
-        renderer->DrawIndexedPrimitive( Renderer::TriangleStrip, startIndex, indicesCount );
 
-        if( layerCount < 2 )
+        // Distance from the camera to the closest point of the chunk.
+        Bool hiRes = false;
+        if( useHiRes )
         {
-            startIndex += indicesCount;
-            continue;
+            Vector3f closest( Maths::Min( Maths::Max(cameraPos.x, bounds.Min().x), bounds.Max().x ),
+                              Maths::Min( Maths::Max(cameraPos.y, bounds.Min().y), bounds.Max().y ),
+                              Maths::Min( Maths::Max(cameraPos.z, bounds.Min().z), bounds.Max().z ) );
+            Float distanceSq = (closest - cameraPos).GetLengthSqr();
+            hiRes = distanceSq < hiResDistanceSq;
+
+            // Layers span the whole chunk, ask for the resolution it covers on screen.
+            Float chunkSize  = Maths::Max( bounds.Max().x - bounds.Min().x, bounds.Max().z - bounds.Min().z );
+            Float screenSize = chunkSize * screenScale / Maths::Max( Maths::Sqrt(distanceSq), 1.0f );
+            for( Int32 iLayer = 0; iLayer < layerCount; iLayer++ )
+            {
+                Texture2D* texture = chunk->GetTexturePtr(iLayer);
+                if( texture )
+                    texture->RequestSize( screenSize );
+            }
         }
-        
-        renderer->SetRenderState( Renderer::Blend, true );
-        renderer->SetDepthFunc( Renderer::CmpEqual );
-        renderer->SetRenderState( Renderer::DepthMask, false );
-        
-        renderer->GetTextureStage(0)->SetTexture( (*itChunk)->GetTexture(1) );
-        renderer->GetTextureStage(1)->SetTexture( (*itChunk)->GetAlphaMap(1) );
-        renderer->DrawIndexedPrimitive( Renderer::TriangleStrip, startIndex, indicesCount );
-    
-        if( layerCount < 3 )
+
+        if( hiRes )
         {
-            startIndex += indicesCount;
-            continue;
+            renderer->DrawIndexedPrimitive( Renderer::TriangleStrip, chunk->mOffsetHi, chunk->mHiResTriangles.GetIndicesCount() );
+            mNbHiResChunks++;
         }
-
-        renderer->GetTextureStage(0)->SetTexture( (*itChunk)->GetTexture(2) );
-        renderer->GetTextureStage(1)->SetTexture( (*itChunk)->GetAlphaMap(2) );
-        renderer->DrawIndexedPrimitive( Renderer::TriangleStrip, startIndex, indicesCount );
-        
-        
-        if( layerCount < 4 )
+        else
         {
-            startIndex += indicesCount;
-            continue;
+            renderer->DrawIndexedPrimitive( Renderer::TriangleStrip, chunk->mOffsetLow, chunk->mLowResTriangles.GetIndicesCount() );
         }
 
-        renderer->GetTextureStage(0)->SetTexture( (*itChunk)->GetTexture(3) );
-        renderer->GetTextureStage(1)->SetTexture( (*itChunk)->GetAlphaMap(3) );
-        renderer->DrawIndexedPrimitive( Renderer::TriangleStrip, startIndex, indicesCount );
-        */
-		//startIndex += indicesCount;
+        mNbRenderedChunks++;
 	}
 
     mShaderProgram->Done();
@@ -266,11 +343,6 @@ void WorldTile::Render() const
     renderer->GetTextureStage(5)->ResetTexture();
     renderer->GetTextureStage(6)->ResetTexture();
     renderer->GetTextureStage(7)->ResetTexture();
-	    
-    //renderer->SetRenderState( Renderer::Blend, false );
-    //renderer->SetRenderState( Renderer::DepthMask, true );
-
-    //renderer->SetDepthFunc( Renderer::CmpLess );
 }
 
 VertexList& WorldTile::GetVertexList()
@@ -278,6 +350,32 @@ VertexList& WorldTile::GetVertexList()
     return mVertexList;
 }
 
+void WorldTile::SetHiResDistance( Float pDistance )
+{
+    mHiResDistance = pDistance;
+}
+
+Float WorldTile::GetHiResDistance() const
+{
+    return mHiResDistance;
+}
+
+UInt32 WorldTile::GetNbRenderedChunks() const
+{
+    return mNbRenderedChunks;
+}
+
+UInt32 WorldTile::GetNbHiResChunks() const
+{
+    return mNbHiResChunks;
+}
+
+WorldTile::TerrainChunk::TerrainChunk()
+    : mOffsetHi(0)
+    , mOffsetLow(0)
+{
+}
+
 void WorldTile::TerrainChunk::AddTextureLayer( const HTexture2D& pTexture, Texture2D* pAlphaMap )
 {
     TextureLayer newLayer;
@@ -305,6 +403,34 @@ Texture2D& WorldTile::TerrainChunk::GetAlphaMap( UInt32 pLayer )
     return *mTextureLayers[pLayer].mAlphaMap;
 }
 
+Texture2D* WorldTile::TerrainChunk::GetTexturePtr( UInt32 pLayer ) const
+{
+    GD_ASSERT( pLayer < mTextureLayers.size() );
+    const HTexture2D& texture = mTextureLayers[pLayer].mTexture;
+    return texture ? &(*texture) : NULL;
+}
+
+const BoundingBox& WorldTile::TerrainChunk::GetBoundingBox() const
+{
+    return mBoundingBox;
+}
+
+Bool WorldTile::TerrainChunk::UsesTexturesBefore( const TerrainChunk& pOther ) const
+{
+    UInt32 layerCount = Maths::Min( GetLayerCount(), pOther.GetLayerCount() );
+
+    for( UInt32 iLayer = 0; iLayer < layerCount; iLayer++ )
+    {
+        Texture2D* texture      = GetTexturePtr(iLayer);
+        Texture2D* otherTexture = pOther.GetTexturePtr(iLayer);
+
+        if( texture != otherTexture )
+            return texture < otherTexture;
+    }
+
+    return GetLayerCount() < pOther.GetLayerCount();
+}
+
 Vector<WorldTile::TerrainChunk*>& WorldTile::GetTerrainChunks()
 {
     return mTerrainChunks;
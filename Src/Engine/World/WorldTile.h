@@ -46,6 +46,12 @@ class ShaderProgram;
 class ShaderObject;
 
 
+/**
+ *  Terrain tile made of 16x16 chunks (WoW ADT). Each chunk has a hi and a low
+ *  resolution strip sharing the same vertices; the hi resolution one is used
+ *  for chunks closer than the hi resolution distance. Chunks are frustum
+ *  culled and drawn sorted by texture set to limit texture changes.
+ */
 class ENGINE_API WorldTile : public Entity
 {
     DECLARE_CLASS(WorldTile, Entity)
@@ -53,7 +59,11 @@ class ENGINE_API WorldTile : public Entity
 public:
     class ENGINE_API TerrainChunk
     {
+        friend class WorldTile;
+
     public:
+        TerrainChunk();
+
         TriangleBatch& GetHiResTriangles();
         TriangleBatch& GetLowResTriangles();
 
@@ -63,11 +73,21 @@ public:
         Texture2D& GetTexture( UInt32 pLayer );
         Texture2D& GetAlphaMap( UInt32 pLayer );
 
+        //! Bounds of the chunk, valid once the tile has been initialized.
+        const BoundingBox& GetBoundingBox() const;
+
+        //! Strict weak ordering on the set of textures used by the chunk.
+        Bool UsesTexturesBefore( const TerrainChunk& pOther ) const;
+
+    private:
+        Texture2D* GetTexturePtr( UInt32 pLayer ) const;
+
     private:
         TriangleBatch   mHiResTriangles;
         TriangleBatch   mLowResTriangles;
-        UInt32          mOffsetHi;
-        UInt32          mOffsetLow;
+        UInt32          mOffsetHi;          //!< Start of the hi res strip in the tile index buffer.
+        UInt32          mOffsetLow;         //!< Start of the low res strip in the tile index buffer.
+        BoundingBox     mBoundingBox;
 		
     private:
         class TextureLayer
@@ -95,7 +115,19 @@ public:
     VertexList& GetVertexList();
     Vector<TerrainChunk*>& GetTerrainChunks();
 
+    //! Chunks closer than this distance to the camera use their hi res strip.
+    void  SetHiResDistance( Float pDistance );
+    Float GetHiResDistance() const;
+
+    //! Number of chunks drawn during the last Render().
+    UInt32 GetNbRenderedChunks() const;
+
+    //! Number of chunks drawn with their hi res strip during the last Render().
+    UInt32 GetNbHiResChunks() const;
+
 private:
+    class ChunkTextureOrder;
+
     VertexList              mVertexList;
 
     VertexBuffer*           mTerrainPositions;
@@ -104,10 +136,16 @@ private:
     VertexBuffer*           mTerrainTexCoords_2;
     IndexBuffer*            mTerrainIndices;     
     Vector<TerrainChunk*>   mTerrainChunks;
+    Vector<TerrainChunk*>   mRenderOrder;       //!< Chunks sorted by texture set.
 
     ShaderObject*           mPixelShader;
     ShaderObject*           mVertexShader;
     ShaderProgram*          mShaderProgram;
+
+    Float                   mHiResDistance;
+
+    mutable UInt32          mNbRenderedChunks;
+    mutable UInt32          mNbHiResChunks;
 };
 
 
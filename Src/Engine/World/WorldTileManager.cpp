@@ -0,0 +1,223 @@
+/**
+ *  @file       WorldTileManager.cpp
+ *  @brief      Stream the tiles of a tiled map around the camera.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "Engine.h"
+#include "WorldTileManager.h"
+#include "WorldTile.h"
+
+#include "FileManager/FileManager.h"
+#include "Resource/ResourceManager.h"
+#include "World/Camera.h"
+#include "Debug/PerformanceMonitor.h"
+
+
+namespace Gamedesk {
+
+
+IMPLEMENT_CLASS(WorldTileManager);
+
+
+static const Int32 NUM_TILES    = 64;               //!< Tiles per side of a map.
+static const Float TILE_SIZE    = 53.333333f;       //!< Size of a tile once imported (ADT units scaled by 0.1).
+
+
+WorldTileManager::WorldTileManager()
+    : mLoadRadius(1)
+    , mHiResDistance(10.0f)
+    , mTilesPerUpdate(4)
+{
+}
+
+WorldTileManager::~WorldTileManager()
+{
+    UnloadAllTiles();
+}
+
+void WorldTileManager::SetMap( const String& pMapBaseName )
+{
+    UnloadAllTiles();
+    mMissingTiles.clear();
+    mMapBaseName = pMapBaseName;
+}
+
+void WorldTileManager::SetLoadRadius( UInt32 pRadius )
+{
+    mLoadRadius = pRadius;
+}
+
+void WorldTileManager::SetHiResDistance( Float pDistance )
+{
+    mHiResDistance = pDistance;
+
+    for( Map<UInt32, WorldTile*>::iterator itTile = mTiles.begin(); itTile != mTiles.end(); ++itTile )
+        itTile->second->SetHiResDistance( pDistance );
+}
+
+void WorldTileManager::SetTilesPerUpdate( UInt32 pTilesPerUpdate )
+{
+    mTilesPerUpdate = Maths::Max<UInt32>( pTilesPerUpdate, 1 );
+}
+
+void WorldTileManager::Update( Double /*pElapsedTime*/ )
+{
+    if( !mWorld || !mWorld->GetCurrentCamera() || mMapBaseName.empty() )
+        return;
+
+    Profile("WorldTileManager Update");
+
+    // Tiles are imported in world coordinates, tile (32,32) starts at the origin.
+    Vector3f cameraPos = mWorld->GetCurrentCamera()->GetPosition() - GetPosition();
+    Int32 cameraTileX = (Int32)floorf( cameraPos.x / TILE_SIZE ) + NUM_TILES / 2;
+    Int32 cameraTileY = (Int32)floorf( cameraPos.z / TILE_SIZE ) + NUM_TILES / 2;
+
+    // Release the tiles that are out of range. Keep one extra ring so moving
+    // back and forth over a tile border doesn't reload tiles.
+    Map<UInt32, WorldTile*>::iterator itTile = mTiles.begin();
+    while( itTile != mTiles.end() )
+    {
+        Int32 tileX = itTile->first & 0xFFFF;
+        Int32 tileY = itTile->first >> 16;
+
+        if( abs(tileX - cameraTileX) > mLoadRadius + 1 || abs(tileY - cameraTileY) > mLoadRadius + 1 )
+        {
+            GD_DELETE(itTile->second);
+            mTiles.erase( itTile++ );
+        }
+        else
+        {
+            ++itTile;
+        }
+    }
+
+    // Load the missing tiles closest to the camera, a batch of at most
+    // mTilesPerUpdate so the importer can share the work between them.
+    Vector< std::pair<Int32, UInt32> > missingTiles;
+
+    for( Int32 y = cameraTileY - mLoadRadius; y <= cameraTileY + mLoadRadius; y++ )
+    {
+        for( Int32 x = cameraTileX - mLoadRadius; x <= cameraTileX + mLoadRadius; x++ )
+        {
+            if( x < 0 || y < 0 || x >= NUM_TILES || y >= NUM_TILES )
+                continue;
+
+            UInt32 key = GetTileKey( x, y );
+            if( mTiles.find(key) != mTiles.end() || mMissingTiles.find(key) != mMissingTiles.end() )
+                continue;
+
+            Int32 distance = (x - cameraTileX)*(x - cameraTileX) + (y - cameraTileY)*(y - cameraTileY);
+            missingTiles.push_back( std::make_pair( distance, key ) );
+        }
+    }
+
+    if( missingTiles.empty() )
+        return;
+
+    std::sort( missingTiles.begin(), missingTiles.end() );
+
+    Vector<UInt32> tileKeys;
+    for( UInt32 i = 0; i < missingTiles.size() && i < mTilesPerUpdate; i++ )
+        tileKeys.push_back( missingTiles[i].second );
+
+    LoadTiles( tileKeys );
+}
+
+void WorldTileManager::Render() const
+{
+    for( Map<UInt32, WorldTile*>::const_iterator itTile = mTiles.begin(); itTile != mTiles.end(); ++itTile )
+        itTile->second->Render();
+}
+
+UInt32 WorldTileManager::GetNbLoadedTiles() const
+{
+    return mTiles.size();
+}
+
+UInt32 WorldTileManager::GetTileKey( Int32 pTileX, Int32 pTileY )
+{
+    return (pTileY << 16) | pTileX;
+}
+
+void WorldTileManager::LoadTiles( const Vector<UInt32>& pTileKeys )
+{
+    Vector<UInt32>  keys;
+    Vector<String>  filenames;
+
+    for( UInt32 i = 0; i < pTileKeys.size(); i++ )
+    {
+        Int32 tileX = pTileKeys[i] & 0xFFFF;
+        Int32 tileY = pTileKeys[i] >> 16;
+        const String filename = mMapBaseName + String("_") + ToString(tileX) + String("_") + ToString(tileY) + String(".adt");
+
+        if( FileManager::FileExist( filename ) )
+        {
+            keys.push_back( pTileKeys[i] );
+            filenames.push_back( filename );
+        }
+        else
+        {
+            mMissingTiles[pTileKeys[i]] = true;
+        }
+    }
+
+    if( filenames.empty() )
+        return;
+
+    ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile( filenames[0], WorldTile::StaticClass() );
+
+    Vector<Resource*> resources;
+    if( importer )
+        importer->ImportBatch( filenames, resources );
+    else
+        resources.resize( filenames.size(), NULL );
+
+    for( UInt32 i = 0; i < keys.size(); i++ )
+    {
+        if( !resources[i] || !resources[i]->IsA( WorldTile::StaticClass() ) )
+        {
+            GD_DELETE(resources[i]);
+            mMissingTiles[keys[i]] = true;
+            continue;
+        }
+
+        WorldTile* tile = Cast<WorldTile>( resources[i] );
+        tile->SetWorld( mWorld );
+        tile->SetPosition( GetPosition() );
+        tile->SetHiResDistance( mHiResDistance );
+        tile->Init();
+
+        mTiles[keys[i]] = tile;
+    }
+}
+
+void WorldTileManager::UnloadAllTiles()
+{
+    for( Map<UInt32, WorldTile*>::iterator itTile = mTiles.begin(); itTile != mTiles.end(); ++itTile )
+        GD_DELETE(itTile->second);
+
+    mTiles.clear();
+}
+
+
+} // namespace Gamedesk
@@ -0,0 +1,101 @@
+/**
+ *  @file       WorldTileManager.h
+ *  @brief      Stream the tiles of a tiled map around the camera.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#ifndef     _WORLD_TILE_MANAGER_H_
+#define     _WORLD_TILE_MANAGER_H_
+
+
+#include "Entity.h"
+
+
+namespace Gamedesk {
+
+
+class WorldTile;
+
+
+/**
+ *  Keep the WorldTile of a 64x64 tiled map (WoW ADT files named
+ *  "<Map>_<X>_<Y>.adt") loaded around the camera. Tiles within the load radius
+ *  are imported closest first, a few per frame in a single batch to bound the
+ *  hitch, and tiles further than the load radius plus one are released.
+ */
+class ENGINE_API WorldTileManager : public Entity
+{
+    DECLARE_CLASS(WorldTileManager, Entity)
+
+public:
+    //! Default constructor.
+    WorldTileManager();
+
+    //! Destructor.
+    virtual ~WorldTileManager();
+
+    /**
+     *  Set the map to stream, unloading the current tiles.
+     *  @param  pMapBaseName    Path of the tiles without the coordinates,
+     *                          ie. "Data/World/Maps/Azeroth/Azeroth".
+     */
+    void SetMap( const String& pMapBaseName );
+
+    //! Number of tiles loaded in each direction around the tile of the camera.
+    void SetLoadRadius( UInt32 pRadius );
+
+    //! Hi res distance given to every tile.
+    void SetHiResDistance( Float pDistance );
+
+    //! Maximum number of tiles imported by each Update(). They are imported as one batch.
+    void SetTilesPerUpdate( UInt32 pTilesPerUpdate );
+
+    //! Load and release tiles around the camera.
+    virtual void Update( Double pElapsedTime );
+
+    //! Render the loaded tiles.
+    virtual void Render() const;
+
+    //! Number of tiles currently loaded.
+    UInt32 GetNbLoadedTiles() const;
+
+private:
+    static UInt32 GetTileKey( Int32 pTileX, Int32 pTileY );
+
+    void    LoadTiles( const Vector<UInt32>& pTileKeys );
+    void    UnloadAllTiles();
+
+private:
+    String                      mMapBaseName;
+    Map<UInt32, WorldTile*>     mTiles;
+    Map<UInt32, Bool>           mMissingTiles;      //!< Tiles that failed to load, never retried.
+
+    Int32                       mLoadRadius;
+    Float                       mHiResDistance;
+    UInt32                      mTilesPerUpdate;
+};
+
+
+} // namespace Gamedesk
+
+
+#endif  //  _WORLD_TILE_MANAGER_H_
@@ -41,6 +41,7 @@
 #include "World/Model3D.h"
 
 #include "Input/InputSubsystem.h"
+#include "Network/NetworkSubsystem.h"
 #include "Sound/SoundSubsystem.h"
 #include "Graphic/GraphicSubsystem.h"
 #include "Graphic/Renderer.h"
@@ -191,6 +192,13 @@ public:
 				//PhysicSubsystem::Instance()->Update(mDelta);
 				//}
 
+				// Receive the network packets and send the snapshots.
+				if(NetworkSubsystem::Instance())
+				{
+					Profile("Network");
+					NetworkSubsystem::Instance()->Update(mDelta);
+				}
+
 				// Update the world.
 				{
 					Profile("World Update");
@@ -217,6 +225,8 @@ public:
 														camera->GetUp() );
 				}
             }
+
+            ProfileFrame();
         }
     }
 
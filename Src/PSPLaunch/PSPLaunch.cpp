@@ -323,6 +323,8 @@ public:
 
 				val++;
             }
+
+            ProfileFrame();
         }
     }
 
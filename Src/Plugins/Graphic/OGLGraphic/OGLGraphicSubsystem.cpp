@@ -41,6 +41,7 @@
 #include "Graphic/Buffer/SoftwareIndexBuffer.h"
 #include "Graphic/Buffer/SoftwareVertexBuffer.h"
 #include "Graphic/Mesh/Mesh.h"
+#include "Graphic/Texture/TextureManager.h"
 
 
 namespace Gamedesk {
@@ -66,6 +67,9 @@ void OGLGraphicSubsystem::Init()
 
 void OGLGraphicSubsystem::Kill()
 {
+    // Cached textures must be released while the renderer is still alive.
+    TextureManager::Instance().Flush();
+
     if( mRenderer )
         GD_DELETE(mRenderer);
 
@@ -211,19 +211,20 @@ void OGLTexture2D::Init()
     if( mImage.GetData() != NULL )
     {
         // If asked to have mipmaps but texture has none, automatically generate them.
-        if( mImage.GetNumMipmaps() == 1 && mHasMipmaps )
+        if( mImage.GetNumMipmaps() == 1 && mHasMipmaps && mFirstMipmap == 0 )
         {
             gluBuild2DMipmaps( GL_TEXTURE_2D, GDToGLIntTexFormat[mFormat], mWidth, mHeight, GDToGLTexFormat[mFormat], GL_UNSIGNED_BYTE, mImage.GetData() );
         }
         else
         {
-            UInt32 height    = mHeight;
-            UInt32 width     = mWidth;
-            UInt32 offset    = 0;
+            // Mipmaps above mFirstMipmap are not resident (streamed by the TextureManager).
+            UInt32 height    = mHeight >> mFirstMipmap;
+            UInt32 width     = mWidth >> mFirstMipmap;
+            UInt32 offset    = Image::GetSizeWithMipmaps( mFormat, mWidth, mHeight, 1, mFirstMipmap );
             UInt32 dataSize  = 0;
 
             // Load each mipmap individually
-            for( UInt32 i = 0; i < mImage.GetNumMipmaps() && (width || height); ++i )
+            for( UInt32 i = 0; i < mImage.GetNumMipmaps() - mFirstMipmap && (width || height); ++i )
             {
                 if (width == 0)
                     width = 1;
@@ -36,6 +36,7 @@
 #include "Graphic/Shader/ShaderObject.h"
 #include "Graphic/Shader/ShaderProgram.h"
 #include "Graphic/RenderTarget/RenderTexture.h"
+#include "Graphic/Texture/TextureManager.h"
 
 
 namespace Gamedesk {
@@ -61,6 +62,9 @@ void PSPGraphicSubsystem::Init()
 
 void PSPGraphicSubsystem::Kill()
 {
+    // Cached textures must be released while the renderer is still alive.
+    TextureManager::Instance().Flush();
+
     if( mRenderer )
         GD_DELETE(mRenderer);
 
@@ -56,8 +56,7 @@ void MeshReader::Read( const String& pFileName )
 
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib);
+        UInt32 attribHash = ReadToken().GetHash();
 
         if     (attribHash == _3DSMAX_ASCIIEXPORT)  Read(mMeshFile.mVersion);
         else if(attribHash == COMMENT)              Read(mMeshFile.mComment);
@@ -87,8 +86,7 @@ void MeshReader::Read(ASEFile::Scene& pScene)
     
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib);
+        UInt32 attribHash = ReadToken().GetHash();
 
         if     (attribHash == SCENE_FILENAME)           Read(pScene.mFilename);
         else if(attribHash == SCENE_FIRSTFRAME)         Read(pScene.mFirstFrame);
@@ -119,8 +117,7 @@ void MeshReader::Read(ASEFile::MaterialList& pMaterialList)
 
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib.c_str());
+        UInt32 attribHash = ReadToken().GetHash();
 
         if(attribHash == MATERIAL)                 
         {
@@ -173,8 +170,7 @@ void MeshReader::Read(ASEFile::Material& pMat)
 
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib);
+        UInt32 attribHash = ReadToken().GetHash();
 
         if     (attribHash == MATERIAL_NAME)            Read(pMat.mName);
         else if(attribHash == MATERIAL_CLASS)           Read(pMat.mClass);
@@ -246,8 +242,7 @@ void MeshReader::Read(ASEFile::Material::Map& pMap)
 
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib);
+        UInt32 attribHash = ReadToken().GetHash();
 
         if     (attribHash == MAP_NAME)         Read(pMap.mName);
         else if(attribHash == MAP_CLASS)        Read(pMap.mClass);
@@ -286,8 +281,7 @@ void MeshReader::Read(ASEFile::GeomObject& pGeomObject)
 
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib);
+        UInt32 attribHash = ReadToken().GetHash();
 
         if     (attribHash == NODE_NAME)        Read(pGeomObject.mNodeName);
         else if(attribHash == NODE_TM)          Read(pGeomObject.mNodeTM);
@@ -321,8 +315,7 @@ void MeshReader::Read(ASEFile::GeomObject::NodeTM& pNodeTM)
 
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib);
+        UInt32 attribHash = ReadToken().GetHash();
 
         if     (attribHash == NODE_NAME)        Read(pNodeTM.mNodeName);
         else if(attribHash == INHERIT_POS)      Read(pNodeTM.mInheritPos);
@@ -359,8 +352,7 @@ void MeshReader::Read(ASEFile::GeomObject::Mesh& pMesh)
 
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        UInt32 attribHash = Hash(attrib);
+        UInt32 attribHash = ReadToken().GetHash();
 
         if     (attribHash == TIMEVALUE)        Read(pMesh.mTimeValue);
         else if(attribHash == MESH_NUMVERTEX)   Read(pMesh.mNumVertex);
@@ -385,8 +377,7 @@ void MeshReader::Read(Vector<Vector3f>& pVector3List, UInt32 pSize)
     UInt32 currentIdx = 0;
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        if(attrib == "}")
+        if(ReadToken() == "}")
         {
             if(currentIdx != pSize)
                 throw ResourceImportException(String("Missing data"), Here);
@@ -413,8 +404,7 @@ void MeshReader::Read(Vector<ASEFile::GeomObject::Mesh::Face>& pFaceList, UInt32
     UInt32 currentIdx = 0;
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        if(attrib == "}")
+        if(ReadToken() == "}")
         {
             if(currentIdx != pSize)
                 throw ResourceImportException(String("Missing data"), Here);
@@ -443,9 +433,7 @@ void MeshReader::Read(Vector<ASEFile::GeomObject::Mesh::Face>& pFaceList, UInt32
             ReadUInt();
 
             MustRead("*MESH_SMOOTHING");
-            String res = ReadString();
-
-            if(res != "*MESH_MTLID")
+            if(ReadToken() != "*MESH_MTLID")
                 MustRead("*MESH_MTLID");
 
             Read(pFaceList[idx].mMaterialID);
@@ -470,8 +458,7 @@ void MeshReader::Read(Vector<ASEFile::GeomObject::Mesh::FaceNormal>& pFaceNormal
     UInt32 currentIdx = 0;
     while(GetNextLine())
     {
-        String attrib = ReadString();
-        if(attrib == "}")
+        if(ReadToken() == "}")
         {
             if(currentIdx != pSize)
                 throw ResourceImportException(String("Missing data"), Here);
@@ -500,6 +487,7 @@ void MeshReader::Read(Vector<ASEFile::GeomObject::Mesh::FaceNormal>& pFaceNormal
 }
 
 Reader::Reader()
+    : mNextLine(NULL)
 {
 }
 
@@ -509,50 +497,38 @@ Reader::~Reader()
 
 void Reader::Read( const String& pFileName )
 {
-    const char whitespaces[] = { 10, 13, '\t', ' ', 0 };
+    mMemoryFile.Close();
+    mMemoryFile.Open( pFileName, true );
 
-    mTokenizer.SetWhiteSpaces(whitespaces);
-    
-    File::ReadAllLines(pFileName.c_str(), mLines);
+    mNextLine = (const Char*)mMemoryFile.GetMemory();
+}
 
-    mCurrentLine = mLines.begin();
+void Reader::MustRead( const Char* pValue )
+{
+    TextToken token = mLexer.ReadToken();
+    GD_ASSERT( token == pValue );
 }
 
-void Reader::MustRead( const String& pValue )
+TextToken Reader::ReadToken()
 {
-    String tmp;
-    ReadString( tmp );
-    GD_ASSERT( tmp == pValue );
+    return mLexer.ReadToken();
 }
 
 const String& Reader::ReadStringQuote( String& pValue )
 {
-    EatWhite();
-
-    pValue = "";
-    
-    Char c;
-    c = mTokenizer.GetChar();
-    GD_ASSERT( c == '"' );
-    
-    c = mTokenizer.GetChar();
-    while( c != '"' )
-    {
-        pValue += c;
-        c = mTokenizer.GetChar();
-    }
+    mLexer.SkipWhite();
+    GD_ASSERT( mLexer.PeekChar() == '"' );
 
+    mLexer.ReadQuoted().CopyTo( pValue );
     return pValue;
 }
 
 const String& Reader::ReadString( String& pValue )
 {
-    EatWhite();
-
 	if(NextChar() == '\"')
 		return ReadStringQuote(pValue);
 	
-	mTokenizer >> pValue;
+    mLexer.ReadToken().CopyTo( pValue );
     return pValue;
 }
 
@@ -565,43 +541,34 @@ String Reader::ReadString()
 
 const Float& Reader::ReadFloat( Float& pValue )
 {
-    EatWhite();
-    mTokenizer >> pValue;
+    pValue = mLexer.ReadFloat();
     return pValue;
 }
 
 Float Reader::ReadFloat()
 {
-    Float val;
-    ReadFloat( val );
-    return val;
+    return mLexer.ReadFloat();
 }
 
 const Int32& Reader::ReadInt( Int32& pValue )
 {
-    EatWhite();
-    mTokenizer >> pValue;
+    pValue = mLexer.ReadInt();
     return pValue;
 }
 Int32 Reader::ReadInt()
 {
-    Int32 val;
-    ReadInt( val );
-    return val;
+    return mLexer.ReadInt();
 }
 
 const UInt32& Reader::ReadUInt( UInt32& pValue )
 {
-    EatWhite();
-    mTokenizer >> pValue;
+    pValue = mLexer.ReadUInt();
     return pValue;
 }
 
 UInt32 Reader::ReadUInt()
 {
-    UInt32 val;
-    ReadUInt( val );
-    return val;
+    return mLexer.ReadUInt();
 }
 
 const Color3f& Reader::ReadColor( Color3f& pValue )
@@ -628,35 +595,32 @@ const Vector2f& Reader::ReadVector2( Vector2f& pValue )
     return pValue;
 }
 
-void Reader::EatWhite()
-{
-    Int32 peek = mTokenizer.NextChar();
-    while( peek == ' '  || peek == '\n' || peek == 13 || peek == '\t' )
-    {
-        mTokenizer.GetChar();
-        peek = mTokenizer.NextChar();
-    }
-}
-
 Char Reader::NextChar()
 {
-    EatWhite();
-    return mTokenizer.NextChar();
+    mLexer.SkipWhite();
+    return mLexer.PeekChar();
 }
 
 Char Reader::ReadChar()
 {
-    EatWhite();
-    return mTokenizer.GetChar();
+    mLexer.SkipWhite();
+    return mLexer.GetChar();
 }
 
 Bool Reader::GetNextLine()
 {
-    mCurrentLine++;
-    Bool bGotLine = mCurrentLine != mLines.end();
-    if(bGotLine)
-        mTokenizer.Init(mCurrentLine->c_str(), mCurrentLine->size());
-    return bGotLine;
+    const Char* fileEnd = (const Char*)mMemoryFile.GetMemory() + mMemoryFile.GetSize();
+    if( mNextLine >= fileEnd )
+        return false;
+
+    const Char* lineEnd = (const Char*)memchr( mNextLine, '\n', fileEnd - mNextLine );
+    if( !lineEnd )
+        lineEnd = fileEnd;
+
+    mLexer.Init( mNextLine, (UInt32)(lineEnd - mNextLine) );
+    mNextLine = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+
+    return true;
 }
 
 }
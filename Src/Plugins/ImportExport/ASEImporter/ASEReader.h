@@ -33,6 +33,7 @@
 #include "ASEFile.h"
 
 #include "FileManager/MemoryFile.h"
+#include "FileManager/TextLexer.h"
 
 namespace ASE
 {
@@ -51,7 +52,9 @@ public:
     virtual void    Read( const String& pFileName );
 
 protected:    
-    void            MustRead( const String& pValue );
+    void            MustRead( const Char* pValue );
+
+    TextToken       ReadToken();
     
     const String&   ReadStringQuote( String& pValue );
 
@@ -71,7 +74,6 @@ protected:
     const Vector3f& ReadVector3( Vector3f& pValue );
     const Vector2f& ReadVector2( Vector2f& pValue );
 
-    void EatWhite();
     Char NextChar();
     Char ReadChar();
 	Char PeekChar();
@@ -79,12 +81,9 @@ protected:
     Bool GetNextLine();
 
 private:
-    typedef List<String>                StringList;
-    typedef StringList::const_iterator  StringListIterator;
-
-    StringTokenizer         mTokenizer;
-    StringList              mLines;
-    StringListIterator      mCurrentLine;
+    MemoryFile              mMemoryFile;
+    TextLexer               mLexer;             //!< Over the current line only.
+    const Char*             mNextLine;
 };
 
 
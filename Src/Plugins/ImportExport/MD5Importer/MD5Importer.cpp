@@ -34,6 +34,7 @@
 #include "FileManager/FileManager.h"
 #include "Graphic/Mesh/SkeletalMesh.h"
 #include "Graphic/Mesh/SkeletalAnim.h"
+#include "World/SpacePartition/PortalMap.h"
 #include "Graphic/Shader/Shader.h"
 #include "Config/ConfigFile.h"
 
@@ -365,86 +366,79 @@ Resource* ProcImporter::Import( const String& pFilename, const String& /*pParams
     Core::DebugOut( "Num Portals : %d\n", procFile.mPortals.size() );
     Core::DebugOut( "Num Shadow Models : %d\n", procFile.mShadowModels.size() );
 
-    
-    // Shit Begin !
+    // Doom 3 is Z up, in inches.
+    const Float scale = 0.05f;
 
-    // Count Vertices
-    UInt32 verticesCount = 0;
-    UInt32 indicesCount = 0;
-    UInt32 numSurface = 0;
-    Bool   stopCount = false;
-    for( Vector<MD5::Area>::iterator it = procFile.mAreas.begin(); it != procFile.mAreas.end(); ++it )
+    PortalMap* map = GD_NEW(PortalMap, this, "PortalMap");
+
+    // Areas, each surface is a child mesh.
+    map->mAreas.resize( procFile.mAreas.size() );
+    for( UInt32 iArea = 0; iArea < procFile.mAreas.size(); iArea++ )
     {
-        for( Vector<MD5::Area::Surface>::iterator surfIt = it->mSurfaces.begin(); surfIt != it->mSurfaces.end(); ++surfIt )
+        const MD5::Area& procArea = procFile.mAreas[iArea];
+        PortalMap::Area& area = map->mAreas[iArea];
+
+        area.mName = procArea.mName;
+
+        for( Vector<MD5::Area::Surface>::const_iterator surfIt = procArea.mSurfaces.begin(); surfIt != procArea.mSurfaces.end(); ++surfIt )
         {
-            if( verticesCount + surfIt->mVertices.size() > 65535 )
+            if( surfIt->mVertices.size() > 65535 )
             {
-                stopCount = true;
-                break;
+                Core::DebugOut( "Surface %s of area %s has too many vertices, skipped\n", surfIt->mName.c_str(), procArea.mName.c_str() );
+                continue;
             }
 
-            if( indicesCount + surfIt->mIndices.size() > 65535 )
+            Mesh* surface = GD_NEW(Mesh, this, "Mesh");
+            surface->GetVertexList().Allocate( surfIt->mVertices.size(), (VertexFormat::Component) (VertexFormat::Position3 | VertexFormat::Normal3 | VertexFormat::TexCoord2) );
+            surface->GetTriangles().Allocate( TriangleBatch::TriangleList, surfIt->mIndices.size() );
+
+            Vector3f* ptrPosition = surface->GetVertexList().GetPositions();
+            Vector3f* ptrNormal   = surface->GetVertexList().GetNormals();
+            Vector2f* ptrTexCoord = surface->GetVertexList().GetTextureCoords();
+            UInt16*   ptrIndices  = surface->GetTriangles().GetIndices();
+
+            for( UInt32 i = 0; i < surfIt->mIndices.size(); i++ )
+                ptrIndices[i] = surfIt->mIndices[i];
+
+            for( UInt32 i = 0; i < surfIt->mVertices.size(); i++ )
             {
-                stopCount = true;
-                break;
+                const MD5::Area::Surface::Vertex& vertex = surfIt->mVertices[i];
+                ptrPosition[i] = Vector3f(vertex.mPosition.x, vertex.mPosition.z, vertex.mPosition.y) * scale;
+                ptrNormal[i]   = Vector3f(vertex.mNormal.x, vertex.mNormal.z, vertex.mNormal.y).GetNormalized();
+                ptrTexCoord[i] = vertex.mTexCoord;
             }
 
-            verticesCount += surfIt->mVertices.size();
-            indicesCount += surfIt->mIndices.size();
-
-            numSurface++;
+            area.mSurfaces.push_back( surface );
+            map->AddChild( surface );
         }
-
-        if( stopCount )
-            break;
     }
 
-
-    Mesh* newMesh = GD_NEW(Mesh, this, "Mesh");
-    newMesh->GetVertexList().Allocate( verticesCount, (VertexFormat::Component) (VertexFormat::Position3 | VertexFormat::Normal3 | VertexFormat::TexCoord2) );
-    newMesh->GetTriangles().Allocate( TriangleBatch::TriangleList, indicesCount );
-
-    // Vertices
-    Vector3f* ptrPosition = newMesh->GetVertexList().GetPositions();
-    Vector3f* ptrNormal   = newMesh->GetVertexList().GetNormals();
-    Vector2f* ptrTexCoord = newMesh->GetVertexList().GetTextureCoords();
-    UInt16*   ptrIndices  = newMesh->GetTriangles().GetIndices();
-    
-    UInt32 iVertex = 0;
-    UInt32 iIndex = 0;
-    UInt32 iSurface = 0;
-    Bool   stop = false;
-    for( Vector<MD5::Area>::iterator it = procFile.mAreas.begin(); it != procFile.mAreas.end(); ++it )
+    // Portals.
+    map->mPortals.resize( procFile.mPortals.size() );
+    for( UInt32 iPortal = 0; iPortal < procFile.mPortals.size(); iPortal++ )
     {
-        for( Vector<MD5::Area::Surface>::iterator surfIt = it->mSurfaces.begin(); surfIt != it->mSurfaces.end(); ++surfIt )
-        {
-            if( iSurface == numSurface )
-            {
-                stop = true;
-                break;
-            }
+        const MD5::Portal& procPortal = procFile.mPortals[iPortal];
+        PortalMap::Portal& portal = map->mPortals[iPortal];
 
-            for( Vector<UInt32>::iterator indexIt = surfIt->mIndices.begin(); indexIt != surfIt->mIndices.end(); ++indexIt )
-            {
-                ptrIndices[iIndex] = (*indexIt) + iVertex;
-                iIndex++;
-            }
+        portal.mAreas[0] = procPortal.mPositiveSideArea;
+        portal.mAreas[1] = procPortal.mNegativeSideArea;
 
-            for( Vector<MD5::Area::Surface::Vertex>::iterator vertexIt = surfIt->mVertices.begin(); vertexIt != surfIt->mVertices.end(); ++vertexIt )
-            {
-                ptrPosition[iVertex] = Vector3f(vertexIt->mPosition.x, vertexIt->mPosition.z, vertexIt->mPosition.y) * 0.05f;
-                ptrNormal[iVertex]   = Vector3f(vertexIt->mNormal.x, vertexIt->mNormal.z, vertexIt->mNormal.y).GetNormalized();
-                ptrTexCoord[iVertex] = vertexIt->mTexCoord;
-                iVertex++;
-            }
-                 
-            iSurface++;
-        }
+        portal.mPoints.resize( procPortal.mPoints.size() );
+        for( UInt32 i = 0; i < procPortal.mPoints.size(); i++ )
+            portal.mPoints[i] = Vector3f(procPortal.mPoints[i].x, procPortal.mPoints[i].z, procPortal.mPoints[i].y) * scale;
+    }
 
-        if( stop )
-            break;
+    // Nodes. Doom 3 planes are a*x + b*y + c*z + d = 0, a Plane3f is n.p - d = 0.
+    map->mNodes.resize( procFile.mNodes.size() );
+    for( UInt32 iNode = 0; iNode < procFile.mNodes.size(); iNode++ )
+    {
+        const MD5::Node& procNode = procFile.mNodes[iNode];
+        PortalMap::Node& node = map->mNodes[iNode];
+
+        node.mPlane = Plane3f( Vector3f(procNode.mPlane(0), procNode.mPlane(2), procNode.mPlane(1)), -procNode.mPlane(3) * scale );
+        node.mChildren[0] = procNode.mPositiveChild;
+        node.mChildren[1] = procNode.mNegativeChild;
     }
-    // Shit End !
-   
-    return newMesh;
+
+    return map;
 }
\ No newline at end of file
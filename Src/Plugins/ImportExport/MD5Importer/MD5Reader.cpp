@@ -30,6 +30,7 @@
 
 #include "FileManager/FileManager.h"
 #include "Resource/ResourceManager.h"
+#include "Thread/JobManager.h"
 
 namespace MD5
 {
@@ -99,41 +100,34 @@ void ShaderReader::Read( const String& pFile )
 {
     Reader::Read( pFile );
 
-    String lastSymbol;
-
-    while( !mTokenizer.AtEnd() )
+    while( !mLexer.AtEnd() )
     {
-        String symbol;
-        ReadString( symbol );
+        TextToken symbol = ReadString();
 
-        if( symbol.size() == 0 )
+        if( symbol.IsEmpty() )
             break;
 
         if( symbol == "table" )
         {
-            ReadString( symbol );            
+            ReadString();
             ReadTable();
         }
         else
         {
             if( symbol == "material" || symbol == "skin" || symbol == "particle" )
-                ReadString( symbol );
+                symbol = ReadString();
                        
             Shader* shader = GD_NEW(Shader, this, "Shader");
-            shader->mName = symbol;
+            symbol.CopyTo( shader->mName );
             
             ReadShader( shader );
             mDirectory->AddShader( shader );
         }
-
-        lastSymbol = symbol;
     }
 }
 
 void ShaderReader::ReadTable()
 {
-    String symbol;
-
     UInt32 numBrace = 0;
 
     if( NextChar() == '{' )
@@ -156,8 +150,6 @@ void ShaderReader::ReadTable()
 }
 void ShaderReader::ReadShader( Shader* pShader )
 {
-    String symbol;
-    
     if( ReadChar() != '{' )
         debugBreak();
     
@@ -169,7 +161,7 @@ void ShaderReader::ReadShader( Shader* pShader )
         }
         else
         {
-            ReadSymbol( symbol );
+            TextToken symbol = ReadSymbol();
 
             if( symbol == "bumpmap" )
                 ReadTexture( pShader->mTextures[Shader::TexBump] );
@@ -190,8 +182,6 @@ void ShaderReader::ReadShader( Shader* pShader )
 
 void ShaderReader::ReadBlendBlock( Shader* pShader )
 {
-    String symbol;
-
     if( ReadChar() != '{' )
         debugBreak();
 
@@ -199,36 +189,36 @@ void ShaderReader::ReadBlendBlock( Shader* pShader )
     
     while( NextChar() != '}' )
     {
-        ReadKeyword( symbol );
+        TextToken symbol = ReadSymbol();
         
-        if( symbol == "blend" )
+        if( symbol.EqualsLowerCase( "blend" ) )
         {
-            ReadKeyword( symbol );
+            symbol = ReadSymbol();
             
-            if( symbol == "add" )
+            if( symbol.EqualsLowerCase( "add" ) )
             {
                 pShader->mBlendSrc[CurrentTex] = Renderer::BlendOne;
                 pShader->mBlendDst[CurrentTex] = Renderer::BlendOne;
             }
-            else if( symbol == "blend" )
+            else if( symbol.EqualsLowerCase( "blend" ) )
             {
                 pShader->mBlendSrc[CurrentTex] = Renderer::BlendZero;
                 pShader->mBlendDst[CurrentTex] = Renderer::BlendSrcColor;
             }
-            else if( symbol == "filter" )
+            else if( symbol.EqualsLowerCase( "filter" ) )
             {
                 pShader->mBlendSrc[CurrentTex] = Renderer::BlendSrcAlpha;
                 pShader->mBlendDst[CurrentTex] = Renderer::BlendInvSrcAlpha;
             }
-            else if( symbol == "diffusemap" ) 
+            else if( symbol.EqualsLowerCase( "diffusemap" ) ) 
             {
                 CurrentTex = Shader::TexDiffuse;
             }
-            else if( symbol == "specularmap" )
+            else if( symbol.EqualsLowerCase( "specularmap" ) )
             {
                 CurrentTex = Shader::TexSpecular;
             }
-            else if( symbol == "bumpmap" )
+            else if( symbol.EqualsLowerCase( "bumpmap" ) )
             {
                 CurrentTex = Shader::TexBump;
             }            
@@ -239,11 +229,11 @@ void ShaderReader::ReadBlendBlock( Shader* pShader )
                 if( ReadChar() != ',' )
                     debugBreak();
 
-                ReadKeyword( symbol );
+                symbol = ReadSymbol();
                 pShader->mBlendDst[CurrentTex] = PixelBlendingConv( symbol );
             }
         }
-        else if( symbol == "map" )
+        else if( symbol.EqualsLowerCase( "map" ) )
         {
             ReadTexture( pShader->mTextures[CurrentTex] );
         }
@@ -259,121 +249,86 @@ void ShaderReader::ReadBlendBlock( Shader* pShader )
 
 void ShaderReader::ReadTexture( String& pString )
 {
-    ReadString( pString );
+    TextToken texture = ReadString();
 
-    if( pString == "addnormals" || 
-        pString == "heightmap"  || 
-        pString == "makealpha" )
+    if( texture == "addnormals" || 
+        texture == "heightmap"  || 
+        texture == "makealpha" )
     {
         if( ReadChar() != '(' )
             debugBreak();
 
-        ReadString( pString );
+        texture = ReadString();
     }
 
+    texture.CopyTo( pString );
+
     SkipLine();
 }
 
-Renderer::PixelBlendingFactor ShaderReader::PixelBlendingConv( const String& symbol )
+Renderer::PixelBlendingFactor ShaderReader::PixelBlendingConv( const TextToken& pSymbol )
 {
-    if( symbol == "gl_zero" )
+    if( pSymbol.EqualsLowerCase( "gl_zero" ) )
         return Renderer::BlendZero;
-    else if( symbol == "gl_one" )
+    else if( pSymbol.EqualsLowerCase( "gl_one" ) )
         return Renderer::BlendOne;
-    else if( symbol == "gl_src_color" )
+    else if( pSymbol.EqualsLowerCase( "gl_src_color" ) )
         return Renderer::BlendSrcColor;
-    else if( symbol == "gl_one_minus_src_color" )
+    else if( pSymbol.EqualsLowerCase( "gl_one_minus_src_color" ) )
         return Renderer::BlendInvSrcColor;
-    else if( symbol == "gl_dst_color" )
+    else if( pSymbol.EqualsLowerCase( "gl_dst_color" ) )
         return Renderer::BlendDstColor;
-    else if( symbol == "gl_one_minus_dst_color" )
+    else if( pSymbol.EqualsLowerCase( "gl_one_minus_dst_color" ) )
         return Renderer::BlendInvDstColor;
-    else if( symbol == "gl_src_alpha" )
+    else if( pSymbol.EqualsLowerCase( "gl_src_alpha" ) )
         return Renderer::BlendSrcAlpha;
-    else if( symbol == "gl_one_minus_src_alpha" )
+    else if( pSymbol.EqualsLowerCase( "gl_one_minus_src_alpha" ) )
         return Renderer::BlendInvSrcAlpha;
-    else if( symbol == "gl_dst_alpha" )
+    else if( pSymbol.EqualsLowerCase( "gl_dst_alpha" ) )
         return Renderer::BlendDstAlpha;
-    else if( symbol == "gl_one_minus_dst_alpha" )
+    else if( pSymbol.EqualsLowerCase( "gl_one_minus_dst_alpha" ) )
         return Renderer::BlendInvDstAlpha;
-    else if( symbol == "gl_src_alpha_saturate" )
+    else if( pSymbol.EqualsLowerCase( "gl_src_alpha_saturate" ) )
         return Renderer::BlendSrcAlphaSaturate;
 
     debugBreak();
     return Renderer::BlendZero; 
 }
 
-void ShaderReader::ReadString( String& pString )
+TextToken ShaderReader::ReadString()
 {
-    SkipComments();
-
-    pString = "";
-
-    Int32 peek = mTokenizer.NextChar();
-
-    while( peek != ' ' && peek != '\n' && peek != 13 && peek != '\t' && peek != '}' && peek != '{' &&  peek != '(' && peek != ')' && peek != 0 && peek != -1 )
-    {
-        peek = mTokenizer.GetChar();
-        if( peek == '/' && (mTokenizer.NextChar() == '/' || mTokenizer.NextChar() == '*') )
-        {
-             mTokenizer.UngetChar();
-             break;
-        }
-        
-        pString += peek;
-        peek = mTokenizer.NextChar();
-    }
+    TextToken token = mLexer.ReadToken( "{}()" );
 
-    if( pString.size() == 0 && peek != 0 && peek != -1 )
+    if( token.IsEmpty() && !mLexer.AtEnd() )
         debugBreak();
+
+    return token;
 }
 
-void ShaderReader::ReadSymbol( String& pString )
+TextToken ShaderReader::ReadSymbol()
 {
-    SkipComments();
-
-    pString = "";
-
-    Int32 peek = mTokenizer.NextChar();
+    TextToken symbol = mLexer.ReadIdentifier( "*" );
 
-    while( (peek >= 'A' && peek <= 'Z') ||
-           (peek >= 'a' && peek <= 'z') ||
-           (peek >= '0' && peek <= '9') ||
-           (peek == '_') || (peek == '*') )
-    {
-        if( pString.size() == 0 && (peek >= '0' && peek <= '9') )
-            debugBreak();
-
-        pString += peek;
-
-        mTokenizer.GetChar();
-        peek = mTokenizer.NextChar();
-    }
-
-    if( pString.size() == 0 )
+    if( symbol.IsEmpty() || (symbol.GetData()[0] >= '0' && symbol.GetData()[0] <= '9') )
         debugBreak();
-}
 
-void ShaderReader::ReadKeyword( String& pKeyword )
-{
-    ReadSymbol( pKeyword );
-    ToLower( pKeyword );
+    return symbol;
 }
 
 void ShaderReader::SkipLine( Bool bIgnoreBrace )
 {
-    Int32 peek = mTokenizer.NextChar();
-    while( peek != '\n' )
+    Char peek = mLexer.PeekChar();
+    while( peek != '\n' && !mLexer.AtEnd() )
     {
         if( (peek == '{' || peek == '}') && !bIgnoreBrace )
             break;
         
-        mTokenizer.GetChar();
-        peek = mTokenizer.NextChar();
+        mLexer.GetChar();
+        peek = mLexer.PeekChar();
     }
 
     if( peek == '\n' )
-        mTokenizer.GetChar();
+        mLexer.GetChar();
 }
 
 MeshReader::MeshReader( MeshFile& pMeshFile )
@@ -595,20 +550,53 @@ ProcReader::ProcReader( ProcFile& pProcFile )
 {
 }
 
+class ProcAreaBody : public ParallelForBody
+{
+public:
+    ProcAreaBody( ProcFile& pProcFile, const Vector<TextToken>& pAreaTexts )
+        : mProcFile(pProcFile)
+        , mAreaTexts(pAreaTexts)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        ProcReader reader( mProcFile );
+
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+        {
+            reader.SetText( mAreaTexts[i].GetData(), mAreaTexts[i].GetLength() );
+            reader.ReadArea( mProcFile.mAreas[i] );
+        }
+    }
+
+private:
+    ProcFile&                   mProcFile;
+    const Vector<TextToken>&    mAreaTexts;
+};
+
 void ProcReader::Read( const String& pFileName )
 {
     Reader::Read( pFileName );
 
     MustRead("mapProcFile003");
+
+    // Text of each area, parsed once the whole file has been seen.
+    Vector<TextToken> areaTexts;
     
     while( 1 )
     {
-        String section = ReadString();
+        TextToken section = ReadToken();
 
         if( section == "model" )
         {
-            mProcFile.mAreas.resize( mProcFile.mAreas.size() + 1 );
-            ReadArea( mProcFile.mAreas[mProcFile.mAreas.size()-1] );
+            mLexer.SkipWhite();
+            const Char* areaStart = mLexer.GetPosition();
+
+            MustRead( "{" );
+            mLexer.SkipBlock();
+
+            areaTexts.push_back( TextToken( areaStart, (UInt32)(mLexer.GetPosition() - areaStart) ) );
         }
         else if( section == "shadowModel" )
         {
@@ -628,6 +616,11 @@ void ProcReader::Read( const String& pFileName )
             break;
         }
     }
+
+    mProcFile.mAreas.resize( areaTexts.size() );
+
+    ProcAreaBody body( mProcFile, areaTexts );
+    JobManager::Instance()->ParallelFor( areaTexts.size(), 1, body );
 }
 
 
@@ -796,93 +789,77 @@ Reader::~Reader()
 
 void Reader::Read( const String& pFileName )
 {
-    const char whitespaces[] = { 10, 13, '\t', ' ', 0 };
-
-    // Read all the file data into the string stream.
+    // Tokens are read in place from the mapped file.
+    GD_DELETE(mMemoryFile);
     mMemoryFile = GD_NEW(MemoryFile, this, "MD5Reader MemoryFile")( pFileName, true );
-    mTokenizer.Init( (Char*)mMemoryFile->GetMemory(), mMemoryFile->GetSize() );
-    mTokenizer.SetWhiteSpaces(whitespaces);
+    mLexer.Init( (const Char*)mMemoryFile->GetMemory(), mMemoryFile->GetSize(), TextLexer::Comment_Cpp );
 }
 
-void Reader::MustRead( const String& pValue )
+void Reader::MustRead( const Char* pValue )
 {
-    String tmp;
-    ReadString( tmp );
-    GD_ASSERT( tmp == pValue );
+    TextToken token = mLexer.ReadToken();
+    GD_ASSERT( token == pValue );
 }
 
-const String& Reader::ReadStringQuote( String& pValue )
+void Reader::SetText( const Char* pText, UInt32 pLength )
 {
-    SkipComments();
+    mLexer.Init( pText, pLength, TextLexer::Comment_Cpp );
+}
 
-    pValue = "";
-    
-    Char c;
-    c = mTokenizer.GetChar();
-    GD_ASSERT( c == '"' );
-    
-    c = mTokenizer.GetChar();
-    while( c != '"' )
-    {
-        pValue += c;
-        c = mTokenizer.GetChar();
-    }
+TextToken Reader::ReadToken()
+{
+    return mLexer.ReadToken();
+}
 
+const String& Reader::ReadStringQuote( String& pValue )
+{
+    mLexer.SkipWhite();
+    GD_ASSERT( mLexer.PeekChar() == '"' );
+
+    mLexer.ReadQuoted().CopyTo( pValue );
     return pValue;
 }
 
 const String& Reader::ReadString( String& pValue )
 {
-    SkipComments();
-    mTokenizer >> pValue;
+    mLexer.ReadToken().CopyTo( pValue );
     return pValue;
 }
 
 String Reader::ReadString()
 {
-    String val;
-    ReadString( val );
-    return val;
+    return mLexer.ReadToken().ToString();
 }
 
 const Float& Reader::ReadFloat( Float& pValue )
 {
-    SkipComments();
-    mTokenizer >> pValue;
+    pValue = mLexer.ReadFloat();
     return pValue;
 }
 
 Float Reader::ReadFloat()
 {
-    Float val;
-    ReadFloat( val );
-    return val;
+    return mLexer.ReadFloat();
 }
 
 const Int32& Reader::ReadInt( Int32& pValue )
 {
-    SkipComments();
-    mTokenizer >> pValue;
+    pValue = mLexer.ReadInt();
     return pValue;
 }
 Int32 Reader::ReadInt()
 {
-    Int32 val;
-    ReadInt( val );
-    return val;
+    return mLexer.ReadInt();
 }
 
 const UInt32& Reader::ReadUInt( UInt32& pValue )
 {
-    SkipComments();
-    mTokenizer >> pValue;
+    pValue = mLexer.ReadUInt();
     return pValue;
 }
 UInt32 Reader::ReadUInt()
 {
-    UInt32 val;
-    ReadUInt( val );
-    return val;
+    return mLexer.ReadUInt();
 }
 
 const Vector3f& Reader::ReadVector3( Vector3f& pValue )
@@ -922,71 +899,16 @@ const Quaternionf& Reader::ReadQuaternion( Quaternionf& pQuaternion )
     return pQuaternion;
 }
 
-void Reader::SkipComments()
-{
-    EatWhite();
-
-    static Char buf[512];
-    
-    UInt32 peek;
-
-    if( mTokenizer.NextChar() == '/' )
-    {
-        mTokenizer.GetChar();
-        peek = mTokenizer.NextChar();
-
-        if( peek == '/' )
-        {   
-            strcpy_s(buf, 512, "");
-            mTokenizer.GetLine( buf, 512 );
-            SkipComments();
-        }
-        else if( peek == '*' )
-        {
-            mTokenizer.GetChar();
-            
-            mTokenizer.Ignore( Number<UInt32>::Max, '*' );
-            while(1)
-            {                
-                peek = mTokenizer.NextChar();
-                if( peek == '/' )
-                {
-                    mTokenizer.GetChar();
-                    break;
-                }
-                else
-                    mTokenizer.Ignore( Number<UInt32>::Max, '*' );
-            }
-            SkipComments();
-        }
-        else
-        {
-            mTokenizer.UngetChar();
-        }
-    }
-}
-
-
-void Reader::EatWhite()
-{
-    Int32 peek = mTokenizer.NextChar();
-    while( peek == ' '  || peek == '\n' || peek == 13 || peek == '\t' )
-    {
-        mTokenizer.GetChar();
-        peek = mTokenizer.NextChar();
-    }
-}
-
 Char Reader::NextChar()
 {
-    SkipComments();
-    return mTokenizer.NextChar();
+    mLexer.SkipWhite();
+    return mLexer.PeekChar();
 }
 
 Char Reader::ReadChar()
 {
-    SkipComments();
-    return mTokenizer.GetChar();
+    mLexer.SkipWhite();
+    return mLexer.GetChar();
 }
 
 }
@@ -33,6 +33,7 @@
 #include "MD5Shader.h"
 
 #include "FileManager/MemoryFile.h"
+#include "FileManager/TextLexer.h"
 
 
 namespace MD5
@@ -76,7 +77,12 @@ public:
     virtual void    Read( const String& pFileName );
 
 protected:    
-    void            MustRead( const String& pValue );
+    //! Read from pText instead of a file, pText must stay valid while reading.
+    void            SetText( const Char* pText, UInt32 pLength );
+
+    void            MustRead( const Char* pValue );
+
+    TextToken       ReadToken();
     
     const String&   ReadStringQuote( String& pValue );
 
@@ -97,13 +103,11 @@ protected:
 
     const Quaternionf& ReadQuaternion( Quaternionf& pQuaternion );
 
-    void SkipComments();
-    void EatWhite();
     Char NextChar();
     Char ReadChar();
 
 protected:
-    StringTokenizer mTokenizer;
+    TextLexer       mLexer;
 
 private:
     MemoryFile*     mMemoryFile;    
@@ -122,15 +126,14 @@ public:
 private:
     void ReadTable();
     void ReadShader( Shader* pShader );
-    void ReadSymbol( String& pSymbol );
-    void ReadString( String& pString );
-    void ReadKeyword( String& pKeyword );
+    TextToken ReadSymbol();
+    TextToken ReadString();
 
     void SkipLine( Bool bIgnoreClosingBrace = false );
     void ReadBlendBlock( Shader* pShader );
     void ReadTexture( String& pString );
 
-    Renderer::PixelBlendingFactor PixelBlendingConv( const String& symbol );
+    Renderer::PixelBlendingFactor PixelBlendingConv( const TextToken& pSymbol );
 
 private:
     ShaderDirectory* mDirectory;
@@ -175,10 +178,15 @@ private:
 };
 
 
+/**
+ *  Areas are independent, they are located first then parsed in parallel.
+ */
 class ProcReader : public Reader
 {
     CLASS_DISABLE_COPY(ProcReader);
 
+    friend class ProcAreaBody;
+
 public:
     ProcReader( ProcFile& pProc );
 
@@ -28,7 +28,6 @@
 #include "MDLImporter.h"
 #include "MDLReader.h"
 
-#include "Maths/Number.h"
 #include "Resource/ResourceManager.h"
 
 
@@ -43,10 +42,10 @@ MDLReader::MDLReader()
 
 void MDLReader::Read( const String& pFileName, NWN::Model& pModel )
 {
-    // Read all the file data into the string stream.
-    std::ifstream file;
-    file.open( pFileName.c_str() );
-    mStringStream << file.rdbuf(); 
+    // Tokens are read in place from the mapped file.
+    mMemoryFile.Close();
+    mMemoryFile.Open( pFileName, true );
+    mLexer.Init( (const Char*)mMemoryFile.GetMemory(), mMemoryFile.GetSize(), TextLexer::Comment_Hash );
 
     // Skip all dependancies
     UInt32 symbol;
@@ -493,8 +492,8 @@ void MDLReader::ReadAabbList( NWN::AabbGeometryNode& node )
     Float z2;
     Int32 i;
 
-    EatWhite();
-    while( !IsLetter( mStringStream.peek() ) )
+    mLexer.SkipWhite();
+    while( !IsLetter( mLexer.PeekChar() ) )
     {
         x1 = ReadFloat();
         z1 = ReadFloat();
@@ -506,7 +505,7 @@ void MDLReader::ReadAabbList( NWN::AabbGeometryNode& node )
 
         node.AddAabbEntry( x1, y1, z1, x2, y2, z2, i );
 
-        EatWhite();
+        mLexer.SkipWhite();
     }
 }
 
@@ -517,8 +516,8 @@ void MDLReader::ReadPositionKeys( NWN::AnimationNode* pAnimatioNode )
     Vector3f    position;
     UInt32      count;
 
-    EatWhite( false );
-    if( mStringStream.peek() != '\n' )
+    mLexer.SkipBlanks();
+    if( mLexer.PeekChar() != '\n' )
     {
         ReadUInt( count );
      
@@ -535,9 +534,9 @@ void MDLReader::ReadPositionKeys( NWN::AnimationNode* pAnimatioNode )
         // Read until we find a character.
         while( true )
         {
-            EatWhite();
+            mLexer.SkipWhite();
 
-            if( IsLetter( mStringStream.peek() ) )
+            if( IsLetter( mLexer.PeekChar() ) )
                 break;                
             
             ReadFloat( time );
@@ -557,8 +556,8 @@ void MDLReader::ReadOrientationKeys( NWN::AnimationNode* pAnimatioNode )
     Float       angle;
     UInt32      count;
 
-    EatWhite( false );
-    if( mStringStream.peek() != '\n' )
+    mLexer.SkipBlanks();
+    if( mLexer.PeekChar() != '\n' )
     {
         ReadUInt( count );
      
@@ -576,9 +575,9 @@ void MDLReader::ReadOrientationKeys( NWN::AnimationNode* pAnimatioNode )
         // Read until we find a character.
         while( true )
         {
-            EatWhite();
+            mLexer.SkipWhite();
 
-            if( IsLetter( mStringStream.peek() ) )
+            if( IsLetter( mLexer.PeekChar() ) )
                 break;
             
             ReadFloat( time );
@@ -597,8 +596,8 @@ void MDLReader::ReadBirthrateKeys( NWN::AnimationEmitterNode* pAnimatioEmitterNo
     Float       birthrate;
     UInt32      count;
 
-    EatWhite( false );
-    if( mStringStream.peek() != '\n' )
+    mLexer.SkipBlanks();
+    if( mLexer.PeekChar() != '\n' )
     {
         ReadUInt( count );
      
@@ -615,9 +614,9 @@ void MDLReader::ReadBirthrateKeys( NWN::AnimationEmitterNode* pAnimatioEmitterNo
         // Read until we find a character.
         while( true )
         {
-            EatWhite();
+            mLexer.SkipWhite();
 
-            if( IsLetter( mStringStream.peek() ) )
+            if( IsLetter( mLexer.PeekChar() ) )
                 break;
 
             ReadFloat( time );
@@ -631,8 +630,7 @@ void MDLReader::ReadBirthrateKeys( NWN::AnimationEmitterNode* pAnimatioEmitterNo
 
 const String& MDLReader::ReadString( String& pValue )
 {
-    SkipComments();
-    mStringStream >> pValue;
+    mLexer.ReadToken().CopyTo( pValue );
     //Core::DebugOut( "MDLReader: %s\n", pValue.c_str() );
     return pValue;
 }
@@ -646,8 +644,7 @@ String MDLReader::ReadString()
 
 const Float& MDLReader::ReadFloat( Float& pValue )
 {
-    SkipComments();
-    mStringStream >> pValue;
+    pValue = mLexer.ReadFloat();
     return pValue;
 }
 
@@ -660,8 +657,7 @@ Float MDLReader::ReadFloat()
 
 const Int32& MDLReader::ReadInt( Int32& pValue )
 {
-    SkipComments();
-    mStringStream >> pValue;
+    pValue = mLexer.ReadInt();
     return pValue;
 }
 Int32 MDLReader::ReadInt()
@@ -673,8 +669,7 @@ Int32 MDLReader::ReadInt()
 
 const UInt32& MDLReader::ReadUInt( UInt32& pValue )
 {
-    SkipComments();
-    mStringStream >> pValue;
+    pValue = mLexer.ReadUInt();
     return pValue;
 }
 UInt32 MDLReader::ReadUInt()
@@ -740,7 +735,7 @@ void MDLReader::MatchName( const String& pWanted, const String& pGiven ) const
 
 void MDLReader::IgnoreSymbol( UInt32 /*pSymbol*/ )
 {
-    mStringStream.ignore( Number<Int32>::Max, '\n' );
+    mLexer.SkipLine();
     //Core::DebugOut( "MDLReader: Ignoring symbol %s (%ul)\n", GetSymbolString(pSymbol).c_str(), pSymbol );
 }
 
@@ -755,43 +750,6 @@ String MDLReader::GetSymbolString( UInt32 pSymbol ) const
     return "Unknown Symbol";
 }    
 
-void MDLReader::SkipComments()
-{
-    EatWhite();
-    
-    if( mStringStream.peek() == '#' )
-    {
-        mStringStream.ignore( Number<Int32>::Max, '\n' );
-        SkipComments();
-    }
-    else
-    {
-        mStringStream.unget();
-    }
-}
-
-void MDLReader::EatWhite( Bool pEOLIsWhite )
-{
-    UInt32 read;
-    
-    if( pEOLIsWhite )
-    {
-        do 
-        {
-            read = mStringStream.get();
-        } while( read == '\n' || read == ' ' || read == '\t' );
-    }
-    else
-    {
-        do 
-        {
-            read = mStringStream.get();
-        } while( read == ' ' || read == '\t' );
-    }
-
-    mStringStream.unget();
-}
-
 void MDLReader::InitializeSymbolTable()
 {
     if( mSymbolTableInitialized )
@@ -31,6 +31,9 @@
 
 #include "MDLModel.h"
 
+#include "FileManager/MemoryFile.h"
+#include "FileManager/TextLexer.h"
+
 
 /**
  *  File reader used to parse the MDL file and fill a NWN::Model object with it's content.
@@ -86,9 +89,6 @@ private:
 
     String GetSymbolString( UInt32 pSymbol ) const;
 
-    void SkipComments();
-    void EatWhite( Bool pEOLIsWhite = true );
-
     void InitializeSymbolTable();
     
 private:
@@ -99,7 +99,8 @@ private:
     UInt32                          mCurrentSymbol;
     String                          mCurrentSymbolString;
 
-    std::stringstream               mStringStream;
+    MemoryFile                      mMemoryFile;
+    TextLexer                       mLexer;
 
     static Bool                     mSymbolTableInitialized;
     static std::map<String,UInt32>  mSymbolTable;
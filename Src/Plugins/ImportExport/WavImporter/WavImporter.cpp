@@ -45,10 +45,11 @@ Class* WavImporter::GetResourceClass()
     return SoundData::StaticClass();
 }
 
-Resource* WavImporter::Import( const String& pFilename, const String& /*pParams*/ )
+Resource* WavImporter::Import( const String& pFilename, const String& pParams )
 {
+    // "Stream" only maps the file, the sound data is read while it plays.
     WavReader  wavReader;
-    SoundData* soundData = wavReader.Read(pFilename);
+    SoundData* soundData = wavReader.Read(pFilename, pParams == "Stream");
 
     return soundData;
 }
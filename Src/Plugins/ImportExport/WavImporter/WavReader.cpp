@@ -29,17 +29,15 @@
 #include "WavReader.h"
 
 #include "Resource/ResourceManager.h"
+#include "Sound/SoundStream.h"
 
 
 WavReader::WavReader()
 {
 }
 
-SoundData* WavReader::Read(const String& pFileName)
+SoundData* WavReader::Read(const String& pFileName, Bool pStream)
 {
-    SoundData* newSoundData = GD_NEW(SoundData, this, "SoundData");
-    newSoundData->SetFileName(pFileName);
-
     Char identifier[5];
     identifier[4] = '\0';
 
@@ -55,62 +53,102 @@ SoundData* WavReader::Read(const String& pFileName)
     Int32 fileDataSize;
     fileStream.read((Char*)(&fileDataSize), 4);
     fileDataSize += 8;
-    newSoundData->SetFileDataSize(fileDataSize);
 
     // Read "WAVE".
     fileStream.read(identifier, 4);
     if(strcmp(identifier, "WAVE") != 0)
         throw ResourceImportException( String("The wav file should contain the WAVE identifier."), Here );
-    
-    // Read "fmt_"
-    fileStream.read(identifier, 4);
-    if(strcmp(identifier, "fmt ") != 0)
+
+    SoundData* newSoundData;
+    if(pStream)
+        newSoundData = GD_NEW(SoundStream, this, "SoundStream");
+    else
+        newSoundData = GD_NEW(SoundData, this, "SoundData");
+
+    newSoundData->SetFileName(pFileName);
+    newSoundData->SetFileDataSize(fileDataSize);
+
+    // Walk the chunks up to "data", skipping the ones we don't know (LIST, fact, ...).
+    Bool    formatFound = false;
+    Int32   soundDataSize = 0;
+    Int32   soundDataOffset = 0;
+
+    for(;;)
+    {
+        Int32 chunkSize;
+        fileStream.read(identifier, 4);
+        fileStream.read((Char*)(&chunkSize), 4);
+
+        if(!fileStream)
+        {
+            GD_DELETE(newSoundData);
+            throw ResourceImportException( String("The wav file should contain the data identifier."), Here );
+        }
+
+        if(strcmp(identifier, "fmt ") == 0)
+        {
+            // Read a drummy short.
+            Int16 dummyShort;
+            fileStream.read((Char*)(&dummyShort), 2);
+
+            // Read the number of channels.
+            Int16 nbChannels;
+            fileStream.read((Char*)(&nbChannels), 2);
+            newSoundData->SetNbChannels(nbChannels);
+
+            // Read the sample rate.
+            Int32 sampleRate;
+            fileStream.read((Char*)(&sampleRate), 4);
+            newSoundData->SetSampleRate(sampleRate);
+
+            // Read the bytes per second.
+            Int32 bytesPerSecond;
+            fileStream.read((Char*)(&bytesPerSecond), 4);
+            newSoundData->SetBytesPerSecond(bytesPerSecond);
+
+            // Read the bytes per sample.
+            Int16 bytesPerSample;
+            fileStream.read((Char*)(&bytesPerSample), 2);
+            newSoundData->SetBytesPerSample(bytesPerSample);
+
+            // Read the bits per sample.
+            Int16 bitsPerSample;
+            fileStream.read((Char*)(&bitsPerSample), 2);
+            newSoundData->SetBitsPerSample(bitsPerSample);
+
+            // Skip the extension of the format, if any.
+            fileStream.seekg(((chunkSize + 1) & ~1) - 16, std::ios::cur);
+            formatFound = true;
+        }
+        else if(strcmp(identifier, "data") == 0)
+        {
+            soundDataSize = chunkSize;
+            soundDataOffset = Int32(fileStream.tellg());
+            break;
+        }
+        else
+        {
+            // Chunks are word aligned.
+            fileStream.seekg((chunkSize + 1) & ~1, std::ios::cur);
+        }
+    }
+
+    if(!formatFound)
+    {
+        GD_DELETE(newSoundData);
         throw ResourceImportException( String("The wav file should contain the fmt_ identifier."), Here );
-    
-    // Read the Length of the format chunk.
-    Int32 chunkFileSize;
-    fileStream.read((Char*)(&chunkFileSize), 4);
- 
-    // Read a drummy short.
-    Int16 dummyShort;
-    fileStream.read((Char*)(&dummyShort), 2);
-
-    // Read the number of channels.
-    Int16 nbChannels;
-    fileStream.read((Char*)(&nbChannels), 2);
-    newSoundData->SetNbChannels(nbChannels);
-
-    // Read the sample rate.
-    Int32 sampleRate;
-    fileStream.read((Char*)(&sampleRate), 4);
-    newSoundData->SetSampleRate(sampleRate);
-
-    // Read the bytes per second.
-    Int32 bytesPerSecond;
-    fileStream.read((Char*)(&bytesPerSecond), 4);
-    newSoundData->SetBytesPerSecond(bytesPerSecond);
-
-    // Read the bytes per sample.
-    Int16 bytesPerSample;
-    fileStream.read((Char*)(&bytesPerSample), 2);
-    newSoundData->SetBytesPerSample(bytesPerSample);
-
-    // Read the bits per sample.
-    Int16 bitsPerSample;
-    fileStream.read((Char*)(&bitsPerSample), 2);
-    newSoundData->SetBitsPerSample(bitsPerSample);
-
-    // Read "data"
-    fileStream.read(identifier, 4);
-    if(strcmp(identifier, "data") != 0)
-        throw ResourceImportException( String("The wav file should contain the data identifier."), Here );
+    }
 
-    // Read the size of sound data.
-    Int32 soundDataSize;
-    fileStream.read((Char*)(&soundDataSize), 4);
     newSoundData->SetSoundDataSize(soundDataSize);
-    newSoundData->SetSoundDataOffset(44);
-    
+    newSoundData->SetSoundDataOffset(soundDataOffset);
+
+    if(pStream)
+    {
+        fileStream.close();
+        Cast<SoundStream>(newSoundData)->Open(pFileName, soundDataOffset, soundDataSize);
+        return newSoundData;
+    }
+
     // Read the data itself.
     fileStream.seekg(0, std::ios::beg);
     Char* data = GD_NEW_ARRAY(Char, fileDataSize + 1, this, "Data");
@@ -34,13 +34,14 @@
 
 /**
  *  File reader used to parse the Wav file and fill a SoundData object with its content.
+ *  Streamed files only have their header read, the PCM data is left to a SoundStream.
  */
 class WavReader
 {
 public:
     WavReader();
 
-    SoundData* Read(const String& pFileName);
+    SoundData* Read(const String& pFileName, Bool pStream = false);
 
 private:
     WavReader(const WavReader& pOther);
@@ -36,7 +36,7 @@
 #include "Maths/Plane3.h"
 #include "Graphic/Color4.h"
 
-#include "Graphic/Image.h"
+#include "Graphic/Image/Image.h"
 
 namespace WoW
 {
@@ -49,7 +49,7 @@ public:
 };
 
 
-const NUM_MAP_CHUNKS = 256;                  // Map chunks count pet ADT file.
+const UInt32 NUM_MAP_CHUNKS = 256;                 // Map chunks count pet ADT file.
 const UInt32 HEIGHT_MAP_SIZE = 9;
 const UInt32 DETAIL_HEIGHT_MAP_SIZE = 8;
 
@@ -33,6 +33,7 @@
 
 #include "FileManager/FileManager.h"
 #include "World/WorldTile.h"
+#include "Thread/JobManager.h"
 
 
 IMPLEMENT_CLASS(WoWImporter);
@@ -53,14 +54,152 @@ Class* WoWImporter::GetResourceClass()
     return WorldTile::StaticClass();
 }
 
-Resource* WoWImporter::Import( const String& pFilename, const String& /*pParams*/ )
+//! Read ADT files, one job per file. Each file is itself read in parallel.
+class ADTReadBody : public ParallelForBody
 {
-    WoW::ADTFile        adtFile;
-    WoW::ADTFileReader  adtFileReader( adtFile );
+public:
+    ADTReadBody( const Vector<String>& pFilenames, Vector<WoW::ADTFile*>& pADTFiles )
+        : mFilenames(pFilenames)
+        , mADTFiles(pADTFiles)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+        {
+            WoW::ADTFileReader reader( *mADTFiles[i] );
+            if( !reader.Read( mFilenames[i] ) )
+            {
+                GD_DELETE(mADTFiles[i]);
+                mADTFiles[i] = NULL;
+            }
+        }
+    }
+
+private:
+    const Vector<String>&   mFilenames;
+    Vector<WoW::ADTFile*>&  mADTFiles;
+};
+
+
+//! Decode BLP files, one job per file.
+class BLPDecodeBody : public ParallelForBody
+{
+public:
+    BLPDecodeBody( const Vector<String>& pFilenames, Vector<Image>& pImages, Vector<Byte>& pDecoded )
+        : mFilenames(pFilenames)
+        , mImages(pImages)
+        , mDecoded(pDecoded)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+            mDecoded[i] = BLPImporter::ReadImage( mFilenames[i], mImages[i] );
+    }
+
+private:
+    const Vector<String>&   mFilenames;
+    Vector<Image>&          mImages;
+    Vector<Byte>&           mDecoded;
+};
+
+
+Resource* WoWImporter::Import( const String& pFilename, const String& pParams )
+{
+    Vector<String>      filenames;
+    Vector<Resource*>   resources;
+
+    filenames.push_back( pFilename );
+    ImportBatch( filenames, resources, pParams );
+
+    if( resources[0] == NULL )
+        throw ResourceImportException( String("Unable to read \"") + pFilename + String("\""), Here );
+
+    return resources[0];
+}
+
+void WoWImporter::ImportBatch( const Vector<String>& pFilenames, Vector<Resource*>& pResources, const String& /*pParams*/ )
+{
+    // Read every ADT file.
+    Vector<WoW::ADTFile*> adtFiles;
+    adtFiles.resize( pFilenames.size() );
+    for( UInt32 i = 0; i < adtFiles.size(); i++ )
+        adtFiles[i] = GD_NEW(WoW::ADTFile, this, "WoW::ADTFile");
+
+    ADTReadBody readBody( pFilenames, adtFiles );
+    JobManager::Instance()->ParallelFor( adtFiles.size(), 1, readBody );
+
+    // Decode the textures that are not loaded yet, once even if several tiles use them.
+    Map<String,UInt32>  textureIndices;
+    Vector<String>      texturePaths;
+    Vector<String>      decodePaths;
+
+    for( UInt32 i = 0; i < adtFiles.size(); i++ )
+    {
+        if( adtFiles[i] == NULL )
+            continue;
+
+        for( UInt32 iName = 0; iName < adtFiles[i]->mTextureNames.size(); iName++ )
+        {
+            const String& name = adtFiles[i]->mTextureNames[iName];
+            if( textureIndices.find( name ) != textureIndices.end() )
+                continue;
+
+            String path = String("Data/") + name;
+            if( !TextureManager::Instance().IsLoaded( path ) )
+                decodePaths.push_back( path );
+
+            textureIndices[name] = texturePaths.size();
+            texturePaths.push_back( path );
+        }
+    }
+
+    Vector<Image> decodedImages;
+    Vector<Byte>  decoded;
+    decodedImages.resize( decodePaths.size() );
+    decoded.resize( decodePaths.size() );
 
-    adtFileReader.Read( pFilename );
+    BLPDecodeBody decodeBody( decodePaths, decodedImages, decoded );
+    JobManager::Instance()->ParallelFor( decodePaths.size(), 1, decodeBody );
 
+    for( UInt32 i = 0; i < decodePaths.size(); i++ )
+    {
+        if( decoded[i] )
+            BLPImporter::AddDecodedImage( decodePaths[i], decodedImages[i] );
+    }
+
+    // Textures are shared by every tile of the batch.
+    Vector<HTexture2D> textures;
+    textures.resize( texturePaths.size() );
+    for( UInt32 i = 0; i < texturePaths.size(); i++ )
+        textures[i].GetTexture( texturePaths[i] );
+
+    BLPImporter::ClearDecodedImages();
+
+    // Build the tiles, this creates the alpha map textures and must stay on this thread.
+    pResources.resize( pFilenames.size() );
+
+    Vector<HTexture2D> tileTextures;
+    for( UInt32 i = 0; i < adtFiles.size(); i++ )
+    {
+        pResources[i] = NULL;
+        if( adtFiles[i] == NULL )
+            continue;
+
+        tileTextures.resize( adtFiles[i]->mTextureNames.size() );
+        for( UInt32 iName = 0; iName < tileTextures.size(); iName++ )
+            tileTextures[iName] = textures[textureIndices[adtFiles[i]->mTextureNames[iName]]];
+
+        pResources[i] = (Resource*)CreateTile( *adtFiles[i], tileTextures );
+        GD_DELETE(adtFiles[i]);
+    }
+}
 
+WorldTile* WoWImporter::CreateTile( const WoW::ADTFile& pADTFile, const Vector<HTexture2D>& pTextures )
+{
     WorldTile* worldTile = GD_NEW(WorldTile, this, "WoW::WorldTile");
     worldTile->GetTerrainChunks().resize( 256 );
     worldTile->GetVertexList().Allocate( 16*16 * (9*9 + 8*8), (VertexFormat::Component) (VertexFormat::Position3 | VertexFormat::TexCoord2 | VertexFormat::TexCoord2_2 | VertexFormat::Normal3) );
@@ -75,11 +214,11 @@ Resource* WoWImporter::Import( const String& pFilename, const String& /*pParams*
 
     for( UInt32 iChunk = 0; iChunk < 256; iChunk++ )
     {
-        WoW::ADTFile::MapChunk* mapChunk = &adtFile.mMapChunks[iChunk];
+        const WoW::ADTFile::MapChunk* mapChunk = &pADTFile.mMapChunks[iChunk];
 
         // Append vertex data to vertex buffer
-        Float* ptrDataHeight  = mapChunk->mHeightMap;
-        Char*  ptrDataNormals = mapChunk->mHeightMapNormals[0];
+        const Float* ptrDataHeight  = mapChunk->mHeightMap;
+        const Char*  ptrDataNormals = mapChunk->mHeightMapNormals[0];
 
         Vector3f chunkPos( -1.0f*mapChunk->mHeader.mPosition.y, mapChunk->mHeader.mPosition.z, -1.0f*mapChunk->mHeader.mPosition.x );
         Float  posX = chunkPos.x - firstChunkPos.x;
@@ -157,9 +296,7 @@ Resource* WoWImporter::Import( const String& pFilename, const String& /*pParams*
 
 		for( UInt32 iLayer = 0; iLayer < mapChunk->mTextureLayers.size(); iLayer++ )
         {
-			String textureName("Data/");
-			textureName += adtFile.mTextureNames[mapChunk->mTextureLayers[iLayer].mTextureID];
-			HTexture2D texture(textureName);
+			const HTexture2D& texture = pTextures[mapChunk->mTextureLayers[iLayer].mTextureID];
 
             Texture2D* alpha = NULL;
 
@@ -236,7 +373,7 @@ Resource* WoWImporter::Import( const String& pFilename, const String& /*pParams*
         worldTile->GetTerrainChunks()[iChunk] = newChunk;
     }
     
-    return (Resource*)worldTile;
+    return worldTile;
 }
 
 
@@ -283,12 +420,36 @@ Class* BLPImporter::GetResourceClass()
 	return Texture::StaticClass();
 }
 
+Map<String,Image> BLPImporter::mDecodedImages;
+
 Resource* BLPImporter::Import( const String& pFilename, const String& /*pParams*/ )
+{
+	Image img;
+
+    Map<String,Image>::iterator itDecoded = mDecodedImages.find( pFilename );
+    if( itDecoded != mDecodedImages.end() )
+    {
+        img.Swap( itDecoded->second );
+        mDecodedImages.erase( itDecoded );
+    }
+    else if( !ReadImage( pFilename, img ) )
+    {
+        throw ResourceImportException( String("Unable to read \"") + pFilename + String("\""), Here );
+    }
+
+	Texture2D* tex2D = Cast<Texture2D>(Texture2D::StaticClass()->AllocateNew( pFilename ));
+	tex2D->Create( img );
+	
+	return tex2D;	
+}
+
+Bool BLPImporter::ReadImage( const String& pFilename, Image& pImage )
 {
 	WoW::BLPFile        blpFile;
 	WoW::BLPFileReader  blpFileReader( blpFile );
 
-	blpFileReader.Read( pFilename );
+	if( !blpFileReader.Read( pFilename ) )
+        return false;
 
 	Image::Format format;
 	if( blpFile.mHeader.mCompression == 2 )
@@ -305,13 +466,19 @@ Resource* BLPImporter::Import( const String& pFilename, const String& /*pParams*
 		format = Image::Format_R8G8B8A8;
 	}
 
-	Image img;
-	img.Create( blpFile.mHeader.mSizeX, blpFile.mHeader.mSizeY, format, blpFile.mMipmapCount );
+	pImage.Create( blpFile.mHeader.mSizeX, blpFile.mHeader.mSizeY, format, blpFile.mMipmapCount );
 
-	memcpy( img.GetData(), &blpFile.mData[0], blpFile.mData.size() );
+	memcpy( pImage.GetData(), &blpFile.mData[0], blpFile.mData.size() );
 
-	Texture2D* tex2D = Cast<Texture2D>(Texture2D::StaticClass()->AllocateNew( pFilename ));
-	tex2D->Create( img );
-	
-	return tex2D;	
-}
\ No newline at end of file
+    return true;
+}
+
+void BLPImporter::AddDecodedImage( const String& pFilename, Image& pImage )
+{
+    mDecodedImages[pFilename].Swap( pImage );
+}
+
+void BLPImporter::ClearDecodedImages()
+{
+    mDecodedImages.clear();
+}
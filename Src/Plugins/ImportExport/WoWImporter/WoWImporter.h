@@ -31,9 +31,16 @@
 
 #include "Resource/ResourceManager.h"
 
+#include "Graphic/Texture/TextureHdl.h"
+
 #include "WoWFiles.h"
 
 
+namespace Gamedesk {
+    class WorldTile;
+}
+
+
 class WoWIMPORTER_API WoWImporter : public ResourceImporter
 {
     DECLARE_CLASS(WoWImporter,ResourceImporter);
@@ -43,6 +50,16 @@ public:
 
     virtual Class*    GetResourceClass();
     virtual Resource* Import( const String& pFilename, const String& pParams = "" );
+
+    /**
+     *  Import several ADT tiles. The files are read in parallel, then the BLP
+     *  textures they use are decoded once, in parallel, and shared by every tile.
+     */
+    virtual void      ImportBatch( const Vector<String>& pFilenames, Vector<Resource*>& pResources, const String& pParams = "" );
+
+private:
+    //! Build the tile, pTextures has one texture per name of pADTFile.mTextureNames.
+    WorldTile*        CreateTile( const WoW::ADTFile& pADTFile, const Vector<HTexture2D>& pTextures );
 };
 
 class WoWIMPORTER_API BLPImporter : public ResourceImporter
@@ -54,6 +71,18 @@ public:
 
 	virtual Class*    GetResourceClass();
 	virtual Resource* Import( const String& pFilename, const String& pParams = "" );
+
+    //! Decode pFilename without creating a texture. Returns false if the file can't be read.
+    static Bool       ReadImage( const String& pFilename, Image& pImage );
+
+    //! The next Import() of pFilename takes pImage instead of reading the file. pImage is emptied.
+    static void       AddDecodedImage( const String& pFilename, Image& pImage );
+
+    //! Forget the decoded images that were not imported.
+    static void       ClearDecodedImages();
+
+private:
+    static Map<String,Image>    mDecodedImages;
 };
 
 
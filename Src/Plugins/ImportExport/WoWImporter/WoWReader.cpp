@@ -30,6 +30,7 @@
 
 #include "FileManager/FileManager.h"
 #include "Resource/ResourceManager.h"
+#include "Thread/JobManager.h"
 
 
 #define M_ID( a, b, c, d )  (((a) << 24) + ((b) << 16) + ((c) << 8) + ((d) << 0))
@@ -59,24 +60,52 @@ const UInt32 W_MCSE = M_ID('M','C','S','E');
 namespace WoW
 {
 
+class ADTMapChunkBody : public ParallelForBody
+{
+public:
+    ADTMapChunkBody( const Byte* pData, const UInt32* pOffsets, const UInt32* pSizes, ADTFile& pADT )
+        : mData(pData)
+        , mOffsets(pOffsets)
+        , mSizes(pSizes)
+        , mADT(pADT)
+    {
+    }
+
+    virtual void Execute( UInt32 pBegin, UInt32 pEnd )
+    {
+        for( UInt32 i = pBegin; i < pEnd; i++ )
+        {
+            WowMemoryStream chunkStream( mData + mOffsets[i], mSizes[i] );
+            ADTFileReader::ReadMapChunk( chunkStream, mADT.mMapChunks[i] );
+        }
+    }
+
+private:
+    const Byte*     mData;
+    const UInt32*   mOffsets;
+    const UInt32*   mSizes;
+    ADTFile&        mADT;
+};
+
+
 ADTFileReader::ADTFileReader( ADTFile& pFile )
     : mADT(pFile)
 {
 }
 
-void ADTFileReader::Read( const String& pFileName )
+Bool ADTFileReader::Read( const String& pFileName )
 {
     WowFileStream stream;
-    stream.Open( pFileName );
+    if( !stream.Open( pFileName ) )
+        return false;
     
     UInt32  iMapChunk = 0;
     UInt32  chunkId;
     UInt32  chunkSize;
-    Char    chunkName[5];
+    UInt32  mapChunkOffsets[NUM_MAP_CHUNKS];
+    UInt32  mapChunkSizes[NUM_MAP_CHUNKS];
 
-    chunkName[4] = '\0';
-
-    while( iMapChunk != 256 )
+    while( iMapChunk != NUM_MAP_CHUNKS )
     {
         stream << chunkId;
         stream << chunkSize;
@@ -120,9 +149,11 @@ void ADTFileReader::Read( const String& pFileName )
             }
             break;
 
-        // Map chunks
+        // Map chunks, only located here.
         case W_MCNK:
-            ReadMapChunk( stream, mADT.mMapChunks[iMapChunk], chunkSize );
+            mapChunkOffsets[iMapChunk] = stream.Pos();
+            mapChunkSizes[iMapChunk] = chunkSize;
+            stream.SeekRel( chunkSize );
             iMapChunk++;
             break;
 
@@ -157,11 +188,16 @@ void ADTFileReader::Read( const String& pFileName )
             stream.SeekRel( chunkSize );
         }
     }
+
+    ADTMapChunkBody body( stream.GetData(), mapChunkOffsets, mapChunkSizes, mADT );
+    JobManager::Instance()->ParallelFor( NUM_MAP_CHUNKS, 16, body );
+
+    return true;
 }
 
-void ADTFileReader::ReadMapChunk( WowFileStream& pStream, ADTFile::MapChunk& pMapChunk, UInt32 pChunkSize )
+void ADTFileReader::ReadMapChunk( WowMemoryStream& pStream, ADTFile::MapChunk& pMapChunk )
 {
-    UInt32 endPos = pStream.Pos() + pChunkSize;
+    UInt32 endPos = pStream.Size();
 
     // Header
     pStream << pMapChunk.mHeader.mFlags;
@@ -198,9 +234,6 @@ void ADTFileReader::ReadMapChunk( WowFileStream& pStream, ADTFile::MapChunk& pMa
 
     UInt32  subChunkId;
     UInt32  subChunkSize;
-    Char    subChunkName[5];
-
-    subChunkName[4] = '\0';
 
     // Read sub chunks
     while( pStream.Pos() != endPos )
@@ -298,10 +331,11 @@ BLPFileReader::BLPFileReader( BLPFile& pFile )
 {
 }
 
-void BLPFileReader::Read( const String& pFilename )
+Bool BLPFileReader::Read( const String& pFilename )
 {
 	WowFileStream stream;
-	stream.Open( pFilename );
+	if( !stream.Open( pFilename ) )
+        return false;
 
 	stream << mBLP.mHeader.mFileTag[0];		// Always BLP2
 	stream << mBLP.mHeader.mFileTag[1];		// Always BLP2
@@ -340,6 +374,8 @@ void BLPFileReader::Read( const String& pFilename )
     	stream.Serialize( &mBLP.mData[offset], mBLP.mHeader.mSizes[i] );
         offset += mBLP.mHeader.mSizes[i];
     }
+
+    return true;
 }
 
 }
\ No newline at end of file
@@ -70,41 +70,26 @@ private:
 };
 
 
-class WowFileStream : public InputStream
+/**
+ *  Read from a memory range it doesn't own. Several streams can read the same
+ *  data from different threads.
+ */
+class WowMemoryStream : public InputStream
 {
 public:
-    WowFileStream()
-        : mMemFile(NULL)
+    WowMemoryStream()
+        : mData(NULL)
         , mSize(0)
         , mPos(0)
     {
     }
 
-    virtual ~WowFileStream()
-    {
-        Close();
-    }
-
-    Bool Open( const String& pPath )
-    {
-        mMemFile = GD_NEW(MemoryFile, this, "WowImporter::Memory File")( pPath, true );
-        mIsValid = (mMemFile->GetMemory() != NULL);
-
-        // Get file size.
-        if( mIsValid )
-            mSize = mMemFile->GetSize();
-
-        mPos = 0;
-
-        return mIsValid;
-    }
-
-    Bool Close()
+    WowMemoryStream( const Byte* pData, UInt32 pSize )
+        : mData(pData)
+        , mSize(pSize)
+        , mPos(0)
     {
-        if( mMemFile )
-            GD_DELETE(mMemFile);
-
-        return true;
+        mIsValid = (pData != NULL);
     }
 
     UInt32 Size()
@@ -119,12 +104,18 @@ public:
         return mPos;
     }
 
+    //! Data of the whole stream, independently of the current position.
+    const Byte* GetData() const
+    {
+        return mData;
+    }
+
     void Serialize( void* pData, UInt32 pLen )
     {
         GD_ASSERT_M( mIsValid, "Trying to access an invalid stream!" );
         GD_ASSERT_M( mPos + pLen <= mSize, "Trying to read past file buffer!" );
 
-        memcpy( pData, mMemFile->GetMemory() + mPos, pLen );
+        memcpy( pData, mData + mPos, pLen );
         mPos += pLen;
     }
 
@@ -140,24 +131,78 @@ public:
         mPos = pPos;
     }
 
-private:
-    MemoryFile* mMemFile;
+protected:
+    const Byte* mData;
     UInt32      mSize;
     UInt32      mPos;
 };
 
 
+class WowFileStream : public WowMemoryStream
+{
+public:
+    WowFileStream()
+        : mMemFile(NULL)
+    {
+    }
+
+    virtual ~WowFileStream()
+    {
+        Close();
+    }
+
+    Bool Open( const String& pPath )
+    {
+        Close();
+
+        mMemFile = GD_NEW(MemoryFile, this, "WowImporter::Memory File")( pPath, true );
+        mData = mMemFile->GetMemory();
+        mIsValid = (mData != NULL);
+
+        // Get file size.
+        mSize = mIsValid ? mMemFile->GetSize() : 0;
+        mPos = 0;
+
+        return mIsValid;
+    }
+
+    Bool Close()
+    {
+        if( mMemFile )
+        {
+            GD_DELETE(mMemFile);
+            mMemFile = NULL;
+        }
+
+        mData = NULL;
+        mIsValid = false;
+
+        return true;
+    }
+
+private:
+    MemoryFile* mMemFile;
+};
+
+
+/**
+ *  The MCNK chunks of an ADT file are independent, they are located first then
+ *  read in parallel.
+ */
 class ADTFileReader
 {
     CLASS_DISABLE_COPY(ADTFileReader);
 
+    friend class ADTMapChunkBody;
+
 public:
     ADTFileReader( ADTFile& pFile );
 
-    void Read( const String& pFileName );
+    //! Returns false if the file can't be opened.
+    Bool Read( const String& pFileName );
 
 private:
-    void ReadMapChunk( WowFileStream& pStream, ADTFile::MapChunk& pMapChunk, UInt32 pChunkSize );
+    static void ReadMapChunk( WowMemoryStream& pStream, ADTFile::MapChunk& pMapChunk );
 
 private:
     ADTFile&       mADT;
@@ -171,7 +216,8 @@ class BLPFileReader
 public:
 	BLPFileReader( BLPFile& pFile );
 
-	void Read( const String& pFileName );
+    //! Returns false if the file can't be opened.
+	Bool Read( const String& pFileName );
 
 private:
 	BLPFile&       mBLP;
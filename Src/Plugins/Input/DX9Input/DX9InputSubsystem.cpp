@@ -30,6 +30,9 @@
 #include "DX9InputKeyTable.h"
 
 #include "Application/Application.h"
+#include "Debug/PerformanceMonitor.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Thread/Thread.h"
 
 
 namespace Gamedesk {
@@ -38,19 +41,61 @@ namespace Gamedesk {
 IMPLEMENT_CLASS(DX9InputSubsystem);
 
 
+//! Convert a DirectInput time stamp (GetTickCount() time) to SystemInfo::GetMicroSec64() time.
+static UInt64 EventTime( DWORD pTimeStamp, DWORD pTickCount, UInt64 pNow )
+{
+    UInt64 age = (UInt64)(DWORD)(pTickCount - pTimeStamp) * 1000;
+    return age < pNow ? pNow - age : 0;
+}
+
+
+/**
+ *  Sleep until DirectInput has data for one of the devices, and post it.
+ */
+class DX9InputSubsystem::InputThread : public Thread
+{
+public:
+    InputThread( DX9InputSubsystem& pSubsystem ) : mSubsystem(pSubsystem)
+    {
+    }
+
+    virtual void Run()
+    {
+#if GD_CFG_USE_PERF_MONITOR == GD_ENABLED
+        Profiler::SetThreadName( "DX9InputSubsystem::InputThread" );
+#endif
+
+        HANDLE events[] = { mSubsystem.mStopEvent, mSubsystem.mKeyboardEvent, mSubsystem.mMouseEvent };
+
+        for(;;)
+        {
+            // Wake up regularly to acquire again the devices that were lost.
+            if( WaitForMultipleObjects( 3, events, FALSE, 100 ) == WAIT_OBJECT_0 )
+                break;
+
+            mSubsystem.ReadKeyboard();
+            mSubsystem.ReadMouse();
+            mSubsystem.SyncDroppedEvents();
+        }
+    }
+
+private:
+    DX9InputSubsystem&  mSubsystem;
+};
+
+
 DX9InputSubsystem::DX9InputSubsystem() : 
     mDirectInput(NULL),
     mKeyboardDevice(NULL),
-    mMouseDevice(NULL)
+    mMouseDevice(NULL),
+    mKeyboardEvent(NULL),
+    mMouseEvent(NULL),
+    mStopEvent(NULL),
+    mInputThread(NULL),
+    mNbDroppedEvents(0)
 {
-    // Reset last mouse state.
-    mLastMouseState.lX = 0;
-    mLastMouseState.lY = 0;
-    mLastMouseState.lZ = 0;
-    memset( &mLastMouseState.rgbButtons, 0, sizeof(mLastMouseState.rgbButtons) );
-    
-    // Reset las keyboard state.
-    memset( &mLastKeyboardState, 0, sizeof(mLastKeyboardState) );
+    memset( mKeysDown, 0, sizeof(mKeysDown) );
+    memset( mButtonsDown, 0, sizeof(mButtonsDown) );
 
     InitDInputToGamedeskKeyTable();
 }
@@ -66,9 +111,33 @@ void DX9InputSubsystem::Init()
     if( FAILED(hResult) )
         throw DInputException(hResult,Here);
 
+    mKeyboardEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+    mMouseEvent    = CreateEvent( NULL, FALSE, FALSE, NULL );
+    mStopEvent     = CreateEvent( NULL, TRUE, FALSE, NULL );
+
     // Create 2 basic devices, the mouse and the keyboard.
     InitKeyboard();
     InitMouse();    
+
+    mInputThread = GD_NEW(InputThread, this, "DX9InputSubsystem::InputThread")(*this);
+    mInputThread->Start( Thread::PriorityAboveNormal );
+}
+
+//! Set the size of the DirectInput buffer and the event signaled when there's new data.
+static HRESULT SetBuffered( LPDIRECTINPUTDEVICE8 pDevice, UInt32 pBufferSize, HANDLE pEvent )
+{
+    DIPROPDWORD property;
+    property.diph.dwSize       = sizeof(DIPROPDWORD);
+    property.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+    property.diph.dwObj        = 0;
+    property.diph.dwHow        = DIPH_DEVICE;
+    property.dwData            = pBufferSize;
+
+    HRESULT hResult = pDevice->SetProperty( DIPROP_BUFFERSIZE, &property.diph );
+    if( FAILED(hResult) )
+        return hResult;
+
+    return pDevice->SetEventNotification( pEvent );
 }
 
 void DX9InputSubsystem::InitKeyboard()
@@ -97,6 +166,13 @@ void DX9InputSubsystem::InitKeyboard()
         throw DInputException(hResult,Here);
     } 
 
+    hResult = SetBuffered( mKeyboardDevice, BUFFER_SIZE, mKeyboardEvent );
+    if( FAILED(hResult) )
+    { 
+        Kill();
+        throw DInputException(hResult,Here);
+    } 
+
     if( mKeyboardDevice )
         mKeyboardDevice->Acquire();
 }
@@ -127,14 +203,30 @@ void DX9InputSubsystem::InitMouse()
         throw DInputException(hResult,Here);
     } 
 
+    hResult = SetBuffered( mMouseDevice, BUFFER_SIZE, mMouseEvent );
+    if( FAILED(hResult) )
+    { 
+        Kill();
+        throw DInputException(hResult,Here);
+    } 
+
     mMouseDevice->Acquire();
 }
 
 void DX9InputSubsystem::Kill()
 {
+    if( mInputThread )
+    {
+        SetEvent( mStopEvent );
+        mInputThread->WaitUntilStopped();
+        GD_DELETE(mInputThread);
+        mInputThread = NULL;
+    }
+
     if( mKeyboardDevice )
     {
         mKeyboardDevice->Unacquire();
+        mKeyboardDevice->SetEventNotification( NULL );
         mKeyboardDevice->Release();
         mKeyboardDevice = NULL;
     }
@@ -142,6 +234,7 @@ void DX9InputSubsystem::Kill()
     if( mMouseDevice )
     {
         mMouseDevice->Unacquire();
+        mMouseDevice->SetEventNotification( NULL );
         mMouseDevice->Release();
         mMouseDevice = NULL;
     }
@@ -152,137 +245,164 @@ void DX9InputSubsystem::Kill()
         mDirectInput = NULL;
     }
 
+    HANDLE* events[] = { &mKeyboardEvent, &mMouseEvent, &mStopEvent };
+    for( UInt32 i = 0; i < 3; i++ )
+    {
+        if( *events[i] )
+        {
+            CloseHandle( *events[i] );
+            *events[i] = NULL;
+        }
+    }
+
     Super::Kill();
 }
 
 void DX9InputSubsystem::Update()
 {
-    UpdateMouse();
-    UpdateKeyboard();
+    POINT pos;
+    GetCursorPos( &pos );
+    SetMousePosition( pos.x, pos.y );
 
+    // Apply what the input thread posted since the last frame.
     FireEvents();
 }
 
-void DX9InputSubsystem::UpdateMouse()
+void DX9InputSubsystem::ReadMouse()
 {
-    HRESULT         hResult;
-    DIMOUSESTATE2   mouseState;     // DirectInput mouse state structure
+    DIDEVICEOBJECTDATA  data[BUFFER_SIZE];
+    DWORD               nbData = BUFFER_SIZE;
 
-    // Get mouse state
-    memset( &mouseState, 0, sizeof(mouseState) );
-    hResult = mMouseDevice->GetDeviceState( sizeof(DIMOUSESTATE2), &mouseState );
+    // DI_BUFFEROVERFLOW is a success, the oldest events are lost.
+    HRESULT hResult = mMouseDevice->GetDeviceData( sizeof(DIDEVICEOBJECTDATA), data, &nbData, 0 );
     if( FAILED(hResult) ) 
     {
-        // DirectInput may be telling us that the input stream has been
-        // interrupted.  We aren't tracking any state between polls, so
-        // we don't have any special reset that needs to be done.
-        // We just re-acquire and try again.
-        
-        // If input is lost then acquire and keep trying 
-        hResult = mMouseDevice->Acquire();
-        while( hResult == DIERR_INPUTLOST ) 
-            hResult = mMouseDevice->Acquire();
-
-        // Update the dialog text 
-        if( hResult == DIERR_OTHERAPPHASPRIO || hResult == DIERR_NOTACQUIRED ) 
-        {
-            // #TODO: Clear input here ?
-        }
-         
-        // hResult may be DIERR_OTHERAPPHASPRIO or other errors.  This
-        // may occur when the app is minimized or in the process of 
-        // switching, so just try again later 
+        // Input was lost or the application is in the background, try again later.
+        // The buttons that changed meanwhile have no event, post them from the current state.
+        UInt64 now = SystemInfo::Instance()->GetMicroSec64();
+        DIMOUSESTATE2 state;
+        if( SUCCEEDED(mMouseDevice->Acquire()) && SUCCEEDED(mMouseDevice->GetDeviceState( sizeof(state), &state )) )
+            SyncMouse( state.rgbButtons, now );
+        else
+            SyncMouse( NULL, now );
+        return;
     }
 
-    // Store new buttons states
-    for( Int32 iButton = 0; iButton < Mouse::Button_NumButtons; iButton++ )
+    UInt64 now = SystemInfo::Instance()->GetMicroSec64();
+    DWORD  tickCount = GetTickCount();
+
+    // Movements are summed by frame anyway, post one event per axis instead of one per delta.
+    Int32  motion[3] = { 0, 0, 0 };
+    UInt64 motionTime = 0;
+
+    for( UInt32 i = 0; i < nbData; i++ )
     {
-        if( (mouseState.rgbButtons[iButton] & 0x80) )
+        DWORD  offset = data[i].dwOfs;
+        UInt64 time   = EventTime( data[i].dwTimeStamp, tickCount, now );
+
+        if( offset == DIMOFS_X || offset == DIMOFS_Y || offset == DIMOFS_Z )
         {
-            if( mLastMouseState.rgbButtons[iButton] & 0x80 )
-                SetMouseButtonState( (Mouse::Button)iButton, Mouse::Button_Down );
-            else
-                SetMouseButtonState( (Mouse::Button)iButton, Mouse::Button_Pressed );
+            motion[(offset - DIMOFS_X) / sizeof(LONG)] += (LONG)data[i].dwData;
+            motionTime = time;
         }
-        else
+        else if( offset >= DIMOFS_BUTTON0 && offset < DIMOFS_BUTTON0 + Mouse::Button_NumButtons )
         {
-            if( mLastMouseState.rgbButtons[iButton] & 0x80 )
-                SetMouseButtonState( (Mouse::Button)iButton, Mouse::Button_Released );
-            else
-                SetMouseButtonState( (Mouse::Button)iButton, Mouse::Button_Up );
+            UInt32 button = offset - DIMOFS_BUTTON0;
+            Bool   down   = (data[i].dwData & 0x80) != 0;
+
+            // A dropped event is posted again by SyncDroppedEvents().
+            if( PostMouseButtonEvent( (Mouse::Button)button, down, time ) )
+                mButtonsDown[button] = down;
         }
     }
 
-    // Update mouse relative mouvement.
-    SetMouseAxisValue( Mouse::Axis_X, mouseState.lX );
-    SetMouseAxisValue( Mouse::Axis_Y, mouseState.lY );
-    SetMouseAxisValue( Mouse::Axis_Z, mouseState.lZ );
-
-    POINT pos;
-    GetCursorPos( &pos );
-    SetMousePosition( pos.x, pos.y );
-
-    // Now make this new state the last obtained state.
-    memcpy( &mLastMouseState, &mouseState, sizeof(mouseState) );
+    const Mouse::Axis axes[3] = { Mouse::Axis_X, Mouse::Axis_Y, Mouse::Axis_Z };
+    for( UInt32 i = 0; i < 3; i++ )
+    {
+        if( motion[i] != 0 )
+            PostMouseMotionEvent( axes[i], motion[i], motionTime );
+    }
 }
 
-void DX9InputSubsystem::UpdateKeyboard()
+void DX9InputSubsystem::ReadKeyboard()
 {
-    HRESULT         hResult;
-    static Byte     keyState[DI_KEY_ARRAY_SIZE];  // DirectInput keyboard state buffer 
+    DIDEVICEOBJECTDATA  data[BUFFER_SIZE];
+    DWORD               nbData = BUFFER_SIZE;
 
-    // Get keyboard state
-    memset( keyState, 0, DI_KEY_ARRAY_SIZE );
-    hResult = mKeyboardDevice->GetDeviceState( sizeof(keyState), keyState );
+    HRESULT hResult = mKeyboardDevice->GetDeviceData( sizeof(DIDEVICEOBJECTDATA), data, &nbData, 0 );
     if( FAILED(hResult) ) 
     {
-        // DirectInput may be telling us that the input stream has been
-        // interrupted.  We aren't tracking any state between polls, so
-        // we don't have any special reset that needs to be done.
-        // We just re-acquire and try again.
-        
-        // If input is lost then acquire and keep trying 
-        hResult = mKeyboardDevice->Acquire();
-        while( hResult == DIERR_INPUTLOST ) 
-            hResult = mKeyboardDevice->Acquire();
-
-        if( hResult == DIERR_OTHERAPPHASPRIO || hResult == DIERR_NOTACQUIRED ) 
-        {
-            // #TODO: Clear input here ?
-        }
+        UInt64 now = SystemInfo::Instance()->GetMicroSec64();
+        BYTE state[DI_KEY_ARRAY_SIZE];
+        if( SUCCEEDED(mKeyboardDevice->Acquire()) && SUCCEEDED(mKeyboardDevice->GetDeviceState( sizeof(state), state )) )
+            SyncKeyboard( state, now );
+        else
+            SyncKeyboard( NULL, now );
+        return;
+    }
 
-        // hResult may be DIERR_OTHERAPPHASPRIO or other errors.  This
-        // may occur when the app is minimized or in the process of 
-        // switching, so just try again later 
-    }    
+    UInt64 now = SystemInfo::Instance()->GetMicroSec64();
+    DWORD  tickCount = GetTickCount();
 
-    Keyboard::Key currentKey;
-    for( Int32 iKey = 0; iKey < DI_KEY_ARRAY_SIZE; iKey++ )
+    for( UInt32 i = 0; i < nbData; i++ )
     {
         // Ignore unused keys
-        if( gDInputToGamedeskKeyTable[iKey] == -1 )
+        Int32 key = data[i].dwOfs < DI_KEY_ARRAY_SIZE ? gDInputToGamedeskKeyTable[data[i].dwOfs] : -1;
+        if( key == -1 )
             continue;
-        else 
-            currentKey = (Keyboard::Key)gDInputToGamedeskKeyTable[iKey];
 
-        if( keyState[iKey] & 0x80 )
-        {
-            if( mLastKeyboardState[iKey] & 0x80 )
-                Super::SetKeyboardState( currentKey, Keyboard::Key_Down );
-            else
-                Super::SetKeyboardState( currentKey, Keyboard::Key_Pressed );
-        }
-        else
-        {
-            if( mLastKeyboardState[iKey] & 0x80 )
-                Super::SetKeyboardState( currentKey, Keyboard::Key_Released );
-            else
-                Super::SetKeyboardState( currentKey, Keyboard::Key_Up );
-        }
+        // A dropped event is posted again by SyncDroppedEvents().
+        Bool down = (data[i].dwData & 0x80) != 0;
+        if( PostKeyEvent( (Keyboard::Key)key, down, EventTime( data[i].dwTimeStamp, tickCount, now ) ) )
+            mKeysDown[data[i].dwOfs] = down;
+    }
+}
+
+void DX9InputSubsystem::SyncKeyboard( const BYTE* pState, UInt64 pTime )
+{
+    for( UInt32 i = 0; i < DI_KEY_ARRAY_SIZE; i++ )
+    {
+        Bool down = pState != NULL && (pState[i] & 0x80) != 0;
+        if( down == mKeysDown[i] || gDInputToGamedeskKeyTable[i] == -1 )
+            continue;
+
+        if( PostKeyEvent( (Keyboard::Key)gDInputToGamedeskKeyTable[i], down, pTime ) )
+            mKeysDown[i] = down;
     }
+}
+
+void DX9InputSubsystem::SyncMouse( const BYTE* pButtons, UInt64 pTime )
+{
+    for( UInt32 i = 0; i < Mouse::Button_NumButtons; i++ )
+    {
+        Bool down = pButtons != NULL && (pButtons[i] & 0x80) != 0;
+        if( down == mButtonsDown[i] )
+            continue;
+
+        if( PostMouseButtonEvent( (Mouse::Button)i, down, pTime ) )
+            mButtonsDown[i] = down;
+    }
+}
+
+void DX9InputSubsystem::SyncDroppedEvents()
+{
+    // Events dropped while syncing are seen at the next call, until the queue has room for all of them.
+    UInt32 nbDroppedEvents = GetNbDroppedEvents();
+    if( nbDroppedEvents == mNbDroppedEvents )
+        return;
+
+    mNbDroppedEvents = nbDroppedEvents;
+
+    UInt64 now = SystemInfo::Instance()->GetMicroSec64();
+
+    // A lost device is synced by its next read.
+    BYTE keys[DI_KEY_ARRAY_SIZE];
+    if( SUCCEEDED(mKeyboardDevice->GetDeviceState( sizeof(keys), keys )) )
+        SyncKeyboard( keys, now );
 
-    // Now make this new state the last obtained state.
-    memcpy( &mLastKeyboardState, &keyState, sizeof(keyState) );
+    DIMOUSESTATE2 state;
+    if( SUCCEEDED(mMouseDevice->GetDeviceState( sizeof(state), &state )) )
+        SyncMouse( state.rgbButtons, now );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -40,6 +40,8 @@ const Int32 DI_KEY_ARRAY_SIZE = 256;
 
 /**
  *  Input subsystem that uses DirectInput to update the devices states.
+ *  The devices are read in buffered mode by an input thread, woken up by
+ *  DirectInput, which posts their events to the InputSubsystem.
  */
 class DX9INPUT_API DX9InputSubsystem : public InputSubsystem
 {
@@ -70,19 +72,39 @@ protected:
     //! Initialize DirectInput keyboard.
     void InitKeyboard();
     
-    //! Update the state of the mouse.
-    void UpdateMouse();
+    //! Post the buffered events of the mouse, called by the input thread.
+    void ReadMouse();
 
-    //! Update the state of the keyboard.
-    void UpdateKeyboard();
+    //! Post the buffered events of the keyboard, called by the input thread.
+    void ReadKeyboard();
+
+    //! Post the keys that changed since the last event queued, pState is indexed by DirectInput offset (NULL if every key is up).
+    void SyncKeyboard( const BYTE* pState, UInt64 pTime );
+
+    //! Post the buttons that changed since the last event queued (NULL if every button is up).
+    void SyncMouse( const BYTE* pButtons, UInt64 pTime );
+
+    //! Post the keys and buttons that changed since the last event queued, if events were dropped since the last call.
+    void SyncDroppedEvents();
 
 private:
+    class InputThread;
+    friend class InputThread;
+
+    static const UInt32     BUFFER_SIZE = 256;  //!< Events buffered by DirectInput for each device.
+
     LPDIRECTINPUT8          mDirectInput;       //!< DirectInput object.
     LPDIRECTINPUTDEVICE8    mKeyboardDevice;    //!< DirectInput device for the keyboard.
     LPDIRECTINPUTDEVICE8    mMouseDevice;       //!< DirectInput device for the mouse.
 
-    DIMOUSESTATE2           mLastMouseState;                        //!< Last state of the mouse.
-    Byte                    mLastKeyboardState[DI_KEY_ARRAY_SIZE];  //!< Last state of the keyboard.
+    HANDLE                  mKeyboardEvent;     //!< Signaled by DirectInput when the keyboard has new data.
+    HANDLE                  mMouseEvent;        //!< Signaled by DirectInput when the mouse has new data.
+    HANDLE                  mStopEvent;         //!< Signaled to stop the input thread.
+    InputThread*            mInputThread;
+
+    Bool                    mKeysDown[DI_KEY_ARRAY_SIZE];           //!< Keys down for the last event queued, by DirectInput offset.
+    Bool                    mButtonsDown[Mouse::Button_NumButtons]; //!< Buttons down for the last event queued.
+    UInt32                  mNbDroppedEvents;                       //!< Dropped events at the last SyncDroppedEvents().
 };
 
 
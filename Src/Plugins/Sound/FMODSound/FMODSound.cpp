@@ -29,6 +29,7 @@
 #include "FMODSound.h"
 #include "FMODTables.h"
 #include "Sound/SoundData.h"
+#include "Sound/SoundStream.h"
 #include "Sound/SoundSubsystem.h"
 
 
@@ -38,8 +39,19 @@ namespace Gamedesk {
 IMPLEMENT_CLASS(FMODSound);
 
 
+//! Called by FMOD from its mixing thread when the stream buffer needs data.
+static signed char F_CALLBACKAPI FMODStreamCallback(FSOUND_STREAM* /*pStream*/, void* pBuffer, int pLength, void* pUserData)
+{
+    SoundStream* soundStream = (SoundStream*)pUserData;
+
+    // Returning false stops the stream, do it once all the data was played.
+    return soundStream->Read((Byte*)pBuffer, pLength) != 0;
+}
+
+
 FMODSound::FMODSound() : 
     mFMODSample(0),
+    mFMODStream(0),
     mChannel(-1)
 {
 }
@@ -54,6 +66,12 @@ void FMODSound::Create(SoundData* pSoundData, Bool pIs3DSound)
 
     GD_ASSERT(pSoundData);
 
+    if(pSoundData->IsA(SoundStream::StaticClass()))
+    {
+        CreateStream(Cast<SoundStream>(pSoundData), pIs3DSound);
+        return;
+    }
+
 	// Build the sound flags.
 	UInt32 soundFlags = FSOUND_LOADMEMORY;
 	if(pIs3DSound)
@@ -73,6 +91,22 @@ void FMODSound::Create(SoundData* pSoundData, Bool pIs3DSound)
     GD_ASSERT(mFMODSample);
 }
 
+void FMODSound::CreateStream(SoundStream* pSoundStream, Bool pIs3DSound)
+{
+    // Raw PCM, FMOD can't parse the file header through a callback.
+    UInt32 streamFlags = FSOUND_LOOP_OFF;
+    streamFlags |= pSoundStream->GetBitsPerSample() == 8 ? (FSOUND_8BITS | FSOUND_UNSIGNED) : (FSOUND_16BITS | FSOUND_SIGNED);
+    streamFlags |= pSoundStream->GetNbChannels() == 1 ? FSOUND_MONO : FSOUND_STEREO;
+    streamFlags |= pIs3DSound ? FSOUND_HW3D : FSOUND_2D;
+
+    mFMODStream = FSOUND_Stream_Create(FMODStreamCallback, STREAM_BUFFER_SIZE, streamFlags,
+                                       pSoundStream->GetSampleRate(), pSoundStream);
+
+    // Set the frequency
+    Sound::SetFrequency(pSoundStream->GetSampleRate());
+    GD_ASSERT(mFMODStream);
+}
+
 void FMODSound::Init()
 {
     Super::Init();
@@ -84,6 +118,9 @@ void FMODSound::Kill()
     
     if(mFMODSample)
 		FSOUND_Sample_Free(mFMODSample);
+
+    if(mFMODStream)
+        FSOUND_Stream_Close(mFMODStream);
 }
 
 Bool FMODSound::Play()
@@ -93,7 +130,7 @@ Bool FMODSound::Play()
     if(mFMODSample)
     {
         // Set the default properties.
-        UChar result = FSOUND_Sample_SetDefaults(mFMODSample, GetFrequency(), 
+        UChar result = FSOUND_Sample_SetDefaults(mFMODSample, Int32(GetFrequency() * SoundSubsystem::Instance()->GetSpeedRatio()), 
                                                               GetVolume(),
                                                               GetPan(),
                                                               GetPriority());
@@ -115,6 +152,28 @@ Bool FMODSound::Play()
         if(!success)
             return false;
     }
+    else if(mFMODStream)
+    {
+        SoundStream* soundStream = Cast<SoundStream>(&GetSoundData());
+        if(soundStream->IsFinished())
+            soundStream->Rewind();
+
+        // Start paused so the channel properties are set before anything is heard.
+        mChannel = FSOUND_Stream_PlayEx(FSOUND_FREE, mFMODStream, 0, TRUE);
+        if(mChannel == -1)  
+            return false;
+
+        FSOUND_SetFrequency(mChannel, Int32(GetFrequency() * SoundSubsystem::Instance()->GetSpeedRatio()));
+        FSOUND_SetVolume(mChannel, GetVolume());
+        FSOUND_SetPan(mChannel, GetPan());
+        FSOUND_SetPriority(mChannel, GetPriority());
+        FSOUND_3D_SetMinMaxDistance(mChannel, GetMinDistance(), GetMaxDistance());
+
+        if(!SetAttributes(GetPosition(), Vector3f(0, 0, 0)) || !SetMute(IsMuted()))
+            return false;
+
+        return FSOUND_SetPaused(mChannel, Sound::IsPaused()) != 0;
+    }
 
     return true;
 }
@@ -123,6 +182,16 @@ Bool FMODSound::Stop()
 {
     Sound::Stop();
 
+    if(mFMODStream)
+    {
+        mChannel = -1;
+        Bool result = FSOUND_Stream_Stop(mFMODStream) != 0;
+
+        // Play() starts over like for samples, pause to resume instead.
+        Cast<SoundStream>(&GetSoundData())->Rewind();
+        return result;
+    }
+
     if(mChannel != -1)
     {
         Int32 channel = mChannel;
@@ -169,6 +238,13 @@ Bool FMODSound::SetMode(eSoundMode pMode)
     if(mFMODSample)
         return FSOUND_Sample_SetMode(mFMODSample, GDToFMODSoundMode[pMode]) != 0;
 
+    // FMOD sees a stream as infinite, looping is done when filling the ring buffer.
+    if(mFMODStream)
+    {
+        Cast<SoundStream>(&GetSoundData())->SetLooping(pMode == kSoundModeLoop);
+        return true;
+    }
+
     return false;
 }
 
@@ -278,6 +354,9 @@ Bool FMODSound::SetMinMaxDistance(Float pMininumDistance, Float pMaximumDistance
 		return result;
     }
 
+    if(mChannel != -1)
+        return FSOUND_3D_SetMinMaxDistance(mChannel, pMininumDistance, pMaximumDistance) != 0;
+
     return false;
 }
 
@@ -35,6 +35,9 @@
 namespace Gamedesk {
 
 
+class SoundStream;
+
+
 class FMODSOUND_API FMODSound : public Sound
 {
     DECLARE_CLASS(FMODSound, Sound);
@@ -262,8 +265,16 @@ public:
     //! Returns the sound's priority.
     virtual Int32 GetPriority() const;
        
+private:
+    //! Size of the FMOD stream buffer, in bytes, filled through the stream callback.
+    static const UInt32 STREAM_BUFFER_SIZE = 16 * 1024;
+
+    //! Play a SoundStream through a FMOD user stream instead of a sample.
+    void CreateStream(SoundStream* pSoundStream, Bool pIs3DSound);
+
 private:
 	FSOUND_SAMPLE*	mFMODSample;
+    FSOUND_STREAM*  mFMODStream;
 	Int32           mChannel;
 };
 
@@ -0,0 +1,340 @@
+/**
+ *  @file       TestCompressedStream.cpp
+ *  @brief      Compressed stream tests.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Stream/CompressedStream.h"
+#include "FileManager/FileManager.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Maths/Maths.h"
+
+using namespace Gamedesk;
+
+
+//! Data looking like serialized objects: class names, names, default values and positions on a grid.
+static void BuildObjectData( UInt32 pSize, Vector<Byte>& pData )
+{
+    static const Char*  CLASS_NAMES[] = { "StaticMesh", "Light", "Trigger", "Character" };
+    static const Float  DEFAULTS[] = { 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+
+    pData.clear();
+    pData.reserve( pSize + 256 );
+
+    UInt32 seed = 12345;
+    for( UInt32 i = 0; pData.size() < pSize; i++ )
+    {
+        seed = seed * 1664525 + 1013904223;
+
+        String name = String(CLASS_NAMES[seed >> 30]) + ToString(i);
+        pData.insert( pData.end(), name.begin(), name.end() + 1 );
+        pData.insert( pData.end(), (const Byte*)&i, (const Byte*)(&i + 1) );
+
+        Float pos[3] = { Float((seed >> 8) & 0xFF) * 4.0f, 0.0f, Float((seed >> 16) & 0xFF) * 4.0f };
+        pData.insert( pData.end(), (const Byte*)pos, (const Byte*)(pos + 3) );
+        pData.insert( pData.end(), (const Byte*)DEFAULTS, (const Byte*)(DEFAULTS + 7) );
+    }
+
+    pData.resize( pSize );
+}
+
+//! Data that doesn't compress.
+static void BuildRandomData( UInt32 pSize, Vector<Byte>& pData )
+{
+    pData.resize( pSize );
+
+    UInt32 seed = 54321;
+    for( UInt32 i = 0; i < pSize; i++ )
+    {
+        seed = seed * 1664525 + 1013904223;
+        pData[i] = Byte(seed >> 24);
+    }
+}
+
+static void ReadWholeFile( const String& pFileName, Vector<Byte>& pData )
+{
+    pData.resize( FileManager::GetFileSize( pFileName ) );
+
+    Stream* stream = FileManager::CreateInputStream( pFileName );
+    if( !pData.empty() )
+        stream->Serialize( &pData[0], pData.size() );
+    GD_DELETE(stream);
+}
+
+
+class UNITTESTS_API CompressedStreamTest : public TestCase
+{
+    DECLARE_CLASS( CompressedStreamTest, TestCase );
+
+public:
+    CompressedStreamTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        Vector<Byte> objectData;
+        Vector<Byte> randomData;
+        BuildObjectData( BLOCK_SIZE * 5 + 123, objectData );
+        BuildRandomData( BLOCK_SIZE * 2 + 7, randomData );
+
+        Vector<Byte> data( objectData );
+        data.insert( data.end(), randomData.begin(), randomData.end() );
+        data.insert( data.end(), objectData.begin(), objectData.begin() + BLOCK_SIZE );
+
+        // Block codec.
+        Vector<Byte> compressed;
+        Vector<Byte> decompressed;
+        compressed.resize( Compression::GetMaxCompressedSize( objectData.size() ) );
+        decompressed.resize( objectData.size() );
+        for( Int32 level = Compression::LEVEL_FAST; level <= Compression::LEVEL_MAX; level += 4 )
+        {
+            UInt32 size = Compression::Compress( Compression::Codec_LZ4, level, &objectData[0], objectData.size(), &compressed[0] );
+            TestAssert( size < objectData.size() / 2 );
+            TestAssert( Compression::Decompress( Compression::Codec_LZ4, &compressed[0], size, &decompressed[0], decompressed.size() ) );
+            TestAssert( decompressed == objectData );
+            TestAssert( !Compression::Decompress( Compression::Codec_LZ4, &compressed[0], size - 1, &decompressed[0], decompressed.size() ) );
+        }
+
+        TestStream( data, Compression::Codec_None, Compression::LEVEL_FAST );
+        TestStream( data, Compression::Codec_LZ4, Compression::LEVEL_FAST );
+        TestStream( data, Compression::Codec_LZ4, 9 );
+
+        // Empty stream.
+        Vector<Byte> empty;
+        TestStream( empty, Compression::Codec_LZ4, Compression::LEVEL_FAST );
+
+        TestCorruption( objectData );
+    }
+
+    virtual void TearDown()
+    {
+        FileManager::DeleteFile( "TestCompressedStream.gdz" );
+    }
+
+private:
+    static const UInt32 BLOCK_SIZE = 4096;
+
+    void TestStream( const Vector<Byte>& pData, Compression::Codec pCodec, Int32 pLevel )
+    {
+        // Write by pieces of various sizes, across block boundaries.
+        Stream* fileStream = FileManager::CreateOutputStream( "TestCompressedStream.gdz" );
+        {
+            CompressedOutputStream stream( *fileStream, pCodec, pLevel, BLOCK_SIZE );
+            for( UInt32 pos = 0, i = 0; pos < pData.size(); i++ )
+            {
+                UInt32 size = Maths::Min( (i * 997) % (BLOCK_SIZE * 3), (UInt32)pData.size() - pos );
+                stream.Serialize( (void*)&pData[pos], size );
+                pos += size;
+            }
+            TestAssert( stream.Pos() == pData.size() );
+        }
+        GD_DELETE(fileStream);
+
+        // Sequential reads from a file, by pieces of other sizes.
+        Vector<Byte> data;
+        data.resize( pData.size() );
+
+        fileStream = FileManager::CreateInputStream( "TestCompressedStream.gdz" );
+        {
+            CompressedInputStream stream( *fileStream );
+            TestAssert( stream.GetCodec() == pCodec );
+            for( UInt32 pos = 0, i = 0; pos < data.size(); i++ )
+            {
+                UInt32 size = Maths::Min( (i * 1499) % (BLOCK_SIZE * 4), (UInt32)data.size() - pos );
+                stream.Serialize( &data[pos], size );
+                pos += size;
+            }
+            TestAssert( stream.Pos() == pData.size() );
+        }
+        GD_DELETE(fileStream);
+        TestAssert( data == pData );
+
+        // Seek in memory.
+        Vector<Byte> file;
+        ReadWholeFile( "TestCompressedStream.gdz", file );
+
+        CompressedInputStream stream( &file[0], file.size() );
+        TestAssert( stream.Size() == pData.size() );
+
+        UInt32 positions[] = { BLOCK_SIZE * 2, 0, BLOCK_SIZE + 100, (UInt32)pData.size() / 2, BLOCK_SIZE - 1 };
+        for( UInt32 i = 0; i < sizeof(positions) / sizeof(positions[0]); i++ )
+        {
+            UInt32 pos = Maths::Min( positions[i], (UInt32)pData.size() );
+            UInt32 size = Maths::Min( BLOCK_SIZE * 2, (UInt32)pData.size() - pos );
+            
+            TestAssert( stream.Seek( pos ) );
+            if( size )
+            {
+                stream.Serialize( &data[0], size );
+                TestAssert( memcmp( &data[0], &pData[pos], size ) == 0 );
+            }
+            TestAssert( stream.Pos() == pos + size );
+        }
+
+        TestAssert( stream.Seek( pData.size() ) );
+        TestAssert( !stream.Seek( pData.size() + 1 ) );
+    }
+
+    void TestCorruption( const Vector<Byte>& pData )
+    {
+        // The first frame follows the 16 bytes header, its stored size comes first.
+        const UInt32 FIRST_FRAME = 16;
+
+        Stream* fileStream = FileManager::CreateOutputStream( "TestCompressedStream.gdz" );
+        {
+            CompressedOutputStream stream( *fileStream, Compression::Codec_LZ4, Compression::LEVEL_FAST, BLOCK_SIZE );
+            stream.Serialize( (void*)&pData[0], pData.size() );
+        }
+        GD_DELETE(fileStream);
+
+        Vector<Byte> file;
+        ReadWholeFile( "TestCompressedStream.gdz", file );
+
+        UInt32 storedSize;
+        memcpy( &storedSize, &file[FIRST_FRAME], sizeof(storedSize) );
+        TestAssert( storedSize < BLOCK_SIZE );
+
+        Vector<Byte> data;
+        data.resize( BLOCK_SIZE );
+
+        // Truncated header.
+        {
+            CompressedInputStream stream( &file[0], 10 );
+            TestAssert( !stream.IsValid() );
+            TestAssert( stream.Size() == 0 );
+        }
+
+        // Frame larger than a block, from memory and from a file.
+        Vector<Byte> corrupted( file );
+        UInt32 invalidSize = 0x7FFFFFFF;
+        memcpy( &corrupted[FIRST_FRAME], &invalidSize, sizeof(invalidSize) );
+        {
+            CompressedInputStream stream( &corrupted[0], corrupted.size() );
+            TestAssert( stream.IsValid() );
+            stream.Serialize( &data[0], data.size() );
+            TestAssert( !stream.IsValid() );
+            TestAssert( data[0] == 0 && data[BLOCK_SIZE - 1] == 0 );
+            TestAssert( !stream.Seek( 0 ) );
+        }
+
+        fileStream = FileManager::CreateOutputStream( "TestCompressedStream.gdz" );
+        fileStream->Serialize( &corrupted[0], corrupted.size() );
+        GD_DELETE(fileStream);
+
+        fileStream = FileManager::CreateInputStream( "TestCompressedStream.gdz" );
+        {
+            CompressedInputStream stream( *fileStream );
+            TestAssert( stream.IsValid() );
+            stream.Serialize( &data[0], data.size() );
+            TestAssert( !stream.IsValid() );
+        }
+        GD_DELETE(fileStream);
+
+        // Block data that doesn't decompress.
+        {
+            UInt32 shortSize = storedSize - 1;
+            corrupted = file;
+            memcpy( &corrupted[FIRST_FRAME], &shortSize, sizeof(shortSize) );
+
+            CompressedInputStream stream( &corrupted[0], corrupted.size() );
+            stream.Serialize( &data[0], data.size() );
+            TestAssert( !stream.IsValid() );
+        }
+    }
+};
+
+IMPLEMENT_CLASS( CompressedStreamTest );
+
+
+class UNITTESTS_API CompressedStreamBenchmark : public TestCase
+{
+    DECLARE_CLASS( CompressedStreamBenchmark, TestCase );
+
+public:
+    CompressedStreamBenchmark()
+    {
+    }
+
+    virtual void Run()
+    {
+        const UInt32 DATA_SIZE = 32 * 1024 * 1024;
+
+        Vector<Byte> data;
+        BuildObjectData( DATA_SIZE, data );
+
+        Benchmark( data, Compression::Codec_None, 0 );
+        Benchmark( data, Compression::Codec_LZ4, Compression::LEVEL_FAST );
+        Benchmark( data, Compression::Codec_LZ4, 4 );
+        Benchmark( data, Compression::Codec_LZ4, 9 );
+    }
+
+    virtual void TearDown()
+    {
+        FileManager::DeleteFile( "BenchCompressedStream.gdz" );
+    }
+
+private:
+    void Benchmark( const Vector<Byte>& pData, Compression::Codec pCodec, Int32 pLevel )
+    {
+        UInt64 start = SystemInfo::Instance()->GetMicroSec64();
+        Stream* fileStream = FileManager::CreateOutputStream( "BenchCompressedStream.gdz" );
+        if( pCodec == Compression::Codec_None )
+        {
+            fileStream->Serialize( (void*)&pData[0], pData.size() );
+        }
+        else
+        {
+            CompressedOutputStream stream( *fileStream, pCodec, pLevel );
+            stream.Serialize( (void*)&pData[0], pData.size() );
+        }
+        GD_DELETE(fileStream);
+        UInt64 saveTime = SystemInfo::Instance()->GetMicroSec64() - start;
+
+        // Load as a package does: read the whole file, decompress in memory.
+        Vector<Byte> data;
+        start = SystemInfo::Instance()->GetMicroSec64();
+        ReadWholeFile( "BenchCompressedStream.gdz", data );
+        UInt32 fileSize = data.size();
+        if( pCodec != Compression::Codec_None )
+        {
+            CompressedInputStream stream( &data[0], data.size() );
+            Vector<Byte> decompressed;
+            decompressed.resize( stream.Size() );
+            stream.Serialize( &decompressed[0], decompressed.size() );
+            data.swap( decompressed );
+        }
+        UInt64 loadTime = SystemInfo::Instance()->GetMicroSec64() - start;
+
+        TestAssert( data == pData );
+
+        Core::DebugOut( "CompressedStreamBenchmark: codec %d level %2d, ratio %5.3f, save %8.1f ms, load %8.1f ms\n",
+                        pCodec, pLevel,
+                        Double(fileSize) / pData.size(),
+                        Double(saveTime) / 1000.0,
+                        Double(loadTime) / 1000.0 );
+    }
+};
+
+IMPLEMENT_CLASS( CompressedStreamBenchmark );
@@ -30,6 +30,8 @@
 #include "Config/ConfigFile.h"
 #include "FileManager/FileManager.h"
 
+using namespace Gamedesk;
+
 
 class UNITTESTS_API ConfigFileTest : public TestCase
 {
@@ -78,6 +80,7 @@ public:
     virtual void TearDown()
     {
         FileManager::DeleteFile( "config/TestConfigFile.ini" );
+        FileManager::DeleteFile( "config/TestConfigFile.ini.cache" );
     }
 
 private:
@@ -89,3 +92,99 @@ private:
 };
 
 IMPLEMENT_CLASS( ConfigFileTest );
+
+
+class UNITTESTS_API ConfigFileCacheTest : public TestCase
+{
+    DECLARE_CLASS( ConfigFileCacheTest, TestCase );
+
+public:
+    ConfigFileCacheTest()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        ConfigFile configSave( "TestConfigCache.ini" );
+
+        configSave["General"]["ShowDialog"] = true;
+        configSave["General"]["Workers"   ] = Int32(-1);
+        configSave["General"]["Scale"     ] = 0.5f;
+        configSave["Graphic"]["Current"   ] = String("None");
+        configSave["Graphic"]["PluginDir" ] = String("Plugins/Graphic/");
+
+        configSave.Save();
+    }
+
+    virtual void Run()
+    {
+        // First load parses the text and compiles the cache.
+        ConfigFile configText( "TestConfigCache.ini" );
+        configText.Load();
+        TestAssert( !configText.IsLoadedFromCache() );
+        TestAssert( FileManager::FileExist( configText.GetCacheFileName() ) );
+
+        // Values are typed when they are read.
+        TestAssert( configText["General"]["ShowDialog"].IsOfType( Variant::Variant_Bool ) );
+        TestAssert( configText["General"]["Workers"   ].IsOfType( Variant::Variant_Int ) );
+        TestAssert( configText["General"]["Scale"     ].IsOfType( Variant::Variant_Float ) );
+        TestAssert( configText["Graphic"]["Current"   ].IsOfType( Variant::Variant_String ) );
+
+        // Keys resolved before the load see the loaded values.
+        ConfigFile configCache( "TestConfigCache.ini" );
+        ConfigFile::Key workers = configCache.GetKey( "General", "Workers", Int32(4) );
+        ConfigFile::Key missing = configCache.GetKey( "General", "Missing", Int32(4) );
+        configCache.Load();
+        TestAssert( configCache.IsLoadedFromCache() );
+
+        TestAssert( ((Int32) configCache.Get( workers )) == -1 );
+        TestAssert( ((Int32) configCache.Get( missing )) == 4 );
+        TestAssert( ((Bool)  configCache["General"]["ShowDialog"]) == true );
+        TestAssert( ((Float) configCache["General"]["Scale"     ]) == 0.5f );
+        TestAssert( ((String)configCache["Graphic"]["Current"   ]) == "None" );
+        TestAssert( ((String)configCache["Graphic"]["PluginDir" ]) == "Plugins/Graphic/" );
+
+        // Float values convert to the other types.
+        TestAssert( ((Int32) configCache["General"]["Scale"]) == 0 );
+        TestAssert( ((Bool)  configCache["General"]["Scale"]) == true );
+
+        // A cache with an offset out of the string table is ignored, the text is parsed again.
+        CorruptCache( configCache.GetCacheFileName() );
+
+        ConfigFile configCorrupted( "TestConfigCache.ini" );
+        configCorrupted.Load();
+        TestAssert( !configCorrupted.IsLoadedFromCache() );
+        TestAssert( ((Int32) configCorrupted["General"]["Workers"]) == -1 );
+
+        // A modified text file doesn't match the cache anymore.
+        configCache["Graphic"]["Current"] = String("OpenGLGraphicSubsystem");
+        configCache.Save();
+
+        ConfigFile configModified( "TestConfigCache.ini" );
+        configModified.Load();
+        TestAssert( !configModified.IsLoadedFromCache() );
+        TestAssert( ((String)configModified["Graphic"]["Current"]) == "OpenGLGraphicSubsystem" );
+    }
+
+    virtual void TearDown()
+    {
+        FileManager::DeleteFile( "config/TestConfigCache.ini" );
+        FileManager::DeleteFile( "config/TestConfigCache.ini.cache" );
+    }
+
+private:
+    //! Point the name of the first section past the end of the cache.
+    void CorruptCache( const String& pCacheFileName )
+    {
+        // The sections follow the 36 bytes header, their name comes first.
+        const UInt32 FIRST_SECTION_NAME = 36;
+        const UInt32 INVALID_OFFSET = 0x7FFFFFFF;
+
+        FILE* file = fopen( pCacheFileName.c_str(), "r+b" );
+        fseek( file, FIRST_SECTION_NAME, SEEK_SET );
+        fwrite( &INVALID_OFFSET, sizeof(INVALID_OFFSET), 1, file );
+        fclose( file );
+    }
+};
+
+IMPLEMENT_CLASS( ConfigFileCacheTest );
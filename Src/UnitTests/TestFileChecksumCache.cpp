@@ -0,0 +1,124 @@
+/**
+ *  @file       TestFileChecksumCache.cpp
+ *  @brief      Tests for the file checksum cache.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "FileManager/FileChecksumCache.h"
+#include "FileManager/FileManager.h"
+
+using namespace Gamedesk;
+
+
+class UNITTESTS_API FileChecksumCacheTest : public TestCase
+{
+    DECLARE_CLASS( FileChecksumCacheTest, TestCase );
+
+public:
+    FileChecksumCacheTest()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        for( UInt32 i = 0; i < NB_FILES; i++ )
+            WriteFile( i, i * 1000 );
+    }
+
+    virtual void Run()
+    {
+        // Reference values.
+        const Byte* abc = (const Byte*)"abc";
+        TestAssert( FileChecksumCache::ComputeChecksum( abc, 3, FileChecksum::Algorithm_MD5 ).GetMD5() == MD5Checksum::Value( 0x98500190, 0xb04fd23c, 0x7d3f96d6, 0x727fe128 ) );
+        TestAssert( XXHashChecksum::Compute( abc, 3 ) == 0x44bc2cf5ad770999ULL );
+        TestAssert( XXHashChecksum::Compute( NULL, 0 ) == 0xef46db3751d8e999ULL );
+        TestAssert( FileChecksumCache::ComputeChecksum( abc, 3, FileChecksum::Algorithm_XXHash ).GetXXHash() == 0x44bc2cf5ad770999ULL );
+
+        // Checksums of different algorithms never match.
+        TestAssert( FileChecksum( MD5Checksum::Value( 0, 0, 0, 0 ) ) != FileChecksum( XXHashChecksum::Value( 0 ) ) );
+        TestAssert( FileChecksum( XXHashChecksum::Value( 0 ) ) != FileChecksum() );
+
+        Vector<String> fileNames;
+        for( UInt32 i = 0; i < NB_FILES; i++ )
+            fileNames.push_back( GetFileName(i) );
+        fileNames.push_back( GetFileName(0) );
+        fileNames.push_back( "TestChecksumMissing.bin" );
+
+        // Every file is hashed once, in parallel.
+        FileChecksumCache cache( FileChecksum::Algorithm_XXHash );
+        Vector<FileChecksum> checksums;
+        cache.GetChecksums( fileNames, checksums );
+        TestAssert( cache.GetNbHashedFiles() == NB_FILES );
+        TestAssert( checksums[0] == checksums[NB_FILES] );
+        TestAssert( checksums[NB_FILES + 1].GetAlgorithm() == FileChecksum::Algorithm_None );
+        for( UInt32 i = 0; i < NB_FILES; i++ )
+            TestAssert( checksums[i] == FileChecksumCache::ComputeChecksum( fileNames[i], FileChecksum::Algorithm_XXHash ) );
+
+        // Reloaded cache, nothing changed: nothing is read.
+        cache.Save( "TestChecksums.cache" );
+
+        FileChecksumCache reloaded( FileChecksum::Algorithm_XXHash );
+        reloaded.Load( "TestChecksums.cache" );
+        Vector<FileChecksum> cachedChecksums;
+        reloaded.GetChecksums( fileNames, cachedChecksums );
+        TestAssert( reloaded.GetNbHashedFiles() == 0 );
+        TestAssert( cachedChecksums == checksums );
+
+        // A cache saved with another algorithm is ignored.
+        FileChecksumCache md5( FileChecksum::Algorithm_MD5 );
+        md5.Load( "TestChecksums.cache" );
+        TestAssert( md5.GetChecksum( fileNames[1] ).GetAlgorithm() == FileChecksum::Algorithm_MD5 );
+        TestAssert( md5.GetNbHashedFiles() == 1 );
+
+        // Only the modified file is hashed again.
+        WriteFile( 1, 1001 );
+        TestAssert( reloaded.GetChecksum( fileNames[1] ) != checksums[1] );
+        TestAssert( reloaded.GetNbHashedFiles() == 1 );
+    }
+
+    virtual void TearDown()
+    {
+        for( UInt32 i = 0; i < NB_FILES; i++ )
+            FileManager::DeleteFile( GetFileName(i) );
+        FileManager::DeleteFile( "TestChecksums.cache" );
+    }
+
+private:
+    static const UInt32 NB_FILES = 8;
+
+    String GetFileName( UInt32 pIndex ) const
+    {
+        return String("TestChecksum") + ToString(pIndex) + String(".bin");
+    }
+
+    void WriteFile( UInt32 pIndex, UInt32 pSize )
+    {
+        FILE* file = fopen( GetFileName(pIndex).c_str(), "wb" );
+        for( UInt32 i = 0; i < pSize; i++ )
+            fputc( (pIndex * 31 + i * 7) & 0xFF, file );
+        fclose( file );
+    }
+};
+
+IMPLEMENT_CLASS( FileChecksumCacheTest );
@@ -0,0 +1,496 @@
+/**
+ *  @file       TestImage.cpp
+ *  @brief      Tests and benchmarks for the Image pixel operations.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Graphic/Image/Image.h"
+#include "Graphic/Image/DXTCodec.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Maths/Maths.h"
+
+using namespace Gamedesk;
+
+
+// Scalar implementations the Image operations used to have, kept as a
+// reference for the results and the timings.
+namespace ImageReference
+{
+    void ChangeGamma( Byte* pData, UInt32 pNumPixels, UInt32 pNumComponents, UInt32 pNumColors, Float pGamma )
+    {
+        Float components[4];
+
+        for( UInt32 i = 0; i < pNumPixels; i++, pData += pNumComponents )
+        {
+            Float scale = 1.0f;
+            Float temp  = 0.0f;
+
+            for( UInt32 j = 0; j < pNumColors; j++ )
+            {
+                components[j] = (Float)pData[j] * pGamma;
+
+                if( components[j] > 255.0f && (temp = (255.0f/components[j])) < scale )
+                    scale = temp;
+            }
+
+            for( UInt32 j = 0; j < pNumColors; j++ )
+                pData[j] = (Byte)(components[j] * scale);
+        }
+    }
+
+    void ToGrayscale( const Byte* pSrc, Byte* pDest, UInt32 pNumPixels, UInt32 pNumChannels )
+    {
+        for( UInt32 i = 0; i < pNumPixels; i++, pSrc += pNumChannels )
+            *pDest++ = (77 * pSrc[0] + 151 * pSrc[1] + 28 * pSrc[2] + 128) >> 8;
+    }
+
+    void ToNormalMap( const Byte* pSrc, Byte* pDest, UInt32 pWidth, UInt32 pHeight )
+    {
+        for( UInt32 y = 0; y < pHeight; y++ )
+        {
+            const Byte* row0 = pSrc + ((y + pHeight - 1) % pHeight) * pWidth;
+            const Byte* row1 = pSrc + y * pWidth;
+            const Byte* row2 = pSrc + ((y + 1) % pHeight) * pWidth;
+
+            for( UInt32 x = 0; x < pWidth; x++, pDest += 3 )
+            {
+                UInt32 predx = x == 0 ? pWidth - 1 : x - 1;
+                UInt32 succx = x + 1 == pWidth ? 0 : x + 1;
+
+                UInt32 sx = (row0[predx] + 2 * row1[predx] + row2[predx]) - (row0[succx] + 2 * row1[succx] + row2[succx]);
+                UInt32 sy = (row0[predx] + 2 * row0[x]     + row0[succx]) - (row2[predx] + 2 * row2[x]     + row2[succx]);
+
+                UInt32 len = UInt32(0x000FF000 * Maths::FastRSqrt(Float(sx * sx + sy * sy + 256*256)));
+                sx *= len;
+                sy *= len;
+
+                pDest[0] = ((sx  + 0x000FF000) >> 13);
+                pDest[1] = ((sy  + 0x000FF000) >> 13);
+                pDest[2] = ((len + 0x00000FF0) >> 5);
+            }
+        }
+    }
+
+    void FlipY( Byte* pData, UInt32 pLineSize, UInt32 pHeight )
+    {
+        Vector<Byte> swapTmp;
+        swapTmp.resize( pLineSize );
+
+        Byte* top    = pData;
+        Byte* bottom = pData + (pHeight - 1) * pLineSize;
+
+        for( UInt32 i = 0; i < (pHeight >> 1); i++, top += pLineSize, bottom -= pLineSize )
+        {
+            memcpy( &swapTmp[0], bottom, pLineSize );
+            memcpy( bottom, top, pLineSize );
+            memcpy( top, &swapTmp[0], pLineSize );
+        }
+    }
+
+    void FillRandom( Image& pImage )
+    {
+        UInt32 seed = 12345;
+        Byte*  data = pImage.GetData();
+
+        for( UInt32 i = 0; i < pImage.GetDataSize(); i++ )
+        {
+            seed = seed * 1664525 + 1013904223;
+            data[i] = (Byte)(seed >> 24);
+        }
+    }
+
+    //! Returns true if both buffers differ by at most pTolerance on every byte.
+    Bool Compare( const Byte* pFirst, const Byte* pSecond, UInt32 pSize, Int32 pTolerance )
+    {
+        for( UInt32 i = 0; i < pSize; i++ )
+        {
+            if( Maths::Abs( Int32(pFirst[i]) - Int32(pSecond[i]) ) > pTolerance )
+                return false;
+        }
+
+        return true;
+    }
+}
+
+
+class UNITTESTS_API ImageProcessingTest : public TestCase
+{
+    DECLARE_CLASS( ImageProcessingTest, TestCase );
+
+public:
+    ImageProcessingTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        // Odd sizes so the SIMD loops have leftovers.
+        const UInt32 width  = 67;
+        const UInt32 height = 33;
+
+        Image source;
+        source.Create( width, height, Image::Format_R8G8B8A8 );
+        ImageReference::FillRandom( source );
+
+        // Gamma, the reference truncates floats so it can be one below.
+        Image gamma( source );
+        Image gammaRef( source );
+        gamma.ChangeGamma( 1.7f );
+        ImageReference::ChangeGamma( gammaRef.GetData(), width * height, 4, 3, 1.7f );
+        TestAssert( ImageReference::Compare( gamma.GetData(), gammaRef.GetData(), gamma.GetDataSize(), 1 ) );
+
+        // Grayscale
+        Image gray( source );
+        Vector<Byte> grayRef;
+        grayRef.resize( width * height );
+        gray.ToGrayscale();
+        ImageReference::ToGrayscale( source.GetData(), &grayRef[0], width * height, 4 );
+        TestAssert( gray.GetFormat() == Image::Format_L8 );
+        TestAssert( gray.GetDataSize() == width * height );
+        TestAssert( ImageReference::Compare( gray.GetData(), &grayRef[0], width * height, 0 ) );
+
+        // Normal map, the reference uses an approximated reciprocal square root.
+        Image normalMap( gray );
+        Vector<Byte> normalMapRef;
+        normalMapRef.resize( width * height * 3 );
+        normalMap.ToNormalMap();
+        ImageReference::ToNormalMap( gray.GetData(), &normalMapRef[0], width, height );
+        TestAssert( normalMap.GetFormat() == Image::Format_R8G8B8 );
+        TestAssert( ImageReference::Compare( normalMap.GetData(), &normalMapRef[0], normalMap.GetDataSize(), 1 ) );
+
+        // Flip
+        Image flipped( source );
+        Image flippedRef( source );
+        flipped.FlipY();
+        ImageReference::FlipY( flippedRef.GetData(), width * 4, height );
+        TestAssert( ImageReference::Compare( flipped.GetData(), flippedRef.GetData(), flipped.GetDataSize(), 0 ) );
+    }
+};
+
+IMPLEMENT_CLASS( ImageProcessingTest );
+
+
+class UNITTESTS_API ImageMipmapTest : public TestCase
+{
+    DECLARE_CLASS( ImageMipmapTest, TestCase );
+
+public:
+    ImageMipmapTest()
+    {
+    }
+
+    //! Returns true if every pixel of every level is pValue.
+    Bool IsUniform( const Image& pImage, Byte pValue )
+    {
+        for( UInt32 i = 0; i < pImage.GetDataSize(); i++ )
+        {
+            if( pImage.GetData()[i] != pValue )
+                return false;
+        }
+
+        return true;
+    }
+
+    virtual void Run()
+    {
+        const Image::MipmapFilter filters[] = { Image::MipmapFilter_Box, Image::MipmapFilter_Kaiser, Image::MipmapFilter_Lanczos };
+
+        for( UInt32 i = 0; i < 3; i++ )
+        {
+            // Normalized filters keep a uniform image uniform, odd sizes included.
+            Image image;
+            image.Create( 37, 16, Image::Format_R8G8B8A8 );
+            memset( image.GetData(), 100, image.GetDataSize() );
+            image.GenerateMipmaps( filters[i], true );
+
+            TestAssert( image.GetNumMipmaps() == Image::GetMaxNumMipmaps( 37, 16 ) );
+            TestAssert( image.GetDataSize() == Image::GetSizeWithMipmaps( Image::Format_R8G8B8A8, 37, 16 ) );
+            TestAssert( IsUniform( image, 100 ) );
+
+            Image volume;
+            volume.Create( 8, 8, Image::Format_L8, 1, 8 );
+            memset( volume.GetData(), 42, volume.GetDataSize() );
+            volume.GenerateMipmaps( filters[i] );
+
+            TestAssert( volume.GetNumMipmaps() == 4 );
+            TestAssert( IsUniform( volume, 42 ) );
+
+            // The depth halves after the width and height reached 1.
+            Image deepVolume;
+            deepVolume.Create( 4, 4, Image::Format_L8, 1, 16 );
+            memset( deepVolume.GetData(), 42, deepVolume.GetDataSize() );
+            deepVolume.GenerateMipmaps( filters[i] );
+
+            TestAssert( deepVolume.GetNumMipmaps() == Image::GetMaxNumMipmaps( 4, 4, 16 ) );
+            TestAssert( deepVolume.GetNumMipmaps() == 5 );
+            TestAssert( deepVolume.GetDataSize() == Image::GetSizeWithMipmaps( Image::Format_L8, 4, 4, 16 ) );
+            TestAssert( IsUniform( deepVolume, 42 ) );
+        }
+
+        // Black and white columns average to 50% intensity, which is 188 in sRGB.
+        Image checker;
+        checker.Create( 2, 2, Image::Format_L8A8 );
+        Byte pixels[] = { 0, 255, 255, 255, 0, 255, 255, 255 };
+        memcpy( checker.GetData(), pixels, sizeof(pixels) );
+
+        Image linear( checker );
+        linear.GenerateMipmaps( Image::MipmapFilter_Box, false );
+        TestAssert( linear.GetData()[8] == 128 && linear.GetData()[9] == 255 );
+
+        checker.GenerateMipmaps( Image::MipmapFilter_Box, true );
+        TestAssert( checker.GetData()[8] == 188 && checker.GetData()[9] == 255 );
+    }
+};
+
+IMPLEMENT_CLASS( ImageMipmapTest );
+
+
+class UNITTESTS_API DXTCodecTest : public TestCase
+{
+    DECLARE_CLASS( DXTCodecTest, TestCase );
+
+public:
+    DXTCodecTest()
+    {
+    }
+
+    //! Root mean square error of the color channels of two RGBA images.
+    Double ColorError( const Image& pImageA, const Image& pImageB )
+    {
+        Double error     = 0.0;
+        UInt32 numPixels = pImageA.GetWidth() * pImageA.GetHeight();
+
+        for( UInt32 i = 0; i < numPixels * 4; i++ )
+        {
+            if( (i & 3) == 3 )
+                continue;
+
+            Double diff = pImageA.GetData()[i] - pImageB.GetData()[i];
+            error += diff * diff;
+        }
+
+        return sqrt( error / (numPixels * 3) );
+    }
+
+    virtual void Run()
+    {
+        // Red and blue endpoints, indices 0, 1, 2 and 3 on each row.
+        Byte block[8] = { 0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 };
+        Byte pixels[16 * 4];
+        DXTCodec::DecompressBlock( block, Image::Format_DXT1, pixels );
+
+        TestAssert( pixels[0]  == 255 && pixels[1]  == 0 && pixels[2]  == 0   );
+        TestAssert( pixels[4]  == 0   && pixels[5]  == 0 && pixels[6]  == 255 );
+        TestAssert( pixels[8]  == 170 && pixels[9]  == 0 && pixels[10] == 85  );
+        TestAssert( pixels[12] == 85  && pixels[13] == 0 && pixels[14] == 170 );
+
+        // Smooth colors with some noise, opaque.
+        Image source;
+        source.Create( 64, 64, Image::Format_R8G8B8A8 );
+        for( UInt32 y = 0; y < 64; y++ )
+        {
+            for( UInt32 x = 0; x < 64; x++ )
+            {
+                Byte* pixel = source.GetData() + (y * 64 + x) * 4;
+                pixel[0] = (Byte)(x * 4);
+                pixel[1] = (Byte)(y * 3 + (x * 7 + y * 13) % 23);
+                pixel[2] = (Byte)(255 - x * 2 - y);
+                pixel[3] = 255;
+            }
+        }
+
+        const Image::Format formats[] = { Image::Format_DXT1, Image::Format_DXT3, Image::Format_DXT5 };
+
+        for( UInt32 i = 0; i < 3; i++ )
+        {
+            Image fast( source );
+            fast.Compress( formats[i] );
+            TestAssert( fast.GetFormat() == formats[i] );
+            TestAssert( fast.GetDataSize() == Image::GetSizeWithMipmaps( formats[i], 64, 64, 1, 1 ) );
+
+            Image high( source );
+            high.Compress( formats[i], true );
+
+            fast.Decompress();
+            high.Decompress();
+
+            // The cluster fit is never worse, per block, than the range fit.
+            Double fastError = ColorError( source, fast );
+            Double highError = ColorError( source, high );
+            TestAssert( fastError < 8.0 );
+            TestAssert( highError <= fastError );
+        }
+
+        // DXT1 keeps the transparent pixels, DXT5 an alpha gradient.
+        Byte alphaPixels[16 * 4];
+        for( UInt32 i = 0; i < 16; i++ )
+        {
+            alphaPixels[i * 4 + 0] = (Byte)(i * 16);
+            alphaPixels[i * 4 + 1] = 50;
+            alphaPixels[i * 4 + 2] = 200;
+            alphaPixels[i * 4 + 3] = (i & 1) ? 255 : (Byte)(i * 8);
+        }
+
+        Byte alphaBlock[16];
+        DXTCodec::CompressBlock( alphaPixels, Image::Format_DXT1, DXTCodec::Quality_Fast, alphaBlock );
+        DXTCodec::DecompressBlock( alphaBlock, Image::Format_DXT1, pixels );
+        for( UInt32 i = 0; i < 16; i++ )
+            TestAssert( pixels[i * 4 + 3] == ((i & 1) ? 255 : 0) );
+
+        DXTCodec::CompressBlock( alphaPixels, Image::Format_DXT5, DXTCodec::Quality_Fast, alphaBlock );
+        DXTCodec::DecompressBlock( alphaBlock, Image::Format_DXT5, pixels );
+        for( UInt32 i = 0; i < 16; i++ )
+            TestAssert( Maths::Abs( Int32(pixels[i * 4 + 3]) - alphaPixels[i * 4 + 3] ) <= 9 );
+
+        // Sizes that are not a multiple of 4, with mipmaps.
+        Image uniform;
+        uniform.Create( 13, 7, Image::Format_B8G8R8A8, 4 );
+        memset( uniform.GetData(), 77, uniform.GetDataSize() );
+        uniform.Compress( Image::Format_DXT5 );
+        TestAssert( uniform.GetDataSize() == Image::GetSizeWithMipmaps( Image::Format_DXT5, 13, 7, 1, 4 ) );
+
+        uniform.Decompress();
+        TestAssert( uniform.GetNumMipmaps() == 4 );
+        for( UInt32 i = 0; i < uniform.GetDataSize(); i++ )
+            TestAssert( Maths::Abs( Int32(uniform.GetData()[i]) - 77 ) <= 4 );
+
+        // Gamma of an opaque compressed image, the alpha doesn't keep the colors from changing.
+        Image opaque;
+        opaque.Create( 8, 8, Image::Format_R8G8B8A8 );
+        for( UInt32 i = 0; i < 64; i++ )
+        {
+            Byte* pixel = opaque.GetData() + i * 4;
+            pixel[0] = pixel[1] = pixel[2] = 100;
+            pixel[3] = 255;
+        }
+        opaque.Compress( Image::Format_DXT5 );
+        opaque.ChangeGamma( 1.5f );
+        TestAssert( opaque.GetFormat() == Image::Format_DXT5 );
+
+        opaque.Decompress();
+        for( UInt32 i = 0; i < 64; i++ )
+        {
+            const Byte* pixel = opaque.GetData() + i * 4;
+            TestAssert( Maths::Abs( Int32(pixel[0]) - 150 ) <= 4 );
+            TestAssert( pixel[3] == 255 );
+        }
+    }
+};
+
+IMPLEMENT_CLASS( DXTCodecTest );
+
+
+/**
+ *  Time the Image operations against the reference implementations on a 4k
+ *  texture. Results are sent to the debug output.
+ */
+class UNITTESTS_API ImageBenchmark : public TestCase
+{
+    DECLARE_CLASS( ImageBenchmark, TestCase );
+
+public:
+    ImageBenchmark()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mSource.Create( SIZE, SIZE, Image::Format_R8G8B8A8 );
+        ImageReference::FillRandom( mSource );
+    }
+
+    virtual void Run()
+    {
+        UInt64 start;
+        Image  work;
+        Vector<Byte> output;
+
+        Core::DebugOut( "Image benchmark, %dx%d RGBA8, time in ms (reference / new)\n", SIZE, SIZE );
+
+        // Gamma
+        work = mSource;
+        start = GetTime();
+        ImageReference::ChangeGamma( work.GetData(), SIZE * SIZE, 4, 3, 1.5f );
+        UInt64 gammaRef = GetTime() - start;
+
+        work = mSource;
+        start = GetTime();
+        work.ChangeGamma( 1.5f );
+        Report( "ChangeGamma", gammaRef, GetTime() - start );
+
+        // Grayscale
+        output.resize( SIZE * SIZE );
+        start = GetTime();
+        ImageReference::ToGrayscale( mSource.GetData(), &output[0], SIZE * SIZE, 4 );
+        UInt64 grayscaleRef = GetTime() - start;
+
+        work = mSource;
+        start = GetTime();
+        work.ToGrayscale();
+        Report( "ToGrayscale", grayscaleRef, GetTime() - start );
+
+        // Normal map, from the grayscale image.
+        Image heightMap( work );
+        output.resize( SIZE * SIZE * 3 );
+        start = GetTime();
+        ImageReference::ToNormalMap( heightMap.GetData(), &output[0], SIZE, SIZE );
+        UInt64 normalMapRef = GetTime() - start;
+
+        start = GetTime();
+        work.ToNormalMap();
+        Report( "ToNormalMap", normalMapRef, GetTime() - start );
+
+        // Flip
+        work = mSource;
+        start = GetTime();
+        ImageReference::FlipY( work.GetData(), SIZE * 4, SIZE );
+        UInt64 flipRef = GetTime() - start;
+
+        start = GetTime();
+        work.FlipY();
+        Report( "FlipY", flipRef, GetTime() - start );
+
+        // Flipped twice.
+        TestAssert( ImageReference::Compare( work.GetData(), mSource.GetData(), work.GetDataSize(), 0 ) );
+    }
+
+private:
+    static UInt64 GetTime()
+    {
+        return SystemInfo::Instance()->GetMicroSec64();
+    }
+
+    static void Report( const Char* pName, UInt64 pReference, UInt64 pNew )
+    {
+        Core::DebugOut( "  %-12s %8.2f / %8.2f  (x%.1f)\n", pName, pReference / 1000.0, pNew / 1000.0,
+                        pNew ? Double(pReference) / Double(pNew) : 0.0 );
+    }
+
+private:
+    static const UInt32 SIZE = 4096;
+
+    Image   mSource;
+};
+
+IMPLEMENT_CLASS( ImageBenchmark );
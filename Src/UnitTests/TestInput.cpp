@@ -0,0 +1,216 @@
+/**
+ *  @file       TestInput.cpp
+ *  @brief      Tests for the input event queue and dispatch.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Input/InputEventQueue.h"
+#include "Input/InputSubsystem.h"
+#include "Thread/Thread.h"
+
+using namespace Gamedesk;
+
+
+class UNITTESTS_API InputEventTest : public TestCase
+{
+    DECLARE_CLASS( InputEventTest, TestCase );
+
+public:
+    InputEventTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        const UInt32 NB_EVENTS = 100000;
+
+        InputEventQueue* queue = GD_NEW(InputEventQueue, 0, "InputEventQueue");
+        ProducerThread producer( *queue, NB_EVENTS );
+        producer.Start();
+
+        // Events come out in order, none is lost.
+        InputEvent event;
+        UInt32 nbEvents = 0;
+        Bool inOrder = true;
+        while( nbEvents < NB_EVENTS )
+        {
+            if( queue->Pop( event ) )
+                inOrder &= event.mCode == nbEvents++ && event.mTime == event.mCode;
+            else
+                Thread::Sleep(0);
+        }
+
+        producer.WaitUntilStopped();
+        TestAssert( inOrder );
+        TestAssert( !queue->Pop( event ) );
+        TestAssert( queue->GetNbDroppedEvents() == producer.mNbFull );
+
+        GD_DELETE(queue);
+    }
+
+private:
+    //! Push numbered events, waiting when the queue is full.
+    class ProducerThread : public Thread
+    {
+    public:
+        ProducerThread( InputEventQueue& pQueue, UInt32 pNbEvents ) : mQueue(pQueue), mNbEvents(pNbEvents), mNbFull(0)
+        {
+        }
+
+        virtual void Run()
+        {
+            InputEvent event;
+            event.mType = InputEvent::Type_Key;
+            event.mValue = 1;
+
+            for( UInt32 i = 0; i < mNbEvents; i++ )
+            {
+                event.mCode = i;
+                event.mTime = i;
+                while( !mQueue.Push( event ) )
+                {
+                    mNbFull++;
+                    Thread::Sleep(0);
+                }
+            }
+        }
+
+        InputEventQueue&    mQueue;
+        UInt32              mNbEvents;
+        UInt32              mNbFull;
+    };
+};
+
+IMPLEMENT_CLASS(InputEventTest);
+
+
+class UNITTESTS_API InputSubsystemTest : public TestCase
+{
+    DECLARE_CLASS( InputSubsystemTest, TestCase );
+
+public:
+    InputSubsystemTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        TestInputSubsystem input;
+        const Keyboard& keyboard = input.mKeyboard;
+        const Mouse& mouse = input.mMouse;
+
+        // A tap between two frames is seen pressed, then released at the next frame.
+        input.PostKey( Keyboard::Key_A, true );
+        input.PostKey( Keyboard::Key_A, false );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Pressed );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Released );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Up );
+
+        // A deferred key keeps the order of its events, the other keys are not delayed.
+        input.PostKey( Keyboard::Key_A, true );
+        input.PostKey( Keyboard::Key_A, false );
+        input.PostKey( Keyboard::Key_A, true );
+        input.PostKey( Keyboard::Key_B, true );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Pressed );
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_B ) == Keyboard::Key_Pressed );
+
+        input.PostKey( Keyboard::Key_B, false );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Released );
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_B ) == Keyboard::Key_Released );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Pressed );
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_B ) == Keyboard::Key_Up );
+
+        // Repeated key down events change nothing and are not deferred.
+        input.PostKey( Keyboard::Key_A, true );
+        input.PostKey( Keyboard::Key_A, true );
+        input.PostKey( Keyboard::Key_A, false );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Released );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Up );
+
+        // Same for the mouse buttons, the movements are summed by frame.
+        input.PostButton( Mouse::Button_Left, true );
+        input.PostButton( Mouse::Button_Left, false );
+        input.PostMotion( Mouse::Axis_X, 3 );
+        input.PostMotion( Mouse::Axis_X, 4 );
+        input.Update();
+        TestAssert( mouse.GetState( Mouse::Button_Left ) == Mouse::Button_Pressed );
+        TestAssert( mouse.GetRelX() == 7 );
+        input.Update();
+        TestAssert( mouse.GetState( Mouse::Button_Left ) == Mouse::Button_Released );
+        TestAssert( mouse.GetRelX() == 0 );
+
+        // An event posted to a full queue is dropped and reported, so the producer can post it again.
+        TestAssert( input.PostKey( Keyboard::Key_A, true ) );
+        for( UInt32 i = 1; i < InputEventQueue::CAPACITY; i++ )
+            TestAssert( input.PostMotion( Mouse::Axis_Y, 1 ) );
+        TestAssert( !input.PostKey( Keyboard::Key_A, false ) );
+        TestAssert( input.GetNbDroppedEvents() == 1 );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Pressed );
+        TestAssert( mouse.GetRelY() == Int32(InputEventQueue::CAPACITY - 1) );
+
+        TestAssert( input.PostKey( Keyboard::Key_A, false ) );
+        input.Update();
+        TestAssert( keyboard.GetKeyState( Keyboard::Key_A ) == Keyboard::Key_Released );
+    }
+
+private:
+    //! Input subsystem fed by the test.
+    class TestInputSubsystem : public InputSubsystem
+    {
+    public:
+        void Update()
+        {
+            FireEvents();
+        }
+
+        Bool PostKey( Keyboard::Key pKey, Bool pDown )
+        {
+            return PostKeyEvent( pKey, pDown, 0 );
+        }
+
+        Bool PostButton( Mouse::Button pButton, Bool pDown )
+        {
+            return PostMouseButtonEvent( pButton, pDown, 0 );
+        }
+
+        Bool PostMotion( Mouse::Axis pAxis, Int32 pValue )
+        {
+            return PostMouseMotionEvent( pAxis, pValue, 0 );
+        }
+
+        using InputSubsystem::mKeyboard;
+        using InputSubsystem::mMouse;
+    };
+};
+
+IMPLEMENT_CLASS(InputSubsystemTest);
@@ -0,0 +1,264 @@
+/**
+ *  @file       TestMathsSIMD.cpp
+ *  @brief      Tests and benchmark for the SSE maths kernels.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Maths/Matrix4.h"
+#include "Maths/Quaternion.h"
+
+using namespace Gamedesk;
+
+
+static Float Random()
+{
+    return Float(rand() % 2000) / 100.0f - 10.0f;
+}
+
+static void RandomMatrix( Matrix4f& pMatrix )
+{
+    for( Int32 i = 0; i < 16; i++ )
+        pMatrix(i) = Random();
+}
+
+static Bool Equal( const Matrix4f& pFirst, const Matrix4f& pSecond, Float pEpsilon )
+{
+    for( Int32 i = 0; i < 16; i++ )
+    {
+        if( Maths::Abs( pFirst(i) - pSecond(i) ) > pEpsilon )
+            return false;
+    }
+    return true;
+}
+
+static Bool Equal( const Vector3f& pFirst, const Vector3f& pSecond, Float pEpsilon )
+{
+    return Maths::Abs( pFirst.x - pSecond.x ) <= pEpsilon &&
+           Maths::Abs( pFirst.y - pSecond.y ) <= pEpsilon &&
+           Maths::Abs( pFirst.z - pSecond.z ) <= pEpsilon;
+}
+
+
+class UNITTESTS_API MathsSIMDTest : public TestCase
+{
+    DECLARE_CLASS( MathsSIMDTest, TestCase );
+
+public:
+    MathsSIMDTest()
+    {
+    }
+
+    virtual void TearDown()
+    {
+        MathsSIMD::SetUseSSE( true );
+    }
+
+    virtual void Run()
+    {
+        static const UInt32 NB_POINTS = 7;
+
+        for( UInt32 iteration = 0; iteration < 100; iteration++ )
+        {
+            Matrix4f first, second;
+            RandomMatrix( first );
+            RandomMatrix( second );
+
+            Vector3f points[NB_POINTS];
+            for( UInt32 i = 0; i < NB_POINTS; i++ )
+                points[i] = Vector3f( Random(), Random(), Random() );
+
+            Quaternionf quat( Random(), Random(), Random(), Random() );
+
+            // Scalar results.
+            MathsSIMD::SetUseSSE( false );
+
+            Matrix4f product = first * second;
+            Vector3f transformed[NB_POINTS];
+            Vector3f rotated[NB_POINTS];
+            first.TransformPoints( points, transformed, NB_POINTS );
+            first.TransformVectors( points, rotated, NB_POINTS );
+
+            Matrix4f quatMatrix;
+            quat.ToMatrix( quatMatrix );
+
+            // SSE results, when available.
+            MathsSIMD::SetUseSSE( true );
+
+            TestAssert( Equal( first * second, product, 0.01f ) );
+
+            Matrix4f inPlace( second );
+            Matrix4f::Multiply( first, inPlace, inPlace );
+            TestAssert( Equal( inPlace, product, 0.01f ) );
+
+            inPlace = first;
+            inPlace *= second;
+            TestAssert( Equal( inPlace, product, 0.01f ) );
+
+            Vector3f result[NB_POINTS];
+            first.TransformPoints( points, result, NB_POINTS );
+            for( UInt32 i = 0; i < NB_POINTS; i++ )
+            {
+                TestAssert( Equal( result[i], transformed[i], 0.001f ) );
+                TestAssert( Equal( points[i] * first, transformed[i], 0.001f ) );
+            }
+
+            first.TransformVectors( points, result, NB_POINTS );
+            for( UInt32 i = 0; i < NB_POINTS; i++ )
+                TestAssert( Equal( result[i], rotated[i], 0.001f ) );
+
+            first.TransformPoints( points, points, NB_POINTS );
+            for( UInt32 i = 0; i < NB_POINTS; i++ )
+                TestAssert( Equal( points[i], transformed[i], 0.001f ) );
+
+            Matrix4f sseQuatMatrix;
+            quat.ToMatrix( sseQuatMatrix );
+            TestAssert( Equal( sseQuatMatrix, quatMatrix, 0.0001f ) );
+        }
+    }
+};
+
+IMPLEMENT_CLASS( MathsSIMDTest );
+
+
+class UNITTESTS_API MathsBenchmark : public TestCase
+{
+    DECLARE_CLASS( MathsBenchmark, TestCase );
+
+public:
+    MathsBenchmark()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mMatrices.resize( NB_ELEMENTS );
+        mResultMatrices.resize( NB_ELEMENTS );
+        mPoints.resize( NB_ELEMENTS );
+        mQuaternions.resize( NB_ELEMENTS );
+        mResultPoints.resize( NB_ELEMENTS );
+
+        for( UInt32 i = 0; i < NB_ELEMENTS; i++ )
+        {
+            RandomMatrix( mMatrices[i] );
+            mPoints[i] = Vector3f( Random(), Random(), Random() );
+            mQuaternions[i] = Quaternionf( Random(), Random(), Random(), Random() );
+        }
+    }
+
+    virtual void TearDown()
+    {
+        MathsSIMD::SetUseSSE( true );
+
+        mMatrices.clear();
+        mResultMatrices.clear();
+        mPoints.clear();
+        mQuaternions.clear();
+        mResultPoints.clear();
+    }
+
+    virtual void Run()
+    {
+        Core::DebugOut( "Maths benchmark, %d elements, operations per ms (scalar / SSE)\n", NB_ELEMENTS );
+
+        UInt64 scalarTime[Bench_Count];
+        UInt64 sseTime[Bench_Count];
+
+        MathsSIMD::SetUseSSE( false );
+        RunAll( scalarTime );
+
+        MathsSIMD::SetUseSSE( true );
+        if( !MathsSIMD::UseSSE() )
+        {
+            Core::DebugOut( "  SSE not available\n" );
+            return;
+        }
+
+        RunAll( sseTime );
+
+        Report( "Multiply", scalarTime[Bench_Multiply], sseTime[Bench_Multiply] );
+        Report( "Point*Matrix", scalarTime[Bench_TransformPoint], sseTime[Bench_TransformPoint] );
+        Report( "TransformPoints", scalarTime[Bench_TransformPoints], sseTime[Bench_TransformPoints] );
+        Report( "ToMatrix", scalarTime[Bench_ToMatrix], sseTime[Bench_ToMatrix] );
+    }
+
+private:
+    enum Bench
+    {
+        Bench_Multiply,
+        Bench_TransformPoint,
+        Bench_TransformPoints,
+        Bench_ToMatrix,
+        Bench_Count
+    };
+
+    void RunAll( UInt64* pTimes )
+    {
+        UInt64 start;
+
+        start = GetTime();
+        for( UInt32 i = 1; i < NB_ELEMENTS; i++ )
+            mResultMatrices[i] = mMatrices[i] * mMatrices[i-1];
+        pTimes[Bench_Multiply] = GetTime() - start;
+
+        const Matrix4f& matrix = mMatrices[0];
+        start = GetTime();
+        for( UInt32 i = 0; i < NB_ELEMENTS; i++ )
+            mResultPoints[i] = mPoints[i] * matrix;
+        pTimes[Bench_TransformPoint] = GetTime() - start;
+
+        start = GetTime();
+        matrix.TransformPoints( &mPoints[0], &mResultPoints[0], NB_ELEMENTS );
+        pTimes[Bench_TransformPoints] = GetTime() - start;
+
+        start = GetTime();
+        for( UInt32 i = 0; i < NB_ELEMENTS; i++ )
+            mQuaternions[i].ToMatrix( mMatrices[i] );
+        pTimes[Bench_ToMatrix] = GetTime() - start;
+    }
+
+    static UInt64 GetTime()
+    {
+        return SystemInfo::Instance()->GetMicroSec64();
+    }
+
+    static void Report( const Char* pName, UInt64 pScalar, UInt64 pSSE )
+    {
+        Core::DebugOut( "  %-16s %10.1f / %10.1f  (x%.1f)\n", pName,
+                        pScalar ? NB_ELEMENTS / (pScalar / 1000.0) : 0.0,
+                        pSSE ? NB_ELEMENTS / (pSSE / 1000.0) : 0.0,
+                        pSSE ? Double(pScalar) / Double(pSSE) : 0.0 );
+    }
+
+private:
+    static const UInt32 NB_ELEMENTS = 1 << 18;
+
+    Vector<Matrix4f>    mMatrices;
+    Vector<Matrix4f>    mResultMatrices;
+    Vector<Vector3f>    mPoints;
+    Vector<Quaternionf> mQuaternions;
+    Vector<Vector3f>    mResultPoints;
+};
+
+IMPLEMENT_CLASS( MathsBenchmark );
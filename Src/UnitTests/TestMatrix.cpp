@@ -33,6 +33,8 @@
 #include <gl/glut.h>
 #include "Maths/Matrix4.h"
 
+using namespace Gamedesk;
+
 
 class UNITTESTS_API MatrixTest : public TestCase
 {
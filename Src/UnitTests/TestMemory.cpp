@@ -0,0 +1,109 @@
+/**
+ *  @file       TestMemory.cpp
+ *  @brief      Tests for the memory allocators and tracker.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+
+
+#include "Memory/LinearAllocator.h"
+#include "Memory/PoolAllocator.h"
+
+using namespace Gamedesk;
+
+
+class UNITTESTS_API MemoryAllocatorsTest : public TestCase
+{
+    DECLARE_CLASS( MemoryAllocatorsTest, TestCase );
+
+public:
+    MemoryAllocatorsTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        // Linear allocator: aligned, contiguous, chains a block when full and merges it on Reset().
+        LinearAllocator arena( 256, "UnitTests::LinearAllocator" );
+
+        Byte* first  = (Byte*)arena.Allocate( 1 );
+        Byte* second = (Byte*)arena.Allocate( 20 );
+        TestAssert( ((size_t)first % LinearAllocator::ALIGNMENT) == 0 );
+        TestAssert( second == first + LinearAllocator::ALIGNMENT );
+        TestAssert( arena.GetUsedBytes() == 3 * LinearAllocator::ALIGNMENT );
+
+        arena.Allocate( 512 );
+        TestAssert( arena.GetCapacity() > 256 );
+        TestAssert( arena.GetPeakBytes() == 3 * LinearAllocator::ALIGNMENT + 512 );
+
+        arena.Reset();
+        TestAssert( arena.GetUsedBytes() == 0 );
+        TestAssert( arena.GetCapacity() == arena.GetPeakBytes() );
+
+        // Pool allocator: blocks are reused and new chunks are added on demand.
+        PoolAllocator pool( 24, 4, "UnitTests::PoolAllocator" );
+        TestAssert( pool.GetBlockSize() == 32 );
+
+        Vector<void*> blocks;
+        for( UInt32 i = 0; i < 6; i++ )
+            blocks.push_back( pool.Allocate( 24 ) );
+
+        TestAssert( pool.GetNbBlocks() == 8 );
+        TestAssert( pool.GetNbUsedBlocks() == 6 );
+
+        void* freed = blocks[2];
+        pool.Free( freed );
+        TestAssert( pool.Allocate( 24 ) == freed );
+
+        for( UInt32 i = 0; i < blocks.size(); i++ )
+            pool.Free( blocks[i] );
+        TestAssert( pool.GetNbUsedBlocks() == 0 );
+
+        // Objects constructed in an allocator.
+        Vector3f* point = GD_NEW_IN(pool, Vector3f)( 1.0f, 2.0f, 3.0f );
+        TestAssert( point->y == 2.0f );
+        GD_DELETE_IN(pool, point);
+        TestAssert( pool.GetNbUsedBlocks() == 0 );
+
+#if GD_CFG_USE_MEMORY_TRACKING == GD_ENABLED
+        // Live and peak bytes per tag.
+        const Char* tag = "UnitTests::MemoryTracker";
+        UInt64 liveBefore = MemoryTracker::GetLiveBytes( tag );
+
+        Byte* data = GD_ALLOC(Byte, 1000, this, tag);
+        TestAssert( MemoryTracker::GetLiveBytes( tag ) == liveBefore + 1000 );
+        TestAssert( MemoryTracker::GetPeakBytes( tag ) >= liveBefore + 1000 );
+
+        GD_FREE(data);
+        TestAssert( MemoryTracker::GetLiveBytes( tag ) == liveBefore );
+
+        Vector3f* vec = GD_NEW(Vector3f, this, tag)( 0.0f, 0.0f, 0.0f );
+        TestAssert( MemoryTracker::GetLiveBytes( tag ) == liveBefore + sizeof(Vector3f) );
+        GD_DELETE(vec);
+        TestAssert( MemoryTracker::GetLiveBytes( tag ) == liveBefore );
+#endif
+    }
+};
+
+IMPLEMENT_CLASS( MemoryAllocatorsTest );
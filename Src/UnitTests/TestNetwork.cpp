@@ -0,0 +1,318 @@
+/**
+ *  @file       TestNetwork.cpp
+ *  @brief      Tests for the network subsystem.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Network/BitStream.h"
+#include "Network/UdpSocket.h"
+#include "Network/NetReplication.h"
+#include "Network/NetServer.h"
+#include "Network/NetClient.h"
+#include "Network/NetConnection.h"
+#include "World/Entity.h"
+#include "SystemInfo/SystemInfo.h"
+
+using namespace Gamedesk;
+
+
+//! Update the server and its clients until every client has the server tick.
+static void Synchronize( NetServer& pServer, Vector<NetClient*>& pClients, UInt32 pMaxUpdates = 200 )
+{
+    for( UInt32 update = 0; update < pMaxUpdates; update++ )
+    {
+        pServer.Update( 0.05 );
+        for( UInt32 i = 0; i < pClients.size(); i++ )
+            pClients[i]->Update( 0.05 );
+
+        Bool synchronized = pServer.GetTick() != 0;
+        for( UInt32 i = 0; i < pClients.size(); i++ )
+            synchronized &= pClients[i]->GetSnapshotTick() == pServer.GetTick();
+
+        if( synchronized )
+            return;
+    }
+}
+
+static Vector3f MovingPosition( UInt32 pIndex, UInt32 pTick )
+{
+    return Vector3f( Float(pIndex), Float(pTick) * 0.1f, 0 );
+}
+
+
+class UNITTESTS_API NetworkTest : public TestCase
+{
+    DECLARE_CLASS( NetworkTest, TestCase );
+
+public:
+    NetworkTest()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        UdpSocket::Startup();
+    }
+
+    virtual void TearDown()
+    {
+        UdpSocket::Shutdown();
+    }
+
+    virtual void Run()
+    {
+        TestBitStream();
+        TestSnapshotDelta();
+        TestReplication();
+    }
+
+    void TestBitStream()
+    {
+        Vector<Byte> data;
+        BitWriter writer( data );
+        writer.WriteBool( true );
+        writer.WriteBits( 5, 3 );
+        writer.WriteVarUInt32( 300 );
+        writer.WriteFloat( 1.5f );
+        writer.WriteString( "Gamedesk" );
+        writer.WriteBits( 0xDEADBEEF, 32 );
+
+        BitReader reader( &data[0], data.size() );
+        TestAssert( reader.ReadBool() );
+        TestAssert( reader.ReadBits( 3 ) == 5 );
+        TestAssert( reader.ReadVarUInt32() == 300 );
+        TestAssert( reader.ReadFloat() == 1.5f );
+
+        String str;
+        reader.ReadString( str );
+        TestAssert( str == "Gamedesk" );
+        TestAssert( reader.ReadBits( 32 ) == 0xDEADBEEF );
+        TestAssert( !reader.IsOverflow() );
+
+        // Reading past the end is detected.
+        reader.ReadBits( 16 );
+        TestAssert( reader.IsOverflow() );
+    }
+
+    void TestSnapshotDelta()
+    {
+        const NetClassLayout* layout = NetClassLayout::Get( Entity::StaticClass() );
+        TestAssert( layout->GetStateSize() > 0 );
+
+        Entity a, b;
+        a.SetPosition( Vector3f(1, 2, 3) );
+        b.SetPosition( Vector3f(4, 5, 6) );
+
+        NetSnapshot baseline;
+        baseline.SetTick( 1 );
+        layout->CaptureState( &a, baseline.AddEntry( 1, layout ) );
+        layout->CaptureState( &b, baseline.AddEntry( 2, layout ) );
+
+        // b moves, a is removed and c is created.
+        Entity c;
+        c.SetPosition( Vector3f(7, 8, 9) );
+        b.SetPosition( Vector3f(4, 5, 7) );
+
+        NetSnapshot snapshot;
+        snapshot.SetTick( 2 );
+        layout->CaptureState( &b, snapshot.AddEntry( 2, layout ) );
+        layout->CaptureState( &c, snapshot.AddEntry( 3, layout ) );
+
+        Vector<Byte> full, delta;
+        BitWriter fullWriter( full );
+        NetSnapshot::WriteDelta( fullWriter, NULL, snapshot );
+        BitWriter deltaWriter( delta );
+        NetSnapshot::WriteDelta( deltaWriter, &baseline, snapshot );
+        TestAssert( deltaWriter.GetNbBits() < fullWriter.GetNbBits() );
+
+        NetSnapshot decoded;
+        BitReader reader( &delta[0], delta.size() );
+        TestAssert( NetSnapshot::ReadDelta( reader, &baseline, decoded ) );
+        TestAssert( decoded.GetNbEntries() == 2 );
+        TestAssert( decoded.Find( 1 ) == -1 );
+
+        Entity copy;
+        layout->ApplyState( decoded.GetState( decoded.Find( 2 ) ), &copy );
+        TestAssert( copy.GetPosition() == b.GetPosition() );
+        layout->ApplyState( decoded.GetState( decoded.Find( 3 ) ), &copy );
+        TestAssert( copy.GetPosition() == c.GetPosition() );
+    }
+
+    void TestReplication()
+    {
+        NetServer server;
+        server.Start( 0, 4 );
+
+        const UInt32 NB_CLIENTS = 3;
+        const UInt32 NB_ENTITIES = 10;
+
+        Vector<NetClient*> clients;
+        for( UInt32 i = 0; i < NB_CLIENTS; i++ )
+        {
+            clients.push_back( GD_NEW(NetClient, 0, "NetClient") );
+            clients[i]->Connect( NetAddress::Loopback( server.GetPort() ) );
+        }
+
+        Vector<Entity*> entities;
+        Vector<UInt32>  netIds;
+        for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+        {
+            entities.push_back( GD_NEW(Entity, 0, "Entity") );
+            netIds.push_back( server.Replicate( entities[i] ) );
+        }
+
+        Synchronize( server, clients );
+        TestAssert( server.GetNbClients() == NB_CLIENTS );
+
+        // Move the entities, the clients follow.
+        for( UInt32 tick = 0; tick < 10; tick++ )
+        {
+            for( UInt32 i = 0; i < NB_ENTITIES; i += 2 )
+                entities[i]->SetPosition( MovingPosition( i, tick ) );
+            Synchronize( server, clients );
+        }
+
+        for( UInt32 c = 0; c < NB_CLIENTS; c++ )
+        {
+            TestAssert( clients[c]->GetState() == NetClient::State_Connected );
+            TestAssert( clients[c]->GetNbObjects() == NB_ENTITIES );
+            for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+            {
+                Entity* copy = Cast<Entity>( clients[c]->GetObject( netIds[i] ) );
+                TestAssert( copy && copy->GetPosition() == entities[i]->GetPosition() );
+            }
+        }
+
+        // Objects no longer replicated are deleted on the clients.
+        server.StopReplicating( entities[0] );
+        Synchronize( server, clients );
+        for( UInt32 c = 0; c < NB_CLIENTS; c++ )
+        {
+            TestAssert( clients[c]->GetNbObjects() == NB_ENTITIES - 1 );
+            TestAssert( clients[c]->GetObject( netIds[0] ) == NULL );
+        }
+
+        // A client leaving is removed from the server.
+        clients[0]->Disconnect();
+        Synchronize( server, clients );
+        TestAssert( server.GetNbClients() == NB_CLIENTS - 1 );
+
+        for( UInt32 i = 0; i < NB_CLIENTS; i++ )
+            GD_DELETE(clients[i]);
+
+        server.Stop();
+        for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+        {
+            if( i != 0 )
+                server.StopReplicating( entities[i] );
+            GD_DELETE(entities[i]);
+        }
+    }
+};
+
+IMPLEMENT_CLASS(NetworkTest);
+
+
+/**
+ *  Measure the bandwidth and the server tick time for an increasing number
+ *  of clients, with 256 entities of which one in eight moves every tick.
+ */
+class UNITTESTS_API NetworkBenchmark : public TestCase
+{
+    DECLARE_CLASS( NetworkBenchmark, TestCase );
+
+public:
+    NetworkBenchmark()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        UdpSocket::Startup();
+    }
+
+    virtual void TearDown()
+    {
+        UdpSocket::Shutdown();
+    }
+
+    virtual void Run()
+    {
+        const UInt32 NB_ENTITIES = 256;
+        const UInt32 NB_TICKS = 50;
+        const UInt32 nbClients[] = { 1, 8, 32, 64 };
+
+        for( UInt32 test = 0; test < sizeof(nbClients) / sizeof(nbClients[0]); test++ )
+        {
+            NetServer server;
+            server.Start( 0, nbClients[test] );
+
+            Vector<NetClient*> clients;
+            for( UInt32 i = 0; i < nbClients[test]; i++ )
+            {
+                clients.push_back( GD_NEW(NetClient, 0, "NetClient") );
+                clients[i]->Connect( NetAddress::Loopback( server.GetPort() ) );
+            }
+
+            Vector<Entity*> entities;
+            for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+            {
+                entities.push_back( GD_NEW(Entity, 0, "Entity") );
+                server.Replicate( entities[i] );
+            }
+
+            // Initial state, sent in full.
+            Synchronize( server, clients );
+
+            UInt64 tickTime = 0;
+            UInt64 snapshotBytes = 0;
+            for( UInt32 tick = 0; tick < NB_TICKS; tick++ )
+            {
+                for( UInt32 i = tick % 8; i < NB_ENTITIES; i += 8 )
+                    entities[i]->SetPosition( MovingPosition( i, tick ) );
+
+                Synchronize( server, clients );
+                tickTime += server.GetLastTickTime();
+                snapshotBytes += server.GetLastSnapshotBytes();
+            }
+
+            Core::DebugOut( "NetworkBenchmark: %3d clients, %6.1f bytes/client/tick, server tick %8.1f us\n",
+                            nbClients[test],
+                            Double(snapshotBytes) / (NB_TICKS * nbClients[test]),
+                            Double(tickTime) / NB_TICKS );
+
+            for( UInt32 i = 0; i < clients.size(); i++ )
+                GD_DELETE(clients[i]);
+
+            server.Stop();
+            for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+            {
+                server.StopReplicating( entities[i] );
+                GD_DELETE(entities[i]);
+            }
+        }
+    }
+};
+
+IMPLEMENT_CLASS(NetworkBenchmark);
@@ -0,0 +1,343 @@
+/**
+ *  @file       TestPackage.cpp
+ *  @brief      Tests for the incremental package save.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Package/Package.h"
+#include "FileManager/FileManager.h"
+#include "World/World.h"
+#include "World/Entity.h"
+
+using namespace Gamedesk;
+
+
+class UNITTESTS_API PackageTestObject : public Object
+{
+    DECLARE_CLASS( PackageTestObject, Object );
+
+public:
+    PackageTestObject()
+        : mValue(0)
+        , mReference(NULL)
+    {
+    }
+
+    virtual void Serialize( Stream& pStream )
+    {
+        pStream << mValue;
+        pStream << mReference;
+        mNbSerialized++;
+    }
+
+    Int32           mValue;
+    Object*         mReference;
+
+    static UInt32   mNbSerialized;
+};
+
+UInt32 PackageTestObject::mNbSerialized = 0;
+
+IMPLEMENT_CLASS( PackageTestObject );
+
+
+class UNITTESTS_API PackageSaveTest : public TestCase
+{
+    DECLARE_CLASS( PackageSaveTest, TestCase );
+
+public:
+    PackageSaveTest()
+        : mPackage(NULL)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mPackage = PackageManager::Instance()->CreatePackage( "TestPackage.gdp" );
+
+        for( UInt32 i = 0; i < NB_OBJECTS; i++ )
+            AddObject( i, i > 0 ? mObjects[i - 1] : NULL );
+    }
+
+    virtual void Run()
+    {
+        PackageTestObject::mNbSerialized = 0;
+        mPackage->Save();
+        TestAssert( PackageTestObject::mNbSerialized == NB_OBJECTS );
+
+        // Nothing changed, nothing is serialized.
+        PackageTestObject::mNbSerialized = 0;
+        mPackage->Save();
+        TestAssert( PackageTestObject::mNbSerialized == 0 );
+
+        // Only the modified and new objects are serialized.
+        mObjects[3]->mValue = 100;
+        mObjects[3]->MarkDirty();
+        AddObject( 1000, mObjects[0] );
+
+        PackageTestObject::mNbSerialized = 0;
+        mPackage->Save();
+        TestAssert( PackageTestObject::mNbSerialized == 2 );
+
+        // The file holds the data of the last save, references included.
+        mObjects[3]->mValue = 0;
+        mObjects[5]->mReference = NULL;
+        mObjects[NB_OBJECTS]->mReference = NULL;
+        mPackage->Load();
+        TestAssert( mObjects[3]->mValue == 100 );
+        TestAssert( mObjects[4]->mValue == 4 );
+        TestAssert( mObjects[5]->mReference == mObjects[4] );
+        TestAssert( mObjects[NB_OBJECTS]->mReference == mObjects[0] );
+
+        // Renaming an object moves it in the tables, everything is saved again.
+        mObjects[2]->SetName( "Renamed" );
+        PackageTestObject::mNbSerialized = 0;
+        mPackage->Save();
+        TestAssert( PackageTestObject::mNbSerialized == mObjects.size() );
+
+        // The file was modified by someone else, it can't be trusted.
+        FileManager::DeleteFile( "TestPackage.gdp" );
+        PackageTestObject::mNbSerialized = 0;
+        mPackage->Save();
+        TestAssert( PackageTestObject::mNbSerialized == mObjects.size() );
+    }
+
+    virtual void TearDown()
+    {
+        for( UInt32 i = 0; i < mObjects.size(); i++ )
+            GD_DELETE(mObjects[i]);
+        mObjects.clear();
+
+        GD_DELETE(mPackage);
+        FileManager::DeleteFile( "TestPackage.gdp" );
+    }
+
+private:
+    static const UInt32 NB_OBJECTS = 10;
+
+    void AddObject( Int32 pValue, PackageTestObject* pReference )
+    {
+        PackageTestObject* obj = Cast<PackageTestObject>( PackageTestObject::StaticClass()->AllocateNew( String("Object") + ToString(mObjects.size()) ) );
+        obj->SetOwner( mPackage );
+        obj->mValue     = pValue;
+        obj->mReference = pReference;
+        mObjects.push_back( obj );
+    }
+
+private:
+    Package*                    mPackage;
+    Vector<PackageTestObject*>  mObjects;
+};
+
+IMPLEMENT_CLASS( PackageSaveTest );
+
+
+class UNITTESTS_API PackageCompressionTest : public TestCase
+{
+    DECLARE_CLASS( PackageCompressionTest, TestCase );
+
+public:
+    PackageCompressionTest()
+        : mPackage(NULL)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mPackage = PackageManager::Instance()->CreatePackage( "TestCompressedPackage.gdp" );
+
+        for( UInt32 i = 0; i < NB_OBJECTS; i++ )
+        {
+            PackageTestObject* obj = Cast<PackageTestObject>( PackageTestObject::StaticClass()->AllocateNew( String("Object") + ToString(i) ) );
+            obj->SetOwner( mPackage );
+            obj->mValue     = i % 10;
+            obj->mReference = i > 0 ? mObjects[i - 1] : NULL;
+            mObjects.push_back( obj );
+        }
+    }
+
+    virtual void Run()
+    {
+        mPackage->Save();
+        UInt32 rawSize = FileManager::GetFileSize( "TestCompressedPackage.gdp" );
+
+        mPackage->SetCompression( Compression::Codec_LZ4 );
+        mObjects[0]->MarkDirty();
+        mPackage->Save();
+        TestAssert( FileManager::GetFileSize( "TestCompressedPackage.gdp" ) < rawSize / 2 );
+
+        // Incremental save from a compressed file.
+        mObjects[7]->mValue = 100;
+        mObjects[7]->MarkDirty();
+        PackageTestObject::mNbSerialized = 0;
+        mPackage->Save();
+        TestAssert( PackageTestObject::mNbSerialized == 1 );
+
+        mObjects[7]->mValue = 0;
+        mObjects[8]->mReference = NULL;
+        mPackage->SetCompression( Compression::Codec_None );
+        mPackage->Load();
+        TestAssert( mPackage->GetCompression() == Compression::Codec_LZ4 );
+        TestAssert( mObjects[7]->mValue == 100 );
+        TestAssert( mObjects[8]->mValue == 8 );
+        TestAssert( mObjects[8]->mReference == mObjects[7] );
+    }
+
+    virtual void TearDown()
+    {
+        for( UInt32 i = 0; i < mObjects.size(); i++ )
+            GD_DELETE(mObjects[i]);
+        mObjects.clear();
+
+        GD_DELETE(mPackage);
+        FileManager::DeleteFile( "TestCompressedPackage.gdp" );
+    }
+
+private:
+    static const UInt32 NB_OBJECTS = 1000;
+
+private:
+    Package*                    mPackage;
+    Vector<PackageTestObject*>  mObjects;
+};
+
+IMPLEMENT_CLASS( PackageCompressionTest );
+
+
+class UNITTESTS_API PackageWorldTest : public TestCase
+{
+    DECLARE_CLASS( PackageWorldTest, TestCase );
+
+public:
+    PackageWorldTest()
+        : mPackage(NULL)
+        , mWorld(NULL)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mPackage = PackageManager::Instance()->CreatePackage( "TestWorldPackage.gdp" );
+
+        mWorld = Cast<World>( World::StaticClass()->AllocateNew( "TestWorld" ) );
+        mWorld->SetOwner( mPackage );
+    }
+
+    virtual void Run()
+    {
+        Entity* first = mWorld->SpawnEntity( Entity::StaticClass(), Vector3f(0, 0, 0), Quaternionf(1, 0, 0, 0), "First" );
+        mPackage->Save();
+
+        // An entity spawned in a saved world must not be lost by the next incremental save.
+        Entity* second = mWorld->SpawnEntity( Entity::StaticClass(), Vector3f(10, 0, 0), Quaternionf(1, 0, 0, 0), "Second" );
+        mPackage->Save();
+
+        mWorld->RemoveEntity( second );
+        second->SetPosition( Vector3f(0, 0, 0) );
+        mPackage->Load();
+
+        const List<Entity*>& entities = mWorld->GetEntities();
+        TestAssert( entities.size() == 2 );
+        TestAssert( entities.front() == first );
+        TestAssert( entities.back() == second );
+        TestAssert( second->GetPosition() == Vector3f(10, 0, 0) );
+
+        // Moving an entity only dirties the entity, the world entity list is kept.
+        first->SetPosition( Vector3f(5, 0, 0) );
+        mPackage->Save();
+        first->SetPosition( Vector3f(0, 0, 0) );
+        mPackage->Load();
+        TestAssert( first->GetPosition() == Vector3f(5, 0, 0) );
+        TestAssert( mWorld->GetEntities().size() == 2 );
+    }
+
+    virtual void TearDown()
+    {
+        mWorld->Kill();
+        GD_DELETE(mWorld);
+
+        GD_DELETE(mPackage);
+        FileManager::DeleteFile( "TestWorldPackage.gdp" );
+    }
+
+private:
+    Package*    mPackage;
+    World*      mWorld;
+};
+
+IMPLEMENT_CLASS( PackageWorldTest );
+
+
+class UNITTESTS_API WorldSaveTest : public TestCase
+{
+    DECLARE_CLASS( WorldSaveTest, TestCase );
+
+public:
+    WorldSaveTest()
+        : mWorld(NULL)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mWorld = Cast<World>( World::StaticClass()->AllocateNew( "TestSavedWorld" ) );
+    }
+
+    virtual void Run()
+    {
+        Entity* first  = mWorld->SpawnEntity( Entity::StaticClass(), Vector3f(1, 2, 3), Quaternionf(1, 0, 0, 0), "First" );
+        Entity* second = mWorld->SpawnEntity( Entity::StaticClass(), Vector3f(4, 5, 6), Quaternionf(1, 0, 0, 0), "Second" );
+
+        TestRoundTrip( first, second, Compression::Codec_None );
+        TestRoundTrip( first, second, Compression::Codec_LZ4 );
+    }
+
+    virtual void TearDown()
+    {
+        mWorld->Kill();
+        GD_DELETE(mWorld);
+
+        FileManager::DeleteFile( "TestSavedWorld.gdw" );
+    }
+
+private:
+    void TestRoundTrip( Entity* pFirst, Entity* pSecond, Compression::Codec pCodec )
+    {
+        mWorld->SaveWorld( "TestSavedWorld.gdw", pCodec );
+
+        pFirst->SetPosition( Vector3f(0, 0, 0) );
+        pSecond->SetPosition( Vector3f(0, 0, 0) );
+        mWorld->RemoveEntity( pSecond );
+
+        mWorld->LoadWorld( "TestSavedWorld.gdw" );
+        TestAssert( mWorld->GetEntities().size() == 2 );
+        TestAssert( pFirst->GetPosition() == Vector3f(1, 2, 3) );
+        TestAssert( pSecond->GetPosition() == Vector3f(4, 5, 6) );
+    }
+
+private:
+    World*  mWorld;
+};
+
+IMPLEMENT_CLASS( WorldSaveTest );
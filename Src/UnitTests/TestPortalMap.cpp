@@ -0,0 +1,281 @@
+/**
+ *  @file       TestPortalMap.cpp
+ *  @brief      PortalMap and PortalPartition tests.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Maths/Frustum.h"
+#include "World/SpacePartition/PortalMap.h"
+#include "World/SpacePartition/PortalPartition.h"
+
+using namespace Gamedesk;
+
+
+/**
+ *  Four areas, looking down -z from area 0:
+ *  area 0 (z > -10, x < 10), area 1 (-20 < z < -10), area 2 (-30 < z < -20)
+ *  and area 3 (z > -10, x > 10) on the side. Portal 0 is a small window from
+ *  area 0 to area 1, portal 1 leads from area 1 to area 2 off to the right,
+ *  where it can't be seen through portal 0, and portal 2 leads from area 0
+ *  to area 3, outside the view. Beyond z = -30 is solid.
+ */
+static void BuildPortalMap( PortalMap& pMap )
+{
+    pMap.mAreas.resize( 4 );
+    pMap.mPortals.resize( 3 );
+    pMap.mNodes.resize( 4 );
+
+    PortalMap::Portal& window = pMap.mPortals[0];
+    window.mAreas[0] = 0;
+    window.mAreas[1] = 1;
+    window.mPoints.push_back( Vector3f(-2, -2, -10) );
+    window.mPoints.push_back( Vector3f( 2, -2, -10) );
+    window.mPoints.push_back( Vector3f( 2,  2, -10) );
+    window.mPoints.push_back( Vector3f(-2,  2, -10) );
+
+    PortalMap::Portal& right = pMap.mPortals[1];
+    right.mAreas[0] = 1;
+    right.mAreas[1] = 2;
+    right.mPoints.push_back( Vector3f( 6, -2, -20) );
+    right.mPoints.push_back( Vector3f(10, -2, -20) );
+    right.mPoints.push_back( Vector3f(10,  2, -20) );
+    right.mPoints.push_back( Vector3f( 6,  2, -20) );
+
+    PortalMap::Portal& side = pMap.mPortals[2];
+    side.mAreas[0] = 0;
+    side.mAreas[1] = 3;
+    side.mPoints.push_back( Vector3f(10, -2, -2) );
+    side.mPoints.push_back( Vector3f(10,  2, -2) );
+    side.mPoints.push_back( Vector3f(10,  2, -8) );
+    side.mPoints.push_back( Vector3f(10, -2, -8) );
+
+    // z > -10 : x > 10 is area 3, else area 0.
+    pMap.mNodes[0].mPlane = Plane3f( Vector3f(0, 0, 1), -10.0f );
+    pMap.mNodes[0].mChildren[0] = 1;
+    pMap.mNodes[0].mChildren[1] = 2;
+
+    pMap.mNodes[1].mPlane = Plane3f( Vector3f(1, 0, 0), 10.0f );
+    pMap.mNodes[1].mChildren[0] = -1 - 3;
+    pMap.mNodes[1].mChildren[1] = -1 - 0;
+
+    // z < -10 : area 1 down to z = -20, then area 2 down to z = -30.
+    pMap.mNodes[2].mPlane = Plane3f( Vector3f(0, 0, 1), -20.0f );
+    pMap.mNodes[2].mChildren[0] = -1 - 1;
+    pMap.mNodes[2].mChildren[1] = 3;
+
+    pMap.mNodes[3].mPlane = Plane3f( Vector3f(0, 0, 1), -30.0f );
+    pMap.mNodes[3].mChildren[0] = -1 - 2;
+    pMap.mNodes[3].mChildren[1] = 0;
+
+    pMap.Init();
+}
+
+
+class UNITTESTS_API PortalMapTest : public TestCase
+{
+    DECLARE_CLASS( PortalMapTest, TestCase );
+
+public:
+    PortalMapTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        // Without nodes, everything is in the first area, if there's one.
+        PortalMap empty;
+        TestAssert( empty.FindArea( Vector3f(0, 0, 0) ) == -1 );
+
+        empty.mAreas.resize( 1 );
+        TestAssert( empty.FindArea( Vector3f(0, 0, 0) ) == 0 );
+
+        PortalMap map;
+        BuildPortalMap( map );
+
+        TestAssert( map.FindArea( Vector3f( 0, 0,  -1) ) == 0 );
+        TestAssert( map.FindArea( Vector3f(15, 0,  -5) ) == 3 );
+        TestAssert( map.FindArea( Vector3f( 0, 0, -15) ) == 1 );
+        TestAssert( map.FindArea( Vector3f( 8, 0, -25) ) == 2 );
+        TestAssert( map.FindArea( Vector3f( 0, 0, -35) ) == -1 );
+
+        // On a node plane, the point is on the negative side.
+        TestAssert( map.FindArea( Vector3f( 0, 0, -10) ) == 1 );
+
+        // Init() links the areas to their portals, each portal plane faces the side its points turn counterclockwise around.
+        TestAssert( map.mAreas[0].mPortals.size() == 2 );
+        TestAssert( map.mAreas[1].mPortals.size() == 2 );
+        TestAssert( map.mAreas[2].mPortals.size() == 1 );
+        TestAssert( map.mAreas[3].mPortals.size() == 1 );
+        TestAssert( Maths::Abs( map.mPortals[0].mPlane.DistanceTo( Vector3f(0, 0, -9) ) - 1.0f ) < EPSILON );
+        TestAssert( Maths::Abs( map.mPortals[2].mPlane.DistanceTo( Vector3f(9, 0, -5) ) - 1.0f ) < EPSILON );
+    }
+
+private:
+    static const Float EPSILON;
+};
+
+const Float PortalMapTest::EPSILON = 0.0001f;
+
+IMPLEMENT_CLASS( PortalMapTest );
+
+
+class UNITTESTS_API PortalClipTest : public TestCase
+{
+    DECLARE_CLASS( PortalClipTest, TestCase );
+
+public:
+    PortalClipTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        Vector<Vector3f> square;
+        square.push_back( Vector3f(-1, -1, 0) );
+        square.push_back( Vector3f( 1, -1, 0) );
+        square.push_back( Vector3f( 1,  1, 0) );
+        square.push_back( Vector3f(-1,  1, 0) );
+
+        Vector<Vector3f> clipped;
+
+        // Completely on the positive side, the polygon is kept as is.
+        PortalPartition::ClipPolygon( square, Plane3f( Vector3f(1, 0, 0), -2.0f ), clipped );
+        TestAssert( clipped.size() == 4 );
+        for( UInt32 i = 0; i < clipped.size(); i++ )
+            TestAssert( clipped[i] == square[i] );
+
+        // Completely on the negative side, nothing is left.
+        PortalPartition::ClipPolygon( square, Plane3f( Vector3f(1, 0, 0), 2.0f ), clipped );
+        TestAssert( clipped.empty() );
+
+        // Cut in half, the two crossed edges are split at their intersection with the plane.
+        PortalPartition::ClipPolygon( square, Plane3f( Vector3f(1, 0, 0), 0.0f ), clipped );
+        TestAssert( clipped.size() == 4 );
+        TestAssert( clipped[0] == Vector3f(0, -1, 0) );
+        TestAssert( clipped[1] == Vector3f(1, -1, 0) );
+        TestAssert( clipped[2] == Vector3f(1,  1, 0) );
+        TestAssert( clipped[3] == Vector3f(0,  1, 0) );
+
+        // Cutting a corner adds a vertex.
+        PortalPartition::ClipPolygon( square, Plane3f( Vector3f(-1, -1, 0), -1.0f ), clipped );
+        TestAssert( clipped.size() == 5 );
+        for( UInt32 i = 0; i < clipped.size(); i++ )
+            TestAssert( clipped[i].x + clipped[i].y <= 1.0f );
+    }
+};
+
+IMPLEMENT_CLASS( PortalClipTest );
+
+
+class UNITTESTS_API PortalFloodTest : public TestCase
+{
+    DECLARE_CLASS( PortalFloodTest, TestCase );
+
+public:
+    PortalFloodTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        PortalMap map;
+        BuildPortalMap( map );
+
+        PortalPartition partition;
+        partition.SetMap( &map );
+
+        // From area 0, area 1 is seen through the window, but not portal 1 which is off to
+        // the right of it. Portal 2 is tested, then clipped out of the view.
+        Vector3f viewPoint( 0, 0, -1 );
+        partition.UpdateVisibility( viewPoint, GetFrustum( viewPoint, false ) );
+        TestAssert( partition.GetNbVisitedAreas() == 2 );
+        TestAssert( partition.GetNbVisitedPortals() == 3 );
+
+        // Closer to it, portal 1 is in the view: area 2 is reached through area 1.
+        // Portal 0 leads back behind, it's tested and clipped.
+        viewPoint = Vector3f( 0, 0, -11 );
+        partition.UpdateVisibility( viewPoint, GetFrustum( viewPoint, false ) );
+        TestAssert( partition.GetNbVisitedAreas() == 2 );
+        TestAssert( partition.GetNbVisitedPortals() == 2 );
+
+        // Turned around, all the portals of area 0 are behind the camera.
+        viewPoint = Vector3f( 0, 0, -1 );
+        partition.UpdateVisibility( viewPoint, GetFrustum( viewPoint, true ) );
+        TestAssert( partition.GetNbVisitedAreas() == 1 );
+        TestAssert( partition.GetNbVisitedPortals() == 2 );
+
+        // Standing in the window, area 0 is entered without being narrowed by it, even
+        // though the window is seen edge-on. Portal 2 is still outside the view.
+        viewPoint = Vector3f( 0, 0, -10 );
+        partition.UpdateVisibility( viewPoint, GetFrustum( viewPoint, true ) );
+        TestAssert( partition.GetNbVisitedAreas() == 2 );
+        TestAssert( partition.GetNbVisitedPortals() == 3 );
+
+        // Outside the map, every area is visible.
+        viewPoint = Vector3f( 0, 0, -40 );
+        partition.UpdateVisibility( viewPoint, GetFrustum( viewPoint, true ) );
+        TestAssert( partition.GetNbVisitedAreas() == 4 );
+        TestAssert( partition.GetNbVisitedPortals() == 0 );
+
+        partition.SetMap( NULL );
+    }
+
+private:
+    /**
+     *  Frustum of a 90 degrees camera at pViewPoint, looking down -z, or +z if
+     *  pLookBack is true. The matrices are laid out as the renderer returns them.
+     */
+    static Frustum GetFrustum( const Vector3f& pViewPoint, Bool pLookBack )
+    {
+        const Float nearView = 0.1f;
+        const Float farView  = 100.0f;
+
+        Matrix4f projectionMatrix;
+        projectionMatrix.SetNull();
+        projectionMatrix(0)  = 1.0f;
+        projectionMatrix(5)  = 1.0f;
+        projectionMatrix(10) = (farView + nearView) / (nearView - farView);
+        projectionMatrix(11) = -1.0f;
+        projectionMatrix(14) = 2.0f * farView * nearView / (nearView - farView);
+
+        // Translate to the view point, then turn half a turn around y to look back.
+        Float turn = pLookBack ? -1.0f : 1.0f;
+
+        Matrix4f modelViewMatrix;
+        modelViewMatrix.SetNull();
+        modelViewMatrix(0)  = turn;
+        modelViewMatrix(5)  = 1.0f;
+        modelViewMatrix(10) = turn;
+        modelViewMatrix(12) = -pViewPoint.x * turn;
+        modelViewMatrix(13) = -pViewPoint.y;
+        modelViewMatrix(14) = -pViewPoint.z * turn;
+        modelViewMatrix(15) = 1.0f;
+
+        Frustum frustum;
+        frustum.CalculateFrustum( projectionMatrix, modelViewMatrix );
+        return frustum;
+    }
+};
+
+IMPLEMENT_CLASS( PortalFloodTest );
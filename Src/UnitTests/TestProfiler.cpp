@@ -0,0 +1,149 @@
+/**
+ *  @file       TestProfiler.cpp
+ *  @brief      Profiler persistent names and thread rings tests.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Debug/PerformanceMonitor.h"
+#include "FileManager/FileManager.h"
+#include "Thread/Thread.h"
+
+using namespace Gamedesk;
+
+
+#if GD_CFG_USE_PERF_MONITOR == GD_ENABLED
+
+
+class UNITTESTS_API ProfilerTest : public TestCase
+{
+    DECLARE_CLASS( ProfilerTest, TestCase );
+
+public:
+    ProfilerTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        // Equal names share one copy, it doesn't depend on the string asked for.
+        String name( "ProfilerTest::Scope" );
+        const Char* persistentName = Profiler::GetPersistentName( name );
+        TestAssert( persistentName != name.c_str() && name == persistentName );
+        TestAssert( Profiler::GetPersistentName( String("ProfilerTest::Scope") ) == persistentName );
+        TestAssert( Profiler::GetPersistentName( String("ProfilerTest::Other") ) != persistentName );
+
+        {
+            Profile( name );
+        }
+
+        // The scopes of an exited thread are collected, then its ring is freed.
+        Profiler::StartCapture();
+        UInt32 nbThreads = Profiler::GetNbThreads();
+
+        ProfiledThread thread;
+        thread.Start();
+        thread.WaitUntilStopped();
+        TestAssert( thread.mPersistentName == persistentName );
+        TestAssert( Profiler::GetNbThreads() == nbThreads + 1 );
+
+        TestAssert( Profiler::StopCapture( TRACE_FILE_NAME ) );
+        TestAssert( Profiler::GetNbThreads() == nbThreads );
+
+        // One scope at the root of each thread, the second one is nested in the thread scope.
+        TestAssert( GetNbSamples( "ProfilerTest::Thread" ) == 1 );
+        TestAssert( GetNbSamples( "ProfilerTest::Scope" ) == 2 );
+
+        // The thread name outlives the ring.
+        TestAssert( ReadTrace().find( "\"name\":\"ProfilerTest::ProfiledThread\"" ) != String::npos );
+    }
+
+    virtual void TearDown()
+    {
+        FileManager::DeleteFile( TRACE_FILE_NAME );
+    }
+
+private:
+    static const Char* TRACE_FILE_NAME;
+
+    //! Profile a scope by name and by persistent name, then exit.
+    class ProfiledThread : public Thread
+    {
+    public:
+        ProfiledThread() : mPersistentName(NULL)
+        {
+        }
+
+        virtual void Run()
+        {
+            Profiler::SetThreadName( "ProfilerTest::ProfiledThread" );
+
+            Profile( "ProfilerTest::Thread" );
+            {
+                Profile( String("ProfilerTest::Scope") );
+                mPersistentName = Profiler::GetPersistentName( String("ProfilerTest::Scope") );
+            }
+        }
+
+        const Char*     mPersistentName;
+    };
+
+    //! Return the number of samples of the scopes named pName, wherever they are in the tree.
+    static UInt32 GetNbSamples( const Char* pName )
+    {
+        tree<PerformanceStats>& stats = PerformanceMonitor::mStats;
+        UInt32 nbSamples = 0;
+
+        for( tree<PerformanceStats>::iterator itr = stats.begin(); itr != stats.end(); ++itr )
+        {
+            if( itr->mName == pName )
+                nbSamples += itr->mSamples;
+        }
+
+        return nbSamples;
+    }
+
+    static String ReadTrace()
+    {
+        String trace;
+
+        FILE* file = fopen( TRACE_FILE_NAME, "rb" );
+        if( !file )
+            return trace;
+
+        Char buffer[256];
+        size_t size;
+        while( (size = fread( buffer, 1, sizeof(buffer), file )) != 0 )
+            trace.append( buffer, size );
+
+        fclose( file );
+        return trace;
+    }
+};
+
+const Char* ProfilerTest::TRACE_FILE_NAME = "TestProfiler.json";
+
+IMPLEMENT_CLASS( ProfilerTest );
+
+
+#endif
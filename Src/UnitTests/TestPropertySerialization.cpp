@@ -0,0 +1,352 @@
+/**
+ *  @file       TestPropertySerialization.cpp
+ *  @brief      Tests for the serialization generated by gdprop.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Package/Package.h"
+#include "Stream/MemoryStream.h"
+#include "FileManager/FileManager.h"
+#include "SystemInfo/SystemInfo.h"
+#include "World/TestEntities/TestProperties.h"
+
+using namespace Gamedesk;
+
+
+/**
+ *  Accessors for the protected properties of TestProperties, which is a friend of this class.
+ */
+class TestPropertiesAccess
+{
+public:
+    static void Modify( TestProperties* pObject, UInt32 pSeed )
+    {
+        pObject->mBool       = (pSeed & 1) != 0;
+        pObject->mChar       = Char('a' + pSeed % 26);
+        pObject->mInt16      = Int16(-(Int32)pSeed);
+        pObject->mInt32      = -(Int32)pSeed * 3;
+        pObject->mInt64      = -(Int64)pSeed * 5;
+        pObject->mByte       = Byte(pSeed);
+        pObject->mUInt16     = UInt16(pSeed * 7);
+        pObject->mUInt32     = pSeed * 11;
+        pObject->mUInt64     = UInt64(pSeed) * 13;
+        pObject->mFloat      = pSeed * 0.5f;
+        pObject->mDouble     = pSeed * 0.25;
+        pObject->mColor3     = Color3f(0.1f, 0.2f, pSeed * 0.01f);
+        pObject->mColor4     = Color4f(0.1f, 0.2f, 0.3f, pSeed * 0.01f);
+        pObject->mVector3    = Vector3f(Float(pSeed), 2.0f, 3.0f);
+        pObject->mQuaternion = Quaternionf(0.5f, 0.5f, 0.5f, 0.5f);
+        pObject->mString     = String("Entity") + ToString(pSeed);
+        pObject->mEnum       = TestProperties::Third;
+        pObject->mPosition   = Vector3f(Float(pSeed % 256) * 4.0f, 0.0f, Float(pSeed / 256) * 4.0f);
+    }
+
+    static Bool Equal( const TestProperties* pA, const TestProperties* pB )
+    {
+        return pA->mBool == pB->mBool && pA->mChar == pB->mChar && pA->mInt16 == pB->mInt16 &&
+               pA->mInt32 == pB->mInt32 && pA->mInt64 == pB->mInt64 && pA->mByte == pB->mByte &&
+               pA->mUInt16 == pB->mUInt16 && pA->mUInt32 == pB->mUInt32 && pA->mUInt64 == pB->mUInt64 &&
+               pA->mFloat == pB->mFloat && pA->mDouble == pB->mDouble &&
+               memcmp(&pA->mColor3, &pB->mColor3, sizeof(pA->mColor3)) == 0 &&
+               memcmp(&pA->mColor4, &pB->mColor4, sizeof(pA->mColor4)) == 0 &&
+               memcmp(&pA->mVector3, &pB->mVector3, sizeof(pA->mVector3)) == 0 &&
+               memcmp(&pA->mQuaternion, &pB->mQuaternion, sizeof(pA->mQuaternion)) == 0 &&
+               pA->mString == pB->mString && pA->mEnum == pB->mEnum &&
+               pA->GetPosition() == pB->GetPosition();
+    }
+
+    //! Serialize as the properties were before gdprop generated the code, one virtual call per field.
+    static void SerializePerField( TestProperties* pObject, Stream& pStream )
+    {
+        pStream << pObject->mPosition;
+        pStream << pObject->mOrientation;
+        pStream << pObject->mBool << pObject->mChar << pObject->mInt16 << pObject->mInt32 << pObject->mInt64;
+        pStream << pObject->mByte << pObject->mUInt16 << pObject->mUInt32 << pObject->mUInt64;
+        pStream << pObject->mFloat << pObject->mDouble;
+        pStream << pObject->mColor3.R << pObject->mColor3.G << pObject->mColor3.B;
+        pStream << pObject->mColor4.R << pObject->mColor4.G << pObject->mColor4.B << pObject->mColor4.A;
+        pStream << pObject->mVector3;
+        pStream << pObject->mQuaternion;
+        pStream << pObject->mString;
+        pStream.Serialize( &pObject->mEnum, sizeof(pObject->mEnum) );
+    }
+};
+
+
+static UInt32 GetPropertyIndex( Class* pClass, const Char* pName )
+{
+    UInt32 index = 0;
+    for( Class::PropertyIterator itProp(pClass); itProp; ++itProp, ++index )
+    {
+        if( strcmp( (*itProp)->GetName(), pName ) == 0 )
+            return index;
+    }
+
+    return Number<UInt32>::Max;
+}
+
+
+class UNITTESTS_API PropertySerializationTest : public TestCase
+{
+    DECLARE_CLASS( PropertySerializationTest, TestCase );
+
+public:
+    PropertySerializationTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        TestProperties source;
+        TestProperties loaded;
+        TestPropertiesAccess::Modify( &source, 42 );
+        TestAssert( !TestPropertiesAccess::Equal( &source, &loaded ) );
+
+        // Round trip.
+        Vector<Byte> data;
+        MemoryOutputStream outStream( data );
+        source.Serialize( outStream );
+
+        MemoryInputStream inStream( &data[0], data.size() );
+        loaded.Serialize( inStream );
+        TestAssert( inStream.Pos() == data.size() );
+        TestAssert( TestPropertiesAccess::Equal( &source, &loaded ) );
+
+        // Same layout as streaming the fields one at a time.
+        Vector<Byte> propertyData;
+        MemoryOutputStream propertyStream( propertyData );
+        TestProperties::StaticClass()->SerializeProperties( &source, propertyStream );
+
+        Vector<Byte> fieldData;
+        MemoryOutputStream fieldStream( fieldData );
+        TestPropertiesAccess::SerializePerField( &source, fieldStream );
+        TestAssert( propertyData == fieldData );
+
+        // Only the modified properties are flagged.
+        Class* testClass = TestProperties::StaticClass();
+        UInt32 count = testClass->GetPropertyCount();
+        Vector<Byte> changed;
+        changed.resize( count );
+        Bool* changedFlags = (Bool*)&changed[0];
+
+        testClass->DiffProperties( &source, &propertyData[0], changedFlags );
+        for( UInt32 i = 0; i < count; i++ )
+            TestAssert( !changedFlags[i] );
+
+        TestPropertiesAccess::Modify( &loaded, 43 );
+        loaded.SetPosition( source.GetPosition() );
+
+        Vector<Byte> loadedData;
+        MemoryOutputStream loadedStream( loadedData );
+        testClass->SerializeProperties( &loaded, loadedStream );
+
+        TestPropertiesAccess::Modify( &source, 43 );
+        source.SetPosition( loaded.GetPosition() );
+        source.SetOrientation( Quaternionf(0.0f, 1.0f, 0.0f, 0.0f) );
+        testClass->DiffProperties( &source, &loadedData[0], changedFlags );
+
+        UInt32 orientation = GetPropertyIndex( testClass, "Orientation" );
+        for( UInt32 i = 0; i < count; i++ )
+            TestAssert( changedFlags[i] == (i == orientation) );
+
+        // Strings of a different length.
+        TestPropertiesAccess::Modify( &source, 4300 );
+        testClass->DiffProperties( &source, &loadedData[0], changedFlags );
+        TestAssert( changedFlags[GetPropertyIndex( testClass, "String" )] );
+    }
+};
+
+IMPLEMENT_CLASS( PropertySerializationTest );
+
+
+/**
+ *  Save and load a package of entities, as World::SaveWorld() and World::LoadWorld()
+ *  do, and compare the generated serialization to streaming the fields one at a time.
+ *  The throughput is reported to the debug output.
+ */
+class UNITTESTS_API PropertySerializationBenchmark : public TestCase
+{
+    DECLARE_CLASS( PropertySerializationBenchmark, TestCase );
+
+public:
+    PropertySerializationBenchmark()
+        : mPackage(NULL)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mPackage = PackageManager::Instance()->CreatePackage( "BenchProperties.gdp" );
+
+        for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+        {
+            TestProperties* entity = Cast<TestProperties>( TestProperties::StaticClass()->AllocateNew( String("Entity") + ToString(i) ) );
+            entity->SetOwner( mPackage );
+            TestPropertiesAccess::Modify( entity, i );
+            mEntities.push_back( entity );
+        }
+    }
+
+    virtual void Run()
+    {
+        Vector<Byte> data;
+        data.reserve( NB_ENTITIES * 256 );
+
+        // Properties to and from memory, generated code against one call per field.
+        UInt64 generatedTime[2];
+        UInt64 perFieldTime[2];
+
+        UInt64 start = GetTime();
+        for( UInt32 pass = 0; pass < NB_PASSES; pass++ )
+        {
+            data.clear();
+            MemoryOutputStream stream( data );
+            for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+                mEntities[i]->GetClass()->SerializeProperties( mEntities[i], stream );
+        }
+        generatedTime[0] = GetTime() - start;
+
+        start = GetTime();
+        for( UInt32 pass = 0; pass < NB_PASSES; pass++ )
+        {
+            MemoryInputStream stream( &data[0], data.size() );
+            for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+                mEntities[i]->GetClass()->SerializeProperties( mEntities[i], stream );
+        }
+        generatedTime[1] = GetTime() - start;
+
+        UInt32 dataSize = data.size();
+
+        start = GetTime();
+        for( UInt32 pass = 0; pass < NB_PASSES; pass++ )
+        {
+            data.clear();
+            MemoryOutputStream stream( data );
+            for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+                TestPropertiesAccess::SerializePerField( mEntities[i], stream );
+        }
+        perFieldTime[0] = GetTime() - start;
+
+        start = GetTime();
+        for( UInt32 pass = 0; pass < NB_PASSES; pass++ )
+        {
+            MemoryInputStream stream( &data[0], data.size() );
+            for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+                TestPropertiesAccess::SerializePerField( mEntities[i], stream );
+        }
+        perFieldTime[1] = GetTime() - start;
+
+        Core::DebugOut( "PropertySerializationBenchmark: %d entities, %d bytes, MB/s (save / load)\n", NB_ENTITIES, dataSize );
+        Core::DebugOut( "  %-10s %8.1f / %8.1f\n", "generated",
+                        MegaBytesPerSec( dataSize * NB_PASSES, generatedTime[0] ),
+                        MegaBytesPerSec( dataSize * NB_PASSES, generatedTime[1] ) );
+        Core::DebugOut( "  %-10s %8.1f / %8.1f\n", "per field",
+                        MegaBytesPerSec( dataSize * NB_PASSES, perFieldTime[0] ),
+                        MegaBytesPerSec( dataSize * NB_PASSES, perFieldTime[1] ) );
+
+        // Property grid refresh: nothing changed, every property is compared.
+        Vector<Byte> changed;
+        changed.resize( TestProperties::StaticClass()->GetPropertyCount() );
+
+        Vector<Byte> snapshot;
+        MemoryOutputStream snapshotStream( snapshot );
+        TestProperties::StaticClass()->SerializeProperties( mEntities[0], snapshotStream );
+
+        start = GetTime();
+        for( UInt32 pass = 0; pass < NB_PASSES * NB_ENTITIES; pass++ )
+            TestProperties::StaticClass()->DiffProperties( mEntities[0], &snapshot[0], (Bool*)&changed[0] );
+        UInt64 diffTime = GetTime() - start;
+
+        String value;
+        start = GetTime();
+        for( UInt32 pass = 0; pass < NB_PASSES * NB_ENTITIES; pass++ )
+        {
+            for( Class::PropertyIterator itProp(TestProperties::StaticClass()); itProp; ++itProp )
+                (*itProp)->GetValueString( mEntities[0], value );
+        }
+        UInt64 valueStringTime = GetTime() - start;
+
+        Core::DebugOut( "PropertySerializationBenchmark: property grid refresh %8.3f us diff, %8.3f us value strings\n",
+                        Double(diffTime) / (NB_PASSES * NB_ENTITIES),
+                        Double(valueStringTime) / (NB_PASSES * NB_ENTITIES) );
+
+        // Whole package, as the world is saved. Loading also resolves every object by name.
+        start = GetTime();
+        mPackage->Save();
+        UInt64 saveTime = GetTime() - start;
+
+        for( UInt32 i = 0; i < NB_ENTITIES; i++ )
+            TestPropertiesAccess::Modify( mEntities[i], 0 );
+
+        start = GetTime();
+        mPackage->Load();
+        UInt64 loadTime = GetTime() - start;
+
+        for( UInt32 i = 0; i < NB_ENTITIES; i += 97 )
+        {
+            TestProperties expected;
+            TestPropertiesAccess::Modify( &expected, i );
+            TestAssert( TestPropertiesAccess::Equal( mEntities[i], &expected ) );
+        }
+
+        Core::DebugOut( "PropertySerializationBenchmark: package save %8.1f ms (%8.0f entities/s), load %8.1f ms (%8.0f entities/s)\n",
+                        Double(saveTime) / 1000.0, EntitiesPerSec( saveTime ),
+                        Double(loadTime) / 1000.0, EntitiesPerSec( loadTime ) );
+    }
+
+    virtual void TearDown()
+    {
+        for( UInt32 i = 0; i < mEntities.size(); i++ )
+            GD_DELETE(mEntities[i]);
+        mEntities.clear();
+
+        GD_DELETE(mPackage);
+        FileManager::DeleteFile( "BenchProperties.gdp" );
+    }
+
+private:
+    static UInt64 GetTime()
+    {
+        return SystemInfo::Instance()->GetMicroSec64();
+    }
+
+    static Double MegaBytesPerSec( UInt32 pSize, UInt64 pTime )
+    {
+        return pTime ? Double(pSize) / Double(pTime) : 0.0;
+    }
+
+    static Double EntitiesPerSec( UInt64 pTime )
+    {
+        return pTime ? NB_ENTITIES * 1000000.0 / Double(pTime) : 0.0;
+    }
+
+private:
+    static const UInt32 NB_ENTITIES = 20000;
+    static const UInt32 NB_PASSES   = 10;
+
+    Package*                mPackage;
+    Vector<TestProperties*> mEntities;
+};
+
+IMPLEMENT_CLASS( PropertySerializationBenchmark );
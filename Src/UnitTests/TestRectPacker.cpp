@@ -0,0 +1,93 @@
+/**
+ *  @file       TestRectPacker.cpp
+ *  @brief      Tests for the RectPacker class.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+
+
+#include "Graphic/Texture/RectPacker.h"
+
+using namespace Gamedesk;
+
+
+class UNITTESTS_API RectPackerTest : public TestCase
+{
+    DECLARE_CLASS( RectPackerTest, TestCase );
+
+public:
+    RectPackerTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        // Exact fit: four 32x32 in a 64x64 area, nothing else fits after.
+        RectPacker       exact( 64, 64 );
+        RectPacker::Rect rect;
+        Bool             rotated;
+
+        for( UInt32 i = 0; i < 4; i++ )
+            TestAssert( exact.Insert( 32, 32, RectPacker::Heuristic_BestShortSideFit, rect, rotated ) );
+
+        TestAssert( !exact.Insert( 1, 1, RectPacker::Heuristic_BestShortSideFit, rect, rotated ) );
+        TestAssert( exact.GetOccupancy() == 1.0f );
+
+        // A tall rectangle only fits in a wide area when rotated.
+        RectPacker noRotation( 64, 16, false );
+        RectPacker rotation( 64, 16, true );
+        TestAssert( !noRotation.Insert( 16, 64, RectPacker::Heuristic_BestAreaFit, rect, rotated ) );
+        TestAssert( rotation.Insert( 16, 64, RectPacker::Heuristic_BestAreaFit, rect, rotated ) );
+        TestAssert( rotated && rect.mWidth == 64 && rect.mHeight == 16 );
+
+        // Random rectangles with every heuristic: they stay inside the area and never overlap.
+        for( UInt32 heuristic = 0; heuristic < RectPacker::Heuristic_Count; heuristic++ )
+        {
+            RectPacker                  packer( 256, 256, heuristic % 2 == 0 );
+            Vector<RectPacker::Rect>    placed;
+            UInt32                      seed = 1234;
+
+            for( UInt32 i = 0; i < 500; i++ )
+            {
+                seed = seed * 1103515245 + 12345;
+                UInt32 width  = 1 + (seed >> 16) % 24;
+                UInt32 height = 1 + (seed >> 8) % 24;
+
+                if( packer.Insert( width, height, RectPacker::Heuristic(heuristic), rect, rotated ) )
+                {
+                    TestAssert( rect.mX + rect.mWidth <= 256 && rect.mY + rect.mHeight <= 256 );
+
+                    for( UInt32 j = 0; j < placed.size(); j++ )
+                        TestAssert( !placed[j].Intersects( rect ) );
+
+                    placed.push_back( rect );
+                }
+            }
+
+            TestAssert( packer.GetOccupancy() > 0.85f );
+        }
+    }
+};
+
+IMPLEMENT_CLASS( RectPackerTest );
@@ -0,0 +1,236 @@
+/**
+ *  @file       TestSoundMixer.cpp
+ *  @brief      Software sound subsystem tests and mixing benchmark.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Sound/SoftwareSoundSubsystem.h"
+#include "Sound/SoftwareSound.h"
+#include "Sound/SoundData.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Maths/Maths.h"
+
+using namespace Gamedesk;
+
+
+//! Keep the last block written.
+class LastBlockSink : public SoundSink
+{
+public:
+    virtual void Write( const Int16* pFrames, UInt32 pNbFrames )
+    {
+        mFrames.assign( pFrames, pFrames + pNbFrames * 2 );
+    }
+
+    Int16 GetLeft() const   { return mFrames[mFrames.size() - 2]; }
+    Int16 GetRight() const  { return mFrames[mFrames.size() - 1]; }
+
+    Vector<Int16>   mFrames;
+};
+
+//! A 16 bits mono sound of pNbFrames frames, a sine wave or a constant value.
+static SoundData* CreateSoundData( UInt32 pNbFrames, Float pValue, Bool pSine )
+{
+    SoundData* soundData = GD_NEW(SoundData, 0, "SoundData");
+
+    Char* data = GD_NEW_ARRAY(Char, pNbFrames * 2, 0, "Data");
+    Int16* samples = (Int16*)data;
+    for( UInt32 i = 0; i < pNbFrames; i++ )
+        samples[i] = Int16( 32767 * pValue * (pSine ? Maths::Sin( i * 0.05f ) : 1.0f) );
+
+    soundData->SetFileData( data );
+    soundData->SetFileDataSize( pNbFrames * 2 );
+    soundData->SetSoundDataOffset( 0 );
+    soundData->SetSoundDataSize( pNbFrames * 2 );
+    soundData->SetNbChannels( 1 );
+    soundData->SetBitsPerSample( 16 );
+    soundData->SetBytesPerSample( 2 );
+    soundData->SetSampleRate( 44100 );
+    soundData->SetBytesPerSecond( 44100 * 2 );
+
+    return soundData;
+}
+
+static SoftwareSound* CreateSound( SoftwareSoundSubsystem* pSubsystem, SoundData* pSoundData, Bool pIs3DSound )
+{
+    SoftwareSound* sound = Cast<SoftwareSound>( pSubsystem->Create( Sound::StaticClass() ) );
+    sound->Create( pSoundData, pIs3DSound );
+    sound->Init();
+    return sound;
+}
+
+
+class UNITTESTS_API SoftwareSoundMixTest : public TestCase
+{
+    DECLARE_CLASS( SoftwareSoundMixTest, TestCase );
+
+public:
+    SoftwareSoundMixTest() : mSubsystem(NULL), mSoundData(NULL)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mSubsystem = GD_NEW(SoftwareSoundSubsystem, 0, "SoftwareSoundSubsystem");
+        mSubsystem->Init();
+        mSubsystem->SetSink( &mSink );
+        mSubsystem->SetMaxNbSoftwareChannels( 4 );
+
+        mSoundData = CreateSoundData( 44100, 0.5f, false );
+    }
+
+    virtual void TearDown()
+    {
+        mSubsystem->Kill();
+        GD_DELETE(mSubsystem);
+        GD_DELETE(mSoundData);
+    }
+
+    virtual void Run()
+    {
+        // A centered 2D sound at half volume, constant power pan.
+        SoftwareSound* sound = CreateSound( mSubsystem, mSoundData, false );
+        sound->Play();
+        mSubsystem->Mix( 2 * SoftwareSoundSubsystem::BLOCK_SIZE );
+
+        Int32 expected = Int32( 16383 * Maths::Cos( Maths::PI * 0.25f ) );
+        TestAssert( Maths::Abs( mSink.GetLeft() - expected ) <= 2 );
+        TestAssert( Maths::Abs( mSink.GetRight() - expected ) <= 2 );
+
+        // Same on the right of the listener, in 3D.
+        GD_DELETE(sound);
+        sound = CreateSound( mSubsystem, mSoundData, true );
+        sound->SetAttributes( Vector3f(10, 0, 0), Vector3f(0, 0, 0) );
+        sound->Play();
+        mSubsystem->Set3DListenerAttributes( Vector3f(0, 0, 0), Vector3f(0, 0, 0), Vector3f(0, 0, -1), Vector3f(0, 1, 0) );
+        mSubsystem->Mix( 2 * SoftwareSoundSubsystem::BLOCK_SIZE );
+
+        TestAssert( mSink.GetLeft() == 0 );
+        TestAssert( mSink.GetRight() > 0 && mSink.GetRight() < 16383 );
+
+        // One shot sounds stop at their end.
+        mSubsystem->Mix( 44100 );
+        TestAssert( !sound->IsPlaying() );
+        GD_DELETE(sound);
+
+        // Only the 4 highest priority sounds are mixed.
+        Vector<SoftwareSound*> sounds;
+        for( UInt32 i = 0; i < 10; i++ )
+        {
+            sounds.push_back( CreateSound( mSubsystem, mSoundData, false ) );
+            sounds.back()->SetPriority( i );
+            sounds.back()->Play();
+        }
+
+        mSubsystem->Mix( SoftwareSoundSubsystem::BLOCK_SIZE );
+        TestAssert( mSubsystem->GetNbPlayingChannels() == 4 );
+        TestAssert( mSubsystem->GetNbVirtualVoices() == 6 );
+        for( UInt32 i = 0; i < sounds.size(); i++ )
+            TestAssert( sounds[i]->IsVirtual() == (i < 6) );
+
+        for( UInt32 i = 0; i < sounds.size(); i++ )
+            GD_DELETE(sounds[i]);
+    }
+
+private:
+    SoftwareSoundSubsystem* mSubsystem;
+    LastBlockSink           mSink;
+    SoundData*              mSoundData;
+};
+
+IMPLEMENT_CLASS( SoftwareSoundMixTest );
+
+
+/**
+ *  Mix hundreds of 3D voices played at a different rate than the output, and
+ *  report how many voices are mixed per millisecond to the debug output.
+ */
+class UNITTESTS_API SoftwareSoundMixBenchmark : public TestCase
+{
+    DECLARE_CLASS( SoftwareSoundMixBenchmark, TestCase );
+
+public:
+    SoftwareSoundMixBenchmark()
+    {
+    }
+
+    virtual void Run()
+    {
+        SoftwareSoundSubsystem* subsystem = GD_NEW(SoftwareSoundSubsystem, 0, "SoftwareSoundSubsystem");
+        subsystem->SetMaxNbSoftwareChannels( NB_VOICES );
+        subsystem->Init();
+
+        SoundData* soundData = CreateSoundData( 44100, 0.1f, true );
+
+        Vector<SoftwareSound*> sounds;
+        for( UInt32 i = 0; i < NB_VOICES; i++ )
+        {
+            SoftwareSound* sound = CreateSound( subsystem, soundData, true );
+            sound->SetMode( Sound::kSoundModeLoop );
+            sound->SetFrequency( 22050 + i * 50 );
+            sound->SetAttributes( Vector3f( Maths::Cos( Float(i) ) * i, 0, Maths::Sin( Float(i) ) * i ), Vector3f(0, 0, 0) );
+            sound->Play();
+            sounds.push_back( sound );
+        }
+
+        Core::DebugOut( "Software sound mix benchmark, %d voices, voices mixed per ms\n", NB_VOICES );
+
+        Mix( subsystem, SoundMixer::Interpolation_Linear, "Linear" );
+        Mix( subsystem, SoundMixer::Interpolation_Cubic, "Cubic" );
+
+        TestAssert( subsystem->GetNbPlayingChannels() == NB_VOICES );
+
+        for( UInt32 i = 0; i < sounds.size(); i++ )
+            GD_DELETE(sounds[i]);
+
+        subsystem->Kill();
+        GD_DELETE(subsystem);
+        GD_DELETE(soundData);
+    }
+
+private:
+    static void Mix( SoftwareSoundSubsystem* pSubsystem, SoundMixer::Interpolation pInterpolation, const Char* pName )
+    {
+        pSubsystem->SetInterpolation( pInterpolation );
+
+        UInt64 start = GetTime();
+        pSubsystem->Mix( NB_FRAMES );
+        UInt64 time = GetTime() - start;
+
+        // Voices times the milliseconds of sound mixed, per millisecond.
+        Double soundTime = NB_FRAMES * 1000.0 / pSubsystem->GetOutputRate();
+        Core::DebugOut( "  %-12s %10.1f\n", pName, time ? NB_VOICES * soundTime / (time / 1000.0) : 0.0 );
+    }
+
+    static UInt64 GetTime()
+    {
+        return SystemInfo::Instance()->GetMicroSec64();
+    }
+
+private:
+    static const UInt32 NB_VOICES   = 256;
+    static const UInt32 NB_FRAMES   = 44100;
+};
+
+IMPLEMENT_CLASS( SoftwareSoundMixBenchmark );
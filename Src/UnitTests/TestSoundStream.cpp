@@ -0,0 +1,131 @@
+/**
+ *  @file       TestSoundStream.cpp
+ *  @brief      Sound stream read, rewind and looping tests.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "Sound/SoundStream.h"
+#include "FileManager/FileManager.h"
+
+using namespace Gamedesk;
+
+
+class UNITTESTS_API SoundStreamTest : public TestCase
+{
+    DECLARE_CLASS( SoundStreamTest, TestCase );
+
+public:
+    SoundStreamTest()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        // A small header to skip, then 8 bit PCM data, much smaller than the ring.
+        FILE* file = fopen( FILE_NAME, "wb" );
+        for( UInt32 i = 0; i < HEADER_SIZE + DATA_SIZE; i++ )
+            fputc( GetByte(i), file );
+        fclose( file );
+    }
+
+    virtual void Run()
+    {
+        SoundStream stream;
+        stream.SetNbChannels( 1 );
+        stream.SetBitsPerSample( 8 );
+        stream.SetBytesPerSample( 1 );
+        stream.SetSampleRate( 22050 );
+        stream.Open( FILE_NAME, HEADER_SIZE, DATA_SIZE );
+
+        Byte buffer[DATA_SIZE];
+
+        // Read the whole data in two parts, the end is padded with silence.
+        TestAssert( stream.Read( buffer, 600 ) == 600 );
+        TestAssert( IsData( buffer, 0, 600 ) );
+        TestAssert( !stream.IsFinished() );
+
+        TestAssert( stream.Read( buffer, 600 ) == DATA_SIZE - 600 );
+        TestAssert( IsData( buffer, 600, DATA_SIZE - 600 ) );
+        TestAssert( buffer[DATA_SIZE - 600] == 0x80 && buffer[599] == 0x80 );
+        TestAssert( stream.IsFinished() );
+        TestAssert( stream.GetNbUnderruns() == 0 );
+
+        // Rewind starts over from the first byte.
+        stream.Rewind();
+        TestAssert( !stream.IsFinished() );
+        TestAssert( stream.Read( buffer, 100 ) == 100 );
+        TestAssert( IsData( buffer, 0, 100 ) );
+
+        // Looping when the whole data is already in the ring still wraps around.
+        stream.Read( buffer, DATA_SIZE - 100 );
+        TestAssert( stream.IsFinished() );
+        stream.SetLooping( true );
+        TestAssert( !stream.IsFinished() );
+        for( UInt32 i = 0; i < 3; i++ )
+        {
+            TestAssert( stream.Read( buffer, DATA_SIZE ) == DATA_SIZE );
+            TestAssert( IsData( buffer, 0, DATA_SIZE ) );
+        }
+
+        // Once looping stops, the stream ends at the end of the data.
+        stream.SetLooping( false );
+        stream.Rewind();
+        TestAssert( stream.Read( buffer, 500 ) == 500 );
+        TestAssert( stream.Read( buffer, DATA_SIZE ) == DATA_SIZE - 500 );
+        TestAssert( stream.IsFinished() );
+
+        stream.Close();
+    }
+
+    virtual void TearDown()
+    {
+        FileManager::DeleteFile( FILE_NAME );
+    }
+
+private:
+    static const UInt32 HEADER_SIZE = 44;
+    static const UInt32 DATA_SIZE   = 1000;
+    static const Char*  FILE_NAME;
+
+    static Byte GetByte( UInt32 pPos )
+    {
+        return Byte( (pPos * 7 + pPos / 251) & 0xFF );
+    }
+
+    //! Returns whether pBuffer holds pSize bytes of PCM data, starting at pFirst.
+    static Bool IsData( const Byte* pBuffer, UInt32 pFirst, UInt32 pSize )
+    {
+        for( UInt32 i = 0; i < pSize; i++ )
+        {
+            if( pBuffer[i] != GetByte( HEADER_SIZE + pFirst + i ) )
+                return false;
+        }
+
+        return true;
+    }
+};
+
+const Char* SoundStreamTest::FILE_NAME = "TestSoundStream.wav";
+
+IMPLEMENT_CLASS( SoundStreamTest );
@@ -28,6 +28,8 @@
 #include "UnitTests.h"
 #include "Test/TestCase.h"
 
+using namespace Gamedesk;
+
 
 class UNITTESTS_API StringConversionTest : public TestCase
 {
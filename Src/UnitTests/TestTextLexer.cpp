@@ -0,0 +1,229 @@
+/**
+ *  @file       TestTextLexer.cpp
+ *  @brief      Tests and benchmark for the TextLexer class.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+
+
+#include "FileManager/TextLexer.h"
+#include "FileManager/MemoryFile.h"
+#include "SystemInfo/SystemInfo.h"
+#include "Maths/Maths.h"
+
+using namespace Gamedesk;
+
+
+class UNITTESTS_API TextLexerTest : public TestCase
+{
+    DECLARE_CLASS( TextLexerTest, TestCase );
+
+public:
+    TextLexerTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        const Char text[] = "mesh {\n"
+                            "    // Comment { ignored }\n"
+                            "    shader \"models/monsters/imp\" /* block\n comment */ numverts 42\n"
+                            "    vert 0 ( 0.5 -1.5e-3 ) 123456.789 -7\n"
+                            "}\n"
+                            "blend\tGL_One_Minus_Src_Alpha, gl_one\n"
+                            "map textures/base{x}";
+
+        TextLexer lexer( text, sizeof(text) - 1, TextLexer::Comment_Cpp );
+
+        TestAssert( lexer.Expect( "mesh" ) );
+        TestAssert( lexer.Expect( "{" ) );
+        TestAssert( lexer.Expect( "shader" ) );
+        TestAssert( lexer.ReadQuoted() == "models/monsters/imp" );
+        TestAssert( lexer.Expect( "numverts" ) );
+        TestAssert( lexer.ReadUInt() == 42 );
+        TestAssert( lexer.GetLineNumber() == 4 );
+
+        TestAssert( lexer.Expect( "vert" ) );
+        TestAssert( lexer.ReadInt() == 0 );
+        TestAssert( lexer.Expect( "(" ) );
+        TestAssert( lexer.ReadFloat() == 0.5f );
+        TestAssert( lexer.ReadFloat() == -1.5e-3f );
+        TestAssert( lexer.Expect( ")" ) );
+        TestAssert( lexer.ReadFloat() == 123456.789f );
+        TestAssert( lexer.ReadInt() == -7 );
+        TestAssert( lexer.Expect( "}" ) );
+
+        TestAssert( lexer.ReadIdentifier() == "blend" );
+        TestAssert( lexer.ReadIdentifier().EqualsLowerCase( "gl_one_minus_src_alpha" ) );
+        TestAssert( lexer.GetChar() == ',' );
+        TestAssert( lexer.ReadIdentifier().GetHash() == Hash( "gl_one" ) );
+
+        TestAssert( lexer.Expect( "map" ) );
+        TestAssert( lexer.ReadToken( "{}" ) == "textures/base" );
+        TestAssert( lexer.GetChar() == '{' );
+
+        lexer.SkipLine();
+        TestAssert( lexer.AtEnd() && lexer.ReadToken().IsEmpty() );
+
+        // Hash comments, blanks and long whitespace runs.
+        const Char hashText[] = "a # comment\n"
+                                "                                                 \t\t\r\n"
+                                "  b   c\n";
+
+        lexer.Init( hashText, sizeof(hashText) - 1, TextLexer::Comment_Hash );
+        TestAssert( lexer.Expect( "a" ) );
+        TestAssert( lexer.Expect( "b" ) );
+        lexer.SkipBlanks();
+        TestAssert( lexer.PeekChar() == 'c' );
+
+        // Number parsing matches the C library, which is locale dependent but "C" here.
+        const Char* numbers[] = { "0", "-0.0", "1e10", "3.14159265358979", "0.000001", "-2.5E+3", "1e-40", ".5", "7.", "12345678901234567890123" };
+        for( UInt32 i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++ )
+        {
+            Double value = TextLexer::ParseDouble( numbers[i], numbers[i] + strlen(numbers[i]) );
+            TestAssert( Float(value) == Float(atof( numbers[i] )) );
+        }
+
+        const Char* stop;
+        const Char exponentless[] = "2e";
+        TestAssert( TextLexer::ParseDouble( exponentless, exponentless + 2, &stop ) == 2.0 && *stop == 'e' );
+        const Char trailing[] = "-12abc";
+        TestAssert( TextLexer::ParseInt( trailing, trailing + 6, &stop ) == -12 && *stop == 'a' );
+    }
+};
+
+IMPLEMENT_CLASS( TextLexerTest );
+
+
+class UNITTESTS_API TextLexerBenchmark : public TestCase
+{
+    DECLARE_CLASS( TextLexerBenchmark, TestCase );
+
+public:
+    TextLexerBenchmark()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        // An md5anim like file: frames of joint components.
+        Char line[256];
+        UInt32 seed = 1;
+
+        mText.reserve( NUM_FRAMES * COMPONENTS_PER_FRAME * 12 );
+        for( UInt32 frame = 0; frame < NUM_FRAMES; frame++ )
+        {
+            sprintf( line, "frame %d {\n", frame );
+            mText += line;
+
+            for( UInt32 i = 0; i < COMPONENTS_PER_FRAME; i += 6 )
+            {
+                Float values[6];
+                for( UInt32 j = 0; j < 6; j++ )
+                {
+                    seed = seed * 1103515245 + 12345;
+                    values[j] = (Float((seed >> 8) % 200000) - 100000.0f) / 1000.0f;
+                }
+
+                sprintf( line, "\t%f %f %f %f %f %f\n", values[0], values[1], values[2], values[3], values[4], values[5] );
+                mText += line;
+            }
+
+            mText += "}\n";
+        }
+    }
+
+    virtual void Run()
+    {
+        UInt64 start;
+        Double referenceSum = 0;
+        Double newSum = 0;
+
+        Core::DebugOut( "TextLexer benchmark, %d KB, time in ms (reference / new)\n", mText.size() / 1024 );
+
+        // StringTokenizer, as used by the importers before.
+        const Char whitespaces[] = { 10, 13, '\t', ' ', 0 };
+        StringTokenizer tokenizer;
+        tokenizer.Init( mText.c_str(), (UInt32)mText.size() );
+        tokenizer.SetWhiteSpaces( whitespaces );
+
+        start = GetTime();
+        for( UInt32 frame = 0; frame < NUM_FRAMES; frame++ )
+        {
+            String  token;
+            Int32   frameNum;
+            tokenizer >> token >> frameNum >> token;
+
+            for( UInt32 i = 0; i < COMPONENTS_PER_FRAME; i++ )
+            {
+                Float value;
+                tokenizer >> value;
+                referenceSum += value;
+            }
+
+            tokenizer >> token;
+        }
+        UInt64 referenceTime = GetTime() - start;
+
+        // TextLexer
+        TextLexer lexer( mText.c_str(), (UInt32)mText.size(), TextLexer::Comment_Cpp );
+
+        start = GetTime();
+        for( UInt32 frame = 0; frame < NUM_FRAMES; frame++ )
+        {
+            lexer.Expect( "frame" );
+            lexer.ReadInt();
+            lexer.Expect( "{" );
+
+            for( UInt32 i = 0; i < COMPONENTS_PER_FRAME; i++ )
+                newSum += lexer.ReadFloat();
+
+            lexer.Expect( "}" );
+        }
+        Report( "ReadFloat", referenceTime, GetTime() - start );
+
+        TestAssert( lexer.AtEnd() );
+        TestAssert( Maths::Abs( referenceSum - newSum ) < 0.001 * NUM_FRAMES );
+    }
+
+private:
+    static UInt64 GetTime()
+    {
+        return SystemInfo::Instance()->GetMicroSec64();
+    }
+
+    static void Report( const Char* pName, UInt64 pReference, UInt64 pNew )
+    {
+        Core::DebugOut( "  %-12s %8.2f / %8.2f  (x%.1f)\n", pName, pReference / 1000.0, pNew / 1000.0,
+                        pNew ? Double(pReference) / Double(pNew) : 0.0 );
+    }
+
+private:
+    static const UInt32 NUM_FRAMES              = 2000;
+    static const UInt32 COMPONENTS_PER_FRAME    = 420;
+
+    String  mText;
+};
+
+IMPLEMENT_CLASS( TextLexerBenchmark );
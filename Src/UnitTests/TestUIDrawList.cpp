@@ -0,0 +1,153 @@
+/**
+ *  @file       TestUIDrawList.cpp
+ *  @brief      Tests for the merging of the UI draw lists.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "UI/UIDrawList.h"
+
+using namespace Gamedesk;
+
+
+//! Draw lists never dereference their textures, distinct addresses are enough.
+static Byte     TEXTURES[2];
+static Texture* ATLAS       = reinterpret_cast<Texture*>( &TEXTURES[0] );
+static Texture* FONT_PAGE   = reinterpret_cast<Texture*>( &TEXTURES[1] );
+
+static void AddRect( UIDrawList& pList, Texture* pTexture, Float pX1, Float pY1, Float pX2, Float pY2 )
+{
+    Vector2f positions[4] = { Vector2f(pX1, pY1), Vector2f(pX2, pY1), Vector2f(pX2, pY2), Vector2f(pX1, pY2) };
+    UIColor  colors[4]    = { UIColor(1.0f, 1.0f, 1.0f, 1.0f), UIColor(1.0f, 1.0f, 1.0f, 1.0f), UIColor(1.0f, 1.0f, 1.0f, 1.0f), UIColor(1.0f, 1.0f, 1.0f, 1.0f) };
+    Vector2f uvs[4]       = { Vector2f(0,0), Vector2f(1,0), Vector2f(1,1), Vector2f(0,1) };
+
+    pList.AddQuad( pTexture, positions, colors, uvs );
+}
+
+//! Paint a widget like the default style does: a frame from the atlas, then a caption.
+static void PaintWidget( UIDrawList& pList, Float pX1, Float pY1, Float pX2, Float pY2 )
+{
+    pList.Clear();
+    AddRect( pList, ATLAS, pX1, pY1, pX2, pY2 );
+    AddRect( pList, FONT_PAGE, pX1 + 4, pY1 + 4, pX2 - 4, pY1 + 16 );
+}
+
+static void Queue( Vector<UIDrawList::BatchRef>& pQueue, const UIDrawList& pList )
+{
+    for( UInt32 i = 0; i < pList.GetNbBatches(); i++ )
+    {
+        UIDrawList::BatchRef ref;
+        ref.mList  = &pList;
+        ref.mBatch = i;
+        pQueue.push_back( ref );
+    }
+}
+
+
+class UNITTESTS_API UIDrawOrderTest : public TestCase
+{
+    DECLARE_CLASS( UIDrawOrderTest, TestCase );
+
+public:
+    UIDrawOrderTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        // Two overlapping sibling windows, the second one is painted over the first one.
+        UIDrawList back, front;
+        PaintWidget( back,  0,  0, 200, 100 );
+        PaintWidget( front, 50, 10, 250, 110 );
+
+        Vector<UIDrawList::BatchRef> queue;
+        Queue( queue, back );
+        Queue( queue, front );
+
+        UIDrawList frame;
+        frame.Compose( queue );
+
+        // The caption of the back window must not be drawn over the front window.
+        TestAssert( frame.GetNbBatches() == 4 );
+        TestAssert( frame.GetBatch(0).mTexture == ATLAS     && frame.GetBatch(0).mMin == Vector2f(0, 0) );
+        TestAssert( frame.GetBatch(1).mTexture == FONT_PAGE && frame.GetBatch(1).mMin == Vector2f(4, 4) );
+        TestAssert( frame.GetBatch(2).mTexture == ATLAS     && frame.GetBatch(2).mMin == Vector2f(50, 10) );
+        TestAssert( frame.GetBatch(3).mTexture == FONT_PAGE && frame.GetBatch(3).mMin == Vector2f(54, 14) );
+        TestAssert( frame.GetNbVertices() == back.GetNbVertices() + front.GetNbVertices() );
+
+        // Moved apart, the windows are merged by texture.
+        PaintWidget( front, 200, 10, 400, 110 );
+        frame.Compose( queue );
+
+        TestAssert( frame.GetNbBatches() == 2 );
+        TestAssert( frame.GetBatch(0).mTexture == ATLAS );
+        TestAssert( frame.GetBatch(1).mTexture == FONT_PAGE );
+        TestAssert( frame.GetBatch(1).mMax == Vector2f(396, 26) );
+    }
+};
+
+IMPLEMENT_CLASS(UIDrawOrderTest);
+
+
+class UNITTESTS_API UIDrawCallTest : public TestCase
+{
+    DECLARE_CLASS( UIDrawCallTest, TestCase );
+
+public:
+    UIDrawCallTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        // A toolbar of buttons, each one painted with the atlas and a font page.
+        const UInt32 NB_BUTTONS = 20;
+
+        UIDrawList toolbar;
+        AddRect( toolbar, ATLAS, 0, 0, NB_BUTTONS * 40 + 4, 40 );
+
+        Vector<UIDrawList> buttons;
+        buttons.resize( NB_BUTTONS );
+        for( UInt32 i = 0; i < NB_BUTTONS; i++ )
+            PaintWidget( buttons[i], Float(i * 40 + 4), 4, Float(i * 40 + 40), 36 );
+
+        Vector<UIDrawList::BatchRef> queue;
+        Queue( queue, toolbar );
+        for( UInt32 i = 0; i < NB_BUTTONS; i++ )
+            Queue( queue, buttons[i] );
+
+        // An idle UI is drawn with one draw call per texture, the toolbar under its buttons.
+        UIDrawList frame;
+        frame.Compose( queue );
+
+        TestAssert( queue.size() == 1 + NB_BUTTONS * 2 );
+        TestAssert( frame.GetNbBatches() == 2 );
+        TestAssert( frame.GetBatch(0).mTexture == ATLAS );
+        TestAssert( frame.GetBatch(0).mNbVertices == (1 + NB_BUTTONS) * 6 );
+        TestAssert( frame.GetPositions()[0] == Vector3f(0, 0, 0) );
+        TestAssert( frame.GetBatch(1).mTexture == FONT_PAGE );
+        TestAssert( frame.GetBatch(1).mNbVertices == NB_BUTTONS * 6 );
+    }
+};
+
+IMPLEMENT_CLASS(UIDrawCallTest);
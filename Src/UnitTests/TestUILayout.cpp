@@ -0,0 +1,317 @@
+/**
+ *  @file       TestUILayout.cpp
+ *  @brief      Tests for the incremental UI layout.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "UI/UIElement.h"
+#include "SystemInfo/SystemInfo.h"
+
+using namespace Gamedesk;
+
+
+//! Bare element, its root is sized by hand like UIDesktop does.
+class TestLayoutElement : public UIElement
+{
+public:
+    TestLayoutElement()
+    {
+    }
+
+    TestLayoutElement( UIElement* pParent ) : UIElement(pParent)
+    {
+    }
+
+    void Resize( UIScalar pWidth, UIScalar pHeight )
+    {
+        mRect = UIRect( 0, 0, pWidth, pHeight );
+        SetFlags( Flag_ValidPos );
+    }
+
+    Bool IsLayoutDirty()        { return HasFlags(Flag_LayoutDirty); }
+    Bool IsChildLayoutDirty()   { return HasFlags(Flag_ChildLayoutDirty); }
+
+protected:
+    virtual void Paint()
+    {
+    }
+};
+
+static const UInt32 NB_ROWS    = 100;
+static const UInt32 NB_FIELDS  = 47;
+
+/**
+ *  Build a tool panel of NB_ROWS rows, each one holding a label, NB_FIELDS fields and a slider
+ *  taking the remaining width: 5,000 elements in total. Every element is appended to pElements.
+ */
+static TestLayoutElement* CreateToolPanel( Vector<TestLayoutElement*>& pElements )
+{
+    TestLayoutElement* panel = GD_NEW(TestLayoutElement, 0, "UILayoutTest")();
+    pElements.push_back( panel );
+
+    TestLayoutElement* previousRow = NULL;
+    for( UInt32 row = 0; row < NB_ROWS; row++ )
+    {
+        TestLayoutElement* rowElement = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( panel );
+        pElements.push_back( rowElement );
+
+        rowElement->AttachParent( UI::Left, UI::Left, 4 );
+        rowElement->AttachParent( UI::Right, UI::Right, -4 );
+        if( previousRow )
+            rowElement->Attach( UI::Top, previousRow, UI::Bottom, -2 );
+        else
+            rowElement->AttachParent( UI::Top, UI::Top, -4 );
+        rowElement->SetHeight( 20 );
+
+        TestLayoutElement* label = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( rowElement );
+        pElements.push_back( label );
+        label->AttachParent( UI::Left, UI::Left, 2 );
+        label->AttachParent( UI::Bottom, UI::Bottom, 2 );
+        label->AttachParent( UI::Top, UI::Top, -2 );
+        label->SetWidth( 60 );
+
+        TestLayoutElement* previous = label;
+        for( UInt32 field = 0; field < NB_FIELDS; field++ )
+        {
+            TestLayoutElement* fieldElement = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( rowElement );
+            pElements.push_back( fieldElement );
+            fieldElement->Attach( UI::Left, previous, UI::Right, 2 );
+            fieldElement->AttachParent( UI::Bottom, UI::Bottom, 2 );
+            fieldElement->AttachParent( UI::Top, UI::Top, -2 );
+            fieldElement->SetWidth( 30 );
+            previous = fieldElement;
+        }
+
+        TestLayoutElement* slider = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( rowElement );
+        pElements.push_back( slider );
+        slider->Attach( UI::Left, previous, UI::Right, 2 );
+        slider->AttachParent( UI::Right, UI::Right, -2 );
+        slider->AttachParent( UI::Bottom, UI::Bottom, 2 );
+        slider->AttachParent( UI::Top, UI::Top, -2 );
+
+        previousRow = rowElement;
+    }
+
+    return panel;
+}
+
+static Bool SameLayout( const Vector<TestLayoutElement*>& pA, const Vector<TestLayoutElement*>& pB )
+{
+    if( pA.size() != pB.size() )
+        return false;
+
+    for( UInt32 i = 0; i < pA.size(); i++ )
+    {
+        if( pA[i]->GetRect() != pB[i]->GetRect() )
+            return false;
+    }
+
+    return true;
+}
+
+
+class UNITTESTS_API UILayoutTest : public TestCase
+{
+    DECLARE_CLASS( UILayoutTest, TestCase );
+
+public:
+    UILayoutTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        const UIScalar HEIGHT = 2400;
+
+        // Resizing step by step must give the same layout as a fresh one.
+        Vector<TestLayoutElement*> resized;
+        TestLayoutElement* resizedPanel = CreateToolPanel( resized );
+        UIScalar width;
+        for( width = 2000; width < 2600; width += 37 )
+        {
+            resizedPanel->Resize( width, HEIGHT );
+            resizedPanel->UpdateLayout();
+        }
+        width -= 37;
+
+        Vector<TestLayoutElement*> fresh;
+        TestLayoutElement* freshPanel = CreateToolPanel( fresh );
+        freshPanel->Resize( width, HEIGHT );
+        freshPanel->UpdateLayout();
+
+        TestAssert( resized.size() == 1 + NB_ROWS * (NB_FIELDS + 3) );
+        TestAssert( SameLayout( resized, fresh ) );
+
+        // The slider takes the remaining width.
+        TestAssert( resized[1]->GetWidth() == width - 8 );
+        TestAssert( resized[NB_FIELDS + 3]->GetWidth() == resized[1]->GetWidth() - 2 - 60 - NB_FIELDS * 32 - 4 );
+
+        // Changing a constraint only lays out its row again, and gives the same layout as a fresh one.
+        resized[1 + 2 + 10]->SetWidth( 50 );
+        resizedPanel->UpdateLayout();
+
+        Vector<TestLayoutElement*> modified;
+        TestLayoutElement* modifiedPanel = CreateToolPanel( modified );
+        modified[1 + 2 + 10]->SetWidth( 50 );
+        modifiedPanel->Resize( width, HEIGHT );
+        modifiedPanel->UpdateLayout();
+
+        TestAssert( SameLayout( resized, modified ) );
+        TestAssert( resized[1 + 2 + 10]->GetWidth() == 50 );
+
+        GD_DELETE(resizedPanel);
+        GD_DELETE(freshPanel);
+        GD_DELETE(modifiedPanel);
+    }
+};
+
+IMPLEMENT_CLASS(UILayoutTest);
+
+
+class UNITTESTS_API UILayoutInvalidationTest : public TestCase
+{
+    DECLARE_CLASS( UILayoutInvalidationTest, TestCase );
+
+public:
+    UILayoutInvalidationTest()
+    {
+    }
+
+    virtual void Run()
+    {
+        TestLayoutElement* panel = GD_NEW(TestLayoutElement, 0, "UILayoutTest")();
+
+        TestLayoutElement* left = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( panel );
+        left->AttachParent( UI::Left, UI::Left, 0 );
+        left->AttachParent( UI::Bottom, UI::Bottom, 0 );
+        left->AttachParent( UI::Top, UI::Top, 0 );
+        left->SetWidth( 100 );
+
+        TestLayoutElement* right = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( panel );
+        right->Attach( UI::Left, left, UI::Right, 10 );
+        right->AttachParent( UI::Bottom, UI::Bottom, 0 );
+        right->AttachParent( UI::Top, UI::Top, 0 );
+        right->SetWidth( 50 );
+
+        panel->Resize( 400, 100 );
+        panel->UpdateLayout();
+        TestAssert( right->GetPosition().x == 110 );
+
+        // Removing an element invalidates the siblings attached to it.
+        panel->RemoveChild( left );
+        TestAssert( right->IsLayoutDirty() );
+        TestAssert( panel->IsChildLayoutDirty() );
+
+        right->AttachParent( UI::Left, UI::Left, 10 );
+        panel->UpdateLayout();
+        TestAssert( right->GetPosition().x == 10 );
+        TestAssert( !right->IsLayoutDirty() );
+        GD_DELETE(left);
+
+        // An element attached to an unresolved one can't be laid out...
+        TestLayoutElement* unresolved = GD_NEW(TestLayoutElement, 0, "UILayoutTest")();
+        unresolved->SetWidth( 10 );
+
+        TestLayoutElement* orphan = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( panel );
+        orphan->Attach( UI::Left, unresolved, UI::Right, 0 );
+        orphan->AttachParent( UI::Bottom, UI::Bottom, 0 );
+        orphan->AttachParent( UI::Top, UI::Top, 0 );
+        orphan->SetWidth( 20 );
+
+        TestLayoutElement* child = GD_NEW(TestLayoutElement, 0, "UILayoutTest")( orphan );
+        child->AttachParent( UI::Left, UI::Left, 0 );
+        child->AttachParent( UI::Right, UI::Right, 0 );
+        child->AttachParent( UI::Bottom, UI::Bottom, 0 );
+        child->AttachParent( UI::Top, UI::Top, 0 );
+
+        panel->UpdateLayout();
+        TestAssert( orphan->IsLayoutDirty() );
+        TestAssert( !orphan->IsChildLayoutDirty() );
+
+        // ... but it doesn't stop the invalidations of its children.
+        child->InvalidateLayout();
+        TestAssert( panel->IsChildLayoutDirty() );
+
+        // Its subtree is laid out once it resolves.
+        orphan->AttachParent( UI::Left, UI::Left, 30 );
+        panel->UpdateLayout();
+        TestAssert( !orphan->IsLayoutDirty() );
+        TestAssert( child->GetPosition().x == 30 );
+        TestAssert( child->GetWidth() == 20 );
+
+        GD_DELETE(unresolved);
+        GD_DELETE(panel);
+    }
+};
+
+IMPLEMENT_CLASS(UILayoutInvalidationTest);
+
+
+class UNITTESTS_API UILayoutBenchmark : public TestCase
+{
+    DECLARE_CLASS( UILayoutBenchmark, TestCase );
+
+public:
+    UILayoutBenchmark()
+    {
+    }
+
+    virtual void Run()
+    {
+        const UInt32 NB_STEPS = 200;
+
+        Vector<TestLayoutElement*> elements;
+        TestLayoutElement* panel = CreateToolPanel( elements );
+
+        UInt64 start = SystemInfo::Instance()->GetMicroSec64();
+        panel->Resize( 2000, 2400 );
+        panel->UpdateLayout();
+        UInt64 fullLayoutTime = SystemInfo::Instance()->GetMicroSec64() - start;
+
+        // Interactive resize, the panel grows and shrinks a few pixels at a time.
+        start = SystemInfo::Instance()->GetMicroSec64();
+        for( UInt32 step = 0; step < NB_STEPS; step++ )
+        {
+            panel->Resize( 2000 + (step % 50) * 4, 2400 );
+            panel->UpdateLayout();
+        }
+        UInt64 resizeTime = SystemInfo::Instance()->GetMicroSec64() - start;
+
+        // Idle frames, nothing changed.
+        start = SystemInfo::Instance()->GetMicroSec64();
+        for( UInt32 step = 0; step < NB_STEPS; step++ )
+            panel->UpdateLayout();
+        UInt64 idleTime = SystemInfo::Instance()->GetMicroSec64() - start;
+
+        Core::DebugOut( "UILayoutBenchmark: %d elements, full layout %8.1f us, resize %8.1f us, idle %6.2f us\n",
+                        elements.size(),
+                        Double(fullLayoutTime),
+                        Double(resizeTime) / NB_STEPS,
+                        Double(idleTime) / NB_STEPS );
+
+        GD_DELETE(panel);
+    }
+};
+
+IMPLEMENT_CLASS(UILayoutBenchmark);
@@ -0,0 +1,140 @@
+/**
+ *  @file       TestWorldTileImport.cpp
+ *  @brief      Throughput benchmark for the world tile importers.
+ */
+/*
+ *  Copyright (C) 2010 Gamedesk
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *  Gamedesk
+ *  http://gamedesk.type-cast.com
+ *
+ */
+#include "UnitTests.h"
+#include "Test/TestCase.h"
+#include "FileManager/FileManager.h"
+#include "Resource/ResourceManager.h"
+#include "World/WorldTile.h"
+#include "Graphic/Texture/TextureManager.h"
+#include "SystemInfo/SystemInfo.h"
+
+using namespace Gamedesk;
+
+
+/**
+ *  Import a block of ADT tiles one at a time, then as a single batch, and
+ *  report the throughput in tiles/sec to the debug output. The texture cache
+ *  is flushed before each run, so both import every texture. The map files are
+ *  not part of the repository, the benchmark does nothing when they are missing.
+ */
+class UNITTESTS_API WorldTileImportBenchmark : public TestCase
+{
+    DECLARE_CLASS( WorldTileImportBenchmark, TestCase );
+
+public:
+    WorldTileImportBenchmark()
+    {
+    }
+
+    virtual void SetUp()
+    {
+        mFilenames.clear();
+
+        for( UInt32 y = FIRST_TILE; y < FIRST_TILE + TILES_PER_SIDE; y++ )
+        {
+            for( UInt32 x = FIRST_TILE; x < FIRST_TILE + TILES_PER_SIDE; x++ )
+            {
+                String filename = String("Data/World/Maps/Azeroth/Azeroth_") + ToString(x) + String("_") + ToString(y) + String(".adt");
+                if( FileManager::FileExist( filename ) )
+                    mFilenames.push_back( filename );
+            }
+        }
+    }
+
+    virtual void Run()
+    {
+        if( mFilenames.empty() )
+        {
+            Core::DebugOut( "World tile import benchmark skipped, no ADT file found\n" );
+            return;
+        }
+
+        ResourceImporter* importer = ResourceManager::Instance()->GetImporterForFile( mFilenames[0], WorldTile::StaticClass() );
+        if( !importer )
+        {
+            Core::DebugOut( "World tile import benchmark skipped, no ADT importer\n" );
+            return;
+        }
+
+        Vector<Resource*> resources;
+        UInt64 start;
+
+        Core::DebugOut( "World tile import benchmark, %d tiles, tiles/sec (one at a time / batch)\n", mFilenames.size() );
+
+        TextureManager::Instance().Flush();
+
+        start = GetTime();
+        for( UInt32 i = 0; i < mFilenames.size(); i++ )
+            resources.push_back( importer->Import( mFilenames[i] ) );
+        UInt64 sequential = GetTime() - start;
+        Release( resources );
+
+        TextureManager::Instance().Flush();
+        UInt32 cacheHits = TextureManager::Instance().GetStats().mNbCacheHits;
+
+        start = GetTime();
+        importer->ImportBatch( mFilenames, resources );
+        UInt64 batch = GetTime() - start;
+
+        TestAssert( TextureManager::Instance().GetStats().mNbCacheHits == cacheHits );
+
+        TestAssert( resources.size() == mFilenames.size() );
+        for( UInt32 i = 0; i < resources.size(); i++ )
+            TestAssert( resources[i] != NULL );
+        Release( resources );
+
+        Core::DebugOut( "  %-12s %8.2f / %8.2f  (x%.1f)\n", "ImportBatch",
+                        TilesPerSec( mFilenames.size(), sequential ), TilesPerSec( mFilenames.size(), batch ),
+                        batch ? Double(sequential) / Double(batch) : 0.0 );
+    }
+
+private:
+    static UInt64 GetTime()
+    {
+        return SystemInfo::Instance()->GetMicroSec64();
+    }
+
+    static Double TilesPerSec( UInt32 pTiles, UInt64 pTime )
+    {
+        return pTime ? pTiles * 1000000.0 / Double(pTime) : 0.0;
+    }
+
+    static void Release( Vector<Resource*>& pResources )
+    {
+        for( UInt32 i = 0; i < pResources.size(); i++ )
+            GD_DELETE(pResources[i]);
+
+        pResources.clear();
+    }
+
+private:
+    static const UInt32 FIRST_TILE      = 30;
+    static const UInt32 TILES_PER_SIDE  = 4;
+
+    Vector<String>  mFilenames;
+};
+
+IMPLEMENT_CLASS( WorldTileImportBenchmark );
@@ -28,5 +28,7 @@
 #include "UnitTests.h"
 #include "Module/ModuleManager.h"
 
+using namespace Gamedesk;
+
 
 IMPLEMENT_MODULE(UnitTests);
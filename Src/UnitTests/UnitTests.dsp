@@ -92,16 +92,88 @@ LINK32=link.exe
 # PROP Default_Filter ""
 # Begin Source File
 
+SOURCE=.\TestCompressedStream.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\TestConfigFile.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\TestFileChecksumCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestImage.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestInput.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestMathsSIMD.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\TestMatrix.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\TestMemory.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestNetwork.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestPackage.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestPortalMap.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestProfiler.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestPropertySerialization.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestRectPacker.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestSoundMixer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestSoundStream.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\TestString.cpp
 # End Source File
+# Begin Source File
+
+SOURCE=.\TestTextLexer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestUILayout.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestUIDrawList.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\TestWorldTileImport.cpp
+# End Source File
 # End Group
 # Begin Source File
 
@@ -55,7 +55,7 @@ namespace Cpp
             mProperties.push_back(pNewProperty);
         }
 
-        void OutputProperties( TextOutputStream& out )
+        void OutputInclude( TextOutputStream& out )
         {
             if( mProperties.empty() )
                 return;
@@ -63,6 +63,67 @@ namespace Cpp
             out << "#include \"";
             out << mHeaderFile;
             out << "\"\n";
+        }
+
+        void OutputSerializeProperties( TextOutputStream& out )
+        {
+            if( mProperties.empty() )
+                return;
+
+            out << "void ";
+            out << mNamespace;
+            out << mName;
+            out << "::SerializeProperties( Stream& pStream )\n";
+            out << "{\n";
+
+            for( List<PropertyDesc*>::iterator it(mProperties.begin()); it != mProperties.end(); )
+            {
+                List<PropertyDesc*>::iterator itEnd = GetRunEnd(it);
+
+                if( !(*it)->IsPlainData() )
+                {
+                    out << "    pStream << ";
+                    out << (*it)->mVariableName;
+                    out << ";\n";
+                }
+                else if( Next(it) == itEnd )
+                {
+                    OutputSerialize( out, it, itEnd, "    " );
+                }
+                else
+                {
+                    // Serialized in one call, unless the compiler padded the run.
+                    // The test is constant, only one branch is compiled in.
+                    OutputRunComment( out, it, itEnd );
+                    out << "    if( (Byte*)(&";
+                    out << GetLast(itEnd)->mVariableName;
+                    out << " + 1) - (Byte*)&";
+                    out << (*it)->mVariableName;
+                    out << " == ";
+                    OutputRunSize( out, it, itEnd, "" );
+                    out << " )\n";
+                    out << "        pStream.Serialize( &";
+                    out << (*it)->mVariableName;
+                    out << ", ";
+                    OutputRunSize( out, it, itEnd, "" );
+                    out << " );\n";
+                    out << "    else\n";
+                    out << "    {\n";
+                    OutputSerialize( out, it, itEnd, "        " );
+                    out << "    }\n";
+                }
+
+                it = itEnd;
+            }
+
+            out << "}\n";
+            out << "\n";
+        }
+
+        void OutputProperties( TextOutputStream& out )
+        {
+            if( mProperties.empty() )
+                return;
 
             out << "void ";
             out << mNamespace;
@@ -81,6 +142,151 @@ namespace Cpp
                 out << "\n";
             }
 
+            out << "    pClass->SetPropertyFunctions( &";
+            out << mName;
+            out << "::StaticSerializeProperties, &";
+            out << mName;
+            out << "::StaticDiffProperties );\n";
+            out << "}\n";
+            out << "\n";
+
+            out << "void ";
+            out << mNamespace;
+            out << mName;
+            out << "::StaticSerializeProperties( Object* pObject, Stream& pStream )\n";
+            out << "{\n";
+            out << "    static_cast<";
+            out << mName;
+            out << "*>(pObject)->SerializeProperties( pStream );\n";
+            out << "}\n";
+            out << "\n";
+
+            OutputDiffProperties( out );
+        }
+
+    private:
+        //! Plain data properties declared one after the other are handled as a single run.
+        List<PropertyDesc*>::iterator GetRunEnd( List<PropertyDesc*>::iterator pBegin )
+        {
+            List<PropertyDesc*>::iterator itEnd = Next(pBegin);
+
+            if( (*pBegin)->IsPlainData() )
+            {
+                while( itEnd != mProperties.end() && (*itEnd)->IsPlainData() )
+                    ++itEnd;
+            }
+
+            return itEnd;
+        }
+
+        static List<PropertyDesc*>::iterator Next( List<PropertyDesc*>::iterator pIt )
+        {
+            return ++pIt;
+        }
+
+        static PropertyDesc* GetLast( List<PropertyDesc*>::iterator pEnd )
+        {
+            return *(--pEnd);
+        }
+
+        void OutputRunComment( TextOutputStream& out, List<PropertyDesc*>::iterator pBegin, List<PropertyDesc*>::iterator pEnd )
+        {
+            out << "    // ";
+            for( List<PropertyDesc*>::iterator it(pBegin); it != pEnd; ++it )
+            {
+                if( it != pBegin )
+                    out << ", ";
+                out << (*it)->mVariableName;
+            }
+            out << "\n";
+        }
+
+        void OutputRunSize( TextOutputStream& out, List<PropertyDesc*>::iterator pBegin, List<PropertyDesc*>::iterator pEnd, const Char* pPrefix )
+        {
+            for( List<PropertyDesc*>::iterator it(pBegin); it != pEnd; ++it )
+            {
+                if( it != pBegin )
+                    out << " + ";
+                out << "sizeof(";
+                out << pPrefix;
+                out << (*it)->mVariableName;
+                out << ")";
+            }
+        }
+
+        void OutputSerialize( TextOutputStream& out, List<PropertyDesc*>::iterator pBegin, List<PropertyDesc*>::iterator pEnd, const Char* pIndent )
+        {
+            for( List<PropertyDesc*>::iterator it(pBegin); it != pEnd; ++it )
+            {
+                out << pIndent;
+                out << "pStream.Serialize( &";
+                out << (*it)->mVariableName;
+                out << ", sizeof(";
+                out << (*it)->mVariableName;
+                out << ") );\n";
+            }
+        }
+
+        void OutputChanged( TextOutputStream& out, List<PropertyDesc*>::iterator pBegin, List<PropertyDesc*>::iterator pEnd, UInt32 pIndex, const Char* pIndent )
+        {
+            for( List<PropertyDesc*>::iterator it(pBegin); it != pEnd; ++it, ++pIndex )
+            {
+                out << pIndent;
+                out << "pChanged[";
+                out << pIndex;
+                out << "] = PropertySnapshot::Changed( pSnapshot, obj->";
+                out << (*it)->mVariableName;
+                out << " );\n";
+            }
+        }
+
+        void OutputDiffProperties( TextOutputStream& out )
+        {
+            out << "void ";
+            out << mNamespace;
+            out << mName;
+            out << "::StaticDiffProperties( const Object* pObject, const Byte*& pSnapshot, Bool* pChanged )\n";
+            out << "{\n";
+            out << "    const ";
+            out << mName;
+            out << "* obj = static_cast<const ";
+            out << mName;
+            out << "*>(pObject);\n";
+            out << "\n";
+
+            UInt32 index = 0;
+            for( List<PropertyDesc*>::iterator it(mProperties.begin()); it != mProperties.end(); )
+            {
+                List<PropertyDesc*>::iterator itEnd = GetRunEnd(it);
+
+                if( !(*it)->IsPlainData() || Next(it) == itEnd )
+                {
+                    OutputChanged( out, it, itEnd, index, "    " );
+                }
+                else
+                {
+                    // Compare the whole run at once, property by property only when it changed.
+                    OutputRunComment( out, it, itEnd );
+                    out << "    if( PropertySnapshot::RunEqual( pSnapshot, &obj->";
+                    out << (*it)->mVariableName;
+                    out << ", &obj->";
+                    out << GetLast(itEnd)->mVariableName;
+                    out << " + 1, ";
+                    OutputRunSize( out, it, itEnd, "obj->" );
+                    out << " ) )\n";
+                    out << "        pSnapshot += ";
+                    OutputRunSize( out, it, itEnd, "obj->" );
+                    out << ";\n";
+                    out << "    else\n";
+                    out << "    {\n";
+                    OutputChanged( out, it, itEnd, index, "        " );
+                    out << "    }\n";
+                }
+
+                for( ; it != itEnd; ++it )
+                    ++index;
+            }
+
             out << "}\n";
             out << "\n";
         }
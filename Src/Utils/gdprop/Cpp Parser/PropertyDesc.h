@@ -153,6 +153,9 @@ namespace Cpp
 
         virtual const String& GetPropertyTypeName() const = 0;
 
+        //! True if the variable can be serialized and compared as raw memory.
+        virtual Bool IsPlainData() const { return true; }
+
     public:
         String mVariableName;
         String mName;
@@ -247,6 +247,7 @@ namespace Cpp
     public:
         StringPropertyDesc( const String& pVariableName ) : PropertyDesc(pVariableName) {}     
         const String& GetPropertyTypeName() const { static const String PROPERTY_TYPE_NAME("PropertyString"); return PROPERTY_TYPE_NAME; }
+        Bool IsPlainData() const { return false; }
     };
 
     class EnumPropertyDesc : public PropertyDesc
@@ -2,7 +2,7 @@
 
 #include "Core.h"
 #include "FileManager/FileManager.h"
-#include "FileManager/Checksum.h"
+#include "FileManager/FileChecksumCache.h"
 
 using namespace Gamedesk;
 
@@ -204,6 +204,19 @@ void GeneratePropertyFile( const String& pModuleName, const String& pPrecompiled
     out << pModuleName.c_str();
     out << "Enums.h\"\n\n";
 
+    for( List<Cpp::ClassDesc*>::iterator it(reader.mClassDesc.begin()); it != reader.mClassDesc.end(); ++it )
+    {
+        (*it)->OutputInclude(out);
+    }
+
+    out << "\n\n";
+
+    // Serialization is used by Serialize() even when properties are disabled.
+    for( List<Cpp::ClassDesc*>::iterator it(reader.mClassDesc.begin()); it != reader.mClassDesc.end(); ++it )
+    {
+        (*it)->OutputSerializeProperties(out);
+    }
+
     out << "#if GD_CFG_USE_PROPERTIES == GD_ENABLED\n\n";
 
     for( List<Cpp::ClassDesc*>::iterator it(reader.mClassDesc.begin()); it != reader.mClassDesc.end(); ++it )
@@ -306,22 +319,13 @@ void ReplaceIfChanged( const String& pSourceFile, const String& pDestinationFile
     }
     else
     {
-        FILE* srcFile = 0;
-        FILE* dstFile = 0;
-
-        fopen_s(&srcFile, pSourceFile.c_str(), "rb");
-        fopen_s(&dstFile, pDestinationFile.c_str(), "rb");
-
-        GD_ASSERT(srcFile);
-        GD_ASSERT(dstFile);
-
-        MD5Checksum checksumSrc(srcFile);
-        MD5Checksum checksumDst(dstFile);
+        GD_ASSERT(FileManager::FileExist(pSourceFile));
 
-        fclose(srcFile);
-        fclose(dstFile);
+        // Generated files are small, a fast hash is enough to tell if they changed.
+        FileChecksum checksumSrc = FileChecksumCache::ComputeChecksum(pSourceFile, FileChecksum::Algorithm_XXHash);
+        FileChecksum checksumDst = FileChecksumCache::ComputeChecksum(pDestinationFile, FileChecksum::Algorithm_XXHash);
 
-        bReplace = checksumSrc.Digest() != checksumDst.Digest();
+        bReplace = checksumSrc != checksumDst;
     }
 
     if( bReplace )